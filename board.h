@@ -69,6 +69,20 @@ static  int  drawMarkerSprite;
 static  int  squareSize          =  BOARD_SQUARE_SIZE;
 
 
+/* glow of radius 4 with 2 iterations reaches this far past each sprite */
+#define  BOARD_GLOW_BORDER  16
+
+/* squares and border, inside the outer glow, are cached here, along with
+   the draw color and blend mode they were captured with */
+static  int            boardLayer;
+
+static  unsigned char  boardLayerRed;
+static  unsigned char  boardLayerGreen;
+static  unsigned char  boardLayerBlue;
+static  unsigned char  boardLayerAlpha;
+static  char           boardLayerAdditive;
+
+
 
 
 
@@ -102,6 +116,139 @@ void boardInit( void ) {
                                 2 );
 
     drawMarkerSprite = maxigin_initSprite( "drawX.tga" );
+
+    boardLayer = maxigin_initLayer( squareSize * BW,
+                                    squareSize * BH );
+    }
+
+
+
+/* draws glow of every square and border sprite that reaches outside
+   the board */
+static void boardDrawEdgeGlows( int  inCenterX,
+                                int  inCenterY ) {
+    int  y;
+    int  x;
+    int  yOff  =  ( squareSize * BH ) / 2;
+    int  xOff  =  ( squareSize * BW ) / 2;
+
+    for( y = 0;
+         y < BH;
+         y ++ ) {
+
+        int  yPos  =  inCenterY - yOff + y * squareSize + squareSize / 2;
+        
+        for( x = 0;
+             x < BW;
+             x ++ ) {
+
+            int  xPos  =  inCenterX - xOff + x * squareSize + squareSize / 2;
+
+            if( y != 0 && y != BH - 1
+                &&
+                x != 0 && x != BW - 1 ) {
+                /* inner square glow stays on board */
+                continue;
+                }
+
+            /* top left square is white */
+            if( ( x + y ) % 2 == 0 ) {
+                maxigin_drawSpriteGlowOnly( squareSpriteWhite,
+                                            xPos,
+                                            yPos );
+                }
+            else {
+                maxigin_drawSpriteGlowOnly( squareSpriteBlack,
+                                            xPos,
+                                            yPos );
+                }
+            }
+        }
+
+    maxigin_drawSpriteGlowOnly( borderSpriteH,
+                                inCenterX,
+                                inCenterY - yOff );
+
+    maxigin_drawSpriteGlowOnly( borderSpriteH,
+                                inCenterX,
+                                inCenterY + yOff - 1 );
+    
+    maxigin_drawSpriteGlowOnly( borderSpriteV,
+                                inCenterX - xOff,
+                                inCenterY );
+
+    maxigin_drawSpriteGlowOnly( borderSpriteV,
+                                inCenterX + xOff - 1,
+                                inCenterY );
+    }
+
+
+
+/*
+  Redraws the part of the board's glow that falls outside of the cached
+  layer, one strip at a time.
+
+  Glows are additive, so drawing them in a different order than a full
+  boardDraw gives the same pixels, even over things drawn under the board.
+*/
+static void boardDrawOuterGlow( int  inCenterX,
+                                int  inCenterY ) {
+    int  i;
+    int  yOff    =  ( squareSize * BH ) / 2;
+    int  xOff    =  ( squareSize * BW ) / 2;
+    int  startX  =  inCenterX - xOff;
+    int  startY  =  inCenterY - yOff;
+    int  endX    =  startX + squareSize * BW - 1;
+    int  endY    =  startY + squareSize * BH - 1;
+
+    /* top, bottom, left, right, with corners in top and bottom */
+    int  strips[4][4];
+
+    strips[0][0] = startX - BOARD_GLOW_BORDER;
+    strips[0][1] = endX + BOARD_GLOW_BORDER;
+    strips[0][2] = startY - BOARD_GLOW_BORDER;
+    strips[0][3] = startY - 1;
+
+    strips[1][0] = startX - BOARD_GLOW_BORDER;
+    strips[1][1] = endX + BOARD_GLOW_BORDER;
+    strips[1][2] = endY + 1;
+    strips[1][3] = endY + BOARD_GLOW_BORDER;
+
+    strips[2][0] = startX - BOARD_GLOW_BORDER;
+    strips[2][1] = startX - 1;
+    strips[2][2] = startY;
+    strips[2][3] = endY;
+
+    strips[3][0] = endX + 1;
+    strips[3][1] = endX + BOARD_GLOW_BORDER;
+    strips[3][2] = startY;
+    strips[3][3] = endY;
+
+    for( i = 0;
+         i < 4;
+         i ++ ) {
+
+        if( strips[i][1] < 0
+            ||
+            strips[i][3] < 0
+            ||
+            strips[i][0] >= MAXIGIN_GAME_NATIVE_W
+            ||
+            strips[i][2] >= MAXIGIN_GAME_NATIVE_H ) {
+            /* off screen, and -1 end would mean no clip limit */
+            continue;
+            }
+
+        maxigin_drawPushClipRectangle( strips[i][0],
+                                       strips[i][1],
+                                       strips[i][2],
+                                       strips[i][3] );
+
+        boardDrawEdgeGlows( inCenterX,
+                            inCenterY );
+
+        maxigin_drawPopClipRectangle();
+        }
     }
 
 
@@ -117,8 +264,49 @@ void boardDraw( int  inCenterX,
     int  yOff  =  ( squareSize * BH ) / 2;
     int  xOff  =  ( squareSize * BW ) / 2;
 
+    int  layerX  =  inCenterX - xOff;
+    int  layerY  =  inCenterY - yOff;
+
+    unsigned char  r;
+    unsigned char  g;
+    unsigned char  b;
+    unsigned char  a;
+    char           additive;
+    char           capturing;
+    
     colorsApplyBoardColor();
 
+    maxigin_drawGetColor( &r, &g, &b, &a );
+
+    additive = maxigin_drawGetAdditive();
+
+    if( r == boardLayerRed
+        &&
+        g == boardLayerGreen
+        &&
+        b == boardLayerBlue
+        &&
+        a == boardLayerAlpha
+        &&
+        additive == boardLayerAdditive
+        &&
+        maxigin_drawLayer( boardLayer,
+                           layerX,
+                           layerY ) ) {
+
+        boardDrawOuterGlow( inCenterX,
+                            inCenterY );
+        
+        maxigin_drawResetColor();
+        return;
+        }
+
+    /* no usable cached copy, draw sprite by sprite, and cache the result
+       if the board is going onto black */
+    capturing = maxigin_drawBeginLayer( boardLayer,
+                                        layerX,
+                                        layerY );
+
     /* draw black squares in first pass, then white on top */
     for( pass = 0;
          pass < 2;
@@ -176,6 +364,16 @@ void boardDraw( int  inCenterX,
                         inCenterX + xOff - 1,
                         inCenterY );
 
+    if( capturing ) {
+        maxigin_drawEndLayer( boardLayer );
+
+        boardLayerRed       =  r;
+        boardLayerGreen     =  g;
+        boardLayerBlue      =  b;
+        boardLayerAlpha     =  a;
+        boardLayerAdditive  =  additive;
+        }
+    
     maxigin_drawResetColor();
     }
 
@@ -34,6 +34,10 @@ void checkDisplayStartCheck( BoardState  *inState );
 char checkDisplayIsSettled( void );
 
 
+/* ends any running check animation instantly */
+void checkDisplaySkip( void );
+
+
 
 #ifdef CHECK_DISPLAY_IMPLEMENTATION
 
@@ -247,6 +251,12 @@ char checkDisplayIsSettled( void ) {
 
 
 
+void checkDisplaySkip( void ) {
+    checkRunning = 0;
+    }
+
+
+
 void checkDisplayStartCheck( BoardState  *inState ) {
 
     if( isKingInCheckGetMove( inState,
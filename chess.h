@@ -84,11 +84,13 @@ typedef struct Move{
 
 typedef struct BoardPiece {
         
-        ChessPiece  p;
+        ChessPiece     p;
         
-        int         row;
+        /* board coordinates always fit in a byte, which keeps the
+           BN-entry Captured lists small when they're recorded */
+        unsigned char  row;
         
-        int         col;
+        unsigned char  col;
         
     } BoardPiece;
 
@@ -96,11 +98,11 @@ typedef struct BoardPiece {
 
 typedef struct Captured {
 
-        /* number of pieces captured */
-        int        num;
+        /* number of pieces captured, at most BN */
+        unsigned char  num;
         
         /* list of up to BN pieces, with only the first num entries populated */
-        BoardPiece pieces[ BN ];
+        BoardPiece     pieces[ BN ];
         
     } Captured;
 
@@ -475,8 +477,8 @@ static void addCapturedPiece( Captured    *inCaptured,
     BoardPiece  *bp  =  &( inCaptured->pieces[ inCaptured->num ] );
 
     bp->p   = inState->grid[ inRow ][ inCol ];
-    bp->row = inRow;
-    bp->col = inCol;
+    bp->row = (unsigned char)inRow;
+    bp->col = (unsigned char)inCol;
 
     if( ( bp->p & CHESS_TYPE_MASK ) == king ) {
 
@@ -1560,8 +1562,8 @@ static int rocketMove( BoardState     *inState,
                 ( p & CHESS_COLOR_MASK ) == otherColor ) {
 
                 enemy[numEnemy].p   = p;
-                enemy[numEnemy].row = y;
-                enemy[numEnemy].col = x;
+                enemy[numEnemy].row = (unsigned char)y;
+                enemy[numEnemy].col = (unsigned char)x;
                 numEnemy++;
                 } 
             }
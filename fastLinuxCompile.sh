@@ -1 +1 @@
-tcc -g -o Chessamphetamine game.c maxigin_imp.c mingin_imp.c -lX11 -lXrandr -lGLX -lGL -lasound
+tcc -g -o Chessamphetamine game.c maxigin_imp.c mingin_imp.c -lX11 -lXrandr -lXext -lGLX -lGL -lasound
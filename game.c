@@ -100,7 +100,8 @@ enum GameUserAction {
     ROT_COLORS_1,
     ROT_COLORS_2,
     ROT_COLORS_ALL,
-    PRINT_COLORS
+    PRINT_COLORS,
+    FAST_FORWARD
     };
 
 static char         actionHeldDown     =   0;
@@ -765,7 +766,9 @@ void maxiginGame_getNativePixels( unsigned char *inRGBBuffer ) {
             }
         }
     
+    MAXIGIN_PROFILE_ZONE_START( "pinchApply" );
     pinchApply( inRGBBuffer );
+    MAXIGIN_PROFILE_ZONE_END();
     }
 
 
@@ -1121,11 +1124,22 @@ void maxiginGame_step( void ) {
 
     if( moveMade ) {
 
-        char moveDone = stepMoveAnimation( &boardState,
-                                           &boardMove,
-                                           &postMoveCaptured,
-                                           &postMoveState,
-                                           &moveProgress );
+        char moveDone;
+
+        if( maxigin_isButtonDown( FAST_FORWARD ) ) {
+            /* skip rest of move animation */
+            resolveMoveAnimation( &boardState,
+                                  &boardMove,
+                                  &postMoveCaptured,
+                                  &postMoveState,
+                                  &moveProgress );
+            }
+        
+        moveDone = stepMoveAnimation( &boardState,
+                                      &boardMove,
+                                      &postMoveCaptured,
+                                      &postMoveState,
+                                      &moveProgress );
 
         if( moveDone ) {
 
@@ -2062,6 +2076,9 @@ static MinginButton rotColors2Mapping[] = { MGN_KEY_3,  MGN_MAP_END };
 static MinginButton rotColorsAllMapping[] = { MGN_KEY_4,  MGN_MAP_END };
 static MinginButton printColorsMapping[] = { MGN_KEY_5,  MGN_MAP_END };
 
+/* not F, which maxigin keeps for toggling fullscreen */
+static MinginButton fastForwardMapping[] = { MGN_KEY_TAB,  MGN_MAP_END };
+
 
 static MinginButton actionMapping[]  =  { MGN_BUTTON_MOUSE_LEFT,
                                           MGN_BUTTON_PS_X,
@@ -2388,6 +2405,8 @@ void maxiginGame_init( void ) {
                                    rotColorsAllMapping );
     maxigin_registerButtonMapping( PRINT_COLORS,
                                    printColorsMapping );
+    maxigin_registerButtonMapping( FAST_FORWARD,
+                                   fastForwardMapping );
     
     maxigin_registerDynamicButtonMapping(
         ACTION,
@@ -2507,8 +2526,10 @@ void maxiginGame_init( void ) {
     pieceDescriptionsInit();
 
     navInit();
-    
+
+    maxigin_initStartProfilePhase( "levelsInit" );
     levelsInit();
+    maxigin_initEndProfilePhase();
 
     deckInit();
 
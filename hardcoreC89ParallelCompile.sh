@@ -51,7 +51,7 @@ fi
 
 if [[ $anyRebuilt -ne 0 ]]; then
 	if [[ -e mingin_imp.o && -e maxigin_imp.o && -e game.o ]]; then
-		gcc -o Chessamphetamine mingin_imp.o maxigin_imp.o game.o -lX11 -lXrandr -lGLX -lGL -lasound -lpthread
+		gcc -o Chessamphetamine mingin_imp.o maxigin_imp.o game.o -lX11 -lXrandr -lXext -lGLX -lGL -lasound -lpthread
 	fi
 fi
 
@@ -118,19 +118,23 @@
 
 
 /*
-  If recording is enabled, what is the maximum total size of the
+  If recording is enabled, what is the expected total size of the
   static memory that the game will register with:
 
       maxigin_initRegisterStaticMemory
 
-  Maxigin will actually use 2x this amount of static memory internally as
-  part of its incremental diff recording process.
+  Maxigin sets aside a static arena with room for MAXIGIN_RECORDING_RING_STEPS
+  copies of this amount, plus 2x this amount for encoding, as part of its
+  incremental diff recording process.  At startup, the arena is divided up
+  based on how much memory the game actually registered, and untouched parts
+  of the arena cost nothing on most platforms.
 
   This static memory is ONLY compiled into the program if
   MAXIGIN_ENABLE_RECORDING is set to 1 (which is the default).
 
-  If the game registers MORE than this amount, recording will still work,
-  but incremental diff recording will be disabled.
+  If the game registers MORE than this amount, recording will still work with
+  fewer steps waiting to be written, as long as the arena has room for
+  at least 2 copies plus encoding.
 
   To set the max static size to 256, do this:
 
@@ -139,7 +143,79 @@
   [jumpSettings]
 */
 #ifndef  MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES
-#define  MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES  4096
+#define  MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES  262144
+#endif
+
+
+
+/*
+  If recording is enabled, how many steps of captured memory can be
+  waiting to be written to the recording?
+
+  Each step of the game only captures memory, and diffing and writing the
+  recording happen in a background thread, on platforms that support one.
+  If the writer falls this many steps behind, the game step waits for it.
+
+  Must be at least 2.
+
+  To allow 16 steps to be waiting, do this:
+
+      #define  MAXIGIN_RECORDING_RING_STEPS   17
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_RECORDING_RING_STEPS
+#define  MAXIGIN_RECORDING_RING_STEPS  8
+#endif
+
+
+
+/*
+  If recording is enabled, how many full snapshots from a recording's index
+  are loaded into memory when playback starts?
+
+  Jumping around during playback looks up snapshots in this table without
+  touching the recording file.  Snapshots beyond this many are still
+  reachable, but are looked up in the file.
+
+  To keep 1024 snapshots in memory, do this:
+
+      #define  MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS   1024
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS
+#define  MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS  4096
+#endif
+
+
+
+/*
+  During playback, copies of the game's memory are kept as keyframes every
+  MAXIGIN_PLAYBACK_KEYFRAME_INTERVAL steps, as they are played in either
+  direction.  Jumping back to a step near a keyframe restores the keyframe
+  and plays forward from there, instead of re-reading every diff from the
+  nearest full snapshot.  Fast reverse playback does the same when a
+  keyframe is closer than the steps it needs to take backward.
+
+  Keyframes share the static arena used for recording (playback and
+  recording never run at the same time), so how many fit depends on
+  how much memory the game registers.  MAXIGIN_MAX_PLAYBACK_KEYFRAMES caps
+  how many are kept, with the least recently used keyframe replaced first.
+
+  To keep up to 128 keyframes, one every 10 steps, do this:
+
+      #define  MAXIGIN_MAX_PLAYBACK_KEYFRAMES      128
+      #define  MAXIGIN_PLAYBACK_KEYFRAME_INTERVAL  10
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_MAX_PLAYBACK_KEYFRAMES
+#define  MAXIGIN_MAX_PLAYBACK_KEYFRAMES  64
+#endif
+
+#ifndef  MAXIGIN_PLAYBACK_KEYFRAME_INTERVAL
+#define  MAXIGIN_PLAYBACK_KEYFRAME_INTERVAL  30
 #endif
 
 
@@ -208,6 +284,59 @@
 
 
 
+/*
+  Glow sprites are blurred, so they have too many colors for a palette.
+  maxigin_initPaletteSprite lets glow colors that match after dropping up
+  to this many low bits per channel share an averaged palette color.
+  Glows are compared by how much they add to the screen, so this is
+  roughly how many low bits of that can be lost.
+
+  0 leaves glows with more than 256 colors as RGBA.
+
+  To allow glows to be off by at most 31 out of 255, do this:
+
+      #define  MAXIGIN_GLOW_PALETTE_MAX_DROP_BITS  5
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_GLOW_PALETTE_MAX_DROP_BITS
+#define  MAXIGIN_GLOW_PALETTE_MAX_DROP_BITS  3
+#endif
+
+
+
+/*
+  How many cached drawing layers are supported?
+
+  See maxigin_initLayer.
+
+  To make room for 4 layers, do this:
+
+      #define  MAXIGIN_MAX_NUM_LAYERS  4
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_MAX_NUM_LAYERS
+#define  MAXIGIN_MAX_NUM_LAYERS  8
+#endif
+
+
+
+/*
+  Layers are stored as RGB pixels in a statically allocated memory buffer.
+
+  To allocate room for one 100x100 layer, do this:
+
+      #define  MAXIGIN_MAX_TOTAL_LAYER_BYTES  30000
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_MAX_TOTAL_LAYER_BYTES
+#define  MAXIGIN_MAX_TOTAL_LAYER_BYTES  1000000
+#endif
+
+
+
 /*
   How many unique sound effects are supported?
 
@@ -390,6 +519,62 @@
 
 
 
+/*
+  Enable the per-frame profiler, which times named zones in each frame
+  (see MAXIGIN_PROFILE_ZONE_START), shows a graph of recent frames
+  on top of the game when F3 is pressed, and exports recent frames as a
+  Chrome trace-event file when F4 is pressed.
+
+  Off by default, which compiles the profiler and all zones out entirely.
+
+  This setting must be the same for every .c file that includes maxigin.h.
+
+  Build mingin with MINGIN_ENABLE_PRESENT_TIMING too, so that the profiler
+  can show how long the platform spends presenting each frame.
+
+  To enable the profiler, do this:
+
+      #define  MAXIGIN_ENABLE_FRAME_PROFILER  1
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_ENABLE_FRAME_PROFILER
+#define  MAXIGIN_ENABLE_FRAME_PROFILER  0
+#endif
+
+
+
+/*
+  If the frame profiler is enabled, how many recent frames are kept?
+
+  To keep 512 frames, do this:
+
+      #define  MAXIGIN_PROFILER_NUM_FRAMES  512
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_PROFILER_NUM_FRAMES
+#define  MAXIGIN_PROFILER_NUM_FRAMES  240
+#endif
+
+
+
+/*
+  If the frame profiler is enabled, how many zones can be timed in
+  each frame?
+
+  To allow 64 zones per frame, do this:
+
+      #define  MAXIGIN_PROFILER_MAX_FRAME_ZONES  64
+
+  [jumpSettings]
+*/
+#ifndef  MAXIGIN_PROFILER_MAX_FRAME_ZONES
+#define  MAXIGIN_PROFILER_MAX_FRAME_ZONES  32
+#endif
+
+
+
 
 
 /*
@@ -795,6 +980,33 @@ void maxigin_initMakeDropShadowSprite( int            inSpriteHandle,
 
 
 
+/*
+  Repacks a loaded sprite, along with its glow and drop shadow sprites, so
+  that each pixel is stored as a one-byte index into a palette of the
+  sprite's RGBA colors, with colors looked up from the palette as the sprite
+  is drawn.
+
+  For pixel art with few colors, this cuts the sprite's data to about a
+  quarter of its RGBA size.
+
+  Call this after applying any color map and making any glow or drop
+  shadows for the sprite, since those work on RGBA pixels.
+
+  A glow sprite with more than 256 colors has similar colors merged, see
+  MAXIGIN_GLOW_PALETTE_MAX_DROP_BITS.  Other sprites with more than 256
+  colors, and sprites from sprite strips, are left as RGBA.
+  Hot-reloaded sprites also go back to RGBA.
+  
+  Parameters:
+
+      inSpriteHandle     the sprite to repack
+
+  [jumpMaxiginInit]  
+*/
+void maxigin_initPaletteSprite( int  inSpriteHandle );
+
+
+
 /*
   Loads a TGA-formatted sprite strip from the platform's bulk data store.
 
@@ -1384,6 +1596,53 @@ int maxigin_initSoundEffect( const char  *inBulkResourceName );
 
 
 
+/*
+  Starts timing a named phase of startup, for the startup profile.
+
+  Maxigin times its own startup phases (sprite cache, sprite loading,
+  glow and shadow generation, fonts, languages, sound effects), and games
+  can wrap their own expensive init steps in phases too.
+
+  Phases nest:  a phase started while another is running is recorded as
+  a child of it.  Starting a phase with the same name under the same parent
+  more than once adds to that phase's total time and call count.
+
+  The profile is written to the persistent data store as text when
+  init is done, to
+
+      maxigin_startupProfileCold.txt   if sprites were generated from
+                                       bulk data
+
+      maxigin_startupProfileWarm.txt   if sprites came from the
+                                       sprite cache
+
+  If the maxigin_printStartupProfile.ini setting is 1, the profile is also
+  logged.
+
+  Times have millisecond resolution.
+
+  Each call must be matched by a call to maxigin_initEndProfilePhase.
+
+  Parameters:
+
+      inPhaseName   the name of the phase, which must be a static
+                    string that stays valid for the rest of startup
+  
+  [jumpMaxiginInit]
+*/
+void maxigin_initStartProfilePhase( const char  *inPhaseName );
+
+
+
+/*
+  Ends the most recently started startup profile phase.
+
+  [jumpMaxiginInit]
+*/
+void maxigin_initEndProfilePhase( void );
+
+
+
 
 
 /*
@@ -1549,6 +1808,115 @@ void maxigin_drawClearClipRectangles( void );
 
 
 
+/*
+  Sets up a layer, which caches a rectangle of the game's native pixel
+  buffer so that static content that is expensive to draw sprite by sprite
+  can be redrawn later with a block copy.
+
+  Layers are captured on top of black and copied, not blended, back into
+  the pixel buffer, so they only reproduce the original drawing where the
+  destination is still black.
+
+  Parameters:
+
+      inWide   the width of the layer in pixels
+
+      inHigh   the height of the layer in pixels
+
+  Returns:
+
+      layer handle   on success
+
+      -1             on failure (out of layer slots or layer space)
+
+  [jumpMaxiginInit]
+*/
+int maxigin_initLayer( int  inWide,
+                       int  inHigh );
+
+
+
+/*
+  Starts capturing a layer.
+
+  Call this before drawing the layer's content normally, and call
+  maxigin_drawEndLayer after.
+
+  Capturing only happens if no clip rectangle is set and the layer's
+  rectangle in the native pixel buffer is entirely black before drawing.
+
+  Parameters:
+
+      inLayerHandle   the layer to capture into
+
+      inStartX        the x position in the game's native pixel buffer of the
+                      layer's top left corner
+
+      inStartY        the y position in the game's native pixel buffer of the
+                      layer's top left corner
+
+  Returns:
+
+      1   if capturing has started
+
+      0   if the layer can't be captured here
+
+  [jumpMaxiginDraw]
+*/
+char maxigin_drawBeginLayer( int  inLayerHandle,
+                             int  inStartX,
+                             int  inStartY );
+
+
+
+/*
+  Finishes capturing a layer started with maxigin_drawBeginLayer, copying
+  everything drawn since then in the layer's rectangle into the layer.
+
+  Parameters:
+
+      inLayerHandle   the layer to finish capturing
+
+  [jumpMaxiginDraw]
+*/
+void maxigin_drawEndLayer( int  inLayerHandle );
+
+
+
+/*
+  Copies a captured layer into the game's native pixel buffer, respecting
+  the current clip rectangle.
+
+  Nothing is drawn if the layer hasn't been captured, if a sprite has been
+  hot-reloaded since capturing, if the layer would be cut off by the edge
+  of the pixel buffer in a way that it wasn't when captured, or if the
+  destination rectangle isn't entirely black.
+
+  Parameters:
+
+      inLayerHandle   the layer to draw
+
+      inStartX        the x position in the game's native pixel buffer of the
+                      layer's top left corner
+
+      inStartY        the y position in the game's native pixel buffer of the
+                      layer's top left corner
+
+  Returns:
+
+      1   if the layer was drawn
+
+      0   if nothing was drawn, and the layer's content should be drawn
+          normally instead
+
+  [jumpMaxiginDraw]
+*/
+char maxigin_drawLayer( int  inLayerHandle,
+                        int  inStartX,
+                        int  inStartY );
+
+
+
 /*
   Draws a sprite into the game's native pixel buffer.
 
@@ -3533,6 +3901,51 @@ int maxigin_getElapsedMilliseconds( MaxiginTimer  inTimer );
 
 
 
+/*
+  Starts timing a named zone of the current frame, for the frame profiler.
+
+  Zones nest:  a zone started while another is running is shown inside it.
+
+  Use through these macros, which compile to nothing unless
+  MAXIGIN_ENABLE_FRAME_PROFILER is 1  [jumpSettings]
+
+      MAXIGIN_PROFILE_ZONE_START( "pinchApply" );
+
+      pinchApply( ... );
+
+      MAXIGIN_PROFILE_ZONE_END();
+
+  Zones can be timed from maxiginGame_step or maxiginGame_getNativePixels.
+
+  Each start must be matched by an end in the same function call.
+
+  Parameters:
+
+      inZoneName   the name of the zone, which must be a static string
+  
+  [jumpMaxiginGeneral]
+*/
+#if MAXIGIN_ENABLE_FRAME_PROFILER
+
+void maxigin_startProfileZone( const char  *inZoneName );
+
+void maxigin_endProfileZone( void );
+
+#define  MAXIGIN_PROFILE_ZONE_START( inZoneName ) \
+    maxigin_startProfileZone( inZoneName )
+
+#define  MAXIGIN_PROFILE_ZONE_END() \
+    maxigin_endProfileZone()
+
+#else
+
+#define  MAXIGIN_PROFILE_ZONE_START( inZoneName )
+#define  MAXIGIN_PROFILE_ZONE_END()
+
+#endif
+
+
+
 
 
 /*
@@ -3802,6 +4215,10 @@ typedef enum MaxiginUserAction {
     MAXIGIN_HIDE_GUI,
     MAXIGIN_ADD_LOOP_POINT,
     MAXIGIN_CLEAR_LOOP_POINTS,
+#if MAXIGIN_ENABLE_FRAME_PROFILER
+    MAXIGIN_PROFILER_TOGGLE,
+    MAXIGIN_PROFILER_EXPORT,
+#endif
     LAST_MAXIGIN_USER_ACTION
     } MaxiginUserAction;
 
@@ -3957,6 +4374,12 @@ static  char            mx_hideGUI            =  0;
 static void mx_generateCRTOverlay( int  inW,
                                    int  inH );
 
+#if MAXIGIN_ENABLE_FRAME_PROFILER
+static  char  mx_profilerOverlayOn  =  0;
+
+static void mx_drawProfilerOverlay( void );
+#endif
+
 
 
 void minginGame_getScreenPixels( int             inWide,
@@ -3980,15 +4403,26 @@ void minginGame_getScreenPixels( int             inWide,
 
 
     mx_areWeInMaxiginGameDrawFunction = 1;
-    
+
+    MAXIGIN_PROFILE_ZONE_START( "maxiginGame_getNativePixels" );
     maxiginGame_getNativePixels( mx_gameImageBuffer );
+    MAXIGIN_PROFILE_ZONE_END();
 
     if( ! mx_hideGUI ) {
+        MAXIGIN_PROFILE_ZONE_START( "drawGUI" );
         maxigin_drawGUI( &mx_internalGUI );
+        MAXIGIN_PROFILE_ZONE_END();
+        }
+
+#if MAXIGIN_ENABLE_FRAME_PROFILER
+    if( mx_profilerOverlayOn ) {
+        mx_drawProfilerOverlay();
         }
+#endif
     
     mx_areWeInMaxiginGameDrawFunction = 0;
 
+    MAXIGIN_PROFILE_ZONE_START( "upscale" );
     
     mx_computeScaling( inWide,
                        inHigh,
@@ -4026,6 +4460,8 @@ void minginGame_getScreenPixels( int             inWide,
                 }
             }
 
+        MAXIGIN_PROFILE_ZONE_END();
+        
         return;
         }
 
@@ -4098,6 +4534,10 @@ void minginGame_getScreenPixels( int             inWide,
             }
         }
 
+    MAXIGIN_PROFILE_ZONE_END();
+
+    MAXIGIN_PROFILE_ZONE_START( "crtOverlay" );
+    
     if( mx_crtOverlayLive
         &&
         ( mx_crtOverlayW != scaledGameW
@@ -4160,6 +4600,8 @@ void minginGame_getScreenPixels( int             inWide,
             destI = startDestI + inWide * 3;
             }
         }
+
+    MAXIGIN_PROFILE_ZONE_END();
     }
 
 
@@ -4399,11 +4841,15 @@ static void mx_generateCRTOverlay( int  inW,
                                                    numBytes,
                                                    mx_crtOverlayPixelBuffer );
 
+        if( ! mingin_endWritePersistData( storageHandle ) ) {
+            success = 0;
+            }
+
         if( ! success ) {
             maxigin_logString( "Failed to write out crtOverlay: ",
                                resName );
+            mingin_deletePersistData( resName );
             }
-        mingin_endWritePersistData( storageHandle );
         }
     else {
         maxigin_logString( "Failed to open crtOverlay for writing: ",
@@ -4424,9034 +4870,12695 @@ static void mx_finalizeSpriteCache( void );
 
 
 
-#define  MAXIGIN_SPRITE_MAX_BULK_NAME_LENGTH  64
+/*
+  Startup profile, timing nested phases of init, and written out to a
+  cold or warm profile file at the end of init.
 
-#define  MAXIGIN_SPRITE_HASH_LENGTH            4
+  See maxigin_initStartProfilePhase
+*/
+#define  MAXIGIN_MAX_PROFILE_PHASES      64
+#define  MAXIGIN_MAX_PROFILE_DEPTH       16
 
 
-typedef struct MaxiginSprite {
-        
-        int            w;
-        int            h;
+typedef struct MaxiginProfilePhase {
+        const char    *name;
 
-        /* how far visible pixels (alpha > 0) extend beyond left and
-           right of sprite center */
-        int            leftVisibleRadius;
-        int            rightVisibleRadius;
+        /* index of parent phase, or -1 for top-level phases */
+        int            parent;
 
-        /* how far visible pixels (alpha > 0) extend above and
-           below sprite center */
-        int            upperVisibleRadius;
-        int            lowerVisibleRadius;
-        
-        /*
-          Index for this sprite into font kerning table.
+        int            depth;
 
-          Only used for sprites that are font glyphs.
-          
-          -1 if it hasn't been computed.
-        */
-        int            kerningTableIndex;
+        int            numCalls;
+        
+        int            totalMilliseconds;
 
+        MaxiginTimer   timer;
         
-        /* index into mx_spriteBytes */
-        int            startByte;
+    } MaxiginProfilePhase;
 
-        char           bulkResourceName[ MAXIGIN_SPRITE_MAX_BULK_NAME_LENGTH ];
 
-        char           pendingChange;
+static  char                 mx_startupProfileActive  =  0;
 
-        int            retryCount;
+static  MaxiginProfilePhase  mx_profilePhases[ MAXIGIN_MAX_PROFILE_PHASES ];
+static  int                  mx_numProfilePhases      =  0;
 
-        int            stepsUntilNextRetry;
+/* indices of running phases, or -1 for phases that didn't fit */
+static  int                  mx_profileStack[ MAXIGIN_MAX_PROFILE_DEPTH ];
+static  int                  mx_profileStackDepth     =  0;
 
-        /* -1 if this sprite has no glow sprite */
-        int            glowSpriteHandle;
-        int            glowRadius;
-        int            glowIterations;
 
-        /* -1 if this sprite has not had a color map applied */
-        int            colorMapHandle;
-        int            colorMapRow;
-        /* 1 if this sprite is itself a color map */
-        char           isColorMap;
 
-        
-        int            numShadows;
-        int            shadowSpriteHandle [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        int            shadowRadius       [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        int            shadowIterations   [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        unsigned char  shadowBottomAlpha  [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        unsigned char  shadowTopAlpha     [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        unsigned char  shadowBottomPercent[ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        unsigned char  shadowTopPercent   [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        int            shadowDarkness     [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        unsigned char  shadowGrayValue    [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
-        
+static void mx_startProfilePhase( const char  *inPhaseName ) {
 
-        /* handle of full sprite strip that this is a sub-sprite of, or -1
-           if not part of a strip */
-        int            stripParentHandle;
-        int            stripIndex;
+    int  parent  =  -1;
+    int  p;
+    
+    if( ! mx_startupProfileActive ) {
+        return;
+        }
 
-        /* if this sprite is the parent of a strip of sprites, this
-           is the handle to the sprite strip, or -1 if not */
-        int            stripChildHandle;
-        
-        unsigned char  hash[ MAXIGIN_SPRITE_HASH_LENGTH ];
+    if( mx_profileStackDepth >= MAXIGIN_MAX_PROFILE_DEPTH ) {
+        maxigin_logString( "Startup profile phases nested too deeply at: ",
+                           inPhaseName );
+        return;
+        }
+    
+    if( mx_profileStackDepth > 0 ) {
+        parent = mx_profileStack[ mx_profileStackDepth - 1 ];
+        }
+
+    for( p = 0;
+         p < mx_numProfilePhases;
+         p ++ ) {
+
+        if( mx_profilePhases[ p ].parent == parent
+            &&
+            maxigin_stringsEqual( mx_profilePhases[ p ].name,
+                                  inPhaseName ) ) {
+            break;
+            }
+        }
+
+    if( p == mx_numProfilePhases ) {
         
-    } MaxiginSprite;
+        if( mx_numProfilePhases < MAXIGIN_MAX_PROFILE_PHASES ) {
+            
+            MaxiginProfilePhase  *newPhase  =
+                &( mx_profilePhases[ mx_numProfilePhases ] );
+            
+            newPhase->name              = inPhaseName;
+            newPhase->parent            = parent;
+            newPhase->depth             = mx_profileStackDepth;
+            newPhase->numCalls          = 0;
+            newPhase->totalMilliseconds = 0;
+            
+            mx_numProfilePhases ++;
+            }
+        else {
+            maxigin_logString( "Too many startup profile phases, "
+                               "not timing: ",
+                               inPhaseName );
+            p = -1;
+            }
+        }
 
+    if( p != -1 ) {
+        mx_profilePhases[ p ].timer = maxigin_startTimer();
+        }
+    
+    mx_profileStack[ mx_profileStackDepth ] = p;
+    mx_profileStackDepth ++;
+    }
 
 
-static  unsigned char  mx_spriteBytes  [ MAXIGIN_MAX_TOTAL_SPRITE_BYTES ];
-static  MaxiginSprite  mx_sprites      [ MAXIGIN_MAX_NUM_SPRITES        ];
 
-static  int            mx_numSpriteBytesUsed  =  0;
-static  int            mx_numSprites          =  0;
+static void mx_endProfilePhase( void ) {
 
+    int  p;
+    
+    if( ! mx_startupProfileActive ) {
+        return;
+        }
 
+    if( mx_profileStackDepth == 0 ) {
+        mingin_log( "Ended a startup profile phase that wasn't started\n" );
+        return;
+        }
+    
+    mx_profileStackDepth --;
 
-static void mx_dumpSpriteRGBA( int  inSpriteHandle ) {
+    p = mx_profileStack[ mx_profileStackDepth ];
 
-    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle ] );
+    if( p == -1 ) {
+        return;
+        }
 
-    mx_dumpRGBAPixels( &( mx_spriteBytes[ s->startByte ] ),
-                       s->w,
-                       s->h );
+    mx_profilePhases[ p ].numCalls ++;
+    
+    mx_profilePhases[ p ].totalMilliseconds +=
+        maxigin_getElapsedMilliseconds( mx_profilePhases[ p ].timer );
     }
 
 
 
-typedef struct MaxiginClipRectangle {
-
-        int  startX;
-        int  endX;
-        int  startY;
-        int  endY;
+void maxigin_initStartProfilePhase( const char  *inPhaseName ) {
+    
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call maxigin_initStartProfilePhase "
+                    "from outside of maxiginGame_init\n" );
+        return;
+        }
 
-    } MaxiginClipRectangle;
+    mx_startProfilePhase( inPhaseName );
+    }
 
 
 
-static  MaxiginClipRectangle  mx_clipStack
-                                  [ MAXIGIN_MAX_NUM_CLIPPING_RECTANGLES ];
+void maxigin_initEndProfilePhase( void ) {
+    
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call maxigin_initEndProfilePhase "
+                    "from outside of maxiginGame_init\n" );
+        return;
+        }
 
-static  int                   mx_clipStackDepth  =  0;
+    mx_endProfilePhase();
+    }
 
 
 
-void maxigin_drawPushClipRectangle( int  inStartX,
-                                    int  inEndX,
-                                    int  inStartY,
-                                    int  inEndY ) {
+static void mx_startStartupProfile( void ) {
     
-    MaxiginClipRectangle  curClip;
+    mx_numProfilePhases     = 0;
+    mx_profileStackDepth    = 0;
+    mx_startupProfileActive = 1;
+    }
 
-    int                   nextStackPos;
 
-    if( mx_clipStackDepth > 0 ) {
-        curClip = mx_clipStack[ mx_clipStackDepth - 1 ];
-        }
-    else {
-        /* empty stack, cur is whole screen */
-        curClip.startX = 0;
-        curClip.endX   = MAXIGIN_GAME_NATIVE_W - 1;
-        curClip.startY = 0;
-        curClip.endY   = MAXIGIN_GAME_NATIVE_H - 1;
-        }
 
-    
-    /* handle -1 params for defaults, all the way to edge of screen */
-    if( inStartX == -1 ) {
-        inStartX = 0;
-        }
-    if( inEndX == -1 ) {
-        inEndX = MAXIGIN_GAME_NATIVE_W - 1;
-        }
-    if( inStartY == -1 ) {
-        inStartY = 0;
-        }
-    if( inEndY == -1 ) {
-        inEndY = MAXIGIN_GAME_NATIVE_H - 1;
-        }
+/*
+  Writes a profile line, depth-first from inPhase, to an open store, and
+  logs it if inPrint is set.
 
-    /* trim new clip by current
-       
-       since the first clip pushed is trimmed by screen, all
-       clips will also be trimmed by screen, since they are nested */
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writeProfilePhase( int   inStoreWriteHandle,
+                                  int   inPhase,
+                                  char  inPrint ) {
 
-    if( inStartX < curClip.startX ) {
-        inStartX = curClip.startX;
+    MaxiginProfilePhase  *phase  =  &( mx_profilePhases[ inPhase ] );
+    const char           *line   =  "";
+    int                   d;
+    int                   p;
+
+    for( d = 0;
+         d < phase->depth;
+         d ++ ) {
+        line = maxigin_stringConcat( line, "    " );
         }
-    if( inEndX > curClip.endX ) {
-        inEndX = curClip.endX;
+
+    line = maxigin_stringConcat5(
+        line,
+        phase->name,
+        "  ",
+        maxigin_intToString( phase->totalMilliseconds ),
+        " ms" );
+
+    if( phase->numCalls > 1 ) {
+        line = maxigin_stringConcat4(
+            line,
+            "  (",
+            maxigin_intToString( phase->numCalls ),
+            " calls)" );
         }
-    if( inStartY < curClip.startY ) {
-        inStartY = curClip.startY;
+    
+    line = maxigin_stringConcat( line, "\n" );
+
+    if( inPrint ) {
+        mingin_log( line );
         }
-    if( inEndY > curClip.endY ) {
-        inEndY = curClip.endY;
+
+    if( ! mingin_writePersistData( inStoreWriteHandle,
+                                   maxigin_stringLength( line ),
+                                   (unsigned char*)line ) ) {
+        return 0;
         }
 
-    nextStackPos = mx_clipStackDepth;
+    /* children follow in the order they were first started */
+    for( p = inPhase + 1;
+         p < mx_numProfilePhases;
+         p ++ ) {
 
-    if( nextStackPos >= MAXIGIN_MAX_NUM_CLIPPING_RECTANGLES ) {
-        maxigin_logInt2( "Trying to push clipping rectangle number ",
-                         nextStackPos + 1,
-                         ", but there's only room for ",
-                         MAXIGIN_MAX_NUM_CLIPPING_RECTANGLES,
-                         ", merging this rectangle with previous one." );
-        nextStackPos = MAXIGIN_MAX_NUM_CLIPPING_RECTANGLES - 1;
-        }
-    else {
-        mx_clipStackDepth ++;
+        if( mx_profilePhases[ p ].parent == inPhase ) {
+            
+            if( ! mx_writeProfilePhase( inStoreWriteHandle,
+                                        p,
+                                        inPrint ) ) {
+                return 0;
+                }
+            }
         }
-    
-    mx_clipStack[ nextStackPos ].startX = inStartX;
-    mx_clipStack[ nextStackPos ].endX = inEndX;
-    mx_clipStack[ nextStackPos ].startY = inStartY;
-    mx_clipStack[ nextStackPos ].endY = inEndY;  
+
+    return 1;
     }
 
 
 
-void maxigin_drawPopClipRectangle( void ) {
-    mx_clipStackDepth --;
+/*
+  Ends profiling and writes the profile out.
+*/
+static void mx_finishStartupProfile( void ) {
 
-    if( mx_clipStackDepth < 0 ) {
-        mx_clipStackDepth = 0;
+    const char  *storeName  =  "maxigin_startupProfileCold.txt";
+    const char  *firstLine  =  "Startup profile, cold:\n";
+    char         print;
+    int          store;
+    int          p;
+    
+    if( ! mx_startupProfileActive ) {
+        return;
         }
-    }
 
+    while( mx_profileStackDepth > 0 ) {
+        maxigin_logString( "Startup profile phase never ended: ",
+                           mx_profilePhases[
+                               mx_profileStack[
+                                   mx_profileStackDepth - 1 ] ].name );
+        mx_endProfilePhase();
+        }
+    
+    mx_startupProfileActive = 0;
 
+    if( mx_spriteCacheLoaded ) {
+        storeName = "maxigin_startupProfileWarm.txt";
+        firstLine = "Startup profile, warm:\n";
+        }
 
-void maxigin_drawClearClipRectangles( void ) {
-    mx_clipStackDepth = 0;
-    }
+    print = maxigin_readFlagSetting( "maxigin_printStartupProfile.ini",
+                                     0 );
 
+    store = mingin_startWritePersistData( storeName );
 
+    if( store == -1 ) {
+        maxigin_logString( "Failed to open startup profile for writing: ",
+                           storeName );
+        return;
+        }
 
-#define  MAXIGIN_TGA_BUFFER_SIZE  256
+    if( print ) {
+        mingin_log( firstLine );
+        }
+    
+    if( ! mingin_writePersistData( store,
+                                   maxigin_stringLength( firstLine ),
+                                   (unsigned char*)firstLine ) ) {
+        
+        maxigin_logString( "Failed to write startup profile: ",
+                           storeName );
+        mingin_endWritePersistData( store );
+        return;
+        }
 
-static  unsigned char  mx_tgaReadBuffer[ MAXIGIN_TGA_BUFFER_SIZE ];
+    for( p = 0;
+         p < mx_numProfilePhases;
+         p ++ ) {
+
+        if( mx_profilePhases[ p ].parent == -1
+            &&
+            ! mx_writeProfilePhase( store,
+                                    p,
+                                    print ) ) {
+            
+            maxigin_logString( "Failed to write startup profile: ",
+                               storeName );
+            break;
+            }
+        }
 
+    mingin_endWritePersistData( store );
+    }
 
 
-#define  MAXIGIN_PADDED_INT_LENGTH  12
 
+#if MAXIGIN_ENABLE_FRAME_PROFILER
 
 /*
-  Reads int and jumps ahead MAXIGIN_PADDED_INT_LENGTH total bytes, to skip
-  all padding.
+  Frame profiler, timing named zones in each frame into a ring of
+  recent frames.
 
-  Returns 1 on success, 0 on failure.
+  See MAXIGIN_ENABLE_FRAME_PROFILER and maxigin_startProfileZone
 */
-static char mx_readPaddedIntFromPeristentData( int   inStoreReadHandle,
-                                               int  *outInt );
+#define  MAXIGIN_PROFILER_MAX_DEPTH        16
+#define  MAXIGIN_PROFILER_NUM_COLORS       8
+#define  MAXIGIN_PROFILER_GRAPH_FRAMES     120
+#define  MAXIGIN_PROFILER_GRAPH_H          50
+/* 2 pixels per millisecond, so a 60 fps frame is about 33 pixels high */
+#define  MAXIGIN_PROFILER_US_PER_PIXEL     500
 
 
+typedef struct MaxiginProfileZone {
+        const char     *name;
 
-/*
-  Writes a \0-terminated string representation of an int to data store,
-  and pads it with \0 characters afterwards to fill paddedIntLength total.
+        int             depth;
 
-  Returns 1 on success, 0 on failure.
-*/
-static char mx_writePaddedIntToPerisistentData( int  inStoreWriteHandle,
-                                                int  inInt );
+        /* in mingin_getRunningMicroseconds time */
+        unsigned long   start;
+        unsigned long   end;
+        
+    } MaxiginProfileZone;
 
 
+typedef struct MaxiginProfileFrame {
+        unsigned long       start;
 
-/*
-  encapsulates both bulkReadHandle and persistentDataReadHandle
-  this allows us to cache generated sprites in our persistent data
-  and load them using the same code as fixed sprites loaded from bulk data
-*/
-typedef struct MinginOpenData {
+        /* start of the next frame, set when that frame starts */
+        unsigned long       end;
 
-        int   readHandle;
-        /* 0 if persistent data, 1 if bulk data */
-        char  isBulk;
+        int                 numZones;
         
-    } MinginOpenData;
+        MaxiginProfileZone  zones[ MAXIGIN_PROFILER_MAX_FRAME_ZONES ];
+        
+    } MaxiginProfileFrame;
 
 
+static  MaxiginProfileFrame  mx_profileFrames[ MAXIGIN_PROFILER_NUM_FRAMES ];
 
-static int mx_readData( MinginOpenData  *inDataHandle,
-                        int              inNumBytesToRead,
-                        unsigned char   *inByteBuffer ) {
+/* frame being timed, or -1 before first frame starts */
+static  int                  mx_profileCurrentFrame   =  -1;
 
-    if( inDataHandle->isBulk ) {
-        return mingin_readBulkData( inDataHandle->readHandle,
-                                    inNumBytesToRead,
-                                    inByteBuffer );
-        }
-    else {
-        return mingin_readPersistData( inDataHandle->readHandle,
-                                       inNumBytesToRead,
-                                       inByteBuffer );
+/* how many frames before the current one have ended, up to
+   MAXIGIN_PROFILER_NUM_FRAMES - 1 */
+static  int                  mx_profileNumFramesDone  =  0;
+
+/* zone indices of open zones, or -1 for zones that didn't fit in frame */
+static  int                  mx_profileZoneStack[ MAXIGIN_PROFILER_MAX_DEPTH ];
+static  int                  mx_profileZoneDepth      =  0;
+/* zones started beyond MAXIGIN_PROFILER_MAX_DEPTH */
+static  int                  mx_profileZoneOverflow   =  0;
+
+/* top-level zone names, in the order they got their graph colors */
+static  const char  *mx_profileColorNames[ MAXIGIN_PROFILER_NUM_COLORS ];
+static  int          mx_numProfileColorNames  =  0;
+
+static  unsigned char  mx_profileColors[ MAXIGIN_PROFILER_NUM_COLORS ][3] =
+    { { 230,  80,  80 },
+      {  80, 200,  80 },
+      {  80, 130, 240 },
+      { 230, 200,  60 },
+      { 200,  90, 220 },
+      {  70, 210, 210 },
+      { 240, 150,  60 },
+      { 180, 180, 180 } };
+
+static  const char  *mx_presentStageZoneNames[ MGN_NUM_PRESENT_STAGES ] =
+    { "presentUpload",
+      "presentSwap" };
+
+
+
+static void mx_addProfileZone( const char     *inZoneName,
+                               unsigned long   inStart,
+                               unsigned long   inEnd ) {
+
+    MaxiginProfileFrame  *f  =  &( mx_profileFrames[ mx_profileCurrentFrame ] );
+    MaxiginProfileZone   *z;
+    
+    if( f->numZones >= MAXIGIN_PROFILER_MAX_FRAME_ZONES ) {
+        return;
         }
+
+    z = &( f->zones[ f->numZones ] );
+
+    z->name  = inZoneName;
+    z->depth = 0;
+    z->start = inStart;
+    z->end   = inEnd;
+
+    f->numZones ++;
     }
 
 
 
-static int mx_getDataPosition( MinginOpenData  *inDataHandle ) {
-    if( inDataHandle->isBulk ) {
-        return mingin_getBulkDataPosition( inDataHandle->readHandle );
+void maxigin_startProfileZone( const char  *inZoneName ) {
+
+    MaxiginProfileFrame  *f;
+    int                   z  =  -1;
+    
+    if( mx_profileCurrentFrame == -1 ) {
+        return;
         }
-    else {
-        return mingin_getPersistDataPosition( inDataHandle->readHandle );
+
+    if( mx_profileZoneDepth >= MAXIGIN_PROFILER_MAX_DEPTH ) {
+        mx_profileZoneOverflow ++;
+        return;
         }
-    }
 
+    f = &( mx_profileFrames[ mx_profileCurrentFrame ] );
+
+    if( f->numZones < MAXIGIN_PROFILER_MAX_FRAME_ZONES ) {
+
+        MaxiginProfileZone  *newZone;
         
+        z = f->numZones;
+        f->numZones ++;
 
-/* removes sprite data from sprite data store and collapses
-   subsequent sprite data back to fill the gap
-*/
-static void mx_removeSpriteData( int  inSpriteHandle ) {
+        newZone = &( f->zones[ z ] );
+        
+        newZone->name  = inZoneName;
+        newZone->depth = mx_profileZoneDepth;
+        newZone->start = mingin_getRunningMicroseconds();
+        newZone->end   = newZone->start;
+        }
+    
+    mx_profileZoneStack[ mx_profileZoneDepth ] = z;
+    mx_profileZoneDepth ++;
+    }
 
-    int  b;
-    int  s;
-    int  oldSpriteBytes  =  mx_sprites[ inSpriteHandle ].w *
-                            mx_sprites[ inSpriteHandle ].h * 4;
 
 
-    if( mx_sprites[ inSpriteHandle ].startByte == -1 ) {
-        /* data already removed */
+void maxigin_endProfileZone( void ) {
+
+    int  z;
+    
+    if( mx_profileCurrentFrame == -1 ) {
+        return;
+        }
+    
+    if( mx_profileZoneOverflow > 0 ) {
+        mx_profileZoneOverflow --;
         return;
         }
-        
-    /* collapse memory location of existing sprite,
-       moving all subsequent sprite data back */
-
-    for( b = mx_sprites[ inSpriteHandle ].startByte;
-         b < mx_numSpriteBytesUsed - oldSpriteBytes;
-         b ++ ) {
 
-        mx_spriteBytes[ b ] = mx_spriteBytes[ b + oldSpriteBytes ];
+    if( mx_profileZoneDepth == 0 ) {
+        mingin_log( "Ended a profile zone that wasn't started\n" );
+        return;
         }
 
-    /* update all sprites that pointed into the now-moved sprite data */
-    for( s = 0;
-         s < mx_numSprites;
-         s ++ ) {
-            
-        if( mx_sprites[ s ].startByte
-            > 
-            mx_sprites[ inSpriteHandle ].startByte ) {
+    mx_profileZoneDepth --;
 
-            mx_sprites[ s ].startByte -= oldSpriteBytes;
-            }
+    z = mx_profileZoneStack[ mx_profileZoneDepth ];
+
+    if( z != -1 ) {
+        mx_profileFrames[ mx_profileCurrentFrame ].zones[ z ].end =
+            mingin_getRunningMicroseconds();
         }
+    }
 
-    mx_numSpriteBytesUsed -= oldSpriteBytes;
 
-    /* stick -1 in for byte index of this sprite record, since
-       its data is gone */
-    mx_sprites[ inSpriteHandle ].startByte = -1;
-    }
 
+/* ends the current frame, if any, and starts timing the next one */
+static void mx_startProfileFrame( void ) {
 
+    unsigned long  now  =  mingin_getRunningMicroseconds();
+    
+    if( mx_profileCurrentFrame != -1 ) {
 
+        MaxiginProfileFrame  *f  =
+            &( mx_profileFrames[ mx_profileCurrentFrame ] );
+        int                   s;
 
-static void mx_recomputeSpriteAttributes( int  inSpriteHandle ) {
+        if( mx_profileZoneDepth > 0 ) {
+            mingin_log( "Profile zones left open at end of frame\n" );
 
-    MaxiginSprite  *s            =  &( mx_sprites[ inSpriteHandle ] );
-    
-    int             leftRadius      =  0;
-    int             rightRadius     =  0;
-    int             upperRadius     =  0;
-    int             lowerRadius     =  0;
-    int             w               =  s->w;
-    int             h               =  s->h;
-    int             xCenter         =  w / 2;
-    int             yCenter         =  h / 2;
-    int             y;
-    int             startByte       =  s->startByte;
-    int             numSpriteBytes  =  w * h * 4;
-    
-    /* find left/right visible extents */
-    
-    for( y = 0;
-         y < h;
-         y ++ ) {
+            while( mx_profileZoneDepth > 0 ) {
+                maxigin_endProfileZone();
+                }
+            }
+        mx_profileZoneOverflow = 0;
 
-        int   curByte  =  startByte + y * w * 4;
-        int   x;
-        char  someVis  =  0;
-        
-        
-        for( x = 0;
-             x < w;
-             x ++ ) {
+        f->end = now;
 
-            unsigned char  a  =  mx_spriteBytes[ curByte + 3 ];
+        /* platform presented this frame after we drew it, and before
+           now */
+        for( s = 0;
+             s < MGN_NUM_PRESENT_STAGES;
+             s ++ ) {
 
-            if( a > 0 ) {
+            unsigned long  start;
+            unsigned long  end;
 
-                if( x - xCenter > rightRadius ) {
-                    rightRadius = x - xCenter;
-                    }
-                else if( xCenter - x > leftRadius ) {
-                    leftRadius = xCenter - x;
-                    }
-                someVis = 1;
+            if( mingin_getLastPresentTiming( (MinginPresentStage)s,
+                                             &start,
+                                             &end )
+                &&
+                start - f->start <= now - f->start
+                &&
+                end - f->start <= now - f->start ) {
+
+                mx_addProfileZone( mx_presentStageZoneNames[ s ],
+                                   start,
+                                   end );
                 }
-            
-            /* on to next pixel */
-            curByte += 4;
             }
 
-        if( someVis ) {
-            /* some pixels in this row are visible */  
-            if( y - yCenter > lowerRadius ) {
-                lowerRadius =  y - yCenter;
-                }
-            else if( yCenter - y > upperRadius ) {
-                upperRadius = yCenter - y;
-                }
-            }       
+        if( mx_profileNumFramesDone < MAXIGIN_PROFILER_NUM_FRAMES - 1 ) {
+            mx_profileNumFramesDone ++;
+            }
         }
 
-    s->leftVisibleRadius  = leftRadius;
+    mx_profileCurrentFrame =
+        ( mx_profileCurrentFrame + 1 ) % MAXIGIN_PROFILER_NUM_FRAMES;
 
-    /* center position is actually off by 1 in favor of left radius */
-    s->rightVisibleRadius = rightRadius + 1;
+    mx_profileFrames[ mx_profileCurrentFrame ].start    = now;
+    mx_profileFrames[ mx_profileCurrentFrame ].end      = now;
+    mx_profileFrames[ mx_profileCurrentFrame ].numZones = 0;
+    }
 
-    s->upperVisibleRadius = upperRadius;
-    s->lowerVisibleRadius = lowerRadius + 1;
-    
 
-    /* hash bytes after origin flip and BGRA conversion */
 
-    maxigin_flexHash( numSpriteBytes,
-                      &( mx_spriteBytes[ startByte ] ),
-                      MAXIGIN_SPRITE_HASH_LENGTH,
-                      s->hash );
-    }
+/* gets a frame that has ended, where 0 is the oldest one we have */
+static MaxiginProfileFrame *mx_getDoneProfileFrame( int  inIndex ) {
+    
+    int  f  =  mx_profileCurrentFrame
+               - mx_profileNumFramesDone
+               + inIndex;
 
+    if( f < 0 ) {
+        f += MAXIGIN_PROFILER_NUM_FRAMES;
+        }
+    
+    return &( mx_profileFrames[ f ] );
+    }
 
 
-static void mx_initEmptyShadows( int  inSpriteHandle ) {
 
-    int  i;
+static int mx_getProfileColorIndex( const char  *inZoneName ) {
 
-    mx_sprites[ inSpriteHandle ].numShadows = 0;
+    int  c;
 
-    for( i = 0;
-         i < MAXIGIN_MAX_NUM_DROP_SHADOWS;
-         i ++ ) {
+    for( c = 0;
+         c < mx_numProfileColorNames;
+         c ++ ) {
+        
+        if( maxigin_stringsEqual( mx_profileColorNames[ c ],
+                                  inZoneName ) ) {
+            return c;
+            }
+        }
 
-        mx_sprites[ inSpriteHandle ].shadowSpriteHandle[ i ] = -1;
+    if( mx_numProfileColorNames < MAXIGIN_PROFILER_NUM_COLORS ) {
+        mx_profileColorNames[ mx_numProfileColorNames ] = inZoneName;
+        mx_numProfileColorNames ++;
+        
+        return mx_numProfileColorNames - 1;
         }
-    
+
+    /* out of colors, share the last one */
+    return MAXIGIN_PROFILER_NUM_COLORS - 1;
     }
 
 
 
-static int mx_reloadSpriteFromOpenData( const char      *inBulkResourceName,
-                                        int              inReloadHandle,
-                                        MinginOpenData  *inReadHandle,
-                                        int              inNumBytesLeft ) {
-    int   numBytes;
-    int   numRead;
+/* formats microseconds as milliseconds with two decimal places */
+static const char *mx_microsecondsToMillisecondString(
+    unsigned long  inMicroseconds ) {
 
-    int   idFieldSize;
-    char  originAtTop;
-    int   w;
-    int   h;
-    
-    int   neededSpriteBytes;
-    int   newSpriteHandle;
-    int   neededFileSpriteBytes;
+    int          hundredths  =  (int)( ( inMicroseconds / 10 ) % 100 );
+    const char  *pad         =  "";
+
+    if( hundredths < 10 ) {
+        pad = "0";
+        }
     
-    int   b;
-    int   startByte;
+    return maxigin_stringConcat5(
+        maxigin_intToString( (int)( inMicroseconds / 1000 ) ),
+        ".",
+        pad,
+        maxigin_intToString( hundredths ),
+        " ms" );
+    }
 
-    char  makingNewSprite     =  0;
 
-    
-    newSpriteHandle = inReloadHandle;
 
-    if( newSpriteHandle == -1 ) {
-        makingNewSprite = 1;
-        newSpriteHandle = mx_numSprites;
-        }
-    
+/* draws graph of recent frames, stacked by top-level zone, with a
+   legend of average zone times above it */
+static void mx_drawProfilerOverlay( void ) {
+
+    int            numFrames      =  mx_profileNumFramesDone;
+    int            graphLeft      =  4;
+    int            graphBottom    =  MAXIGIN_GAME_NATIVE_H - 4;
+    int            graphTop       =  graphBottom - MAXIGIN_PROFILER_GRAPH_H;
+    int            targetY;
+    int            i;
+    int            c;
+    char           oldAdditive    =  maxigin_drawGetAdditive();
+    unsigned long  colorTotals[ MAXIGIN_PROFILER_NUM_COLORS ];
+    unsigned long  frameTotal     =  0;
     
-    if( makingNewSprite
-        &&
-        mx_numSprites >= MAXIGIN_MAX_NUM_SPRITES ) {
+    if( numFrames > MAXIGIN_PROFILER_GRAPH_FRAMES ) {
+        numFrames = MAXIGIN_PROFILER_GRAPH_FRAMES;
+        }
 
-        if( inReloadHandle == -1 ) {
-            /* suppress error messages when reloading */
-            
-            maxigin_logInt( "Alreaded loaded maximum number of sprites: ",
-                            mx_numSprites );
-            maxigin_logString( "Failed to load sprite: ",
-                               inBulkResourceName );
-            }
-        return -1;
+    if( numFrames == 0 ) {
+        return;
         }
 
+    for( c = 0;
+         c < MAXIGIN_PROFILER_NUM_COLORS;
+         c ++ ) {
+        colorTotals[ c ] = 0;
+        }
     
-    numBytes       = inNumBytesLeft;
-    
+    maxigin_drawToggleAdditive( 0 );
 
-    if( numBytes < 18 ) {
-        if( inReloadHandle == -1 ) {
-            maxigin_logString( "Sprite file too small to contain TGA header: ",
-                               inBulkResourceName );
-            }
-        
-        return -1;
-        }
+    maxigin_drawSetColor( 0, 0, 0, 180 );
 
-    numRead = mx_readData( inReadHandle,
-                           18,
-                           mx_tgaReadBuffer );
+    maxigin_drawFillRect( graphLeft - 2,
+                          graphTop - 2,
+                          graphLeft + MAXIGIN_PROFILER_GRAPH_FRAMES * 2 + 1,
+                          graphBottom + 1 );
 
-    if( numRead != 18 ) {
-        if( inReloadHandle == -1 ) {
-            maxigin_logString( "Failed to read TGA header: ",
-                               inBulkResourceName );
-            }
+    for( i = 0;
+         i < numFrames;
+         i ++ ) {
+
+        MaxiginProfileFrame  *f  =
+            mx_getDoneProfileFrame( mx_profileNumFramesDone - numFrames + i );
         
-        return -1;
-        }
+        int                   x  =  graphLeft + i * 2;
+        int                   y  =  graphBottom;
+        int                   h;
+        int                   z;
+        unsigned long         duration  =  f->end - f->start;
 
-    if( mx_tgaReadBuffer[2]  != 2       /* image type code */
-        ||
-        mx_tgaReadBuffer[1]  != 0       /* color map type */
-        ||
-        ( mx_tgaReadBuffer[16] != 24
-          &&
-          mx_tgaReadBuffer[16] != 32 ) ) {  /* bits per pixel */
+        frameTotal += duration;
+        
+        /* whole frame in dark gray behind zones */
+        h = (int)( duration / MAXIGIN_PROFILER_US_PER_PIXEL );
 
-        if( inReloadHandle == -1 ) {
-            maxigin_logString(
-                "Only uncompressed unmapped 32-bit RGBA and 24-bit RGB "
-                "TGA files can be loaded: ",
-                inBulkResourceName );
+        if( h > MAXIGIN_PROFILER_GRAPH_H ) {
+            h = MAXIGIN_PROFILER_GRAPH_H;
             }
+
+        maxigin_drawSetColor( 90, 90, 90, 255 );
         
-        return -1;
-        }
+        maxigin_drawFillRect( x,
+                              graphBottom - h,
+                              x + 1,
+                              graphBottom );
 
-    idFieldSize = mx_tgaReadBuffer[ 0 ];
-    
-    w = mx_tgaReadBuffer[ 13 ] << 8
-        |
-        mx_tgaReadBuffer[ 12 ];
+        for( z = 0;
+             z < f->numZones;
+             z ++ ) {
 
-    h = mx_tgaReadBuffer[ 15 ] << 8
-        |
-        mx_tgaReadBuffer[ 14 ];
-    
+            MaxiginProfileZone  *zone  =  &( f->zones[ z ] );
+            unsigned long        zoneDuration;
+            
+            if( zone->depth != 0 ) {
+                continue;
+                }
 
-    /* image descriptor byte, with bit 5 indicating image vertical flip */
-    originAtTop = mx_tgaReadBuffer[ 17 ]
-                  &
-                  ( 1 << 5 );
+            zoneDuration = zone->end - zone->start;
 
-    
-    /* now read the id field and ignore it */
-    if( idFieldSize > 0 ) {
-        numRead = mx_readData( inReadHandle,
-                               idFieldSize,
-                               mx_tgaReadBuffer );
+            c = mx_getProfileColorIndex( zone->name );
 
-        if( numRead != idFieldSize ) {
-            if( inReloadHandle == -1 ) {
-                maxigin_logString( "Failed to read id field from TGA data: ",
-                                   inBulkResourceName );
+            colorTotals[ c ] += zoneDuration;
+            
+            h = (int)( zoneDuration / MAXIGIN_PROFILER_US_PER_PIXEL );
+
+            if( h == 0 ) {
+                continue;
                 }
-        
-            return -1;
+            
+            if( y - h < graphTop ) {
+                h = y - graphTop;
+                }
+
+            if( h <= 0 ) {
+                break;
+                }
+            
+            maxigin_drawSetColor( mx_profileColors[ c ][0],
+                                  mx_profileColors[ c ][1],
+                                  mx_profileColors[ c ][2],
+                                  255 );
+            
+            maxigin_drawFillRect( x,
+                                  y - h,
+                                  x + 1,
+                                  y - 1 );
+            y -= h;
             }
         }
 
-    /* now we're done reading the header
-       image data next */
+    /* line at 60 fps frame time */
+    targetY = graphBottom - 16667 / MAXIGIN_PROFILER_US_PER_PIXEL;
+
+    maxigin_drawSetColor( 255, 255, 255, 128 );
     
-    /* TGA pixels are in BGRA order */
+    maxigin_drawLine( graphLeft,
+                      targetY,
+                      graphLeft + MAXIGIN_PROFILER_GRAPH_FRAMES * 2 - 1,
+                      targetY );
 
-    neededSpriteBytes = w * h * 4;
+    
+    /* legend with average times, one line per color */
+    
+    maxigin_drawSetColor( 0, 0, 0, 180 );
 
-    if( mx_tgaReadBuffer[16] == 32 ) {
-        neededFileSpriteBytes = w * h * 4;
-        }
-    else {
-        neededFileSpriteBytes = w * h * 3;
-        }
+    maxigin_drawFillRect( graphLeft - 2,
+                          graphTop - 14 - mx_numProfileColorNames * 10,
+                          graphLeft + MAXIGIN_PROFILER_GRAPH_FRAMES * 2 + 1,
+                          graphTop - 3 );
+
+    maxigin_drawSetColor( 255, 255, 255, 255 );
+    
+    maxigin_drawLangTextString(
+        maxigin_stringConcat(
+            "frame  ",
+            mx_microsecondsToMillisecondString(
+                frameTotal / (unsigned long)numFrames ) ),
+        graphLeft + 8,
+        graphTop - 8 - mx_numProfileColorNames * 10,
+        MAXIGIN_LEFT );
+
+    for( c = 0;
+         c < mx_numProfileColorNames;
+         c ++ ) {
+
+        int  y  =  graphTop - 8 - ( mx_numProfileColorNames - 1 - c ) * 10;
         
-    if( numBytes - mx_getDataPosition( inReadHandle )
-        < neededFileSpriteBytes ) {
+        maxigin_drawSetColor( mx_profileColors[ c ][0],
+                              mx_profileColors[ c ][1],
+                              mx_profileColors[ c ][2],
+                              255 );
 
-        if( inReloadHandle == -1 ) {
-            maxigin_logString( "Full TGA pixel data truncated: ",
-                               inBulkResourceName );
-            }
+        maxigin_drawFillRect( graphLeft,
+                              y - 2,
+                              graphLeft + 4,
+                              y + 2 );
         
-        return -1;
+        maxigin_drawSetColor( 255, 255, 255, 255 );
+
+        maxigin_drawLangTextString(
+            maxigin_stringConcat3(
+                mx_profileColorNames[ c ],
+                "  ",
+                mx_microsecondsToMillisecondString(
+                    colorTotals[ c ] / (unsigned long)numFrames ) ),
+            graphLeft + 8,
+            y,
+            MAXIGIN_LEFT );
         }
+    
+    maxigin_drawResetColor();
+    
+    maxigin_drawToggleAdditive( oldAdditive );
+    }
 
+
+
+static char mx_writeTraceString( int          inStoreWriteHandle,
+                                 const char  *inString ) {
     
-    if( ! makingNewSprite
-        &&
-        mx_sprites[ newSpriteHandle ].startByte == -1 ) {
+    return mingin_writePersistData( inStoreWriteHandle,
+                                    maxigin_stringLength( inString ),
+                                    (unsigned char*)inString );
+    }
 
-        /* existing sprite data has been deleted before reload was called */
 
-        makingNewSprite = 1;
-        }
 
+/* writes one complete event, with times relative to inBaseTime */
+static char mx_writeTraceEvent( int             inStoreWriteHandle,
+                                const char     *inName,
+                                unsigned long   inBaseTime,
+                                unsigned long   inStart,
+                                unsigned long   inEnd,
+                                char            inFirst ) {
+
+    const char  *separator  =  ",\n";
+
+    if( inFirst ) {
+        separator = "\n";
+        }
     
-    if( ! makingNewSprite
+    return
+        mx_writeTraceString(
+            inStoreWriteHandle,
+            maxigin_stringConcat5( separator,
+                                   "{\"name\":\"",
+                                   inName,
+                                   "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,",
+                                   "\"ts\":" ) )
         &&
-        ( mx_sprites[ newSpriteHandle ].w != w
-          ||
-          mx_sprites[ newSpriteHandle ].h != h ) ) {
+        mx_writeTraceString(
+            inStoreWriteHandle,
+            maxigin_stringConcat4(
+                maxigin_intToString( (int)( inStart - inBaseTime ) ),
+                ",\"dur\":",
+                maxigin_intToString( (int)( inEnd - inStart ) ),
+                "}" ) );
+    }
 
-        /* mismatch with existing record, sprite changing size*/
 
-        int  oldNeededSpriteBytes  =  mx_sprites[ newSpriteHandle ].w *
-                                      mx_sprites[ newSpriteHandle ].h * 4;
 
-        if( neededSpriteBytes > oldNeededSpriteBytes ) {
-            /* reloaded sprite getting bigger */
-            if( neededSpriteBytes + mx_numSpriteBytesUsed - oldNeededSpriteBytes
-                >
-                MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
+/*
+  Writes recent frames as a Chrome trace-event file, which can be opened
+  in chrome://tracing or Perfetto.
+*/
+static void mx_exportProfileTrace( void ) {
 
-                maxigin_logString(
-                    "Not enough space in static memory to reload sprite that "
-                    "is increasing in size: ",
-                    inBulkResourceName );
-        
-                return -1;
-                }
-            }
+    const char     *storeName  =  "maxigin_profileTrace.json";
+    int             store;
+    int             i;
+    char            success;
+    unsigned long   baseTime;
 
+    if( mx_profileNumFramesDone == 0 ) {
+        return;
+        }
 
-        mx_removeSpriteData( newSpriteHandle );
-        
-        makingNewSprite = 1;
+    store = mingin_startWritePersistData( storeName );
+
+    if( store == -1 ) {
+        maxigin_logString( "Failed to open profile trace for writing: ",
+                           storeName );
+        return;
         }
 
+    baseTime = mx_getDoneProfileFrame( 0 )->start;
+    
+    success = mx_writeTraceString( store,
+                                   "{\"traceEvents\":[" );
     
+    for( i = 0;
+         i < mx_profileNumFramesDone
+             &&
+             success;
+         i ++ ) {
 
-    if( makingNewSprite
-        &&
-        neededSpriteBytes + mx_numSpriteBytesUsed
-        >
-        MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
+        MaxiginProfileFrame  *f  =  mx_getDoneProfileFrame( i );
+        int                   z;
 
-        maxigin_logString( "Not enough space in static memory to load sprite: ",
-                           inBulkResourceName );
+        success = mx_writeTraceEvent( store,
+                                      "frame",
+                                      baseTime,
+                                      f->start,
+                                      f->end,
+                                      ( i == 0 ) );
 
-        maxigin_logInt2( "",
-                         MAXIGIN_MAX_TOTAL_SPRITE_BYTES,
-                         " bytes total, ",
-                         mx_numSpriteBytesUsed,
-                         " bytes used" );
-        
-        return -1;
-        }
+        for( z = 0;
+             z < f->numZones
+                 &&
+                 success;
+             z ++ ) {
 
-    if( makingNewSprite ) {
-        
-        /* read into end of sprite bytes */
-        
-        numRead = mx_readData(
-                      inReadHandle,
-                      neededFileSpriteBytes,
-                      &( mx_spriteBytes[ mx_numSpriteBytesUsed ] ) );
-        }
-    else {
-        
-        /* read into region pointed to by existing sprite record */
-        
-        startByte = mx_sprites[ newSpriteHandle ].startByte;
-        
-        numRead = mx_readData(
-                      inReadHandle,
-                      neededFileSpriteBytes,
-                      &( mx_spriteBytes[ startByte ] ) );
+            success = mx_writeTraceEvent( store,
+                                          f->zones[ z ].name,
+                                          baseTime,
+                                          f->zones[ z ].start,
+                                          f->zones[ z ].end,
+                                          0 );
+            }
         }
 
-    
-    if( numRead != neededFileSpriteBytes ) {
-        maxigin_logString( "Failed to read full TGA pixel data: ",
-                           inBulkResourceName );
-        return -1;
+    if( success ) {
+        success = mx_writeTraceString( store,
+                                       "\n],\"displayTimeUnit\":\"ms\"}\n" );
         }
     
-    
-    mx_sprites[ newSpriteHandle ].w          =  w;
-    mx_sprites[ newSpriteHandle ].h          =  h;
-
-    if( makingNewSprite ) {
-        mx_sprites[ newSpriteHandle ].startByte  =  mx_numSpriteBytesUsed;
-        mx_numSpriteBytesUsed += neededSpriteBytes;
+    if( ! mingin_endWritePersistData( store ) ) {
+        success = 0;
         }
 
-    /* copy bulk resource name into struct */
-    b = 0;
-    while( inBulkResourceName[ b ] != '\0'
-           &&
-           b < MAXIGIN_SPRITE_MAX_BULK_NAME_LENGTH - 1 ) {
-        
-        mx_sprites[ newSpriteHandle ].bulkResourceName[ b ] =
-                                    inBulkResourceName[ b ];
-        b++;
+    if( success ) {
+        maxigin_logString( "Wrote recent frames to profile trace: ",
+                           storeName );
         }
-    mx_sprites[ newSpriteHandle ].bulkResourceName[ b ] = '\0';
+    else {
+        maxigin_logString( "Failed to write profile trace: ",
+                           storeName );
+        mingin_deletePersistData( storeName );
+        }
+    }
 
-    /* successfully loaded this sprite
-       change to data no longer pending */
-    mx_sprites[ newSpriteHandle ].pendingChange       = 0;
-    mx_sprites[ newSpriteHandle ].retryCount          = 0;
-    mx_sprites[ newSpriteHandle ].stepsUntilNextRetry = 0;
+#endif
 
-    mx_sprites[ newSpriteHandle ].stripParentHandle = -1;
-    mx_sprites[ newSpriteHandle ].stripIndex = -1;
-    
-    if( newSpriteHandle == mx_numSprites ) {
 
-        /* leave stripChildHandle alone if we're reloading an existing sprite */
-        
-        mx_sprites[ newSpriteHandle ].stripChildHandle  = -1;
 
-        /* leave old glow handle in place if this isn't a new sprite record */
-        
-        mx_sprites[ newSpriteHandle ].glowSpriteHandle   = -1;
+#define  MAXIGIN_SPRITE_MAX_BULK_NAME_LENGTH  64
 
-        mx_initEmptyShadows( newSpriteHandle );
+#define  MAXIGIN_SPRITE_HASH_LENGTH            4
 
-        mx_sprites[ newSpriteHandle ].kerningTableIndex  = -1;
 
-        mx_sprites[ newSpriteHandle ].colorMapHandle     = -1;
-        mx_sprites[ newSpriteHandle ].colorMapRow        = -1;
-        mx_sprites[ newSpriteHandle ].isColorMap         =  0;
+typedef struct MaxiginSprite {
         
-        mx_numSprites ++;
-        }
+        int            w;
+        int            h;
 
-    
-    startByte = mx_sprites[ newSpriteHandle ].startByte;
-    
+        /* how far visible pixels (alpha > 0) extend beyond left and
+           right of sprite center */
+        int            leftVisibleRadius;
+        int            rightVisibleRadius;
 
-    if( neededSpriteBytes == w * h * 4
-        &&
-        neededFileSpriteBytes == w * h * 3 ) {
-        
-        /* we want BRGA sprite data, but we read BRG data from the file */
+        /* how far visible pixels (alpha > 0) extend above and
+           below sprite center */
+        int            upperVisibleRadius;
+        int            lowerVisibleRadius;
         
-        /* do BRG -> BRGA conversion, with all A values set to 255 */
+        /*
+          Index for this sprite into font kerning table.
 
-        /* walk backward through file data, which is filled into our
-           first 3/4 of the sprite buffer, while we
-           also walk backward through our full sprite buffer,
-           copying pixels last-first
+          Only used for sprites that are font glyphs.
+          
+          -1 if it hasn't been computed.
         */
-        int fb  =  startByte + neededFileSpriteBytes - 1;
-        int sb  =  startByte + neededSpriteBytes     - 1;
+        int            kerningTableIndex;
 
-        while( fb > startByte
-               &&
-               sb > startByte ) {
+        
+        /* index into mx_spriteBytes */
+        int            startByte;
 
-            /* each iteration, we move fb back by only 3 bytes
-               we move sb back by 4 bytes */
+        /* 0 if pixels are stored as RGBA, or the number of palette colors
+           if each pixel is stored as a one-byte index into a palette
+           of RGBA colors, which is stored right after the pixels */
+        int            numPaletteColors;
 
-            /* fixed, fully-opaque alpha */
-            mx_spriteBytes[ sb -- ] =  255;
+        char           bulkResourceName[ MAXIGIN_SPRITE_MAX_BULK_NAME_LENGTH ];
 
-            /* copy g b r */
-            mx_spriteBytes[ sb -- ] = mx_spriteBytes[ fb -- ];
-            mx_spriteBytes[ sb -- ] = mx_spriteBytes[ fb -- ];
-            mx_spriteBytes[ sb -- ] = mx_spriteBytes[ fb -- ];
-            }
-        }
-    
+        char           pendingChange;
 
+        int            retryCount;
 
-    /* now do BGRA to RGBA conversion */
+        int            stepsUntilNextRetry;
 
-    
-    b = startByte;
+        /* -1 if this sprite has no glow sprite */
+        int            glowSpriteHandle;
+        int            glowRadius;
+        int            glowIterations;
+
+        /* -1 if this sprite has not had a color map applied */
+        int            colorMapHandle;
+        int            colorMapRow;
+        /* 1 if this sprite is itself a color map */
+        char           isColorMap;
 
-    while( b < startByte + neededSpriteBytes ) {
-        
-        unsigned char  blue  =  mx_spriteBytes[ b ];
         
-        /* swap red and blue bytes */
-        mx_spriteBytes[ b ] = mx_spriteBytes[ b + 2 ];
+        int            numShadows;
+        int            shadowSpriteHandle [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        int            shadowRadius       [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        int            shadowIterations   [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        unsigned char  shadowBottomAlpha  [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        unsigned char  shadowTopAlpha     [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        unsigned char  shadowBottomPercent[ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        unsigned char  shadowTopPercent   [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        int            shadowDarkness     [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        unsigned char  shadowGrayValue    [ MAXIGIN_MAX_NUM_DROP_SHADOWS ];
+        
 
-        mx_spriteBytes[ b + 2 ] = blue;
+        /* handle of full sprite strip that this is a sub-sprite of, or -1
+           if not part of a strip */
+        int            stripParentHandle;
+        int            stripIndex;
 
-        b += 4;
-        }
-    
-    if( ! originAtTop ) {
+        /* if this sprite is the parent of a strip of sprites, this
+           is the handle to the sprite strip, or -1 if not */
+        int            stripChildHandle;
+        
+        unsigned char  hash[ MAXIGIN_SPRITE_HASH_LENGTH ];
+        
+    } MaxiginSprite;
 
-        int  stopRow  =  h / 2;
-        int  r;
 
-        for( r = 0;
-             r < stopRow;
-             r ++ ) {
 
-            int  otherRow        =  ( h - 1 ) - r;
-            int  rStartByte      =  r        * w * 4;
-            int  otherStartByte  =  otherRow * w * 4;
-            int  rowBytes        =  w * 4;
+static  unsigned char  mx_spriteBytes  [ MAXIGIN_MAX_TOTAL_SPRITE_BYTES ];
+static  MaxiginSprite  mx_sprites      [ MAXIGIN_MAX_NUM_SPRITES        ];
 
-            for( b = 0;
-                 b < rowBytes;
-                 b ++ ) {
+static  int            mx_numSpriteBytesUsed  =  0;
+static  int            mx_numSprites          =  0;
 
-                unsigned char  temp  =  mx_spriteBytes[ rStartByte + b ];
 
-                mx_spriteBytes    [ rStartByte     + b ] =
-                    mx_spriteBytes[ otherStartByte + b ];
-                
-                mx_spriteBytes[ otherStartByte + b ] = temp;
-                }
-            }
-        }
 
+static void mx_dumpSpriteRGBA( int  inSpriteHandle ) {
+
+    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle ] );
+
+    if( s->numPaletteColors > 0 ) {
+        mingin_log( "Can't dump palette sprite as RGBA\n" );
+        return;
+        }
     
-    mx_recomputeSpriteAttributes( newSpriteHandle );
-     
-    
-    return newSpriteHandle;
+    mx_dumpRGBAPixels( &( mx_spriteBytes[ s->startByte ] ),
+                       s->w,
+                       s->h );
     }
 
 
 
-/* inReloadHandle is -1 if loading a new sprite */
-static int mx_reloadSprite( const char  *inBulkResourceName,
-                            int          inReloadHandle ) {
-    
-    int             numBytes;
-    int             spriteHandle;
-    MinginOpenData  openData;
-    
-    openData.readHandle = mingin_startReadBulkData( inBulkResourceName,
-                                                    & numBytes );
+typedef struct MaxiginClipRectangle {
 
-    if( openData.readHandle == -1 ) {
-        if( inReloadHandle == -1 ) {
-            maxigin_logString( "Failed to open sprite: ",
-                               inBulkResourceName );
-            }
-        return -1;
-        }
+        int  startX;
+        int  endX;
+        int  startY;
+        int  endY;
 
-    openData.isBulk = 1;
+    } MaxiginClipRectangle;
 
-    spriteHandle = mx_reloadSpriteFromOpenData( inBulkResourceName,
-                                                inReloadHandle,
-                                                & openData,
-                                                numBytes );
 
-    mingin_endReadBulkData( openData.readHandle );
-    
-    return spriteHandle;
-    }
 
+static  MaxiginClipRectangle  mx_clipStack
+                                  [ MAXIGIN_MAX_NUM_CLIPPING_RECTANGLES ];
 
+static  int                   mx_clipStackDepth  =  0;
 
-int maxigin_initSprite( const char  *inBulkResourceName ) {
 
-    if( ! mx_areWeInMaxiginGameInitFunction ) {
-        mingin_log( "Game tried to call maxigin_initSprite "
-                    "from outside of maxiginGame_init\n" );
-        return -1;
+
+void maxigin_drawPushClipRectangle( int  inStartX,
+                                    int  inEndX,
+                                    int  inStartY,
+                                    int  inEndY ) {
+    
+    MaxiginClipRectangle  curClip;
+
+    int                   nextStackPos;
+
+    if( mx_clipStackDepth > 0 ) {
+        curClip = mx_clipStack[ mx_clipStackDepth - 1 ];
+        }
+    else {
+        /* empty stack, cur is whole screen */
+        curClip.startX = 0;
+        curClip.endX   = MAXIGIN_GAME_NATIVE_W - 1;
+        curClip.startY = 0;
+        curClip.endY   = MAXIGIN_GAME_NATIVE_H - 1;
         }
 
-    if( mx_spriteCacheLoaded ) {
+    
+    /* handle -1 params for defaults, all the way to edge of screen */
+    if( inStartX == -1 ) {
+        inStartX = 0;
+        }
+    if( inEndX == -1 ) {
+        inEndX = MAXIGIN_GAME_NATIVE_W - 1;
+        }
+    if( inStartY == -1 ) {
+        inStartY = 0;
+        }
+    if( inEndY == -1 ) {
+        inEndY = MAXIGIN_GAME_NATIVE_H - 1;
+        }
 
-        if( mx_nextCachedSpriteHandle < mx_numSprites ) {
+    /* trim new clip by current
+       
+       since the first clip pushed is trimmed by screen, all
+       clips will also be trimmed by screen, since they are nested */
 
-            if( maxigin_stringsEqual(
-                    mx_sprites[ mx_nextCachedSpriteHandle ].bulkResourceName,
-                    inBulkResourceName ) ) {
-                int  thisHandle = mx_nextCachedSpriteHandle;
-                mx_nextCachedSpriteHandle ++;
-                return thisHandle;
-                }
-            }
-        maxigin_logString( "Mismatch in sprite cache for:  ",
-                           inBulkResourceName );
+    if( inStartX < curClip.startX ) {
+        inStartX = curClip.startX;
+        }
+    if( inEndX > curClip.endX ) {
+        inEndX = curClip.endX;
+        }
+    if( inStartY < curClip.startY ) {
+        inStartY = curClip.startY;
+        }
+    if( inEndY > curClip.endY ) {
+        inEndY = curClip.endY;
+        }
 
-        mx_spriteCacheBad = 1;
+    nextStackPos = mx_clipStackDepth;
+
+    if( nextStackPos >= MAXIGIN_MAX_NUM_CLIPPING_RECTANGLES ) {
+        maxigin_logInt2( "Trying to push clipping rectangle number ",
+                         nextStackPos + 1,
+                         ", but there's only room for ",
+                         MAXIGIN_MAX_NUM_CLIPPING_RECTANGLES,
+                         ", merging this rectangle with previous one." );
+        nextStackPos = MAXIGIN_MAX_NUM_CLIPPING_RECTANGLES - 1;
+        }
+    else {
+        mx_clipStackDepth ++;
         }
     
+    mx_clipStack[ nextStackPos ].startX = inStartX;
+    mx_clipStack[ nextStackPos ].endX = inEndX;
+    mx_clipStack[ nextStackPos ].startY = inStartY;
+    mx_clipStack[ nextStackPos ].endY = inEndY;  
+    }
+
+
 
-    return mx_reloadSprite( inBulkResourceName,
-                            -1 );
+void maxigin_drawPopClipRectangle( void ) {
+    mx_clipStackDepth --;
+
+    if( mx_clipStackDepth < 0 ) {
+        mx_clipStackDepth = 0;
+        }
     }
 
 
 
-char maxigin_loadTempSprite( const char      *inBulkResourceName,
-                             unsigned char  **outRGBABytePointer,
-                             int             *outWidth,
-                             int             *outHeight ) {
+void maxigin_drawClearClipRectangles( void ) {
+    mx_clipStackDepth = 0;
+    }
 
-    char  oldInitFlag  =  mx_areWeInMaxiginGameInitFunction;
-    
-    int   s;
 
-    /* force this to allow temp sprite loading outside of init function */
-    mx_areWeInMaxiginGameInitFunction = 1;
 
-    s = maxigin_initSprite( inBulkResourceName );
+#define  MAXIGIN_TGA_BUFFER_SIZE  256
 
-    mx_areWeInMaxiginGameInitFunction = oldInitFlag;
-    
+static  unsigned char  mx_tgaReadBuffer[ MAXIGIN_TGA_BUFFER_SIZE ];
 
-    if( s == -1 ) {
-        return 0;
-        }
 
-    *outRGBABytePointer = &( mx_spriteBytes[ mx_sprites[ s ].startByte ] );
 
-    *outWidth  = mx_sprites[ s ].w;
-    *outHeight = mx_sprites[ s ].h;
+#define  MAXIGIN_PADDED_INT_LENGTH  12
 
-    /* undo loading sprite
-       the bytes will still be valid until next time a sprite is
-       reloaded */
-    mx_numSpriteBytesUsed -= mx_sprites[ s ].w * mx_sprites[ s ].h  *  4;
-    mx_numSprites --;
+/* enough bytes for a LEB128 varint holding any 32-bit value */
+#define  MAXIGIN_MAX_VARINT_LENGTH  5
 
-    return 1;
-    }
 
+/*
+  Reads int and jumps ahead MAXIGIN_PADDED_INT_LENGTH total bytes, to skip
+  all padding.
 
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_readPaddedIntFromPeristentData( int   inStoreReadHandle,
+                                               int  *outInt );
 
-/* writes sprite pixel data to open handle as a TGA file */
-static void mx_writeSpriteToOpenData( int  inSpriteHandle,
-                                      int  inPersistentDataWriteHandle ) {
 
-    int            w;
-    int            h;
-    int            p;
-    int            b;
-    int            numPixels;
-    char           success;
-    unsigned char  tgaHeader[18];
-    
 
-    w = mx_sprites[ inSpriteHandle ].w;
-    h = mx_sprites[ inSpriteHandle ].h;
+/*
+  Writes a \0-terminated string representation of an int to data store,
+  and pads it with \0 characters afterwards to fill paddedIntLength total.
 
-    numPixels = w * h * 4;
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writePaddedIntToPerisistentData( int  inStoreWriteHandle,
+                                                int  inInt );
 
-    /* empty ID field */
-    tgaHeader[ 0 ] = 0;
-    /* no color map */
-    tgaHeader[ 1 ] = 0;
-    /* image type, unmapped RGBA */
-    tgaHeader[ 2 ] = 2;
-    /* empty color map spec */
-    tgaHeader[ 3 ] = 0;
-    tgaHeader[ 4 ] = 0;
-    tgaHeader[ 5 ] = 0;
-    tgaHeader[ 6 ] = 0;
-    tgaHeader[ 7 ] = 0;
-    /* x origin 2-byte int */
-    tgaHeader[ 8 ] = 0;
-    tgaHeader[ 9 ] = 0;
-    /* y origin 2-byte int */
-    tgaHeader[ 10 ] = 0;
-    tgaHeader[ 11 ] = 0;
-    /* width, lo-hi byte */
-    tgaHeader[ 12 ] = (unsigned char)( w & 0xFF );
-    tgaHeader[ 13 ] = (unsigned char)( w >> 8 );
-    /* height, lo-hi byte */
-    tgaHeader[ 14 ] = (unsigned char)( h & 0xFF );
-    tgaHeader[ 15 ] = (unsigned char)( h >> 8 );
-    /* bits per pixel, RGBA is 32 */
-    tgaHeader[ 16 ] = 32;
-    /* 8-bit attribute (for the A component)
-       and a 1 in the 5th position, since origin at upper left corner */
-    tgaHeader[ 17 ] = 8 | 1 << 5;
 
 
-    success = mingin_writePersistData( inPersistentDataWriteHandle,
-                                       18,
-                                       tgaHeader );
+/*
+  Same as maxigin_intToString, but uses inBuffer instead of a shared
+  static buffer, so it's safe to call from a worker thread.
 
-    if( ! success ) {
-        mingin_log( "Failed to write TGA header to persistent data store.\n" );
-        return;
-        }
+  inBuffer must have room for 20 characters.
 
-    /* perform RGBA to BGRA conversion as we write pixels to file */
+  Returns inBuffer, or a constant string.
+*/
+static const char *mx_intToStringInBuffer( int    inInt,
+                                           char  *inBuffer );
+
+
+
+/*
+  Copies bytes in blocks of 8, which compilers can turn into wide moves,
+  since we can't count on memcpy.
+*/
+static void mx_copyBytes( unsigned char        *outDest,
+                          const unsigned char  *inSource,
+                          int                   inNumBytes ) {
     
-    b = mx_sprites[ inSpriteHandle ].startByte;
+    int  i  =  0;
     
-    for( p = 0;
-         p < numPixels;
-         p ++ ) {
+    while( i < inNumBytes - 7 ) {
+        outDest[ i     ] = inSource[ i     ];
+        outDest[ i + 1 ] = inSource[ i + 1 ];
+        outDest[ i + 2 ] = inSource[ i + 2 ];
+        outDest[ i + 3 ] = inSource[ i + 3 ];
+        outDest[ i + 4 ] = inSource[ i + 4 ];
+        outDest[ i + 5 ] = inSource[ i + 5 ];
+        outDest[ i + 6 ] = inSource[ i + 6 ];
+        outDest[ i + 7 ] = inSource[ i + 7 ];
+        i += 8;
+        }
+    
+    while( i < inNumBytes ) {
+        outDest[i] = inSource[i];
+        i++;
+        }
+    }
 
-        unsigned char  bgra[4];
+
+
+typedef struct MaxiginLayer {
         
-        bgra[2] = mx_spriteBytes[ b ++ ];
-        bgra[1] = mx_spriteBytes[ b ++ ];
-        bgra[0] = mx_spriteBytes[ b ++ ];
-        bgra[3] = mx_spriteBytes[ b ++ ];
+        int   w;
+        int   h;
+        int   startByte;
+
+        /* where the layer was last captured in the native pixel buffer */
+        int   capturedX;
+        int   capturedY;
+
+        char  capturing;
+        char  valid;
+
+        /* set if some of the layer was off the edge of the pixel buffer
+           when captured, so it can only be drawn back where it was */
+        char  partial;
         
-        success = mingin_writePersistData(
-                      inPersistentDataWriteHandle,
-                      4,
-                      bgra );
-        if( ! success ) {
-            mingin_log(
-                "Failed to write TGA pixel data to persistent data store.\n" );
-            return;
-            }
-        }
-    }
+    } MaxiginLayer;
 
 
 
-static void mx_blurSprite( int  inSpriteHandle,
-                           int  inRadius,
-                           int  inIterations ) {
+static  unsigned char  mx_layerBytes  [ MAXIGIN_MAX_TOTAL_LAYER_BYTES ];
+static  MaxiginLayer   mx_layers      [ MAXIGIN_MAX_NUM_LAYERS        ];
 
-    int  w                 =  mx_sprites[ inSpriteHandle ].w;
-    int  h                 =  mx_sprites[ inSpriteHandle ].h;
-    int  startByte         =  mx_sprites[ inSpriteHandle ].startByte;
-    int  tempStartByte;
-    int  sourceStartByte;
-    int  destStartByte;
-    int  i;
-    int  b;
-    int  y;
-    int  x;
-    int  neededExtraBytes  =  w * h * 4;
+static  int            mx_numLayers            =  0;
+static  int            mx_numLayerBytesUsed    =  0;
+
+
+
+int maxigin_initLayer( int  inWide,
+                       int  inHigh ) {
+
+    int            numBytes;
+    MaxiginLayer  *l;
     
-    if( mx_numSpriteBytesUsed + neededExtraBytes >
-        MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call maxigin_initLayer "
+                    "from outside of maxiginGame_init\n" );
+        return -1;
+        }
 
-        mingin_log( "Not enough extra sprites bytes in sprite data buffer "
-                    "to perform mx_blurSprite.\n" );
-        return;
+    if( mx_numLayers >= MAXIGIN_MAX_NUM_LAYERS ) {
+        maxigin_logInt( "Already made maximum number of layers: ",
+                        mx_numLayers );
+        return -1;
         }
-    
-    tempStartByte = mx_numSpriteBytesUsed;
 
-    /* zero out temp... black transparent pixels */
-    for( b = 0;
-         b < neededExtraBytes;
-         b ++ ) {
-        mx_spriteBytes[ tempStartByte + b ] = 0;
+    numBytes = inWide * inHigh * 3;
+
+    if( inWide <= 0
+        ||
+        inHigh <= 0
+        ||
+        numBytes > MAXIGIN_MAX_TOTAL_LAYER_BYTES - mx_numLayerBytesUsed ) {
+
+        maxigin_logInt( "Not enough room in layer space for layer bytes: ",
+                        numBytes );
+        return -1;
         }
-    
 
-    /* start with main sprite as source, blank buffer as dest */
-    sourceStartByte = startByte;
-    destStartByte   = tempStartByte;
+    l = &( mx_layers[ mx_numLayers ] );
+
+    l->w          =  inWide;
+    l->h          =  inHigh;
+    l->startByte  =  mx_numLayerBytesUsed;
+    l->capturedX  =  0;
+    l->capturedY  =  0;
+    l->capturing  =  0;
+    l->valid      =  0;
+    l->partial    =  0;
+
+    mx_numLayerBytesUsed += numBytes;
     
-    for( i = 0;
-         i < inIterations;
-         i ++ ) {
+    mx_numLayers ++;
 
-        int  tempTempStartByte;
-        int  startY              =  inRadius;
-        int  endY                =  h - inRadius;
-        int  startX              =  inRadius;
-        int  endX                =  w - inRadius;
+    return mx_numLayers - 1;
+    }
 
-        /* ignore edge cases
-           start blur pushed into image far enough where
-           our blur radius never goes outside of image */
 
+
+/*
+  Trims a layer placed at inStartX,inStartY by the current clip
+  rectangle, or by the edges of the native pixel buffer if there is none.
+
+  Returns 0 if nothing of the layer is left.
+*/
+static char mx_trimLayerRect( MaxiginLayer  *inLayer,
+                              int            inStartX,
+                              int            inStartY,
+                              int           *outStartX,
+                              int           *outStartY,
+                              int           *outEndX,
+                              int           *outEndY ) {
+    
+    int  clipStartX  =  0;
+    int  clipEndX    =  MAXIGIN_GAME_NATIVE_W - 1;
+    int  clipStartY  =  0;
+    int  clipEndY    =  MAXIGIN_GAME_NATIVE_H - 1;
+
+    if( mx_clipStackDepth > 0 ) {
+        MaxiginClipRectangle  *clip  =
+            &( mx_clipStack[ mx_clipStackDepth - 1 ] );
         
-        for( y = startY;
-             y < endY;
-             y ++ ) {
+        clipStartX = clip->startX;
+        clipEndX   = clip->endX;
+        clipStartY = clip->startY;
+        clipEndY   = clip->endY;
+        }
 
-            long           boxAccume[3]  =  { 0, 0, 0 };
-            long           alphaSum      =  0;
-            int            py;
-            int            px;
-            int            pixelsInBox   =  0;
-            int            rowStart;
-            int            pix;
-            int            c;
-            unsigned char  alpha;
-            
-            /* first, fill box accume with entire box around first pixel
-               in row */
-            for( py = y - inRadius;
-                 py <= y + inRadius;
-                 py ++ ) {
+    *outStartX  =  inStartX;
+    *outStartY  =  inStartY;
+    *outEndX    =  inStartX + inLayer->w - 1;
+    *outEndY    =  inStartY + inLayer->h - 1;
 
-                int  boxRowStart  =  py * w * 4 + sourceStartByte;
-                
-                for( px = 0;
-                     px < inRadius + inRadius + 1;
-                     px ++ ) {
+    if( *outStartX < clipStartX ) {
+        *outStartX = clipStartX;
+        }
+    if( *outStartY < clipStartY ) {
+        *outStartY = clipStartY;
+        }
+    if( *outEndX > clipEndX ) {
+        *outEndX = clipEndX;
+        }
+    if( *outEndY > clipEndY ) {
+        *outEndY = clipEndY;
+        }
 
-                    pix   = boxRowStart + px * 4;
-                    c     = 0;
-                    alpha = mx_spriteBytes[ pix + 3 ];
+    if( *outStartX > *outEndX
+        ||
+        *outStartY > *outEndY ) {
+        return 0;
+        }
 
-                    /* pre-multiply by alpha to avoid
-                       halos of residual color coming from
-                       fully transparent areas */
-                    
-                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
-                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
-                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
-                    alphaSum         += alpha;
+    return 1;
+    }
 
-                    pixelsInBox ++;
-                    }
-                }
 
-            /* set blur value for first pixel in row */
 
-            rowStart = y * w * 4 + destStartByte;
-            pix      = rowStart + startX * 4;
-            c        = 0;
+static char mx_isImageRectBlack( int  inStartX,
+                                 int  inStartY,
+                                 int  inEndX,
+                                 int  inEndY ) {
+    int  y;
 
-            if( alphaSum == 0 ) {     
-                mx_spriteBytes[ pix++ ] = 0;
-                mx_spriteBytes[ pix++ ] = 0;
-                mx_spriteBytes[ pix++ ] = 0;
-                mx_spriteBytes[ pix++ ] = 0;
-                }
-            else { 
-                mx_spriteBytes[ pix++ ] =    
-                    (unsigned char)( boxAccume[ c++ ] / alphaSum );
-                mx_spriteBytes[ pix++ ] =
-                    (unsigned char)( boxAccume[ c++ ] / alphaSum );
-                mx_spriteBytes[ pix++ ] =
-                    (unsigned char)( boxAccume[ c++ ] / alphaSum );
-                mx_spriteBytes[ pix++ ] =
-                    (unsigned char)( alphaSum / pixelsInBox );
-                }
-            
-            /* now process remaining pixels in row */
-            for( x = startX + 1;
-                 x < endX;
-                 x ++ ) {
+    for( y = inStartY;
+         y <= inEndY;
+         y ++ ) {
 
-                /* subtract column to left that has fallen out of our
-                   moving box, add in column to right that has
-                   been added to our moving box */
-                for( py = y - inRadius;
-                     py <= y + inRadius;
-                     py ++ ) {
+        int  b     =  ( y * MAXIGIN_GAME_NATIVE_W + inStartX ) * 3;
+        int  endB  =  ( y * MAXIGIN_GAME_NATIVE_W + inEndX ) * 3 + 2;
 
-                    int  boxRowStart  =  py * w * 4 + sourceStartByte;
+        for( ;
+             b <= endB;
+             b ++ ) {
 
-                    pix   = boxRowStart + ( x - 1 - inRadius ) * 4;
-                    c     = 0;
-                    alpha = mx_spriteBytes[ pix + 3 ];
+            if( mx_gameImageBuffer[ b ] != 0 ) {
+                return 0;
+                }
+            }
+        }
 
-                    /* subtract pre-mulitiplied alpha left column */
-                    boxAccume[ c++ ] -= alpha * mx_spriteBytes[ pix++ ];
-                    boxAccume[ c++ ] -= alpha * mx_spriteBytes[ pix++ ];
-                    boxAccume[ c++ ] -= alpha * mx_spriteBytes[ pix++ ];
-                    alphaSum         -= alpha;
+    return 1;
+    }
 
-                    pix   = boxRowStart + ( x + inRadius ) * 4;
-                    c     = 0;
-                    alpha = mx_spriteBytes[ pix + 3 ];
-                    
-                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
-                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
-                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
-                    alphaSum         += alpha;
-                    }
 
-                /* now our accume contains sum of all pixels
-                   in box around our pixel */
-                pix = rowStart + x * 4;
-                c   = 0;
 
-                if( alphaSum == 0 ) {
-                    mx_spriteBytes[ pix++ ] = 0;
-                    mx_spriteBytes[ pix++ ] = 0;
-                    mx_spriteBytes[ pix++ ] = 0;
-                    mx_spriteBytes[ pix++ ] = 0;
-                    }
-                else {
-                    mx_spriteBytes[ pix++ ] =
-                        (unsigned char)( boxAccume[ c++ ] / alphaSum );
-                    mx_spriteBytes[ pix++ ] =
-                        (unsigned char)( boxAccume[ c++ ] / alphaSum );
-                    mx_spriteBytes[ pix++ ] =
-                        (unsigned char)( boxAccume[ c++ ] / alphaSum );
-                    mx_spriteBytes[ pix++ ] =
-                        (unsigned char)( alphaSum / pixelsInBox );
-                    }
-                }
-            
-            }
+/* skip bad handles and draw calls from outside of the draw function */
+static char mx_isDrawLayerOK( int          inLayerHandle,
+                              const char  *inFunctionName ) {
+    
+    if( ! mx_areWeInMaxiginGameDrawFunction ) {
+        maxigin_logString( "Game tried to call this function from outside "
+                           "of maxiginGame_getNativePixels: ",
+                           inFunctionName );
+        return 0;
+        }
 
-        /* for next iteration, swap source and dest
-           blur back the other way */
-        tempTempStartByte = sourceStartByte;
-        sourceStartByte = destStartByte;
-        destStartByte = tempTempStartByte;
+    if( inLayerHandle < 0
+        ||
+        inLayerHandle >= mx_numLayers ) {
+        return 0;
         }
 
-    /* we're done with iterations
-       where did our final image end up? */
+    return 1;
+    }
 
-    if( sourceStartByte == tempStartByte ) {
 
-        /* ended up in our temp buffer
-           copy result back in */
-        for( b = 0;
-             b < neededExtraBytes;
-             b ++ ) {
-            
-            mx_spriteBytes    [ startByte     + b ] =
-                mx_spriteBytes[ tempStartByte + b ];
-            }
-        }
-    /* else ended up in-place in our original sprite byte buffer */
-    /* don't need to do any copying */
-    }
 
+char maxigin_drawBeginLayer( int  inLayerHandle,
+                             int  inStartX,
+                             int  inStartY ) {
 
+    MaxiginLayer  *l;
+    int            startX;
+    int            startY;
+    int            endX;
+    int            endY;
 
-static void mx_regenerateGlowSprite( int  inMainSpriteHandle,
-                                     int  inBlurRadius,
-                                     int  inBlurIterations ) {
+    if( ! mx_isDrawLayerOK( inLayerHandle,
+                            "maxigin_drawBeginLayer" ) ) {
+        return 0;
+        }
 
-    MaxiginSprite  *mainSprite;
-    const char     *glowSpriteDataName;
-    char            skipPersistentData   =   0;
-    int             persistReadHandle    =  -1;
-    int             numBytes             =   0;
-    int             numRead;
-    int             b;
-    int             glowW;
-    int             glowH;
-    int             glowBorder;
+    l = &( mx_layers[ inLayerHandle ] );
     
-    char           readGlowFromFile;
-    unsigned char  hashBuffer[ MAXIGIN_SPRITE_HASH_LENGTH ];
+    l->capturing = 0;
+    
+    if( mx_clipStackDepth > 0 ) {
+        /* clipped drawing would leave holes in the layer */
+        return 0;
+        }
 
+    if( ! mx_trimLayerRect( l,
+                            inStartX,
+                            inStartY,
+                            &startX,
+                            &startY,
+                            &endX,
+                            &endY ) ) {
+        return 0;
+        }
 
-    mainSprite = &( mx_sprites[ inMainSpriteHandle ] );
+    if( ! mx_isImageRectBlack( startX,
+                               startY,
+                               endX,
+                               endY ) ) {
+        return 0;
+        }
 
+    l->capturing  =  1;
+    l->valid      =  0;
+    l->capturedX  =  inStartX;
+    l->capturedY  =  inStartY;
 
-    glowBorder = inBlurRadius * inBlurIterations * 2;
-    
-    glowW = mainSprite->w
-            +
-            2 * glowBorder;
-        
-    glowH = mainSprite->h
-            +
-            2 * glowBorder;
+    l->partial    =  ( startX != inStartX
+                       ||
+                       startY != inStartY
+                       ||
+                       endX != inStartX + l->w - 1
+                       ||
+                       endY != inStartY + l->h - 1 );
 
-    if( mainSprite->bulkResourceName[0] == '\0' ) {
-        /* empty source resource name, check if this is part of a strip */
+    return 1;
+    }
 
-        if( mainSprite->stripParentHandle == -1 ) {
-            /* no bulk resource name, and not a strip sprite
-               this might be an internally-generated sprite that has
-               no bulk data representation */
-            
-            glowSpriteDataName = "";
-            skipPersistentData = 1;
-            }
-        else {
-            glowSpriteDataName =
-                maxigin_stringConcat4(
-                    mx_sprites[ mainSprite->stripParentHandle ].bulkResourceName,
-                    "_strip_",
-                    maxigin_intToString( mainSprite->stripIndex ),
-                    ".glow" );
-            }
+
+
+void maxigin_drawEndLayer( int  inLayerHandle ) {
+
+    MaxiginLayer  *l;
+    int            startX;
+    int            startY;
+    int            endX;
+    int            endY;
+    int            y;
+    
+    if( ! mx_isDrawLayerOK( inLayerHandle,
+                            "maxigin_drawEndLayer" ) ) {
+        return;
         }
-    else {
-        glowSpriteDataName = maxigin_stringConcat( mainSprite->bulkResourceName,
-                                                   ".glow" );
+
+    l = &( mx_layers[ inLayerHandle ] );
+    
+    if( ! l->capturing ) {
+        return;
         }
 
-    readGlowFromFile = 0;
+    l->capturing = 0;
+    
+    if( mx_clipStackDepth > 0 ) {
+        mingin_log( "Clip rectangle left set during layer capture\n" );
+        return;
+        }
 
-    if( ! skipPersistentData ) {
-        persistReadHandle = mingin_startReadPersistData( glowSpriteDataName,
-                                                         & numBytes );
+    if( ! mx_trimLayerRect( l,
+                            l->capturedX,
+                            l->capturedY,
+                            &startX,
+                            &startY,
+                            &endX,
+                            &endY ) ) {
+        return;
         }
     
-    
-    if( persistReadHandle != -1 ) {
+    for( y = startY;
+         y <= endY;
+         y ++ ) {
 
-        if( numBytes > MAXIGIN_SPRITE_HASH_LENGTH ) {
+        mx_copyBytes(
+            &( mx_layerBytes[ l->startByte +
+                              ( ( y - l->capturedY ) * l->w
+                                + startX - l->capturedX ) * 3 ] ),
+            &( mx_gameImageBuffer[ ( y * MAXIGIN_GAME_NATIVE_W
+                                     + startX ) * 3 ] ),
+            ( endX - startX + 1 ) * 3 );
+        }
 
-            numRead = mingin_readPersistData( persistReadHandle,
-                                              MAXIGIN_SPRITE_HASH_LENGTH,
-                                              hashBuffer );
-            
-            if( numRead == MAXIGIN_SPRITE_HASH_LENGTH ) {
+    l->valid = 1;
+    }
 
-                char  hashMatch        =  1;
-                int   readRadius;
-                int   readIterations;
-                char  success          =  0;
-                int   headerLength;
-                
-                for( b = 0;
-                     b < MAXIGIN_SPRITE_HASH_LENGTH;
-                     b ++ ) {
-                    
-                    if( hashBuffer[ b ] !=
-                        mainSprite->hash[ b ] ) {
-                        
-                        hashMatch = 0;
-                        break;
-                        }
-                    }
 
-                if( hashMatch ) {
-                    success =
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readRadius );
-                    
-                    success = success
-                        &&
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readIterations );
 
-                    if( success
-                        &&
-                        ( readRadius != inBlurRadius
-                          ||
-                          readIterations != inBlurIterations ) ) {
-                        success = 0;
-                        }
-                    }
+char maxigin_drawLayer( int  inLayerHandle,
+                        int  inStartX,
+                        int  inStartY ) {
+    
+    MaxiginLayer  *l;
+    int            startX;
+    int            startY;
+    int            endX;
+    int            endY;
+    int            y;
 
-                headerLength = MAXIGIN_SPRITE_HASH_LENGTH
-                               +
-                               2 * MAXIGIN_PADDED_INT_LENGTH;
-                
-                if( success ) {
-                    if( mainSprite->glowSpriteHandle ==
-                        -1 ) {
+    if( ! mx_isDrawLayerOK( inLayerHandle,
+                            "maxigin_drawLayer" ) ) {
+        return 0;
+        }
 
-                        MinginOpenData  openData;
-                        
-                        /* load from glow file */
-                        openData.readHandle = persistReadHandle;
-                        openData.isBulk = 0;
+    l = &( mx_layers[ inLayerHandle ] );
+    
+    if( ! l->valid ) {
+        return 0;
+        }
 
-                        /* set a non-file-name (blank string )
-                           as inBulkResourceName
-                           since this glow sprite isn't actually in
-                           our bulk data store */
-                        mainSprite->glowSpriteHandle =
-                            mx_reloadSpriteFromOpenData(
-                                "",
-                                -1,
-                                & openData,
-                                /* TGA data comes right after hash bytes
-                                   and int parameters */
-                                numBytes - headerLength );
+    if( l->partial
+        &&
+        ( inStartX != l->capturedX
+          ||
+          inStartY != l->capturedY ) ) {
+        return 0;
+        }
 
-                        if( mainSprite->glowSpriteHandle !=
-                            -1 ) {
-                            /* successfully loaded from file */
-                            readGlowFromFile = 1;
+    if( ! mx_trimLayerRect( l,
+                            inStartX,
+                            inStartY,
+                            &startX,
+                            &startY,
+                            &endX,
+                            &endY ) ) {
+        /* completely clipped away, nothing to draw */
+        return 1;
+        }
 
-                            mainSprite->glowRadius = inBlurRadius;
-                            mainSprite->glowIterations = inBlurIterations;
-                            
-                            maxigin_logString( "Successfully read cached glow "
-                                               "sprite from perisistent data "
-                                               "store for ",
-                                               mainSprite->bulkResourceName );
-                            }
-                        }
-                    else {
-                        /* glow sprite with hash and parameter
-                           match already loaded */
+    if( ! mx_isImageRectBlack( startX,
+                               startY,
+                               endX,
+                               endY ) ) {
+        return 0;
+        }
 
-                        readGlowFromFile = 1;
-                        }
-                    }  
-                }
-            }
-        
-        mingin_endReadPersistData( persistReadHandle );
+    for( y = startY;
+         y <= endY;
+         y ++ ) {
+
+        mx_copyBytes(
+            &( mx_gameImageBuffer[ ( y * MAXIGIN_GAME_NATIVE_W
+                                     + startX ) * 3 ] ),
+            &( mx_layerBytes[ l->startByte +
+                              ( ( y - inStartY ) * l->w
+                                + startX - inStartX ) * 3 ] ),
+            ( endX - startX + 1 ) * 3 );
         }
 
-    if( ! readGlowFromFile ) {
+    return 1;
+    }
 
-        /* generate glow from scratch
-           cache it to file for future */
 
-        int  glowSpriteHandle;
-        int  neededGlowBytes;
-        int  glowCacheDataWriteHandle;
-        int  glowStartByte;
-        int  mainStartByte;
-        int  x;
-        int  y;
-        int  mainW;
-        int  mainH;
-        
-        glowSpriteHandle = mainSprite->glowSpriteHandle;
 
+/* layers drawn with old sprites are stale after a hot reload */
+static void mx_invalidateLayers( void ) {
+    int  i;
 
-        if( glowSpriteHandle != -1 ) {
-            mx_removeSpriteData( glowSpriteHandle );
-            }
-        else {
-            /* stick new glow sprite at end of sprite list */
-            glowSpriteHandle = mx_numSprites;
+    for( i = 0;
+         i < mx_numLayers;
+         i ++ ) {
+        
+        mx_layers[i].valid = 0;
+        }
+    }
 
-            if( mx_numSprites >= MAXIGIN_MAX_NUM_SPRITES ) {
 
-                maxigin_logString(
-                    "Already have too many sprites when trying "
-                    "to create glow sprite for: ",
-                    mainSprite->bulkResourceName );
-                return;
-                }
-            }
-
-        neededGlowBytes = glowW * glowH * 4;
 
-        if( mx_numSpriteBytesUsed + neededGlowBytes
-            >
-            MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
+/*
+  encapsulates both bulkReadHandle and persistentDataReadHandle
+  this allows us to cache generated sprites in our persistent data
+  and load them using the same code as fixed sprites loaded from bulk data
 
-            maxigin_logString(
-                "Already have too many sprite data bytes when trying "
-                "to create glow sprite for: ",
-                mainSprite->bulkResourceName );
-            
-            return;
-            }
+  bulk data can also be mapped into memory, in which case reads copy
+  straight out of the mapping
+*/
+typedef struct MinginOpenData {
 
-        
-        mainSprite->glowSpriteHandle = glowSpriteHandle;
-        mainSprite->glowRadius       = inBlurRadius;
-        mainSprite->glowIterations   = inBlurIterations;
+        int                   readHandle;
+        /* 0 if persistent data, 1 if bulk data */
+        char                  isBulk;
 
-        glowStartByte  =  mx_numSpriteBytesUsed;
-        
-        mainW          =  mainSprite->w;
-        mainH          =  mainSprite->h;
-        mainStartByte  =  mainSprite->startByte;
+        /* 0 if not mapped */
+        const unsigned char  *mappedData;
+        int                   mappedLength;
+        int                   mappedPos;
         
-        mx_sprites[ glowSpriteHandle ].w                  = glowW;
-        mx_sprites[ glowSpriteHandle ].h                  = glowH;
-        mx_sprites[ glowSpriteHandle ].startByte          = glowStartByte;
-        mx_sprites[ glowSpriteHandle ].glowSpriteHandle   = -1;
+    } MinginOpenData;
 
-        mx_initEmptyShadows( glowSpriteHandle );
 
-        mx_sprites[ glowSpriteHandle ].bulkResourceName[0] = '\0';
 
-        mx_sprites[ glowSpriteHandle ].stripParentHandle = -1;
-        mx_sprites[ glowSpriteHandle ].stripIndex = -1;
-        mx_sprites[ glowSpriteHandle ].stripChildHandle = -1;
+static int mx_readData( MinginOpenData  *inDataHandle,
+                        int              inNumBytesToRead,
+                        unsigned char   *inByteBuffer ) {
 
-        if( glowSpriteHandle == mx_numSprites ) {
-            /* adding a new sprite to end of list */
-            mx_numSprites ++;
-            }
+    if( inDataHandle->mappedData != 0 ) {
         
-        mx_numSpriteBytesUsed += neededGlowBytes;
+        int  numLeft  =  inDataHandle->mappedLength - inDataHandle->mappedPos;
 
+        if( inNumBytesToRead > numLeft ) {
+            inNumBytesToRead = numLeft;
+            }
 
-        /* generate glow sprite pixels */
+        mx_copyBytes( inByteBuffer,
+                      &( inDataHandle->mappedData[ inDataHandle->mappedPos ] ),
+                      inNumBytesToRead );
 
-        for( b = 0;
-             b < neededGlowBytes;
-             b ++ ) {
-            /* zero out glow sprite */
-            mx_spriteBytes[ b + glowStartByte ] = 0;
-            }
+        inDataHandle->mappedPos += inNumBytesToRead;
 
-        /* copy sprite into center of glow sprite, leaving border
-           of black transparent pixels */
+        return inNumBytesToRead;
+        }
+    else if( inDataHandle->isBulk ) {
+        return mingin_readBulkData( inDataHandle->readHandle,
+                                    inNumBytesToRead,
+                                    inByteBuffer );
+        }
+    else {
+        return mingin_readPersistData( inDataHandle->readHandle,
+                                       inNumBytesToRead,
+                                       inByteBuffer );
+        }
+    }
 
-        for( y = 0;
-             y < mainH;
-             y ++ ) {
 
-            int  mainRowStart  =  y * mainW * 4;
-            int  glowY         =  y + glowBorder;
-            int  glowRowStart  =  glowY * glowW * 4;
-            
-            for( x = 0;
-                 x < mainW;
-                 x ++ ) {
-                
-                int  pixStart      =  mainRowStart + x * 4 + mainStartByte;
-                int  glowX         =  x + glowBorder;
-                int  glowPixStart  =  glowRowStart + glowX * 4 + glowStartByte;
 
-                mx_spriteBytes    [ glowPixStart     ++ ] =
-                    mx_spriteBytes[ pixStart         ++ ];
-                
-                mx_spriteBytes    [ glowPixStart     ++ ] =
-                    mx_spriteBytes[ pixStart         ++ ];
-                
-                mx_spriteBytes    [ glowPixStart     ++ ] =
-                    mx_spriteBytes[ pixStart         ++ ];
-                
-                mx_spriteBytes    [ glowPixStart     ++ ] =
-                    mx_spriteBytes[ pixStart         ++ ];
-                }
-            }
+static int mx_getDataPosition( MinginOpenData  *inDataHandle ) {
+    if( inDataHandle->mappedData != 0 ) {
+        return inDataHandle->mappedPos;
+        }
+    else if( inDataHandle->isBulk ) {
+        return mingin_getBulkDataPosition( inDataHandle->readHandle );
+        }
+    else {
+        return mingin_getPersistDataPosition( inDataHandle->readHandle );
+        }
+    }
 
         
-        mx_blurSprite( glowSpriteHandle,
-                       inBlurRadius,
-                       inBlurIterations );
 
-        if( ! skipPersistentData ) {
-            glowCacheDataWriteHandle =
-                mingin_startWritePersistData( glowSpriteDataName );
+static int mx_getSpriteNumBytes( int  inSpriteHandle ) {
 
-            if( glowCacheDataWriteHandle == -1 ) {
-                maxigin_logString( "Failed to open persistent "
-                                   "data cache file for writing: ",
-                                   glowSpriteDataName );
-                return;
-                }
+    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle ] );
 
-        
-            mingin_writePersistData( glowCacheDataWriteHandle,
-                                     MAXIGIN_SPRITE_HASH_LENGTH,
-                                     mainSprite->hash );
+    if( s->numPaletteColors > 0 ) {
+        return s->w * s->h + s->numPaletteColors * 4;
+        }
+    
+    return s->w * s->h * 4;
+    }
 
-            /* next radius and iteration count as padded ints */
-        
-            mx_writePaddedIntToPerisistentData( glowCacheDataWriteHandle,
-                                                inBlurRadius );
-        
-            mx_writePaddedIntToPerisistentData( glowCacheDataWriteHandle,
-                                                inBlurIterations );
 
-        
-            mx_writeSpriteToOpenData( glowSpriteHandle,
-                                      glowCacheDataWriteHandle );
 
+/* index in mx_spriteBytes of a pixel's RGBA bytes, where inPixelIndex
+   is y * w + x */
+static int mx_getSpritePixelByte( MaxiginSprite  *inSprite,
+                                  int             inPixelIndex ) {
 
-            mingin_endWritePersistData( glowCacheDataWriteHandle );
-            }
+    if( inSprite->numPaletteColors > 0 ) {
+        
+        int  paletteStart  =  inSprite->startByte + inSprite->w * inSprite->h;
+        
+        return paletteStart
+            + mx_spriteBytes[ inSprite->startByte + inPixelIndex ] * 4;
         }
-    
+
+    return inSprite->startByte + inPixelIndex * 4;
     }
 
 
 
-void maxigin_initMakeGlowSprite( int  inSpriteHandle,
-                                 int  inBlurRadius,
-                                 int  inBlurIterations ) {
+/* shrinks a sprite's data down to its first inNumKeptBytes in the sprite
+   data store, and collapses subsequent sprite data back to fill the gap
+*/
+static void mx_collapseSpriteData( int  inSpriteHandle,
+                                   int  inNumKeptBytes ) {
 
-    if( ! mx_areWeInMaxiginGameInitFunction ) {
-        mingin_log( "Game tried to call maxigin_initMakeGlowSprite "
-                    "from outside of maxiginGame_init\n" );
-        return;
-        }
+    int  b;
+    int  s;
+    int  startByte       =  mx_sprites[ inSpriteHandle ].startByte;
+    int  numFreedBytes   =  mx_getSpriteNumBytes( inSpriteHandle )
+                            - inNumKeptBytes;
+    
+    /* collapse memory location of existing sprite,
+       moving all subsequent sprite data back */
 
-    if( inSpriteHandle < 0 ) {
-        return;
+    for( b = startByte + inNumKeptBytes;
+         b < mx_numSpriteBytesUsed - numFreedBytes;
+         b ++ ) {
+
+        mx_spriteBytes[ b ] = mx_spriteBytes[ b + numFreedBytes ];
         }
 
-    if( mx_spriteCacheLoaded ) {
-        /* skip generating glow sprite */
-        /* advance next sprite handle */
-        mx_nextCachedSpriteHandle ++;
-        return;
+    /* update all sprites that pointed into the now-moved sprite data */
+    for( s = 0;
+         s < mx_numSprites;
+         s ++ ) {
+            
+        if( mx_sprites[ s ].startByte
+            > 
+            startByte ) {
+
+            mx_sprites[ s ].startByte -= numFreedBytes;
+            }
         }
 
-    mx_regenerateGlowSprite( inSpriteHandle,
-                             inBlurRadius,
-                             inBlurIterations );
+    mx_numSpriteBytesUsed -= numFreedBytes;
     }
 
 
 
-static void mx_regenerateDropShadowSprite( int            inMainSpriteHandle,
-                                           int            inShadowIndex,
-                                           int            inBlurRadius,
-                                           int            inBlurIterations,
-                                           unsigned char  inBottomAlpha,
-                                           unsigned char  inTopAlpha,
-                                           unsigned char  inBottomPercent,
-                                           unsigned char  inTopPercent,
-                                           int            inDarkness,
-                                           unsigned char  inGrayValue ) {
+/* removes sprite data from sprite data store and collapses
+   subsequent sprite data back to fill the gap
+*/
+static void mx_removeSpriteData( int  inSpriteHandle ) {
 
-    MaxiginSprite  *mainSprite;
-    const char     *shadowSpriteDataName;
-    int             persistReadHandle;
-    int             numBytes;
-    int             numRead;
-    int             p;
-    int             b;
-    int             shadowW;
-    int             shadowH;
-    int             shadowBorder;
+    if( mx_sprites[ inSpriteHandle ].startByte == -1 ) {
+        /* data already removed */
+        return;
+        }
 
-    int             si                     =  inShadowIndex;
+    mx_collapseSpriteData( inSpriteHandle,
+                           0 );
     
-    char            readShadowFromFile;
-    unsigned char   hashBuffer[ MAXIGIN_SPRITE_HASH_LENGTH ];
+    /* stick -1 in for byte index of this sprite record, since
+       its data is gone */
+    mx_sprites[ inSpriteHandle ].startByte        = -1;
+    mx_sprites[ inSpriteHandle ].numPaletteColors =  0;
+    }
 
 
-    mainSprite = &( mx_sprites[ inMainSpriteHandle ] );
 
 
-    shadowBorder = inBlurRadius * inBlurIterations * 2;
+static void mx_recomputeSpriteAttributes( int  inSpriteHandle ) {
+
+    MaxiginSprite  *s            =  &( mx_sprites[ inSpriteHandle ] );
     
-    shadowW = mainSprite->w
-              +
-              2 * shadowBorder;
+    int             leftRadius      =  0;
+    int             rightRadius     =  0;
+    int             upperRadius     =  0;
+    int             lowerRadius     =  0;
+    int             w               =  s->w;
+    int             h               =  s->h;
+    int             xCenter         =  w / 2;
+    int             yCenter         =  h / 2;
+    int             y;
+    int             startByte       =  s->startByte;
+    int             numSpriteBytes  =  w * h * 4;
+    
+    /* find left/right visible extents */
+    
+    for( y = 0;
+         y < h;
+         y ++ ) {
+
+        int   curByte  =  startByte + y * w * 4;
+        int   x;
+        char  someVis  =  0;
         
-    shadowH = mainSprite->h
-              +
-              2 * shadowBorder;
+        
+        for( x = 0;
+             x < w;
+             x ++ ) {
 
-    if( mainSprite->bulkResourceName[0] == '\0' ) {
-        /* empty source resource name, check if this is part of a strip */
+            unsigned char  a  =  mx_spriteBytes[ curByte + 3 ];
 
-        if( mainSprite->stripParentHandle == -1 ) {
-            mingin_log( "Failed to make shadow sprite for non-strip sprite "
-                        "without bulk resource name.\n" );
-            return;
-            }
-
-        shadowSpriteDataName =
-            maxigin_stringConcat5(
-                mx_sprites[ mainSprite->stripParentHandle ].bulkResourceName,
-                "_strip_",
-                maxigin_intToString( mainSprite->stripIndex ),
-                ".shadow_",
-                maxigin_intToString( si ) );
-        }
-    else {
-        shadowSpriteDataName =
-            maxigin_stringConcat3( mainSprite->bulkResourceName,
-                                  ".shadow_",
-                                   maxigin_intToString( si ) );
-        }
-
-    readShadowFromFile = 0;
-    
-    persistReadHandle = mingin_startReadPersistData( shadowSpriteDataName,
-                                                     & numBytes );
-    
-    if( persistReadHandle != -1 ) {
-
-        if( numBytes > MAXIGIN_SPRITE_HASH_LENGTH ) {
+            if( a > 0 ) {
 
-            numRead = mingin_readPersistData( persistReadHandle,
-                                              MAXIGIN_SPRITE_HASH_LENGTH,
-                                              hashBuffer );
+                if( x - xCenter > rightRadius ) {
+                    rightRadius = x - xCenter;
+                    }
+                else if( xCenter - x > leftRadius ) {
+                    leftRadius = xCenter - x;
+                    }
+                someVis = 1;
+                }
             
-            if( numRead == MAXIGIN_SPRITE_HASH_LENGTH ) {
+            /* on to next pixel */
+            curByte += 4;
+            }
 
-                char  hashMatch        =  1;
-                int   readRadius;
-                int   readIterations;
-                int   readBottomAlpha;
-                int   readTopAlpha;
-                int   readBottomPercent;
-                int   readTopPercent;
-                int   readDarkness;
-                int   readGrayValue;
-                char  success          =  0;
-                int   headerLength;
-                
-                for( b = 0;
-                     b < MAXIGIN_SPRITE_HASH_LENGTH;
-                     b ++ ) {
-                    
-                    if( hashBuffer[ b ] !=
-                        mainSprite->hash[ b ] ) {
-                        
-                        hashMatch = 0;
-                        break;
-                        }
-                    }
+        if( someVis ) {
+            /* some pixels in this row are visible */  
+            if( y - yCenter > lowerRadius ) {
+                lowerRadius =  y - yCenter;
+                }
+            else if( yCenter - y > upperRadius ) {
+                upperRadius = yCenter - y;
+                }
+            }       
+        }
 
-                if( hashMatch ) {
-                    success =
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readRadius );
-                    
-                    success = success
-                        &&
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readIterations );
+    s->leftVisibleRadius  = leftRadius;
 
-                    success = success
-                        &&
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readBottomAlpha );
+    /* center position is actually off by 1 in favor of left radius */
+    s->rightVisibleRadius = rightRadius + 1;
 
-                    success = success
-                        &&
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readTopAlpha );
+    s->upperVisibleRadius = upperRadius;
+    s->lowerVisibleRadius = lowerRadius + 1;
+    
 
-                    success = success
-                        &&
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readBottomPercent );
+    /* hash bytes after origin flip and BGRA conversion */
 
-                    success = success
-                        &&
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readTopPercent );
+    maxigin_flexHash( numSpriteBytes,
+                      &( mx_spriteBytes[ startByte ] ),
+                      MAXIGIN_SPRITE_HASH_LENGTH,
+                      s->hash );
+    }
 
-                    success = success
-                        &&
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readDarkness );
-                    
-                    success = success
-                        &&
-                        mx_readPaddedIntFromPeristentData(
-                            persistReadHandle,
-                            & readGrayValue );
-                    
-                    if( success
-                        &&
-                        ( readRadius != inBlurRadius
-                          ||
-                          readIterations != inBlurIterations
-                          ||
-                          (unsigned char)readBottomAlpha != inBottomAlpha
-                          ||
-                          (unsigned char)readTopAlpha != inTopAlpha
-                          ||
-                          (unsigned char)readBottomPercent != inBottomPercent
-                          ||
-                          (unsigned char)readTopPercent != inTopPercent
-                          ||
-                          readDarkness != inDarkness
-                          ||
-                          (unsigned char)readGrayValue != inGrayValue ) ) {
-                        
-                        success = 0;
-                        }
-                    }
 
-                headerLength = MAXIGIN_SPRITE_HASH_LENGTH
-                               +
-                               5 * MAXIGIN_PADDED_INT_LENGTH;
-                
-                if( success ) {
-                    if( mainSprite->shadowSpriteHandle[ si ] ==
-                        -1 ) {
 
-                        MinginOpenData  openData;
-                        
-                        /* load from shadow file */
-                        openData.readHandle = persistReadHandle;
-                        openData.isBulk = 0;
+static void mx_initEmptyShadows( int  inSpriteHandle ) {
 
-                        /* set a non-file-name (blank string )
-                           as inBulkResourceName
-                           since this shadow sprite isn't actually in
-                           our bulk data store */
-                        mainSprite->shadowSpriteHandle[ si ] =
-                            mx_reloadSpriteFromOpenData(
-                                "",
-                                -1,
-                                & openData,
-                                /* TGA data comes right after hash bytes
-                                   and parameter ints */
-                                numBytes - headerLength );
+    int  i;
 
-                        if( mainSprite->shadowSpriteHandle[ si ] !=
-                            -1 ) {
-                            /* successfully loaded from file */
-                            readShadowFromFile = 1;
+    mx_sprites[ inSpriteHandle ].numShadows = 0;
 
-                            mainSprite->shadowRadius     [si] = inBlurRadius;
-                            mainSprite->shadowIterations [si] = inBlurIterations;
-                            mainSprite->shadowBottomAlpha[si] = inBottomAlpha;
-                            mainSprite->shadowTopAlpha   [si] = inTopAlpha;
-                            mainSprite->shadowBottomPercent
-                                                         [si] = inBottomPercent;
-                            mainSprite->shadowTopPercent [si] = inTopPercent;
-                            mainSprite->shadowDarkness   [si] = inDarkness;
-                            mainSprite->shadowGrayValue  [si] = inGrayValue;
-                            
-                            maxigin_logString( "Successfully read cached shadow "
-                                               "sprite from perisistent data "
-                                               "store for ",
-                                               mainSprite->bulkResourceName );
-                            }
-                        }
-                    else {
-                        /* shadow sprite with hash and parameter
-                           match already loaded */
+    for( i = 0;
+         i < MAXIGIN_MAX_NUM_DROP_SHADOWS;
+         i ++ ) {
 
-                        readShadowFromFile = 1;
-                        }
-                    }  
-                }
-            }
-        
-        mingin_endReadPersistData( persistReadHandle );
+        mx_sprites[ inSpriteHandle ].shadowSpriteHandle[ i ] = -1;
         }
+    
+    }
 
-    if( ! readShadowFromFile ) {
-
-        /* generate shadow from scratch
-           cache it to file for future */
 
-        int  shadowSpriteHandle;
-        int  numShadowPixels;
-        int  neededShadowBytes;
-        int  shadowCacheDataWriteHandle;
-        int  shadowStartByte;
-        int  mainStartByte;
-        int  x;
-        int  y;
-        int  mainW;
-        int  mainH;
 
-        int   opaqueFirstY;
-        int   opaqueLastY;
-        long  opaqueSpan;
-        long  alphaSpan         =  inBottomAlpha - inTopAlpha;
+static int mx_reloadSpriteFromOpenData( const char      *inBulkResourceName,
+                                        int              inReloadHandle,
+                                        MinginOpenData  *inReadHandle,
+                                        int              inNumBytesLeft ) {
+    int   numBytes;
+    int   numRead;
 
-        long  topOffsetPixels;
-        long  bottomOffsetPixels;
+    int   idFieldSize;
+    char  originAtTop;
+    int   w;
+    int   h;
+    
+    int   neededSpriteBytes;
+    int   newSpriteHandle;
+    int   neededFileSpriteBytes;
+    
+    int   b;
+    int   startByte;
 
-        
-        shadowSpriteHandle = mainSprite->shadowSpriteHandle[ si ];
+    char  makingNewSprite     =  0;
 
+    
+    newSpriteHandle = inReloadHandle;
 
-        if( shadowSpriteHandle != -1 ) {
-            mx_removeSpriteData( shadowSpriteHandle );
-            }
-        else {
-            /* stick new shadow sprite at end of sprite list */
-            shadowSpriteHandle = mx_numSprites;
-
-            if( mx_numSprites >= MAXIGIN_MAX_NUM_SPRITES ) {
+    if( newSpriteHandle == -1 ) {
+        makingNewSprite = 1;
+        newSpriteHandle = mx_numSprites;
+        }
+    
+    
+    if( makingNewSprite
+        &&
+        mx_numSprites >= MAXIGIN_MAX_NUM_SPRITES ) {
 
-                maxigin_logString(
-                    "Already have too many sprites when trying "
-                    "to create shadow sprite for: ",
-                    mainSprite->bulkResourceName );
-                return;
-                }
+        if( inReloadHandle == -1 ) {
+            /* suppress error messages when reloading */
+            
+            maxigin_logInt( "Alreaded loaded maximum number of sprites: ",
+                            mx_numSprites );
+            maxigin_logString( "Failed to load sprite: ",
+                               inBulkResourceName );
             }
+        return -1;
+        }
 
-        numShadowPixels   = shadowW * shadowH;
-        neededShadowBytes = numShadowPixels * 4;
-
-        if( mx_numSpriteBytesUsed + neededShadowBytes
-            >
-            MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
+    
+    numBytes       = inNumBytesLeft;
+    
 
-            maxigin_logString(
-                "Already have too many sprite data bytes when trying "
-                "to create shadow sprite for: ",
-                mainSprite->bulkResourceName );
-            
-            return;
+    if( numBytes < 18 ) {
+        if( inReloadHandle == -1 ) {
+            maxigin_logString( "Sprite file too small to contain TGA header: ",
+                               inBulkResourceName );
             }
-
-        
-        mainSprite->shadowSpriteHandle [si] = shadowSpriteHandle;
-        mainSprite->shadowRadius       [si] = inBlurRadius;
-        mainSprite->shadowIterations   [si] = inBlurIterations;
-        mainSprite->shadowBottomAlpha  [si] = inBottomAlpha;
-        mainSprite->shadowTopAlpha     [si] = inTopAlpha;
-        mainSprite->shadowBottomPercent[si] = inBottomPercent;
-        mainSprite->shadowTopPercent   [si] = inTopPercent;
-        mainSprite->shadowDarkness     [si] = inDarkness;
-        mainSprite->shadowGrayValue    [si] = inGrayValue;
-        
-        shadowStartByte  =  mx_numSpriteBytesUsed;
-        
-        mainW          =  mainSprite->w;
-        mainH          =  mainSprite->h;
-        mainStartByte  =  mainSprite->startByte;
         
-        mx_sprites[ shadowSpriteHandle ].w                   =  shadowW;
-        mx_sprites[ shadowSpriteHandle ].h                   =  shadowH;
-        mx_sprites[ shadowSpriteHandle ].startByte           =  shadowStartByte;
-        mx_sprites[ shadowSpriteHandle ].glowSpriteHandle    = -1;
-
-        mx_initEmptyShadows( shadowSpriteHandle );
+        return -1;
+        }
 
-        mx_sprites[ shadowSpriteHandle ].bulkResourceName[0] = '\0';
+    numRead = mx_readData( inReadHandle,
+                           18,
+                           mx_tgaReadBuffer );
 
-        mx_sprites[ shadowSpriteHandle ].stripParentHandle   = -1;
-        mx_sprites[ shadowSpriteHandle ].stripIndex          = -1;
-        mx_sprites[ shadowSpriteHandle ].stripChildHandle    = -1;
+    if( numRead != 18 ) {
+        if( inReloadHandle == -1 ) {
+            maxigin_logString( "Failed to read TGA header: ",
+                               inBulkResourceName );
+            }
         
-        mx_numSprites ++;
-        mx_numSpriteBytesUsed += neededShadowBytes;
-
+        return -1;
+        }
 
-        /* generate shadow sprite pixels */
+    if( mx_tgaReadBuffer[2]  != 2       /* image type code */
+        ||
+        mx_tgaReadBuffer[1]  != 0       /* color map type */
+        ||
+        ( mx_tgaReadBuffer[16] != 24
+          &&
+          mx_tgaReadBuffer[16] != 32 ) ) {  /* bits per pixel */
 
-        for( b = 0;
-             b < neededShadowBytes;
-             b ++ ) {
-            /* zero out shadow sprite */
-            mx_spriteBytes[ b + shadowStartByte ] = 0;
+        if( inReloadHandle == -1 ) {
+            maxigin_logString(
+                "Only uncompressed unmapped 32-bit RGBA and 24-bit RGB "
+                "TGA files can be loaded: ",
+                inBulkResourceName );
             }
+        
+        return -1;
+        }
 
-        /* copy sprite into center of shadow sprite, leaving border
-           of gray transparent pixels */
+    idFieldSize = mx_tgaReadBuffer[ 0 ];
+    
+    w = mx_tgaReadBuffer[ 13 ] << 8
+        |
+        mx_tgaReadBuffer[ 12 ];
 
-        for( y = 0;
-             y < mainH;
-             y ++ ) {
+    h = mx_tgaReadBuffer[ 15 ] << 8
+        |
+        mx_tgaReadBuffer[ 14 ];
+    
 
-            int  mainRowStart    =  y * mainW * 4;
-            int  shadowY         =  y + shadowBorder;
-            int  shadowRowStart  =  shadowY * shadowW * 4;
-            
-            for( x = 0;
-                 x < mainW;
-                 x ++ ) {
-                
-                int  pixStart        =  mainRowStart + x * 4 + mainStartByte;
-                int  shadowX         =  x + shadowBorder;
-                int  shadowPixStart  =  shadowRowStart + shadowX * 4
-                                        + shadowStartByte;
+    /* image descriptor byte, with bit 5 indicating image vertical flip */
+    originAtTop = mx_tgaReadBuffer[ 17 ]
+                  &
+                  ( 1 << 5 );
 
-                mx_spriteBytes    [ shadowPixStart     ++ ] =
-                    mx_spriteBytes[ pixStart           ++ ];
-                
-                mx_spriteBytes    [ shadowPixStart     ++ ] =
-                    mx_spriteBytes[ pixStart           ++ ];
-                
-                mx_spriteBytes    [ shadowPixStart     ++ ] =
-                    mx_spriteBytes[ pixStart           ++ ];
-                
-                mx_spriteBytes    [ shadowPixStart     ++ ] =
-                    mx_spriteBytes[ pixStart           ++ ];
+    
+    /* now read the id field and ignore it */
+    if( idFieldSize > 0 ) {
+        numRead = mx_readData( inReadHandle,
+                               idFieldSize,
+                               mx_tgaReadBuffer );
+
+        if( numRead != idFieldSize ) {
+            if( inReloadHandle == -1 ) {
+                maxigin_logString( "Failed to read id field from TGA data: ",
+                                   inBulkResourceName );
                 }
+        
+            return -1;
             }
+        }
 
+    /* now we're done reading the header
+       image data next */
+    
+    /* TGA pixels are in BGRA order */
 
-        /* now walk through pixels of copy, and make all pixels gray
-           ( leave alpha alone )
-           This makes a gray silhouette of the sprite */
-        b = shadowStartByte;
-
-        for( p = 0;
-             p < numShadowPixels;
-             p ++ ) {
+    neededSpriteBytes = w * h * 4;
 
-            mx_spriteBytes[ b ++ ] = inGrayValue;
-            mx_spriteBytes[ b ++ ] = inGrayValue;
-            mx_spriteBytes[ b ++ ] = inGrayValue;
+    if( mx_tgaReadBuffer[16] == 32 ) {
+        neededFileSpriteBytes = w * h * 4;
+        }
+    else {
+        neededFileSpriteBytes = w * h * 3;
+        }
+        
+    if( numBytes - mx_getDataPosition( inReadHandle )
+        < neededFileSpriteBytes ) {
 
-            /* leave alpha untouched */
-            b++;
+        if( inReloadHandle == -1 ) {
+            maxigin_logString( "Full TGA pixel data truncated: ",
+                               inBulkResourceName );
             }
         
-        mx_blurSprite( shadowSpriteHandle,
-                       inBlurRadius,
-                       inBlurIterations );
-
+        return -1;
+        }
 
-        
+    
+    if( ! makingNewSprite
+        &&
+        mx_sprites[ newSpriteHandle ].startByte == -1 ) {
 
+        /* existing sprite data has been deleted before reload was called */
 
-        /* now apply darkness parameter to alpha only
-           (this doesn't make the gray value darker ) */
-        b = shadowStartByte;
+        makingNewSprite = 1;
+        }
 
-        if( inDarkness > 0 ) {
-            
-            long  factor  =  inDarkness + 100;
-            
-            for( p = 0;
-                 p < numShadowPixels;
-                 p ++ ) {
+    
+    if( ! makingNewSprite
+        &&
+        ( mx_sprites[ newSpriteHandle ].w != w
+          ||
+          mx_sprites[ newSpriteHandle ].h != h
+          ||
+          mx_sprites[ newSpriteHandle ].numPaletteColors > 0 ) ) {
 
-                long  a;
-            
-                b += 3;
-                
-                a = mx_spriteBytes[ b ];
-                
-                if( a != 0 ) {
+        /* mismatch with existing record, sprite changing size,
+           or going from palette back to RGBA */
 
-                    a = ( a * factor ) /  100;
+        int  oldNeededSpriteBytes  =  mx_getSpriteNumBytes( newSpriteHandle );
 
-                    if( a > 255 ) {
-                        a = 255;
-                        }
-                    
-                    mx_spriteBytes[ b ] = (unsigned char)a;
-                    }
+        if( neededSpriteBytes > oldNeededSpriteBytes ) {
+            /* reloaded sprite getting bigger */
+            if( neededSpriteBytes + mx_numSpriteBytesUsed - oldNeededSpriteBytes
+                >
+                MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
 
-                b ++;
+                maxigin_logString(
+                    "Not enough space in static memory to reload sprite that "
+                    "is increasing in size: ",
+                    inBulkResourceName );
+        
+                return -1;
                 }
             }
-        else if( inDarkness < 0 ) {
 
-            long  factor  =  - inDarkness + 100;
-            
-            for( p = 0;
-                 p < numShadowPixels;
-                 p ++ ) {
 
-                long  a;
-            
-                b += 3;
-            
-                a = mx_spriteBytes[ b ];
+        mx_removeSpriteData( newSpriteHandle );
+        
+        makingNewSprite = 1;
+        }
 
-                a = ( a * 100 ) / factor;
+    
 
-                mx_spriteBytes[ b ] = (unsigned char)a;
+    if( makingNewSprite
+        &&
+        neededSpriteBytes + mx_numSpriteBytesUsed
+        >
+        MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
 
-                b ++;
-                }
-            }
+        maxigin_logString( "Not enough space in static memory to load sprite: ",
+                           inBulkResourceName );
 
+        maxigin_logInt2( "",
+                         MAXIGIN_MAX_TOTAL_SPRITE_BYTES,
+                         " bytes total, ",
+                         mx_numSpriteBytesUsed,
+                         " bytes used" );
+        
+        return -1;
+        }
 
+    if( makingNewSprite ) {
         
-        /* now apply bottom-to-top alpha ramp */
-        opaqueFirstY = shadowH;
-        opaqueLastY  = 0;
+        /* read into end of sprite bytes */
         
-        for( y = 0;
-             y < shadowH;
-             y ++ ) {
-
-            int  rowStart  =  y * shadowW * 4 + shadowStartByte;
-            
-            for( x = 0;
-                 x < shadowW;
-                 x ++ ) {
+        numRead = mx_readData(
+                      inReadHandle,
+                      neededFileSpriteBytes,
+                      &( mx_spriteBytes[ mx_numSpriteBytesUsed ] ) );
+        }
+    else {
+        
+        /* read into region pointed to by existing sprite record */
+        
+        startByte = mx_sprites[ newSpriteHandle ].startByte;
+        
+        numRead = mx_readData(
+                      inReadHandle,
+                      neededFileSpriteBytes,
+                      &( mx_spriteBytes[ startByte ] ) );
+        }
 
-                unsigned char  a  = mx_spriteBytes[ rowStart + x * 4 + 3 ];
+    
+    if( numRead != neededFileSpriteBytes ) {
+        maxigin_logString( "Failed to read full TGA pixel data: ",
+                           inBulkResourceName );
+        return -1;
+        }
+    
+    
+    mx_sprites[ newSpriteHandle ].w          =  w;
+    mx_sprites[ newSpriteHandle ].h          =  h;
 
-                if( a != 0 ) {
-                    if( y < opaqueFirstY ) {
-                        opaqueFirstY = y;
-                        }
-                    if( y > opaqueLastY ) {
-                        opaqueLastY = y;
-                        }
-                    }
-                }
-            }
+    if( makingNewSprite ) {
+        mx_sprites[ newSpriteHandle ].startByte  =  mx_numSpriteBytesUsed;
+        mx_numSpriteBytesUsed += neededSpriteBytes;
+        }
 
-        /* tweak these based on top/bottom percentages */
+    mx_sprites[ newSpriteHandle ].numPaletteColors = 0;
 
-        opaqueSpan = opaqueLastY - opaqueFirstY;
+    /* copy bulk resource name into struct */
+    b = 0;
+    while( inBulkResourceName[ b ] != '\0'
+           &&
+           b < MAXIGIN_SPRITE_MAX_BULK_NAME_LENGTH - 1 ) {
+        
+        mx_sprites[ newSpriteHandle ].bulkResourceName[ b ] =
+                                    inBulkResourceName[ b ];
+        b++;
+        }
+    mx_sprites[ newSpriteHandle ].bulkResourceName[ b ] = '\0';
 
-        topOffsetPixels    = ( inTopPercent    * opaqueSpan ) / 100;
-        bottomOffsetPixels = ( inBottomPercent * opaqueSpan ) / 100;
+    /* successfully loaded this sprite
+       change to data no longer pending */
+    mx_sprites[ newSpriteHandle ].pendingChange       = 0;
+    mx_sprites[ newSpriteHandle ].retryCount          = 0;
+    mx_sprites[ newSpriteHandle ].stepsUntilNextRetry = 0;
 
-        if( bottomOffsetPixels < topOffsetPixels ) {
-            bottomOffsetPixels = topOffsetPixels;
-            }
+    mx_sprites[ newSpriteHandle ].stripParentHandle = -1;
+    mx_sprites[ newSpriteHandle ].stripIndex = -1;
+    
+    if( newSpriteHandle == mx_numSprites ) {
 
-        if( bottomOffsetPixels == topOffsetPixels ) {
-            /* span of at least 1 to avoid divide by zero */
-            bottomOffsetPixels += 1;
-            }
+        /* leave stripChildHandle alone if we're reloading an existing sprite */
         
-        opaqueLastY  = (int)( opaqueFirstY + bottomOffsetPixels );
-        opaqueFirstY = (int)( opaqueFirstY + topOffsetPixels );
+        mx_sprites[ newSpriteHandle ].stripChildHandle  = -1;
 
-        opaqueSpan = opaqueLastY - opaqueFirstY;
-        
+        /* leave old glow handle in place if this isn't a new sprite record */
         
-        for( y = 0;
-             y < shadowH;
-             y ++ ) {
-
-            int  rowStart  =  y * shadowW * 4 + shadowStartByte;
+        mx_sprites[ newSpriteHandle ].glowSpriteHandle   = -1;
 
-            /* using longs here prevents overflow */
-            long rowAlpha;
+        mx_initEmptyShadows( newSpriteHandle );
 
+        mx_sprites[ newSpriteHandle ].kerningTableIndex  = -1;
 
-            if( y >= opaqueFirstY
-                &&
-                y <= opaqueLastY ) {
+        mx_sprites[ newSpriteHandle ].colorMapHandle     = -1;
+        mx_sprites[ newSpriteHandle ].colorMapRow        = -1;
+        mx_sprites[ newSpriteHandle ].isColorMap         =  0;
+        
+        mx_numSprites ++;
+        }
 
-                rowAlpha =  ( alphaSpan * ( y - opaqueFirstY ) )
-                              /
-                              opaqueSpan
-                              +
-                              inTopAlpha;
-                }
-            else if( y < opaqueFirstY ) {
-                rowAlpha = inTopAlpha;
-                }
-            else {
-                rowAlpha = inBottomAlpha;
-                }
-             
-            for( x = 0;
-                 x < shadowW;
-                 x ++ ) {
+    
+    startByte = mx_sprites[ newSpriteHandle ].startByte;
+    
 
-                int            rowI  =  rowStart + x * 4 + 3;
+    if( neededSpriteBytes == w * h * 4
+        &&
+        neededFileSpriteBytes == w * h * 3 ) {
+        
+        /* we want BRGA sprite data, but we read BRG data from the file */
+        
+        /* do BRG -> BRGA conversion, with all A values set to 255 */
 
-                unsigned char  a     =  mx_spriteBytes[ rowI ];
+        /* walk backward through file data, which is filled into our
+           first 3/4 of the sprite buffer, while we
+           also walk backward through our full sprite buffer,
+           copying pixels last-first
+        */
+        int fb  =  startByte + neededFileSpriteBytes - 1;
+        int sb  =  startByte + neededSpriteBytes     - 1;
 
-                if( a != 0 ) {
-                    
-                    mx_spriteBytes[ rowI ]  =
-                        (unsigned char) ( ( a * rowAlpha ) / 255 );
-                    }
-                }
-            }
+        while( fb > startByte
+               &&
+               sb > startByte ) {
 
-        
+            /* each iteration, we move fb back by only 3 bytes
+               we move sb back by 4 bytes */
 
-        shadowCacheDataWriteHandle =
-            mingin_startWritePersistData( shadowSpriteDataName );
+            /* fixed, fully-opaque alpha */
+            mx_spriteBytes[ sb -- ] =  255;
 
-        if( shadowCacheDataWriteHandle == -1 ) {
-            maxigin_logString( "Failed to open persistent "
-                               "data cache file for writing: ",
-                               shadowSpriteDataName );
-            return;
+            /* copy g b r */
+            mx_spriteBytes[ sb -- ] = mx_spriteBytes[ fb -- ];
+            mx_spriteBytes[ sb -- ] = mx_spriteBytes[ fb -- ];
+            mx_spriteBytes[ sb -- ] = mx_spriteBytes[ fb -- ];
             }
+        }
+    
 
-        
-        mingin_writePersistData( shadowCacheDataWriteHandle,
-                                 MAXIGIN_SPRITE_HASH_LENGTH,
-                                 mainSprite->hash );
-
-        /* next radius and iteration count as padded ints
-           also alpha parameters */
-        
-        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
-                                            inBlurRadius );
-        
-        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
-                                            inBlurIterations );
-        
-        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
-                                            inBottomAlpha );
-
-        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
-                                            inTopAlpha );
-        
-        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
-                                            inBottomPercent );
 
-        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
-                                            inTopPercent );
+    /* now do BGRA to RGBA conversion */
 
-        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
-                                            inDarkness );
+    
+    b = startByte;
 
-        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
-                                            inGrayValue );
+    while( b < startByte + neededSpriteBytes ) {
         
-        mx_writeSpriteToOpenData( shadowSpriteHandle,
-                                  shadowCacheDataWriteHandle );
+        unsigned char  blue  =  mx_spriteBytes[ b ];
+        
+        /* swap red and blue bytes */
+        mx_spriteBytes[ b ] = mx_spriteBytes[ b + 2 ];
 
+        mx_spriteBytes[ b + 2 ] = blue;
 
-        mingin_endWritePersistData( shadowCacheDataWriteHandle );
+        b += 4;
         }
     
-    }
+    if( ! originAtTop ) {
 
+        int  stopRow  =  h / 2;
+        int  r;
 
+        for( r = 0;
+             r < stopRow;
+             r ++ ) {
 
-void maxigin_initMakeDropShadowSprite( int            inSpriteHandle,
-                                       int            inBlurRadius,
-                                       int            inBlurIterations,
-                                       unsigned char  inBottomAlpha,
-                                       unsigned char  inTopAlpha,
-                                       unsigned char  inBottomPercent,
-                                       unsigned char  inTopPercent,
-                                       int            inDarkness,
-                                       unsigned char  inGrayValue ) {
+            int  otherRow        =  ( h - 1 ) - r;
+            int  rStartByte      =  r        * w * 4;
+            int  otherStartByte  =  otherRow * w * 4;
+            int  rowBytes        =  w * 4;
 
-    int  newShadowIndex;
-    
-    if( ! mx_areWeInMaxiginGameInitFunction ) {
-        mingin_log( "Game tried to call maxigin_initMakeDropShadowSprite "
-                    "from outside of maxiginGame_init\n" );
-        return;
-        }
+            for( b = 0;
+                 b < rowBytes;
+                 b ++ ) {
 
-    if( inSpriteHandle < 0 ) {
-        return;
-        }
+                unsigned char  temp  =  mx_spriteBytes[ rStartByte + b ];
 
-    if( mx_spriteCacheLoaded ) {
-        /* skip generating shadow sprite */
-        /* advance next sprite handle */
-        mx_nextCachedSpriteHandle ++;
-        return;
+                mx_spriteBytes    [ rStartByte     + b ] =
+                    mx_spriteBytes[ otherStartByte + b ];
+                
+                mx_spriteBytes[ otherStartByte + b ] = temp;
+                }
+            }
         }
 
-    newShadowIndex = mx_sprites[ inSpriteHandle ].numShadows;
-
-    if( newShadowIndex >= MAXIGIN_MAX_NUM_DROP_SHADOWS ) {
-        maxigin_logInt( "Game tried to call maxigin_initMakeDropShadowSprite "
-                        "on a sprite that already has too many drop shadows: ",
-                        newShadowIndex );
-        return;
-        }
     
-    mx_regenerateDropShadowSprite( inSpriteHandle,
-                                   newShadowIndex,
-                                   inBlurRadius,
-                                   inBlurIterations,
-                                   inBottomAlpha,
-                                   inTopAlpha,
-                                   inBottomPercent,
-                                   inTopPercent,
-                                   inDarkness,
-                                   inGrayValue );
-
-    if( mx_sprites[ inSpriteHandle ].shadowSpriteHandle[ newShadowIndex ]
-        != -1 ) {
-        /* success */
-        mx_sprites[ inSpriteHandle ].numShadows ++;
-        }
+    mx_recomputeSpriteAttributes( newSpriteHandle );
+     
+    
+    return newSpriteHandle;
     }
 
 
 
-static void mx_mapPixel( unsigned char  *inPixelPointer,
-                         unsigned char  *inColorMapStart,
-                         int             inColorMapW,
-                         int             inColorMapDestRow ) {
-
-    int  destCol  =  -1;
-    int  c;
-    int  cb;
+/* inReloadHandle is -1 if loading a new sprite */
+static int mx_reloadSprite( const char  *inBulkResourceName,
+                            int          inReloadHandle ) {
     
-    for( c = 0;
-         c < inColorMapW;
-         c ++ ) {
+    int             numBytes;
+    int             spriteHandle;
+    MinginOpenData  openData;
 
-        cb = c * 4;
+    openData.isBulk     = 1;
+    openData.readHandle = -1;
+    openData.mappedPos  = 0;
+    
+    /* map TGA data if we can, so we can copy pixels straight out of it
+       without going through mingin_readBulkData */
+    openData.mappedData = mingin_startMapBulkData( inBulkResourceName,
+                                                   & numBytes );
 
-        if( inPixelPointer[0] == inColorMapStart[ cb     ]
-            &&
-            inPixelPointer[1] == inColorMapStart[ cb + 1 ]
-            &&
-            inPixelPointer[2] == inColorMapStart[ cb + 2 ] ) {
+    if( openData.mappedData != 0 ) {
+        openData.mappedLength = numBytes;
+        }
+    else {
+        openData.readHandle = mingin_startReadBulkData( inBulkResourceName,
+                                                        & numBytes );
 
-            /* hit! */
-            destCol = c;
-            break;
+        if( openData.readHandle == -1 ) {
+            if( inReloadHandle == -1 ) {
+                maxigin_logString( "Failed to open sprite: ",
+                                   inBulkResourceName );
+                }
+            return -1;
             }
         }
+    
+    spriteHandle = mx_reloadSpriteFromOpenData( inBulkResourceName,
+                                                inReloadHandle,
+                                                & openData,
+                                                numBytes );
 
-    if( destCol == -1 ) {
-        /* color not found in source row, leave it alone */
-        return;
+    if( openData.mappedData != 0 ) {
+        mingin_endMapBulkData( openData.mappedData,
+                               openData.mappedLength );
+        }
+    else {
+        mingin_endReadBulkData( openData.readHandle );
         }
+    
+    return spriteHandle;
+    }
 
-    cb = inColorMapDestRow * inColorMapW * 4 + destCol * 4;
 
-    inPixelPointer[0] = inColorMapStart[ cb     ];
-    inPixelPointer[1] = inColorMapStart[ cb + 1 ];
-    inPixelPointer[2] = inColorMapStart[ cb + 2 ];
-    }
 
+int maxigin_initSprite( const char  *inBulkResourceName ) {
 
+    int  handle;
+    
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call maxigin_initSprite "
+                    "from outside of maxiginGame_init\n" );
+        return -1;
+        }
 
-void maxigin_applyColorMap( int  inSpriteHandle,
-                            int  inColorMapHandle,
-                            int  inColorMapRow ) {
+    if( mx_spriteCacheLoaded ) {
 
-    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle   ] );
-    MaxiginSprite  *c  =  &( mx_sprites[ inColorMapHandle ] );
+        if( mx_nextCachedSpriteHandle < mx_numSprites ) {
 
-    int             n  =  s->w * s->h;
-    int             i;
-    unsigned char  *spriteBytes    =  &( mx_spriteBytes[ s->startByte ] );
-    unsigned char  *colorMapBytes  =  &( mx_spriteBytes[ c->startByte ] );
-    
-    for( i = 0;
-         i < n;
-         i ++ ) {
+            if( maxigin_stringsEqual(
+                    mx_sprites[ mx_nextCachedSpriteHandle ].bulkResourceName,
+                    inBulkResourceName ) ) {
+                int  thisHandle = mx_nextCachedSpriteHandle;
+                mx_nextCachedSpriteHandle ++;
+                return thisHandle;
+                }
+            }
+        maxigin_logString( "Mismatch in sprite cache for:  ",
+                           inBulkResourceName );
 
-        mx_mapPixel( &( spriteBytes[ i * 4 ] ),
-                     colorMapBytes,
-                     c->w,
-                     inColorMapRow );
+        mx_spriteCacheBad = 1;
         }
-
-    s->colorMapHandle = inColorMapHandle;
-    s->colorMapRow    = inColorMapRow;
     
-    c->isColorMap     = 1;
+    mx_startProfilePhase( "loadSprites" );
+    
+    handle = mx_reloadSprite( inBulkResourceName,
+                              -1 );
+    
+    mx_endProfilePhase();
+
+    return handle;
     }
 
 
 
-#define  MAXIGIN_NUM_STATIC_SLIDER_BARS  10
+char maxigin_loadTempSprite( const char      *inBulkResourceName,
+                             unsigned char  **outRGBABytePointer,
+                             int             *outWidth,
+                             int             *outHeight ) {
 
-typedef struct MaxiginSliderSprites {
+    char  oldInitFlag  =  mx_areWeInMaxiginGameInitFunction;
+    
+    int   s;
 
-        /* index 0 for empty, 1 for full */
-        int  left  [2];
-        int  right [2];
-        int  bar   [2];
-        int  sliver[2];
+    /* force this to allow temp sprite loading outside of init function */
+    mx_areWeInMaxiginGameInitFunction = 1;
 
-        int  numFullBars;
-        int  fullBars[ MAXIGIN_NUM_STATIC_SLIDER_BARS ];
-        
-        /* index 0 for cold, 1 for hot, 2 for active */
-        int  thumb [3];
+    s = maxigin_initSprite( inBulkResourceName );
 
-        int  loop  [2];
-        
-    } MaxiginSliderSprites;
+    mx_areWeInMaxiginGameInitFunction = oldInitFlag;
+    
 
+    if( s == -1 ) {
+        return 0;
+        }
 
-char                   mx_sliderSpritesSet  =  0;
-MaxiginSliderSprites   mx_sliderSprites;
+    *outRGBABytePointer = &( mx_spriteBytes[ mx_sprites[ s ].startByte ] );
 
+    *outWidth  = mx_sprites[ s ].w;
+    *outHeight = mx_sprites[ s ].h;
 
-static void mx_clearSliderSprites( void ) {
-    int  i;
+    /* undo loading sprite
+       the bytes will still be valid until next time a sprite is
+       reloaded */
+    mx_numSpriteBytesUsed -= mx_sprites[ s ].w * mx_sprites[ s ].h  *  4;
+    mx_numSprites --;
 
-    mx_sliderSprites.numFullBars = 0;
-    
-    for( i = 0;
-         i < 2;
-         i ++ ) {
-        mx_sliderSprites.left  [i] = -1;
-        mx_sliderSprites.right [i] = -1;
-        mx_sliderSprites.bar   [i] = -1;
-        mx_sliderSprites.sliver[i] = -1;
-        mx_sliderSprites.loop  [i] = -1;
-        }
-    
-    for( i = 0;
-         i < 3;
-         i ++ ) {
-        mx_sliderSprites.thumb[i] = -1;
-        }
+    return 1;
     }
 
 
 
-void maxigin_initSliderSprites( const char  *inLeftEndEmptySpriteResource,
-                                const char  *inLeftEndFullSpriteResource,
-                                const char  *inRightEndEmptySpriteResource,
-                                const char  *inRightEndFullSpriteResource,
-                                const char  *inMiddleBarEmptySpriteResource,
-                                const char  *inMiddleBarFullSpriteResource,
-                                const char  *inMiddleSliverEmptySpriteResource,
-                                const char  *inMiddleSliverFullSpriteResource,
-                                const char  *inThumbSpriteResource,
-                                const char  *inThumbHotSpriteResource,
-                                const char  *inThumbActiveSpriteResource,
-                                const char  *inLoopStartSpriteResource,
-                                const char  *inLoopEndSpriteResource ) {
+/* writes sprite pixel data to open handle as a TGA file */
+static void mx_writeSpriteToOpenData( int  inSpriteHandle,
+                                      int  inPersistentDataWriteHandle ) {
 
-    mx_clearSliderSprites();
-    
-    mx_sliderSprites.left[ 0 ] =
-        maxigin_initSprite( inLeftEndEmptySpriteResource );
+    int            w;
+    int            h;
+    int            p;
+    int            b;
+    int            numPixels;
+    char           success;
+    unsigned char  tgaHeader[18];
     
-    mx_sliderSprites.left[ 1 ] =
-        maxigin_initSprite( inLeftEndFullSpriteResource );
 
+    w = mx_sprites[ inSpriteHandle ].w;
+    h = mx_sprites[ inSpriteHandle ].h;
 
-    mx_sliderSprites.right[ 0 ] =
-        maxigin_initSprite( inRightEndEmptySpriteResource );
-
-    mx_sliderSprites.right[ 1 ] =
-        maxigin_initSprite( inRightEndFullSpriteResource );
+    numPixels = w * h * 4;
 
-    
-    mx_sliderSprites.bar[ 0 ] =
-        maxigin_initSprite( inMiddleBarEmptySpriteResource );
-
-    mx_sliderSprites.bar[ 1 ] =
-        maxigin_initSprite( inMiddleBarFullSpriteResource );
-
-
-    mx_sliderSprites.sliver[ 0 ] =
-        maxigin_initSprite( inMiddleSliverEmptySpriteResource );
-
-    mx_sliderSprites.sliver[ 1 ] =
-        maxigin_initSprite( inMiddleSliverFullSpriteResource );
-
-
-    mx_sliderSprites.thumb[ 0 ] =
-        maxigin_initSprite( inThumbSpriteResource );
+    /* empty ID field */
+    tgaHeader[ 0 ] = 0;
+    /* no color map */
+    tgaHeader[ 1 ] = 0;
+    /* image type, unmapped RGBA */
+    tgaHeader[ 2 ] = 2;
+    /* empty color map spec */
+    tgaHeader[ 3 ] = 0;
+    tgaHeader[ 4 ] = 0;
+    tgaHeader[ 5 ] = 0;
+    tgaHeader[ 6 ] = 0;
+    tgaHeader[ 7 ] = 0;
+    /* x origin 2-byte int */
+    tgaHeader[ 8 ] = 0;
+    tgaHeader[ 9 ] = 0;
+    /* y origin 2-byte int */
+    tgaHeader[ 10 ] = 0;
+    tgaHeader[ 11 ] = 0;
+    /* width, lo-hi byte */
+    tgaHeader[ 12 ] = (unsigned char)( w & 0xFF );
+    tgaHeader[ 13 ] = (unsigned char)( w >> 8 );
+    /* height, lo-hi byte */
+    tgaHeader[ 14 ] = (unsigned char)( h & 0xFF );
+    tgaHeader[ 15 ] = (unsigned char)( h >> 8 );
+    /* bits per pixel, RGBA is 32 */
+    tgaHeader[ 16 ] = 32;
+    /* 8-bit attribute (for the A component)
+       and a 1 in the 5th position, since origin at upper left corner */
+    tgaHeader[ 17 ] = 8 | 1 << 5;
 
-    mx_sliderSprites.thumb[ 1 ] =
-        maxigin_initSprite( inThumbHotSpriteResource );
 
-    mx_sliderSprites.thumb[ 2 ] =
-        maxigin_initSprite( inThumbActiveSpriteResource );
+    success = mingin_writePersistData( inPersistentDataWriteHandle,
+                                       18,
+                                       tgaHeader );
 
-    mx_sliderSprites.loop[ 0 ] =
-        maxigin_initSprite( inLoopStartSpriteResource );
+    if( ! success ) {
+        mingin_log( "Failed to write TGA header to persistent data store.\n" );
+        return;
+        }
 
-    mx_sliderSprites.loop[ 1 ] =
-        maxigin_initSprite( inLoopEndSpriteResource );
+    /* perform RGBA to BGRA conversion as we write pixels to file */
+    
+    b = mx_sprites[ inSpriteHandle ].startByte;
     
+    for( p = 0;
+         p < numPixels;
+         p ++ ) {
 
-    mx_sliderSpritesSet =
-        ( mx_sliderSprites.left[ 0 ]   >= 0 )
-        &&
-        ( mx_sliderSprites.left[ 1 ]   >= 0 )
-        &&
-        ( mx_sliderSprites.right[ 0 ]  >= 0 )
-        &&
-        ( mx_sliderSprites.right[ 1 ]  >= 0 )
-        &&
-        ( mx_sliderSprites.bar[ 0 ]    >= 0 )
-        &&
-        ( mx_sliderSprites.bar[ 1 ]    >= 0 )
-        &&
-        ( mx_sliderSprites.sliver[ 0 ] >= 0 )
-        &&
-        ( mx_sliderSprites.sliver[ 1 ] >= 0 )
-        &&
-        ( mx_sliderSprites.thumb[ 0 ]  >= 0 )
-        &&
-        ( mx_sliderSprites.thumb[ 1 ]  >= 0 )
-        &&
-        ( mx_sliderSprites.thumb[ 2 ]  >= 0 )
-        &&
-        ( mx_sliderSprites.loop[ 0 ]   >= 0 )
-        &&
-        ( mx_sliderSprites.loop[ 1 ]   >= 0 );
+        unsigned char  bgra[4];
+        
+        bgra[2] = mx_spriteBytes[ b ++ ];
+        bgra[1] = mx_spriteBytes[ b ++ ];
+        bgra[0] = mx_spriteBytes[ b ++ ];
+        bgra[3] = mx_spriteBytes[ b ++ ];
+        
+        success = mingin_writePersistData(
+                      inPersistentDataWriteHandle,
+                      4,
+                      bgra );
+        if( ! success ) {
+            mingin_log(
+                "Failed to write TGA pixel data to persistent data store.\n" );
+            return;
+            }
+        }
     }
 
 
-void maxigin_initSliderSpritesStatic(
-    int           inNumBarSprites,
-    const char  **inBarSprites,
-    const char   *inThumbSpriteResource,
-    const char   *inThumbHotSpriteResource,
-    const char   *inThumbActiveSpriteResource,
-    const char   *inLoopStartSpriteResource,
-    const char   *inLoopEndSpriteResource ) {
 
-    int   i;
-    char  success;
+static void mx_blurSprite( int  inSpriteHandle,
+                           int  inRadius,
+                           int  inIterations ) {
 
-    mx_clearSliderSprites();
+    int  w                 =  mx_sprites[ inSpriteHandle ].w;
+    int  h                 =  mx_sprites[ inSpriteHandle ].h;
+    int  startByte         =  mx_sprites[ inSpriteHandle ].startByte;
+    int  tempStartByte;
+    int  sourceStartByte;
+    int  destStartByte;
+    int  i;
+    int  b;
+    int  y;
+    int  x;
+    int  neededExtraBytes  =  w * h * 4;
     
-    if( inNumBarSprites > MAXIGIN_NUM_STATIC_SLIDER_BARS ) {
-        maxigin_logInt( "Error:  maxigin_initSliderSpritesStatic called with "
-                        "too many bar sprites; ",
-                        inNumBarSprites );
-        inNumBarSprites = MAXIGIN_NUM_STATIC_SLIDER_BARS;
-        }
-
-    mx_sliderSprites.numFullBars = inNumBarSprites;
+    if( mx_numSpriteBytesUsed + neededExtraBytes >
+        MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
 
-    success = 1;
+        mingin_log( "Not enough extra sprites bytes in sprite data buffer "
+                    "to perform mx_blurSprite.\n" );
+        return;
+        }
     
-    for( i = 0;
-         i < inNumBarSprites;
-         i ++ ) {
+    tempStartByte = mx_numSpriteBytesUsed;
 
-        mx_sliderSprites.fullBars[i] =
-            maxigin_initSprite( inBarSprites[i] );
-        
-        success =
-            success
-            &&
-            ( mx_sliderSprites.fullBars[i] >= 0 );
+    /* zero out temp... black transparent pixels */
+    for( b = 0;
+         b < neededExtraBytes;
+         b ++ ) {
+        mx_spriteBytes[ tempStartByte + b ] = 0;
         }
     
 
-    mx_sliderSprites.thumb[ 0 ] =
-        maxigin_initSprite( inThumbSpriteResource );
+    /* start with main sprite as source, blank buffer as dest */
+    sourceStartByte = startByte;
+    destStartByte   = tempStartByte;
+    
+    for( i = 0;
+         i < inIterations;
+         i ++ ) {
 
-    mx_sliderSprites.thumb[ 1 ] =
-        maxigin_initSprite( inThumbHotSpriteResource );
+        int  tempTempStartByte;
+        int  startY              =  inRadius;
+        int  endY                =  h - inRadius;
+        int  startX              =  inRadius;
+        int  endX                =  w - inRadius;
 
-    mx_sliderSprites.thumb[ 2 ] =
-        maxigin_initSprite( inThumbActiveSpriteResource );
+        /* ignore edge cases
+           start blur pushed into image far enough where
+           our blur radius never goes outside of image */
 
-    mx_sliderSprites.loop[ 0 ] =
-        maxigin_initSprite( inLoopStartSpriteResource );
+        
+        for( y = startY;
+             y < endY;
+             y ++ ) {
 
-    mx_sliderSprites.loop[ 1 ] =
-        maxigin_initSprite( inLoopEndSpriteResource );
+            long           boxAccume[3]  =  { 0, 0, 0 };
+            long           alphaSum      =  0;
+            int            py;
+            int            px;
+            int            pixelsInBox   =  0;
+            int            rowStart;
+            int            pix;
+            int            c;
+            unsigned char  alpha;
+            
+            /* first, fill box accume with entire box around first pixel
+               in row */
+            for( py = y - inRadius;
+                 py <= y + inRadius;
+                 py ++ ) {
 
-    mx_sliderSpritesSet =
-        success
-        &&
-        ( mx_sliderSprites.thumb[ 0 ]  >= 0 )
-        &&
-        ( mx_sliderSprites.thumb[ 1 ]  >= 0 )
-        &&
-        ( mx_sliderSprites.thumb[ 2 ]  >= 0 )
-        &&
-        ( mx_sliderSprites.loop[ 0 ]   >= 0 )
-        &&
-        ( mx_sliderSprites.loop[ 1 ]   >= 0 );
-    }
+                int  boxRowStart  =  py * w * 4 + sourceStartByte;
+                
+                for( px = 0;
+                     px < inRadius + inRadius + 1;
+                     px ++ ) {
 
+                    pix   = boxRowStart + px * 4;
+                    c     = 0;
+                    alpha = mx_spriteBytes[ pix + 3 ];
 
+                    /* pre-multiply by alpha to avoid
+                       halos of residual color coming from
+                       fully transparent areas */
+                    
+                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
+                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
+                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
+                    alphaSum         += alpha;
 
-void maxigin_initMakeSliderGlow( int  inBlurRadius,
-                                 int  inBlurIterations ) {
-    int  i;
+                    pixelsInBox ++;
+                    }
+                }
 
-    /* don't apply glow to bar parts and slivers, because glow
-       doesn't tile nicely */
+            /* set blur value for first pixel in row */
 
-    for( i = 0;
-         i < mx_sliderSprites.numFullBars;
-         i ++ ) {
+            rowStart = y * w * 4 + destStartByte;
+            pix      = rowStart + startX * 4;
+            c        = 0;
 
-        maxigin_initMakeGlowSprite( mx_sliderSprites.fullBars[i],
-                                    inBlurRadius,
-                                    inBlurIterations );
-        }
-    
-    for( i = 0;
-         i < 3;
-         i ++ ) {
-        
-        maxigin_initMakeGlowSprite( mx_sliderSprites.thumb[i],
-                                    inBlurRadius,
-                                    inBlurIterations );
-        }
-    }
-
-
-
-#define  MAXIGIN_NUM_STATIC_PANELS  10
-
-
-typedef struct MaxiginPanelSprites {
+            if( alphaSum == 0 ) {     
+                mx_spriteBytes[ pix++ ] = 0;
+                mx_spriteBytes[ pix++ ] = 0;
+                mx_spriteBytes[ pix++ ] = 0;
+                mx_spriteBytes[ pix++ ] = 0;
+                }
+            else { 
+                mx_spriteBytes[ pix++ ] =    
+                    (unsigned char)( boxAccume[ c++ ] / alphaSum );
+                mx_spriteBytes[ pix++ ] =
+                    (unsigned char)( boxAccume[ c++ ] / alphaSum );
+                mx_spriteBytes[ pix++ ] =
+                    (unsigned char)( boxAccume[ c++ ] / alphaSum );
+                mx_spriteBytes[ pix++ ] =
+                    (unsigned char)( alphaSum / pixelsInBox );
+                }
+            
+            /* now process remaining pixels in row */
+            for( x = startX + 1;
+                 x < endX;
+                 x ++ ) {
 
-        /* tl, tr, bl, br */
-        int  corners[4];
-        
-        /* l, r, t, b */
-        int  sides  [4];
-        
-        int  fill;
+                /* subtract column to left that has fallen out of our
+                   moving box, add in column to right that has
+                   been added to our moving box */
+                for( py = y - inRadius;
+                     py <= y + inRadius;
+                     py ++ ) {
 
-        int  numFullPanels;
-        int  fullPanels[ MAXIGIN_NUM_STATIC_PANELS ];
+                    int  boxRowStart  =  py * w * 4 + sourceStartByte;
 
-        
-    } MaxiginPanelSprites;
+                    pix   = boxRowStart + ( x - 1 - inRadius ) * 4;
+                    c     = 0;
+                    alpha = mx_spriteBytes[ pix + 3 ];
 
+                    /* subtract pre-mulitiplied alpha left column */
+                    boxAccume[ c++ ] -= alpha * mx_spriteBytes[ pix++ ];
+                    boxAccume[ c++ ] -= alpha * mx_spriteBytes[ pix++ ];
+                    boxAccume[ c++ ] -= alpha * mx_spriteBytes[ pix++ ];
+                    alphaSum         -= alpha;
 
-char                   mx_panelSpritesSet  =  0;
-MaxiginPanelSprites    mx_panelSprites;
+                    pix   = boxRowStart + ( x + inRadius ) * 4;
+                    c     = 0;
+                    alpha = mx_spriteBytes[ pix + 3 ];
+                    
+                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
+                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
+                    boxAccume[ c++ ] += alpha * mx_spriteBytes[ pix++ ];
+                    alphaSum         += alpha;
+                    }
 
+                /* now our accume contains sum of all pixels
+                   in box around our pixel */
+                pix = rowStart + x * 4;
+                c   = 0;
 
+                if( alphaSum == 0 ) {
+                    mx_spriteBytes[ pix++ ] = 0;
+                    mx_spriteBytes[ pix++ ] = 0;
+                    mx_spriteBytes[ pix++ ] = 0;
+                    mx_spriteBytes[ pix++ ] = 0;
+                    }
+                else {
+                    mx_spriteBytes[ pix++ ] =
+                        (unsigned char)( boxAccume[ c++ ] / alphaSum );
+                    mx_spriteBytes[ pix++ ] =
+                        (unsigned char)( boxAccume[ c++ ] / alphaSum );
+                    mx_spriteBytes[ pix++ ] =
+                        (unsigned char)( boxAccume[ c++ ] / alphaSum );
+                    mx_spriteBytes[ pix++ ] =
+                        (unsigned char)( alphaSum / pixelsInBox );
+                    }
+                }
+            
+            }
 
-void maxigin_initPanelSprites( const char  *inTopLeftSpriteResource,
-                               const char  *inTopRightSpriteResource,
-                               const char  *inBottomLeftSpriteResource,
-                               const char  *inBottomRightSpriteResource,
-                               const char  *inLeftEdgeSpriteResource,
-                               const char  *inRightEdgeSpriteResource,
-                               const char  *inTopEdgeSpriteResource,
-                               const char  *inBottomEdgeSpriteResource,
-                               const char  *inFillSpriteResource ) {
-    mx_panelSprites.corners[0] =
-        maxigin_initSprite( inTopLeftSpriteResource );
-    
-    mx_panelSprites.corners[1] =
-        maxigin_initSprite( inTopRightSpriteResource );
-    
-    mx_panelSprites.corners[2] =
-        maxigin_initSprite( inBottomLeftSpriteResource );
-    
-    mx_panelSprites.corners[3] =
-        maxigin_initSprite( inBottomRightSpriteResource );
+        /* for next iteration, swap source and dest
+           blur back the other way */
+        tempTempStartByte = sourceStartByte;
+        sourceStartByte = destStartByte;
+        destStartByte = tempTempStartByte;
+        }
 
-    mx_panelSprites.sides[0] =
-        maxigin_initSprite( inLeftEdgeSpriteResource );
-    
-    mx_panelSprites.sides[1] =
-        maxigin_initSprite( inRightEdgeSpriteResource );
-    
-    mx_panelSprites.sides[2] =
-        maxigin_initSprite( inTopEdgeSpriteResource );
-    
-    mx_panelSprites.sides[3] =
-        maxigin_initSprite( inBottomEdgeSpriteResource );
+    /* we're done with iterations
+       where did our final image end up? */
 
-    mx_panelSprites.fill =
-        maxigin_initSprite( inFillSpriteResource );
+    if( sourceStartByte == tempStartByte ) {
 
-    mx_panelSpritesSet =
-        ( mx_panelSprites.corners[0] >= 0 )
-        &&
-        ( mx_panelSprites.corners[1] >= 0 )
-        &&
-        ( mx_panelSprites.corners[2] >= 0 )
-        &&
-        ( mx_panelSprites.corners[3] >= 0 )
-        &&
-        ( mx_panelSprites.sides[0]   >= 0 )
-        &&
-        ( mx_panelSprites.sides[1]   >= 0 )
-        &&
-        ( mx_panelSprites.sides[2]   >= 0 )
-        &&
-        ( mx_panelSprites.sides[3]   >= 0 )
-        &&
-        ( mx_panelSprites.fill       >= 0 );
+        /* ended up in our temp buffer
+           copy result back in */
+        for( b = 0;
+             b < neededExtraBytes;
+             b ++ ) {
+            
+            mx_spriteBytes    [ startByte     + b ] =
+                mx_spriteBytes[ tempStartByte + b ];
+            }
+        }
+    /* else ended up in-place in our original sprite byte buffer */
+    /* don't need to do any copying */
     }
 
 
 
-void maxigin_initPanelSpritesStatic( int           inNumFullPanelSprites,
-                                     const char  **inFullPanelSprites ) {
-    int   i;
-    char  success;
+static void mx_regenerateGlowSprite( int  inMainSpriteHandle,
+                                     int  inBlurRadius,
+                                     int  inBlurIterations ) {
 
+    MaxiginSprite  *mainSprite;
+    const char     *glowSpriteDataName;
+    char            skipPersistentData   =   0;
+    int             persistReadHandle    =  -1;
+    int             numBytes             =   0;
+    int             numRead;
+    int             b;
+    int             glowW;
+    int             glowH;
+    int             glowBorder;
     
-    if( inNumFullPanelSprites > MAXIGIN_NUM_STATIC_PANELS ) {
-        maxigin_logInt( "Error:  maxigin_initPanelSpritesStatic called with "
-                        "too many panel sprites; ",
-                        inNumFullPanelSprites );
-        inNumFullPanelSprites = MAXIGIN_NUM_STATIC_PANELS;
-        }
+    char           readGlowFromFile;
+    unsigned char  hashBuffer[ MAXIGIN_SPRITE_HASH_LENGTH ];
 
-    mx_panelSprites.numFullPanels = inNumFullPanelSprites;
 
-    success = 1;
-    
-    for( i = 0;
-         i < inNumFullPanelSprites;
-         i ++ ) {
+    mainSprite = &( mx_sprites[ inMainSpriteHandle ] );
 
-        mx_panelSprites.fullPanels[i] =
-            maxigin_initSprite( inFullPanelSprites[i] );
-        
-        success =
-            success
-            &&
-            ( mx_panelSprites.fullPanels[i] >= 0 );
+    if( mainSprite->numPaletteColors > 0 ) {
+        maxigin_logString( "Can't make glow for palette sprite: ",
+                           mainSprite->bulkResourceName );
+        return;
         }
 
-    mx_panelSpritesSet = success;
-    }
+    glowBorder = inBlurRadius * inBlurIterations * 2;
+    
+    glowW = mainSprite->w
+            +
+            2 * glowBorder;
+        
+    glowH = mainSprite->h
+            +
+            2 * glowBorder;
 
+    if( mainSprite->bulkResourceName[0] == '\0' ) {
+        /* empty source resource name, check if this is part of a strip */
 
+        if( mainSprite->stripParentHandle == -1 ) {
+            /* no bulk resource name, and not a strip sprite
+               this might be an internally-generated sprite that has
+               no bulk data representation */
+            
+            glowSpriteDataName = "";
+            skipPersistentData = 1;
+            }
+        else {
+            glowSpriteDataName =
+                maxigin_stringConcat4(
+                    mx_sprites[ mainSprite->stripParentHandle ].bulkResourceName,
+                    "_strip_",
+                    maxigin_intToString( mainSprite->stripIndex ),
+                    ".glow" );
+            }
+        }
+    else {
+        glowSpriteDataName = maxigin_stringConcat( mainSprite->bulkResourceName,
+                                                   ".glow" );
+        }
 
-void maxigin_initMakePanelGlow( int  inBlurRadius,
-                                int  inBlurIterations ) {
-    int  i;
+    readGlowFromFile = 0;
 
-    /* only apply to static panels, not dynamic panel tiles */
+    if( ! skipPersistentData ) {
+        persistReadHandle = mingin_startReadPersistData( glowSpriteDataName,
+                                                         & numBytes );
+        }
     
-    for( i = 0;
-         i < mx_panelSprites.numFullPanels;
-         i ++ ) {
-
-        maxigin_initMakeGlowSprite( mx_panelSprites.fullPanels[i],
-                                    inBlurRadius,
-                                    inBlurIterations );
-        }
-    }
-
-
-
-typedef struct MaxiginCheckboxSprites {
+    
+    if( persistReadHandle != -1 ) {
 
-        /* [0] for unchecked, [1] for checked */
-        int  cool[2];
-        int  hot [2];
-        
-    } MaxiginCheckboxSprites;
+        if( numBytes > MAXIGIN_SPRITE_HASH_LENGTH ) {
 
+            numRead = mingin_readPersistData( persistReadHandle,
+                                              MAXIGIN_SPRITE_HASH_LENGTH,
+                                              hashBuffer );
+            
+            if( numRead == MAXIGIN_SPRITE_HASH_LENGTH ) {
 
-char                     mx_checkboxSpritesSet  =  0;
-MaxiginCheckboxSprites   mx_checkboxSprites;
+                char  hashMatch        =  1;
+                int   readRadius;
+                int   readIterations;
+                char  success          =  0;
+                int   headerLength;
+                
+                for( b = 0;
+                     b < MAXIGIN_SPRITE_HASH_LENGTH;
+                     b ++ ) {
+                    
+                    if( hashBuffer[ b ] !=
+                        mainSprite->hash[ b ] ) {
+                        
+                        hashMatch = 0;
+                        break;
+                        }
+                    }
 
+                if( hashMatch ) {
+                    success =
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readRadius );
+                    
+                    success = success
+                        &&
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readIterations );
 
-void maxigin_initCheckboxSprites( const char  *inCoolUncheckedResource,
-                                  const char  *inCoolCheckedResource,
-                                  const char  *inHotUncheckedResource,
-                                  const char  *inHotCheckedResource ) {
+                    if( success
+                        &&
+                        ( readRadius != inBlurRadius
+                          ||
+                          readIterations != inBlurIterations ) ) {
+                        success = 0;
+                        }
+                    }
 
-    mx_checkboxSprites.cool[0] = maxigin_initSprite( inCoolUncheckedResource );
-    mx_checkboxSprites.cool[1] = maxigin_initSprite( inCoolCheckedResource   );
-    
-    mx_checkboxSprites.hot [0] = maxigin_initSprite( inHotUncheckedResource  );
-    mx_checkboxSprites.hot [1] = maxigin_initSprite( inHotCheckedResource    );
+                headerLength = MAXIGIN_SPRITE_HASH_LENGTH
+                               +
+                               2 * MAXIGIN_PADDED_INT_LENGTH;
+                
+                if( success ) {
+                    if( mainSprite->glowSpriteHandle ==
+                        -1 ) {
 
-    mx_checkboxSpritesSet =
-        ( mx_checkboxSprites.cool[0] != -1 )
-        &&
-        ( mx_checkboxSprites.cool[1] != -1 )
-        &&
-        ( mx_checkboxSprites.hot [0] != -1 )
-        &&
-        ( mx_checkboxSprites.hot [1] != -1 );   
-    }
+                        MinginOpenData  openData;
+                        
+                        /* load from glow file */
+                        openData.readHandle = persistReadHandle;
+                        openData.isBulk     = 0;
+                        openData.mappedData = 0;
 
+                        /* set a non-file-name (blank string )
+                           as inBulkResourceName
+                           since this glow sprite isn't actually in
+                           our bulk data store */
+                        mainSprite->glowSpriteHandle =
+                            mx_reloadSpriteFromOpenData(
+                                "",
+                                -1,
+                                & openData,
+                                /* TGA data comes right after hash bytes
+                                   and int parameters */
+                                numBytes - headerLength );
 
-void maxigin_initMakeCheckboxGlow( int  inBlurRadius,
-                                   int  inBlurIterations ) {
+                        if( mainSprite->glowSpriteHandle !=
+                            -1 ) {
+                            /* successfully loaded from file */
+                            readGlowFromFile = 1;
 
-    int  i;
-    
-    for( i = 0;
-         i < 2;
-         i ++ ) {
+                            mainSprite->glowRadius = inBlurRadius;
+                            mainSprite->glowIterations = inBlurIterations;
+                            
+                            maxigin_logString( "Successfully read cached glow "
+                                               "sprite from perisistent data "
+                                               "store for ",
+                                               mainSprite->bulkResourceName );
+                            }
+                        }
+                    else {
+                        /* glow sprite with hash and parameter
+                           match already loaded */
 
-        maxigin_initMakeGlowSprite( mx_checkboxSprites.cool[i],
-                                    inBlurRadius,
-                                    inBlurIterations );
+                        readGlowFromFile = 1;
+                        }
+                    }  
+                }
+            }
         
-        maxigin_initMakeGlowSprite( mx_checkboxSprites.hot[i],
-                                    inBlurRadius,
-                                    inBlurIterations );
+        mingin_endReadPersistData( persistReadHandle );
         }
-    }
 
+    if( ! readGlowFromFile ) {
 
+        /* generate glow from scratch
+           cache it to file for future */
 
-typedef struct MaxiginButtonSprites {
-        
-        int  cool;
-        int  hot;
-        int  pressed;
+        int  glowSpriteHandle;
+        int  neededGlowBytes;
+        int  glowCacheDataWriteHandle;
+        int  glowStartByte;
+        int  mainStartByte;
+        int  x;
+        int  y;
+        int  mainW;
+        int  mainH;
         
-    } MaxiginButtonSprites;
-
+        glowSpriteHandle = mainSprite->glowSpriteHandle;
 
-char                  mx_buttonSpritesSet  =  0;
-MaxiginButtonSprites  mx_buttonSprites;
 
+        if( glowSpriteHandle != -1 ) {
+            mx_removeSpriteData( glowSpriteHandle );
+            }
+        else {
+            /* stick new glow sprite at end of sprite list */
+            glowSpriteHandle = mx_numSprites;
 
-void maxigin_initButtonSprites( const char  *inCoolResource,
-                                const char  *inHotResource,
-                                const char  *inPressedResource ) {
+            if( mx_numSprites >= MAXIGIN_MAX_NUM_SPRITES ) {
 
-    mx_buttonSprites.cool = maxigin_initSprite( inCoolResource );
-    mx_buttonSprites.hot = maxigin_initSprite( inHotResource  );
-    
-    mx_buttonSprites.pressed = maxigin_initSprite( inPressedResource  );
-    
-    mx_buttonSpritesSet =
-        ( mx_buttonSprites.cool    != -1 )
-        &&
-        ( mx_buttonSprites.hot     != -1 )
-        &&
-        ( mx_buttonSprites.pressed != -1 );   
-    }
+                maxigin_logString(
+                    "Already have too many sprites when trying "
+                    "to create glow sprite for: ",
+                    mainSprite->bulkResourceName );
+                return;
+                }
+            }
 
+        neededGlowBytes = glowW * glowH * 4;
 
+        if( mx_numSpriteBytesUsed + neededGlowBytes
+            >
+            MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
 
-void maxigin_initMakeButtonGlow( int  inBlurRadius,
-                                 int  inBlurIterations ) {
+            maxigin_logString(
+                "Already have too many sprite data bytes when trying "
+                "to create glow sprite for: ",
+                mainSprite->bulkResourceName );
+            
+            return;
+            }
 
-    maxigin_initMakeGlowSprite( mx_buttonSprites.cool,
-                                inBlurRadius,
-                                inBlurIterations );
         
-    maxigin_initMakeGlowSprite( mx_buttonSprites.hot,
-                                inBlurRadius,
-                                inBlurIterations );
-
-    maxigin_initMakeGlowSprite( mx_buttonSprites.pressed,
-                                inBlurRadius,
-                                inBlurIterations );
-    }
+        mainSprite->glowSpriteHandle = glowSpriteHandle;
+        mainSprite->glowRadius       = inBlurRadius;
+        mainSprite->glowIterations   = inBlurIterations;
 
+        glowStartByte  =  mx_numSpriteBytesUsed;
+        
+        mainW          =  mainSprite->w;
+        mainH          =  mainSprite->h;
+        mainStartByte  =  mainSprite->startByte;
+        
+        mx_sprites[ glowSpriteHandle ].w                  = glowW;
+        mx_sprites[ glowSpriteHandle ].h                  = glowH;
+        mx_sprites[ glowSpriteHandle ].startByte          = glowStartByte;
+        mx_sprites[ glowSpriteHandle ].numPaletteColors   = 0;
+        mx_sprites[ glowSpriteHandle ].glowSpriteHandle   = -1;
 
+        mx_initEmptyShadows( glowSpriteHandle );
 
-void maxigin_initMakeGuiGlow( int  inBlurRadius,
-                              int  inBlurIterations ) {
+        mx_sprites[ glowSpriteHandle ].bulkResourceName[0] = '\0';
 
-    maxigin_initMakeSliderGlow( inBlurRadius,
-                                inBlurIterations );
-    
-    maxigin_initMakePanelGlow( inBlurRadius,
-                               inBlurIterations );
-    
-    maxigin_initMakeCheckboxGlow( inBlurRadius,
-                                  inBlurIterations );
+        mx_sprites[ glowSpriteHandle ].stripParentHandle = -1;
+        mx_sprites[ glowSpriteHandle ].stripIndex = -1;
+        mx_sprites[ glowSpriteHandle ].stripChildHandle = -1;
 
-    maxigin_initMakeButtonGlow( inBlurRadius,
-                                inBlurIterations );
-    }
+        if( glowSpriteHandle == mx_numSprites ) {
+            /* adding a new sprite to end of list */
+            mx_numSprites ++;
+            }
+        
+        mx_numSpriteBytesUsed += neededGlowBytes;
 
 
+        /* generate glow sprite pixels */
 
-/* strip handle is -1 to make a new strip
-   
-   if inStripHandle is an existing strip, inHeightPerSprite should be -1,
-   since the existing height per sprite will be used.
-   
-   returns handle to strip (which may equal inSpriteHandle if re-making
-   an existing strip) */
-static int mx_regenSpriteStripChildren( int  inMainSpriteHandle,
-                                        int  inStripHandle,
-                                        int  inHeightPerSprite );
+        for( b = 0;
+             b < neededGlowBytes;
+             b ++ ) {
+            /* zero out glow sprite */
+            mx_spriteBytes[ b + glowStartByte ] = 0;
+            }
 
+        /* copy sprite into center of glow sprite, leaving border
+           of black transparent pixels */
 
+        for( y = 0;
+             y < mainH;
+             y ++ ) {
 
-static void mx_regenerateSpriteKerning( int  inSpriteHandle );
+            int  mainRowStart  =  y * mainW * 4;
+            int  glowY         =  y + glowBorder;
+            int  glowRowStart  =  glowY * glowW * 4;
+            
+            for( x = 0;
+                 x < mainW;
+                 x ++ ) {
+                
+                int  pixStart      =  mainRowStart + x * 4 + mainStartByte;
+                int  glowX         =  x + glowBorder;
+                int  glowPixStart  =  glowRowStart + glowX * 4 + glowStartByte;
 
+                mx_spriteBytes    [ glowPixStart     ++ ] =
+                    mx_spriteBytes[ pixStart         ++ ];
+                
+                mx_spriteBytes    [ glowPixStart     ++ ] =
+                    mx_spriteBytes[ pixStart         ++ ];
+                
+                mx_spriteBytes    [ glowPixStart     ++ ] =
+                    mx_spriteBytes[ pixStart         ++ ];
+                
+                mx_spriteBytes    [ glowPixStart     ++ ] =
+                    mx_spriteBytes[ pixStart         ++ ];
+                }
+            }
 
+        
+        mx_blurSprite( glowSpriteHandle,
+                       inBlurRadius,
+                       inBlurIterations );
 
-static void mx_postReloadStep( int  inSpriteHandle ) {
-    
-    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle ] );
+        if( ! skipPersistentData ) {
+            glowCacheDataWriteHandle =
+                mingin_startWritePersistData( glowSpriteDataName );
 
-    if( s->colorMapHandle != -1 ) {
+            if( glowCacheDataWriteHandle == -1 ) {
+                maxigin_logString( "Failed to open persistent "
+                                   "data cache file for writing: ",
+                                   glowSpriteDataName );
+                return;
+                }
 
-        /* re-apply the color map to the newly-loaded sprite,
-           which would have reloaded its source colors */
+        
+            mingin_writePersistData( glowCacheDataWriteHandle,
+                                     MAXIGIN_SPRITE_HASH_LENGTH,
+                                     mainSprite->hash );
 
-        maxigin_applyColorMap( inSpriteHandle,
-                               s->colorMapHandle,
-                               s->colorMapRow );
-        }
-    
-    s->pendingChange       = 0;
-    s->retryCount          = 0;
-    s->stepsUntilNextRetry = 0;
+            /* next radius and iteration count as padded ints */
+        
+            mx_writePaddedIntToPerisistentData( glowCacheDataWriteHandle,
+                                                inBlurRadius );
+        
+            mx_writePaddedIntToPerisistentData( glowCacheDataWriteHandle,
+                                                inBlurIterations );
 
-    if( s->glowSpriteHandle != -1 ) {
+        
+            mx_writeSpriteToOpenData( glowSpriteHandle,
+                                      glowCacheDataWriteHandle );
 
-        mx_regenerateGlowSprite(
-            inSpriteHandle,
-            s->glowRadius,
-            s->glowIterations );
+
+            if( ! mingin_endWritePersistData( glowCacheDataWriteHandle ) ) {
+                /* don't leave a cut-off cache behind */
+                maxigin_logString( "Failed to write persistent "
+                                   "data cache file: ",
+                                   glowSpriteDataName );
+                mingin_deletePersistData( glowSpriteDataName );
+                }
+            }
         }
+    
+    }
 
-    if( s->numShadows > 0 ) {
 
-        int  i;
 
-        for( i = 0;
-             i < s->numShadows;
-             i ++ ) {
+void maxigin_initMakeGlowSprite( int  inSpriteHandle,
+                                 int  inBlurRadius,
+                                 int  inBlurIterations ) {
 
-            mx_regenerateDropShadowSprite(
-                inSpriteHandle,
-                i,
-                s->shadowRadius       [i],
-                s->shadowIterations   [i],
-                s->shadowBottomAlpha  [i],
-                s->shadowTopAlpha     [i],
-                s->shadowBottomPercent[i],
-                s->shadowTopPercent   [i],
-                s->shadowDarkness     [i],
-                s->shadowGrayValue    [i] );
-            }
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call maxigin_initMakeGlowSprite "
+                    "from outside of maxiginGame_init\n" );
+        return;
         }
 
-    if( s->stripChildHandle != -1 ) {
-        /* just reloaded a parent sprite of a strip
-           need to make new pointers for child sprites */
-
-        /* this will also re-gen glow sprites if needed */
-        mx_regenSpriteStripChildren( inSpriteHandle,
-                                     s->stripChildHandle,
-                                     -1 );
+    if( inSpriteHandle < 0 ) {
+        return;
         }
 
-    if( s->kerningTableIndex != -1 ) {
-        mx_regenerateSpriteKerning( inSpriteHandle );
+    if( mx_spriteCacheLoaded ) {
+        /* skip generating glow sprite */
+        /* advance next sprite handle */
+        mx_nextCachedSpriteHandle ++;
+        return;
         }
 
+    mx_startProfilePhase( "makeGlowSprites" );
     
-    if( s->isColorMap ) {
-        /* this sprite is a color map itself
-           and it has changed!
-           Trigger reload of all sprites that use this map */
+    mx_regenerateGlowSprite( inSpriteHandle,
+                             inBlurRadius,
+                             inBlurIterations );
+    
+    mx_endProfilePhase();
+    }
 
-        int  i;
 
-        for( i = 0;
-             i < mx_numSprites;
-             i ++ ) {
 
-            if( i != inSpriteHandle ) {
+static void mx_regenerateDropShadowSprite( int            inMainSpriteHandle,
+                                           int            inShadowIndex,
+                                           int            inBlurRadius,
+                                           int            inBlurIterations,
+                                           unsigned char  inBottomAlpha,
+                                           unsigned char  inTopAlpha,
+                                           unsigned char  inBottomPercent,
+                                           unsigned char  inTopPercent,
+                                           int            inDarkness,
+                                           unsigned char  inGrayValue ) {
 
-                MaxiginSprite  *s2  =  &( mx_sprites[i] );
+    MaxiginSprite  *mainSprite;
+    const char     *shadowSpriteDataName;
+    int             persistReadHandle;
+    int             numBytes;
+    int             numRead;
+    int             p;
+    int             b;
+    int             shadowW;
+    int             shadowH;
+    int             shadowBorder;
 
-                if( s2->colorMapHandle == inSpriteHandle
-                    &&
-                    s2->bulkResourceName[0] != '\0' ) {
+    int             si                     =  inShadowIndex;
+    
+    char            readShadowFromFile;
+    unsigned char   hashBuffer[ MAXIGIN_SPRITE_HASH_LENGTH ];
 
-                    /* don't worry about whether this is a success
-                       or not.
-                       We do that during the file-changed-reload process
-                       because the file may be incomplete for a bit
-                       after it has changed on disk
-                       But in this case, we are triggering a cascade
-                       reload after a separate color map file changed */
-                    mx_reloadSprite( s2->bulkResourceName,
-                                     i );
-                    
-                    mx_postReloadStep( i );
-                    }
-                }
-            }
-        }
-    }
 
+    mainSprite = &( mx_sprites[ inMainSpriteHandle ] );
 
+    if( mainSprite->numPaletteColors > 0 ) {
+        maxigin_logString( "Can't make drop shadow for palette sprite: ",
+                           mainSprite->bulkResourceName );
+        return;
+        }
 
-static void mx_checkSpritesNeedReload( void ) {
+    shadowBorder = inBlurRadius * inBlurIterations * 2;
+    
+    shadowW = mainSprite->w
+              +
+              2 * shadowBorder;
+        
+    shadowH = mainSprite->h
+              +
+              2 * shadowBorder;
 
-    int  s;
+    if( mainSprite->bulkResourceName[0] == '\0' ) {
+        /* empty source resource name, check if this is part of a strip */
 
-    for( s = 0;
-         s < mx_numSprites;
-         s ++ ) {
+        if( mainSprite->stripParentHandle == -1 ) {
+            mingin_log( "Failed to make shadow sprite for non-strip sprite "
+                        "without bulk resource name.\n" );
+            return;
+            }
 
-        if( mx_sprites[ s ].pendingChange ) {
+        shadowSpriteDataName =
+            maxigin_stringConcat5(
+                mx_sprites[ mainSprite->stripParentHandle ].bulkResourceName,
+                "_strip_",
+                maxigin_intToString( mainSprite->stripIndex ),
+                ".shadow_",
+                maxigin_intToString( si ) );
+        }
+    else {
+        shadowSpriteDataName =
+            maxigin_stringConcat3( mainSprite->bulkResourceName,
+                                  ".shadow_",
+                                   maxigin_intToString( si ) );
+        }
 
-            if( mx_sprites[ s ].stepsUntilNextRetry <= 0 ) {
+    readShadowFromFile = 0;
+    
+    persistReadHandle = mingin_startReadPersistData( shadowSpriteDataName,
+                                                     & numBytes );
+    
+    if( persistReadHandle != -1 ) {
 
-                int  retry   =  mx_sprites[ s ].retryCount;
-                int  handle  =  mx_reloadSprite(
-                                    mx_sprites[ s ].bulkResourceName,
-                                    s );
+        if( numBytes > MAXIGIN_SPRITE_HASH_LENGTH ) {
 
-                if( handle == -1 ) {
-                    /* with each failure, we wait more and more
-                       steps until we try again */
-                    mx_sprites[ s ].pendingChange = 1;
-                    mx_sprites[ s ].retryCount ++;
-                    
-                    mx_sprites[ s ].stepsUntilNextRetry =
-                                        mx_sprites[ s ].retryCount;
-                    }
-                else {
-                    /* success in reloading */
-
-                    maxigin_logInt(
-                        "Success in reloading sprite after retries: ",
-                        retry );
+            numRead = mingin_readPersistData( persistReadHandle,
+                                              MAXIGIN_SPRITE_HASH_LENGTH,
+                                              hashBuffer );
+            
+            if( numRead == MAXIGIN_SPRITE_HASH_LENGTH ) {
 
-                    mx_postReloadStep( s );
+                char  hashMatch        =  1;
+                int   readRadius;
+                int   readIterations;
+                int   readBottomAlpha;
+                int   readTopAlpha;
+                int   readBottomPercent;
+                int   readTopPercent;
+                int   readDarkness;
+                int   readGrayValue;
+                char  success          =  0;
+                int   headerLength;
+                
+                for( b = 0;
+                     b < MAXIGIN_SPRITE_HASH_LENGTH;
+                     b ++ ) {
+                    
+                    if( hashBuffer[ b ] !=
+                        mainSprite->hash[ b ] ) {
+                        
+                        hashMatch = 0;
+                        break;
+                        }
                     }
-                }
-            else {
-                /* wait another step before retrying */
-                mx_sprites[ s ].stepsUntilNextRetry --;
-                }
-            }
-        else if(
-            mx_sprites[ s ].bulkResourceName[ 0 ] != '\0'
-            &&
-            mingin_getBulkDataChanged( mx_sprites[ s ].bulkResourceName ) ) {
-
-            /* skip checking any with blank bulkResourceNames,
-               since those are our internally-generated sprites */
 
-            int  so;
-            int  handle  =  mx_reloadSprite( mx_sprites[ s ].bulkResourceName,
-                                             s );
-            
-            /* we see a bulk data change for this sprite
-               however, the bulk data might be in the middle of being
-               written by an external editor, or may contain invalid
-               data for other reasons.
-               If that's the case, truncated TGA data will be found
-               and skipped, and the old sprite will remain in place.
-               But keep trying to reload it */
-
-            if( handle == -1 ) {
-                mx_sprites[ s ].pendingChange       = 1;
-                mx_sprites[ s ].retryCount          = 1;
-                mx_sprites[ s ].stepsUntilNextRetry = 1;
-                }
-            else {
-                mx_postReloadStep( s );
-                }
+                if( hashMatch ) {
+                    success =
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readRadius );
+                    
+                    success = success
+                        &&
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readIterations );
 
-            /* loop over other sprites and look for any that
-               have same bulk data resource and reload those now too.
-               Otherwise, we will miss reloading them (they won't count
-               as changed since last reload). */
+                    success = success
+                        &&
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readBottomAlpha );
 
-            for( so = 0;
-                 so < mx_numSprites;
-                 so ++ ) {
+                    success = success
+                        &&
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readTopAlpha );
 
-                int  handleO;
+                    success = success
+                        &&
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readBottomPercent );
 
-                if( so == s ) {
-                    continue;
-                    }
-                
-                if( mx_sprites[ so ].bulkResourceName[ 0 ] == '\0' ) {
-                    continue;
-                    }
+                    success = success
+                        &&
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readTopPercent );
 
-                if( ! maxigin_stringsEqual(
-                        mx_sprites[ s ].bulkResourceName,
-                        mx_sprites[ so ].bulkResourceName ) ) {
-                    continue;
+                    success = success
+                        &&
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readDarkness );
+                    
+                    success = success
+                        &&
+                        mx_readPaddedIntFromPeristentData(
+                            persistReadHandle,
+                            & readGrayValue );
+                    
+                    if( success
+                        &&
+                        ( readRadius != inBlurRadius
+                          ||
+                          readIterations != inBlurIterations
+                          ||
+                          (unsigned char)readBottomAlpha != inBottomAlpha
+                          ||
+                          (unsigned char)readTopAlpha != inTopAlpha
+                          ||
+                          (unsigned char)readBottomPercent != inBottomPercent
+                          ||
+                          (unsigned char)readTopPercent != inTopPercent
+                          ||
+                          readDarkness != inDarkness
+                          ||
+                          (unsigned char)readGrayValue != inGrayValue ) ) {
+                        
+                        success = 0;
+                        }
                     }
 
-                /* a match! */
+                headerLength = MAXIGIN_SPRITE_HASH_LENGTH
+                               +
+                               5 * MAXIGIN_PADDED_INT_LENGTH;
                 
-                handleO  =  mx_reloadSprite( mx_sprites[ so ].bulkResourceName,
-                                             so );
-                if( handleO == -1 ) {
-                    mx_sprites[ so ].pendingChange       = 1;
-                    mx_sprites[ so ].retryCount          = 1;
-                    mx_sprites[ so ].stepsUntilNextRetry = 1;
-                    }
-                else {
-                    mx_postReloadStep( so );
-                    }
-                }
-            }
-        }
-    }
+                if( success ) {
+                    if( mainSprite->shadowSpriteHandle[ si ] ==
+                        -1 ) {
 
+                        MinginOpenData  openData;
+                        
+                        /* load from shadow file */
+                        openData.readHandle = persistReadHandle;
+                        openData.isBulk     = 0;
+                        openData.mappedData = 0;
 
+                        /* set a non-file-name (blank string )
+                           as inBulkResourceName
+                           since this shadow sprite isn't actually in
+                           our bulk data store */
+                        mainSprite->shadowSpriteHandle[ si ] =
+                            mx_reloadSpriteFromOpenData(
+                                "",
+                                -1,
+                                & openData,
+                                /* TGA data comes right after hash bytes
+                                   and parameter ints */
+                                numBytes - headerLength );
 
-/* each sprite strip points to sprites in the sprite pool
-   the handles for these sub-sprites are stored here */
-static  int  mx_stripSubSprites[ MAXIGIN_MAX_NUM_SPRITES ];
+                        if( mainSprite->shadowSpriteHandle[ si ] !=
+                            -1 ) {
+                            /* successfully loaded from file */
+                            readShadowFromFile = 1;
 
-static  int  mx_numStripSubSprites  =  0;
+                            mainSprite->shadowRadius     [si] = inBlurRadius;
+                            mainSprite->shadowIterations [si] = inBlurIterations;
+                            mainSprite->shadowBottomAlpha[si] = inBottomAlpha;
+                            mainSprite->shadowTopAlpha   [si] = inTopAlpha;
+                            mainSprite->shadowBottomPercent
+                                                         [si] = inBottomPercent;
+                            mainSprite->shadowTopPercent [si] = inTopPercent;
+                            mainSprite->shadowDarkness   [si] = inDarkness;
+                            mainSprite->shadowGrayValue  [si] = inGrayValue;
+                            
+                            maxigin_logString( "Successfully read cached shadow "
+                                               "sprite from perisistent data "
+                                               "store for ",
+                                               mainSprite->bulkResourceName );
+                            }
+                        }
+                    else {
+                        /* shadow sprite with hash and parameter
+                           match already loaded */
 
+                        readShadowFromFile = 1;
+                        }
+                    }  
+                }
+            }
+        
+        mingin_endReadPersistData( persistReadHandle );
+        }
 
-typedef struct MaxiginSpriteStrip {
+    if( ! readShadowFromFile ) {
 
-        int  numSubSprites;
+        /* generate shadow from scratch
+           cache it to file for future */
 
-        int  heightPerSprite;
+        int  shadowSpriteHandle;
+        int  numShadowPixels;
+        int  neededShadowBytes;
+        int  shadowCacheDataWriteHandle;
+        int  shadowStartByte;
+        int  mainStartByte;
+        int  x;
+        int  y;
+        int  mainW;
+        int  mainH;
 
-        /* index of first strip sprite's handle in mx_stripSubSprites */
-        int  startIndex;
-        
-    } MaxiginSpriteStrip;
+        int   opaqueFirstY;
+        int   opaqueLastY;
+        long  opaqueSpan;
+        long  alphaSpan         =  inBottomAlpha - inTopAlpha;
 
+        long  topOffsetPixels;
+        long  bottomOffsetPixels;
 
+        
+        shadowSpriteHandle = mainSprite->shadowSpriteHandle[ si ];
 
-static  MaxiginSpriteStrip  mx_spriteStrips[ MAXIGIN_MAX_NUM_SPRITE_STRIPS ];
 
-static  int                 mx_numSpriteStrips  =  0;
+        if( shadowSpriteHandle != -1 ) {
+            mx_removeSpriteData( shadowSpriteHandle );
+            }
+        else {
+            /* stick new shadow sprite at end of sprite list */
+            shadowSpriteHandle = mx_numSprites;
 
+            if( mx_numSprites >= MAXIGIN_MAX_NUM_SPRITES ) {
 
+                maxigin_logString(
+                    "Already have too many sprites when trying "
+                    "to create shadow sprite for: ",
+                    mainSprite->bulkResourceName );
+                return;
+                }
+            }
 
-int maxigin_initSpriteStrip( const char  *inBulkResourceName,
-                             int          inHeightPerSprite ) {
+        numShadowPixels   = shadowW * shadowH;
+        neededShadowBytes = numShadowPixels * 4;
 
-    int                  mainSpriteHandle;
-    
-    if( mx_numSpriteStrips >= MAXIGIN_MAX_NUM_SPRITE_STRIPS ) {
-        maxigin_logString( "Failed to load sprite strip because we already "
-                           "have too many sprite strips loaded: ",
-                           inBulkResourceName );
-        return -1;
-        }
-    
-    mainSpriteHandle = maxigin_initSprite( inBulkResourceName );
+        if( mx_numSpriteBytesUsed + neededShadowBytes
+            >
+            MAXIGIN_MAX_TOTAL_SPRITE_BYTES ) {
 
-    if( mainSpriteHandle == -1 ) {
-        return -1;
-        }
+            maxigin_logString(
+                "Already have too many sprite data bytes when trying "
+                "to create shadow sprite for: ",
+                mainSprite->bulkResourceName );
+            
+            return;
+            }
 
-    
-    if( mx_spriteCacheLoaded ) {
-        /* strip already loadded from cache */
         
-        int  thisHandle  =  mx_nextCachedSpriteStripHandle;
-
-        mx_nextCachedSpriteStripHandle ++;
-
-        /* figure out how many sprite handles to skip */
-
-        mx_nextCachedSpriteHandle +=
-            mx_sprites[ mainSpriteHandle ].h  / inHeightPerSprite;
+        mainSprite->shadowSpriteHandle [si] = shadowSpriteHandle;
+        mainSprite->shadowRadius       [si] = inBlurRadius;
+        mainSprite->shadowIterations   [si] = inBlurIterations;
+        mainSprite->shadowBottomAlpha  [si] = inBottomAlpha;
+        mainSprite->shadowTopAlpha     [si] = inTopAlpha;
+        mainSprite->shadowBottomPercent[si] = inBottomPercent;
+        mainSprite->shadowTopPercent   [si] = inTopPercent;
+        mainSprite->shadowDarkness     [si] = inDarkness;
+        mainSprite->shadowGrayValue    [si] = inGrayValue;
         
-        return thisHandle;
-        }
-    
+        shadowStartByte  =  mx_numSpriteBytesUsed;
+        
+        mainW          =  mainSprite->w;
+        mainH          =  mainSprite->h;
+        mainStartByte  =  mainSprite->startByte;
+        
+        mx_sprites[ shadowSpriteHandle ].w                   =  shadowW;
+        mx_sprites[ shadowSpriteHandle ].h                   =  shadowH;
+        mx_sprites[ shadowSpriteHandle ].startByte           =  shadowStartByte;
+        mx_sprites[ shadowSpriteHandle ].numPaletteColors    =  0;
+        mx_sprites[ shadowSpriteHandle ].glowSpriteHandle    = -1;
 
-    /* generate a brand new strip */
-    return mx_regenSpriteStripChildren( mainSpriteHandle,
-                                        -1,
-                                        inHeightPerSprite );
-    }
+        mx_initEmptyShadows( shadowSpriteHandle );
 
+        mx_sprites[ shadowSpriteHandle ].bulkResourceName[0] = '\0';
 
+        mx_sprites[ shadowSpriteHandle ].stripParentHandle   = -1;
+        mx_sprites[ shadowSpriteHandle ].stripIndex          = -1;
+        mx_sprites[ shadowSpriteHandle ].stripChildHandle    = -1;
+        
+        mx_numSprites ++;
+        mx_numSpriteBytesUsed += neededShadowBytes;
 
-static int mx_regenSpriteStripChildren( int  inMainSpriteHandle,
-                                        int  inStripHandle,
-                                        int  inHeightPerSprite ) {
 
-    MaxiginSprite       *mainSprite;
-    int                  numSubSprites;
-    int                  newStripHandle;
-    MaxiginSpriteStrip  *newStrip;
-    int                  i;
-    int                  bytesPerSubSprite;
-    int                  nextSubStartByte;
-    char                 exists;
-    
-    mainSprite = &( mx_sprites[ inMainSpriteHandle ] );
+        /* generate shadow sprite pixels */
 
-    if( inHeightPerSprite == -1 ) {
-        if( inStripHandle == -1 ) {
-            maxigin_logString(
-                "Failed to load sprite strip because strip height "
-                "per sub-sprite not specified: ",
-                mainSprite->bulkResourceName );
-            return -1;
+        for( b = 0;
+             b < neededShadowBytes;
+             b ++ ) {
+            /* zero out shadow sprite */
+            mx_spriteBytes[ b + shadowStartByte ] = 0;
             }
-        /* if height not given, extract it from existing strip */
-        inHeightPerSprite = mx_spriteStrips[ inStripHandle ].heightPerSprite;
-        }
-
-    numSubSprites = mainSprite->h / inHeightPerSprite;
-
-    if( inStripHandle != -1 ) {
-        if( numSubSprites * inHeightPerSprite
-            != mainSprite->h
-            ||
-            numSubSprites != mx_spriteStrips[ inStripHandle ].numSubSprites ) {
 
-            /* some kind of mismatch */
+        /* copy sprite into center of shadow sprite, leaving border
+           of gray transparent pixels */
 
-            /* we actually allow a taller/shorter strip if can still contain
-               the same number of sub-sprites that are all of a new,
-               taller/shorter same size */
+        for( y = 0;
+             y < mainH;
+             y ++ ) {
 
-            /* number of sub sprites can't change, though */
-            numSubSprites = mx_spriteStrips[ inStripHandle ].numSubSprites;
+            int  mainRowStart    =  y * mainW * 4;
+            int  shadowY         =  y + shadowBorder;
+            int  shadowRowStart  =  shadowY * shadowW * 4;
+            
+            for( x = 0;
+                 x < mainW;
+                 x ++ ) {
+                
+                int  pixStart        =  mainRowStart + x * 4 + mainStartByte;
+                int  shadowX         =  x + shadowBorder;
+                int  shadowPixStart  =  shadowRowStart + shadowX * 4
+                                        + shadowStartByte;
 
-            /* we'll check if an interger multiple of this fits below */
-            inHeightPerSprite = mainSprite->h / numSubSprites;
+                mx_spriteBytes    [ shadowPixStart     ++ ] =
+                    mx_spriteBytes[ pixStart           ++ ];
+                
+                mx_spriteBytes    [ shadowPixStart     ++ ] =
+                    mx_spriteBytes[ pixStart           ++ ];
+                
+                mx_spriteBytes    [ shadowPixStart     ++ ] =
+                    mx_spriteBytes[ pixStart           ++ ];
+                
+                mx_spriteBytes    [ shadowPixStart     ++ ] =
+                    mx_spriteBytes[ pixStart           ++ ];
+                }
             }
-        }
-    
-    if( numSubSprites * inHeightPerSprite
-        !=
-        mainSprite->h ) {
 
-        maxigin_logString( "Failed to (re) load sprite strip because strip "
-                           "height is not integer multiple of supplied height: ",
-                           mainSprite->bulkResourceName );
-        return -1;
-        }
 
-    
+        /* now walk through pixels of copy, and make all pixels gray
+           ( leave alpha alone )
+           This makes a gray silhouette of the sprite */
+        b = shadowStartByte;
 
+        for( p = 0;
+             p < numShadowPixels;
+             p ++ ) {
 
+            mx_spriteBytes[ b ++ ] = inGrayValue;
+            mx_spriteBytes[ b ++ ] = inGrayValue;
+            mx_spriteBytes[ b ++ ] = inGrayValue;
 
-    if( inStripHandle == -1 ) {
+            /* leave alpha untouched */
+            b++;
+            }
+        
+        mx_blurSprite( shadowSpriteHandle,
+                       inBlurRadius,
+                       inBlurIterations );
 
-        /* make sure there's room for this many new sub-sprites */
 
-        if( mx_numStripSubSprites + numSubSprites
-            >=
-            MAXIGIN_MAX_NUM_SPRITES ) {
         
-            maxigin_logString( "Failed to load sprite strip because we already "
-                               "have too many strip sub sprites: ",
-                               mainSprite->bulkResourceName );
-            return -1;
-            }
 
-        if( mx_numSprites + numSubSprites
-            >=
-            MAXIGIN_MAX_NUM_SPRITES ) {
-        
-            maxigin_logString( "Failed to load sprite strip because we already "
-                               "have too many sprites: ",
-                               mainSprite->bulkResourceName );
-            return -1;
-            };
-        
-        newStripHandle = mx_numSpriteStrips;
-        
-        mx_numSpriteStrips ++;
 
-        exists = 0;
-        }
-    else {
-        /* an existing strip, there's already room for it */
-        
-        newStripHandle = inStripHandle;
+        /* now apply darkness parameter to alpha only
+           (this doesn't make the gray value darker ) */
+        b = shadowStartByte;
 
-        exists = 1;
-        }
-    
+        if( inDarkness > 0 ) {
+            
+            long  factor  =  inDarkness + 100;
+            
+            for( p = 0;
+                 p < numShadowPixels;
+                 p ++ ) {
 
-    newStrip = &( mx_spriteStrips[ newStripHandle ] );
+                long  a;
+            
+                b += 3;
+                
+                a = mx_spriteBytes[ b ];
+                
+                if( a != 0 ) {
 
-    if( ! exists ) {
-        newStrip->numSubSprites = numSubSprites;
+                    a = ( a * factor ) /  100;
 
-        newStrip->startIndex = mx_numStripSubSprites;
+                    if( a > 255 ) {
+                        a = 255;
+                        }
+                    
+                    mx_spriteBytes[ b ] = (unsigned char)a;
+                    }
 
-        newStrip->heightPerSprite = inHeightPerSprite;
-    
-        mx_numStripSubSprites += numSubSprites;
-        }
-    else {
-        if( numSubSprites != newStrip->numSubSprites ) {
-            maxigin_logString( "Failed to hot re-load sprite strip because "
-                               "of size mismatch with old strip: ",
-                               mainSprite->bulkResourceName );
-            return -1;
+                b ++;
+                }
             }
-        }
-    
-    nextSubStartByte = mainSprite->startByte;
-    
-    bytesPerSubSprite = mainSprite->w * inHeightPerSprite * 4;
-    
-    for( i = 0;
-         i < numSubSprites;
-         i ++ ) {
+        else if( inDarkness < 0 ) {
 
-        int             subHandle;
-        MaxiginSprite  *subSprite;
+            long  factor  =  - inDarkness + 100;
+            
+            for( p = 0;
+                 p < numShadowPixels;
+                 p ++ ) {
 
-        if( ! exists ) {
-            subHandle = mx_numSprites;
+                long  a;
             
-            mx_numSprites ++;
+                b += 3;
+            
+                a = mx_spriteBytes[ b ];
 
-            mx_stripSubSprites[ i + newStrip->startIndex ] = subHandle;
-            }
-        else {
-            /* re-use existing sub-sprite, but point it at new data
-               from main sprite */
-            subHandle = mx_stripSubSprites[ i + newStrip->startIndex ];
-            }
-        
-        subSprite = &( mx_sprites[ subHandle ] );
+                a = ( a * 100 ) / factor;
 
-        subSprite->w = mainSprite->w;
+                mx_spriteBytes[ b ] = (unsigned char)a;
 
-        subSprite->h = inHeightPerSprite;
+                b ++;
+                }
+            }
 
-        subSprite->startByte = nextSubStartByte;
-
-        nextSubStartByte += bytesPerSubSprite;
-
-        subSprite->bulkResourceName[0] = '\0';
-
-        subSprite->pendingChange = 0;
 
-        subSprite->stripParentHandle = inMainSpriteHandle;
-        subSprite->stripIndex = i;
         
+        /* now apply bottom-to-top alpha ramp */
+        opaqueFirstY = shadowH;
+        opaqueLastY  = 0;
         
-        mx_recomputeSpriteAttributes( subHandle );
-
-        if( ! exists ) {
-            subSprite->glowSpriteHandle   = -1;
+        for( y = 0;
+             y < shadowH;
+             y ++ ) {
 
-            mx_initEmptyShadows( subHandle );
+            int  rowStart  =  y * shadowW * 4 + shadowStartByte;
             
-            subSprite->kerningTableIndex  = -1;
+            for( x = 0;
+                 x < shadowW;
+                 x ++ ) {
+
+                unsigned char  a  = mx_spriteBytes[ rowStart + x * 4 + 3 ];
+
+                if( a != 0 ) {
+                    if( y < opaqueFirstY ) {
+                        opaqueFirstY = y;
+                        }
+                    if( y > opaqueLastY ) {
+                        opaqueLastY = y;
+                        }
+                    }
+                }
             }
-        }
 
-    /* now that they are all pointing to the right spots in the new
-       parent sprite strip, we can regenerate glow sprites if needed.
+        /* tweak these based on top/bottom percentages */
 
-       If we do this inline in the loop above, the deletion of glow
-       sprites can cause our parent sprite strip to move,
-       causing later children to point to the wrong place */
+        opaqueSpan = opaqueLastY - opaqueFirstY;
 
-    for( i = 0;
-         i < numSubSprites;
-         i ++ ) {
+        topOffsetPixels    = ( inTopPercent    * opaqueSpan ) / 100;
+        bottomOffsetPixels = ( inBottomPercent * opaqueSpan ) / 100;
+
+        if( bottomOffsetPixels < topOffsetPixels ) {
+            bottomOffsetPixels = topOffsetPixels;
+            }
+
+        if( bottomOffsetPixels == topOffsetPixels ) {
+            /* span of at least 1 to avoid divide by zero */
+            bottomOffsetPixels += 1;
+            }
         
-        int             subHandle;
-        MaxiginSprite  *subSprite;
+        opaqueLastY  = (int)( opaqueFirstY + bottomOffsetPixels );
+        opaqueFirstY = (int)( opaqueFirstY + topOffsetPixels );
 
-        subHandle = mx_stripSubSprites[ i + newStrip->startIndex ];
-        subSprite = &( mx_sprites[ subHandle ] );
+        opaqueSpan = opaqueLastY - opaqueFirstY;
         
-        if( subSprite->glowSpriteHandle != -1 ) {
-            mx_regenerateGlowSprite(
-                subHandle,
-                subSprite->glowRadius,
-                subSprite->glowIterations );
-            }
-        if( subSprite->numShadows > 0 ) {
+        
+        for( y = 0;
+             y < shadowH;
+             y ++ ) {
 
-            int  si;
+            int  rowStart  =  y * shadowW * 4 + shadowStartByte;
 
-            for( si = 0;
-                 si < subSprite->numShadows;
-                 si ++ ) {
-                
-                mx_regenerateDropShadowSprite(
-                    subHandle,
-                    si,
-                    subSprite->shadowRadius       [si],
-                    subSprite->shadowIterations   [si],
-                    subSprite->shadowBottomAlpha  [si],
-                    subSprite->shadowTopAlpha     [si],
-                    subSprite->shadowBottomPercent[si],
-                    subSprite->shadowTopPercent   [si],
-                    subSprite->shadowDarkness     [si],
-                    subSprite->shadowGrayValue    [si] );
+            /* using longs here prevents overflow */
+            long rowAlpha;
+
+
+            if( y >= opaqueFirstY
+                &&
+                y <= opaqueLastY ) {
+
+                rowAlpha =  ( alphaSpan * ( y - opaqueFirstY ) )
+                              /
+                              opaqueSpan
+                              +
+                              inTopAlpha;
+                }
+            else if( y < opaqueFirstY ) {
+                rowAlpha = inTopAlpha;
+                }
+            else {
+                rowAlpha = inBottomAlpha;
+                }
+             
+            for( x = 0;
+                 x < shadowW;
+                 x ++ ) {
+
+                int            rowI  =  rowStart + x * 4 + 3;
+
+                unsigned char  a     =  mx_spriteBytes[ rowI ];
+
+                if( a != 0 ) {
+                    
+                    mx_spriteBytes[ rowI ]  =
+                        (unsigned char) ( ( a * rowAlpha ) / 255 );
+                    }
                 }
             }
-        if( subSprite->kerningTableIndex != -1 ) {
-            mx_regenerateSpriteKerning( subHandle );
-            }
-        }
 
-    mainSprite->stripChildHandle = newStripHandle;
-    
-    return newStripHandle;
-    }
+        
 
+        shadowCacheDataWriteHandle =
+            mingin_startWritePersistData( shadowSpriteDataName );
 
+        if( shadowCacheDataWriteHandle == -1 ) {
+            maxigin_logString( "Failed to open persistent "
+                               "data cache file for writing: ",
+                               shadowSpriteDataName );
+            return;
+            }
 
-int maxigin_getNumSpritesInStrip( int  inSpriteStripHandle ) {
-    return mx_spriteStrips[ inSpriteStripHandle ].numSubSprites;
-    }
+        
+        mingin_writePersistData( shadowCacheDataWriteHandle,
+                                 MAXIGIN_SPRITE_HASH_LENGTH,
+                                 mainSprite->hash );
 
+        /* next radius and iteration count as padded ints
+           also alpha parameters */
+        
+        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
+                                            inBlurRadius );
+        
+        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
+                                            inBlurIterations );
+        
+        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
+                                            inBottomAlpha );
 
+        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
+                                            inTopAlpha );
+        
+        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
+                                            inBottomPercent );
 
-int maxigin_getSpriteFromStrip( int  inSpriteStripHandle,
-                                int  inSpriteIndex ) {
-    return mx_stripSubSprites[
-        mx_spriteStrips[ inSpriteStripHandle ].startIndex + inSpriteIndex ];
-    }
+        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
+                                            inTopPercent );
 
+        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
+                                            inDarkness );
 
+        mx_writePaddedIntToPerisistentData( shadowCacheDataWriteHandle,
+                                            inGrayValue );
+        
+        mx_writeSpriteToOpenData( shadowSpriteHandle,
+                                  shadowCacheDataWriteHandle );
 
-void maxigin_getSpriteDimensions( int   inSpriteHandle,
-                                  int  *outWide,
-                                  int  *outHigh ) {
-    
-    MaxiginSprite *s  =  &( mx_sprites[ inSpriteHandle ] );
 
-    *outWide = s->w;
-    *outHigh = s->h;
+        if( ! mingin_endWritePersistData( shadowCacheDataWriteHandle ) ) {
+            /* don't leave a cut-off cache behind */
+            maxigin_logString( "Failed to write persistent "
+                               "data cache file: ",
+                               shadowSpriteDataName );
+            mingin_deletePersistData( shadowSpriteDataName );
+            }
+        }
+    
     }
 
 
 
-void maxigin_initMakeGlowSpriteStrip( int  inSpriteStripHandle,
-                                      int  inBlurRadius,
-                                      int  inBlurIterations ) {
-
-    int  numSubSprites;
-    int  i;
+void maxigin_initMakeDropShadowSprite( int            inSpriteHandle,
+                                       int            inBlurRadius,
+                                       int            inBlurIterations,
+                                       unsigned char  inBottomAlpha,
+                                       unsigned char  inTopAlpha,
+                                       unsigned char  inBottomPercent,
+                                       unsigned char  inTopPercent,
+                                       int            inDarkness,
+                                       unsigned char  inGrayValue ) {
 
+    int  newShadowIndex;
     
-    if( inSpriteStripHandle < 0 ) {
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call maxigin_initMakeDropShadowSprite "
+                    "from outside of maxiginGame_init\n" );
         return;
         }
-    
-    numSubSprites = mx_spriteStrips[ inSpriteStripHandle ].numSubSprites;
-    
-    for( i = 0;
-         i < numSubSprites;
-         i ++ ) {
-        
-        int  subSpriteHandle  =
-            mx_stripSubSprites[
-                mx_spriteStrips[ inSpriteStripHandle ].startIndex + i ];
 
-        maxigin_initMakeGlowSprite( subSpriteHandle,
-                                    inBlurRadius,
-                                    inBlurIterations );
+    if( inSpriteHandle < 0 ) {
+        return;
         }
-    }
-
 
+    if( mx_spriteCacheLoaded ) {
+        /* skip generating shadow sprite */
+        /* advance next sprite handle */
+        mx_nextCachedSpriteHandle ++;
+        return;
+        }
 
-void maxigin_initMakeDropShadowSpriteStrip( int            inSpriteStripHandle,
-                                            int            inBlurRadius,
-                                            int            inBlurIterations,
-                                            unsigned char  inBottomAlpha,
-                                            unsigned char  inTopAlpha,
-                                            unsigned char  inBottomPercent,
-                                            unsigned char  inTopPercent,
-                                            int            inDarkness,
-                                            unsigned char  inGrayValue ) {
-
-    int  numSubSprites;
-    int  i;
+    newShadowIndex = mx_sprites[ inSpriteHandle ].numShadows;
 
-    
-    if( inSpriteStripHandle < 0 ) {
+    if( newShadowIndex >= MAXIGIN_MAX_NUM_DROP_SHADOWS ) {
+        maxigin_logInt( "Game tried to call maxigin_initMakeDropShadowSprite "
+                        "on a sprite that already has too many drop shadows: ",
+                        newShadowIndex );
         return;
         }
     
-    numSubSprites = mx_spriteStrips[ inSpriteStripHandle ].numSubSprites;
+    mx_startProfilePhase( "makeDropShadowSprites" );
     
-    for( i = 0;
-         i < numSubSprites;
-         i ++ ) {
-        
-        int  subSpriteHandle  =
-            mx_stripSubSprites[
-                mx_spriteStrips[ inSpriteStripHandle ].startIndex + i ];
+    mx_regenerateDropShadowSprite( inSpriteHandle,
+                                   newShadowIndex,
+                                   inBlurRadius,
+                                   inBlurIterations,
+                                   inBottomAlpha,
+                                   inTopAlpha,
+                                   inBottomPercent,
+                                   inTopPercent,
+                                   inDarkness,
+                                   inGrayValue );
+    
+    mx_endProfilePhase();
 
-        maxigin_initMakeDropShadowSprite( subSpriteHandle,
-                                          inBlurRadius,
-                                          inBlurIterations,
-                                          inBottomAlpha,
-                                          inTopAlpha,
-                                          inBottomPercent,
-                                          inTopPercent,
-                                          inDarkness,
-                                          inGrayValue );
+    if( mx_sprites[ inSpriteHandle ].shadowSpriteHandle[ newShadowIndex ]
+        != -1 ) {
+        /* success */
+        mx_sprites[ inSpriteHandle ].numShadows ++;
         }
     }
 
 
 
-static  char  mx_additiveBlend  =  0;
-
+static void mx_mapPixel( unsigned char  *inPixelPointer,
+                         unsigned char  *inColorMapStart,
+                         int             inColorMapW,
+                         int             inColorMapDestRow ) {
 
+    int  destCol  =  -1;
+    int  c;
+    int  cb;
+    
+    for( c = 0;
+         c < inColorMapW;
+         c ++ ) {
 
-void maxigin_drawToggleAdditive( char  inAdditiveOn ) {
-    mx_additiveBlend = inAdditiveOn;
-    }
+        cb = c * 4;
 
+        if( inPixelPointer[0] == inColorMapStart[ cb     ]
+            &&
+            inPixelPointer[1] == inColorMapStart[ cb + 1 ]
+            &&
+            inPixelPointer[2] == inColorMapStart[ cb + 2 ] ) {
 
+            /* hit! */
+            destCol = c;
+            break;
+            }
+        }
 
-char maxigin_drawGetAdditive( void ) {
-    return mx_additiveBlend;
-    }
+    if( destCol == -1 ) {
+        /* color not found in source row, leave it alone */
+        return;
+        }
 
+    cb = inColorMapDestRow * inColorMapW * 4 + destCol * 4;
 
+    inPixelPointer[0] = inColorMapStart[ cb     ];
+    inPixelPointer[1] = inColorMapStart[ cb + 1 ];
+    inPixelPointer[2] = inColorMapStart[ cb + 2 ];
+    }
 
 
 
+void maxigin_applyColorMap( int  inSpriteHandle,
+                            int  inColorMapHandle,
+                            int  inColorMapRow ) {
 
+    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle   ] );
+    MaxiginSprite  *c  =  &( mx_sprites[ inColorMapHandle ] );
 
-static MaxiginColor  mx_drawColor  =  { { 255, 255, 255, 255 } };
+    int             n  =  s->w * s->h;
+    int             i;
+    unsigned char  *spriteBytes    =  &( mx_spriteBytes[ s->startByte ] );
+    unsigned char  *colorMapBytes  =  &( mx_spriteBytes[ c->startByte ] );
 
+    if( s->numPaletteColors > 0 ) {
+        /* map palette colors instead of pixels */
+        spriteBytes  =  &( spriteBytes[ n ] );
+        n            =  s->numPaletteColors;
+        }
+    
+    for( i = 0;
+         i < n;
+         i ++ ) {
 
-void maxigin_drawSetColor( unsigned char  inRed,
-                           unsigned char  inGreen,
-                           unsigned char  inBlue,
-                           unsigned char  inAlpha ) {
+        mx_mapPixel( &( spriteBytes[ i * 4 ] ),
+                     colorMapBytes,
+                     c->w,
+                     inColorMapRow );
+        }
 
-    mx_drawColor.comp.red    =  inRed;
-    mx_drawColor.comp.green  =  inGreen;
-    mx_drawColor.comp.blue   =  inBlue;
-    mx_drawColor.comp.alpha  =  inAlpha;
+    s->colorMapHandle = inColorMapHandle;
+    s->colorMapRow    = inColorMapRow;
     
+    c->isColorMap     = 1;
     }
 
 
 
-void maxigin_drawGetColor( unsigned char  *outRed,
-                           unsigned char  *outGreen,
-                           unsigned char  *outBlue,
-                           unsigned char  *outAlpha ) {
-    *outRed   = mx_drawColor.comp.red;
-    *outGreen = mx_drawColor.comp.green;
-    *outBlue  = mx_drawColor.comp.blue;
-    *outAlpha = mx_drawColor.comp.alpha;
+/*
+  Key that a pixel's palette color is found by, with inDropBits low bits
+  of each channel dropped.
+  Alpha is offset by one so that fully transparent pixels get a key
+  of their own.
+*/
+static void mx_getPaletteKey( const unsigned char  *inRGBA,
+                              int                   inDropBits,
+                              int                  *outKey ) {
+    
+    outKey[0] = inRGBA[0] >> inDropBits;
+    outKey[1] = inRGBA[1] >> inDropBits;
+    outKey[2] = inRGBA[2] >> inDropBits;
+    outKey[3] = 0;
+
+    if( inRGBA[3] != 0 ) {
+        outKey[3] = ( inRGBA[3] >> inDropBits ) + 1;
+        }
     }
 
 
 
-void maxigin_drawSetAlpha( unsigned char  inAlpha ) {
-    
-    mx_drawColor.comp.alpha  =  inAlpha;
+/*
+  Finds index of inKey in inKeys, adding it if there's room.
 
-    }
+  Returns -1 if inKey isn't there and inKeys already holds 256 keys.
+*/
+static int mx_findPaletteKey( int        *inKeys,
+                              int        *inOutNumKeys,
+                              const int  *inKey ) {
+    int  c;
+
+    for( c = 0;
+         c < *inOutNumKeys;
+         c ++ ) {
+
+        if( inKeys[ c * 4     ] == inKey[0]
+            &&
+            inKeys[ c * 4 + 1 ] == inKey[1]
+            &&
+            inKeys[ c * 4 + 2 ] == inKey[2]
+            &&
+            inKeys[ c * 4 + 3 ] == inKey[3] ) {
+            return c;
+            }
+        }
 
+    if( c == 256 ) {
+        return -1;
+        }
 
+    inKeys[ c * 4     ] = inKey[0];
+    inKeys[ c * 4 + 1 ] = inKey[1];
+    inKeys[ c * 4 + 2 ] = inKey[2];
+    inKeys[ c * 4 + 3 ] = inKey[3];
 
-void maxigin_drawResetColor( void ) {
-    mx_drawColor.comp.red    =  255;
-    mx_drawColor.comp.green  =  255;
-    mx_drawColor.comp.blue   =  255;
-    mx_drawColor.comp.alpha  =  255;
+    *inOutNumKeys = c + 1;
+    
+    return c;
     }
 
 
 
 /*
-  rgb in  0..255
-  h   in  0..36000
-  s   in  0..10000
-  v   in  0..10000
+  Multiplies a glow sprite's colors by their alpha, and makes every pixel
+  either opaque or fully transparent.
+
+  Glows are always drawn additively, which adds color times alpha, so
+  this draws the same, but leaves far fewer distinct colors, since faint
+  pixels all end up near black.
 */
-static void mx_convertRGBToHSV( unsigned char   inR,
-                                unsigned char   inG,
-                                unsigned char   inB,
-                                long           *outH,
-                                long           *outS,
-                                long           *outV ) {
-        
-    /* based on forumula found here:
-       
-       https://www.rapidtables.com/convert/color/rgb-to-hsv.html
+static void mx_premultiplyGlowSprite( int  inSpriteHandle ) {
+    
+    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle ] );
+    int             n  =  s->w * s->h;
+    int             i;
+    unsigned char  *bytes;
 
-       Translated these formulas into fixed-point math.
-    */
+    if( s->numPaletteColors > 0
+        ||
+        s->startByte == -1 ) {
+        return;
+        }
 
+    bytes = &( mx_spriteBytes[ s->startByte ] );
     
-    long  h    =  0;   /* in range 0.. 36,000 */
-    long  s    =  0;   /* in range 0.. 10,000 */
-    long  v    =  0;   /* in range 0.. 10,000 */
-    
-    long  r    =  inR;
-    long  g    =  inG;
-    long  b    =  inB;
+    for( i = 0;
+         i < n;
+         i ++ ) {
 
-    long  min  =  r;
-    long  max  =  r;
+        unsigned char  *p  =  &( bytes[ i * 4 ] );
+        int             a  =  p[3];
+        int             k;
 
-    long  d;
-    
-    if( g > max ) {
-        max = g;
-        }
-    if( b > max ) {
-        max = b;
-        }
-    
-    if( g < min ) {
-        min = g;
-        }
-    if( b < min ) {
-        min = b;
+        for( k = 0;
+             k < 3;
+             k ++ ) {
+            p[k] = (unsigned char)( ( p[k] * a + 127 ) / 255 );
+            }
+
+        if( p[0] == 0 && p[1] == 0 && p[2] == 0 ) {
+            p[3] = 0;
+            }
+        else {
+            p[3] = 255;
+            }
         }
+    }
 
-    d = max - min;
 
-    /* round with  + 127 */
-    v = ( 10000 * max + 127 ) / 255;
+
+/*
+  Repacks a sprite's RGBA pixels as palette indices, merging colors that
+  match after dropping up to inMaxDropBits low bits of each channel, as
+  few as possible.  Merged colors are averaged.
+
+  Does nothing if the sprite has too many colors, or if repacking wouldn't
+  save any bytes.
+*/
+static void mx_repackSpriteAsPalette( int  inSpriteHandle,
+                                      int  inMaxDropBits ) {
+
+    /* keys and color sums, built here before the palette is put
+       after the pixels */
+    static  int            keys[ 256 * 4 ];
+    static  unsigned long  sums[ 256 * 4 ];
+    static  unsigned long  counts[ 256 ];
+    
+    MaxiginSprite  *s          =  &( mx_sprites[ inSpriteHandle ] );
+    int             numColors  =  0;
+    int             n          =  s->w * s->h;
+    int             dropBits;
+    int             i;
+    int             c;
+    int             key[4];
+    unsigned char  *bytes;
     
-    if ( d == 0 ) {
-        /* This is a gray, no chroma */
-        h = 0;
-        s = 0;
+    if( s->numPaletteColors > 0
+        ||
+        s->startByte == -1
+        ||
+        s->stripParentHandle != -1
+        ||
+        s->stripChildHandle != -1 ) {
+        /* already repacked, or shares data with a strip */
+        return;
         }
-    else {
-        /* chroma present */
 
-        long  halfD  =  d / 2;
-        
-
-        if( max > 0 ) {
-            long  halfMax  =  max / 2;
+    bytes = &( mx_spriteBytes[ s->startByte ] );
 
-            /* round with  + halfMax */
-            s = ( 10000 * d + halfMax ) / max;
-            }
-        else {
-            s = 0;
-            }
+    /* find fewest dropped bits that fit in a palette */
+    for( dropBits = 0;
+         dropBits <= inMaxDropBits;
+         dropBits ++ ) {
 
-        if( d == 0 ) {
-            h = 0;
-            }
-        else if( r == max )  {
-            /* round with  + halfD */
-            h =         ( ( g - b ) * 6000 + halfD ) / d;
-            }
-        else if( g == max ) {
-            h = 12000 + ( ( b - r ) * 6000 + halfD ) / d;
-            }
-        else if ( b == max ) {
-            h = 24000 + ( ( r - g ) * 6000 + halfD ) / d;
-            }
+        numColors = 0;
         
+        for( i = 0;
+             i < n;
+             i ++ ) {
 
-        while( h < 0 ) {
-            h += 36000;
+            mx_getPaletteKey( &( bytes[ i * 4 ] ),
+                              dropBits,
+                              key );
+
+            if( mx_findPaletteKey( keys,
+                                   &numColors,
+                                   key ) == -1 ) {
+                break;
+                }
             }
 
-        /* don't ever let h be 36000 */
-        while( h >= 36000 ) {
-            h -= 36000;
+        if( i == n ) {
+            break;
             }
         }
 
+    if( dropBits > inMaxDropBits ) {
+        /* too many colors, leave as RGBA */
+        return;
+        }
 
-    *outH = h;
-    *outS = s;
-    *outV = v;
-    }
-
+    if( n + numColors * 4 >= n * 4 ) {
+        /* palette too big to save anything */
+        return;
+        }
 
+    for( c = 0;
+         c < numColors * 4;
+         c ++ ) {
+        sums[c] = 0;
+        }
+    for( c = 0;
+         c < numColors;
+         c ++ ) {
+        counts[c] = 0;
+        }
 
-/*
-  h   in  0..36000
-  s   in  0..10000
-  v   in  0..10000
-  rgb in  0..255
-*/
-static void mx_convertHSVToRGB( long           inH,
-                                long           inS,
-                                long           inV,
-                                unsigned char  *outR,
-                                unsigned char  *outG,
-                                unsigned char  *outB ) {
-    long  r;
-    long  g;
-    long  b;
-    
-    if( inS == 0 ) {
-        /* round with  + 5000 */
-        long  gray  =  ( inV * 255 + 5000 ) / 10000;
+    /* indices can be written in place, since index i never lands
+       past the RGBA bytes of pixel i, which we've already read */
         
-        r = gray;                      
-        g = gray;
-        b = gray;
-        }
-    else {
+    for( i = 0;
+         i < n;
+         i ++ ) {
 
-        /* round with  + 5000 */
-        long  c     =  ( inV * inS + 5000 ) / 10000;
-        long  m     =  inV - c;
+        int  k;
         
-        long  hBin  =  inH / 6;
+        mx_getPaletteKey( &( bytes[ i * 4 ] ),
+                          dropBits,
+                          key );
 
-        long  hMod  =  ( hBin % 2000 ) - 1000;
-        long  x;
-        long  r2;
-        long  g2;
-        long  b2;
+        c = mx_findPaletteKey( keys,
+                               &numColors,
+                               key );
         
-        if( hMod < 0 ) {
-            hMod = -hMod;
+        for( k = 0;
+             k < 4;
+             k ++ ) {
+            sums[ c * 4 + k ] += bytes[ i * 4 + k ];
             }
+        counts[c] ++;
+        
+        bytes[ i ] = (unsigned char)c;
+        }
 
-        /* round with  + 500 */
-        x = ( c * (1000 - hMod ) + 500 ) / 1000;
+    /* palette goes right after the indices, rounded averages of
+       the colors that share each key, which are exact if none were
+       dropped */
+    for( c = 0;
+         c < numColors;
+         c ++ ) {
 
+        int  k;
 
-        if( inH < 6000 ) {
-            r2 = c;
-            g2 = x;
-            b2 = 0;
-            }
-        else if( inH < 12000 ) {
-            r2 = x;
-            g2 = c;
-            b2 = 0;
-            }
-        else if( inH < 18000 ) {
-            r2 = 0;
-            g2 = c;
-            b2 = x;
-            }
-        else if( inH < 24000 ) {
-            r2 = 0;
-            g2 = x;
-            b2 = c;
-            }
-        else if( inH < 30000 ) {
-            r2 = x;
-            g2 = 0;
-            b2 = c;
-            }
-        else {
-            r2 = c;
-            g2 = 0;
-            b2 = x;
+        for( k = 0;
+             k < 4;
+             k ++ ) {
+            
+            bytes[ n + c * 4 + k ] =
+                (unsigned char)( ( sums[ c * 4 + k ] + counts[c] / 2 )
+                                 / counts[c] );
             }
-
-        /* round with  + 5000 */
-        r = ( ( r2 + m ) * 255 + 5000 ) / 10000;
-        g = ( ( g2 + m ) * 255 + 5000 ) / 10000;
-        b = ( ( b2 + m ) * 255 + 5000 ) / 10000;
         }
 
-    *outR = (unsigned char)r;
-    *outG = (unsigned char)g;
-    *outB = (unsigned char)b;
-    }
+    /* collapse while sprite is still RGBA, so that its old size
+       is used */
+    mx_collapseSpriteData( inSpriteHandle,
+                           n + numColors * 4 );
 
+    s->numPaletteColors = numColors;
+    }
 
-                         
 
-int maxigin_drawGetColorSaturation( void ) {
 
-    long  h;
-    long  s;
-    long  v;
-    
-    mx_convertRGBToHSV( mx_drawColor.comp.red,
-                        mx_drawColor.comp.green,
-                        mx_drawColor.comp.blue,
-                        &h,
-                        &s,
-                        &v );
+void maxigin_initPaletteSprite( int  inSpriteHandle ) {
     
-    return (int)s;
-    }
-
+    MaxiginSprite  *s;
+    int             i;
 
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call maxigin_initPaletteSprite "
+                    "from outside of maxiginGame_init\n" );
+        return;
+        }
 
-void maxigin_drawSetColorSaturation( int  inSaturation ) {
+    if( inSpriteHandle < 0 ) {
+        return;
+        }
 
-    /* convert to HSV, adjust S, and convert back */
+    if( mx_spriteCacheLoaded ) {
+        /* sprite data already repacked in cache */
+        return;
+        }
 
-    long  h;
-    long  s;
-    long  v;
-    
-    mx_convertRGBToHSV( mx_drawColor.comp.red,
-                        mx_drawColor.comp.green,
-                        mx_drawColor.comp.blue,
-                        &h,
-                        &s,
-                        &v );
-                        
+    s = &( mx_sprites[ inSpriteHandle ] );
 
-    /* now adjust saturation */
+    mx_startProfilePhase( "paletteSprites" );
 
-    s = inSaturation;
+    if( s->glowSpriteHandle != -1 ) {
+        /* glows are added on top, so close colors look the same */
+        mx_premultiplyGlowSprite( s->glowSpriteHandle );
+        
+        mx_repackSpriteAsPalette( s->glowSpriteHandle,
+                                  MAXIGIN_GLOW_PALETTE_MAX_DROP_BITS );
+        }
 
+    for( i = 0;
+         i < s->numShadows;
+         i ++ ) {
+        
+        mx_repackSpriteAsPalette( s->shadowSpriteHandle[i],
+                                  0 );
+        }
 
-    /* now convert back */
+    mx_repackSpriteAsPalette( inSpriteHandle,
+                              0 );
 
-    mx_convertHSVToRGB( h,
-                        s,
-                        v,
-                        &( mx_drawColor.comp.red ),
-                        &( mx_drawColor.comp.green ),
-                        &( mx_drawColor.comp.blue ) );
+    mx_endProfilePhase();
     }
 
 
 
-void maxigin_drawBaseSprite( int  inSpriteHandle,
-                             int  inCenterX,
-                             int  inCenterY ) {
+#define  MAXIGIN_NUM_STATIC_SLIDER_BARS  10
 
-    int  startImageX;
-    int  startImageY;
-    int  endImageX;
-    int  endImageY;
-    
-    int  startSpriteX;
-    int  startSpriteY;
-    int  endSpriteX;
-    int  endSpriteY;
-    
-    int  x;
-    int  y;
-    int  imY;
-    
-    int  w;
-    int  h;
-    int  imW;
-    int  imH;
-    
-    int  startByte;
+typedef struct MaxiginSliderSprites {
 
-    char drawAlphaSet;
-    char drawColorSet;
+        /* index 0 for empty, 1 for full */
+        int  left  [2];
+        int  right [2];
+        int  bar   [2];
+        int  sliver[2];
 
-    int  clipStartX     =  0;
-    int  clipEndX       =  MAXIGIN_GAME_NATIVE_W - 1;
-    int  clipStartY     =  0;
-    int  clipEndY       =  MAXIGIN_GAME_NATIVE_H - 1;
-    
-    
-    if( ! mx_areWeInMaxiginGameDrawFunction ) {
+        int  numFullBars;
+        int  fullBars[ MAXIGIN_NUM_STATIC_SLIDER_BARS ];
+        
+        /* index 0 for cold, 1 for hot, 2 for active */
+        int  thumb [3];
 
-        mingin_log( "Game tried to call maxigin_drawSprite "
-                    "from outside of maxiginGame_getNativePixels\n" );
-        return;
-        }
+        int  loop  [2];
+        
+    } MaxiginSliderSprites;
 
-    if( inSpriteHandle == -1 ) {
-        /* trying to draw a sprite that failed to load
-           draw a place-holder rect so that it's not totally invisible*/
 
-        maxigin_drawRect( inCenterX - 3,
-                          inCenterY - 3,
-                          inCenterX + 3,
-                          inCenterY + 3 );
+char                   mx_sliderSpritesSet  =  0;
+MaxiginSliderSprites   mx_sliderSprites;
 
-        maxigin_drawLine( inCenterX - 2,
-                          inCenterY - 2,
-                          inCenterX + 2,
-                          inCenterY + 2 );
-        return;
+
+static void mx_clearSliderSprites( void ) {
+    int  i;
+
+    mx_sliderSprites.numFullBars = 0;
+    
+    for( i = 0;
+         i < 2;
+         i ++ ) {
+        mx_sliderSprites.left  [i] = -1;
+        mx_sliderSprites.right [i] = -1;
+        mx_sliderSprites.bar   [i] = -1;
+        mx_sliderSprites.sliver[i] = -1;
+        mx_sliderSprites.loop  [i] = -1;
         }
     
-    if( inSpriteHandle >= mx_numSprites ) {
-        maxigin_logInt( "Game tried to draw an unknown sprite handle: ",
-                        inSpriteHandle );
+    for( i = 0;
+         i < 3;
+         i ++ ) {
+        mx_sliderSprites.thumb[i] = -1;
         }
+    }
 
-    
-    drawAlphaSet = 0;
 
-    if( mx_drawColor.comp.alpha < 255 ) {
-        drawAlphaSet = 1;
-        
-        if( mx_drawColor.comp.alpha == 0 ) {
 
-            /* draw alpha of 0 means sprite is invisible, skip it */
-            return;
-            }
-        }
+void maxigin_initSliderSprites( const char  *inLeftEndEmptySpriteResource,
+                                const char  *inLeftEndFullSpriteResource,
+                                const char  *inRightEndEmptySpriteResource,
+                                const char  *inRightEndFullSpriteResource,
+                                const char  *inMiddleBarEmptySpriteResource,
+                                const char  *inMiddleBarFullSpriteResource,
+                                const char  *inMiddleSliverEmptySpriteResource,
+                                const char  *inMiddleSliverFullSpriteResource,
+                                const char  *inThumbSpriteResource,
+                                const char  *inThumbHotSpriteResource,
+                                const char  *inThumbActiveSpriteResource,
+                                const char  *inLoopStartSpriteResource,
+                                const char  *inLoopEndSpriteResource ) {
 
-    drawColorSet = 0;
-
-    if( mx_drawColor.comp.red < 255
-        ||
-        mx_drawColor.comp.green < 255
-        ||
-        mx_drawColor.comp.blue < 255 ) {
-        
-        drawColorSet = 1;
-        }
+    mx_clearSliderSprites();
     
+    mx_sliderSprites.left[ 0 ] =
+        maxigin_initSprite( inLeftEndEmptySpriteResource );
     
-    w             =  mx_sprites[ inSpriteHandle ].w;
-    h             =  mx_sprites[ inSpriteHandle ].h;
-    startByte     =  mx_sprites[ inSpriteHandle ].startByte;
+    mx_sliderSprites.left[ 1 ] =
+        maxigin_initSprite( inLeftEndFullSpriteResource );
+
+
+    mx_sliderSprites.right[ 0 ] =
+        maxigin_initSprite( inRightEndEmptySpriteResource );
+
+    mx_sliderSprites.right[ 1 ] =
+        maxigin_initSprite( inRightEndFullSpriteResource );
 
-    imW           =  MAXIGIN_GAME_NATIVE_W;
-    imH           =  MAXIGIN_GAME_NATIVE_H;
     
-    startImageX   =  inCenterX - w / 2;
-    startImageY   =  inCenterY - h / 2;
-    endImageX     =  startImageX + w;
-    endImageY     =  startImageY + h;
+    mx_sliderSprites.bar[ 0 ] =
+        maxigin_initSprite( inMiddleBarEmptySpriteResource );
 
-    startSpriteX  =  0;
-    startSpriteY  =  0;
-    endSpriteX    =  w;
-    endSpriteY    =  h;
+    mx_sliderSprites.bar[ 1 ] =
+        maxigin_initSprite( inMiddleBarFullSpriteResource );
 
-    /* handle case where sprite is cut off by edge of game image */
 
-    /* also consider clipping rectangle */
-    if( mx_clipStackDepth > 0 ) {
-        int                    clipI  =  mx_clipStackDepth - 1;
-        MaxiginClipRectangle  *clip   =  &( mx_clipStack[ clipI ] );
-        
-        clipStartX = clip->startX;
-        clipEndX = clip->endX;
-        clipStartY = clip->startY;
-        clipEndY = clip->endY;
-        }
-        
+    mx_sliderSprites.sliver[ 0 ] =
+        maxigin_initSprite( inMiddleSliverEmptySpriteResource );
 
-    if( startImageX < clipStartX ) {
-        startSpriteX += clipStartX - startImageX;
-        startImageX = clipStartX;
-        }
-    if( startImageY < clipStartY ) {
-        startSpriteY += clipStartY - startImageY;
-        startImageY = clipStartY;
-        }
+    mx_sliderSprites.sliver[ 1 ] =
+        maxigin_initSprite( inMiddleSliverFullSpriteResource );
 
-    if( endImageX > clipEndX + 1 ) {
-        endSpriteX -= ( endImageX - ( clipEndX + 1 ) );
-        }
-    if( endImageY > clipEndY + 1 ) {
-        endSpriteY -= ( endImageY - ( clipEndY + 1 ) );
-        }
 
-    if( startImageX >= imW
-        ||
-        startImageY >= imH
-        ||
-        endImageX   <=  0
-        ||
-        endImageY   <=  0 ) {
+    mx_sliderSprites.thumb[ 0 ] =
+        maxigin_initSprite( inThumbSpriteResource );
 
-        /* sprite drawn completely out of bounds, affecting no pixels at all */
-        return;
-        }
-    
-    
-    imY = startImageY;
-    
-    for( y = startSpriteY;
-         y < endSpriteY;
-         y ++ ) {
+    mx_sliderSprites.thumb[ 1 ] =
+        maxigin_initSprite( inThumbHotSpriteResource );
 
-        int spriteByte  =  startByte  +    y * 4 *   w   +  4 * startSpriteX;
-        int imageByte   =                imY * 3 * imW   +  3 * startImageX;
+    mx_sliderSprites.thumb[ 2 ] =
+        maxigin_initSprite( inThumbActiveSpriteResource );
 
-        if( mx_additiveBlend ) {
-            /* different row loop for additive blending */
+    mx_sliderSprites.loop[ 0 ] =
+        maxigin_initSprite( inLoopStartSpriteResource );
 
-            for( x = startSpriteX;
-                 x < endSpriteX;
-                 x ++ ) {
+    mx_sliderSprites.loop[ 1 ] =
+        maxigin_initSprite( inLoopEndSpriteResource );
+    
 
-                unsigned char  r;
-                unsigned char  g;
-                unsigned char  b;
-                unsigned char  a  =  mx_spriteBytes[ spriteByte + 3 ];
-                
-                if( drawAlphaSet ) {
-                    a = (unsigned char)( ( a * mx_drawColor.comp.alpha ) / 255 );
-                    }
-                
-                if( a == 0 ) {
-                    imageByte += 3;
-                    spriteByte += 4;
-                    continue;
-                    }
+    mx_sliderSpritesSet =
+        ( mx_sliderSprites.left[ 0 ]   >= 0 )
+        &&
+        ( mx_sliderSprites.left[ 1 ]   >= 0 )
+        &&
+        ( mx_sliderSprites.right[ 0 ]  >= 0 )
+        &&
+        ( mx_sliderSprites.right[ 1 ]  >= 0 )
+        &&
+        ( mx_sliderSprites.bar[ 0 ]    >= 0 )
+        &&
+        ( mx_sliderSprites.bar[ 1 ]    >= 0 )
+        &&
+        ( mx_sliderSprites.sliver[ 0 ] >= 0 )
+        &&
+        ( mx_sliderSprites.sliver[ 1 ] >= 0 )
+        &&
+        ( mx_sliderSprites.thumb[ 0 ]  >= 0 )
+        &&
+        ( mx_sliderSprites.thumb[ 1 ]  >= 0 )
+        &&
+        ( mx_sliderSprites.thumb[ 2 ]  >= 0 )
+        &&
+        ( mx_sliderSprites.loop[ 0 ]   >= 0 )
+        &&
+        ( mx_sliderSprites.loop[ 1 ]   >= 0 );
+    }
 
-                r = mx_spriteBytes[ spriteByte ++ ];
-                g = mx_spriteBytes[ spriteByte ++ ];
-                b = mx_spriteBytes[ spriteByte ++ ];
 
-                if( drawColorSet ) {
-                    r = (unsigned char)( ( r * mx_drawColor.comp.red   ) / 255 );
-                    g = (unsigned char)( ( g * mx_drawColor.comp.green ) / 255 );
-                    b = (unsigned char)( ( b * mx_drawColor.comp.blue  ) / 255 );
-                    }
-                
-                if( a == 255 ) {
+void maxigin_initSliderSpritesStatic(
+    int           inNumBarSprites,
+    const char  **inBarSprites,
+    const char   *inThumbSpriteResource,
+    const char   *inThumbHotSpriteResource,
+    const char   *inThumbActiveSpriteResource,
+    const char   *inLoopStartSpriteResource,
+    const char   *inLoopEndSpriteResource ) {
 
-                    int  v;
+    int   i;
+    char  success;
 
-                    /* red */
-                    v = mx_gameImageBuffer[ imageByte  ] + r;
+    mx_clearSliderSprites();
+    
+    if( inNumBarSprites > MAXIGIN_NUM_STATIC_SLIDER_BARS ) {
+        maxigin_logInt( "Error:  maxigin_initSliderSpritesStatic called with "
+                        "too many bar sprites; ",
+                        inNumBarSprites );
+        inNumBarSprites = MAXIGIN_NUM_STATIC_SLIDER_BARS;
+        }
 
-                    if( v > 255 ) {
-                        v = 255;
-                        }
-                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+    mx_sliderSprites.numFullBars = inNumBarSprites;
 
-                    imageByte  ++;
+    success = 1;
+    
+    for( i = 0;
+         i < inNumBarSprites;
+         i ++ ) {
 
-                    /* green */
-                    v = mx_gameImageBuffer[ imageByte  ] + g;
+        mx_sliderSprites.fullBars[i] =
+            maxigin_initSprite( inBarSprites[i] );
+        
+        success =
+            success
+            &&
+            ( mx_sliderSprites.fullBars[i] >= 0 );
+        }
+    
 
-                    if( v > 255 ) {
-                        v = 255;
-                        }
-                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+    mx_sliderSprites.thumb[ 0 ] =
+        maxigin_initSprite( inThumbSpriteResource );
 
-                    imageByte  ++;
+    mx_sliderSprites.thumb[ 1 ] =
+        maxigin_initSprite( inThumbHotSpriteResource );
 
-                    /* blue */
-                    v = mx_gameImageBuffer[ imageByte  ] + b;
+    mx_sliderSprites.thumb[ 2 ] =
+        maxigin_initSprite( inThumbActiveSpriteResource );
 
-                    if( v > 255 ) {
-                        v = 255;
-                        }
-                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+    mx_sliderSprites.loop[ 0 ] =
+        maxigin_initSprite( inLoopStartSpriteResource );
 
-                    imageByte  ++;
-                    }
-                else {
-                    /* alpha blending */
+    mx_sliderSprites.loop[ 1 ] =
+        maxigin_initSprite( inLoopEndSpriteResource );
 
-                    int  v;
-                    
-                    /* red */
-                    v = mx_gameImageBuffer[ imageByte ]
-                        +
-                        ( r * a ) / 255;
-                    
-                    if( v > 255 ) {
-                        v = 255;
-                        }
-                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
-                
-                    imageByte  ++;
+    mx_sliderSpritesSet =
+        success
+        &&
+        ( mx_sliderSprites.thumb[ 0 ]  >= 0 )
+        &&
+        ( mx_sliderSprites.thumb[ 1 ]  >= 0 )
+        &&
+        ( mx_sliderSprites.thumb[ 2 ]  >= 0 )
+        &&
+        ( mx_sliderSprites.loop[ 0 ]   >= 0 )
+        &&
+        ( mx_sliderSprites.loop[ 1 ]   >= 0 );
+    }
 
-                    /* green */
-                    v = mx_gameImageBuffer[ imageByte ]
-                        +
-                        ( g * a ) / 255;
-                    
-                    if( v > 255 ) {
-                        v = 255;
-                        }
-                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
-                
-                    imageByte  ++;
 
-                    /* blue */
-                    v = mx_gameImageBuffer[ imageByte ]
-                        +
-                        ( b * a ) / 255;
-                    
-                    if( v > 255 ) {
-                        v = 255;
-                        }
-                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
-                
-                    imageByte  ++;
-                    }
-            
-                /* skip the alpha in the sprite
-                   dest image has no alpha channel */
-                spriteByte ++;
-                }
-            }
-        else {
-            /* non-additive blending row loop */
-            
-            for( x = startSpriteX;
-                 x < endSpriteX;
-                 x ++ ) {
-            
-                unsigned char  r;
-                unsigned char  g;
-                unsigned char  b;
-                unsigned char  a  =  mx_spriteBytes[ spriteByte + 3 ];
-
-                if( drawAlphaSet ) {
-                    a = (unsigned char)( ( a * mx_drawColor.comp.alpha ) / 255 );
-                    }
-                                
-                if( a == 0 ) {
-                    imageByte += 3;
-                    spriteByte += 4;
-                    continue;
-                    }
-
-                r = mx_spriteBytes[ spriteByte ++ ];
-                g = mx_spriteBytes[ spriteByte ++ ];
-                b = mx_spriteBytes[ spriteByte ++ ];
-
-                if( drawColorSet ) {
-                    r = (unsigned char)( ( r * mx_drawColor.comp.red   ) / 255 );
-                    g = (unsigned char)( ( g * mx_drawColor.comp.green ) / 255 );
-                    b = (unsigned char)( ( b * mx_drawColor.comp.blue  ) / 255 );
-                    }
-                
-                if( a == 255 ) {
-                    /* RGBA bytes */
-                    mx_gameImageBuffer[ imageByte  ++ ] = r;
 
-                    mx_gameImageBuffer[ imageByte  ++ ] = g;
-
-                    mx_gameImageBuffer[ imageByte  ++ ] = b;
-                    }
-                else {
-                    /* alpha blending */
+void maxigin_initMakeSliderGlow( int  inBlurRadius,
+                                 int  inBlurIterations ) {
+    int  i;
 
-                    /* red */
-                    mx_gameImageBuffer[ imageByte ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ imageByte ] * ( 255 - a )
-                              +
-                              r * a )
-                            /
-                            255 );
-                
-                    imageByte  ++;
+    /* don't apply glow to bar parts and slivers, because glow
+       doesn't tile nicely */
 
-                    /* green */
-                    mx_gameImageBuffer[ imageByte ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ imageByte ] * ( 255 - a )
-                              +
-                              g * a )
-                            /
-                            255 );
-                
-                    imageByte  ++;
+    for( i = 0;
+         i < mx_sliderSprites.numFullBars;
+         i ++ ) {
 
-                    /* blue */
-                    mx_gameImageBuffer[ imageByte ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ imageByte ] * ( 255 - a )
-                              +
-                              b * a )
-                            /
-                            255 );
-                
-                    imageByte  ++;
-                    }
-            
-                /* skip the alpha in the sprite
-                   dest image has no alpha channel */
-                spriteByte ++;
-                }
-            }
-        
-        imY ++;
+        maxigin_initMakeGlowSprite( mx_sliderSprites.fullBars[i],
+                                    inBlurRadius,
+                                    inBlurIterations );
         }
     
+    for( i = 0;
+         i < 3;
+         i ++ ) {
+        
+        maxigin_initMakeGlowSprite( mx_sliderSprites.thumb[i],
+                                    inBlurRadius,
+                                    inBlurIterations );
+        }
     }
 
 
 
-static void mx_drawGlowSprite( int  inSpriteHandle,
-                               int  inCenterX,
-                               int  inCenterY ) {
+#define  MAXIGIN_NUM_STATIC_PANELS  10
 
-    char  oldAdditive  =  maxigin_drawGetAdditive();
-    
-    maxigin_drawBaseSprite( inSpriteHandle,
-                            inCenterX,
-                            inCenterY );
 
-    if( mx_sprites[ inSpriteHandle ].glowSpriteHandle != -1 ) {
+typedef struct MaxiginPanelSprites {
 
-        maxigin_drawToggleAdditive( 1 );
+        /* tl, tr, bl, br */
+        int  corners[4];
+        
+        /* l, r, t, b */
+        int  sides  [4];
+        
+        int  fill;
 
-        maxigin_drawBaseSprite( mx_sprites[ inSpriteHandle ].glowSpriteHandle,
-                                inCenterX,
-                                inCenterY );
+        int  numFullPanels;
+        int  fullPanels[ MAXIGIN_NUM_STATIC_PANELS ];
 
-        maxigin_drawToggleAdditive( oldAdditive );
-        }
-    }
+        
+    } MaxiginPanelSprites;
 
 
+char                   mx_panelSpritesSet  =  0;
+MaxiginPanelSprites    mx_panelSprites;
 
-void maxigin_drawSprite( int  inSpriteHandle,
-                         int  inCenterX,
-                         int  inCenterY ) {
 
-    if( mx_sprites[ inSpriteHandle ].numShadows > 0 ) {
 
-        int           i;
-        MaxiginColor  oldColor  =  mx_drawColor;
+void maxigin_initPanelSprites( const char  *inTopLeftSpriteResource,
+                               const char  *inTopRightSpriteResource,
+                               const char  *inBottomLeftSpriteResource,
+                               const char  *inBottomRightSpriteResource,
+                               const char  *inLeftEdgeSpriteResource,
+                               const char  *inRightEdgeSpriteResource,
+                               const char  *inTopEdgeSpriteResource,
+                               const char  *inBottomEdgeSpriteResource,
+                               const char  *inFillSpriteResource ) {
+    mx_panelSprites.corners[0] =
+        maxigin_initSprite( inTopLeftSpriteResource );
+    
+    mx_panelSprites.corners[1] =
+        maxigin_initSprite( inTopRightSpriteResource );
+    
+    mx_panelSprites.corners[2] =
+        maxigin_initSprite( inBottomLeftSpriteResource );
+    
+    mx_panelSprites.corners[3] =
+        maxigin_initSprite( inBottomRightSpriteResource );
 
-        maxigin_drawResetColor();
+    mx_panelSprites.sides[0] =
+        maxigin_initSprite( inLeftEdgeSpriteResource );
+    
+    mx_panelSprites.sides[1] =
+        maxigin_initSprite( inRightEdgeSpriteResource );
+    
+    mx_panelSprites.sides[2] =
+        maxigin_initSprite( inTopEdgeSpriteResource );
+    
+    mx_panelSprites.sides[3] =
+        maxigin_initSprite( inBottomEdgeSpriteResource );
 
-        maxigin_drawSetAlpha( oldColor.comp.alpha );
+    mx_panelSprites.fill =
+        maxigin_initSprite( inFillSpriteResource );
 
-        for( i = 0;
-             i < mx_sprites[ inSpriteHandle ].numShadows;
-             i ++ ) {
-        
-            maxigin_drawBaseSprite( mx_sprites[ inSpriteHandle ].
-                                        shadowSpriteHandle[i],
-                                    inCenterX,
-                                    inCenterY );
-            }
+    mx_panelSpritesSet =
+        ( mx_panelSprites.corners[0] >= 0 )
+        &&
+        ( mx_panelSprites.corners[1] >= 0 )
+        &&
+        ( mx_panelSprites.corners[2] >= 0 )
+        &&
+        ( mx_panelSprites.corners[3] >= 0 )
+        &&
+        ( mx_panelSprites.sides[0]   >= 0 )
+        &&
+        ( mx_panelSprites.sides[1]   >= 0 )
+        &&
+        ( mx_panelSprites.sides[2]   >= 0 )
+        &&
+        ( mx_panelSprites.sides[3]   >= 0 )
+        &&
+        ( mx_panelSprites.fill       >= 0 );
+    }
 
-        mx_drawColor = oldColor;
+
+
+void maxigin_initPanelSpritesStatic( int           inNumFullPanelSprites,
+                                     const char  **inFullPanelSprites ) {
+    int   i;
+    char  success;
+
+    
+    if( inNumFullPanelSprites > MAXIGIN_NUM_STATIC_PANELS ) {
+        maxigin_logInt( "Error:  maxigin_initPanelSpritesStatic called with "
+                        "too many panel sprites; ",
+                        inNumFullPanelSprites );
+        inNumFullPanelSprites = MAXIGIN_NUM_STATIC_PANELS;
         }
+
+    mx_panelSprites.numFullPanels = inNumFullPanelSprites;
+
+    success = 1;
     
-    if( mx_sprites[ inSpriteHandle ].glowSpriteHandle != -1 ) {
+    for( i = 0;
+         i < inNumFullPanelSprites;
+         i ++ ) {
 
-        mx_drawGlowSprite( inSpriteHandle,
-                           inCenterX,
-                           inCenterY );
-        }
-    else {
-        maxigin_drawBaseSprite( inSpriteHandle,
-                                inCenterX,
-                                inCenterY );
+        mx_panelSprites.fullPanels[i] =
+            maxigin_initSprite( inFullPanelSprites[i] );
+        
+        success =
+            success
+            &&
+            ( mx_panelSprites.fullPanels[i] >= 0 );
         }
+
+    mx_panelSpritesSet = success;
     }
 
 
 
-void maxigin_drawSpriteGlowOnly( int  inSpriteHandle,
-                                 int  inCenterX,
-                                 int  inCenterY ) {
-    
-    if( mx_sprites[ inSpriteHandle ].glowSpriteHandle != -1 ) {
-        
-        char  oldAdditive  =  maxigin_drawGetAdditive();
-        
-        maxigin_drawToggleAdditive( 1 );
+void maxigin_initMakePanelGlow( int  inBlurRadius,
+                                int  inBlurIterations ) {
+    int  i;
 
-        maxigin_drawBaseSprite( mx_sprites[ inSpriteHandle ].glowSpriteHandle,
-                                inCenterX,
-                                inCenterY );
+    /* only apply to static panels, not dynamic panel tiles */
+    
+    for( i = 0;
+         i < mx_panelSprites.numFullPanels;
+         i ++ ) {
 
-        maxigin_drawToggleAdditive( oldAdditive );
+        maxigin_initMakeGlowSprite( mx_panelSprites.fullPanels[i],
+                                    inBlurRadius,
+                                    inBlurIterations );
         }
     }
 
 
 
-void maxigin_drawSpriteShadowOnly( int  inSpriteHandle,
-                                   int  inCenterX,
-                                   int  inCenterY ) {
-    
-    if( mx_sprites[ inSpriteHandle ].numShadows > 0 ) {
-
-        int           i;
-        MaxiginColor  oldColor  =  mx_drawColor;
-
-        maxigin_drawResetColor();
-
-        maxigin_drawSetAlpha( oldColor.comp.alpha );
+typedef struct MaxiginCheckboxSprites {
 
-        for( i = 0;
-             i < mx_sprites[ inSpriteHandle ].numShadows;
-             i ++ ) {
+        /* [0] for unchecked, [1] for checked */
+        int  cool[2];
+        int  hot [2];
         
-            maxigin_drawBaseSprite( mx_sprites[ inSpriteHandle ].
-                                        shadowSpriteHandle[i],
-                                    inCenterX,
-                                    inCenterY );
-            }
-
-        mx_drawColor = oldColor;
-        }
-    }
+    } MaxiginCheckboxSprites;
 
 
+char                     mx_checkboxSpritesSet  =  0;
+MaxiginCheckboxSprites   mx_checkboxSprites;
 
-void maxigin_getSpritePixel( int            inSpriteHandle,
-                             int            inPixelX,
-                             int            inPixelY,
-                             MaxiginColor  *outColor ) {
 
-    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle ] );
-    int             b;
-    
-    if( inPixelX < 0
-        ||
-        inPixelX >= s->w
-        ||
-        inPixelY < 0
-        ||
-        inPixelY >= s->h ) {
+void maxigin_initCheckboxSprites( const char  *inCoolUncheckedResource,
+                                  const char  *inCoolCheckedResource,
+                                  const char  *inHotUncheckedResource,
+                                  const char  *inHotCheckedResource ) {
 
-        outColor->val[0] = 0;
-        outColor->val[1] = 0;
-        outColor->val[2] = 0;
-        outColor->val[3] = 0;
-        return;
-        }
+    mx_checkboxSprites.cool[0] = maxigin_initSprite( inCoolUncheckedResource );
+    mx_checkboxSprites.cool[1] = maxigin_initSprite( inCoolCheckedResource   );
     
-    b = s->startByte + ( inPixelY * s->w + inPixelX ) * 4;
+    mx_checkboxSprites.hot [0] = maxigin_initSprite( inHotUncheckedResource  );
+    mx_checkboxSprites.hot [1] = maxigin_initSprite( inHotCheckedResource    );
 
-    outColor->val[0] = mx_spriteBytes[ b++ ];
-    outColor->val[1] = mx_spriteBytes[ b++ ];
-    outColor->val[2] = mx_spriteBytes[ b++ ];
-    outColor->val[3] = mx_spriteBytes[ b++ ];
+    mx_checkboxSpritesSet =
+        ( mx_checkboxSprites.cool[0] != -1 )
+        &&
+        ( mx_checkboxSprites.cool[1] != -1 )
+        &&
+        ( mx_checkboxSprites.hot [0] != -1 )
+        &&
+        ( mx_checkboxSprites.hot [1] != -1 );   
     }
 
 
-char maxigin_isInSprite( int  inSpriteHandle,
-                         int  inCenterOffsetX,
-                         int  inCenterOffsetY ) {
-    MaxiginSprite  *s       =  &( mx_sprites[ inSpriteHandle ] );
-    int             pixelX  =  s->w / 2 + inCenterOffsetX;
-    int             pixelY  =  s->h / 2 + inCenterOffsetY;
-    int             b;
+void maxigin_initMakeCheckboxGlow( int  inBlurRadius,
+                                   int  inBlurIterations ) {
+
+    int  i;
     
-    if( pixelX < 0
-        ||
-        pixelX >= s->w
-        ||
-        pixelY < 0
-        ||
-        pixelY >= s->h ) {
+    for( i = 0;
+         i < 2;
+         i ++ ) {
 
-        return 0;
+        maxigin_initMakeGlowSprite( mx_checkboxSprites.cool[i],
+                                    inBlurRadius,
+                                    inBlurIterations );
+        
+        maxigin_initMakeGlowSprite( mx_checkboxSprites.hot[i],
+                                    inBlurRadius,
+                                    inBlurIterations );
         }
+    }
 
-    b = s->startByte + ( pixelY * s->w + pixelX ) * 4;
 
-    /* alpha byte for this pixel */
-    return ( mx_spriteBytes[ b + 3 ] > 0 );
-    }
 
-    
+typedef struct MaxiginButtonSprites {
+        
+        int  cool;
+        int  hot;
+        int  pressed;
+        
+    } MaxiginButtonSprites;
 
 
-void maxigin_drawExplodingSprite( int            inSpriteHandle,
-                                  int            inParticleHandle,
-                                  int            inCenterX,
-                                  int            inCenterY,
-                                  int            inExplosionCenterX,
-                                  int            inExplosionCenterY,
-                                  int            inMaxDistance,
-                                  int            inExplodeProgress,
-                                  int            inExplodeProgressMax,
-                                  unsigned char  inAlphaFade ) {
-    
-    MaxiginSprite  *s         =  &( mx_sprites[ inSpriteHandle ] );
-    int             x;
-    int             y;
-    int             b         =  s->startByte;
-    int             ex        =  inExplosionCenterX - inCenterX;
-    int             ey        =  inExplosionCenterY - inCenterY;
-    int             cx        =  s->w / 2;
-    int             cy        =  s->h / 2;
+char                  mx_buttonSpritesSet  =  0;
+MaxiginButtonSprites  mx_buttonSprites;
 
-    long             d;
-    int              pSprite  =  inParticleHandle;
 
-    long             red      =  mx_drawColor.comp.red;
-    long             green    =  mx_drawColor.comp.green;
-    long             blue     =  mx_drawColor.comp.blue;
-    long             alpha    =  mx_drawColor.comp.alpha;
+void maxigin_initButtonSprites( const char  *inCoolResource,
+                                const char  *inHotResource,
+                                const char  *inPressedResource ) {
 
-    alpha = ( alpha * inAlphaFade ) / 255;
-    
+    mx_buttonSprites.cool = maxigin_initSprite( inCoolResource );
+    mx_buttonSprites.hot = maxigin_initSprite( inHotResource  );
     
-    /* d is scaled by a factor of 100 */
-    d = ( (long)inMaxDistance * 100 * (long) inExplodeProgress )
-        / inExplodeProgressMax;
+    mx_buttonSprites.pressed = maxigin_initSprite( inPressedResource  );
     
+    mx_buttonSpritesSet =
+        ( mx_buttonSprites.cool    != -1 )
+        &&
+        ( mx_buttonSprites.hot     != -1 )
+        &&
+        ( mx_buttonSprites.pressed != -1 );   
+    }
 
-    for( y = 0;
-         y < s->h;
-         y ++ ) {
-
-        int  dy     =  y - cy;
-        int  drawY  =  (int)( ( d * ( dy - ey ) ) / 100 ) + inCenterY + dy;
 
-        for( x = 0;
-             x < s->w;
-             x ++ ) {
 
-            int dx      = x - cx;
-            int  drawX  =  (int)( ( d * ( dx - ex ) ) / 100 ) + inCenterX + dx;
+void maxigin_initMakeButtonGlow( int  inBlurRadius,
+                                 int  inBlurIterations ) {
 
-            maxigin_drawSetColor(
-                (unsigned char)( ( mx_spriteBytes[ b     ] * red )
-                                 / 255 ),
-                (unsigned char)( ( mx_spriteBytes[ b + 1 ] * green )
-                                 / 255 ),
-                (unsigned char)( ( mx_spriteBytes[ b + 2 ] * blue )
-                                 / 255 ),
-                (unsigned char)( ( mx_spriteBytes[ b + 3 ] * alpha )
-                                 / 255 ) );
+    maxigin_initMakeGlowSprite( mx_buttonSprites.cool,
+                                inBlurRadius,
+                                inBlurIterations );
+        
+    maxigin_initMakeGlowSprite( mx_buttonSprites.hot,
+                                inBlurRadius,
+                                inBlurIterations );
 
-            b += 4;
-            
-            maxigin_drawSprite( pSprite,
-                                drawX,
-                                drawY );
-            }
-        }
+    maxigin_initMakeGlowSprite( mx_buttonSprites.pressed,
+                                inBlurRadius,
+                                inBlurIterations );
     }
 
 
 
-void maxigin_drawSpriteSparkles( int            inSpriteHandle,
-                                 int            inParticleHandle,
-                                 int            inCenterX,
-                                 int            inCenterY,
-                                 MaxiginRand   *inRand,
-                                 int            inNumSparkles,
-                                 unsigned char  inAlphaFade,
-                                 int            inStartX,
-                                 int            inEndX,
-                                 int            inStartY,
-                                 int            inEndY ) {
+void maxigin_initMakeGuiGlow( int  inBlurRadius,
+                              int  inBlurIterations ) {
 
-    MaxiginSprite  *s         =  &( mx_sprites[ inSpriteHandle ] );
-    long            numDrawn  =  0;
-    int             pSprite   =  inParticleHandle;
-    int             numFail   =  0;
-    int             cx        =  s->w / 2;
-    int             cy        =  s->h / 2;
-    long            red       =  mx_drawColor.comp.red;
-    long            green     =  mx_drawColor.comp.green;
-    long            blue      =  mx_drawColor.comp.blue;
-    long            alpha     =  mx_drawColor.comp.alpha;
+    maxigin_initMakeSliderGlow( inBlurRadius,
+                                inBlurIterations );
+    
+    maxigin_initMakePanelGlow( inBlurRadius,
+                               inBlurIterations );
+    
+    maxigin_initMakeCheckboxGlow( inBlurRadius,
+                                  inBlurIterations );
 
+    maxigin_initMakeButtonGlow( inBlurRadius,
+                                inBlurIterations );
+    }
 
-    /* compound alpha here */
-    if( inAlphaFade < 255 ) {
-        alpha = ( alpha * inAlphaFade ) / 255;
-        }
 
-    if( inStartX == -1 ) {
-        inStartX = 0;
-        }
-    if( inEndX == -1 ) {
-        inEndX = s->w - 1;
-        }
 
-    if( inStartY == -1 ) {
-        inStartY = 0;
-        }
-    if( inEndY == -1 ) {
-        inEndY = s->h - 1;
+/* strip handle is -1 to make a new strip
+   
+   if inStripHandle is an existing strip, inHeightPerSprite should be -1,
+   since the existing height per sprite will be used.
+   
+   returns handle to strip (which may equal inSpriteHandle if re-making
+   an existing strip) */
+static int mx_regenSpriteStripChildren( int  inMainSpriteHandle,
+                                        int  inStripHandle,
+                                        int  inHeightPerSprite );
+
+
+
+static void mx_regenerateSpriteKerning( int  inSpriteHandle );
+
+
+
+static void mx_postReloadStep( int  inSpriteHandle ) {
+    
+    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle ] );
+
+    mx_invalidateLayers();
+
+    if( s->colorMapHandle != -1 ) {
+
+        /* re-apply the color map to the newly-loaded sprite,
+           which would have reloaded its source colors */
+
+        maxigin_applyColorMap( inSpriteHandle,
+                               s->colorMapHandle,
+                               s->colorMapRow );
         }
     
-    while( numDrawn < inNumSparkles ) {
+    s->pendingChange       = 0;
+    s->retryCount          = 0;
+    s->stepsUntilNextRetry = 0;
 
-        int            y       =  maxigin_randRange( inRand,
-                                                     inStartY,
-                                                     inEndY );
-        int            x       =  maxigin_randRange( inRand,
-                                                     inStartX,
-                                                     inEndX );
-        
-        int            aTweak  =  maxigin_randRange( inRand,
-                                                     0,
-                                                     255 );
-        int            drawY;
-        int            drawX;
+    if( s->glowSpriteHandle != -1 ) {
 
-        int            b       =  s->startByte + y * 4 * s->w + x * 4;
+        mx_regenerateGlowSprite(
+            inSpriteHandle,
+            s->glowRadius,
+            s->glowIterations );
+        }
 
-        unsigned char  a       =  mx_spriteBytes[ b + 3 ];
+    if( s->numShadows > 0 ) {
 
-        if( a == 0 ) {
-            numFail ++;
+        int  i;
 
-            if( numFail < 10 ) {
-                continue;
-                }
-            else {
-                /* 10 failures in a row looking for non-transparent pixel */
-                break;
-                }
-            }
-        numFail = 0;
+        for( i = 0;
+             i < s->numShadows;
+             i ++ ) {
 
-        drawY = inCenterY + ( y - cy );
-        drawX = inCenterX + ( x - cx );
+            mx_regenerateDropShadowSprite(
+                inSpriteHandle,
+                i,
+                s->shadowRadius       [i],
+                s->shadowIterations   [i],
+                s->shadowBottomAlpha  [i],
+                s->shadowTopAlpha     [i],
+                s->shadowBottomPercent[i],
+                s->shadowTopPercent   [i],
+                s->shadowDarkness     [i],
+                s->shadowGrayValue    [i] );
+            }
+        }
 
-        maxigin_drawSetColor(
-            (unsigned char)( ( mx_spriteBytes[ b     ] * red )
-                             / 255 ),
-            (unsigned char)( ( mx_spriteBytes[ b + 1 ] * green )
-                             / 255 ),
-            (unsigned char)( ( mx_spriteBytes[ b + 2 ] * blue )
-                             / 255 ),
-            (unsigned char)( ( a * alpha * aTweak )
-                             / 65025 ) );
+    if( s->stripChildHandle != -1 ) {
+        /* just reloaded a parent sprite of a strip
+           need to make new pointers for child sprites */
 
-            
-        maxigin_drawSprite( pSprite,
-                            drawX,
-                            drawY );
+        /* this will also re-gen glow sprites if needed */
+        mx_regenSpriteStripChildren( inSpriteHandle,
+                                     s->stripChildHandle,
+                                     -1 );
+        }
 
-        numDrawn ++;
+    if( s->kerningTableIndex != -1 ) {
+        mx_regenerateSpriteKerning( inSpriteHandle );
         }
+
     
-        
-        
-    }
+    if( s->isColorMap ) {
+        /* this sprite is a color map itself
+           and it has changed!
+           Trigger reload of all sprites that use this map */
 
+        int  i;
 
+        for( i = 0;
+             i < mx_numSprites;
+             i ++ ) {
 
-static int mx_abs( int  inValue ) {
-    if( inValue < 0 ) {
-        return - inValue;
-        }
-    else {
-        return inValue;
+            if( i != inSpriteHandle ) {
+
+                MaxiginSprite  *s2  =  &( mx_sprites[i] );
+
+                if( s2->colorMapHandle == inSpriteHandle
+                    &&
+                    s2->bulkResourceName[0] != '\0' ) {
+
+                    /* don't worry about whether this is a success
+                       or not.
+                       We do that during the file-changed-reload process
+                       because the file may be incomplete for a bit
+                       after it has changed on disk
+                       But in this case, we are triggering a cascade
+                       reload after a separate color map file changed */
+                    mx_reloadSprite( s2->bulkResourceName,
+                                     i );
+                    
+                    mx_postReloadStep( i );
+                    }
+                }
+            }
         }
     }
 
 
 
-static void mx_drawLineLow( int  inStartX,
-                            int  inStartY,
-                            int  inEndX,
-                            int  inEndY ) {
-    
-    int  dX    =  inEndX - inStartX;
-    int  dY    =  inEndY - inStartY;
-    int  yDir  =  1;
-    int  d;
-    int  x;
-    int  y;
-    int  pixelStartByte;
-    int  lineA            =  mx_drawColor.comp.alpha;
-    
-    /* color components with alpha pre-multiplied */
-    int  linePreR         =  mx_drawColor.comp.red   * lineA;
-    int  linePreG         =  mx_drawColor.comp.green * lineA;
-    int  linePreB         =  mx_drawColor.comp.blue  * lineA;
-    int  lineScaledR      =  linePreR / 255;
-    int  lineScaledG      =  linePreG / 255;
-    int  lineScaledB      =  linePreB / 255;
+/* set when any sprite has pendingChange set */
+static  char  mx_spriteReloadsPending  =  0;
 
-    
-    if( dY < 0 ) {
-        yDir = -1;
-        dY   = -dY;
-        }
-    
-    d = ( 2 * dY ) - dX;
-    
-    y = inStartY;
 
 
-    /* easy bounds checking on end for x, truncate line */
-    if( inEndX >= MAXIGIN_GAME_NATIVE_W ) {
-        inEndX = MAXIGIN_GAME_NATIVE_W - 1;
-        }
+/*
+  Reloads all sprites that come from a given bulk data resource.
+  
+  Sprites that fail to reload, because the bulk data is in the middle of
+  being written by an external editor or is invalid, are left in place
+  and marked to try reloading again later.
+*/
+static void mx_reloadSpritesFromBulkData( const char  *inBulkName ) {
 
-    /* walk through start of line until it is in-bounds in our image */
-    while( inStartX < 0
-           ||
-           y < 0
-           ||
-           y >= MAXIGIN_GAME_NATIVE_H ) {
+    int  s;
+    
+    for( s = 0;
+         s < mx_numSprites;
+         s ++ ) {
 
-        inStartX ++;
+        int  handle;
 
-        if( inStartX > inEndX ) {
-            break;
+        /* skip any with blank bulkResourceNames,
+           since those are our internally-generated sprites */
+        if( mx_sprites[ s ].bulkResourceName[ 0 ] == '\0' ) {
+            continue;
+            }
+
+        if( ! maxigin_stringsEqual( inBulkName,
+                                    mx_sprites[ s ].bulkResourceName ) ) {
+            continue;
             }
         
-        if( d > 0 ) {
-        
-            y += yDir;
-            
-            d += 2 * ( dY - dX );
+        handle  =  mx_reloadSprite( mx_sprites[ s ].bulkResourceName,
+                                    s );
+        if( handle == -1 ) {
+            mx_sprites[ s ].pendingChange       = 1;
+            mx_sprites[ s ].retryCount          = 1;
+            mx_sprites[ s ].stepsUntilNextRetry = 1;
+
+            mx_spriteReloadsPending = 1;
             }
         else {
-            d += 2 * dY;
+            mx_postReloadStep( s );
             }
         }
+    }
 
-    if( inStartX > inEndX
-        ||
-        y >= MAXIGIN_GAME_NATIVE_H
-        ||
-        y < 0 ) {
 
-        /* line is entirely outside of our image */
+
+/*
+  Retries reloading sprites with pending changes, and, if inPollBulkData
+  is set, checks each sprite's bulk data for changes.
+*/
+static void mx_checkSpritesNeedReload( char  inPollBulkData ) {
+
+    int  s;
+
+    if( ! inPollBulkData
+        &&
+        ! mx_spriteReloadsPending ) {
         return;
         }
 
+    mx_spriteReloadsPending = 0;
     
-    pixelStartByte =
-        y * MAXIGIN_GAME_NATIVE_W * 3
-        +
-        inStartX * 3;
-    
-    for( x  = inStartX;
-         x <= inEndX;
-         x ++ ) {
+    for( s = 0;
+         s < mx_numSprites;
+         s ++ ) {
 
-        if( mx_additiveBlend ) {
-            
-            int  v;
+        if( mx_sprites[ s ].pendingChange ) {
 
-            v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
+            if( mx_sprites[ s ].stepsUntilNextRetry <= 0 ) {
 
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
+                int  retry   =  mx_sprites[ s ].retryCount;
+                int  handle  =  mx_reloadSprite(
+                                    mx_sprites[ s ].bulkResourceName,
+                                    s );
 
-                
-            v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
-                
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+                if( handle == -1 ) {
+                    /* with each failure, we wait more and more
+                       steps until we try again */
+                    mx_sprites[ s ].pendingChange = 1;
+                    mx_sprites[ s ].retryCount ++;
+                    
+                    mx_sprites[ s ].stepsUntilNextRetry =
+                                        mx_sprites[ s ].retryCount;
 
-                
-            v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
-                
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v;
+                    mx_spriteReloadsPending = 1;
+                    }
+                else {
+                    /* success in reloading */
 
-            /* next col */
-            pixelStartByte += 3;
-            }
-        else {
-            if( lineA == 255 ) {
-        
-                /* no blend, pure replace */
-                mx_gameImageBuffer[ pixelStartByte ++ ] =
-                    mx_drawColor.comp.red;
-                
-                mx_gameImageBuffer[ pixelStartByte ++ ] =
-                    mx_drawColor.comp.green;
-                
-                mx_gameImageBuffer[ pixelStartByte ++ ] =
-                    mx_drawColor.comp.blue;
-                
+                    maxigin_logInt(
+                        "Success in reloading sprite after retries: ",
+                        retry );
+
+                    mx_postReloadStep( s );
+                    }
                 }
             else {
+                /* wait another step before retrying */
+                mx_sprites[ s ].stepsUntilNextRetry --;
                 
-                /* alpha weighted blend, most expensive case */
-                
-                mx_gameImageBuffer[ pixelStartByte ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte ]
-                          * ( 255 - lineA )
-                          +
-                          linePreR )
-                        /
-                        255 );
-
-                mx_gameImageBuffer[ pixelStartByte + 1 ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte + 1 ]
-                          * ( 255 - lineA )
-                          +
-                          linePreG )
-                        /
-                        255 );
-
-                
-                mx_gameImageBuffer[ pixelStartByte + 2 ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte + 2 ]
-                          * ( 255 - lineA )
-                          +
-                          linePreB )
-                        /
-                        255 );
-                
-                /* next col */
-                pixelStartByte += 3;
+                mx_spriteReloadsPending = 1;
                 }
             }
-        
-        if( d > 0 ) {
-        
-            y += yDir;
-
+        else if(
+            inPollBulkData
+            &&
+            mx_sprites[ s ].bulkResourceName[ 0 ] != '\0'
+            &&
+            mingin_getBulkDataChanged( mx_sprites[ s ].bulkResourceName ) ) {
 
-            /* bail out if y ever steps out of bounds */
-            if( y < 0
-                ||
-                y >= MAXIGIN_GAME_NATIVE_H ) {
-                break;
-                }
-            
-            pixelStartByte += yDir * MAXIGIN_GAME_NATIVE_W * 3;
-                
-            d += 2 * ( dY - dX );
-            }
-        else {
-            d += 2 * dY;
+            /* we see a bulk data change for this sprite
+               reload it, along with any other sprites that have the same
+               bulk data resource.
+               Otherwise, we will miss reloading them (they won't count
+               as changed since last reload). */
+            mx_reloadSpritesFromBulkData( mx_sprites[ s ].bulkResourceName );
             }
-
         }
     }
 
 
 
-static void mx_drawLineHigh( int  inStartX,
-                             int  inStartY,
-                             int  inEndX,
-                             int  inEndY ) {
-    
-    int  dX               =  inEndX - inStartX;
-    int  dY               =  inEndY - inStartY;
-    int  xDir             =  1;
-    int  d;
-    int  x;
-    int  y;
-    int  pixelStartByte;
-    int  lineA            =  mx_drawColor.comp.alpha;
-    
-    /* color components with alpha pre-multiplied */
-    int  linePreR         =  mx_drawColor.comp.red   * lineA;
-    int  linePreG         =  mx_drawColor.comp.green * lineA;
-    int  linePreB         =  mx_drawColor.comp.blue  * lineA;
-    int  lineScaledR      =  linePreR / 255;
-    int  lineScaledG      =  linePreG / 255;
-    int  lineScaledB      =  linePreB / 255;
-    
+/* each sprite strip points to sprites in the sprite pool
+   the handles for these sub-sprites are stored here */
+static  int  mx_stripSubSprites[ MAXIGIN_MAX_NUM_SPRITES ];
+
+static  int  mx_numStripSubSprites  =  0;
+
+
+typedef struct MaxiginSpriteStrip {
+
+        int  numSubSprites;
+
+        int  heightPerSprite;
+
+        /* index of first strip sprite's handle in mx_stripSubSprites */
+        int  startIndex;
+        
+    } MaxiginSpriteStrip;
+
+
+
+static  MaxiginSpriteStrip  mx_spriteStrips[ MAXIGIN_MAX_NUM_SPRITE_STRIPS ];
+
+static  int                 mx_numSpriteStrips  =  0;
+
+
+
+int maxigin_initSpriteStrip( const char  *inBulkResourceName,
+                             int          inHeightPerSprite ) {
+
+    int                  mainSpriteHandle;
+    int                  stripHandle;
     
-    if( dX < 0 ) {
-        xDir = -1;
-        dX   = -dX;
+    if( mx_numSpriteStrips >= MAXIGIN_MAX_NUM_SPRITE_STRIPS ) {
+        maxigin_logString( "Failed to load sprite strip because we already "
+                           "have too many sprite strips loaded: ",
+                           inBulkResourceName );
+        return -1;
         }
     
-    d = ( 2 * dX ) - dY;
-    
-    x = inStartX;
+    mainSpriteHandle = maxigin_initSprite( inBulkResourceName );
 
-    
-    /* easy bounds checking on end for y, truncate line */
-    if( inEndY >= MAXIGIN_GAME_NATIVE_H ) {
-        inEndY = MAXIGIN_GAME_NATIVE_H - 1;
+    if( mainSpriteHandle == -1 ) {
+        return -1;
         }
 
-    /* walk through start of line until it is in-bounds in our image */
-    while( inStartY < 0
-           ||
-           x < 0
-           ||
-           x >= MAXIGIN_GAME_NATIVE_W ) {
-
-        inStartY ++;
-
-        if( inStartY > inEndY ) {
-            break;
-            }
-        
-        if( d > 0 ) {
+    
+    if( mx_spriteCacheLoaded ) {
+        /* strip already loadded from cache */
         
-            x += xDir;
-            
-            d += 2 * ( dX - dY );
-            }
-        else {
-            d += 2 * dX;
-            }
-        }
+        int  thisHandle  =  mx_nextCachedSpriteStripHandle;
 
-    if( inStartY > inEndY
-        ||
-        x < 0
-        ||
-        x >= MAXIGIN_GAME_NATIVE_W ) {
+        mx_nextCachedSpriteStripHandle ++;
 
-        /* line is entirely outside of our image */
-        return;
+        /* figure out how many sprite handles to skip */
+
+        mx_nextCachedSpriteHandle +=
+            mx_sprites[ mainSpriteHandle ].h  / inHeightPerSprite;
+        
+        return thisHandle;
         }
     
-    pixelStartByte =
-        inStartY * MAXIGIN_GAME_NATIVE_W * 3
-        +
-        x * 3;
+
+    /* generate a brand new strip */
+    mx_startProfilePhase( "loadSprites" );
     
-    for( y  = inStartY;
-         y <= inEndY;
-         y ++ ) {
-        
-        if( mx_additiveBlend ) {
-            
-            int  v;
+    stripHandle = mx_regenSpriteStripChildren( mainSpriteHandle,
+                                               -1,
+                                               inHeightPerSprite );
+    mx_endProfilePhase();
 
-            v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
+    return stripHandle;
+    }
 
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
 
-                
-            v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
-                
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
 
+static int mx_regenSpriteStripChildren( int  inMainSpriteHandle,
+                                        int  inStripHandle,
+                                        int  inHeightPerSprite ) {
+
+    MaxiginSprite       *mainSprite;
+    int                  numSubSprites;
+    int                  newStripHandle;
+    MaxiginSpriteStrip  *newStrip;
+    int                  i;
+    int                  bytesPerSubSprite;
+    int                  nextSubStartByte;
+    char                 exists;
+    
+    mainSprite = &( mx_sprites[ inMainSpriteHandle ] );
+
+    if( inHeightPerSprite == -1 ) {
+        if( inStripHandle == -1 ) {
+            maxigin_logString(
+                "Failed to load sprite strip because strip height "
+                "per sub-sprite not specified: ",
+                mainSprite->bulkResourceName );
+            return -1;
+            }
+        /* if height not given, extract it from existing strip */
+        inHeightPerSprite = mx_spriteStrips[ inStripHandle ].heightPerSprite;
+        }
+
+    numSubSprites = mainSprite->h / inHeightPerSprite;
+
+    if( inStripHandle != -1 ) {
+        if( numSubSprites * inHeightPerSprite
+            != mainSprite->h
+            ||
+            numSubSprites != mx_spriteStrips[ inStripHandle ].numSubSprites ) {
+
+            /* some kind of mismatch */
+
+            /* we actually allow a taller/shorter strip if can still contain
+               the same number of sub-sprites that are all of a new,
+               taller/shorter same size */
+
+            /* number of sub sprites can't change, though */
+            numSubSprites = mx_spriteStrips[ inStripHandle ].numSubSprites;
+
+            /* we'll check if an interger multiple of this fits below */
+            inHeightPerSprite = mainSprite->h / numSubSprites;
+            }
+        }
+    
+    if( numSubSprites * inHeightPerSprite
+        !=
+        mainSprite->h ) {
+
+        maxigin_logString( "Failed to (re) load sprite strip because strip "
+                           "height is not integer multiple of supplied height: ",
+                           mainSprite->bulkResourceName );
+        return -1;
+        }
+
+    
+
+
+
+    if( inStripHandle == -1 ) {
+
+        /* make sure there's room for this many new sub-sprites */
+
+        if( mx_numStripSubSprites + numSubSprites
+            >=
+            MAXIGIN_MAX_NUM_SPRITES ) {
+        
+            maxigin_logString( "Failed to load sprite strip because we already "
+                               "have too many strip sub sprites: ",
+                               mainSprite->bulkResourceName );
+            return -1;
+            }
+
+        if( mx_numSprites + numSubSprites
+            >=
+            MAXIGIN_MAX_NUM_SPRITES ) {
+        
+            maxigin_logString( "Failed to load sprite strip because we already "
+                               "have too many sprites: ",
+                               mainSprite->bulkResourceName );
+            return -1;
+            };
+        
+        newStripHandle = mx_numSpriteStrips;
+        
+        mx_numSpriteStrips ++;
+
+        exists = 0;
+        }
+    else {
+        /* an existing strip, there's already room for it */
+        
+        newStripHandle = inStripHandle;
+
+        exists = 1;
+        }
+    
+
+    newStrip = &( mx_spriteStrips[ newStripHandle ] );
+
+    if( ! exists ) {
+        newStrip->numSubSprites = numSubSprites;
+
+        newStrip->startIndex = mx_numStripSubSprites;
+
+        newStrip->heightPerSprite = inHeightPerSprite;
+    
+        mx_numStripSubSprites += numSubSprites;
+        }
+    else {
+        if( numSubSprites != newStrip->numSubSprites ) {
+            maxigin_logString( "Failed to hot re-load sprite strip because "
+                               "of size mismatch with old strip: ",
+                               mainSprite->bulkResourceName );
+            return -1;
+            }
+        }
+    
+    nextSubStartByte = mainSprite->startByte;
+    
+    bytesPerSubSprite = mainSprite->w * inHeightPerSprite * 4;
+    
+    for( i = 0;
+         i < numSubSprites;
+         i ++ ) {
+
+        int             subHandle;
+        MaxiginSprite  *subSprite;
+
+        if( ! exists ) {
+            subHandle = mx_numSprites;
+            
+            mx_numSprites ++;
+
+            mx_stripSubSprites[ i + newStrip->startIndex ] = subHandle;
+            }
+        else {
+            /* re-use existing sub-sprite, but point it at new data
+               from main sprite */
+            subHandle = mx_stripSubSprites[ i + newStrip->startIndex ];
+            }
+        
+        subSprite = &( mx_sprites[ subHandle ] );
+
+        subSprite->w = mainSprite->w;
+
+        subSprite->h = inHeightPerSprite;
+
+        subSprite->startByte = nextSubStartByte;
+
+        subSprite->numPaletteColors = 0;
+
+        nextSubStartByte += bytesPerSubSprite;
+
+        subSprite->bulkResourceName[0] = '\0';
+
+        subSprite->pendingChange = 0;
+
+        subSprite->stripParentHandle = inMainSpriteHandle;
+        subSprite->stripIndex = i;
+        
+        
+        mx_recomputeSpriteAttributes( subHandle );
+
+        if( ! exists ) {
+            subSprite->glowSpriteHandle   = -1;
+
+            mx_initEmptyShadows( subHandle );
+            
+            subSprite->kerningTableIndex  = -1;
+            }
+        }
+
+    /* now that they are all pointing to the right spots in the new
+       parent sprite strip, we can regenerate glow sprites if needed.
+
+       If we do this inline in the loop above, the deletion of glow
+       sprites can cause our parent sprite strip to move,
+       causing later children to point to the wrong place */
+
+    for( i = 0;
+         i < numSubSprites;
+         i ++ ) {
+        
+        int             subHandle;
+        MaxiginSprite  *subSprite;
+
+        subHandle = mx_stripSubSprites[ i + newStrip->startIndex ];
+        subSprite = &( mx_sprites[ subHandle ] );
+        
+        if( subSprite->glowSpriteHandle != -1 ) {
+            mx_regenerateGlowSprite(
+                subHandle,
+                subSprite->glowRadius,
+                subSprite->glowIterations );
+            }
+        if( subSprite->numShadows > 0 ) {
+
+            int  si;
+
+            for( si = 0;
+                 si < subSprite->numShadows;
+                 si ++ ) {
                 
-            v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
-                
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v;
-            }
-        else {
-            if( lineA == 255 ) {
-        
-                /* no blend, pure replace */
-                mx_gameImageBuffer[ pixelStartByte     ] =
-                    mx_drawColor.comp.red;
-                
-                mx_gameImageBuffer[ pixelStartByte + 1 ] =
-                    mx_drawColor.comp.green;
-                
-                mx_gameImageBuffer[ pixelStartByte + 2 ] =
-                    mx_drawColor.comp.blue;
+                mx_regenerateDropShadowSprite(
+                    subHandle,
+                    si,
+                    subSprite->shadowRadius       [si],
+                    subSprite->shadowIterations   [si],
+                    subSprite->shadowBottomAlpha  [si],
+                    subSprite->shadowTopAlpha     [si],
+                    subSprite->shadowBottomPercent[si],
+                    subSprite->shadowTopPercent   [si],
+                    subSprite->shadowDarkness     [si],
+                    subSprite->shadowGrayValue    [si] );
+                }
+            }
+        if( subSprite->kerningTableIndex != -1 ) {
+            mx_regenerateSpriteKerning( subHandle );
+            }
+        }
+
+    mainSprite->stripChildHandle = newStripHandle;
+    
+    return newStripHandle;
+    }
+
+
+
+int maxigin_getNumSpritesInStrip( int  inSpriteStripHandle ) {
+    return mx_spriteStrips[ inSpriteStripHandle ].numSubSprites;
+    }
+
+
+
+int maxigin_getSpriteFromStrip( int  inSpriteStripHandle,
+                                int  inSpriteIndex ) {
+    return mx_stripSubSprites[
+        mx_spriteStrips[ inSpriteStripHandle ].startIndex + inSpriteIndex ];
+    }
+
+
+
+void maxigin_getSpriteDimensions( int   inSpriteHandle,
+                                  int  *outWide,
+                                  int  *outHigh ) {
+    
+    MaxiginSprite *s  =  &( mx_sprites[ inSpriteHandle ] );
+
+    *outWide = s->w;
+    *outHigh = s->h;
+    }
+
+
+
+void maxigin_initMakeGlowSpriteStrip( int  inSpriteStripHandle,
+                                      int  inBlurRadius,
+                                      int  inBlurIterations ) {
+
+    int  numSubSprites;
+    int  i;
+
+    
+    if( inSpriteStripHandle < 0 ) {
+        return;
+        }
+    
+    numSubSprites = mx_spriteStrips[ inSpriteStripHandle ].numSubSprites;
+    
+    for( i = 0;
+         i < numSubSprites;
+         i ++ ) {
+        
+        int  subSpriteHandle  =
+            mx_stripSubSprites[
+                mx_spriteStrips[ inSpriteStripHandle ].startIndex + i ];
+
+        maxigin_initMakeGlowSprite( subSpriteHandle,
+                                    inBlurRadius,
+                                    inBlurIterations );
+        }
+    }
+
+
+
+void maxigin_initMakeDropShadowSpriteStrip( int            inSpriteStripHandle,
+                                            int            inBlurRadius,
+                                            int            inBlurIterations,
+                                            unsigned char  inBottomAlpha,
+                                            unsigned char  inTopAlpha,
+                                            unsigned char  inBottomPercent,
+                                            unsigned char  inTopPercent,
+                                            int            inDarkness,
+                                            unsigned char  inGrayValue ) {
+
+    int  numSubSprites;
+    int  i;
+
+    
+    if( inSpriteStripHandle < 0 ) {
+        return;
+        }
+    
+    numSubSprites = mx_spriteStrips[ inSpriteStripHandle ].numSubSprites;
+    
+    for( i = 0;
+         i < numSubSprites;
+         i ++ ) {
+        
+        int  subSpriteHandle  =
+            mx_stripSubSprites[
+                mx_spriteStrips[ inSpriteStripHandle ].startIndex + i ];
+
+        maxigin_initMakeDropShadowSprite( subSpriteHandle,
+                                          inBlurRadius,
+                                          inBlurIterations,
+                                          inBottomAlpha,
+                                          inTopAlpha,
+                                          inBottomPercent,
+                                          inTopPercent,
+                                          inDarkness,
+                                          inGrayValue );
+        }
+    }
+
+
+
+static  char  mx_additiveBlend  =  0;
+
+
+
+void maxigin_drawToggleAdditive( char  inAdditiveOn ) {
+    mx_additiveBlend = inAdditiveOn;
+    }
+
+
+
+char maxigin_drawGetAdditive( void ) {
+    return mx_additiveBlend;
+    }
+
+
+
+
+
+
+
+static MaxiginColor  mx_drawColor  =  { { 255, 255, 255, 255 } };
+
+
+void maxigin_drawSetColor( unsigned char  inRed,
+                           unsigned char  inGreen,
+                           unsigned char  inBlue,
+                           unsigned char  inAlpha ) {
+
+    mx_drawColor.comp.red    =  inRed;
+    mx_drawColor.comp.green  =  inGreen;
+    mx_drawColor.comp.blue   =  inBlue;
+    mx_drawColor.comp.alpha  =  inAlpha;
+    
+    }
+
+
+
+void maxigin_drawGetColor( unsigned char  *outRed,
+                           unsigned char  *outGreen,
+                           unsigned char  *outBlue,
+                           unsigned char  *outAlpha ) {
+    *outRed   = mx_drawColor.comp.red;
+    *outGreen = mx_drawColor.comp.green;
+    *outBlue  = mx_drawColor.comp.blue;
+    *outAlpha = mx_drawColor.comp.alpha;
+    }
+
+
+
+void maxigin_drawSetAlpha( unsigned char  inAlpha ) {
+    
+    mx_drawColor.comp.alpha  =  inAlpha;
+
+    }
+
+
+
+void maxigin_drawResetColor( void ) {
+    mx_drawColor.comp.red    =  255;
+    mx_drawColor.comp.green  =  255;
+    mx_drawColor.comp.blue   =  255;
+    mx_drawColor.comp.alpha  =  255;
+    }
+
+
+
+/*
+  rgb in  0..255
+  h   in  0..36000
+  s   in  0..10000
+  v   in  0..10000
+*/
+static void mx_convertRGBToHSV( unsigned char   inR,
+                                unsigned char   inG,
+                                unsigned char   inB,
+                                long           *outH,
+                                long           *outS,
+                                long           *outV ) {
+        
+    /* based on forumula found here:
+       
+       https://www.rapidtables.com/convert/color/rgb-to-hsv.html
+
+       Translated these formulas into fixed-point math.
+    */
+
+    
+    long  h    =  0;   /* in range 0.. 36,000 */
+    long  s    =  0;   /* in range 0.. 10,000 */
+    long  v    =  0;   /* in range 0.. 10,000 */
+    
+    long  r    =  inR;
+    long  g    =  inG;
+    long  b    =  inB;
+
+    long  min  =  r;
+    long  max  =  r;
+
+    long  d;
+    
+    if( g > max ) {
+        max = g;
+        }
+    if( b > max ) {
+        max = b;
+        }
+    
+    if( g < min ) {
+        min = g;
+        }
+    if( b < min ) {
+        min = b;
+        }
+
+    d = max - min;
+
+    /* round with  + 127 */
+    v = ( 10000 * max + 127 ) / 255;
+    
+    if ( d == 0 ) {
+        /* This is a gray, no chroma */
+        h = 0;
+        s = 0;
+        }
+    else {
+        /* chroma present */
+
+        long  halfD  =  d / 2;
+        
+
+        if( max > 0 ) {
+            long  halfMax  =  max / 2;
+
+            /* round with  + halfMax */
+            s = ( 10000 * d + halfMax ) / max;
+            }
+        else {
+            s = 0;
+            }
+
+        if( d == 0 ) {
+            h = 0;
+            }
+        else if( r == max )  {
+            /* round with  + halfD */
+            h =         ( ( g - b ) * 6000 + halfD ) / d;
+            }
+        else if( g == max ) {
+            h = 12000 + ( ( b - r ) * 6000 + halfD ) / d;
+            }
+        else if ( b == max ) {
+            h = 24000 + ( ( r - g ) * 6000 + halfD ) / d;
+            }
+        
+
+        while( h < 0 ) {
+            h += 36000;
+            }
+
+        /* don't ever let h be 36000 */
+        while( h >= 36000 ) {
+            h -= 36000;
+            }
+        }
+
+
+    *outH = h;
+    *outS = s;
+    *outV = v;
+    }
+
+
+
+/*
+  h   in  0..36000
+  s   in  0..10000
+  v   in  0..10000
+  rgb in  0..255
+*/
+static void mx_convertHSVToRGB( long           inH,
+                                long           inS,
+                                long           inV,
+                                unsigned char  *outR,
+                                unsigned char  *outG,
+                                unsigned char  *outB ) {
+    long  r;
+    long  g;
+    long  b;
+    
+    if( inS == 0 ) {
+        /* round with  + 5000 */
+        long  gray  =  ( inV * 255 + 5000 ) / 10000;
+        
+        r = gray;                      
+        g = gray;
+        b = gray;
+        }
+    else {
+
+        /* round with  + 5000 */
+        long  c     =  ( inV * inS + 5000 ) / 10000;
+        long  m     =  inV - c;
+        
+        long  hBin  =  inH / 6;
+
+        long  hMod  =  ( hBin % 2000 ) - 1000;
+        long  x;
+        long  r2;
+        long  g2;
+        long  b2;
+        
+        if( hMod < 0 ) {
+            hMod = -hMod;
+            }
+
+        /* round with  + 500 */
+        x = ( c * (1000 - hMod ) + 500 ) / 1000;
+
+
+        if( inH < 6000 ) {
+            r2 = c;
+            g2 = x;
+            b2 = 0;
+            }
+        else if( inH < 12000 ) {
+            r2 = x;
+            g2 = c;
+            b2 = 0;
+            }
+        else if( inH < 18000 ) {
+            r2 = 0;
+            g2 = c;
+            b2 = x;
+            }
+        else if( inH < 24000 ) {
+            r2 = 0;
+            g2 = x;
+            b2 = c;
+            }
+        else if( inH < 30000 ) {
+            r2 = x;
+            g2 = 0;
+            b2 = c;
+            }
+        else {
+            r2 = c;
+            g2 = 0;
+            b2 = x;
+            }
+
+        /* round with  + 5000 */
+        r = ( ( r2 + m ) * 255 + 5000 ) / 10000;
+        g = ( ( g2 + m ) * 255 + 5000 ) / 10000;
+        b = ( ( b2 + m ) * 255 + 5000 ) / 10000;
+        }
+
+    *outR = (unsigned char)r;
+    *outG = (unsigned char)g;
+    *outB = (unsigned char)b;
+    }
+
+
+                         
+
+int maxigin_drawGetColorSaturation( void ) {
+
+    long  h;
+    long  s;
+    long  v;
+    
+    mx_convertRGBToHSV( mx_drawColor.comp.red,
+                        mx_drawColor.comp.green,
+                        mx_drawColor.comp.blue,
+                        &h,
+                        &s,
+                        &v );
+    
+    return (int)s;
+    }
+
+
+
+void maxigin_drawSetColorSaturation( int  inSaturation ) {
+
+    /* convert to HSV, adjust S, and convert back */
+
+    long  h;
+    long  s;
+    long  v;
+    
+    mx_convertRGBToHSV( mx_drawColor.comp.red,
+                        mx_drawColor.comp.green,
+                        mx_drawColor.comp.blue,
+                        &h,
+                        &s,
+                        &v );
+                        
+
+    /* now adjust saturation */
+
+    s = inSaturation;
+
+
+    /* now convert back */
+
+    mx_convertHSVToRGB( h,
+                        s,
+                        v,
+                        &( mx_drawColor.comp.red ),
+                        &( mx_drawColor.comp.green ),
+                        &( mx_drawColor.comp.blue ) );
+    }
+
+
+
+/* one visible row of a palette sprite, looked up into RGBA for drawing */
+static  unsigned char  mx_paletteRowBytes[ MAXIGIN_GAME_NATIVE_W * 4 ];
+
+
+
+void maxigin_drawBaseSprite( int  inSpriteHandle,
+                             int  inCenterX,
+                             int  inCenterY ) {
+
+    int  startImageX;
+    int  startImageY;
+    int  endImageX;
+    int  endImageY;
+    
+    int  startSpriteX;
+    int  startSpriteY;
+    int  endSpriteX;
+    int  endSpriteY;
+    
+    int  x;
+    int  y;
+    int  imY;
+    
+    int  w;
+    int  h;
+    int  imW;
+    int  imH;
+    
+    int  startByte;
+    int  numPaletteColors;
+
+    char drawAlphaSet;
+    char drawColorSet;
+
+    int  clipStartX     =  0;
+    int  clipEndX       =  MAXIGIN_GAME_NATIVE_W - 1;
+    int  clipStartY     =  0;
+    int  clipEndY       =  MAXIGIN_GAME_NATIVE_H - 1;
+    
+    
+    if( ! mx_areWeInMaxiginGameDrawFunction ) {
+
+        mingin_log( "Game tried to call maxigin_drawSprite "
+                    "from outside of maxiginGame_getNativePixels\n" );
+        return;
+        }
+
+    if( inSpriteHandle == -1 ) {
+        /* trying to draw a sprite that failed to load
+           draw a place-holder rect so that it's not totally invisible*/
+
+        maxigin_drawRect( inCenterX - 3,
+                          inCenterY - 3,
+                          inCenterX + 3,
+                          inCenterY + 3 );
+
+        maxigin_drawLine( inCenterX - 2,
+                          inCenterY - 2,
+                          inCenterX + 2,
+                          inCenterY + 2 );
+        return;
+        }
+    
+    if( inSpriteHandle >= mx_numSprites ) {
+        maxigin_logInt( "Game tried to draw an unknown sprite handle: ",
+                        inSpriteHandle );
+        }
+
+    
+    drawAlphaSet = 0;
+
+    if( mx_drawColor.comp.alpha < 255 ) {
+        drawAlphaSet = 1;
+        
+        if( mx_drawColor.comp.alpha == 0 ) {
+
+            /* draw alpha of 0 means sprite is invisible, skip it */
+            return;
+            }
+        }
+
+    drawColorSet = 0;
+
+    if( mx_drawColor.comp.red < 255
+        ||
+        mx_drawColor.comp.green < 255
+        ||
+        mx_drawColor.comp.blue < 255 ) {
+        
+        drawColorSet = 1;
+        }
+    
+    
+    w             =  mx_sprites[ inSpriteHandle ].w;
+    h             =  mx_sprites[ inSpriteHandle ].h;
+    startByte     =  mx_sprites[ inSpriteHandle ].startByte;
+
+    numPaletteColors  =  mx_sprites[ inSpriteHandle ].numPaletteColors;
+
+    imW           =  MAXIGIN_GAME_NATIVE_W;
+    imH           =  MAXIGIN_GAME_NATIVE_H;
+    
+    startImageX   =  inCenterX - w / 2;
+    startImageY   =  inCenterY - h / 2;
+    endImageX     =  startImageX + w;
+    endImageY     =  startImageY + h;
+
+    startSpriteX  =  0;
+    startSpriteY  =  0;
+    endSpriteX    =  w;
+    endSpriteY    =  h;
+
+    /* handle case where sprite is cut off by edge of game image */
+
+    /* also consider clipping rectangle */
+    if( mx_clipStackDepth > 0 ) {
+        int                    clipI  =  mx_clipStackDepth - 1;
+        MaxiginClipRectangle  *clip   =  &( mx_clipStack[ clipI ] );
+        
+        clipStartX = clip->startX;
+        clipEndX = clip->endX;
+        clipStartY = clip->startY;
+        clipEndY = clip->endY;
+        }
+        
+
+    if( startImageX < clipStartX ) {
+        startSpriteX += clipStartX - startImageX;
+        startImageX = clipStartX;
+        }
+    if( startImageY < clipStartY ) {
+        startSpriteY += clipStartY - startImageY;
+        startImageY = clipStartY;
+        }
+
+    if( endImageX > clipEndX + 1 ) {
+        endSpriteX -= ( endImageX - ( clipEndX + 1 ) );
+        }
+    if( endImageY > clipEndY + 1 ) {
+        endSpriteY -= ( endImageY - ( clipEndY + 1 ) );
+        }
+
+    if( startImageX >= imW
+        ||
+        startImageY >= imH
+        ||
+        endImageX   <=  0
+        ||
+        endImageY   <=  0 ) {
+
+        /* sprite drawn completely out of bounds, affecting no pixels at all */
+        return;
+        }
+    
+    
+    imY = startImageY;
+    
+    for( y = startSpriteY;
+         y < endSpriteY;
+         y ++ ) {
+
+        int spriteByte  =  startByte  +    y * 4 *   w   +  4 * startSpriteX;
+        int imageByte   =                imY * 3 * imW   +  3 * startImageX;
+
+        /* pixel bytes to read this row from */
+        const unsigned char  *spriteBytes  =  mx_spriteBytes;
+
+        if( numPaletteColors > 0 ) {
+            /* look up visible part of row in palette */
+            
+            const unsigned char  *indices  =
+                &( mx_spriteBytes[ startByte + y * w ] );
+            
+            const unsigned char  *palette  =
+                &( mx_spriteBytes[ startByte + w * h ] );
+
+            int  rowByte  =  0;
+            
+            for( x = startSpriteX;
+                 x < endSpriteX;
+                 x ++ ) {
+
+                const unsigned char  *c  =  &( palette[ indices[x] * 4 ] );
+
+                mx_paletteRowBytes[ rowByte ++ ] = c[0];
+                mx_paletteRowBytes[ rowByte ++ ] = c[1];
+                mx_paletteRowBytes[ rowByte ++ ] = c[2];
+                mx_paletteRowBytes[ rowByte ++ ] = c[3];
+                }
+
+            spriteBytes  =  mx_paletteRowBytes;
+            spriteByte   =  0;
+            }
+
+        if( mx_additiveBlend ) {
+            /* different row loop for additive blending */
+
+            for( x = startSpriteX;
+                 x < endSpriteX;
+                 x ++ ) {
+
+                unsigned char  r;
+                unsigned char  g;
+                unsigned char  b;
+                unsigned char  a  =  spriteBytes[ spriteByte + 3 ];
+                
+                if( drawAlphaSet ) {
+                    a = (unsigned char)( ( a * mx_drawColor.comp.alpha ) / 255 );
+                    }
+                
+                if( a == 0 ) {
+                    imageByte += 3;
+                    spriteByte += 4;
+                    continue;
+                    }
+
+                r = spriteBytes[ spriteByte ++ ];
+                g = spriteBytes[ spriteByte ++ ];
+                b = spriteBytes[ spriteByte ++ ];
+
+                if( drawColorSet ) {
+                    r = (unsigned char)( ( r * mx_drawColor.comp.red   ) / 255 );
+                    g = (unsigned char)( ( g * mx_drawColor.comp.green ) / 255 );
+                    b = (unsigned char)( ( b * mx_drawColor.comp.blue  ) / 255 );
+                    }
+                
+                if( a == 255 ) {
+
+                    int  v;
+
+                    /* red */
+                    v = mx_gameImageBuffer[ imageByte  ] + r;
+
+                    if( v > 255 ) {
+                        v = 255;
+                        }
+                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+
+                    imageByte  ++;
+
+                    /* green */
+                    v = mx_gameImageBuffer[ imageByte  ] + g;
+
+                    if( v > 255 ) {
+                        v = 255;
+                        }
+                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+
+                    imageByte  ++;
+
+                    /* blue */
+                    v = mx_gameImageBuffer[ imageByte  ] + b;
+
+                    if( v > 255 ) {
+                        v = 255;
+                        }
+                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+
+                    imageByte  ++;
+                    }
+                else {
+                    /* alpha blending */
+
+                    int  v;
+                    
+                    /* red */
+                    v = mx_gameImageBuffer[ imageByte ]
+                        +
+                        ( r * a ) / 255;
+                    
+                    if( v > 255 ) {
+                        v = 255;
+                        }
+                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+                
+                    imageByte  ++;
+
+                    /* green */
+                    v = mx_gameImageBuffer[ imageByte ]
+                        +
+                        ( g * a ) / 255;
+                    
+                    if( v > 255 ) {
+                        v = 255;
+                        }
+                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+                
+                    imageByte  ++;
+
+                    /* blue */
+                    v = mx_gameImageBuffer[ imageByte ]
+                        +
+                        ( b * a ) / 255;
+                    
+                    if( v > 255 ) {
+                        v = 255;
+                        }
+                    mx_gameImageBuffer[ imageByte ] = (unsigned char)v;
+                
+                    imageByte  ++;
+                    }
+            
+                /* skip the alpha in the sprite
+                   dest image has no alpha channel */
+                spriteByte ++;
+                }
+            }
+        else {
+            /* non-additive blending row loop */
+            
+            for( x = startSpriteX;
+                 x < endSpriteX;
+                 x ++ ) {
+            
+                unsigned char  r;
+                unsigned char  g;
+                unsigned char  b;
+                unsigned char  a  =  spriteBytes[ spriteByte + 3 ];
+
+                if( drawAlphaSet ) {
+                    a = (unsigned char)( ( a * mx_drawColor.comp.alpha ) / 255 );
+                    }
+                                
+                if( a == 0 ) {
+                    imageByte += 3;
+                    spriteByte += 4;
+                    continue;
+                    }
+
+                r = spriteBytes[ spriteByte ++ ];
+                g = spriteBytes[ spriteByte ++ ];
+                b = spriteBytes[ spriteByte ++ ];
+
+                if( drawColorSet ) {
+                    r = (unsigned char)( ( r * mx_drawColor.comp.red   ) / 255 );
+                    g = (unsigned char)( ( g * mx_drawColor.comp.green ) / 255 );
+                    b = (unsigned char)( ( b * mx_drawColor.comp.blue  ) / 255 );
+                    }
+                
+                if( a == 255 ) {
+                    /* RGBA bytes */
+                    mx_gameImageBuffer[ imageByte  ++ ] = r;
+
+                    mx_gameImageBuffer[ imageByte  ++ ] = g;
+
+                    mx_gameImageBuffer[ imageByte  ++ ] = b;
+                    }
+                else {
+                    /* alpha blending */
+
+                    /* red */
+                    mx_gameImageBuffer[ imageByte ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ imageByte ] * ( 255 - a )
+                              +
+                              r * a )
+                            /
+                            255 );
+                
+                    imageByte  ++;
+
+                    /* green */
+                    mx_gameImageBuffer[ imageByte ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ imageByte ] * ( 255 - a )
+                              +
+                              g * a )
+                            /
+                            255 );
+                
+                    imageByte  ++;
+
+                    /* blue */
+                    mx_gameImageBuffer[ imageByte ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ imageByte ] * ( 255 - a )
+                              +
+                              b * a )
+                            /
+                            255 );
+                
+                    imageByte  ++;
+                    }
+            
+                /* skip the alpha in the sprite
+                   dest image has no alpha channel */
+                spriteByte ++;
+                }
+            }
+        
+        imY ++;
+        }
+    
+    }
+
+
+
+static void mx_drawGlowSprite( int  inSpriteHandle,
+                               int  inCenterX,
+                               int  inCenterY ) {
+
+    char  oldAdditive  =  maxigin_drawGetAdditive();
+    
+    maxigin_drawBaseSprite( inSpriteHandle,
+                            inCenterX,
+                            inCenterY );
+
+    if( mx_sprites[ inSpriteHandle ].glowSpriteHandle != -1 ) {
+
+        maxigin_drawToggleAdditive( 1 );
+
+        maxigin_drawBaseSprite( mx_sprites[ inSpriteHandle ].glowSpriteHandle,
+                                inCenterX,
+                                inCenterY );
+
+        maxigin_drawToggleAdditive( oldAdditive );
+        }
+    }
+
+
+
+void maxigin_drawSprite( int  inSpriteHandle,
+                         int  inCenterX,
+                         int  inCenterY ) {
+
+    if( mx_sprites[ inSpriteHandle ].numShadows > 0 ) {
+
+        int           i;
+        MaxiginColor  oldColor  =  mx_drawColor;
+
+        maxigin_drawResetColor();
+
+        maxigin_drawSetAlpha( oldColor.comp.alpha );
+
+        for( i = 0;
+             i < mx_sprites[ inSpriteHandle ].numShadows;
+             i ++ ) {
+        
+            maxigin_drawBaseSprite( mx_sprites[ inSpriteHandle ].
+                                        shadowSpriteHandle[i],
+                                    inCenterX,
+                                    inCenterY );
+            }
+
+        mx_drawColor = oldColor;
+        }
+    
+    if( mx_sprites[ inSpriteHandle ].glowSpriteHandle != -1 ) {
+
+        mx_drawGlowSprite( inSpriteHandle,
+                           inCenterX,
+                           inCenterY );
+        }
+    else {
+        maxigin_drawBaseSprite( inSpriteHandle,
+                                inCenterX,
+                                inCenterY );
+        }
+    }
+
+
+
+void maxigin_drawSpriteGlowOnly( int  inSpriteHandle,
+                                 int  inCenterX,
+                                 int  inCenterY ) {
+    
+    if( mx_sprites[ inSpriteHandle ].glowSpriteHandle != -1 ) {
+        
+        char  oldAdditive  =  maxigin_drawGetAdditive();
+        
+        maxigin_drawToggleAdditive( 1 );
+
+        maxigin_drawBaseSprite( mx_sprites[ inSpriteHandle ].glowSpriteHandle,
+                                inCenterX,
+                                inCenterY );
+
+        maxigin_drawToggleAdditive( oldAdditive );
+        }
+    }
+
+
+
+void maxigin_drawSpriteShadowOnly( int  inSpriteHandle,
+                                   int  inCenterX,
+                                   int  inCenterY ) {
+    
+    if( mx_sprites[ inSpriteHandle ].numShadows > 0 ) {
+
+        int           i;
+        MaxiginColor  oldColor  =  mx_drawColor;
+
+        maxigin_drawResetColor();
+
+        maxigin_drawSetAlpha( oldColor.comp.alpha );
+
+        for( i = 0;
+             i < mx_sprites[ inSpriteHandle ].numShadows;
+             i ++ ) {
+        
+            maxigin_drawBaseSprite( mx_sprites[ inSpriteHandle ].
+                                        shadowSpriteHandle[i],
+                                    inCenterX,
+                                    inCenterY );
+            }
+
+        mx_drawColor = oldColor;
+        }
+    }
+
+
+
+void maxigin_getSpritePixel( int            inSpriteHandle,
+                             int            inPixelX,
+                             int            inPixelY,
+                             MaxiginColor  *outColor ) {
+
+    MaxiginSprite  *s  =  &( mx_sprites[ inSpriteHandle ] );
+    int             b;
+    
+    if( inPixelX < 0
+        ||
+        inPixelX >= s->w
+        ||
+        inPixelY < 0
+        ||
+        inPixelY >= s->h ) {
+
+        outColor->val[0] = 0;
+        outColor->val[1] = 0;
+        outColor->val[2] = 0;
+        outColor->val[3] = 0;
+        return;
+        }
+    
+    b = mx_getSpritePixelByte( s,
+                               inPixelY * s->w + inPixelX );
+
+    outColor->val[0] = mx_spriteBytes[ b++ ];
+    outColor->val[1] = mx_spriteBytes[ b++ ];
+    outColor->val[2] = mx_spriteBytes[ b++ ];
+    outColor->val[3] = mx_spriteBytes[ b++ ];
+    }
+
+
+char maxigin_isInSprite( int  inSpriteHandle,
+                         int  inCenterOffsetX,
+                         int  inCenterOffsetY ) {
+    MaxiginSprite  *s       =  &( mx_sprites[ inSpriteHandle ] );
+    int             pixelX  =  s->w / 2 + inCenterOffsetX;
+    int             pixelY  =  s->h / 2 + inCenterOffsetY;
+    int             b;
+    
+    if( pixelX < 0
+        ||
+        pixelX >= s->w
+        ||
+        pixelY < 0
+        ||
+        pixelY >= s->h ) {
+
+        return 0;
+        }
+
+    b = mx_getSpritePixelByte( s,
+                               pixelY * s->w + pixelX );
+
+    /* alpha byte for this pixel */
+    return ( mx_spriteBytes[ b + 3 ] > 0 );
+    }
+
+    
+
+
+void maxigin_drawExplodingSprite( int            inSpriteHandle,
+                                  int            inParticleHandle,
+                                  int            inCenterX,
+                                  int            inCenterY,
+                                  int            inExplosionCenterX,
+                                  int            inExplosionCenterY,
+                                  int            inMaxDistance,
+                                  int            inExplodeProgress,
+                                  int            inExplodeProgressMax,
+                                  unsigned char  inAlphaFade ) {
+    
+    MaxiginSprite  *s         =  &( mx_sprites[ inSpriteHandle ] );
+    int             x;
+    int             y;
+    int             b;
+    int             ex        =  inExplosionCenterX - inCenterX;
+    int             ey        =  inExplosionCenterY - inCenterY;
+    int             cx        =  s->w / 2;
+    int             cy        =  s->h / 2;
+
+    long             d;
+    int              pSprite  =  inParticleHandle;
+
+    long             red      =  mx_drawColor.comp.red;
+    long             green    =  mx_drawColor.comp.green;
+    long             blue     =  mx_drawColor.comp.blue;
+    long             alpha    =  mx_drawColor.comp.alpha;
+
+    alpha = ( alpha * inAlphaFade ) / 255;
+    
+    
+    /* d is scaled by a factor of 100 */
+    d = ( (long)inMaxDistance * 100 * (long) inExplodeProgress )
+        / inExplodeProgressMax;
+    
+
+    for( y = 0;
+         y < s->h;
+         y ++ ) {
+
+        int  dy     =  y - cy;
+        int  drawY  =  (int)( ( d * ( dy - ey ) ) / 100 ) + inCenterY + dy;
+
+        for( x = 0;
+             x < s->w;
+             x ++ ) {
+
+            int dx      = x - cx;
+            int  drawX  =  (int)( ( d * ( dx - ex ) ) / 100 ) + inCenterX + dx;
+
+            b = mx_getSpritePixelByte( s,
+                                       y * s->w + x );
+            
+            maxigin_drawSetColor(
+                (unsigned char)( ( mx_spriteBytes[ b     ] * red )
+                                 / 255 ),
+                (unsigned char)( ( mx_spriteBytes[ b + 1 ] * green )
+                                 / 255 ),
+                (unsigned char)( ( mx_spriteBytes[ b + 2 ] * blue )
+                                 / 255 ),
+                (unsigned char)( ( mx_spriteBytes[ b + 3 ] * alpha )
+                                 / 255 ) );
+
+            maxigin_drawSprite( pSprite,
+                                drawX,
+                                drawY );
+            }
+        }
+    }
+
+
+
+void maxigin_drawSpriteSparkles( int            inSpriteHandle,
+                                 int            inParticleHandle,
+                                 int            inCenterX,
+                                 int            inCenterY,
+                                 MaxiginRand   *inRand,
+                                 int            inNumSparkles,
+                                 unsigned char  inAlphaFade,
+                                 int            inStartX,
+                                 int            inEndX,
+                                 int            inStartY,
+                                 int            inEndY ) {
+
+    MaxiginSprite  *s         =  &( mx_sprites[ inSpriteHandle ] );
+    long            numDrawn  =  0;
+    int             pSprite   =  inParticleHandle;
+    int             numFail   =  0;
+    int             cx        =  s->w / 2;
+    int             cy        =  s->h / 2;
+    long            red       =  mx_drawColor.comp.red;
+    long            green     =  mx_drawColor.comp.green;
+    long            blue      =  mx_drawColor.comp.blue;
+    long            alpha     =  mx_drawColor.comp.alpha;
+
+
+    /* compound alpha here */
+    if( inAlphaFade < 255 ) {
+        alpha = ( alpha * inAlphaFade ) / 255;
+        }
+
+    if( inStartX == -1 ) {
+        inStartX = 0;
+        }
+    if( inEndX == -1 ) {
+        inEndX = s->w - 1;
+        }
+
+    if( inStartY == -1 ) {
+        inStartY = 0;
+        }
+    if( inEndY == -1 ) {
+        inEndY = s->h - 1;
+        }
+    
+    while( numDrawn < inNumSparkles ) {
+
+        int            y       =  maxigin_randRange( inRand,
+                                                     inStartY,
+                                                     inEndY );
+        int            x       =  maxigin_randRange( inRand,
+                                                     inStartX,
+                                                     inEndX );
+        
+        int            aTweak  =  maxigin_randRange( inRand,
+                                                     0,
+                                                     255 );
+        int            drawY;
+        int            drawX;
+
+        int            b       =  mx_getSpritePixelByte( s,
+                                                         y * s->w + x );
+
+        unsigned char  a       =  mx_spriteBytes[ b + 3 ];
+
+        if( a == 0 ) {
+            numFail ++;
+
+            if( numFail < 10 ) {
+                continue;
+                }
+            else {
+                /* 10 failures in a row looking for non-transparent pixel */
+                break;
+                }
+            }
+        numFail = 0;
+
+        drawY = inCenterY + ( y - cy );
+        drawX = inCenterX + ( x - cx );
+
+        maxigin_drawSetColor(
+            (unsigned char)( ( mx_spriteBytes[ b     ] * red )
+                             / 255 ),
+            (unsigned char)( ( mx_spriteBytes[ b + 1 ] * green )
+                             / 255 ),
+            (unsigned char)( ( mx_spriteBytes[ b + 2 ] * blue )
+                             / 255 ),
+            (unsigned char)( ( a * alpha * aTweak )
+                             / 65025 ) );
+
+            
+        maxigin_drawSprite( pSprite,
+                            drawX,
+                            drawY );
+
+        numDrawn ++;
+        }
+    
+        
+        
+    }
+
+
+
+static int mx_abs( int  inValue ) {
+    if( inValue < 0 ) {
+        return - inValue;
+        }
+    else {
+        return inValue;
+        }
+    }
+
+
+
+static void mx_drawLineLow( int  inStartX,
+                            int  inStartY,
+                            int  inEndX,
+                            int  inEndY ) {
+    
+    int  dX    =  inEndX - inStartX;
+    int  dY    =  inEndY - inStartY;
+    int  yDir  =  1;
+    int  d;
+    int  x;
+    int  y;
+    int  pixelStartByte;
+    int  lineA            =  mx_drawColor.comp.alpha;
+    
+    /* color components with alpha pre-multiplied */
+    int  linePreR         =  mx_drawColor.comp.red   * lineA;
+    int  linePreG         =  mx_drawColor.comp.green * lineA;
+    int  linePreB         =  mx_drawColor.comp.blue  * lineA;
+    int  lineScaledR      =  linePreR / 255;
+    int  lineScaledG      =  linePreG / 255;
+    int  lineScaledB      =  linePreB / 255;
+
+    
+    if( dY < 0 ) {
+        yDir = -1;
+        dY   = -dY;
+        }
+    
+    d = ( 2 * dY ) - dX;
+    
+    y = inStartY;
+
+
+    /* easy bounds checking on end for x, truncate line */
+    if( inEndX >= MAXIGIN_GAME_NATIVE_W ) {
+        inEndX = MAXIGIN_GAME_NATIVE_W - 1;
+        }
+
+    /* walk through start of line until it is in-bounds in our image */
+    while( inStartX < 0
+           ||
+           y < 0
+           ||
+           y >= MAXIGIN_GAME_NATIVE_H ) {
+
+        inStartX ++;
+
+        if( inStartX > inEndX ) {
+            break;
+            }
+        
+        if( d > 0 ) {
+        
+            y += yDir;
+            
+            d += 2 * ( dY - dX );
+            }
+        else {
+            d += 2 * dY;
+            }
+        }
+
+    if( inStartX > inEndX
+        ||
+        y >= MAXIGIN_GAME_NATIVE_H
+        ||
+        y < 0 ) {
+
+        /* line is entirely outside of our image */
+        return;
+        }
+
+    
+    pixelStartByte =
+        y * MAXIGIN_GAME_NATIVE_W * 3
+        +
+        inStartX * 3;
+    
+    for( x  = inStartX;
+         x <= inEndX;
+         x ++ ) {
+
+        if( mx_additiveBlend ) {
+            
+            int  v;
+
+            v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
+
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
+
+                
+            v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
+                
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+
+                
+            v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
+                
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v;
+
+            /* next col */
+            pixelStartByte += 3;
+            }
+        else {
+            if( lineA == 255 ) {
+        
+                /* no blend, pure replace */
+                mx_gameImageBuffer[ pixelStartByte ++ ] =
+                    mx_drawColor.comp.red;
+                
+                mx_gameImageBuffer[ pixelStartByte ++ ] =
+                    mx_drawColor.comp.green;
+                
+                mx_gameImageBuffer[ pixelStartByte ++ ] =
+                    mx_drawColor.comp.blue;
+                
+                }
+            else {
+                
+                /* alpha weighted blend, most expensive case */
+                
+                mx_gameImageBuffer[ pixelStartByte ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte ]
+                          * ( 255 - lineA )
+                          +
+                          linePreR )
+                        /
+                        255 );
+
+                mx_gameImageBuffer[ pixelStartByte + 1 ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte + 1 ]
+                          * ( 255 - lineA )
+                          +
+                          linePreG )
+                        /
+                        255 );
+
+                
+                mx_gameImageBuffer[ pixelStartByte + 2 ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte + 2 ]
+                          * ( 255 - lineA )
+                          +
+                          linePreB )
+                        /
+                        255 );
+                
+                /* next col */
+                pixelStartByte += 3;
+                }
+            }
+        
+        if( d > 0 ) {
+        
+            y += yDir;
+
+
+            /* bail out if y ever steps out of bounds */
+            if( y < 0
+                ||
+                y >= MAXIGIN_GAME_NATIVE_H ) {
+                break;
+                }
+            
+            pixelStartByte += yDir * MAXIGIN_GAME_NATIVE_W * 3;
+                
+            d += 2 * ( dY - dX );
+            }
+        else {
+            d += 2 * dY;
+            }
+
+        }
+    }
+
+
+
+static void mx_drawLineHigh( int  inStartX,
+                             int  inStartY,
+                             int  inEndX,
+                             int  inEndY ) {
+    
+    int  dX               =  inEndX - inStartX;
+    int  dY               =  inEndY - inStartY;
+    int  xDir             =  1;
+    int  d;
+    int  x;
+    int  y;
+    int  pixelStartByte;
+    int  lineA            =  mx_drawColor.comp.alpha;
+    
+    /* color components with alpha pre-multiplied */
+    int  linePreR         =  mx_drawColor.comp.red   * lineA;
+    int  linePreG         =  mx_drawColor.comp.green * lineA;
+    int  linePreB         =  mx_drawColor.comp.blue  * lineA;
+    int  lineScaledR      =  linePreR / 255;
+    int  lineScaledG      =  linePreG / 255;
+    int  lineScaledB      =  linePreB / 255;
+    
+    
+    if( dX < 0 ) {
+        xDir = -1;
+        dX   = -dX;
+        }
+    
+    d = ( 2 * dX ) - dY;
+    
+    x = inStartX;
+
+    
+    /* easy bounds checking on end for y, truncate line */
+    if( inEndY >= MAXIGIN_GAME_NATIVE_H ) {
+        inEndY = MAXIGIN_GAME_NATIVE_H - 1;
+        }
+
+    /* walk through start of line until it is in-bounds in our image */
+    while( inStartY < 0
+           ||
+           x < 0
+           ||
+           x >= MAXIGIN_GAME_NATIVE_W ) {
+
+        inStartY ++;
+
+        if( inStartY > inEndY ) {
+            break;
+            }
+        
+        if( d > 0 ) {
+        
+            x += xDir;
+            
+            d += 2 * ( dX - dY );
+            }
+        else {
+            d += 2 * dX;
+            }
+        }
+
+    if( inStartY > inEndY
+        ||
+        x < 0
+        ||
+        x >= MAXIGIN_GAME_NATIVE_W ) {
+
+        /* line is entirely outside of our image */
+        return;
+        }
+    
+    pixelStartByte =
+        inStartY * MAXIGIN_GAME_NATIVE_W * 3
+        +
+        x * 3;
+    
+    for( y  = inStartY;
+         y <= inEndY;
+         y ++ ) {
+        
+        if( mx_additiveBlend ) {
+            
+            int  v;
+
+            v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
+
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
+
+                
+            v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
+                
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+
+                
+            v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
+                
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v;
+            }
+        else {
+            if( lineA == 255 ) {
+        
+                /* no blend, pure replace */
+                mx_gameImageBuffer[ pixelStartByte     ] =
+                    mx_drawColor.comp.red;
+                
+                mx_gameImageBuffer[ pixelStartByte + 1 ] =
+                    mx_drawColor.comp.green;
+                
+                mx_gameImageBuffer[ pixelStartByte + 2 ] =
+                    mx_drawColor.comp.blue;
+                
+                }
+            else {
+                
+                /* alpha weighted blend, most expensive case */
+                
+                mx_gameImageBuffer[ pixelStartByte ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte ]
+                          * ( 255 - lineA )
+                          +
+                          linePreR )
+                        /
+                        255 );
+
+                mx_gameImageBuffer[ pixelStartByte + 1 ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte + 1 ]
+                          * ( 255 - lineA )
+                          +
+                          linePreG )
+                        /
+                        255 );
+
+                
+                mx_gameImageBuffer[ pixelStartByte + 2 ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte + 2 ]
+                          * ( 255 - lineA )
+                          +
+                          linePreB )
+                        /
+                        255 );
+                }
+            }
+                
+        
+        if( d > 0 ) {
+        
+            x += xDir;
+
+            /* bail out if x ever steps out of bounds */
+            if( x < 0
+                ||
+                x >= MAXIGIN_GAME_NATIVE_W ) {
+                break;
+                }
+            
+            pixelStartByte += xDir * 3;
+            
+            d += 2 * ( dX - dY );
+            }
+        else {
+            d += 2 * dX;
+            }
+
+        /* next row */
+        pixelStartByte += MAXIGIN_GAME_NATIVE_W * 3;
+        }
+    }
+
+
+
+/* Draws a horizontal line with no bounds or direction checking.
+
+   Parameters:
+
+       inStartX   the start x location of the line
+                  >= 0
+                  <  MAXIGIN_GAME_NATIVE_W
+                  
+       inEndX     the end x location of the line
+                  >= 0
+                  <  MAXIGIN_GAME_NATIVE_W
+                  >= inStartX
+
+       inY        the y location of the line
+                  >= 0
+                  <  MAXIGIN_GAME_NATIVE_H
+*/
+static void mx_drawFastHorizontalLine( int  inStartX,
+                                       int  inEndX,
+                                       int  inY ) {
+            
+    int  x;
+    int  pixelStartByte;
+    int  lineA            =  mx_drawColor.comp.alpha;
+        
+    /* color components with alpha pre-multiplied */
+    int  linePreR         =  mx_drawColor.comp.red   * lineA;
+    int  linePreG         =  mx_drawColor.comp.green * lineA;
+    int  linePreB         =  mx_drawColor.comp.blue  * lineA;
+    int  lineScaledR      =  linePreR / 255;
+    int  lineScaledG      =  linePreG / 255;
+    int  lineScaledB      =  linePreB / 255;
+        
+    pixelStartByte  =  inY * MAXIGIN_GAME_NATIVE_W * 3 + inStartX * 3;
+        
+    if( mx_additiveBlend ) {
+        /* additive blend */
+            
+        for( x  = inStartX;
+             x <= inEndX;
+             x ++ ) {
+                
+            int  v;
+
+            v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
+
+            v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+
+            v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
+            if( v > 255 ) {
+                v = 255;
+                }
+            mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v; 
+
+            /* next col */
+            pixelStartByte += 3;
+            }
+        }
+    else {
+        if( lineA == 255 ) {
+            /* no blend, pure replace */
+                
+            for( x  = inStartX;
+                 x <= inEndX;
+                 x ++ ) {
+                    
+                mx_gameImageBuffer[ pixelStartByte ++ ] =
+                    mx_drawColor.comp.red;
+                
+                mx_gameImageBuffer[ pixelStartByte ++ ] =
+                    mx_drawColor.comp.green;
+                
+                mx_gameImageBuffer[ pixelStartByte ++ ] =
+                    mx_drawColor.comp.blue;
+                }
+            }
+        else {
+            /* weighted alpha blend */
+                
+            for( x  = inStartX;
+                 x <= inEndX;
+                 x ++ ) {
+                    
+                mx_gameImageBuffer[ pixelStartByte ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte ]
+                          * ( 255 - lineA )
+                          +
+                          linePreR )
+                        /
+                        255 );
+
+                mx_gameImageBuffer[ pixelStartByte + 1 ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte + 1 ]
+                          * ( 255 - lineA )
+                          +
+                          linePreG )
+                        /
+                        255 );
+
+                
+                mx_gameImageBuffer[ pixelStartByte + 2 ] =
+                    (unsigned char)( 
+                        ( mx_gameImageBuffer[ pixelStartByte + 2 ]
+                          * ( 255 - lineA )
+                          +
+                          linePreB )
+                        /
+                        255 );
+
+                /* next col */
+                pixelStartByte += 3;
+                } 
+            }
+        }
+    }
+
+
+
+void maxigin_drawLine( int  inStartX,
+                       int  inStartY,
+                       int  inEndX,
+                       int  inEndY ) {
+
+    
+    if( mx_drawColor.comp.alpha == 0 ) {
+        return;
+        }
+    
+
+    /* special case: vert line */
+    if( inStartX == inEndX ) {
+
+        int  y;
+        int  temp;
+        int  pixelStartByte;
+        int  lineA            =  mx_drawColor.comp.alpha;
+        int  rowHop;
+        
+        /* color components with alpha pre-multiplied */
+        int  linePreR         =  mx_drawColor.comp.red   * lineA;
+        int  linePreG         =  mx_drawColor.comp.green * lineA;
+        int  linePreB         =  mx_drawColor.comp.blue  * lineA;
+        int  lineScaledR      =  linePreR / 255;
+        int  lineScaledG      =  linePreG / 255;
+        int  lineScaledB      =  linePreB / 255;
+        
+        if( inStartX < 0
+            ||
+            inStartX >= MAXIGIN_GAME_NATIVE_W ) {
+            
+            /* vertical line outside left or right side of image */
+            return;
+            }
+
+        if( inStartY < 0
+            &&
+            inEndY < 0 ) {
+            /* completely outside top side of image */
+            return;
+            }
+        if( inStartY >= MAXIGIN_GAME_NATIVE_H
+            &&
+            inEndY   >= MAXIGIN_GAME_NATIVE_H ) {
+            /* completely outside bottom side of image */
+            return;
+            }
+
+        /* truncate vertical line inside image */
+        if( inStartY < 0 ) {
+            inStartY = 0;
+            }
+        else if( inStartY >= MAXIGIN_GAME_NATIVE_H ) {
+            inStartY = MAXIGIN_GAME_NATIVE_H - 1;
+            }
+        if( inEndY < 0 ) {
+            inEndY = 0;
+            }
+        else if( inEndY >= MAXIGIN_GAME_NATIVE_H ) {
+            inEndY = MAXIGIN_GAME_NATIVE_H - 1;
+            }
+        
+
+        /* fix direction */
+        if( inStartY > inEndY ) {
+            temp     = inEndY;
+            inEndY   = inStartY;
+            inStartY = temp;
+            }
+        
+
+        rowHop          =  MAXIGIN_GAME_NATIVE_W * 3;
+        pixelStartByte  =  inStartY * rowHop + inStartX * 3;
+        
+        
+        if( mx_additiveBlend ) {
+            /* additive blend */
+            
+            for( y  = inStartY;
+                 y <= inEndY;
+                 y ++ ) {
+                
+                int  v;
+
+                v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
+                if( v > 255 ) {
+                    v = 255;
+                    }
+                mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
+
+                v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
+                if( v > 255 ) {
+                    v = 255;
+                    }
+                mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+
+                v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
+                if( v > 255 ) {
+                    v = 255;
+                    }
+                mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v; 
+
+                /* next row */
+                pixelStartByte += rowHop;
+                }
+            }
+        else {
+            if( lineA == 255 ) {
+                /* no blend, pure replace */
+                
+                for( y  = inStartY;
+                     y <= inEndY;
+                     y ++ ) {
+                    
+                    mx_gameImageBuffer[ pixelStartByte     ] =
+                        mx_drawColor.comp.red;
+                
+                    mx_gameImageBuffer[ pixelStartByte + 1 ] =
+                        mx_drawColor.comp.green;
+                
+                    mx_gameImageBuffer[ pixelStartByte + 2 ] =
+                        mx_drawColor.comp.blue;
+
+                    /* next row */
+                    pixelStartByte += rowHop;
+                    }
+                }
+            else {
+                /* weighted alpha blend */
+                
+                for( y  = inStartY;
+                     y <= inEndY;
+                     y ++ ) {
+                    
+                    mx_gameImageBuffer[ pixelStartByte ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ pixelStartByte ]
+                              * ( 255 - lineA )
+                              +
+                              linePreR )
+                            /
+                            255 );
+
+                    mx_gameImageBuffer[ pixelStartByte + 1 ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ pixelStartByte + 1 ]
+                              * ( 255 - lineA )
+                              +
+                              linePreG )
+                            /
+                            255 );
+
+                
+                    mx_gameImageBuffer[ pixelStartByte + 2 ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ pixelStartByte + 2 ]
+                              * ( 255 - lineA )
+                              +
+                              linePreB )
+                            /
+                            255 );
+                    
+                    /* next row */
+                    pixelStartByte += rowHop;
+                    }
+                }
+            }
+        return;
+        }
+
+    
+    /* special case: horizontal line */
+    if( inStartY == inEndY ) {
+        
+        int  temp;
+
+        if( inStartY < 0
+            ||
+            inStartY >= MAXIGIN_GAME_NATIVE_H ) {
+            
+            /* horizontal line above or below image */
+            return;
+            }
+
+        if( inStartX < 0
+            &&
+            inEndX < 0 ) {
+            /* completely outside left side of image */
+            return;
+            }
+        if( inStartX >= MAXIGIN_GAME_NATIVE_W
+            &&
+            inEndX   >= MAXIGIN_GAME_NATIVE_W ) {
+            /* completely outside right side of image */
+            return;
+            }
+        
+        /* truncate horizontal line inside image */
+        if( inStartX < 0 ) {
+            inStartX = 0;
+            }
+        else if( inStartX >= MAXIGIN_GAME_NATIVE_W ) {
+            inStartX = MAXIGIN_GAME_NATIVE_W - 1;
+            }
+        if( inEndX < 0 ) {
+            inEndX = 0;
+            }
+        else if( inEndX >= MAXIGIN_GAME_NATIVE_W ) {
+            inEndX = MAXIGIN_GAME_NATIVE_W - 1;
+            }
+
+        /* fix direction */
+        if( inStartX > inEndX ) {
+            temp     = inEndX;
+            inEndX   = inStartX;
+            inStartX = temp;
+            }
+
+        mx_drawFastHorizontalLine( inStartX,
+                                   inEndX,
+                                   inStartY );
+        return;
+        }
+    
+    
+    /* General-case Bresenham's line algorithm */
+
+    if( mx_abs( inEndY - inStartY )
+        <
+        mx_abs( inEndX - inStartX ) ) {
+        
+        if( inStartX > inEndX ) {
+            mx_drawLineLow( inEndX, inEndY, inStartX, inStartY );
+            }
+        else {
+            mx_drawLineLow( inStartX, inStartY, inEndX, inEndY );
+            }
+        }
+    else {
+        if( inStartY > inEndY ) {
+            mx_drawLineHigh( inEndX, inEndY, inStartX, inStartY );
+            }
+        else {
+            mx_drawLineHigh( inStartX, inStartY, inEndX, inEndY );
+            }
+        }
+    }
+
+
+
+void maxigin_drawRect( int  inStartX,
+                       int  inStartY,
+                       int  inEndX,
+                       int  inEndY ) {
+
+    /* prevent overlapping pixels at corners.
+       to make this easier, first ensure start is top left
+       and end is bottom right. */
+
+    int  temp;
+
+    if( inStartX > inEndX ) {
+        temp     = inEndX;
+        inEndX   = inStartX;
+        inStartX = temp;
+        }
+    if( inStartY > inEndY ) {
+        temp     = inEndY;
+        inEndY   = inStartY;
+        inStartY = temp;
+        }
+        
+    maxigin_drawLine( inStartX,
+                      inStartY,
+                      inStartX,
+                      inEndY );
+    
+    maxigin_drawLine( inStartX + 1,  /* no overlap */
+                      inEndY,
+                      inEndX,
+                      inEndY );
+    
+    maxigin_drawLine( inEndX,
+                      inEndY - 1,    /* no overlap */
+                      inEndX,
+                      inStartY );
+    
+    maxigin_drawLine( inEndX - 1,    /* no overlap */
+                      inStartY,
+                      inStartX + 1,  /* no overlap */
+                      inStartY );
+    }
+
+
+
+void maxigin_drawFillRect( int  inStartX,
+                           int  inStartY,
+                           int  inEndX,
+                           int  inEndY ) {
+
+    int  x;
+    int  y;
+    int  pixelStartByte;
+    int  lineA            =  mx_drawColor.comp.alpha;
+    int  rowHop;
+    int  temp;
+    
+    /* color components with alpha pre-multiplied */   
+    int  linePreR         =  mx_drawColor.comp.red   * lineA;
+    int  linePreG         =  mx_drawColor.comp.green * lineA;
+    int  linePreB         =  mx_drawColor.comp.blue  * lineA;
+    int  lineScaledR      =  linePreR / 255;
+    int  lineScaledG      =  linePreG / 255;
+    int  lineScaledB      =  linePreB / 255;
+    
+    if( lineA == 0 ) {
+        return;
+        }
+
+    /* skip rects that are completely out of bounds */
+    if( inStartX < 0
+        &&
+        inEndX < 0 ) {
+        
+        return;
+        }
+    if( inStartX >= MAXIGIN_GAME_NATIVE_W
+        &&
+        inEndX   >= MAXIGIN_GAME_NATIVE_W ) {
+        
+        return;
+        }
+    if( inStartY < 0
+        &&
+        inEndY < 0 ) {
+        
+        return;
+        }
+    if( inStartY >= MAXIGIN_GAME_NATIVE_H
+        &&
+        inEndY   >= MAXIGIN_GAME_NATIVE_H ) {
+        
+        return;
+        }
+    
+    /* trim to be in-bounds of image */
+    if( inStartX < 0 ) {
+        inStartX = 0;
+        }
+    if( inStartX >= MAXIGIN_GAME_NATIVE_W ) {
+        inStartX = MAXIGIN_GAME_NATIVE_W - 1;
+        }
+    if( inEndX < 0 ) {
+        inEndX = 0;
+        }
+    if( inEndX >= MAXIGIN_GAME_NATIVE_W ) {
+        inEndX = MAXIGIN_GAME_NATIVE_W - 1;
+        }
+    if( inStartY < 0 ) {
+        inStartY = 0;
+        }
+    if( inStartY >= MAXIGIN_GAME_NATIVE_H ) {
+        inStartY = MAXIGIN_GAME_NATIVE_H - 1;
+        }
+    if( inEndY < 0 ) {
+        inEndY = 0;
+        }
+    if( inEndY >= MAXIGIN_GAME_NATIVE_H ) {
+        inEndY = MAXIGIN_GAME_NATIVE_H - 1;
+        }
+
+    /* fix draw direction */
+    if( inStartX > inEndX ) {
+        temp     = inEndX;
+        inEndX   = inStartX;
+        inStartX = temp;
+        }
+    if( inStartY > inEndY ) {
+        temp     = inEndY;
+        inEndY   = inStartY;
+        inStartY = temp;
+        }
+
+    rowHop         = MAXIGIN_GAME_NATIVE_W * 3;
+    pixelStartByte = inStartY * rowHop + inStartX * 3;
+
+    if( mx_additiveBlend ) {
+        /* additive blend */
+        
+        for( y =  inStartY;
+             y <= inEndY;
+             y ++ ) {
+
+            pixelStartByte = y * rowHop + inStartX * 3;
+            
+            for( x =  inStartX;
+                 x <= inEndX;
+                 x ++ ) {
+                
+                int  v;
+
+                v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
+                if( v > 255 ) {
+                    v = 255;
+                    }
+                mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
+
+                v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
+                if( v > 255 ) {
+                    v = 255;
+                    }
+                mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+
+                v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
+                if( v > 255 ) {
+                    v = 255;
+                    }
+                mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v; 
+
+                /* next col */
+                pixelStartByte += 3;
+                }
+            }
+        }
+    else {
+
+        if( lineA == 255 ) {
+            /* replace color, no blend */
+            
+            for( y =  inStartY;
+                 y <= inEndY;
+                 y ++ ) {
+
+                pixelStartByte = y * rowHop + inStartX * 3;
+
+                for( x =  inStartX;
+                     x <= inEndX;
+                     x ++ ) {
+
+                    mx_gameImageBuffer[ pixelStartByte ++ ] =
+                        mx_drawColor.comp.red;
+                    
+                    mx_gameImageBuffer[ pixelStartByte ++ ] =
+                        mx_drawColor.comp.green;
+                    
+                    mx_gameImageBuffer[ pixelStartByte ++ ] =
+                        mx_drawColor.comp.blue;
+                    }
+                }
+            }
+        else {
+            /* weighted alpha belnd */
+                    
+            for( y =  inStartY;
+                 y <= inEndY;
+                 y ++ ) {
+
+                pixelStartByte = y * rowHop + inStartX * 3;
+
+                for( x =  inStartX;
+                     x <= inEndX;
+                     x ++ ) {
+                                     
+                    mx_gameImageBuffer[ pixelStartByte ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ pixelStartByte ]
+                              * ( 255 - lineA )
+                              +
+                              linePreR )
+                            /
+                            255 );
+
+                    mx_gameImageBuffer[ pixelStartByte + 1 ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ pixelStartByte + 1 ]
+                              * ( 255 - lineA )
+                              +
+                              linePreG )
+                            /
+                            255 );
+                
+                    mx_gameImageBuffer[ pixelStartByte + 2 ] =
+                        (unsigned char)( 
+                            ( mx_gameImageBuffer[ pixelStartByte + 2 ]
+                              * ( 255 - lineA )
+                              +
+                              linePreB )
+                            /
+                            255 );
+
+                    /* next col */
+                    pixelStartByte += 3;
+                    }
+                }
+            }
+        }   
+    }
+
+
+
+void maxigin_initGUI( MaxiginGUI *inGUI ) {
+
+    inGUI->zeroOffsetX        = MAXIGIN_GAME_NATIVE_W / 2;
+    inGUI->zeroOffsetY        = MAXIGIN_GAME_NATIVE_H / 2;
+    inGUI->fade               = 255;
+    inGUI->hot                = 0;
+    inGUI->active             = 0;
+    inGUI->forceHot           = 0;
+    inGUI->mouseDown          = 0;
+    inGUI->activeMouseOffsetX = 0;
+    inGUI->activeMouseOffsetY = 0;
+    inGUI->numDrawComponents  = 0;
+    }
+
+
+
+void maxigin_drawGUI( MaxiginGUI *inGUI ) {
+
+    int            i;
+    int            drawType;
+    int            xO         =  inGUI->zeroOffsetX;
+    int            yO         =  inGUI->zeroOffsetY;
+    unsigned char  fade       =  inGUI->fade;
+    
+    for( i = 0;
+         i < inGUI->numDrawComponents;
+         i ++ ) {
+
+        drawType = inGUI->drawComponents[i].drawType;
+        
+        maxigin_drawToggleAdditive( inGUI->drawComponents[i].additiveBlend );
+
+        if( drawType == MX_GUI_DRAW_LINE
+            ||
+            drawType == MX_GUI_DRAW_RECT
+            ||
+            drawType == MX_GUI_FILL_RECT
+            ||
+            drawType == MX_GUI_DRAW_SPRITE
+            ||
+            drawType == MX_GUI_DRAW_SPRITE_SEQUENCE
+            ||
+            drawType == MX_GUI_DRAW_TEXT
+            ||
+            drawType == MX_GUI_DRAW_LANG_TEXT ) {
+
+            maxigin_drawSetColor(
+                inGUI->drawComponents[i].red,
+                inGUI->drawComponents[i].green,
+                inGUI->drawComponents[i].blue,
+                (unsigned char)(
+                    ( inGUI->drawComponents[i].alpha * fade ) / 255 ) );
+            }
+
+        switch( drawType ) {
+
+            case MX_GUI_SUB_PANEL_START:
+                xO  += inGUI->drawComponents[i].drawParams.panelStart.plusX;
+                yO  += inGUI->drawComponents[i].drawParams.panelStart.plusY;
+                fade = inGUI->drawComponents[i].drawParams.panelStart.newFade;
+                break;
+                
+            case MX_GUI_SUB_PANEL_END:
+                xO  += inGUI->drawComponents[i].drawParams.panelEnd.plusX;
+                yO  += inGUI->drawComponents[i].drawParams.panelEnd.plusY;
+                fade = inGUI->drawComponents[i].drawParams.panelEnd.oldFade;
+                break;
+                
+            case MX_GUI_DRAW_LINE:
+                maxigin_drawLine(
+                    inGUI->drawComponents[i].drawParams.line.startX + xO,
+                    inGUI->drawComponents[i].drawParams.line.startY + yO,
+                    inGUI->drawComponents[i].drawParams.line.endX + xO,
+                    inGUI->drawComponents[i].drawParams.line.endY + yO );
+                break;
+                
+            case MX_GUI_DRAW_RECT:
+                maxigin_drawRect(
+                    inGUI->drawComponents[i].drawParams.rect.startX + xO,
+                    inGUI->drawComponents[i].drawParams.rect.startY + yO,
+                    inGUI->drawComponents[i].drawParams.rect.endX + xO,
+                    inGUI->drawComponents[i].drawParams.rect.endY + yO );
+                break;
+                
+            case MX_GUI_FILL_RECT:
+                maxigin_drawFillRect(
+                    inGUI->drawComponents[i].drawParams.rect.startX + xO,
+                    inGUI->drawComponents[i].drawParams.rect.startY + yO,
+                    inGUI->drawComponents[i].drawParams.rect.endX + xO,
+                    inGUI->drawComponents[i].drawParams.rect.endY + yO );
+                break;
+                
+            case MX_GUI_DRAW_SPRITE:
+                maxigin_drawSprite(
+                    inGUI->drawComponents[i].drawParams.sprite.spriteHandle,
+                    inGUI->drawComponents[i].drawParams.sprite.centerX + xO,
+                    inGUI->drawComponents[i].drawParams.sprite.centerY + yO );
+                break;
+            case MX_GUI_DRAW_SPRITE_SEQUENCE: {
+
+                int  s;
+                int  x   =  inGUI->drawComponents[i].
+                                drawParams.spriteSequence.startCenterX + xO;
+                int  y   =  inGUI->drawComponents[i].
+                                drawParams.spriteSequence.startCenterY + yO;
+                
+                for( s = 0;
+                     s < inGUI->drawComponents[i].
+                         drawParams.spriteSequence.count;
+                     s ++ ) {
+
+                    maxigin_drawSprite(
+                        inGUI->drawComponents[i].
+                            drawParams.spriteSequence.spriteHandle,
+                        x,
+                        y );
+                
+                    x += inGUI->drawComponents[i].
+                        drawParams.spriteSequence.offsetX;
+                    y += inGUI->drawComponents[i].
+                        drawParams.spriteSequence.offsetY;
+                    }
+                
+                }
+                break;
+            case MX_GUI_DRAW_TEXT:
+                maxigin_drawText(
+                    inGUI->drawComponents[i].drawParams.text.fontHandle,
+                    inGUI->drawComponents[i].drawParams.text.textString,
+                    inGUI->drawComponents[i].drawParams.text.anchorX + xO,
+                    inGUI->drawComponents[i].drawParams.text.anchorY + yO,
+                    inGUI->drawComponents[i].drawParams.text.align );
+                break;    
+            case MX_GUI_DRAW_LANG_TEXT:
+                maxigin_drawLangText(
+                    inGUI->drawComponents[i].drawParams.langText.phraseKey,
+                    inGUI->drawComponents[i].drawParams.langText.anchorX + xO,
+                    inGUI->drawComponents[i].drawParams.langText.anchorY + yO,
+                    inGUI->drawComponents[i].drawParams.langText.align );
+                break;
+            }
+        }
+    }
+
+
+
+void maxigin_startGUI( MaxiginGUI *inGUI ) {
+    inGUI->zeroOffsetX        = MAXIGIN_GAME_NATIVE_W / 2;
+    inGUI->zeroOffsetY        = MAXIGIN_GAME_NATIVE_H / 2;
+    inGUI->fade               = 255;
+    inGUI->numDrawComponents = 0;
+    }
+
+
+
+void maxigin_endGUI( MaxiginGUI *inGUI ) {
+    if( ! inGUI->mouseDown ) {
+
+        if( mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON ) ) {
+
+            /* The button was pressed fresh this step, but NONE
+               of our GUI components were hit by it.
+               Mark it as pressed now, so none will react to it's pressed
+               state by accident next step. */
+
+            inGUI->mouseDown = 1;
+            }
+        }
+    else {
+        /* mouse marked as held down, has it released? */
+        if( ! mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON ) ) {
+
+            inGUI->mouseDown = 0;
+
+            /* endGUI called after all of our components have had a chance
+               to update and notice that the mouse is no longer down.
+               Any active component should have become non-active.
+               However, if our GUI state is being loaded from a saved game
+               state, this might not be the case (if a component was active
+               when the game was saved). */
+            
+            inGUI->active = 0;
+            }
+        }
+        
+    }
+
+
+
+static void mx_guiSetColor( MaxiginGUI    *inGUI,
+                            int            inDrawComponentIndex,
+                            char           inAdditiveBlend,
+                            MaxiginColor  *inColor ) {
+
+    int  i  =  inDrawComponentIndex;
+    
+    inGUI->drawComponents[i].additiveBlend = inAdditiveBlend;
+
+    inGUI->drawComponents[i].red   = inColor->comp.red;
+    inGUI->drawComponents[i].green = inColor->comp.green;
+    inGUI->drawComponents[i].blue  = inColor->comp.blue;
+    inGUI->drawComponents[i].alpha = inColor->comp.alpha;
+    }
+
+
+
+static void mx_guiAddLine( MaxiginGUI    *inGUI,
+                           char           inAdditiveBlend,
+                           MaxiginColor  *inColor,
+                           int            inStartX,
+                           int            inStartY,
+                           int            inEndX,
+                           int            inEndY ) {
+
+    int  i  =  inGUI->numDrawComponents;
+
+    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
+        mingin_log( "Error:  trying to add a line to a full "
+                    "MaxiginGUI instance.\n" );
+        return;
+        }
+
+    mx_guiSetColor( inGUI,
+                    i,
+                    inAdditiveBlend,
+                    inColor );
+
+    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_LINE;
+    
+    inGUI->drawComponents[i].drawParams.line.startX = inStartX;
+    inGUI->drawComponents[i].drawParams.line.startY = inStartY;
+    inGUI->drawComponents[i].drawParams.line.endX   = inEndX;
+    inGUI->drawComponents[i].drawParams.line.endY   = inEndY;
+
+    inGUI->numDrawComponents ++;
+    }
+
+
+
+static void mx_guiAddRect( MaxiginGUI    *inGUI,
+                           char           inAdditiveBlend,
+                           MaxiginColor  *inColor,
+                           int            inStartX,
+                           int            inStartY,
+                           int            inEndX,
+                           int            inEndY,
+                           int            inDrawType ) {
+
+    int  i  =  inGUI->numDrawComponents;
+
+    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
+        mingin_log( "Error:  trying to add a rectangle to a full "
+                    "MaxiginGUI instance.\n" );
+        return;
+        }
+
+    mx_guiSetColor( inGUI,
+                    i,
+                    inAdditiveBlend,
+                    inColor );
+
+    inGUI->drawComponents[i].drawType = inDrawType;
+    
+    inGUI->drawComponents[i].drawParams.rect.startX = inStartX;
+    inGUI->drawComponents[i].drawParams.rect.startY = inStartY;
+    inGUI->drawComponents[i].drawParams.rect.endX   = inEndX;
+    inGUI->drawComponents[i].drawParams.rect.endY   = inEndY;
+
+    inGUI->numDrawComponents ++;
+    }
+
+
+static void mx_guiAddDrawRect( MaxiginGUI    *inGUI,
+                               char           inAdditiveBlend,
+                               MaxiginColor  *inColor,
+                               int            inStartX,
+                               int            inStartY,
+                               int            inEndX,
+                               int            inEndY ) {
+
+    mx_guiAddRect( inGUI,
+                   inAdditiveBlend,
+                   inColor,
+                   inStartX,
+                   inStartY,
+                   inEndX,
+                   inEndY,
+                   MX_GUI_DRAW_RECT );
+    }
+
+
+
+static void mx_guiAddFillRect( MaxiginGUI    *inGUI,
+                               char           inAdditiveBlend,
+                               MaxiginColor  *inColor,
+                               int            inStartX,
+                               int            inStartY,
+                               int            inEndX,
+                               int            inEndY ) {
+    
+    mx_guiAddRect( inGUI,
+                   inAdditiveBlend,
+                   inColor,
+                   inStartX,
+                   inStartY,
+                   inEndX,
+                   inEndY,
+                   MX_GUI_FILL_RECT );
+    }
+
+
+static void mx_guiAddSprite( MaxiginGUI    *inGUI,
+                             char           inAdditiveBlend,
+                             unsigned char  inAlpha,
+                             int            inSpriteHandle,
+                             int            inCenterX,
+                             int            inCenterY ) {
+
+    int           i  =  inGUI->numDrawComponents;
+    MaxiginColor  c;
+    
+    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
+        mingin_log( "Error:  trying to add a sprite to a full "
+                    "MaxiginGUI instance.\n" );
+        return;
+        }
+
+    c.val[0] = 255;
+    c.val[1] = 255;
+    c.val[2] = 255;
+    c.val[3] = inAlpha;
+    
+    mx_guiSetColor( inGUI,
+                    i,
+                    inAdditiveBlend,
+                    &c );
+
+    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_SPRITE;
+    
+    inGUI->drawComponents[i].drawParams.sprite.spriteHandle = inSpriteHandle;
+    inGUI->drawComponents[i].drawParams.sprite.centerX      = inCenterX;
+    inGUI->drawComponents[i].drawParams.sprite.centerY      = inCenterY;
+
+    inGUI->numDrawComponents ++;
+    }
+
+
+
+static void mx_guiAddSpriteSequence( MaxiginGUI    *inGUI,
+                                     char           inAdditiveBlend,
+                                     unsigned char  inAlpha,
+                                     int            inSpriteHandle,
+                                     int            inStartCenterX,
+                                     int            inStartCenterY,
+                                     int            inOffsetX,
+                                     int            inOffsetY,
+                                     int            inCount ) {
+
+    int           i  =  inGUI->numDrawComponents;
+    MaxiginColor  c;
+    
+    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
+        mingin_log( "Error:  trying to add a sprite sequence to a full "
+                    "MaxiginGUI instance.\n" );
+        return;
+        }
+
+    c.val[0] = 255;
+    c.val[1] = 255;
+    c.val[2] = 255;
+    c.val[3] = inAlpha;
+    
+    mx_guiSetColor( inGUI,
+                    i,
+                    inAdditiveBlend,
+                    &c );
+
+    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_SPRITE_SEQUENCE;
+    
+    inGUI->drawComponents[i].drawParams.spriteSequence.spriteHandle
+        = inSpriteHandle;
+    
+    inGUI->drawComponents[i].drawParams.spriteSequence.startCenterX
+        = inStartCenterX;
+    
+    inGUI->drawComponents[i].drawParams.spriteSequence.startCenterY
+        = inStartCenterY;
+
+    inGUI->drawComponents[i].drawParams.spriteSequence.offsetX
+        = inOffsetX;
+    
+    inGUI->drawComponents[i].drawParams.spriteSequence.offsetY
+        = inOffsetY;
+
+    inGUI->drawComponents[i].drawParams.spriteSequence.count
+        = inCount;
+
+    inGUI->numDrawComponents ++;
+    }
+
+
+
+static void mx_makeColorGray( MaxiginColor   *inC,
+                              unsigned char   inGrayVal ) {
+
+    inC->val[0] = inGrayVal;
+    inC->val[1] = inGrayVal;
+    inC->val[2] = inGrayVal;
+    }
+
+
+
+static void mx_guiAddText( MaxiginGUI    *inGUI,
+                           MaxiginColor  *inC,
+                           int            inFontHandle,
+                           char          *inString,
+                           int            inAnchorX,
+                           int            inAnchorY,
+                           MaxiginAlign   inAlign ) {
+    
+    int  i  =  inGUI->numDrawComponents;
+
+
+    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
+        mingin_log( "Error:  trying to add text to a full "
+                    "MaxiginGUI instance.\n" );
+        return;
+        }
+    
+    mx_guiSetColor( inGUI,
+                    i,
+                    0,
+                    inC );
+
+    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_TEXT;
+    
+    inGUI->drawComponents[i].drawParams.text.fontHandle = inFontHandle;
+    inGUI->drawComponents[i].drawParams.text.textString = inString;
+    inGUI->drawComponents[i].drawParams.text.anchorX    = inAnchorX;
+    inGUI->drawComponents[i].drawParams.text.anchorY    = inAnchorY;
+    inGUI->drawComponents[i].drawParams.text.align      = inAlign;
+    
+
+    inGUI->numDrawComponents ++;
+    }
+
+
+
+static void mx_guiAddLangText( MaxiginGUI    *inGUI,
+                               MaxiginColor  *inC,
+                               int            inPhraseKey,
+                               int            inAnchorX,
+                               int            inAnchorY,
+                               MaxiginAlign   inAlign ) {
+    
+    int  i  =  inGUI->numDrawComponents;
+
+
+    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
+        mingin_log( "Error:  trying to add language text to a full "
+                    "MaxiginGUI instance.\n" );
+        return;
+        }
+    
+    mx_guiSetColor( inGUI,
+                    i,
+                    0,
+                    inC );
+
+    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_LANG_TEXT;
+    
+    inGUI->drawComponents[i].drawParams.langText.phraseKey  = inPhraseKey;
+    inGUI->drawComponents[i].drawParams.langText.anchorX    = inAnchorX;
+    inGUI->drawComponents[i].drawParams.langText.anchorY    = inAnchorY;
+    inGUI->drawComponents[i].drawParams.langText.align      = inAlign;
+    
+
+    inGUI->numDrawComponents ++;
+    }
+
+
+
+static void mx_getSliderThumbRadius( int   inThumbWidth,
+                                     int  *outLeftRadius,
+                                     int  *outRightRadius ) {
+    if( mx_sliderSpritesSet ) {
+        
+        int  thumbHandle  =  mx_sliderSprites.thumb[1];
+
+        *outLeftRadius  = mx_sprites[ thumbHandle ].leftVisibleRadius;
+        *outRightRadius = mx_sprites[ thumbHandle ].rightVisibleRadius;
+        }
+    else {
+        *outRightRadius = inThumbWidth / 2;
+        *outLeftRadius  = inThumbWidth / 2;
+        }
+    }
+
+
+
+char maxigin_guiSlider( MaxiginGUI  *inGUI,
+                        int         *inCurrentValue,
+                        int          inMinValue,
+                        int          inMaxValue,
+                        int          inStartX,
+                        int          inEndX,
+                        int          inY,
+                        int          inBarHeight,
+                        int          inThumbHeight,
+                        int          inThumbWidth,
+                        int          inLoopStart,
+                        int          inLoopEnd ) {
+
+    MaxiginColor  c;
+    int           thumbPixelCenter;
+    int           v                       =  *inCurrentValue;
+    int           fullRange               =   inMaxValue - inMinValue;
+    int           tenPercent              =   fullRange / 10;
+    int           thumbLeftR;
+    int           thumbRightR;
+    int           centerX;
+    int           staticBarI              =   0;
+    
+    if( tenPercent < 1 ) {
+        tenPercent = 1;
+        }
+
+    centerX = ( inStartX + inEndX ) / 2;
+
+    if( mx_sliderSpritesSet
+        &&
+        mx_sliderSprites.numFullBars > 0 ) {
+
+        /* find smallest available bar that fits requested span
+           and center it on requested span */
+
+        int  i;
+        int  w             =  inEndX - inStartX;
+        int  smallestBarW  =  30000;
+        int  smallestI     =  -1;
+        int  largestBarW   =   0;
+        int  largestBarI   =  -1;
+        
+        for( i = 0;
+             i < mx_sliderSprites.numFullBars;
+             i ++ ) {
+
+            int  barW  =
+                   mx_sprites[ mx_sliderSprites.fullBars[i] ].rightVisibleRadius
+                   +
+                   mx_sprites[ mx_sliderSprites.fullBars[i] ].leftVisibleRadius;
+
+            if( barW >= w
+                &&
+                barW < smallestBarW ) {
+
+                smallestBarW = barW;
+                smallestI    = i;
+                }
+
+            if( barW > largestBarW ) {
+                largestBarW = barW;
+                largestBarI = i;
+                }
+            }
+
+        if( smallestI == -1 ) {
+            /* no bar big enough */
+            
+            /* just pick largest bar in this case */
+            smallestI    = largestBarI;
+            }
+
+        staticBarI = smallestI;
+        i          = smallestI;
+
+        inStartX =
+            centerX -
+            mx_sprites[ mx_sliderSprites.fullBars[i] ].leftVisibleRadius;
+        
+        inEndX =
+            centerX +
+            mx_sprites[ mx_sliderSprites.fullBars[i] ].rightVisibleRadius;
+        }
+    
+    
+    c.comp.red   = 255;
+    c.comp.green = 255;
+    c.comp.blue  = 255;
+    c.comp.alpha = 255;
+    
+    thumbPixelCenter =
+        ( ( v - inMinValue ) *
+          ( inEndX - inStartX ) )
+        / ( inMaxValue - inMinValue )
+        + inStartX;
+    
+    mx_getSliderThumbRadius( inThumbWidth,
+                             &thumbLeftR,
+                             &thumbRightR );
+
+    if( inGUI->active == inCurrentValue ) {
+        /* previously manipulated with mouse */
+
+        if( ! mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON ) ) {
+
+            inGUI->active = 0;
+            }  
+        }
+    
+
+    if( inGUI->active == 0 ) {
+        /* no other component active */
+
+        char avail;
+        int  x       =  0;
+        int  y       =  0;
+            
+        avail = maxigin_getPointerLocation( &x,
+                                            &y );
+
+        x -= inGUI->zeroOffsetX;
+        y -= inGUI->zeroOffsetY;
+
+        if( avail ) {
+            char  over  =  0;
+
+            if( y >= inY - inThumbHeight / 2
+                &&
+                y <= inY + inThumbHeight / 2 ) {
+                
+                if( x >= inStartX
+                    &&
+                    x <= inEndX ) {
+
+                    over = 1;
+                    }
+                else {
+                    /* mouse is not over horizontal extent of bar
+                       check if mouse over thumb, which might stick
+                       off the end of bar */
+                    if( x >= thumbPixelCenter - thumbLeftR
+                        &&
+                        x <= thumbPixelCenter + thumbRightR ) {
+                        
+                        over = 1;
+                        }
+                    }
+                }
+
+            if( over ) {
+                
+                /* mouse over slider */
+
+                if( ! inGUI->mouseDown ) {
+                    /* mouse hovering, unpressed */
+                    
+                    inGUI->hot = inCurrentValue;
+                    }
+                }
+            else if( inGUI->hot == inCurrentValue ) {
+                /* mouse was over slider, but has moved out */
+                inGUI->hot = 0;
+                }
+            }
+
+        if( inGUI->hot == inCurrentValue ) {
+            /* mouse over slider */
+            if( ! inGUI->mouseDown
+                &&
+                mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON ) ) {
+                
+                /* mouse newly pressed on slider */
+                
+                inGUI->active    = inCurrentValue;
+                inGUI->mouseDown = 1;
+
+                /* is mouse over thumb? */
+
+                if( x <= thumbPixelCenter + thumbRightR
+                    &&
+                    /* extra bit seems to help on left side */
+                    x >= thumbPixelCenter - thumbLeftR - 1 ) {
+
+                    inGUI->activeMouseOffsetX = x - thumbPixelCenter;
+                    }
+                else {
+                    /* thumb should jump to click position */
+                    inGUI->activeMouseOffsetX = 0;
+                    }
+
+                inGUI->activeMouseOffsetY = 0;
+                }
+            }
+        }
+    
+
+    if( inGUI->active == inCurrentValue ) {
+        /* mouse controlling slider */
+
+        char avail;
+        int  x       =  0;
+        int  y       =  0;
+            
+        avail = maxigin_getPointerLocation( &x,
+                                            &y );
+
+        x -= inGUI->zeroOffsetX;
+        y -= inGUI->zeroOffsetY;
+
+        if( avail ) {
+
+            x -= inGUI->activeMouseOffsetX;
+            y -= inGUI->activeMouseOffsetY;
+
+            thumbPixelCenter = x;
+            
+            if( x < inStartX ) {
+                v = inMinValue;
+                thumbPixelCenter = inStartX;
+                }
+            else if( x > inEndX ) {
+                v = inMaxValue;
+                thumbPixelCenter = inEndX;
+                }
+            else {
+                /* in between min and max */
+
+                if( ( inEndX - inStartX )
+                    <=
+                    2 * ( inMaxValue - inMinValue ) ) {
+                    
+                    /* lots of values per pixel */
+                    v = ( x - inStartX ) * ( inMaxValue - inMinValue )
+                        /
+                        ( inEndX - inStartX )
+                        + inMinValue;
+
+                    /* tweak v so that when mouse released, slider
+                       doesn't jump weirdly */
+                    v += 1;
+                    }
+                else {
+                    /* not very many values per pixel of slider */
+
+                    /* snap to closest value */
+
+                    int  numBins       =  inMaxValue - inMinValue;
+                    int  binSize       =  ( inEndX - inStartX ) / numBins;
+                    int  startBinSize  =  binSize /  2;
+                    int  xOffset       =  x - inStartX;
+
+                    v = ( xOffset + startBinSize ) / binSize;
+                    }
+                
+
+                if( v > inMaxValue ) {
+                    v = inMaxValue;
+                    }
+                else if( v < inMinValue ) {
+                    v = inMinValue;
+                    }
+                }
+            } 
+        }
+    
+    
+
+    if( inGUI->forceHot == inCurrentValue ) {
+
+        /* we're in force moving mode, which means the game has this slider
+           active or selected, currently */
+        
+        /* listen to controller sticks, arrow keys, etc */
+
+        if( mx_isActionFreshPressed( MAXIGIN_SLIDER_DECREASE ) ) {
+
+            v -= tenPercent;
+            }
+        else if( mx_isActionFreshPressed( MAXIGIN_SLIDER_INCREASE ) ) {
+
+            v += tenPercent;
+            }
+        else {
+
+            /* move slider with sticks, potentially  */
+
+            /* leaving these uninitialized generates
+               a warning in some compilers */
+            int  pos    =  0;
+            int  lower  =  0;
+            int  upper  =  0;
+            
+            if( mingin_getStickPosition( MAXIGIN_STICK_SLIDER,
+                                         &pos,
+                                         &lower,
+                                         &upper ) ) {
+                /* stick available */
+
+                int  range           =  ( upper - lower );
+                int  half            =  range / 2;
+                int  mid             =  half + lower;
+                int  dead            =  range / 10;
+                int  stepsPerSecond  =  mingin_getStepsPerSecond();
+                int  jump            =  0;
+
+
+                if( dead == 0 ) {
+                    dead = 1;
+                    }
+                
+                /* baseline:
+                   on a 0-100 slider at 60 fps, we should
+                   move 1 step per frame if stick partway pressed
+                   and 2 steps per frame if stick all the way pressed.
+
+                   For longer sliders, we should move faster.
+
+                   On platforms with slower frame rates, we should move
+                   faster.
+                */
+                
+                if( pos > mid + dead ) {
+
+                    jump = 1;
+
+                    if( pos > upper - dead ) {
+                        jump = 2;
+                        }
+                    }
+                else if( pos < mid - dead ) {
+
+                    jump = -1;
+
+                    if( pos < lower + dead ) {
+                        jump = -2;
+                        }
+                    }
+
+                if( stepsPerSecond < 60 ) {
+                    /* bigger jumps if fps lower */
+                    jump = ( jump * 60 ) / stepsPerSecond;
+                    }
+                if( fullRange > 100 ) {
+                    jump = ( jump * fullRange ) / 100;
+                    }
+                
+                v += jump;
+                }
+            }
+        if( v < inMinValue ) {
+            v = inMinValue;
+            }
+        if( v > inMaxValue ) {
+            v = inMaxValue;
+            }
+        }
+
+    
+    *inCurrentValue = v;
+
+    if( ( inEndX - inStartX )
+        >
+        2 * ( inMaxValue - inMinValue ) ) {
+
+        /* bar has way more pixels than legal values
+           thumb should snap to legal values */
+        
+        thumbPixelCenter =
+            ( ( v - inMinValue ) *
+              ( inEndX - inStartX ) )
+            / ( inMaxValue - inMinValue )
+            + inStartX;
+        }
+    /* else bar has enough resolution, thumb should move
+       smoothly with mouse and then snap to actual value when dropped */
+    
+
+
+    /* now draw slider */
+
+    
+    if( mx_sliderSpritesSet ) {
+        /* use sprites  */
+
+        int  thumbHandle;
+
+
+        if( mx_sliderSprites.numFullBars == 0 ) {
+            /* dynamically-sized bar */
+
+                    
+            int  leftEndHandle;
+            int  rightEndHandle;
+        
+            if( v > inMinValue ) {
+                leftEndHandle = mx_sliderSprites.left[1];
+                }
+            else {
+                /* completely empty, show empty left end */
+                leftEndHandle = mx_sliderSprites.left[0];
+                }
+
+        
+            mx_guiAddSprite( inGUI,
+                             0,
+                             255,
+                             leftEndHandle,
+                             inStartX,
+                             inY );
+
+            if( thumbPixelCenter > inStartX ) {
+                /* full bar to left of thumb */
+
+                int  consumedWidth   =  0;
+                int  barSprite       =  mx_sliderSprites.bar[1];
+                int  barSpriteLeftR  =
+                         mx_sprites[ barSprite ].leftVisibleRadius;
+            
+                int  barSpriteW      =  barSpriteLeftR +
+                         mx_sprites[ barSprite ].rightVisibleRadius;
+            
+                int  numBars         =
+                         ( thumbPixelCenter - inStartX ) / barSpriteW;
+
+            
+                if( numBars > 0 ) {
+                    consumedWidth = numBars * barSpriteW;
+                
+                    mx_guiAddSpriteSequence( inGUI,
+                                             0,
+                                             255,
+                                             mx_sliderSprites.bar[1],
+                                             inStartX + barSpriteLeftR,
+                                             inY,
+                                             barSpriteW,
+                                             0,
+                                             numBars );
+                    }
+
+                if( consumedWidth < ( thumbPixelCenter - inStartX ) ) {
+
+                    /* fill rest with slivers */
+                    mx_guiAddSpriteSequence( inGUI,
+                                             0,
+                                             255,
+                                             mx_sliderSprites.sliver[1],
+                                             inStartX + consumedWidth,
+                                             inY,
+                                             1,
+                                             0,
+                                             thumbPixelCenter - inStartX
+                                             - consumedWidth );
+                    }
+                }
+
+            if( thumbPixelCenter < inEndX ) {
+                /* empty bar to right of thumb */
+            
+                int  consumedWidth   =  0;
+                int  barSprite       =  mx_sliderSprites.bar[0];
+                int  barSpriteLeftR  =
+                         mx_sprites[ barSprite ].leftVisibleRadius;
+            
+                int  barSpriteW      =  barSpriteLeftR +
+                    mx_sprites[ barSprite ].rightVisibleRadius;
+            
+                int  numBars         =
+                        ( inEndX - thumbPixelCenter ) / barSpriteW;
+
+            
+                if( numBars > 0 ) {
+                    consumedWidth = numBars * barSpriteW;
+                
+                    mx_guiAddSpriteSequence( inGUI,
+                                             0,
+                                             255,
+                                             mx_sliderSprites.bar[0],
+                                             thumbPixelCenter + barSpriteLeftR,
+                                             inY,
+                                             barSpriteW,
+                                             0,
+                                             numBars );
+                    }
+            
+                if( consumedWidth < ( inEndX - thumbPixelCenter ) ) {
+
+                    /* fill rest with slivers */
+                    mx_guiAddSpriteSequence( inGUI,
+                                             0,
+                                             255,
+                                             mx_sliderSprites.sliver[0],
+                                             thumbPixelCenter + consumedWidth,
+                                             inY,
+                                             1,
+                                             0,
+                                             inEndX - thumbPixelCenter
+                                             - consumedWidth );
+                    }
+                }
+        
+
+            if( v < inMaxValue ) {
+                rightEndHandle = mx_sliderSprites.right[0];
+                }
+            else {
+                /* completely fully, show full right end */
+                rightEndHandle = mx_sliderSprites.right[1];
+                }
+
+        
+            mx_guiAddSprite( inGUI,
+                             0,
+                             255,
+                             rightEndHandle,
+                             inEndX,
+                             inY );
+            }
+        else {
+            /* statically sized bar */
+
+            int  barHandle  =
+                mx_sliderSprites.fullBars[ staticBarI ];
+
+            mx_guiAddSprite( inGUI,
+                             0,
+                             255,
+                             barHandle,
+                             centerX,
+                             inY );
+            }
+
+        
+
+        if( inLoopStart >= inMinValue ) {
+
+            int loopPixCenter =
+                ( ( inLoopStart - inMinValue ) *
+                  ( inEndX - inStartX ) )
+                / ( inMaxValue - inMinValue )
+                + inStartX;
+
+            mx_guiAddSprite( inGUI,
+                             0,
+                             255,
+                             mx_sliderSprites.loop[0],
+                             loopPixCenter,
+                             inY );
+            }
+
+        if( inLoopEnd >= inMinValue ) {
+
+            int loopPixCenter =
+                ( ( inLoopEnd - inMinValue ) *
+                  ( inEndX - inStartX ) )
+                / ( inMaxValue - inMinValue )
+                + inStartX;
+
+            mx_guiAddSprite( inGUI,
+                             0,
+                             255,
+                             mx_sliderSprites.loop[1],
+                             loopPixCenter,
+                             inY );
+            }
+        
+
+        /* thumb drawn the same for both static and dynamic bars */
+
+        if( inGUI->active   == inCurrentValue
+            ||
+            inGUI->forceHot == inCurrentValue ) {
+            
+            thumbHandle = mx_sliderSprites.thumb[2];
+            }
+        else if( inGUI->hot == inCurrentValue ) {
+            thumbHandle = mx_sliderSprites.thumb[1];
+            }
+        else {
+            thumbHandle = mx_sliderSprites.thumb[0];
+            }
+
+        mx_guiAddSprite( inGUI,
+                         0,
+                         255,
+                         thumbHandle,
+                         thumbPixelCenter,
+                         inY );
+        }
+    else {
+        /* no sprites set, draw directly with geometry  */
+
+
+        /* bar */
+        mx_makeColorGray( &c,
+                          128 );
+    
+        mx_guiAddFillRect( inGUI,
+                           0,
+                           &c,
+                           inStartX,
+                           inY - inBarHeight / 2,
+                           inEndX,
+                           inY + inBarHeight / 2 );
+
+        mx_makeColorGray( &c,
+                          255 );
+    
+        mx_guiAddDrawRect( inGUI,
+                           0,
+                           &c,
+                           inStartX,
+                           inY - inBarHeight / 2,
+                           inEndX,
+                           inY + inBarHeight / 2 );
+
+        
+        if( inLoopStart >= inMinValue ) {
+
+            int loopPixCenter =
+                ( ( inLoopStart - inMinValue ) *
+                  ( inEndX - inStartX ) )
+                / ( inMaxValue - inMinValue )
+                + inStartX;
+
+            c.comp.red = 0;
+            c.comp.green = 255;
+            c.comp.blue = 0;
+            c.comp.alpha = 255;
+
+            mx_guiAddLine( inGUI,
+                           0,
+                           &c,
+                           loopPixCenter,
+                           inY - inThumbHeight,
+                           loopPixCenter,
+                           inY + inThumbHeight );
+            }
+
+        if( inLoopEnd >= inMinValue ) {
+
+            int loopPixCenter =
+                ( ( inLoopEnd - inMinValue ) *
+                  ( inEndX - inStartX ) )
+                / ( inMaxValue - inMinValue )
+                + inStartX;
+
+            c.comp.red = 255;
+            c.comp.green = 0;
+            c.comp.blue = 0;
+            c.comp.alpha = 255;
+
+            mx_guiAddLine( inGUI,
+                           0,
+                           &c,
+                           loopPixCenter,
+                           inY - inThumbHeight,
+                           loopPixCenter,
+                           inY + inThumbHeight );
+            }
+
+        /* thumb */
+
+
+        /* shadow */
+        mx_makeColorGray( &c,
+                          64 );
+
+        c.comp.alpha = 128;
+    
+        mx_guiAddFillRect( inGUI,
+                           0,
+                           &c,
+                           thumbPixelCenter - inThumbWidth / 2 - 2,
+                           inY - inBarHeight / 2,
+                           thumbPixelCenter + inThumbWidth / 2 + 2,
+                           inY + inBarHeight / 2 );
+
+        c.comp.alpha = 255;
+    
+        if( inGUI->active   == inCurrentValue
+            ||
+            inGUI->forceHot == inCurrentValue ) {
+            
+            /* darker when moving */
+            mx_makeColorGray( &c,
+                              64 );
+            }
+        else if( inGUI->hot == inCurrentValue ) {
+            /* brighter when hot */
+            mx_makeColorGray( &c,
+                              192 );
+            }
+        else {        
+            mx_makeColorGray( &c,
+                              128 );
+            }
+    
+        mx_guiAddFillRect( inGUI,
+                           0,
+                           &c,
+                           thumbPixelCenter - inThumbWidth / 2,
+                           inY - inThumbHeight / 2,
+                           thumbPixelCenter + inThumbWidth / 2,
+                           inY + inThumbHeight / 2 );
+
+        mx_makeColorGray( &c,
+                          255 );
+    
+        mx_guiAddDrawRect( inGUI,
+                           0,
+                           &c,
+                           thumbPixelCenter - inThumbWidth / 2,
+                           inY - inThumbHeight / 2,
+                           thumbPixelCenter + inThumbWidth / 2,
+                           inY + inThumbHeight / 2 );
+
+
+
+        }
+    
+
+    /* return 1 if slider is active */
+    return ( inGUI->active == inCurrentValue );
+    }
+
+
+
+int maxigin_guiStartPanel( MaxiginGUI    *inGUI,
+                           int            inCenterX,
+                           int            inCenterY,
+                           int            inWidth,
+                           int            inHeight,
+                           unsigned char  inFade ) {
+
+    int           i  =  inGUI->numDrawComponents;
+
+    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
+        mingin_log( "Error:  trying to add a panel to a full "
+                    "MaxiginGUI instance.\n" );
+        return -1;
+        }
+    
+    inGUI->zeroOffsetX += inCenterX;
+    inGUI->zeroOffsetY += inCenterY;
+
+    inGUI->drawComponents[i].drawType = MX_GUI_SUB_PANEL_START;
+    
+    inGUI->drawComponents[i].drawParams.panelStart.plusX = inCenterX;
+    inGUI->drawComponents[i].drawParams.panelStart.plusY = inCenterY;
+
+    inGUI->drawComponents[i].drawParams.panelStart.oldFade = inGUI->fade;
+        
+    /* compound the fades,
+       so fading subpanels in fading panels get doubly faded */
+    inGUI->fade = (unsigned char)( ( inGUI->fade * inFade ) / 255 );
+
+    inGUI->drawComponents[i].drawParams.panelStart.newFade = inGUI->fade;
+    
+    
+    inGUI->numDrawComponents ++;
+
+
+    if( mx_panelSpritesSet ) {
+
+        if( mx_panelSprites.numFullPanels > 0 ) {
+            /* statically-sized panels */
+
+            int  smallestP  =  -1;
+            int  smallestW  =  30000;
+            
+            int  largestP   =  -1;
+            int  largestW   =   0;
+            int  p;
+            
+            for( p = 0;
+                 p < mx_panelSprites.numFullPanels;
+                 p ++ ) {
+
+                MaxiginSprite  *s  =
+                    &( mx_sprites[ mx_panelSprites.fullPanels[p] ] );
+                int             w  =  s->leftVisibleRadius +
+                                      s->rightVisibleRadius;
+                int             h  =  s->upperVisibleRadius +
+                                      s->lowerVisibleRadius;
+
+                if( w >= inWidth
+                    &&
+                    w < smallestW
+                    &&
+                    h >= inHeight ) {
+                    smallestP = p;
+                    smallestW = w;
+                    }
                 
+                if( w > largestW ) {
+                    largestP = p;
+                    largestW = w;
+                    }
                 }
-            else {
-                
-                /* alpha weighted blend, most expensive case */
-                
-                mx_gameImageBuffer[ pixelStartByte ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte ]
-                          * ( 255 - lineA )
-                          +
-                          linePreR )
-                        /
-                        255 );
 
-                mx_gameImageBuffer[ pixelStartByte + 1 ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte + 1 ]
-                          * ( 255 - lineA )
-                          +
-                          linePreG )
-                        /
-                        255 );
+            if( smallestP == -1 ) {
+                /* found no panel that was big enough
+                   use largest one instead */
+                smallestP = largestP;
+                }
 
+            if( smallestP != -1 ) {
                 
-                mx_gameImageBuffer[ pixelStartByte + 2 ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte + 2 ]
-                          * ( 255 - lineA )
-                          +
-                          linePreB )
-                        /
-                        255 );
+                mx_guiAddSprite( inGUI,
+                                 0,
+                                 255,
+                                 mx_panelSprites.fullPanels[ smallestP ],
+                                 0,
+                                 0 );
                 }
             }
-                
+        else {
+            /* dynamically-sized panels */
+
+            int             fill          =  mx_panelSprites.fill;
+            MaxiginSprite  *fillS         =  &( mx_sprites[ fill ] );
+            int             fillW         =  fillS->w;
+            int             fillH         =  fillS->h;
+            int             numFillRows;
+            int             numFillCols;
+            int             totalFillW;
+            int             totalFillH;
+            int             fillStartX;
+            int             fillStartY;
+            int             r;
         
-        if( d > 0 ) {
+            numFillCols = inWidth / fillW;
+
+            if( numFillCols * fillW < inWidth ) {
+                /* round up */
+                numFillCols ++;
+                }
         
-            x += xDir;
+            numFillRows = inHeight / fillH;
 
-            /* bail out if x ever steps out of bounds */
-            if( x < 0
-                ||
-                x >= MAXIGIN_GAME_NATIVE_W ) {
-                break;
+            if( numFillRows * fillH < inHeight ) {
+                /* round up */
+                numFillRows ++;
                 }
-            
-            pixelStartByte += xDir * 3;
-            
-            d += 2 * ( dX - dY );
-            }
-        else {
-            d += 2 * dX;
-            }
 
-        /* next row */
-        pixelStartByte += MAXIGIN_GAME_NATIVE_W * 3;
-        }
-    }
+            /* add extra rows/columns for edges, which might have transparent
+               pixels and not "fill" in the desired area completely
+               We want to guarantee that opaque fill of panel is at least as
+               big as the requested size */
+            numFillCols += 2;
+            numFillRows += 2;
 
+            totalFillW = numFillCols * fillW;
+            totalFillH = numFillRows * fillH;
 
+            fillStartX = ( - totalFillW / 2 ) + fillW / 2;
+            fillStartY = ( - totalFillH / 2 ) + fillH / 2;
 
-/* Draws a horizontal line with no bounds or direction checking.
+            for( r = 0;
+                 r < numFillRows;
+                 r ++ ) {
 
-   Parameters:
+                int  rowStartY  =  fillStartY + r * fillH;
+            
+                if( r == 0 ) {
+                    /* tl corner */
+                    mx_guiAddSprite( inGUI,
+                                     0,
+                                     255,
+                                     mx_panelSprites.corners[0],
+                                     fillStartX,
+                                     rowStartY );
+                    }
+                else if( r == numFillRows - 1 ) {
+                    /* bl corner */
+                    mx_guiAddSprite( inGUI,
+                                     0,
+                                     255,
+                                     mx_panelSprites.corners[2],
+                                     fillStartX,
+                                     rowStartY );
+                    }
+                else {
+                    /* left edge */
+                    mx_guiAddSprite( inGUI,
+                                     0,
+                                     255,
+                                     mx_panelSprites.sides[0],
+                                     fillStartX,
+                                     rowStartY );
+                    }
+            
+                if( r == 0 ) {
+                    /* fill with top edge */
 
-       inStartX   the start x location of the line
-                  >= 0
-                  <  MAXIGIN_GAME_NATIVE_W
-                  
-       inEndX     the end x location of the line
-                  >= 0
-                  <  MAXIGIN_GAME_NATIVE_W
-                  >= inStartX
+                    mx_guiAddSpriteSequence( inGUI,
+                                             0,
+                                             255,
+                                             mx_panelSprites.sides[2],
+                                             fillStartX + fillW,
+                                             fillStartY + r * fillH,
+                                             fillW,
+                                             0,
+                                             numFillCols - 2 );
+                    }
+                else if( r == numFillRows - 1 ) {
+                    /* fill with bottom edge */
 
-       inY        the y location of the line
-                  >= 0
-                  <  MAXIGIN_GAME_NATIVE_H
-*/
-static void mx_drawFastHorizontalLine( int  inStartX,
-                                       int  inEndX,
-                                       int  inY ) {
+                    mx_guiAddSpriteSequence( inGUI,
+                                             0,
+                                             255,
+                                             mx_panelSprites.sides[3],
+                                             fillStartX + fillW,
+                                             fillStartY + r * fillH,
+                                             fillW,
+                                             0,
+                                             numFillCols - 2 );
+                    }
+                else {
+                    /* fill with fill */
             
-    int  x;
-    int  pixelStartByte;
-    int  lineA            =  mx_drawColor.comp.alpha;
-        
-    /* color components with alpha pre-multiplied */
-    int  linePreR         =  mx_drawColor.comp.red   * lineA;
-    int  linePreG         =  mx_drawColor.comp.green * lineA;
-    int  linePreB         =  mx_drawColor.comp.blue  * lineA;
-    int  lineScaledR      =  linePreR / 255;
-    int  lineScaledG      =  linePreG / 255;
-    int  lineScaledB      =  linePreB / 255;
+                    mx_guiAddSpriteSequence( inGUI,
+                                             0,
+                                             255,
+                                             fill,
+                                             fillStartX + fillW,
+                                             fillStartY + r * fillH,
+                                             fillW,
+                                             0,
+                                             numFillCols - 2 );
+                    }
+
+
+                if( r == 0 ) {
+                    /* tr corner */
+                    mx_guiAddSprite( inGUI,
+                                     0,
+                                     255,
+                                     mx_panelSprites.corners[1],
+                                     fillStartX + fillW * ( numFillCols - 1 ),
+                                     rowStartY );
+                    }
+                else if( r == numFillRows - 1 ) {
+                    /* bl corner */
+                    mx_guiAddSprite( inGUI,
+                                     0,
+                                     255,
+                                     mx_panelSprites.corners[3],
+                                     fillStartX + fillW * ( numFillCols - 1 ),
+                                     rowStartY );
+                    }
+                else {
+                    /* left edge */
+                    mx_guiAddSprite( inGUI,
+                                     0,
+                                     255,
+                                     mx_panelSprites.sides[1],
+                                     fillStartX + fillW * ( numFillCols - 1 ),
+                                     rowStartY );
+                    }
+                }
+            }
+        }
+    else {
         
-    pixelStartByte  =  inY * MAXIGIN_GAME_NATIVE_W * 3 + inStartX * 3;
+        MaxiginColor  c;
         
-    if( mx_additiveBlend ) {
-        /* additive blend */
-            
-        for( x  = inStartX;
-             x <= inEndX;
-             x ++ ) {
-                
-            int  v;
-
-            v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
+        /* no sprites, draw with rectangles */
 
-            v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+        /* shadow */
+        mx_makeColorGray( &c,
+                          0 );
 
-            v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
-            if( v > 255 ) {
-                v = 255;
-                }
-            mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v; 
+        c.comp.alpha = 64;
+    
+        mx_guiAddFillRect( inGUI,
+                           0,
+                           &c,
+                           -inWidth  / 2 - 2,
+                           -inHeight / 2 + 2,
+                           inWidth   / 2 - 2 - 1,
+                           inHeight  / 2 + 2 - 1 );
 
-            /* next col */
-            pixelStartByte += 3;
-            }
-        }
-    else {
-        if( lineA == 255 ) {
-            /* no blend, pure replace */
-                
-            for( x  = inStartX;
-                 x <= inEndX;
-                 x ++ ) {
-                    
-                mx_gameImageBuffer[ pixelStartByte ++ ] =
-                    mx_drawColor.comp.red;
-                
-                mx_gameImageBuffer[ pixelStartByte ++ ] =
-                    mx_drawColor.comp.green;
-                
-                mx_gameImageBuffer[ pixelStartByte ++ ] =
-                    mx_drawColor.comp.blue;
-                }
-            }
-        else {
-            /* weighted alpha blend */
-                
-            for( x  = inStartX;
-                 x <= inEndX;
-                 x ++ ) {
-                    
-                mx_gameImageBuffer[ pixelStartByte ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte ]
-                          * ( 255 - lineA )
-                          +
-                          linePreR )
-                        /
-                        255 );
+    
+        mx_makeColorGray( &c,
+                          64 );
 
-                mx_gameImageBuffer[ pixelStartByte + 1 ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte + 1 ]
-                          * ( 255 - lineA )
-                          +
-                          linePreG )
-                        /
-                        255 );
+        c.comp.alpha = 255;
+    
+        mx_guiAddFillRect( inGUI,
+                           0,
+                           &c,
+                           -inWidth  / 2,
+                           -inHeight / 2,
+                           inWidth   / 2 - 1,
+                           inHeight  / 2 - 1 );
 
-                
-                mx_gameImageBuffer[ pixelStartByte + 2 ] =
-                    (unsigned char)( 
-                        ( mx_gameImageBuffer[ pixelStartByte + 2 ]
-                          * ( 255 - lineA )
-                          +
-                          linePreB )
-                        /
-                        255 );
+        mx_makeColorGray( &c,
+                          128 );
 
-                /* next col */
-                pixelStartByte += 3;
-                } 
-            }
+        c.comp.alpha = 255;
+    
+        mx_guiAddDrawRect( inGUI,
+                           0,
+                           &c,
+                           -inWidth  / 2,
+                           -inHeight / 2,
+                           inWidth   / 2 - 1,
+                           inHeight  / 2 - 1 );
         }
+    
+
+    return i;
     }
 
 
 
-void maxigin_drawLine( int  inStartX,
-                       int  inStartY,
-                       int  inEndX,
-                       int  inEndY ) {
+void maxigin_guiEndPanel( MaxiginGUI  *inGUI,
+                          int          inPanelHandle ) {
 
+    int            i    =  inPanelHandle;
+    int            cX;
+    int            cY;
+    unsigned char  oldFade;
     
-    if( mx_drawColor.comp.alpha == 0 ) {
+    if( i < 0 ) {
         return;
         }
-    
 
-    /* special case: vert line */
-    if( inStartX == inEndX ) {
+    if( inGUI->drawComponents[i].drawType != MX_GUI_SUB_PANEL_START ) {
+        mingin_log( "Error:  panel handle mismatch in "
+                    "MaxiginGUI instance.\n" );
+        return;
+        }
 
-        int  y;
-        int  temp;
-        int  pixelStartByte;
-        int  lineA            =  mx_drawColor.comp.alpha;
-        int  rowHop;
-        
-        /* color components with alpha pre-multiplied */
-        int  linePreR         =  mx_drawColor.comp.red   * lineA;
-        int  linePreG         =  mx_drawColor.comp.green * lineA;
-        int  linePreB         =  mx_drawColor.comp.blue  * lineA;
-        int  lineScaledR      =  linePreR / 255;
-        int  lineScaledG      =  linePreG / 255;
-        int  lineScaledB      =  linePreB / 255;
+    /* undo the offset setup when our panel was created */
+    cX      = inGUI->drawComponents[i].drawParams.panelStart.plusX;
+    cY      = inGUI->drawComponents[i].drawParams.panelStart.plusY;
+    oldFade = inGUI->drawComponents[i].drawParams.panelStart.oldFade;
         
-        if( inStartX < 0
-            ||
-            inStartX >= MAXIGIN_GAME_NATIVE_W ) {
-            
-            /* vertical line outside left or right side of image */
-            return;
-            }
+    inGUI->zeroOffsetX -= cX;
+    inGUI->zeroOffsetY -= cY;
+    inGUI->fade = oldFade;
+    
+    /* add a draw component that undoes the offset in our draw sequence */
+    i  =  inGUI->numDrawComponents;
 
-        if( inStartY < 0
-            &&
-            inEndY < 0 ) {
-            /* completely outside top side of image */
-            return;
-            }
-        if( inStartY >= MAXIGIN_GAME_NATIVE_H
-            &&
-            inEndY   >= MAXIGIN_GAME_NATIVE_H ) {
-            /* completely outside bottom side of image */
-            return;
-            }
+    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
+        mingin_log( "Error:  trying to end a panel in a full "
+                    "MaxiginGUI instance.\n" );
+        return;
+        }
 
-        /* truncate vertical line inside image */
-        if( inStartY < 0 ) {
-            inStartY = 0;
-            }
-        else if( inStartY >= MAXIGIN_GAME_NATIVE_H ) {
-            inStartY = MAXIGIN_GAME_NATIVE_H - 1;
-            }
-        if( inEndY < 0 ) {
-            inEndY = 0;
-            }
-        else if( inEndY >= MAXIGIN_GAME_NATIVE_H ) {
-            inEndY = MAXIGIN_GAME_NATIVE_H - 1;
-            }
-        
+    inGUI->drawComponents[i].drawType = MX_GUI_SUB_PANEL_END;
+    
+    inGUI->drawComponents[i].drawParams.panelEnd.plusX   = -cX;
+    inGUI->drawComponents[i].drawParams.panelEnd.plusY   = -cY;
+    inGUI->drawComponents[i].drawParams.panelEnd.oldFade = oldFade;
 
-        /* fix direction */
-        if( inStartY > inEndY ) {
-            temp     = inEndY;
-            inEndY   = inStartY;
-            inStartY = temp;
-            }
-        
+    inGUI->numDrawComponents ++;
+    }
 
-        rowHop          =  MAXIGIN_GAME_NATIVE_W * 3;
-        pixelStartByte  =  inStartY * rowHop + inStartX * 3;
-        
-        
-        if( mx_additiveBlend ) {
-            /* additive blend */
-            
-            for( y  = inStartY;
-                 y <= inEndY;
-                 y ++ ) {
-                
-                int  v;
 
-                v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
-                if( v > 255 ) {
-                    v = 255;
-                    }
-                mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
 
-                v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
-                if( v > 255 ) {
-                    v = 255;
-                    }
-                mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+void maxigin_guiLabel( MaxiginGUI  *inGUI,
+                       int           inPhraseKey,
+                       int           inLocationX,
+                       int           inLocationY,
+                       MaxiginAlign  inAlign ) {
+    
+    MaxiginColor  c;
+
+    mx_makeColorGray( &c,
+                      255 );
+    c.comp.alpha = 255;
+    
+    mx_guiAddLangText( inGUI,
+                       &c,
+                       inPhraseKey,
+                       inLocationX,
+                       inLocationY,
+                       inAlign );
+    }
+
 
-                v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
-                if( v > 255 ) {
-                    v = 255;
-                    }
-                mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v; 
 
-                /* next row */
-                pixelStartByte += rowHop;
-                }
-            }
-        else {
-            if( lineA == 255 ) {
-                /* no blend, pure replace */
-                
-                for( y  = inStartY;
-                     y <= inEndY;
-                     y ++ ) {
-                    
-                    mx_gameImageBuffer[ pixelStartByte     ] =
-                        mx_drawColor.comp.red;
-                
-                    mx_gameImageBuffer[ pixelStartByte + 1 ] =
-                        mx_drawColor.comp.green;
-                
-                    mx_gameImageBuffer[ pixelStartByte + 2 ] =
-                        mx_drawColor.comp.blue;
+void maxigin_guiCheckbox( MaxiginGUI  *inGUI,
+                          char        *inChecked,
+                          int          inLocationX,
+                          int          inLocationY,
+                          int          inRadius ) {
 
-                    /* next row */
-                    pixelStartByte += rowHop;
-                    }
-                }
-            else {
-                /* weighted alpha blend */
-                
-                for( y  = inStartY;
-                     y <= inEndY;
-                     y ++ ) {
-                    
-                    mx_gameImageBuffer[ pixelStartByte ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ pixelStartByte ]
-                              * ( 255 - lineA )
-                              +
-                              linePreR )
-                            /
-                            255 );
+    MaxiginColor   c;
+    int            r          =   inRadius;
+    int            rLeft      =  -inRadius;
+    int            rRight     =   inRadius;
+    int            rTop       =  -inRadius;
+    int            rBot       =   inRadius;
+    char           mouseDown  =   mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON );
+    int            x          =   0;
+    int            y          =   0;
+    char           avail      =   maxigin_getPointerLocation( &x,
+                                                              &y );
+    unsigned char  frameV;
 
-                    mx_gameImageBuffer[ pixelStartByte + 1 ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ pixelStartByte + 1 ]
-                              * ( 255 - lineA )
-                              +
-                              linePreG )
-                            /
-                            255 );
+    if( mx_checkboxSpritesSet ) {
+        MaxiginSprite  *s  = &( mx_sprites[ mx_checkboxSprites.cool[0] ] );
 
-                
-                    mx_gameImageBuffer[ pixelStartByte + 2 ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ pixelStartByte + 2 ]
-                              * ( 255 - lineA )
-                              +
-                              linePreB )
-                            /
-                            255 );
-                    
-                    /* next row */
-                    pixelStartByte += rowHop;
-                    }
-                }
-            }
-        return;
+        rLeft  =  - s->leftVisibleRadius;
+        rRight =    s->rightVisibleRadius;
+        rTop   =  - s->upperVisibleRadius;
+        rBot   =    s->lowerVisibleRadius;
         }
 
-    
-    /* special case: horizontal line */
-    if( inStartY == inEndY ) {
-        
-        int  temp;
+    x -= inGUI->zeroOffsetX;
+    y -= inGUI->zeroOffsetY;
 
-        if( inStartY < 0
+    x -= inLocationX;
+    y -= inLocationY;
+
+    /* if mouse is over us, check for new press */
+    if( avail
+        &&
+        x >= rLeft
+        &&
+        x <= rRight
+        &&
+        y >= rTop
+        &&
+        y <= rBot ) {
+
+        if( inGUI->active == 0
             ||
-            inStartY >= MAXIGIN_GAME_NATIVE_H ) {
+            inGUI->active == inChecked ) {
+            /* don't become hot if mouse pressed on other component */
+            inGUI->hot = inChecked;
+            }
+        
+        if( ! inGUI->mouseDown
+            &&
+            mouseDown ) {
             
-            /* horizontal line above or below image */
-            return;
+            inGUI->mouseDown = 1;
+            inGUI->active = inChecked;
             }
+        else if( inGUI->mouseDown
+                 &&
+                 inGUI->active == inChecked
+                 &&
+                 ! mouseDown ) {
 
-        if( inStartX < 0
-            &&
-            inEndX < 0 ) {
-            /* completely outside left side of image */
-            return;
+            /* mouse released on us when it was pressed on us before,
+               toggle checked */
+
+            *inChecked = ! ( *inChecked );
+
+            inGUI->mouseDown = 0;
+
+            inGUI->active = 0;
             }
-        if( inStartX >= MAXIGIN_GAME_NATIVE_W
-            &&
-            inEndX   >= MAXIGIN_GAME_NATIVE_W ) {
-            /* completely outside right side of image */
-            return;
+        }
+    else {
+        /* mouse not over us
+           watch for release far away due to a press that started on us */
+
+        if( inGUI->hot == inChecked ) {
+            inGUI->hot = 0;
             }
         
-        /* truncate horizontal line inside image */
-        if( inStartX < 0 ) {
-            inStartX = 0;
-            }
-        else if( inStartX >= MAXIGIN_GAME_NATIVE_W ) {
-            inStartX = MAXIGIN_GAME_NATIVE_W - 1;
-            }
-        if( inEndX < 0 ) {
-            inEndX = 0;
-            }
-        else if( inEndX >= MAXIGIN_GAME_NATIVE_W ) {
-            inEndX = MAXIGIN_GAME_NATIVE_W - 1;
-            }
+        if( inGUI->mouseDown
+            &&
+            inGUI->active == inChecked
+            &&
+            ! mouseDown ) {
 
-        /* fix direction */
-        if( inStartX > inEndX ) {
-            temp     = inEndX;
-            inEndX   = inStartX;
-            inStartX = temp;
-            }
+            /* don't toggle checked if it was released away from us */
+            inGUI->mouseDown = 0;
 
-        mx_drawFastHorizontalLine( inStartX,
-                                   inEndX,
-                                   inStartY );
-        return;
+            inGUI->active = 0;
+            }
         }
     
-    
-    /* General-case Bresenham's line algorithm */
 
-    if( mx_abs( inEndY - inStartY )
-        <
-        mx_abs( inEndX - inStartX ) ) {
+    if( mx_checkboxSpritesSet ) {
+
+        int  s;
+        int  i   =  0;
+
+        if( *inChecked ) {
+            i = 1;
+            }
         
-        if( inStartX > inEndX ) {
-            mx_drawLineLow( inEndX, inEndY, inStartX, inStartY );
+        if( inGUI->hot      == inChecked
+            ||
+            inGUI->forceHot == inChecked ) {
+            
+            s = mx_checkboxSprites.hot[i];
             }
         else {
-            mx_drawLineLow( inStartX, inStartY, inEndX, inEndY );
+            s = mx_checkboxSprites.cool[i];
             }
+
+        mx_guiAddSprite( inGUI,
+                         0,
+                         255,
+                         s,
+                         inLocationX,
+                         inLocationY);
         }
     else {
-        if( inStartY > inEndY ) {
-            mx_drawLineHigh( inEndX, inEndY, inStartX, inStartY );
+        /* no sprites, draw with shapes */
+
+        frameV = 128;
+
+        if( inGUI->hot      == inChecked
+            ||
+            inGUI->forceHot == inChecked ) {
+            
+            frameV = 255;
             }
-        else {
-            mx_drawLineHigh( inStartX, inStartY, inEndX, inEndY );
+
+        mx_makeColorGray( &c,
+                          frameV );
+
+        c.comp.alpha = 255;
+    
+        mx_guiAddDrawRect( inGUI,
+                           0,
+                           &c,
+                           inLocationX - r,
+                           inLocationY - r,
+                           inLocationX + r,
+                           inLocationY + r );
+
+        if( *inChecked ) {
+            mx_guiAddLine( inGUI,
+                           0,
+                           &c,
+                           inLocationX - r,
+                           inLocationY - r,
+                           inLocationX + r,
+                           inLocationY + r );
+            mx_guiAddLine( inGUI,
+                           0,
+                           &c,
+                           inLocationX + r,
+                           inLocationY - r,
+                           inLocationX - r,
+                           inLocationY + r );
             }
         }
     }
 
 
 
-void maxigin_drawRect( int  inStartX,
-                       int  inStartY,
-                       int  inEndX,
-                       int  inEndY ) {
+/* returns sprite handle, or -1 if no sprite (label string might be set in
+   this case)
 
-    /* prevent overlapping pixels at corners.
-       to make this easier, first ensure start is top left
-       and end is bottom right. */
+   outLabelString  set to 0 or English-language key name string, if needed
 
-    int  temp;
+   Note that if outLabelString is a single character, sprite handle might
+   be set to a blank key-cap sprite to draw under this character
 
-    if( inStartX > inEndX ) {
-        temp     = inEndX;
-        inEndX   = inStartX;
-        inStartX = temp;
-        }
-    if( inStartY > inEndY ) {
-        temp     = inEndY;
-        inEndY   = inStartY;
-        inStartY = temp;
-        }
-        
-    maxigin_drawLine( inStartX,
-                      inStartY,
-                      inStartX,
-                      inEndY );
-    
-    maxigin_drawLine( inStartX + 1,  /* no overlap */
-                      inEndY,
-                      inEndX,
-                      inEndY );
-    
-    maxigin_drawLine( inEndX,
-                      inEndY - 1,    /* no overlap */
-                      inEndX,
-                      inStartY );
-    
-    maxigin_drawLine( inEndX - 1,    /* no overlap */
-                      inStartY,
-                      inStartX + 1,  /* no overlap */
-                      inStartY );
-    }
+   inButtonHandle is in maxigin-remapped button space
+*/
+static int mx_getButtonHintSprite( int           inButtonHandle,
+                                   const char  **outLabelString );
 
 
+static int mx_getButtonHintFont( void );
 
-void maxigin_drawFillRect( int  inStartX,
-                           int  inStartY,
-                           int  inEndX,
-                           int  inEndY ) {
 
-    int  x;
-    int  y;
-    int  pixelStartByte;
-    int  lineA            =  mx_drawColor.comp.alpha;
-    int  rowHop;
-    int  temp;
-    
-    /* color components with alpha pre-multiplied */   
-    int  linePreR         =  mx_drawColor.comp.red   * lineA;
-    int  linePreG         =  mx_drawColor.comp.green * lineA;
-    int  linePreB         =  mx_drawColor.comp.blue  * lineA;
-    int  lineScaledR      =  linePreR / 255;
-    int  lineScaledG      =  linePreG / 255;
-    int  lineScaledB      =  linePreB / 255;
-    
-    if( lineA == 0 ) {
-        return;
+
+static char mx_guiButtonBody( MaxiginGUI  *inGUI,
+                              int         *inHandle,
+                              int          inHintButtonHandle,
+                              int          inLocationX,
+                              int          inLocationY,
+                              int          inRadiusX,
+                              int          inRadiusY ) {
+
+    MaxiginColor  c;
+    int           rLeft      =  -inRadiusX;
+    int           rRight     =   inRadiusX;
+    int           rTop       =  -inRadiusY;
+    int           rBot       =   inRadiusY;
+    char          mouseDown  =   mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON );
+    int           x          =   0;
+    int           y          =   0;
+    char          avail      =   maxigin_getPointerLocation( &x,
+                                                             &y );
+    char          returnV    =   0;
+
+    if( mx_buttonSpritesSet ) {
+        MaxiginSprite  *s  = &( mx_sprites[ mx_buttonSprites.cool ] );
+
+        rLeft  =  - s->leftVisibleRadius;
+        rRight =    s->rightVisibleRadius;
+        rTop   =  - s->upperVisibleRadius;
+        rBot   =    s->lowerVisibleRadius;
         }
 
-    /* skip rects that are completely out of bounds */
-    if( inStartX < 0
+    x -= inGUI->zeroOffsetX;
+    y -= inGUI->zeroOffsetY;
+
+    x -= inLocationX;
+    y -= inLocationY;
+
+    /* if mouse is over us, check for new press */
+    if( avail
         &&
-        inEndX < 0 ) {
-        
-        return;
-        }
-    if( inStartX >= MAXIGIN_GAME_NATIVE_W
+        x >= rLeft
         &&
-        inEndX   >= MAXIGIN_GAME_NATIVE_W ) {
-        
-        return;
-        }
-    if( inStartY < 0
+        x <= rRight
         &&
-        inEndY < 0 ) {
-        
-        return;
-        }
-    if( inStartY >= MAXIGIN_GAME_NATIVE_H
+        y >= rTop
         &&
-        inEndY   >= MAXIGIN_GAME_NATIVE_H ) {
-        
-        return;
-        }
-    
-    /* trim to be in-bounds of image */
-    if( inStartX < 0 ) {
-        inStartX = 0;
-        }
-    if( inStartX >= MAXIGIN_GAME_NATIVE_W ) {
-        inStartX = MAXIGIN_GAME_NATIVE_W - 1;
-        }
-    if( inEndX < 0 ) {
-        inEndX = 0;
-        }
-    if( inEndX >= MAXIGIN_GAME_NATIVE_W ) {
-        inEndX = MAXIGIN_GAME_NATIVE_W - 1;
-        }
-    if( inStartY < 0 ) {
-        inStartY = 0;
-        }
-    if( inStartY >= MAXIGIN_GAME_NATIVE_H ) {
-        inStartY = MAXIGIN_GAME_NATIVE_H - 1;
-        }
-    if( inEndY < 0 ) {
-        inEndY = 0;
-        }
-    if( inEndY >= MAXIGIN_GAME_NATIVE_H ) {
-        inEndY = MAXIGIN_GAME_NATIVE_H - 1;
-        }
-
-    /* fix draw direction */
-    if( inStartX > inEndX ) {
-        temp     = inEndX;
-        inEndX   = inStartX;
-        inStartX = temp;
-        }
-    if( inStartY > inEndY ) {
-        temp     = inEndY;
-        inEndY   = inStartY;
-        inStartY = temp;
-        }
-
-    rowHop         = MAXIGIN_GAME_NATIVE_W * 3;
-    pixelStartByte = inStartY * rowHop + inStartX * 3;
+        y <= rBot ) {
 
-    if( mx_additiveBlend ) {
-        /* additive blend */
+        if( inGUI->active == 0
+            ||
+            inGUI->active == inHandle ) {
+            /* don't become hot if mouse pressed on other component */
+            inGUI->hot = inHandle;
+            }
         
-        for( y =  inStartY;
-             y <= inEndY;
-             y ++ ) {
-
-            pixelStartByte = y * rowHop + inStartX * 3;
+        if( ! inGUI->mouseDown
+            &&
+            mouseDown ) {
             
-            for( x =  inStartX;
-                 x <= inEndX;
-                 x ++ ) {
-                
-                int  v;
-
-                v = mx_gameImageBuffer[ pixelStartByte ] + lineScaledR;
-                if( v > 255 ) {
-                    v = 255;
-                    }
-                mx_gameImageBuffer[ pixelStartByte ] = (unsigned char)v;
-
-                v = mx_gameImageBuffer[ pixelStartByte + 1 ] + lineScaledG;
-                if( v > 255 ) {
-                    v = 255;
-                    }
-                mx_gameImageBuffer[ pixelStartByte + 1 ] = (unsigned char)v;
+            inGUI->mouseDown = 1;
+            inGUI->active = inHandle;
+            }
+        else if( inGUI->mouseDown
+                 &&
+                 inGUI->active == inHandle
+                 &&
+                 ! mouseDown ) {
 
-                v = mx_gameImageBuffer[ pixelStartByte + 2 ] + lineScaledB;
-                if( v > 255 ) {
-                    v = 255;
-                    }
-                mx_gameImageBuffer[ pixelStartByte + 2 ] = (unsigned char)v; 
+            /* mouse released on us when it was pressed on us before,
+               count as press */
+            returnV = 1;
+            
+            inGUI->mouseDown = 0;
 
-                /* next col */
-                pixelStartByte += 3;
-                }
+            inGUI->active = 0;
             }
         }
     else {
+        /* mouse not over us
+           watch for release far away due to a press that started on us */
 
-        if( lineA == 255 ) {
-            /* replace color, no blend */
-            
-            for( y =  inStartY;
-                 y <= inEndY;
-                 y ++ ) {
+        if( inGUI->hot == inHandle ) {
+            inGUI->hot = 0;
+            }
+        
+        if( inGUI->mouseDown
+            &&
+            inGUI->active == inHandle
+            &&
+            ! mouseDown ) {
+
+            /* don't count as press if it was released away from us */
+            inGUI->mouseDown = 0;
 
-                pixelStartByte = y * rowHop + inStartX * 3;
+            inGUI->active = 0;
+            }
+        }
+    
 
-                for( x =  inStartX;
-                     x <= inEndX;
-                     x ++ ) {
+    if( mx_buttonSpritesSet ) {
 
-                    mx_gameImageBuffer[ pixelStartByte ++ ] =
-                        mx_drawColor.comp.red;
-                    
-                    mx_gameImageBuffer[ pixelStartByte ++ ] =
-                        mx_drawColor.comp.green;
-                    
-                    mx_gameImageBuffer[ pixelStartByte ++ ] =
-                        mx_drawColor.comp.blue;
-                    }
-                }
+        int  s;
+        
+        if( inGUI->hot      == inHandle
+            ||
+            inGUI->forceHot == inHandle ) {
+            
+            s = mx_buttonSprites.hot;
             }
         else {
-            /* weighted alpha belnd */
-                    
-            for( y =  inStartY;
-                 y <= inEndY;
-                 y ++ ) {
+            s = mx_buttonSprites.cool;
+            }
 
-                pixelStartByte = y * rowHop + inStartX * 3;
+        if( inGUI->active == inHandle ) {
+            s = mx_buttonSprites.pressed;
+            }
 
-                for( x =  inStartX;
-                     x <= inEndX;
-                     x ++ ) {
-                                     
-                    mx_gameImageBuffer[ pixelStartByte ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ pixelStartByte ]
-                              * ( 255 - lineA )
-                              +
-                              linePreR )
-                            /
-                            255 );
+        mx_guiAddSprite( inGUI,
+                         0,
+                         255,
+                         s,
+                         inLocationX,
+                         inLocationY);
+        }
+    else {
+        /* no sprites, draw with shapes */
+        unsigned char  frameV  =  128;
+        unsigned char  fillV   =  64;
+        
+        
+        if( inGUI->hot      == inHandle
+            ||
+            inGUI->forceHot == inHandle ) {
+            
+            frameV = 255;
+            }
+        
+        if( inGUI->active == inHandle ) {
+            fillV = 0;
+            }
 
-                    mx_gameImageBuffer[ pixelStartByte + 1 ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ pixelStartByte + 1 ]
-                              * ( 255 - lineA )
-                              +
-                              linePreG )
-                            /
-                            255 );
-                
-                    mx_gameImageBuffer[ pixelStartByte + 2 ] =
-                        (unsigned char)( 
-                            ( mx_gameImageBuffer[ pixelStartByte + 2 ]
-                              * ( 255 - lineA )
-                              +
-                              linePreB )
-                            /
-                            255 );
 
-                    /* next col */
-                    pixelStartByte += 3;
-                    }
-                }
-            }
-        }   
-    }
+        mx_makeColorGray( &c,
+                          fillV );
 
+        c.comp.alpha = 255;
+    
+        mx_guiAddFillRect( inGUI,
+                           0,
+                           &c,
+                           inLocationX - inRadiusX,
+                           inLocationY - inRadiusY,
+                           inLocationX + inRadiusX,
+                           inLocationY + inRadiusY );
+        
 
+        mx_makeColorGray( &c,
+                          frameV );
 
-void maxigin_initGUI( MaxiginGUI *inGUI ) {
+        c.comp.alpha = 255;
+    
+        mx_guiAddDrawRect( inGUI,
+                           0,
+                           &c,
+                           inLocationX - inRadiusX,
+                           inLocationY - inRadiusY,
+                           inLocationX + inRadiusX,
+                           inLocationY + inRadiusY );
 
-    inGUI->zeroOffsetX        = MAXIGIN_GAME_NATIVE_W / 2;
-    inGUI->zeroOffsetY        = MAXIGIN_GAME_NATIVE_H / 2;
-    inGUI->fade               = 255;
-    inGUI->hot                = 0;
-    inGUI->active             = 0;
-    inGUI->forceHot           = 0;
-    inGUI->mouseDown          = 0;
-    inGUI->activeMouseOffsetX = 0;
-    inGUI->activeMouseOffsetY = 0;
-    inGUI->numDrawComponents  = 0;
-    }
+        }    
+    
 
 
+    /* now draw button text on top */
 
-void maxigin_drawGUI( MaxiginGUI *inGUI ) {
 
-    int            i;
-    int            drawType;
-    int            xO         =  inGUI->zeroOffsetX;
-    int            yO         =  inGUI->zeroOffsetY;
-    unsigned char  fade       =  inGUI->fade;
-    
-    for( i = 0;
-         i < inGUI->numDrawComponents;
-         i ++ ) {
+    if( inHintButtonHandle != -1 ) {
 
-        drawType = inGUI->drawComponents[i].drawType;
+        const char  *s;
+        int          hintSprite  =  mx_getButtonHintSprite( inHintButtonHandle,
+                                                            &s );
         
-        maxigin_drawToggleAdditive( inGUI->drawComponents[i].additiveBlend );
-
-        if( drawType == MX_GUI_DRAW_LINE
-            ||
-            drawType == MX_GUI_DRAW_RECT
-            ||
-            drawType == MX_GUI_FILL_RECT
-            ||
-            drawType == MX_GUI_DRAW_SPRITE
-            ||
-            drawType == MX_GUI_DRAW_SPRITE_SEQUENCE
-            ||
-            drawType == MX_GUI_DRAW_TEXT
-            ||
-            drawType == MX_GUI_DRAW_LANG_TEXT ) {
+        /* skip drawing any that are just text labels with no sprite */
+        if( hintSprite != -1 ) {
+            
+            int          hintX  =  inLocationX;
 
-            maxigin_drawSetColor(
-                inGUI->drawComponents[i].red,
-                inGUI->drawComponents[i].green,
-                inGUI->drawComponents[i].blue,
-                (unsigned char)(
-                    ( inGUI->drawComponents[i].alpha * fade ) / 255 ) );
-            }
+            if( mx_buttonSpritesSet ) {
+                hintX -= mx_sprites[ mx_buttonSprites.cool ].leftVisibleRadius;
+                }
+            else {
+                hintX -= inRadiusX;
+                }
 
-        switch( drawType ) {
+            hintX -= mx_sprites[ hintSprite ].rightVisibleRadius;
 
-            case MX_GUI_SUB_PANEL_START:
-                xO  += inGUI->drawComponents[i].drawParams.panelStart.plusX;
-                yO  += inGUI->drawComponents[i].drawParams.panelStart.plusY;
-                fade = inGUI->drawComponents[i].drawParams.panelStart.newFade;
-                break;
-                
-            case MX_GUI_SUB_PANEL_END:
-                xO  += inGUI->drawComponents[i].drawParams.panelEnd.plusX;
-                yO  += inGUI->drawComponents[i].drawParams.panelEnd.plusY;
-                fade = inGUI->drawComponents[i].drawParams.panelEnd.oldFade;
-                break;
-                
-            case MX_GUI_DRAW_LINE:
-                maxigin_drawLine(
-                    inGUI->drawComponents[i].drawParams.line.startX + xO,
-                    inGUI->drawComponents[i].drawParams.line.startY + yO,
-                    inGUI->drawComponents[i].drawParams.line.endX + xO,
-                    inGUI->drawComponents[i].drawParams.line.endY + yO );
-                break;
-                
-            case MX_GUI_DRAW_RECT:
-                maxigin_drawRect(
-                    inGUI->drawComponents[i].drawParams.rect.startX + xO,
-                    inGUI->drawComponents[i].drawParams.rect.startY + yO,
-                    inGUI->drawComponents[i].drawParams.rect.endX + xO,
-                    inGUI->drawComponents[i].drawParams.rect.endY + yO );
-                break;
-                
-            case MX_GUI_FILL_RECT:
-                maxigin_drawFillRect(
-                    inGUI->drawComponents[i].drawParams.rect.startX + xO,
-                    inGUI->drawComponents[i].drawParams.rect.startY + yO,
-                    inGUI->drawComponents[i].drawParams.rect.endX + xO,
-                    inGUI->drawComponents[i].drawParams.rect.endY + yO );
-                break;
+            hintX -= 3;
+            
                 
-            case MX_GUI_DRAW_SPRITE:
-                maxigin_drawSprite(
-                    inGUI->drawComponents[i].drawParams.sprite.spriteHandle,
-                    inGUI->drawComponents[i].drawParams.sprite.centerX + xO,
-                    inGUI->drawComponents[i].drawParams.sprite.centerY + yO );
-                break;
-            case MX_GUI_DRAW_SPRITE_SEQUENCE: {
+            mx_guiAddSprite( inGUI,
+                             0,
+                             255,
+                             hintSprite,
+                             hintX,
+                             inLocationY );
+            
+            if( s != 0 ) {
 
-                int  s;
-                int  x   =  inGUI->drawComponents[i].
-                                drawParams.spriteSequence.startCenterX + xO;
-                int  y   =  inGUI->drawComponents[i].
-                                drawParams.spriteSequence.startCenterY + yO;
-                
-                for( s = 0;
-                     s < inGUI->drawComponents[i].
-                         drawParams.spriteSequence.count;
-                     s ++ ) {
+                int  fontHandle  =  mx_getButtonHintFont();
+
+                if( fontHandle != -1 ) {
+                    
+                    MaxiginColor  fc;
+                    int           spriteLeftR;
+                    
+                    mx_makeColorGray( &fc,
+                                      255 );
+                    fc.comp.alpha = 255;
 
-                    maxigin_drawSprite(
-                        inGUI->drawComponents[i].
-                            drawParams.spriteSequence.spriteHandle,
-                        x,
-                        y );
-                
-                    x += inGUI->drawComponents[i].
-                        drawParams.spriteSequence.offsetX;
-                    y += inGUI->drawComponents[i].
-                        drawParams.spriteSequence.offsetY;
+                    /* put label on key cap */
+                            
+                    spriteLeftR =
+                        mx_sprites[ hintSprite ].leftVisibleRadius;
+                            
+                    mx_guiAddText( &mx_internalGUI,
+                                   &fc,
+                                   fontHandle,
+                                   (char*)s,
+                                   hintX - spriteLeftR + 3,
+                                   inLocationY  - 1,
+                                   MAXIGIN_LEFT );
                     }
-                
                 }
-                break;
-            case MX_GUI_DRAW_TEXT:
-                maxigin_drawText(
-                    inGUI->drawComponents[i].drawParams.text.fontHandle,
-                    inGUI->drawComponents[i].drawParams.text.textString,
-                    inGUI->drawComponents[i].drawParams.text.anchorX + xO,
-                    inGUI->drawComponents[i].drawParams.text.anchorY + yO,
-                    inGUI->drawComponents[i].drawParams.text.align );
-                break;    
-            case MX_GUI_DRAW_LANG_TEXT:
-                maxigin_drawLangText(
-                    inGUI->drawComponents[i].drawParams.langText.phraseKey,
-                    inGUI->drawComponents[i].drawParams.langText.anchorX + xO,
-                    inGUI->drawComponents[i].drawParams.langText.anchorY + yO,
-                    inGUI->drawComponents[i].drawParams.langText.align );
-                break;
             }
         }
+    
+
+    return returnV;
     }
 
 
 
-void maxigin_startGUI( MaxiginGUI *inGUI ) {
-    inGUI->zeroOffsetX        = MAXIGIN_GAME_NATIVE_W / 2;
-    inGUI->zeroOffsetY        = MAXIGIN_GAME_NATIVE_H / 2;
-    inGUI->fade               = 255;
-    inGUI->numDrawComponents = 0;
-    }
+char maxigin_guiLangButton( MaxiginGUI  *inGUI,
+                            int         *inHandle,
+                            int          inPhraseKey,
+                            int          inHintButtonHandle,
+                            int          inLocationX,
+                            int          inLocationY,
+                            int          inRadiusX,
+                            int          inRadiusY ) {
+    
+    MaxiginColor  c;
+    char          returnV  =  mx_guiButtonBody( inGUI,
+                                                inHandle,
+                                                inHintButtonHandle,
+                                                inLocationX,
+                                                inLocationY,
+                                                inRadiusX,
+                                                inRadiusY );
 
+    mx_makeColorGray( &c,
+                      255 );
+    c.comp.alpha = 255;
+    
+    mx_guiAddLangText( inGUI,
+                   &c,
+                   inPhraseKey,
+                   inLocationX,
+                   inLocationY - 1,
+                   MAXIGIN_CENTER );
 
 
-void maxigin_endGUI( MaxiginGUI *inGUI ) {
-    if( ! inGUI->mouseDown ) {
+    return returnV;
+    }
 
-        if( mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON ) ) {
 
-            /* The button was pressed fresh this step, but NONE
-               of our GUI components were hit by it.
-               Mark it as pressed now, so none will react to it's pressed
-               state by accident next step. */
 
-            inGUI->mouseDown = 1;
-            }
-        }
-    else {
-        /* mouse marked as held down, has it released? */
-        if( ! mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON ) ) {
+char maxigin_guiButton( MaxiginGUI  *inGUI,
+                        int         *inHandle,
+                        int          inFontHandle,
+                        char        *inString,
+                        int          inHintButtonHandle,
+                        int          inLocationX,
+                        int          inLocationY,
+                        int          inRadiusX,
+                        int          inRadiusY ) {
+    
+    MaxiginColor  c;
+    char          returnV  =  mx_guiButtonBody( inGUI,
+                                                inHandle,
+                                                inHintButtonHandle,
+                                                inLocationX,
+                                                inLocationY,
+                                                inRadiusX,
+                                                inRadiusY );
+    mx_makeColorGray( &c,
+                      255 );
+    c.comp.alpha = 255;
+    
+    mx_guiAddText( inGUI,
+                   &c,
+                   inFontHandle,
+                   inString,
+                   inLocationX,
+                   inLocationY - 1,
+                   MAXIGIN_CENTER );
+    
+    return returnV;
+    }
 
-            inGUI->mouseDown = 0;
 
-            /* endGUI called after all of our components have had a chance
-               to update and notice that the mouse is no longer down.
-               Any active component should have become non-active.
-               However, if our GUI state is being loaded from a saved game
-               state, this might not be the case (if a component was active
-               when the game was saved). */
-            
-            inGUI->active = 0;
-            }
-        }
-        
-    }
 
 
 
-static void mx_guiSetColor( MaxiginGUI    *inGUI,
-                            int            inDrawComponentIndex,
-                            char           inAdditiveBlend,
-                            MaxiginColor  *inColor ) {
+/*
+  Note about recording/playback:
 
-    int  i  =  inDrawComponentIndex;
-    
-    inGUI->drawComponents[i].additiveBlend = inAdditiveBlend;
+  We actually RECORD the state of this static memory to persistent storage
+  after every step (only storing a sparse map of which bytes have changed)
+  and then use that to do full game playback, including smooth rewinding and
+  time jumping forward and back.
 
-    inGUI->drawComponents[i].red   = inColor->comp.red;
-    inGUI->drawComponents[i].green = inColor->comp.green;
-    inGUI->drawComponents[i].blue  = inColor->comp.blue;
-    inGUI->drawComponents[i].alpha = inColor->comp.alpha;
-    }
+  The old minorGems game engine recorded input events, the system clock, etc,
+  and then let the game code replay itself, which is useful for catching bugs,
+  but also fragile, and doesn't allow time-jumping, which made it too much of a
+  pain to use (if someone submitted a long game with a bug a the end, I didn't
+  have time to watch the whole thing).
 
+  This system allows fast forward and rewind, and pause.
 
+  And then you can see a bug happen (or it will just end, if there was a crash).
 
-static void mx_guiAddLine( MaxiginGUI    *inGUI,
-                           char           inAdditiveBlend,
-                           MaxiginColor  *inColor,
-                           int            inStartX,
-                           int            inStartY,
-                           int            inEndX,
-                           int            inEndY ) {
+  Then you can rewind to the frame before the bug, and then "unleash" it
+  to run on the real game code again, but stop playing back, and then
+  try to trigger the bug yourself.  I.e., you get to the point right before
+  the bug, and then you take the reigns by clicking and pressing buttons.
 
-    int  i  =  inGUI->numDrawComponents;
+  We save space by not saving entire memory each step, but just a diff from a
+  periodic full keyframe.
+  
+  A few things to consider:
 
-    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
-        mingin_log( "Error:  trying to add a line to a full "
-                    "MaxiginGUI instance.\n" );
-        return;
-        }
+  1. This requires two extra static buffers that are at least as big as all
+     of the registered memory regions, so that we can compute a diff at
+     each timestep (and keep track of the diff-summed state currently in our
+     file).  We give the .h user a #define that lets them set this size, or
+     turn this off on platforms where we don't want 3x memory usage.
+     
+  2. Diff steps will vary in size, which means we can't just seek to a known
+     location in the file for accurate time-jumping.  We could write a separate
+     index file in parallel that records file pos offsets of keyframes every 1
+     second or whatever, and then, when the recording is done, we append this
+     index to our recording, with a pointer at the end of the file that points
+     back into the file at the location where this index starts.  During
+     playback, we do instant time-jumping by jumping around in this
+     index portion of the file, which will tell us the location of the keyframe
+     to jump to in the main part of the file.
 
-    mx_guiSetColor( inGUI,
-                    i,
-                    inAdditiveBlend,
-                    inColor );
+  3. Since each diff step is an XOR from the previous state, we can use it
+     during playback to advance forward from the previous state, but we can
+     also use it to go backwards from this state back to the previous state
+     (xor can do and undo changes by applying it).  This allows reverse
+     playback.
 
-    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_LINE;
-    
-    inGUI->drawComponents[i].drawParams.line.startX = inStartX;
-    inGUI->drawComponents[i].drawParams.line.startY = inStartY;
-    inGUI->drawComponents[i].drawParams.line.endX   = inEndX;
-    inGUI->drawComponents[i].drawParams.line.endY   = inEndY;
+  4. Fast-forward and fast-rewind are achieved by simply playing multiple diff
+     steps before updating the screen.  This seems to work great for 2x, 4x,
+     8x, etc. during testing.  Of course, beyond that, instant time-jumping
+     can be used.
 
-    inGUI->numDrawComponents ++;
-    }
+  5. After a crash, the recording is not finalized (the index is not appended
+     to the end of the recording and removed as a separate file).  On the next
+     run, we do crash recovery and finalize this recording file.
+
+  6. The game's step code is skipped completely during playback.  We assume
+     that the step code is where the state is updated, and we've recorded
+     the entire state, so we can update it without calling the game's step.
+     However, the game's drawing code is still called to draw that changing
+     state.
+*/
 
 
+static void mx_initRecording( void );
 
-static void mx_guiAddRect( MaxiginGUI    *inGUI,
-                           char           inAdditiveBlend,
-                           MaxiginColor  *inColor,
-                           int            inStartX,
-                           int            inStartY,
-                           int            inEndX,
-                           int            inEndY,
-                           int            inDrawType ) {
+static void mx_stepRecording( void );
 
-    int  i  =  inGUI->numDrawComponents;
+static void mx_finalizeRecording( void );
 
-    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
-        mingin_log( "Error:  trying to add a rectangle to a full "
-                    "MaxiginGUI instance.\n" );
-        return;
-        }
+static void mx_recordingCrashRecovery( void );
 
-    mx_guiSetColor( inGUI,
-                    i,
-                    inAdditiveBlend,
-                    inColor );
 
-    inGUI->drawComponents[i].drawType = inDrawType;
-    
-    inGUI->drawComponents[i].drawParams.rect.startX = inStartX;
-    inGUI->drawComponents[i].drawParams.rect.startY = inStartY;
-    inGUI->drawComponents[i].drawParams.rect.endX   = inEndX;
-    inGUI->drawComponents[i].drawParams.rect.endY   = inEndY;
+/* copies live memory records aside, into the recording arena, which
+   must not be in use by recording or playback
+   returns 1 if they fit, 0 if not */
+static char mx_backupMemoryRecords( void );
+
+/* puts back memory records copied aside by mx_backupMemoryRecords */
+static void mx_restoreMemoryRecordsBackup( void );
 
-    inGUI->numDrawComponents ++;
-    }
 
+/* returns 1 if playback started, 0 if not */
+static char mx_initPlayback( void );
 
-static void mx_guiAddDrawRect( MaxiginGUI    *inGUI,
-                               char           inAdditiveBlend,
-                               MaxiginColor  *inColor,
-                               int            inStartX,
-                               int            inStartY,
-                               int            inEndX,
-                               int            inEndY ) {
 
-    mx_guiAddRect( inGUI,
-                   inAdditiveBlend,
-                   inColor,
-                   inStartX,
-                   inStartY,
-                   inEndX,
-                   inEndY,
-                   MX_GUI_DRAW_RECT );
-    }
+/* returns 1 of playback happening, 0 if not
+   ignores pause state */
+static char mx_playbackStep( void );
 
+/* executes multi-steps, or delayed steps, basked on mx_playbackSpeed
+   obeys pause state */
+static char mx_playbackSpeedStep( void );
 
+static void mx_playbackJumpHalfAhead( void );
+static void mx_playbackJumpHalfBack( void );
 
-static void mx_guiAddFillRect( MaxiginGUI    *inGUI,
-                               char           inAdditiveBlend,
-                               MaxiginColor  *inColor,
-                               int            inStartX,
-                               int            inStartY,
-                               int            inEndX,
-                               int            inEndY ) {
-    
-    mx_guiAddRect( inGUI,
-                   inAdditiveBlend,
-                   inColor,
-                   inStartX,
-                   inStartY,
-                   inEndX,
-                   inEndY,
-                   MX_GUI_FILL_RECT );
-    }
+static void mx_playbackEnd( void );
 
+static void mx_playbackJumpToFullSnapshot( int inFullSnapshotIndex );
 
-static void mx_guiAddSprite( MaxiginGUI    *inGUI,
-                             char           inAdditiveBlend,
-                             unsigned char  inAlpha,
-                             int            inSpriteHandle,
-                             int            inCenterX,
-                             int            inCenterY ) {
+static void mx_playbackJumpToStep( int inStepNumber );
 
-    int           i  =  inGUI->numDrawComponents;
-    MaxiginColor  c;
-    
-    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
-        mingin_log( "Error:  trying to add a sprite to a full "
-                    "MaxiginGUI instance.\n" );
-        return;
-        }
+static char mx_playbackStepForward( void );
+static char mx_playbackStepBackward( void );
 
-    c.val[0] = 255;
-    c.val[1] = 255;
-    c.val[2] = 255;
-    c.val[3] = inAlpha;
-    
-    mx_guiSetColor( inGUI,
-                    i,
-                    inAdditiveBlend,
-                    &c );
+/* takes inNumSteps backward steps, from a keyframe when that's cheaper */
+static char mx_playbackMultiStepBackward( int  inNumSteps );
 
-    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_SPRITE;
-    
-    inGUI->drawComponents[i].drawParams.sprite.spriteHandle = inSpriteHandle;
-    inGUI->drawComponents[i].drawParams.sprite.centerX      = inCenterX;
-    inGUI->drawComponents[i].drawParams.sprite.centerY      = inCenterY;
+/* replays playback data store headless, returns number of mismatched
+   snapshots, or -1 on failure */
+static int mx_verifyPlayback( void );
 
-    inGUI->numDrawComponents ++;
-    }
 
+static void mx_gameInit( void );
 
+static void mx_saveGame( void );
 
-static void mx_guiAddSpriteSequence( MaxiginGUI    *inGUI,
-                                     char           inAdditiveBlend,
-                                     unsigned char  inAlpha,
-                                     int            inSpriteHandle,
-                                     int            inStartCenterX,
-                                     int            inStartCenterY,
-                                     int            inOffsetX,
-                                     int            inOffsetY,
-                                     int            inCount ) {
+static char mx_copyIntoDataStore( int inStoreReadHandle,
+                                  int inStoreWriteHandle,
+                                  int inNumBytesToCopy );
 
-    int           i  =  inGUI->numDrawComponents;
-    MaxiginColor  c;
-    
-    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
-        mingin_log( "Error:  trying to add a sprite sequence to a full "
-                    "MaxiginGUI instance.\n" );
-        return;
-        }
+static void mx_startPlayingMusic( const char  *inMusicBulkResourceName );
 
-    c.val[0] = 255;
-    c.val[1] = 255;
-    c.val[2] = 255;
-    c.val[3] = inAlpha;
-    
-    mx_guiSetColor( inGUI,
-                    i,
-                    inAdditiveBlend,
-                    &c );
+static void mx_stopPlayingMusic( void );
 
-    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_SPRITE_SEQUENCE;
-    
-    inGUI->drawComponents[i].drawParams.spriteSequence.spriteHandle
-        = inSpriteHandle;
-    
-    inGUI->drawComponents[i].drawParams.spriteSequence.startCenterX
-        = inStartCenterX;
-    
-    inGUI->drawComponents[i].drawParams.spriteSequence.startCenterY
-        = inStartCenterY;
 
-    inGUI->drawComponents[i].drawParams.spriteSequence.offsetX
-        = inOffsetX;
-    
-    inGUI->drawComponents[i].drawParams.spriteSequence.offsetY
-        = inOffsetY;
 
-    inGUI->drawComponents[i].drawParams.spriteSequence.count
-        = inCount;
+static char mx_isActionFreshPressed( MaxiginUserAction  inAction ) {
 
-    inGUI->numDrawComponents ++;
+    char fresh = 0;
+    
+    if( mingin_isButtonDown( inAction ) ) {
+        if( ! mx_buttonsDown[ inAction ] ) {
+            fresh = 1;
+            }
+        mx_buttonsDown[ inAction ] = 1;
+        }
+    else {
+        mx_buttonsDown[ inAction ] = 0;
+        }
+
+    return fresh;
     }
 
 
 
-static void mx_makeColorGray( MaxiginColor   *inC,
-                              unsigned char   inGrayVal ) {
+static  char           mx_playbackInterruptedRecording     =  0;
+static  char           mx_playbackInstantReverseRecording  =  0;
+static  char           mx_enableAutoQuit                   =  0;
+static  char           mx_verifyPlaybackMode               =  0;
+static  char           mx_quitting                         =  0;
+static  char           mx_quittingReady                    =  0;
+static  char           mx_playbackSliderActive             =  0;
+static  char           mx_playbackBlockForwardSounds       =  0;
+static  char           mx_menuShowing                      =  0;
+static  int            mx_menuFade                         =  0;
+static  int            mx_menuFadeMax                      =  2550;
+static  char           mx_langPanelShowing                 =  0;
+static  char           mx_controlsPanelShowing             =  0;
+static  void          *mx_menuReturnForceHot               =  0;
+static  char           mx_blockMenuClose                   =  0;
 
-    inC->val[0] = inGrayVal;
-    inC->val[1] = inGrayVal;
-    inC->val[2] = inGrayVal;
-    }
 
 
+/* initiates and steps sound fade out, returning 1 when finally done
+   returns 0 while still in-progress */
+static char mx_stepSoundFadeOut( void );
 
-static void mx_guiAddText( MaxiginGUI    *inGUI,
-                           MaxiginColor  *inC,
-                           int            inFontHandle,
-                           char          *inString,
-                           int            inAnchorX,
-                           int            inAnchorY,
-                           MaxiginAlign   inAlign ) {
-    
-    int  i  =  inGUI->numDrawComponents;
+/* maps playback speed/direction to sound speed and direction */
+static void mx_setSoundSpeedAndDirection( int  inSpeed,
+                                          int  inDirection );
 
+static int mx_getMusicFilePos( void );
 
-    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
-        mingin_log( "Error:  trying to add text to a full "
-                    "MaxiginGUI instance.\n" );
-        return;
-        }
-    
-    mx_guiSetColor( inGUI,
-                    i,
-                    0,
-                    inC );
+static void mx_setMusicFilePos( int  inPos );
 
-    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_TEXT;
-    
-    inGUI->drawComponents[i].drawParams.text.fontHandle = inFontHandle;
-    inGUI->drawComponents[i].drawParams.text.textString = inString;
-    inGUI->drawComponents[i].drawParams.text.anchorX    = inAnchorX;
-    inGUI->drawComponents[i].drawParams.text.anchorY    = inAnchorY;
-    inGUI->drawComponents[i].drawParams.text.align      = inAlign;
-    
+static void mx_startSoundShortFadeIn( void );
 
-    inGUI->numDrawComponents ++;
-    }
+static void mx_renewSoundStartFadeIn( void );
 
+static void mx_startSoundPauseRamp( void );
 
+static void mx_clearJustStartedSoundEffects( void );
 
-static void mx_guiAddLangText( MaxiginGUI    *inGUI,
-                               MaxiginColor  *inC,
-                               int            inPhraseKey,
-                               int            inAnchorX,
-                               int            inAnchorY,
-                               MaxiginAlign   inAlign ) {
-    
-    int  i  =  inGUI->numDrawComponents;
 
+/* returns sound effect handle of next, and clears it from
+   list.
 
-    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
-        mingin_log( "Error:  trying to add language text to a full "
-                    "MaxiginGUI instance.\n" );
-        return;
-        }
-    
-    mx_guiSetColor( inGUI,
-                    i,
-                    0,
-                    inC );
+   returns -1 if none left */
+static int mx_getNextJustStartedSoundEffect( int  *outLoudness );
+static int mx_getNextJustEndedSoundEffect( int  *outLoudness );
 
-    inGUI->drawComponents[i].drawType = MX_GUI_DRAW_LANG_TEXT;
-    
-    inGUI->drawComponents[i].drawParams.langText.phraseKey  = inPhraseKey;
-    inGUI->drawComponents[i].drawParams.langText.anchorX    = inAnchorX;
-    inGUI->drawComponents[i].drawParams.langText.anchorY    = inAnchorY;
-    inGUI->drawComponents[i].drawParams.langText.align      = inAlign;
-    
 
-    inGUI->numDrawComponents ++;
-    }
+static void mx_processDoneSoundEffects( void );
 
 
+static void mx_endAllSoundEffectsNow( void );
 
-static void mx_getSliderThumbRadius( int   inThumbWidth,
-                                     int  *outLeftRadius,
-                                     int  *outRightRadius ) {
-    if( mx_sliderSpritesSet ) {
-        
-        int  thumbHandle  =  mx_sliderSprites.thumb[1];
 
-        *outLeftRadius  = mx_sprites[ thumbHandle ].leftVisibleRadius;
-        *outRightRadius = mx_sprites[ thumbHandle ].rightVisibleRadius;
-        }
-    else {
-        *outRightRadius = inThumbWidth / 2;
-        *outLeftRadius  = inThumbWidth / 2;
-        }
-    }
+/* passed-in buffers must have room for MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS */
+static int mx_getLiveSoundEffects( int *outHandleBuffer,
+                                   int *outLoudnessBuffer,
+                                   int *outDataPosBuffer );
 
 
+static void mx_nextLang( void );
 
-char maxigin_guiSlider( MaxiginGUI  *inGUI,
-                        int         *inCurrentValue,
-                        int          inMinValue,
-                        int          inMaxValue,
-                        int          inStartX,
-                        int          inEndX,
-                        int          inY,
-                        int          inBarHeight,
-                        int          inThumbHeight,
-                        int          inThumbWidth,
-                        int          inLoopStart,
-                        int          inLoopEnd ) {
 
-    MaxiginColor  c;
-    int           thumbPixelCenter;
-    int           v                       =  *inCurrentValue;
-    int           fullRange               =   inMaxValue - inMinValue;
-    int           tenPercent              =   fullRange / 10;
-    int           thumbLeftR;
-    int           thumbRightR;
-    int           centerX;
-    int           staticBarI              =   0;
-    
-    if( tenPercent < 1 ) {
-        tenPercent = 1;
-        }
+static void mx_checkLangNeedsReload( void );
 
-    centerX = ( inStartX + inEndX ) / 2;
+static void mx_reloadLanguagesFromBulkData( const char  *inBulkName );
 
-    if( mx_sliderSpritesSet
-        &&
-        mx_sliderSprites.numFullBars > 0 ) {
 
-        /* find smallest available bar that fits requested span
-           and center it on requested span */
+static void mx_populateMenuPanel( void );
 
-        int  i;
-        int  w             =  inEndX - inStartX;
-        int  smallestBarW  =  30000;
-        int  smallestI     =  -1;
-        int  largestBarW   =   0;
-        int  largestBarI   =  -1;
-        
-        for( i = 0;
-             i < mx_sliderSprites.numFullBars;
-             i ++ ) {
+static void mx_pauseAllPlayingSoundEffects( void );
 
-            int  barW  =
-                   mx_sprites[ mx_sliderSprites.fullBars[i] ].rightVisibleRadius
-                   +
-                   mx_sprites[ mx_sliderSprites.fullBars[i] ].leftVisibleRadius;
+static void mx_unpauseAllPlayingSoundEffects( void );
 
-            if( barW >= w
-                &&
-                barW < smallestBarW ) {
 
-                smallestBarW = barW;
-                smallestI    = i;
-                }
 
-            if( barW > largestBarW ) {
-                largestBarW = barW;
-                largestBarI = i;
-                }
-            }
+static void mx_updateLoopPoints( void );
 
-        if( smallestI == -1 ) {
-            /* no bar big enough */
-            
-            /* just pick largest bar in this case */
-            smallestI    = largestBarI;
-            }
+static void mx_loadLoopPoints( void );
 
-        staticBarI = smallestI;
-        i          = smallestI;
 
-        inStartX =
-            centerX -
-            mx_sprites[ mx_sliderSprites.fullBars[i] ].leftVisibleRadius;
-        
-        inEndX =
-            centerX +
-            mx_sprites[ mx_sliderSprites.fullBars[i] ].rightVisibleRadius;
-        }
-    
-    
-    c.comp.red   = 255;
-    c.comp.green = 255;
-    c.comp.blue  = 255;
-    c.comp.alpha = 255;
-    
-    thumbPixelCenter =
-        ( ( v - inMinValue ) *
-          ( inEndX - inStartX ) )
-        / ( inMaxValue - inMinValue )
-        + inStartX;
-    
-    mx_getSliderThumbRadius( inThumbWidth,
-                             &thumbLeftR,
-                             &thumbRightR );
 
-    if( inGUI->active == inCurrentValue ) {
-        /* previously manipulated with mouse */
+void minginGame_step( char  inFinalStep ) {
 
-        if( ! mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON ) ) {
+    char  playbackPausedBySlider  =  0;
+    char  playbackStepped         =  0;
+    
+    if( ! mx_initDone ) {
+        if( inFinalStep ) {
+            /* ended before we even got to init, do nothing */
+            return;
+            }
+        
+        mx_gameInit();
+        mx_initDone = 1;
+        }
 
-            inGUI->active = 0;
-            }  
+    if( mx_verifyPlaybackMode ) {
+        /* headless tool mode
+           verify and quit on first step, without saving game */
+        if( ! inFinalStep ) {
+            maxigin_writeIntSetting( "maxigin_verifyPlaybackResult.ini",
+                                     mx_verifyPlayback() );
+            mingin_quit();
+            }
+        return;
         }
+
+#if MAXIGIN_ENABLE_FRAME_PROFILER
+    mx_startProfileFrame();
+#endif
     
 
-    if( inGUI->active == 0 ) {
-        /* no other component active */
+    /* handle both case where platform forced us to end and
+       where user decided to quit */
+    if( inFinalStep ) {
 
-        char avail;
-        int  x       =  0;
-        int  y       =  0;
-            
-        avail = maxigin_getPointerLocation( &x,
-                                            &y );
+        mingin_log( "Forced to quit by platform\n" );
 
-        x -= inGUI->zeroOffsetX;
-        y -= inGUI->zeroOffsetY;
+        /* quit immediately, since this is our last step
+           we can't wait for music to fade out nicely, etc. */
+        mx_quitting  = 1;
+        mx_quittingReady = 1;
+        }
 
-        if( avail ) {
-            char  over  =  0;
+    if( ! mx_quitting
+        &&
+        mingin_isButtonDown( QUIT ) ) {
 
-            if( y >= inY - inThumbHeight / 2
-                &&
-                y <= inY + inThumbHeight / 2 ) {
-                
-                if( x >= inStartX
-                    &&
-                    x <= inEndX ) {
+        mingin_log( "Got quit key, starting sound fade out\n" );
+        
+        mx_quitting      = 1;
+        mx_quittingReady = 0;
+        }
 
-                    over = 1;
-                    }
-                else {
-                    /* mouse is not over horizontal extent of bar
-                       check if mouse over thumb, which might stick
-                       off the end of bar */
-                    if( x >= thumbPixelCenter - thumbLeftR
-                        &&
-                        x <= thumbPixelCenter + thumbRightR ) {
-                        
-                        over = 1;
-                        }
-                    }
-                }
+    if( ! mx_quitting
+        && mx_enableAutoQuit ) {
+        
+        mx_quitting = maxigin_readFlagSetting( "maxigin_autoQuit.ini",
+                                               0 );
 
-            if( over ) {
-                
-                /* mouse over slider */
+        if( mx_quitting ) {
+            mingin_log( "Found auto-quit in persistent data settings\n" );
 
-                if( ! inGUI->mouseDown ) {
-                    /* mouse hovering, unpressed */
-                    
-                    inGUI->hot = inCurrentValue;
-                    }
-                }
-            else if( inGUI->hot == inCurrentValue ) {
-                /* mouse was over slider, but has moved out */
-                inGUI->hot = 0;
-                }
+            /* We normally wait for sound/music to fade out nicely when quitting
+               to avoid a pop, but in case of hot-reload, speed things up
+               by skipping fade-out */
+            mx_quittingReady = 1;
             }
+        }
 
-        if( inGUI->hot == inCurrentValue ) {
-            /* mouse over slider */
-            if( ! inGUI->mouseDown
-                &&
-                mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON ) ) {
-                
-                /* mouse newly pressed on slider */
-                
-                inGUI->active    = inCurrentValue;
-                inGUI->mouseDown = 1;
+    if( mx_quitting
+        &&
+        ! mx_quittingReady ) {
 
-                /* is mouse over thumb? */
+        /* wait for sound to be done fading out */
+        if( mx_stepSoundFadeOut() ) {
+            mx_quittingReady = 1;
+            }
+        }
 
-                if( x <= thumbPixelCenter + thumbRightR
-                    &&
-                    /* extra bit seems to help on left side */
-                    x >= thumbPixelCenter - thumbLeftR - 1 ) {
+    if( mx_quitting
+        &&
+        mx_quittingReady ) {
+        
+        mx_saveGame();
 
-                    inGUI->activeMouseOffsetX = x - thumbPixelCenter;
-                    }
-                else {
-                    /* thumb should jump to click position */
-                    inGUI->activeMouseOffsetX = 0;
-                    }
+        if( mx_playbackRunning ) {
+            /* in the middle of playing back a recording */
 
-                inGUI->activeMouseOffsetY = 0;
-                }
+            maxigin_writeIntSetting( "maxigin_resumePlayback.ini",
+                                     1 );
+            maxigin_writeIntSetting( "maxigin_resumePlaybackPos.ini",
+                                     mx_playbackCurrentStep );
+
+            maxigin_writeIntSetting( "maxigin_resumePlaybackSpeed.ini",
+                                     mx_playbackSpeed );
+            maxigin_writeIntSetting( "maxigin_resumePlaybackDirection.ini",
+                                     mx_playbackDirection );
+            maxigin_writeIntSetting( "maxigin_resumePlaybackPaused.ini",
+                                     mx_playbackPaused );
             }
-        }
-    
+        else {
+            maxigin_writeIntSetting( "maxigin_resumePlayback.ini",
+                                     0 );
+            }
+        
+        mx_finalizeRecording();
+
+        mx_stopPlayingMusic();
+
+        if( mx_enableAutoQuit ) {
+            maxigin_writeIntSetting( "maxigin_autoQuitDone.ini",
+                                     1 );
+            }
+        
+        mingin_quit();
 
-    if( inGUI->active == inCurrentValue ) {
-        /* mouse controlling slider */
+        return;
+        }
 
-        char avail;
-        int  x       =  0;
-        int  y       =  0;
-            
-        avail = maxigin_getPointerLocation( &x,
-                                            &y );
 
-        x -= inGUI->zeroOffsetX;
-        y -= inGUI->zeroOffsetY;
+    if( mx_isActionFreshPressed( MENU ) ) {
 
-        if( avail ) {
+        if( ! mx_menuShowing
+            ||
+            ( mx_menuShowing
+              &&
+              ! mx_blockMenuClose ) ) {
 
-            x -= inGUI->activeMouseOffsetX;
-            y -= inGUI->activeMouseOffsetY;
+            char menuWasShowing = mx_menuShowing;
 
-            thumbPixelCenter = x;
+            if( menuWasShowing ) {
+                /* play thte do sound BEFORE closing the menu,
+                   so it won't be included in recording */
+                if( mx_menuDoSound != -1 ) {
             
-            if( x < inStartX ) {
-                v = inMinValue;
-                thumbPixelCenter = inStartX;
-                }
-            else if( x > inEndX ) {
-                v = inMaxValue;
-                thumbPixelCenter = inEndX;
-                }
-            else {
-                /* in between min and max */
-
-                if( ( inEndX - inStartX )
-                    <=
-                    2 * ( inMaxValue - inMinValue ) ) {
-                    
-                    /* lots of values per pixel */
-                    v = ( x - inStartX ) * ( inMaxValue - inMinValue )
-                        /
-                        ( inEndX - inStartX )
-                        + inMinValue;
-
-                    /* tweak v so that when mouse released, slider
-                       doesn't jump weirdly */
-                    v += 1;
+                    maxigin_playSoundEffect( mx_menuDoSound,
+                                             mx_menuDoLoudness );
                     }
-                else {
-                    /* not very many values per pixel of slider */
-
-                    /* snap to closest value */
+                }
+            
+            mx_menuShowing = ! mx_menuShowing;
 
-                    int  numBins       =  inMaxValue - inMinValue;
-                    int  binSize       =  ( inEndX - inStartX ) / numBins;
-                    int  startBinSize  =  binSize /  2;
-                    int  xOffset       =  x - inStartX;
+            if( ! menuWasShowing ) {
 
-                    v = ( xOffset + startBinSize ) / binSize;
+                /* recording paused during menu, don't want all
+                   active sound effects to pile up their ending events
+                   in one frame */
+                
+                mx_pauseAllPlayingSoundEffects();
+                
+                /* play thte do sound AFTER we start opening the menu,
+                   so it won't be included in recording */
+                if( mx_menuDoSound != -1 ) {
+            
+                    maxigin_playSoundEffect( mx_menuDoSound,
+                                             mx_menuDoLoudness );
                     }
+                }
+            else {
+                /* menu just closed, unpause in-process sound effects
+                   that were playing when menu was opened, allowing
+                   their ending events to get recorded properly */
                 
+                mx_unpauseAllPlayingSoundEffects();
+                }
+            
 
-                if( v > inMaxValue ) {
-                    v = inMaxValue;
-                    }
-                else if( v < inMinValue ) {
-                    v = inMinValue;
-                    }
+            /* end playback when menu opened */
+            if( mx_menuShowing
+                &&
+                mx_playbackRunning ) {
+                mx_playbackEnd();
+                mx_initRecording();
+                mx_playbackInterruptedRecording = 0;
                 }
-            } 
+        
+            
+            }
         }
     
     
 
-    if( inGUI->forceHot == inCurrentValue ) {
+    maxigin_startGUI( &mx_internalGUI );
 
-        /* we're in force moving mode, which means the game has this slider
-           active or selected, currently */
-        
-        /* listen to controller sticks, arrow keys, etc */
+    if( mx_isActionFreshPressed( FULLSCREEN_TOGGLE ) ) {
+        mingin_toggleFullscreen( ! mingin_isFullscreen() );
+        }
 
-        if( mx_isActionFreshPressed( MAXIGIN_SLIDER_DECREASE ) ) {
+    if( mx_isActionFreshPressed( CRT_TOGGLE ) ) {
+        mx_crtOverlayOn = ! mx_crtOverlayOn;
+        }
 
-            v -= tenPercent;
-            }
-        else if( mx_isActionFreshPressed( MAXIGIN_SLIDER_INCREASE ) ) {
+    if( mx_isActionFreshPressed( LANG_SWITCH ) ) {
+        mx_nextLang();
+        }
 
-            v += tenPercent;
-            }
-        else {
+    if( mx_isActionFreshPressed( MAXIGIN_HIDE_GUI ) ) {
+        mx_hideGUI = ! mx_hideGUI;
+        }
 
-            /* move slider with sticks, potentially  */
+#if MAXIGIN_ENABLE_FRAME_PROFILER
+    if( mx_isActionFreshPressed( MAXIGIN_PROFILER_TOGGLE ) ) {
+        mx_profilerOverlayOn = ! mx_profilerOverlayOn;
+        }
 
-            /* leaving these uninitialized generates
-               a warning in some compilers */
-            int  pos    =  0;
-            int  lower  =  0;
-            int  upper  =  0;
-            
-            if( mingin_getStickPosition( MAXIGIN_STICK_SLIDER,
-                                         &pos,
-                                         &lower,
-                                         &upper ) ) {
-                /* stick available */
+    if( mx_isActionFreshPressed( MAXIGIN_PROFILER_EXPORT ) ) {
+        mx_exportProfileTrace();
+        }
+#endif
 
-                int  range           =  ( upper - lower );
-                int  half            =  range / 2;
-                int  mid             =  half + lower;
-                int  dead            =  range / 10;
-                int  stepsPerSecond  =  mingin_getStepsPerSecond();
-                int  jump            =  0;
 
+    if( mx_playbackRunning
+        &&
+        mx_isActionFreshPressed( MAXIGIN_ADD_LOOP_POINT ) ) {
 
-                if( dead == 0 ) {
-                    dead = 1;
-                    }
-                
-                /* baseline:
-                   on a 0-100 slider at 60 fps, we should
-                   move 1 step per frame if stick partway pressed
-                   and 2 steps per frame if stick all the way pressed.
+        int  curDataPos  =
+               mingin_getPersistDataPosition( mx_playbackDataStoreHandle );
 
-                   For longer sliders, we should move faster.
+        if( curDataPos != -1 ) {
 
-                   On platforms with slower frame rates, we should move
-                   faster.
-                */
+            if( ! mx_playbackPaused ) {
                 
-                if( pos > mid + dead ) {
+                if( mx_playbackDirection == 1 ) {
+                    
+                    mx_loopPointHandles[ 1 ] = curDataPos;
+                    mx_loopPointSteps  [ 1 ] = mx_playbackCurrentStep;
 
-                    jump = 1;
+                    if( mx_loopPointHandles[ 0 ] == -1 ) {
+                    
+                        mx_loopPointHandles[ 0 ] = 0;
+                        mx_loopPointSteps  [ 0 ] = 0;
+                        }
+                    mx_updateLoopPoints();
+                    }
+                else if( mx_playbackDirection == -1 ) {
+                    mx_loopPointHandles[ 0 ] = curDataPos;
+                    mx_loopPointSteps  [ 0 ] = mx_playbackCurrentStep;
 
-                    if( pos > upper - dead ) {
-                        jump = 2;
+                    if( mx_loopPointHandles[ 1 ] == -1 ) {
+                    
+                        mx_loopPointHandles[ 1 ] = mx_playbackDataLength;
+                        mx_loopPointSteps  [ 1 ] = mx_playbackTotalSteps;
                         }
+                    mx_updateLoopPoints();
                     }
-                else if( pos < mid - dead ) {
+                }
+            else {
+                /* paused, player might move head with mouse
+                   and we let them set whichever loop point isn't set yet */
 
-                    jump = -1;
+                if( mx_loopPointHandles[ 0 ] == -1
+                    ||
+                    mx_loopPointHandles[ 0 ] == 0 ) {
+                    
+                    mx_loopPointHandles[ 0 ] = curDataPos;
+                    mx_loopPointSteps  [ 0 ] = mx_playbackCurrentStep;
 
-                    if( pos < lower + dead ) {
-                        jump = -2;
+                    if( mx_loopPointHandles[ 1 ] == -1 ) {
+                        mx_loopPointHandles[ 1 ] = mx_playbackDataLength;
+                        mx_loopPointSteps  [ 1 ] = mx_playbackTotalSteps;
+                        }
+                    mx_updateLoopPoints();
+                    }
+                else if( mx_loopPointHandles[ 1 ] == -1
+                         ||
+                         mx_loopPointHandles[ 1 ] == mx_playbackDataLength ) {
+                    
+                    mx_loopPointHandles[ 1 ] = curDataPos;
+                    mx_loopPointSteps  [ 1] = mx_playbackCurrentStep;
+                    mx_updateLoopPoints();
+                    }
+                else {
+                    /* loop points set... are we before first one
+                       or after second one ?
+                     */
+
+                    if( mx_playbackCurrentStep < mx_loopPointSteps  [ 0 ] ) {
+                        mx_loopPointHandles[ 0 ] = curDataPos;
+                        mx_loopPointSteps  [ 0 ] = mx_playbackCurrentStep;
+                        mx_updateLoopPoints();
+                        }
+                    else if( mx_playbackCurrentStep >
+                             mx_loopPointSteps  [ 1 ] ) {
+                        mx_loopPointHandles[ 1 ] = curDataPos;
+                        mx_loopPointSteps  [ 1 ] = mx_playbackCurrentStep;
+                        }
+                    else if( mx_playbackCurrentStep == mx_loopPointSteps[ 0 ]
+                             ||
+                             mx_playbackCurrentStep == mx_loopPointSteps[ 1 ] ) {
+                        /* on an existing point, do nothing */
+                        }
+                    else {
+                        /* we're between loop points...
+                           adjust whichever is closest to us
+                        */
+
+                        int  diff0  =  mx_playbackCurrentStep -
+                                       mx_loopPointSteps[ 0 ];
+                        int  diff1  =  mx_loopPointSteps[ 1 ] -
+                                       mx_playbackCurrentStep;
+
+                        if( diff0 <= diff1 ) {
+                            mx_loopPointHandles[ 0 ] = curDataPos;
+                            mx_loopPointSteps  [ 0 ] = mx_playbackCurrentStep;
+                            }
+                        else {
+                            mx_loopPointHandles[ 1 ] = curDataPos;
+                            mx_loopPointSteps  [ 1 ] = mx_playbackCurrentStep;
+                            }
+                        mx_updateLoopPoints();
                         }
                     }
-
-                if( stepsPerSecond < 60 ) {
-                    /* bigger jumps if fps lower */
-                    jump = ( jump * 60 ) / stepsPerSecond;
-                    }
-                if( fullRange > 100 ) {
-                    jump = ( jump * fullRange ) / 100;
-                    }
-                
-                v += jump;
                 }
             }
-        if( v < inMinValue ) {
-            v = inMinValue;
-            }
-        if( v > inMaxValue ) {
-            v = inMaxValue;
-            }
         }
 
-    
-    *inCurrentValue = v;
+    if( mx_playbackRunning
+        &&
+        mx_isActionFreshPressed( MAXIGIN_CLEAR_LOOP_POINTS ) ) {
 
-    if( ( inEndX - inStartX )
-        >
-        2 * ( inMaxValue - inMinValue ) ) {
+        int  p;
 
-        /* bar has way more pixels than legal values
-           thumb should snap to legal values */
-        
-        thumbPixelCenter =
-            ( ( v - inMinValue ) *
-              ( inEndX - inStartX ) )
-            / ( inMaxValue - inMinValue )
-            + inStartX;
+        for( p = 0;
+             p < 2;
+             p ++ ) {
+
+            mx_loopPointHandles[ p ] = -1;
+            mx_loopPointSteps  [ p ] = -1;
+            }
+        mx_updateLoopPoints();
         }
-    /* else bar has enough resolution, thumb should move
-       smoothly with mouse and then snap to actual value when dropped */
     
-
-
-    /* now draw slider */
-
     
-    if( mx_sliderSpritesSet ) {
-        /* use sprites  */
-
-        int  thumbHandle;
-
+    if( ! mx_menuShowing
+        &&
+        mx_isActionFreshPressed( PLAYBACK_START_STOP ) ) {
+        
+        mx_playbackInstantReverseRecording = 0;
+        
+        if( mx_playbackRunning ) {
+            mx_playbackEnd();
+            mx_initRecording();
+            mx_playbackInterruptedRecording = 0;
+            }
+        else {
+            if( mx_recordingRunning ) {
+                mx_finalizeRecording();
+                mx_playbackInterruptedRecording = 1;
+                }
+            mx_initPlayback();
+            }
+        }
 
-        if( mx_sliderSprites.numFullBars == 0 ) {
-            /* dynamically-sized bar */
+    if( ! mx_menuShowing
+        &&
+        mx_playbackRunning ) {
 
-                    
-            int  leftEndHandle;
-            int  rightEndHandle;
+        int   oldPlaybackFrame;
+        int   newPlaybackFrame;
+        char  playbackSliderActive;
+        int   oldSpeed               =  mx_playbackSpeed;
+        int   oldDir                 =  mx_playbackDirection;
+        char  oldPaused              =  mx_playbackPaused;
         
-            if( v > inMinValue ) {
-                leftEndHandle = mx_sliderSprites.left[1];
+        if( mx_isActionFreshPressed( PLAYBACK_PAUSE ) ) {
+            mx_playbackPaused = ! mx_playbackPaused;
+            }
+        if( mx_isActionFreshPressed( PLAYBACK_NORMAL ) ) {
+            mx_playbackPaused = 0;
+            mx_playbackSpeed = 1;
+            mx_playbackDirection = 1;
+            }
+        if( mx_isActionFreshPressed( PLAYBACK_REVERSE ) ) {
+            mx_playbackPaused = 0;
+            if( mx_playbackDirection == 1 ) {
+                mx_playbackDirection = -1;
                 }
             else {
-                /* completely empty, show empty left end */
-                leftEndHandle = mx_sliderSprites.left[0];
+                mx_playbackDirection = 1;
                 }
-
-        
-            mx_guiAddSprite( inGUI,
-                             0,
-                             255,
-                             leftEndHandle,
-                             inStartX,
-                             inY );
-
-            if( thumbPixelCenter > inStartX ) {
-                /* full bar to left of thumb */
-
-                int  consumedWidth   =  0;
-                int  barSprite       =  mx_sliderSprites.bar[1];
-                int  barSpriteLeftR  =
-                         mx_sprites[ barSprite ].leftVisibleRadius;
-            
-                int  barSpriteW      =  barSpriteLeftR +
-                         mx_sprites[ barSprite ].rightVisibleRadius;
-            
-                int  numBars         =
-                         ( thumbPixelCenter - inStartX ) / barSpriteW;
-
-            
-                if( numBars > 0 ) {
-                    consumedWidth = numBars * barSpriteW;
-                
-                    mx_guiAddSpriteSequence( inGUI,
-                                             0,
-                                             255,
-                                             mx_sliderSprites.bar[1],
-                                             inStartX + barSpriteLeftR,
-                                             inY,
-                                             barSpriteW,
-                                             0,
-                                             numBars );
-                    }
-
-                if( consumedWidth < ( thumbPixelCenter - inStartX ) ) {
-
-                    /* fill rest with slivers */
-                    mx_guiAddSpriteSequence( inGUI,
-                                             0,
-                                             255,
-                                             mx_sliderSprites.sliver[1],
-                                             inStartX + consumedWidth,
-                                             inY,
-                                             1,
-                                             0,
-                                             thumbPixelCenter - inStartX
-                                             - consumedWidth );
-                    }
+            }
+        if( mx_isActionFreshPressed( PLAYBACK_JUMP_HALF_AHEAD ) ) {
+            mx_playbackJumpHalfAhead();
+            }
+        if( mx_isActionFreshPressed( PLAYBACK_JUMP_HALF_BACK ) ) {
+            mx_playbackJumpHalfBack();
+            }
+                        
+        if( mx_isActionFreshPressed( PLAYBACK_FASTER ) ) {
+            if( mx_playbackPaused ) {
+                /* faster button jumps ahead by one step when paused */
+                mx_playbackStep();
                 }
-
-            if( thumbPixelCenter < inEndX ) {
-                /* empty bar to right of thumb */
-            
-                int  consumedWidth   =  0;
-                int  barSprite       =  mx_sliderSprites.bar[0];
-                int  barSpriteLeftR  =
-                         mx_sprites[ barSprite ].leftVisibleRadius;
-            
-                int  barSpriteW      =  barSpriteLeftR +
-                    mx_sprites[ barSprite ].rightVisibleRadius;
-            
-                int  numBars         =
-                        ( inEndX - thumbPixelCenter ) / barSpriteW;
-
+            else {
+                /* not paused, faster adjusts speed */
             
-                if( numBars > 0 ) {
-                    consumedWidth = numBars * barSpriteW;
-                
-                    mx_guiAddSpriteSequence( inGUI,
-                                             0,
-                                             255,
-                                             mx_sliderSprites.bar[0],
-                                             thumbPixelCenter + barSpriteLeftR,
-                                             inY,
-                                             barSpriteW,
-                                             0,
-                                             numBars );
+                if( mx_playbackSpeed >= 1 ) {
+                    mx_playbackSpeed ++;
                     }
-            
-                if( consumedWidth < ( inEndX - thumbPixelCenter ) ) {
-
-                    /* fill rest with slivers */
-                    mx_guiAddSpriteSequence( inGUI,
-                                             0,
-                                             255,
-                                             mx_sliderSprites.sliver[0],
-                                             thumbPixelCenter + consumedWidth,
-                                             inY,
-                                             1,
-                                             0,
-                                             inEndX - thumbPixelCenter
-                                             - consumedWidth );
+                else if( mx_playbackSpeed == -2 ) {
+                    /* coming out of half-speed mode */
+                    mx_playbackSpeed = 1;
+                    }
+                else if( mx_playbackSpeed <= -4 ) {
+                    /* in slow down mode, get 2x faster per step
+                       to get out of it */
+                    
+                    mx_playbackSpeed /= 2;
                     }
                 }
-        
-
-            if( v < inMaxValue ) {
-                rightEndHandle = mx_sliderSprites.right[0];
+            }
+        if( mx_isActionFreshPressed( PLAYBACK_SLOWER ) ) {
+            if( mx_playbackSpeed > 1 ) {
+                mx_playbackSpeed--;
                 }
-            else {
-                /* completely fully, show full right end */
-                rightEndHandle = mx_sliderSprites.right[1];
+            else if( mx_playbackSpeed == 1 ) {
+                mx_playbackSpeed = -2;
+                }
+            else if( mx_playbackSpeed < 0 ) {
+                /* twice as slow */
+                mx_playbackSpeed *= 2;
                 }
-
-        
-            mx_guiAddSprite( inGUI,
-                             0,
-                             255,
-                             rightEndHandle,
-                             inEndX,
-                             inY );
             }
-        else {
-            /* statically sized bar */
 
-            int  barHandle  =
-                mx_sliderSprites.fullBars[ staticBarI ];
+        if( oldSpeed  != mx_playbackSpeed
+            ||
+            oldDir    != mx_playbackDirection
+            ||
+            oldPaused != mx_playbackPaused ) {
+
+            int  setSpeed  =  mx_playbackSpeed;
 
-            mx_guiAddSprite( inGUI,
-                             0,
-                             255,
-                             barHandle,
-                             centerX,
-                             inY );
+            if( mx_playbackPaused ) {
+                setSpeed = 0;
+                }
+            
+            mx_setSoundSpeedAndDirection( setSpeed,
+                                          mx_playbackDirection );
             }
 
-        
-
-        if( inLoopStart >= inMinValue ) {
 
-            int loopPixCenter =
-                ( ( inLoopStart - inMinValue ) *
-                  ( inEndX - inStartX ) )
-                / ( inMaxValue - inMinValue )
-                + inStartX;
+        oldPlaybackFrame = mx_playbackCurrentStep;
 
-            mx_guiAddSprite( inGUI,
-                             0,
-                             255,
-                             mx_sliderSprites.loop[0],
-                             loopPixCenter,
-                             inY );
-            }
+        newPlaybackFrame = oldPlaybackFrame;
 
-        if( inLoopEnd >= inMinValue ) {
+        playbackSliderActive =
+            maxigin_guiSlider( &mx_internalGUI,
+                               &newPlaybackFrame,
+                               0,
+                               mx_playbackTotalSteps - 1,
+                               -( MAXIGIN_GAME_NATIVE_W / 2 - 20 ),
+                               MAXIGIN_GAME_NATIVE_W / 2 - 20,
+                               MAXIGIN_GAME_NATIVE_H / 2 - 30,
+                               10,
+                               20,
+                               10,
+                               mx_loopPointSteps[ 0 ],
+                               mx_loopPointSteps[ 1 ] );
 
-            int loopPixCenter =
-                ( ( inLoopEnd - inMinValue ) *
-                  ( inEndX - inStartX ) )
-                / ( inMaxValue - inMinValue )
-                + inStartX;
+        if( ! mx_playbackPaused
+            &&
+            playbackSliderActive ) {
+            
+            /* temporarily pause playback while slider moving */
+            
+            mx_playbackPaused = 1;
+            playbackPausedBySlider = 1;
+            mx_playbackSliderActive = 1;
 
-            mx_guiAddSprite( inGUI,
-                             0,
-                             255,
-                             mx_sliderSprites.loop[1],
-                             loopPixCenter,
-                             inY );
+            /* pause sound while slider moving */
+            mx_setSoundSpeedAndDirection( 0,
+                                          mx_playbackDirection );
             }
         
 
-        /* thumb drawn the same for both static and dynamic bars */
+        if( mx_playbackSliderActive
+            &&
+            ! playbackSliderActive ) {
+            /* slider was active before, not active now */
 
-        if( inGUI->active   == inCurrentValue
-            ||
-            inGUI->forceHot == inCurrentValue ) {
+            /* unpause sound if necessary */
+            int  setSpeed  =  mx_playbackSpeed;
+
+            if( mx_playbackPaused ) {
+                setSpeed = 0;
+                }
             
-            thumbHandle = mx_sliderSprites.thumb[2];
-            }
-        else if( inGUI->hot == inCurrentValue ) {
-            thumbHandle = mx_sliderSprites.thumb[1];
-            }
-        else {
-            thumbHandle = mx_sliderSprites.thumb[0];
+            mx_setSoundSpeedAndDirection( setSpeed,
+                                          mx_playbackDirection );
+
+            mx_playbackSliderActive = 0;
             }
+        
 
-        mx_guiAddSprite( inGUI,
-                         0,
-                         255,
-                         thumbHandle,
-                         thumbPixelCenter,
-                         inY );
+        if( oldPlaybackFrame != newPlaybackFrame ) {
+            /* slider caused a change */
+
+            mx_playbackJumpToStep( newPlaybackFrame );
+            }
         }
-    else {
-        /* no sprites set, draw directly with geometry  */
+    else if( ! mx_menuShowing ) {
+        /* playback not running
+           watch for "reverse playback button"
+           to insta-rewind the current live game from this point back */
 
+        if( mx_isActionFreshPressed( PLAYBACK_REVERSE ) ) {
+            
+            
+            if( mx_recordingRunning ) {
+                
+                char  success  =  0;
+                
+                /* end the recording, copy the recording file into the
+                   playback file, and then start playback from there */
+                
+                mx_finalizeRecording();
+                mx_playbackInterruptedRecording = 1;
+                mx_playbackInstantReverseRecording = 1;
 
-        /* bar */
-        mx_makeColorGray( &c,
-                          128 );
-    
-        mx_guiAddFillRect( inGUI,
-                           0,
-                           &c,
-                           inStartX,
-                           inY - inBarHeight / 2,
-                           inEndX,
-                           inY + inBarHeight / 2 );
+                if( mingin_renamePersistData( mx_recordingDataStoreName,
+                                              mx_playbackDataStoreName ) ) {
+                    mingin_log( "Moved recording file into playback file "
+                                "for instant playback.\n" );
+                    success = 1;
+                    }
+                else {
+                    /* simple/quick rename failed, try copying data
+                       between files */
+                    int   recordingLength;
+                    int   recordingHandle;
+                    int   playbackHandle;
 
-        mx_makeColorGray( &c,
-                          255 );
-    
-        mx_guiAddDrawRect( inGUI,
-                           0,
-                           &c,
-                           inStartX,
-                           inY - inBarHeight / 2,
-                           inEndX,
-                           inY + inBarHeight / 2 );
+                    mingin_log( "Moving recording file failed, trying "
+                                "data copy into playback file instead.\n" );
+                    
+                    recordingHandle =
+                        mingin_startReadPersistData( mx_recordingDataStoreName,
+                                                     &recordingLength );
 
-        
-        if( inLoopStart >= inMinValue ) {
+                    if( recordingHandle != -1 ) {
 
-            int loopPixCenter =
-                ( ( inLoopStart - inMinValue ) *
-                  ( inEndX - inStartX ) )
-                / ( inMaxValue - inMinValue )
-                + inStartX;
+                        playbackHandle =
+                            mingin_startWritePersistData(
+                                mx_playbackDataStoreName );
 
-            c.comp.red = 0;
-            c.comp.green = 255;
-            c.comp.blue = 0;
-            c.comp.alpha = 255;
+                        if( playbackHandle != -1 ) {
 
-            mx_guiAddLine( inGUI,
-                           0,
-                           &c,
-                           loopPixCenter,
-                           inY - inThumbHeight,
-                           loopPixCenter,
-                           inY + inThumbHeight );
-            }
+                            success = mx_copyIntoDataStore( recordingHandle,
+                                                            playbackHandle,
+                                                            recordingLength );
+                        
+                            if( ! mingin_endWritePersistData(
+                                    playbackHandle ) ) {
+                                success = 0;
+                                }
+                            }
+                        
+                        mingin_endReadPersistData( recordingHandle );
 
-        if( inLoopEnd >= inMinValue ) {
+                        if( success ) {
+                            mingin_log(
+                                "Copied recording file data into playback file "
+                                "for instant playback.\n" );
+                            
+                            mingin_deletePersistData(
+                                mx_recordingDataStoreName );
+                            }
+                        }
+                    }
+                
+                if( success ) {
+                    
+                    /* we block sound triggers here
+                       because we are initing playback from the first
+                       recorded frame and then
 
-            int loopPixCenter =
-                ( ( inLoopEnd - inMinValue ) *
-                  ( inEndX - inStartX ) )
-                / ( inMaxValue - inMinValue )
-                + inStartX;
+                       fast-stepping forward to the
+                       last step, and then instant-reversing from there
+                       we don't want recorded sounds to trigger when
+                       we do this init or fast-stepping */
+                    mx_playbackBlockForwardSounds = 1;
+                    
+                    mx_initPlayback();
 
-            c.comp.red = 255;
-            c.comp.green = 0;
-            c.comp.blue = 0;
-            c.comp.alpha = 255;
+                    /* jump to last step */
+                    mx_playbackJumpToStep( mx_playbackTotalSteps - 1 );
 
-            mx_guiAddLine( inGUI,
-                           0,
-                           &c,
-                           loopPixCenter,
-                           inY - inThumbHeight,
-                           loopPixCenter,
-                           inY + inThumbHeight );
-            }
+                    mx_playbackBlockForwardSounds = 0;
 
-        /* thumb */
+                    
+                    mx_playbackDirection = -1;
+                    mx_playbackSpeed     = 1;
+
+                    mx_setSoundSpeedAndDirection( mx_playbackSpeed,
+                                                  mx_playbackDirection );
+                    }
+                else {
+                    /* playback failed for some reason */
 
+                    mingin_log( "Instant-reverse playback mid-game failed\n" );
 
-        /* shadow */
-        mx_makeColorGray( &c,
-                          64 );
+                    /* start recording again */
+                    
+                    mx_initRecording();
+                    }
+                }
+            }
+        }
 
-        c.comp.alpha = 128;
     
-        mx_guiAddFillRect( inGUI,
-                           0,
-                           &c,
-                           thumbPixelCenter - inThumbWidth / 2 - 2,
-                           inY - inBarHeight / 2,
-                           thumbPixelCenter + inThumbWidth / 2 + 2,
-                           inY + inBarHeight / 2 );
 
-        c.comp.alpha = 255;
-    
-        if( inGUI->active   == inCurrentValue
-            ||
-            inGUI->forceHot == inCurrentValue ) {
+    if( mingin_getBulkDataChangeNotificationsSupported() ) {
+        /* platform tells us what changed, only reload those */
+        const char  *changedName;
+
+        changedName = mingin_getNextChangedBulkData();
+        
+        while( changedName != 0 ) {
             
-            /* darker when moving */
-            mx_makeColorGray( &c,
-                              64 );
+            if( ! mx_spriteCacheLoaded ) {
+                mx_reloadSpritesFromBulkData( changedName );
+                }
+            
+            mx_reloadLanguagesFromBulkData( changedName );
+            
+            changedName = mingin_getNextChangedBulkData();
             }
-        else if( inGUI->hot == inCurrentValue ) {
-            /* brighter when hot */
-            mx_makeColorGray( &c,
-                              192 );
+        
+        if( ! mx_spriteCacheLoaded ) {
+            /* retry any that failed to reload */
+            mx_checkSpritesNeedReload( 0 );
             }
-        else {        
-            mx_makeColorGray( &c,
-                              128 );
+        }
+    else {
+        if( ! mx_spriteCacheLoaded ) {
+            /* have no last-modified times if sprites loaded from cache */
+            mx_checkSpritesNeedReload( 1 );
             }
     
-        mx_guiAddFillRect( inGUI,
-                           0,
-                           &c,
-                           thumbPixelCenter - inThumbWidth / 2,
-                           inY - inThumbHeight / 2,
-                           thumbPixelCenter + inThumbWidth / 2,
-                           inY + inThumbHeight / 2 );
-
-        mx_makeColorGray( &c,
-                          255 );
-    
-        mx_guiAddDrawRect( inGUI,
-                           0,
-                           &c,
-                           thumbPixelCenter - inThumbWidth / 2,
-                           inY - inThumbHeight / 2,
-                           thumbPixelCenter + inThumbWidth / 2,
-                           inY + inThumbHeight / 2 );
-
-
-
+        mx_checkLangNeedsReload();
         }
     
+    mx_processDoneSoundEffects();
 
-    /* return 1 if slider is active */
-    return ( inGUI->active == inCurrentValue );
-    }
+    if( ! mx_menuShowing ) {
+        MAXIGIN_PROFILE_ZONE_START( "playback" );
+        playbackStepped = mx_playbackSpeedStep();
+        MAXIGIN_PROFILE_ZONE_END();
+        }
 
+    if( ! mx_menuShowing
+        &&
+        ! playbackStepped ) {
 
+        if( mx_playbackInterruptedRecording ) {
+            /* playback has ended, resume recording */
+            mx_initRecording();
+            mx_playbackInterruptedRecording = 0;
+            mx_playbackInstantReverseRecording = 0;
+            }
+        
+        mx_areWeInMaxiginGameStepFunction = 1;
 
-int maxigin_guiStartPanel( MaxiginGUI    *inGUI,
-                           int            inCenterX,
-                           int            inCenterY,
-                           int            inWidth,
-                           int            inHeight,
-                           unsigned char  inFade ) {
+        MAXIGIN_PROFILE_ZONE_START( "maxiginGame_step" );
+        maxiginGame_step();
+        MAXIGIN_PROFILE_ZONE_END();
+    
+        mx_areWeInMaxiginGameStepFunction = 0;
 
-    int           i  =  inGUI->numDrawComponents;
+        MAXIGIN_PROFILE_ZONE_START( "recording" );
+        mx_stepRecording();
+        MAXIGIN_PROFILE_ZONE_END();
 
-    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
-        mingin_log( "Error:  trying to add a panel to a full "
-                    "MaxiginGUI instance.\n" );
-        return -1;
+        mx_clearJustStartedSoundEffects();
         }
-    
-    inGUI->zeroOffsetX += inCenterX;
-    inGUI->zeroOffsetY += inCenterY;
-
-    inGUI->drawComponents[i].drawType = MX_GUI_SUB_PANEL_START;
-    
-    inGUI->drawComponents[i].drawParams.panelStart.plusX = inCenterX;
-    inGUI->drawComponents[i].drawParams.panelStart.plusY = inCenterY;
 
-    inGUI->drawComponents[i].drawParams.panelStart.oldFade = inGUI->fade;
-        
-    /* compound the fades,
-       so fading subpanels in fading panels get doubly faded */
-    inGUI->fade = (unsigned char)( ( inGUI->fade * inFade ) / 255 );
+    /* if we jumped half-forward or half-back above
+       we set this to 1.
+       But those jumps waited for mx_playbackSpeedStep to actually
+       apply the snapshot after the jump.
+       So we need to leave mx_playbackJumping set until now, so
+       that our music jumps correctly in mx_playbackSpeedStep.
+    */
+    mx_playbackJumping = 0;
 
-    inGUI->drawComponents[i].drawParams.panelStart.newFade = inGUI->fade;
-    
+    if( playbackPausedBySlider ) {
+        /* unpause temporary playback slider pause */
+        mx_playbackPaused = 0;
+        }
     
-    inGUI->numDrawComponents ++;
 
 
-    if( mx_panelSpritesSet ) {
+    if( mx_menuShowing
+        ||
+        mx_menuFade > 0 ) {
 
-        if( mx_panelSprites.numFullPanels > 0 ) {
-            /* statically-sized panels */
+        int            menuPanel;
+        int            fadeStep;
+        int            ySlideInPos;
 
-            int  smallestP  =  -1;
-            int  smallestW  =  30000;
-            
-            int  largestP   =  -1;
-            int  largestW   =   0;
-            int  p;
+        ySlideInPos =
+            - MAXIGIN_GAME_NATIVE_H * ( mx_menuFadeMax - mx_menuFade )
+            / mx_menuFadeMax;
             
-            for( p = 0;
-                 p < mx_panelSprites.numFullPanels;
-                 p ++ ) {
+        menuPanel = maxigin_guiStartPanel( &mx_internalGUI,
+                                           0,
+                                           ySlideInPos,
+                                           MAXIGIN_GAME_NATIVE_W - 20,
+                                           MAXIGIN_GAME_NATIVE_H - 40,
+                                           (unsigned char)( mx_menuFade / 10 ) );
 
-                MaxiginSprite  *s  =
-                    &( mx_sprites[ mx_panelSprites.fullPanels[p] ] );
-                int             w  =  s->leftVisibleRadius +
-                                      s->rightVisibleRadius;
-                int             h  =  s->upperVisibleRadius +
-                                      s->lowerVisibleRadius;
+        mx_populateMenuPanel();
+        
+        maxigin_guiEndPanel( &mx_internalGUI,
+                             menuPanel );
 
-                if( w >= inWidth
-                    &&
-                    w < smallestW
-                    &&
-                    h >= inHeight ) {
-                    smallestP = p;
-                    smallestW = w;
-                    }
-                
-                if( w > largestW ) {
-                    largestP = p;
-                    largestW = w;
-                    }
+        if( mx_menuShowing
+            &&
+            mx_menuFade < mx_menuFadeMax ) {
+            /* Purho easing function, go 20% of remaining distance */
+            fadeStep = ( mx_menuFadeMax - mx_menuFade ) / 5;
+            if( fadeStep < 1 ) {
+                fadeStep = 1;
                 }
+            
+            mx_menuFade += fadeStep;
+            }
+        else if( ! mx_menuShowing
+                 &&
+                 mx_menuFade > 0 ) {
 
-            if( smallestP == -1 ) {
-                /* found no panel that was big enough
-                   use largest one instead */
-                smallestP = largestP;
+            fadeStep = ( mx_menuFadeMax - mx_menuFade ) / 3;
+            if( fadeStep < 30 ) {
+                fadeStep = 30;
                 }
 
-            if( smallestP != -1 ) {
-                
-                mx_guiAddSprite( inGUI,
-                                 0,
-                                 255,
-                                 mx_panelSprites.fullPanels[ smallestP ],
-                                 0,
-                                 0 );
+            if( fadeStep > mx_menuFade ) {
+                mx_menuFade = 0;
+                }
+            else {
+                mx_menuFade -= fadeStep;
                 }
-            }
-        else {
-            /* dynamically-sized panels */
-
-            int             fill          =  mx_panelSprites.fill;
-            MaxiginSprite  *fillS         =  &( mx_sprites[ fill ] );
-            int             fillW         =  fillS->w;
-            int             fillH         =  fillS->h;
-            int             numFillRows;
-            int             numFillCols;
-            int             totalFillW;
-            int             totalFillH;
-            int             fillStartX;
-            int             fillStartY;
-            int             r;
-        
-            numFillCols = inWidth / fillW;
 
-            if( numFillCols * fillW < inWidth ) {
-                /* round up */
-                numFillCols ++;
+            if( mx_menuFade == 0 ) {
+                mx_langPanelShowing     = 0;
+                mx_controlsPanelShowing = 0;
+                mx_menuReturnForceHot   = 0;
+                mx_internalGUI.forceHot = 0;
                 }
-        
-            numFillRows = inHeight / fillH;
+            } 
+        }
+    
+    
+    maxigin_endGUI( &mx_internalGUI );
+    
+    }
+
+
+
+static  MinginButton  mx_quitMapping[] = { MGN_KEY_Q,
+                                           MGN_MAP_END };
+
+static  MinginButton  mx_menuMapping[] = { MGN_KEY_ESCAPE,
+                                           MGN_BUTTON_XBOX_GUIDE,
+                                           MGN_BUTTON_XBOX_START,
+                                           MGN_BUTTON_PS_PS,
+                                           MGN_BUTTON_PS_OPTIONS,
+                                           MGN_MAP_END };
+
+static  MinginButton  mx_menuBackMapping[] = { MGN_BUTTON_XBOX_B,
+                                               MGN_BUTTON_PS_CIRCLE,
+                                               MGN_BUTTON_XBOX_BACK,
+                                               MGN_MAP_END };
+
+static  MinginButton  mx_menuUpMapping[] = { MGN_BUTTON_DPAD_UP,
+                                             MGN_MAP_END };
 
-            if( numFillRows * fillH < inHeight ) {
-                /* round up */
-                numFillRows ++;
-                }
+static  MinginButton  mx_menuDownMapping[] = { MGN_BUTTON_DPAD_DOWN,
+                                               MGN_MAP_END };
 
-            /* add extra rows/columns for edges, which might have transparent
-               pixels and not "fill" in the desired area completely
-               We want to guarantee that opaque fill of panel is at least as
-               big as the requested size */
-            numFillCols += 2;
-            numFillRows += 2;
+static  MinginStick  mx_menuStickNavMapping[] = { MGN_STICK_LEFT_Y,
+                                                  MGN_STICK_RIGHT_Y,
+                                                  MGN_MAP_END };
 
-            totalFillW = numFillCols * fillW;
-            totalFillH = numFillRows * fillH;
+static  MinginButton  mx_menuPickMapping[] = { MGN_BUTTON_XBOX_A,
+                                               MGN_BUTTON_XBOX_X,
+                                               MGN_BUTTON_XBOX_Y,
+                                               MGN_BUTTON_L1,
+                                               MGN_BUTTON_R1,
+                                               MGN_BUTTON_L2,
+                                               MGN_BUTTON_R2,
+                                               MGN_BUTTON_PS_SQUARE,
+                                               MGN_BUTTON_PS_TRIANGLE,
+                                               MGN_BUTTON_PS_X,
+                                               MGN_MAP_END };
 
-            fillStartX = ( - totalFillW / 2 ) + fillW / 2;
-            fillStartY = ( - totalFillH / 2 ) + fillH / 2;
+static  MinginButton  mx_fullscreenMapping[] = { MGN_KEY_F,
+                                                 MGN_MAP_END };
 
-            for( r = 0;
-                 r < numFillRows;
-                 r ++ ) {
+static  MinginButton  mx_crtMapping[] = { MGN_KEY_C,
+                                          MGN_MAP_END };
 
-                int  rowStartY  =  fillStartY + r * fillH;
-            
-                if( r == 0 ) {
-                    /* tl corner */
-                    mx_guiAddSprite( inGUI,
-                                     0,
-                                     255,
-                                     mx_panelSprites.corners[0],
-                                     fillStartX,
-                                     rowStartY );
-                    }
-                else if( r == numFillRows - 1 ) {
-                    /* bl corner */
-                    mx_guiAddSprite( inGUI,
-                                     0,
-                                     255,
-                                     mx_panelSprites.corners[2],
-                                     fillStartX,
-                                     rowStartY );
-                    }
-                else {
-                    /* left edge */
-                    mx_guiAddSprite( inGUI,
-                                     0,
-                                     255,
-                                     mx_panelSprites.sides[0],
-                                     fillStartX,
-                                     rowStartY );
-                    }
-            
-                if( r == 0 ) {
-                    /* fill with top edge */
+static  MinginButton  mx_langSwitchMapping[] = { MGN_KEY_L,
+                                                 MGN_MAP_END };
 
-                    mx_guiAddSpriteSequence( inGUI,
-                                             0,
-                                             255,
-                                             mx_panelSprites.sides[2],
-                                             fillStartX + fillW,
-                                             fillStartY + r * fillH,
-                                             fillW,
-                                             0,
-                                             numFillCols - 2 );
-                    }
-                else if( r == numFillRows - 1 ) {
-                    /* fill with bottom edge */
+static  MinginButton  mx_mouseButtonMapping[] = { MGN_BUTTON_MOUSE_LEFT,
+                                                  MGN_MAP_END };
 
-                    mx_guiAddSpriteSequence( inGUI,
-                                             0,
-                                             255,
-                                             mx_panelSprites.sides[3],
-                                             fillStartX + fillW,
-                                             fillStartY + r * fillH,
-                                             fillW,
-                                             0,
-                                             numFillCols - 2 );
-                    }
-                else {
-                    /* fill with fill */
-            
-                    mx_guiAddSpriteSequence( inGUI,
-                                             0,
-                                             255,
-                                             fill,
-                                             fillStartX + fillW,
-                                             fillStartY + r * fillH,
-                                             fillW,
-                                             0,
-                                             numFillCols - 2 );
-                    }
+static  MinginButton  mx_sliderIncreaseMapping[] = { MGN_KEY_RIGHT,
+                                                     MGN_BUTTON_DPAD_RIGHT,
+                                                     MGN_MAP_END };
 
+static  MinginButton  mx_sliderDecreaseMapping[] = { MGN_KEY_LEFT,
+                                                     MGN_BUTTON_DPAD_LEFT,
+                                                     MGN_MAP_END };
 
-                if( r == 0 ) {
-                    /* tr corner */
-                    mx_guiAddSprite( inGUI,
-                                     0,
-                                     255,
-                                     mx_panelSprites.corners[1],
-                                     fillStartX + fillW * ( numFillCols - 1 ),
-                                     rowStartY );
-                    }
-                else if( r == numFillRows - 1 ) {
-                    /* bl corner */
-                    mx_guiAddSprite( inGUI,
-                                     0,
-                                     255,
-                                     mx_panelSprites.corners[3],
-                                     fillStartX + fillW * ( numFillCols - 1 ),
-                                     rowStartY );
-                    }
-                else {
-                    /* left edge */
-                    mx_guiAddSprite( inGUI,
-                                     0,
-                                     255,
-                                     mx_panelSprites.sides[1],
-                                     fillStartX + fillW * ( numFillCols - 1 ),
-                                     rowStartY );
-                    }
-                }
-            }
-        }
-    else {
-        
-        MaxiginColor  c;
-        
-        /* no sprites, draw with rectangles */
+static  MinginButton  mx_playbackMappings[8][2] =
+    { { MGN_KEY_BACKSLASH, MGN_MAP_END },   /* start-stop */
+      { MGN_KEY_EQUAL,     MGN_MAP_END },   /* faster */
+      { MGN_KEY_MINUS,     MGN_MAP_END },   /* slower */
+      { MGN_KEY_0,         MGN_MAP_END },   /* pause */
+      { MGN_KEY_9,         MGN_MAP_END },   /* normal speed */
+      { MGN_KEY_8,         MGN_MAP_END },   /* reverse playback */
+      { MGN_KEY_BRACKET_L, MGN_MAP_END },   /* jump back */
+      { MGN_KEY_BRACKET_R, MGN_MAP_END } }; /* jump ahead */
 
-        /* shadow */
-        mx_makeColorGray( &c,
-                          0 );
 
-        c.comp.alpha = 64;
-    
-        mx_guiAddFillRect( inGUI,
-                           0,
-                           &c,
-                           -inWidth  / 2 - 2,
-                           -inHeight / 2 + 2,
-                           inWidth   / 2 - 2 - 1,
-                           inHeight  / 2 + 2 - 1 );
+static  MinginButton  mx_hideGuiMapping[]  = { MGN_KEY_H,
+                                               MGN_MAP_END };
 
-    
-        mx_makeColorGray( &c,
-                          64 );
 
-        c.comp.alpha = 255;
-    
-        mx_guiAddFillRect( inGUI,
-                           0,
-                           &c,
-                           -inWidth  / 2,
-                           -inHeight / 2,
-                           inWidth   / 2 - 1,
-                           inHeight  / 2 - 1 );
+static  MinginButton  mx_addLoopPointMapping[]     = { MGN_KEY_P,
+                                                       MGN_MAP_END };
 
-        mx_makeColorGray( &c,
-                          128 );
+static  MinginButton  mx_clearLoopPointsMapping[]  = { MGN_KEY_O,
+                                                       MGN_MAP_END };
 
-        c.comp.alpha = 255;
-    
-        mx_guiAddDrawRect( inGUI,
-                           0,
-                           &c,
-                           -inWidth  / 2,
-                           -inHeight / 2,
-                           inWidth   / 2 - 1,
-                           inHeight  / 2 - 1 );
-        }
-    
+#if MAXIGIN_ENABLE_FRAME_PROFILER
 
-    return i;
-    }
+static  MinginButton  mx_profilerToggleMapping[]   = { MGN_KEY_F3,
+                                                       MGN_MAP_END };
 
+static  MinginButton  mx_profilerExportMapping[]   = { MGN_KEY_F4,
+                                                       MGN_MAP_END };
 
+#endif
 
-void maxigin_guiEndPanel( MaxiginGUI  *inGUI,
-                          int          inPanelHandle ) {
 
-    int            i    =  inPanelHandle;
-    int            cX;
-    int            cY;
-    unsigned char  oldFade;
-    
-    if( i < 0 ) {
-        return;
-        }
+static  MinginStick  mx_sliderStickMapping[] = { MGN_STICK_LEFT_X,
+                                                 MGN_STICK_RIGHT_X,
+                                                 MGN_MAP_END };
 
-    if( inGUI->drawComponents[i].drawType != MX_GUI_SUB_PANEL_START ) {
-        mingin_log( "Error:  panel handle mismatch in "
-                    "MaxiginGUI instance.\n" );
-        return;
-        }
 
-    /* undo the offset setup when our panel was created */
-    cX      = inGUI->drawComponents[i].drawParams.panelStart.plusX;
-    cY      = inGUI->drawComponents[i].drawParams.panelStart.plusY;
-    oldFade = inGUI->drawComponents[i].drawParams.panelStart.oldFade;
-        
-    inGUI->zeroOffsetX -= cX;
-    inGUI->zeroOffsetY -= cY;
-    inGUI->fade = oldFade;
-    
-    /* add a draw component that undoes the offset in our draw sequence */
-    i  =  inGUI->numDrawComponents;
+static void mx_clearTranslationKeys( void );
 
-    if( i >= MAXIGIN_MAX_TOTAL_GUI_DRAW_COMPONENTS ) {
-        mingin_log( "Error:  trying to end a panel in a full "
-                    "MaxiginGUI instance.\n" );
-        return;
-        }
+static  void mx_initLanguages( void );
 
-    inGUI->drawComponents[i].drawType = MX_GUI_SUB_PANEL_END;
-    
-    inGUI->drawComponents[i].drawParams.panelEnd.plusX   = -cX;
-    inGUI->drawComponents[i].drawParams.panelEnd.plusY   = -cY;
-    inGUI->drawComponents[i].drawParams.panelEnd.oldFade = oldFade;
+static void mx_finishSoundEffectReads( void );
 
-    inGUI->numDrawComponents ++;
-    }
+static int          mx_lang_settings;
+static int          mx_lang_newGame;
+static int          mx_lang_quit;
+static int          mx_lang_resume;
+static int          mx_lang_musicVolume;
+static int          mx_lang_effectsVolume;
+static int          mx_lang_fullscreen;
+static int          mx_lang_languages;
+static int          mx_lang_controls;
+static int          mx_lang_back;
+static int          mx_lang_press;
+static int          mx_lang_defaults;
 
 
+/* smaller scale for sound effects, since the volume only applies
+   per play and doesn't do smooth fades */
+#define       MAXIGIN_MAX_SOUND_LOUDNESS           512
 
-void maxigin_guiLabel( MaxiginGUI  *inGUI,
-                       int           inPhraseKey,
-                       int           inLocationX,
-                       int           inLocationY,
-                       MaxiginAlign  inAlign ) {
-    
-    MaxiginColor  c;
+/* larger scale for music, since we smoothly fade to target volume */
+#define       MAXIGIN_MAX_MUSIC_LOUDNESS           8192
 
-    mx_makeColorGray( &c,
-                      255 );
-    c.comp.alpha = 255;
-    
-    mx_guiAddLangText( inGUI,
-                       &c,
-                       inPhraseKey,
-                       inLocationX,
-                       inLocationY,
-                       inAlign );
-    }
+static  int   mx_soundEffectsVolume             =  MAXIGIN_MAX_SOUND_LOUDNESS;
+static  int   mx_musicVolume                    =  MAXIGIN_MAX_MUSIC_LOUDNESS;
+static  int   mx_musicVolumeTarget              =  MAXIGIN_MAX_MUSIC_LOUDNESS;
 
 
+static  int          mx_buttonPhraseKeys[ MINGIN_NUM_BUTTON_MAPPINGS ];
 
-void maxigin_guiCheckbox( MaxiginGUI  *inGUI,
-                          char        *inChecked,
-                          int          inLocationX,
-                          int          inLocationY,
-                          int          inRadius ) {
 
-    MaxiginColor   c;
-    int            r          =   inRadius;
-    int            rLeft      =  -inRadius;
-    int            rRight     =   inRadius;
-    int            rTop       =  -inRadius;
-    int            rBot       =   inRadius;
-    char           mouseDown  =   mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON );
-    int            x          =   0;
-    int            y          =   0;
-    char           avail      =   maxigin_getPointerLocation( &x,
-                                                              &y );
-    unsigned char  frameV;
+static void mx_loadButtonMapping( const char  *inStoreName );
 
-    if( mx_checkboxSpritesSet ) {
-        MaxiginSprite  *s  = &( mx_sprites[ mx_checkboxSprites.cool[0] ] );
+static void mx_saveButtonMapping( const char  *inStoreName );
 
-        rLeft  =  - s->leftVisibleRadius;
-        rRight =    s->rightVisibleRadius;
-        rTop   =  - s->upperVisibleRadius;
-        rBot   =    s->lowerVisibleRadius;
-        }
 
-    x -= inGUI->zeroOffsetX;
-    y -= inGUI->zeroOffsetY;
 
-    x -= inLocationX;
-    y -= inLocationY;
+static void mx_gameInit( void ) {
 
-    /* if mouse is over us, check for new press */
-    if( avail
-        &&
-        x >= rLeft
-        &&
-        x <= rRight
-        &&
-        y >= rTop
-        &&
-        y <= rBot ) {
+    int  p;
+    int  i;
+    
+    mx_enableAutoQuit = maxigin_readFlagSetting( "maxigin_enableAutoQuit.ini",
+                                                 0 );
 
-        if( inGUI->active == 0
-            ||
-            inGUI->active == inChecked ) {
-            /* don't become hot if mouse pressed on other component */
-            inGUI->hot = inChecked;
-            }
-        
-        if( ! inGUI->mouseDown
-            &&
-            mouseDown ) {
-            
-            inGUI->mouseDown = 1;
-            inGUI->active = inChecked;
-            }
-        else if( inGUI->mouseDown
-                 &&
-                 inGUI->active == inChecked
-                 &&
-                 ! mouseDown ) {
+    mx_verifyPlaybackMode =
+        maxigin_readFlagSetting( "maxigin_verifyPlayback.ini",
+                                 0 );
 
-            /* mouse released on us when it was pressed on us before,
-               toggle checked */
 
-            *inChecked = ! ( *inChecked );
+    mx_soundEffectsVolume =
+        maxigin_readIntSetting( "maxigin_soundEffectsVolume.ini",
+                                MAXIGIN_MAX_SOUND_LOUDNESS );
+    mx_musicVolume =
+        maxigin_readIntSetting( "maxigin_musicVolume.ini",
+                                MAXIGIN_MAX_MUSIC_LOUDNESS );
 
-            inGUI->mouseDown = 0;
+    mx_musicVolumeTarget = mx_musicVolume;
 
-            inGUI->active = 0;
-            }
-        }
-    else {
-        /* mouse not over us
-           watch for release far away due to a press that started on us */
+    for( i = 0;
+         i < MINGIN_NUM_BUTTON_MAPPINGS;
+         i ++ ) {
 
-        if( inGUI->hot == inChecked ) {
-            inGUI->hot = 0;
-            }
+        mx_buttonPhraseKeys[i] = -1;
         
-        if( inGUI->mouseDown
-            &&
-            inGUI->active == inChecked
-            &&
-            ! mouseDown ) {
-
-            /* don't toggle checked if it was released away from us */
-            inGUI->mouseDown = 0;
-
-            inGUI->active = 0;
-            }
         }
     
+    
+    mingin_registerButtonMapping( QUIT,
+                                  mx_quitMapping );
+    
+    mingin_registerButtonMapping( MENU,
+                                  mx_menuMapping );
+    
+    mingin_registerButtonMapping( MENU_BACK,
+                                  mx_menuBackMapping );
 
-    if( mx_checkboxSpritesSet ) {
-
-        int  s;
-        int  i   =  0;
+    mingin_registerButtonMapping( MENU_UP,
+                                  mx_menuUpMapping );
 
-        if( *inChecked ) {
-            i = 1;
-            }
-        
-        if( inGUI->hot      == inChecked
-            ||
-            inGUI->forceHot == inChecked ) {
-            
-            s = mx_checkboxSprites.hot[i];
-            }
-        else {
-            s = mx_checkboxSprites.cool[i];
-            }
+    mingin_registerButtonMapping( MENU_DOWN,
+                                  mx_menuDownMapping );
 
-        mx_guiAddSprite( inGUI,
-                         0,
-                         255,
-                         s,
-                         inLocationX,
-                         inLocationY);
-        }
-    else {
-        /* no sprites, draw with shapes */
+    mingin_registerStickAxis( MENU_STICK_NAV,
+                              mx_menuStickNavMapping );
 
-        frameV = 128;
+    mingin_registerButtonMapping( MENU_PICK,
+                                  mx_menuPickMapping );
+    
+    mingin_registerButtonMapping( FULLSCREEN_TOGGLE,
+                                  mx_fullscreenMapping );
 
-        if( inGUI->hot      == inChecked
-            ||
-            inGUI->forceHot == inChecked ) {
-            
-            frameV = 255;
-            }
+    mingin_registerButtonMapping( CRT_TOGGLE,
+                                  mx_crtMapping );
+    
+    mingin_registerButtonMapping( LANG_SWITCH,
+                                  mx_langSwitchMapping );
 
-        mx_makeColorGray( &c,
-                          frameV );
+    mingin_registerButtonMapping( MAXIGIN_MOUSE_BUTTON,
+                                  mx_mouseButtonMapping );
 
-        c.comp.alpha = 255;
+    mingin_registerButtonMapping( MAXIGIN_SLIDER_INCREASE,
+                                  mx_sliderIncreaseMapping );
     
-        mx_guiAddDrawRect( inGUI,
-                           0,
-                           &c,
-                           inLocationX - r,
-                           inLocationY - r,
-                           inLocationX + r,
-                           inLocationY + r );
+    mingin_registerButtonMapping( MAXIGIN_SLIDER_DECREASE,
+                                  mx_sliderDecreaseMapping );
 
-        if( *inChecked ) {
-            mx_guiAddLine( inGUI,
-                           0,
-                           &c,
-                           inLocationX - r,
-                           inLocationY - r,
-                           inLocationX + r,
-                           inLocationY + r );
-            mx_guiAddLine( inGUI,
-                           0,
-                           &c,
-                           inLocationX + r,
-                           inLocationY - r,
-                           inLocationX - r,
-                           inLocationY + r );
-            }
+    for( p =  PLAYBACK_START_STOP;
+         p <= PLAYBACK_JUMP_HALF_AHEAD;
+         p ++ ) {
+        
+        mingin_registerButtonMapping(
+            p,
+            mx_playbackMappings[ p - PLAYBACK_START_STOP ] );
         }
-    }
 
+    mingin_registerButtonMapping( MAXIGIN_HIDE_GUI,
+                                  mx_hideGuiMapping );
 
+    mingin_registerButtonMapping( MAXIGIN_ADD_LOOP_POINT,
+                                  mx_addLoopPointMapping );
+    
+    mingin_registerButtonMapping( MAXIGIN_CLEAR_LOOP_POINTS,
+                                  mx_clearLoopPointsMapping );
 
-/* returns sprite handle, or -1 if no sprite (label string might be set in
-   this case)
+#if MAXIGIN_ENABLE_FRAME_PROFILER
+    mingin_registerButtonMapping( MAXIGIN_PROFILER_TOGGLE,
+                                  mx_profilerToggleMapping );
+    
+    mingin_registerButtonMapping( MAXIGIN_PROFILER_EXPORT,
+                                  mx_profilerExportMapping );
+#endif
 
-   outLabelString  set to 0 or English-language key name string, if needed
+    /* all buttons start out unpressed */
+    for( p = QUIT;
+         p < LAST_MAXIGIN_USER_ACTION;
+         p ++ ) {
+        
+        mx_buttonsDown[ p ] = 0;
+        }
 
-   Note that if outLabelString is a single character, sprite handle might
-   be set to a blank key-cap sprite to draw under this character
 
-   inButtonHandle is in maxigin-remapped button space
-*/
-static int mx_getButtonHintSprite( int           inButtonHandle,
-                                   const char  **outLabelString );
+    mingin_registerStickAxis( MAXIGIN_STICK_SLIDER,
+                              mx_sliderStickMapping );
 
+    /* all translation keys start empty */
+    mx_clearTranslationKeys();
 
-static int mx_getButtonHintFont( void );
+    
+    
+    mx_areWeInMaxiginGameInitFunction = 1;
 
+    mx_startStartupProfile();
 
+    mx_startProfilePhase( "mx_gameInit" );
+    
+    maxigin_initGUI( &mx_internalGUI );
 
-static char mx_guiButtonBody( MaxiginGUI  *inGUI,
-                              int         *inHandle,
-                              int          inHintButtonHandle,
-                              int          inLocationX,
-                              int          inLocationY,
-                              int          inRadiusX,
-                              int          inRadiusY ) {
+    mx_startProfilePhase( "mx_initSpriteCache" );
+    mx_initSpriteCache();
+    mx_endProfilePhase();
+    
+    mx_startProfilePhase( "maxiginGame_init" );
+    maxiginGame_init();
+    mx_endProfilePhase();
 
-    MaxiginColor  c;
-    int           rLeft      =  -inRadiusX;
-    int           rRight     =   inRadiusX;
-    int           rTop       =  -inRadiusY;
-    int           rBot       =   inRadiusY;
-    char          mouseDown  =   mingin_isButtonDown( MAXIGIN_MOUSE_BUTTON );
-    int           x          =   0;
-    int           y          =   0;
-    char          avail      =   maxigin_getPointerLocation( &x,
-                                                             &y );
-    char          returnV    =   0;
+    /* we save the default dynamic buttons that the game has asked for */
+    mx_saveButtonMapping( "maxigin_defaultButtons.ini" );
 
-    if( mx_buttonSpritesSet ) {
-        MaxiginSprite  *s  = &( mx_sprites[ mx_buttonSprites.cool ] );
+    /* now we load any overwritten dynamic button
+       settings that were saved through
+       our menu in the past */
+    mx_loadButtonMapping( "maxigin_savedButtons.ini" );
+    
 
-        rLeft  =  - s->leftVisibleRadius;
-        rRight =    s->rightVisibleRadius;
-        rTop   =  - s->upperVisibleRadius;
-        rBot   =    s->lowerVisibleRadius;
-        }
+    /* our own internal translation keys */
+    mx_lang_settings      = maxigin_initTranslationKey( "settings" );
+    mx_lang_newGame       = maxigin_initTranslationKey( "newGame"  );
+    mx_lang_quit          = maxigin_initTranslationKey( "quit" );
+    mx_lang_resume        = maxigin_initTranslationKey( "resume" );
+    mx_lang_musicVolume   = maxigin_initTranslationKey( "musicVolume" );
+    mx_lang_effectsVolume = maxigin_initTranslationKey( "effectsVolume" );
+    mx_lang_fullscreen    = maxigin_initTranslationKey( "fullscreen" );
+    mx_lang_languages     = maxigin_initTranslationKey( "languages" );
+    mx_lang_controls      = maxigin_initTranslationKey( "controls" );
+    mx_lang_back          = maxigin_initTranslationKey( "back" );
+    mx_lang_press         = maxigin_initTranslationKey( "press" );
+    mx_lang_defaults      = maxigin_initTranslationKey( "defaults" );
 
-    x -= inGUI->zeroOffsetX;
-    y -= inGUI->zeroOffsetY;
+    /* game set any translation keys during init, now we can load languages
+       based on those keys */
+    mx_startProfilePhase( "mx_initLanguages" );
+    mx_initLanguages();
+    mx_endProfilePhase();
 
-    x -= inLocationX;
-    y -= inLocationY;
+    
+    mx_startProfilePhase( "mx_finalizeSpriteCache" );
+    mx_finalizeSpriteCache();
+    mx_endProfilePhase();
 
-    /* if mouse is over us, check for new press */
-    if( avail
-        &&
-        x >= rLeft
-        &&
-        x <= rRight
-        &&
-        y >= rTop
-        &&
-        y <= rBot ) {
+    mx_startProfilePhase( "mx_finishSoundEffectReads" );
+    mx_finishSoundEffectReads();
+    mx_endProfilePhase();
 
-        if( inGUI->active == 0
-            ||
-            inGUI->active == inHandle ) {
-            /* don't become hot if mouse pressed on other component */
-            inGUI->hot = inHandle;
-            }
-        
-        if( ! inGUI->mouseDown
-            &&
-            mouseDown ) {
-            
-            inGUI->mouseDown = 1;
-            inGUI->active = inHandle;
-            }
-        else if( inGUI->mouseDown
-                 &&
-                 inGUI->active == inHandle
-                 &&
-                 ! mouseDown ) {
+    
+    /* leave init flag set until here, b/c init languages loads sprites, etc */
+    mx_areWeInMaxiginGameInitFunction = 0;
 
-            /* mouse released on us when it was pressed on us before,
-               count as press */
-            returnV = 1;
-            
-            inGUI->mouseDown = 0;
+    
+    mx_startProfilePhase( "mx_initRecording" );
+    
+    mx_recordingCrashRecovery();
 
-            inGUI->active = 0;
-            }
+    if( mx_playbackRunning ) {
+        /* game init resumed playback, and recording would share memory
+           with playback keyframes, so start recording when it ends */
+        mx_playbackInterruptedRecording = 1;
+        }
+    else if( ! mx_verifyPlaybackMode ) {
+        /* don't leave a recording behind when we're only verifying */
+        mx_initRecording();
         }
-    else {
-        /* mouse not over us
-           watch for release far away due to a press that started on us */
-
-        if( inGUI->hot == inHandle ) {
-            inGUI->hot = 0;
-            }
-        
-        if( inGUI->mouseDown
-            &&
-            inGUI->active == inHandle
-            &&
-            ! mouseDown ) {
 
-            /* don't count as press if it was released away from us */
-            inGUI->mouseDown = 0;
+    mx_endProfilePhase();
 
-            inGUI->active = 0;
-            }
-        }
-    
+    /* mx_gameInit */
+    mx_endProfilePhase();
 
-    if( mx_buttonSpritesSet ) {
+    mx_finishStartupProfile();
 
-        int  s;
-        
-        if( inGUI->hot      == inHandle
-            ||
-            inGUI->forceHot == inHandle ) {
-            
-            s = mx_buttonSprites.hot;
-            }
-        else {
-            s = mx_buttonSprites.cool;
-            }
 
-        if( inGUI->active == inHandle ) {
-            s = mx_buttonSprites.pressed;
-            }
+    /* supress warning
+       this function generally only called when debugging */
+    if( 0 ) {
+        mx_dumpSpriteRGBA( 0 );
 
-        mx_guiAddSprite( inGUI,
-                         0,
-                         255,
-                         s,
-                         inLocationX,
-                         inLocationY);
+        mx_dumpRGBPixels( 0,
+                          0,
+                          0 );
         }
-    else {
-        /* no sprites, draw with shapes */
-        unsigned char  frameV  =  128;
-        unsigned char  fillV   =  64;
-        
-        
-        if( inGUI->hot      == inHandle
-            ||
-            inGUI->forceHot == inHandle ) {
-            
-            frameV = 255;
-            }
-        
-        if( inGUI->active == inHandle ) {
-            fillV = 0;
-            }
+    }
 
 
-        mx_makeColorGray( &c,
-                          fillV );
 
-        c.comp.alpha = 255;
-    
-        mx_guiAddFillRect( inGUI,
-                           0,
-                           &c,
-                           inLocationX - inRadiusX,
-                           inLocationY - inRadiusY,
-                           inLocationX + inRadiusX,
-                           inLocationY + inRadiusY );
-        
 
-        mx_makeColorGray( &c,
-                          frameV );
 
-        c.comp.alpha = 255;
-    
-        mx_guiAddDrawRect( inGUI,
-                           0,
-                           &c,
-                           inLocationX - inRadiusX,
-                           inLocationY - inRadiusY,
-                           inLocationX + inRadiusX,
-                           inLocationY + inRadiusY );
 
-        }    
-    
+/* button and stick handles left for the game above our own */
+#define  MAXIGIN_NUM_GAME_BUTTONS                                        \
+            ( MINGIN_NUM_BUTTON_MAPPINGS - LAST_MAXIGIN_USER_ACTION )
 
+#define  MAXIGIN_NUM_GAME_STICKS                                         \
+            ( MINGIN_NUM_STICK_MAPPINGS - LAST_MAXIGIN_STICK )
 
-    /* now draw button text on top */
 
+/*
+  Player input that maxiginGame_step can see through maxigin_isButtonDown,
+  maxigin_getPointerLocation, and maxigin_getStickPosition during one step.
 
-    if( inHintButtonHandle != -1 ) {
+  Recorded with each step, so that the playback verify tool can feed it
+  back through maxiginGame_step.
+*/
+typedef struct MaxiginStepInput {
 
-        const char  *s;
-        int          hintSprite  =  mx_getButtonHintSprite( inHintButtonHandle,
-                                                            &s );
-        
-        /* skip drawing any that are just text labels with no sprite */
-        if( hintSprite != -1 ) {
-            
-            int          hintX  =  inLocationX;
+        /* indexed by game button handle */
+        char  buttonsDown[ MAXIGIN_NUM_GAME_BUTTONS ];
 
-            if( mx_buttonSpritesSet ) {
-                hintX -= mx_sprites[ mx_buttonSprites.cool ].leftVisibleRadius;
-                }
-            else {
-                hintX -= inRadiusX;
-                }
+        char  pointerAvailable;
+        int   pointerX;
+        int   pointerY;
 
-            hintX -= mx_sprites[ hintSprite ].rightVisibleRadius;
+        /* indexed by game stick handle */
+        char  stickAvailable[ MAXIGIN_NUM_GAME_STICKS ];
+        int   stickPositions[ MAXIGIN_NUM_GAME_STICKS ];
+        int   stickLowerLimits[ MAXIGIN_NUM_GAME_STICKS ];
+        int   stickUpperLimits[ MAXIGIN_NUM_GAME_STICKS ];
+        
+    } MaxiginStepInput;
 
-            hintX -= 3;
-            
-                
-            mx_guiAddSprite( inGUI,
-                             0,
-                             255,
-                             hintSprite,
-                             hintX,
-                             inLocationY );
-            
-            if( s != 0 ) {
 
-                int  fontHandle  =  mx_getButtonHintFont();
+/* one past the highest button and stick handles that the game registered */
+static  int               mx_numGameButtons          =  0;
+static  int               mx_numGameSticks           =  0;
 
-                if( fontHandle != -1 ) {
-                    
-                    MaxiginColor  fc;
-                    int           spriteLeftR;
-                    
-                    mx_makeColorGray( &fc,
-                                      255 );
-                    fc.comp.alpha = 255;
+/* when set, the game's input calls answer from mx_replayStepInput
+   instead of asking the platform */
+static  char              mx_replayingStepInput      =  0;
+static  MaxiginStepInput  mx_replayStepInput;
 
-                    /* put label on key cap */
-                            
-                    spriteLeftR =
-                        mx_sprites[ hintSprite ].leftVisibleRadius;
-                            
-                    mx_guiAddText( &mx_internalGUI,
-                                   &fc,
-                                   fontHandle,
-                                   (char*)s,
-                                   hintX - spriteLeftR + 3,
-                                   inLocationY  - 1,
-                                   MAXIGIN_LEFT );
-                    }
-                }
-            }
-        }
+/* set when the last diff played back had step input in it */
+static  char              mx_replayStepInputLoaded   =  0;
+
+
+
+/*
+  Captures what the game's input calls currently return.
+*/
+static void mx_captureStepInput( MaxiginStepInput  *outInput ) {
+
+    int  i;
     
+    for( i = 0;
+         i < mx_numGameButtons;
+         i ++ ) {
+        
+        outInput->buttonsDown[ i ] = maxigin_isButtonDown( i );
+        }
 
-    return returnV;
+    outInput->pointerAvailable =
+        maxigin_getPointerLocation( &( outInput->pointerX ),
+                                    &( outInput->pointerY ) );
+
+    for( i = 0;
+         i < mx_numGameSticks;
+         i ++ ) {
+        
+        outInput->stickAvailable[ i ] =
+            maxigin_getStickPosition( i,
+                                      &( outInput->stickPositions[ i ] ),
+                                      &( outInput->stickLowerLimits[ i ] ),
+                                      &( outInput->stickUpperLimits[ i ] ) );
+        }
     }
 
 
 
-char maxigin_guiLangButton( MaxiginGUI  *inGUI,
-                            int         *inHandle,
-                            int          inPhraseKey,
-                            int          inHintButtonHandle,
-                            int          inLocationX,
-                            int          inLocationY,
-                            int          inRadiusX,
-                            int          inRadiusY ) {
+/* keeps track of the highest game button handle registered */
+static void mx_noteGameButtonHandle( int  inButtonHandle ) {
     
-    MaxiginColor  c;
-    char          returnV  =  mx_guiButtonBody( inGUI,
-                                                inHandle,
-                                                inHintButtonHandle,
-                                                inLocationX,
-                                                inLocationY,
-                                                inRadiusX,
-                                                inRadiusY );
+    if( inButtonHandle >= mx_numGameButtons ) {
+        mx_numGameButtons = inButtonHandle + 1;
+        }
+    }
 
-    mx_makeColorGray( &c,
-                      255 );
-    c.comp.alpha = 255;
+
+
+char maxigin_registerButtonMapping( int                 inButtonHandle,
+                                    const MinginButton  inMapping[] ) {
+
+    char  returnV;
+    int   gameHandle  =  inButtonHandle;
     
-    mx_guiAddLangText( inGUI,
-                   &c,
-                   inPhraseKey,
-                   inLocationX,
-                   inLocationY - 1,
-                   MAXIGIN_CENTER );
+    /* push it up so it doesn't interfere with our mappings */
+    inButtonHandle += LAST_MAXIGIN_USER_ACTION;
+
+    returnV = mingin_registerButtonMapping( inButtonHandle,
+                                            inMapping );
+    if( returnV ) {
+        mx_buttonPhraseKeys[ inButtonHandle ] = -1;
 
+        mx_noteGameButtonHandle( gameHandle );
+        }
 
     return returnV;
     }
 
 
 
-char maxigin_guiButton( MaxiginGUI  *inGUI,
-                        int         *inHandle,
-                        int          inFontHandle,
-                        char        *inString,
-                        int          inHintButtonHandle,
-                        int          inLocationX,
-                        int          inLocationY,
-                        int          inRadiusX,
-                        int          inRadiusY ) {
-    
-    MaxiginColor  c;
-    char          returnV  =  mx_guiButtonBody( inGUI,
-                                                inHandle,
-                                                inHintButtonHandle,
-                                                inLocationX,
-                                                inLocationY,
-                                                inRadiusX,
-                                                inRadiusY );
-    mx_makeColorGray( &c,
-                      255 );
-    c.comp.alpha = 255;
-    
-    mx_guiAddText( inGUI,
-                   &c,
-                   inFontHandle,
-                   inString,
-                   inLocationX,
-                   inLocationY - 1,
-                   MAXIGIN_CENTER );
+char maxigin_registerDynamicButtonMapping( int                 inButtonHandle,
+                                           const MinginButton  inMapping[],
+                                           int                 inPhraseKey ) {
+
+    char  returnV;
+    int   gameHandle  =  inButtonHandle;
     
+    /* push it up so it doesn't interfere with our mappings */
+    inButtonHandle += LAST_MAXIGIN_USER_ACTION;
+
+    returnV = mingin_registerButtonMapping( inButtonHandle,
+                                            inMapping );
+    if( returnV ) {
+        mx_buttonPhraseKeys[ inButtonHandle ] = inPhraseKey;
+
+        mx_noteGameButtonHandle( gameHandle );
+        }
+
     return returnV;
     }
 
 
 
+char maxigin_isButtonDown( int  inButtonHandle ) {
 
+    if( mx_replayingStepInput ) {
+        if( inButtonHandle < 0
+            ||
+            inButtonHandle >= MAXIGIN_NUM_GAME_BUTTONS ) {
+            return 0;
+            }
+        return mx_replayStepInput.buttonsDown[ inButtonHandle ];
+        }
+    
+    /* push it up so it doesn't interfere with our mappings */
+    inButtonHandle += LAST_MAXIGIN_USER_ACTION;
 
-/*
-  Note about recording/playback:
+    return mingin_isButtonDown( inButtonHandle );
+    }
 
-  We actually RECORD the state of this static memory to persistent storage
-  after every step (only storing a sparse map of which bytes have changed)
-  and then use that to do full game playback, including smooth rewinding and
-  time jumping forward and back.
 
-  The old minorGems game engine recorded input events, the system clock, etc,
-  and then let the game code replay itself, which is useful for catching bugs,
-  but also fragile, and doesn't allow time-jumping, which made it too much of a
-  pain to use (if someone submitted a long game with a bug a the end, I didn't
-  have time to watch the whole thing).
 
-  This system allows fast forward and rewind, and pause.
+MinginButton maxigin_getPlatformPrimaryButton( int  inButtonHandle ) {
+    /* push it up so it doesn't interfere with our mappings */
+    inButtonHandle += LAST_MAXIGIN_USER_ACTION;
 
-  And then you can see a bug happen (or it will just end, if there was a crash).
+    return mingin_getPlatformPrimaryButton( inButtonHandle );
+    }
 
-  Then you can rewind to the frame before the bug, and then "unleash" it
-  to run on the real game code again, but stop playing back, and then
-  try to trigger the bug yourself.  I.e., you get to the point right before
-  the bug, and then you take the reigns by clicking and pressing buttons.
 
-  We save space by not saving entire memory each step, but just a diff from a
-  periodic full keyframe.
-  
-  A few things to consider:
 
-  1. This requires two extra static buffers that are at least as big as all
-     of the registered memory regions, so that we can compute a diff at
-     each timestep (and keep track of the diff-summed state currently in our
-     file).  We give the .h user a #define that lets them set this size, or
-     turn this off on platforms where we don't want 3x memory usage.
-     
-  2. Diff steps will vary in size, which means we can't just seek to a known
-     location in the file for accurate time-jumping.  We could write a separate
-     index file in parallel that records file pos offsets of keyframes every 1
-     second or whatever, and then, when the recording is done, we append this
-     index to our recording, with a pointer at the end of the file that points
-     back into the file at the location where this index starts.  During
-     playback, we do instant time-jumping by jumping around in this
-     index portion of the file, which will tell us the location of the keyframe
-     to jump to in the main part of the file.
 
-  3. Since each diff step is an XOR from the previous state, we can use it
-     during playback to advance forward from the previous state, but we can
-     also use it to go backwards from this state back to the previous state
-     (xor can do and undo changes by applying it).  This allows reverse
-     playback.
+char maxigin_getPointerLocation( int  *outX,
+                                 int  *outY ) {
+    int   rawX;
+    int   rawY;
+    int   maxX;
+    int   maxY;
+    char  avail;
+    int   scaleFactor;
+    int   offsetX;
+    int   offsetY;
 
-  4. Fast-forward and fast-rewind are achieved by simply playing multiple diff
-     steps before updating the screen.  This seems to work great for 2x, 4x,
-     8x, etc. during testing.  Of course, beyond that, instant time-jumping
-     can be used.
+    if( mx_replayingStepInput ) {
+        if( ! mx_replayStepInput.pointerAvailable ) {
+            return 0;
+            }
+        *outX = mx_replayStepInput.pointerX;
+        *outY = mx_replayStepInput.pointerY;
+        
+        return 1;
+        }
+        
+    avail = mingin_getPointerLocation( &rawX,
+                                       &rawY,
+                                       &maxX,
+                                       &maxY );
 
-  5. After a crash, the recording is not finalized (the index is not appended
-     to the end of the recording and removed as a separate file).  On the next
-     run, we do crash recovery and finalize this recording file.
+    if( ! avail ) {
+        return 0;
+        }
 
-  6. The game's step code is skipped completely during playback.  We assume
-     that the step code is where the state is updated, and we've recorded
-     the entire state, so we can update it without calling the game's step.
-     However, the game's drawing code is still called to draw that changing
-     state.
-*/
+    mx_computeScaling( maxX,
+                       maxY,
+                       & scaleFactor,
+                       & offsetX,
+                       & offsetY );
 
+    rawX -= offsetX;
+    rawX /= scaleFactor;
 
-static void mx_initRecording( void );
+    rawY -= offsetY;
+    rawY /= scaleFactor;
 
-static void mx_stepRecording( void );
+    *outX = rawX;
+    *outY = rawY;
 
-static void mx_finalizeRecording( void );
+    return 1;
+    }
 
-static void mx_recordingCrashRecovery( void );
 
 
-/* returns 1 if playback started, 0 if not */
-static char mx_initPlayback( void );
+char maxigin_registerStickAxis( int                inStickAxisHandle,
+                                const MinginStick  inMapping[] ) {
 
+    char  returnV;
+    int   gameHandle  =  inStickAxisHandle;
+    
+    inStickAxisHandle += LAST_MAXIGIN_STICK;
 
-/* returns 1 of playback happening, 0 if not
-   ignores pause state */
-static char mx_playbackStep( void );
+    returnV = mingin_registerStickAxis( inStickAxisHandle,
+                                        inMapping );
 
-/* executes multi-steps, or delayed steps, basked on mx_playbackSpeed
-   obeys pause state */
-static char mx_playbackSpeedStep( void );
+    if( returnV
+        &&
+        gameHandle >= mx_numGameSticks ) {
+        
+        mx_numGameSticks = gameHandle + 1;
+        }
 
-static void mx_playbackJumpHalfAhead( void );
-static void mx_playbackJumpHalfBack( void );
+    return returnV;
+    }
 
-static void mx_playbackEnd( void );
 
-static void mx_playbackJumpToFullSnapshot( int inFullSnapshotIndex );
 
-static void mx_playbackJumpToStep( int inStepNumber );
+char maxigin_getStickPosition( int   inStickAxisHandle,
+                               int  *outPosition,
+                               int  *outLowerLimit,
+                               int  *outUpperLimit ) {
+
+    if( mx_replayingStepInput ) {
+        if( inStickAxisHandle < 0
+            ||
+            inStickAxisHandle >= MAXIGIN_NUM_GAME_STICKS
+            ||
+            ! mx_replayStepInput.stickAvailable[ inStickAxisHandle ] ) {
+            return 0;
+            }
+        *outPosition   = mx_replayStepInput.stickPositions[ inStickAxisHandle ];
+        *outLowerLimit =
+            mx_replayStepInput.stickLowerLimits[ inStickAxisHandle ];
+        *outUpperLimit =
+            mx_replayStepInput.stickUpperLimits[ inStickAxisHandle ];
+        
+        return 1;
+        }
+
+    inStickAxisHandle += LAST_MAXIGIN_STICK;
+
+    return mingin_getStickPosition( inStickAxisHandle,
+                                    outPosition,
+                                    outLowerLimit,
+                                    outUpperLimit );
+    }
 
-static char mx_playbackStepForward( void );
-static char mx_playbackStepBackward( void );
 
 
-static void mx_gameInit( void );
 
-static void mx_saveGame( void );
 
-static char mx_copyIntoDataStore( int inStoreReadHandle,
-                                  int inStoreWriteHandle,
-                                  int inNumBytesToCopy );
+typedef struct MaxiginMemRec {
+        void        *pointer;
+        int          numBytes;
+        const char  *description;
+    } MaxiginMemRec;
 
-static void mx_startPlayingMusic( const char  *inMusicBulkResourceName );
 
-static void mx_stopPlayingMusic( void );
+#define  MAXIGIN_MAX_MEM_RECORDS  1024
 
+static  MaxiginMemRec  mx_memRecords[ MAXIGIN_MAX_MEM_RECORDS ];
 
+static  int            mx_numMemRecords            =  0;
+static  int            mx_totalMemoryRecordsBytes  =  0;
 
-static char mx_isActionFreshPressed( MaxiginUserAction  inAction ) {
 
-    char fresh = 0;
+void maxigin_initRegisterStaticMemory( void        *inPointer,
+                                       int          inNumBytes,
+                                       const char  *inDescription ) {
     
-    if( mingin_isButtonDown( inAction ) ) {
-        if( ! mx_buttonsDown[ inAction ] ) {
-            fresh = 1;
-            }
-        mx_buttonsDown[ inAction ] = 1;
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call maxigin_initRegisterStaticMemory "
+                    "from outside of maxiginGame_init\n" );
+        return;
         }
-    else {
-        mx_buttonsDown[ inAction ] = 0;
+    
+    if( mx_numMemRecords >= MAXIGIN_MAX_MEM_RECORDS ) {
+        maxigin_logInt( "Game tried to register more than max memory records: ",
+                        MAXIGIN_MAX_MEM_RECORDS );
+        return;
         }
+    mx_memRecords[ mx_numMemRecords ].pointer      =  inPointer;
+    mx_memRecords[ mx_numMemRecords ].numBytes     =  inNumBytes;
+    mx_memRecords[ mx_numMemRecords ].description  =  inDescription;
 
-    return fresh;
+    mx_numMemRecords ++;
+    mx_totalMemoryRecordsBytes += inNumBytes;
     }
 
 
 
-static  char           mx_playbackInterruptedRecording     =  0;
-static  char           mx_playbackInstantReverseRecording  =  0;
-static  char           mx_enableAutoQuit                   =  0;
-static  char           mx_quitting                         =  0;
-static  char           mx_quittingReady                    =  0;
-static  char           mx_playbackSliderActive             =  0;
-static  char           mx_playbackBlockForwardSounds       =  0;
-static  char           mx_menuShowing                      =  0;
-static  int            mx_menuFade                         =  0;
-static  int            mx_menuFadeMax                      =  2550;
-static  char           mx_langPanelShowing                 =  0;
-static  char           mx_controlsPanelShowing             =  0;
-static  void          *mx_menuReturnForceHot               =  0;
-static  char           mx_blockMenuClose                   =  0;
-
-
-
-/* initiates and steps sound fade out, returning 1 when finally done
-   returns 0 while still in-progress */
-static char mx_stepSoundFadeOut( void );
-
-/* maps playback speed/direction to sound speed and direction */
-static void mx_setSoundSpeedAndDirection( int  inSpeed,
-                                          int  inDirection );
 
-static int mx_getMusicFilePos( void );
 
-static void mx_setMusicFilePos( int  inPos );
 
-static void mx_startSoundShortFadeIn( void );
 
-static void mx_renewSoundStartFadeIn( void );
+static  const char   *mx_saveGameDataStoreName  =  "maxigin_save.bin";
 
-static void mx_startSoundPauseRamp( void );
 
-static void mx_clearJustStartedSoundEffects( void );
 
+static char *mx_getMemRecordsFingerprint( int  *outTotalMemBytes ) {
+    
+    enum{  FINGERPRINT_LENGTH  =  10,
+           HEX_LENGTH          =  FINGERPRINT_LENGTH * 2 + 1  };
+    
+    static  unsigned char  fingerprintBuffer[ FINGERPRINT_LENGTH ];
+    static  char           hexBuffer[ HEX_LENGTH ];
 
-static int mx_getNumJustStartedSoundEffects( void );
-static int mx_getNumJustEndedSoundEffects( void );
+    MaxiginFlexHashState  s;
+    int                   i;
+    int                   totalNumBytes  =  0;
 
-/* returns sound effect handle of next, and clears it from
-   list.
+    
+    maxigin_flexHashInit( &s,
+                          FINGERPRINT_LENGTH,
+                          fingerprintBuffer );
+    
+    for( i = 0;
+         i < mx_numMemRecords;
+         i ++ ) {
+        
+        totalNumBytes += mx_memRecords[i].numBytes;
+        
+        maxigin_flexHashAdd(
+            &s,
+            maxigin_stringLength( mx_memRecords[i].description ),
+            (unsigned char *)( mx_memRecords[i].description ) );
+        }
+    *outTotalMemBytes = totalNumBytes;
 
-   returns -1 if none left */
-static int mx_getNextJustStartedSoundEffect( int  *outLoudness );
-static int mx_getNextJustEndedSoundEffect( int  *outLoudness );
+    maxigin_hexEncode( FINGERPRINT_LENGTH,
+                       fingerprintBuffer, 
+                       hexBuffer );
+    
+    return hexBuffer;
+    }
 
 
-static void mx_processDoneSoundEffects( void );
 
 
-static void mx_endAllSoundEffectsNow( void );
+/*
+  Reads a \0-terminated string from data store.
 
+  inMaxBytes is the length of the buffer, including the \0 byte for termination.
 
-/* passed-in buffers must have room for MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS */
-static int mx_getLiveSoundEffects( int *outHandleBuffer,
-                                   int *outLoudnessBuffer,
-                                   int *outDataPosBuffer );
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_readStringFromPersistData( int    inStoreReadHandle,
+                                          int    inMaxBytes,
+                                          char  *inBuffer ) {
+    int  i        =  0;
 
+    int  readNum  =  mingin_readPersistData(
+                         inStoreReadHandle,
+                         1,
+                         (unsigned char *)&( inBuffer[i] ) );
+    
+    while( readNum == 1
+           &&
+           i < inMaxBytes - 1
+           &&
+           inBuffer[i] != '\0' ) {
+        i++;
+        readNum = mingin_readPersistData( inStoreReadHandle,
+                                          1,
+                                          (unsigned char *)&( inBuffer[i] ) );
+        }
 
-static void mx_nextLang( void );
+    if( readNum == 0
+        &&
+        i > 0 ) {
+        /* read some chars, but last read hit EOF, back up */
+        i --;
+        }
+    else if( readNum == 0
+             &&
+             i == 0 ) {
+        /* never read any chars */
+        return 0;
+        }
+    
+    if( readNum == 1
+        &&
+        inBuffer[i] != '\0' ) {
+        /* didn't find termination in data store
+           because string was too long for buffer */
+        mingin_log( "Error:  Buffer overflow when trying to read string from "
+                    "persistent data store.\n" );
+        return 0;
+        }
+    else if( readNum == 0
+             &&
+             inBuffer[i] != '\0' ) {
+        /* reached end of data store without finding termination byte
+           special case:  a data store that only contains one string, with
+           no termination at the end (to make file editable in a text editor)
+           Terminate our read string and return it */
 
+        if( i < inMaxBytes - 1 ) {
+            inBuffer[ i + 1 ] = '\0';
+            return 1;
+            }
 
-static void mx_checkLangNeedsReload( void );
+        /* reached end of data store AND we reached end of buffer?
+           While loop above should prevent this */
+            
+        mingin_log( "Error:  Reading string from persistent data store reached "
+                    "unexpected case\n" );
+        return 0;
+        }
+    else if( readNum == -1 ) {
+        mingin_log( "Error:  Got read failure when trying to read string "
+                    "from persistent data store.\n" );
+        return 0;
+        }
 
+    return 1;
+    }
 
-static void mx_populateMenuPanel( void );
 
-static void mx_pauseAllPlayingSoundEffects( void );
 
-static void mx_unpauseAllPlayingSoundEffects( void );
+/*
+  Reads a \0-terminated short string (< 64 chars long) into a static buffer.
 
+  Returns 0 on failure.
+*/
+static const char *mx_readShortStringFromPersistData( int  inStoreReadHandle ) {
 
+    enum{  BUFFER_LEN  =  64  };
+    
+    static  char  buffer[ BUFFER_LEN ];
+    
+    char  success;
+    
+    
+    success = mx_readStringFromPersistData( inStoreReadHandle,
+                                            BUFFER_LEN,
+                                            buffer );
+    if( success ) {
+        return buffer;
+        }
+    else {
+        return 0;
+        } 
+    }
 
-static void mx_updateLoopPoints( void );
 
-static void mx_loadLoopPoints( void );
+/*
+  Reads a whitespace-terminated short string token (< 64 chars long) into a
+  static buffer.
 
+  Skips any whitespace before the token, and consumes the first whitespace
+  character after the token.
 
+  Valid whitespace includes ' ', '\n', '\r', and '\t'
 
-void minginGame_step( char  inFinalStep ) {
+  Has 10 internal buffers that it uses, round-robin, for interleaved calls
+  
+  Returns \0-terminated string token with no trailing whitespace
+  Returns 0 on failure.
+*/
+static const char *mx_readShortTokenFromBulkData( int  inBulkReadHandle ) {
 
-    char  playbackPausedBySlider  =  0;
+    enum{         NUM_BUFFERS  =  10,
+                  BUFFER_LEN   =  64  };
+    int           i            =   0;
+    int           readNum;
+    char         *returnVal;
+    char          c;
     
-    if( ! mx_initDone ) {
-        if( inFinalStep ) {
-            /* ended before we even got to init, do nothing */
-            return;
-            }
-        
-        mx_gameInit();
-        mx_initDone = 1;
-        }
+    static  char  buffer[NUM_BUFFERS][ BUFFER_LEN ];
+    static  int   n                                   =  0;
     
 
-    /* handle both case where platform forced us to end and
-       where user decided to quit */
-    if( inFinalStep ) {
+    /* skip white space */
+    readNum = mingin_readBulkData( inBulkReadHandle,
+                                   1,
+                                   (unsigned char *)&( c ) );
 
-        mingin_log( "Forced to quit by platform\n" );
+    while( readNum == 1
+           &&
+           ( c == '\0'
+             ||
+             c == ' '
+             ||
+             c == '\n'
+             ||
+             c == '\r'
+             ||
+             c == '\t' ) ) {
 
-        /* quit immediately, since this is our last step
-           we can't wait for music to fade out nicely, etc. */
-        mx_quitting  = 1;
-        mx_quittingReady = 1;
+        readNum = mingin_readBulkData( inBulkReadHandle,
+                                   1,
+                                   (unsigned char *)&( c ) );
         }
 
-    if( ! mx_quitting
-        &&
-        mingin_isButtonDown( QUIT ) ) {
-
-        mingin_log( "Got quit key, starting sound fade out\n" );
-        
-        mx_quitting      = 1;
-        mx_quittingReady = 0;
+    if( readNum != 1 ) {
+        /* read to end without finding anything but spaces */
+        return 0;
         }
 
-    if( ! mx_quitting
-        && mx_enableAutoQuit ) {
-        
-        mx_quitting = maxigin_readFlagSetting( "maxigin_autoQuit.ini",
-                                               0 );
+    /* put first non-whitespace in our buffer */
+    buffer[n][i] = c;
 
-        if( mx_quitting ) {
-            mingin_log( "Found auto-quit in persistent data settings\n" );
+    i++;
 
-            /* We normally wait for sound/music to fade out nicely when quitting
-               to avoid a pop, but in case of hot-reload, speed things up
-               by skipping fade-out */
-            mx_quittingReady = 1;
-            }
+    
+    /* now continue filling buffer with non-whitespace tokens */
+    
+    readNum = mingin_readPersistData( inBulkReadHandle,
+                                          1,
+                                          (unsigned char *)&( buffer[n][i] ) );
+    
+    while( readNum == 1
+           &&
+           i < BUFFER_LEN - 1
+           &&
+           buffer[n][i] != '\0'
+           &&
+           buffer[n][i] != ' '
+           &&
+           buffer[n][i] != '\n'
+           &&
+           buffer[n][i] != '\r'
+           &&
+           buffer[n][i] != '\t' ) {
+        i++;
+        readNum = mingin_readPersistData( inBulkReadHandle,
+                                          1,
+                                          (unsigned char *)&( buffer[n][i] ) );
         }
 
-    if( mx_quitting
+    if( readNum == 0
         &&
-        ! mx_quittingReady ) {
-
-        /* wait for sound to be done fading out */
-        if( mx_stepSoundFadeOut() ) {
-            mx_quittingReady = 1;
-            }
+        i > 0 ) {
+        /* read some chars, but last read hit end of data, back up */
+        i --;
         }
-
-    if( mx_quitting
+    else if( readNum == 0
+             &&
+             i == 0 ) {
+        /* never read any chars */
+        return 0;
+        }
+    
+    if( readNum == 1
         &&
-        mx_quittingReady ) {
-        
-        mx_saveGame();
+        buffer[n][i] != '\0'
+        &&
+        buffer[n][i] != ' '
+        &&
+        buffer[n][i] != '\n'
+        &&
+        buffer[n][i] != '\r'
+        &&
+        buffer[n][i] != '\t' ) {
+        /* didn't find termination in data store
+           because string was too long for buffer */
+        mingin_log( "Error:  Buffer overflow when trying to read string "
+                    "token from bulk data store.\n" );
+        return 0;
+        }
+    else if( readNum == 0
+             &&
+             buffer[n][i] != '\0'
+             &&
+             buffer[n][i] != ' '
+             &&
+             buffer[n][i] != '\n'
+             &&
+             buffer[n][i] != '\r'
+             &&
+             buffer[n][i] != '\t' ) {
+        /* reached end of data store without finding whitespace
+           or termination byte
+           special case:  a data store that only contains one string, with
+           no whitespace at end
+           Terminate our read string and return it */
 
-        if( mx_playbackRunning ) {
-            /* in the middle of playing back a recording */
+        if( i < BUFFER_LEN - 1 ) {
+            buffer[n][ i + 1 ] = '\0';
 
-            maxigin_writeIntSetting( "maxigin_resumePlayback.ini",
-                                     1 );
-            maxigin_writeIntSetting( "maxigin_resumePlaybackPos.ini",
-                                     mx_playbackCurrentStep );
+            returnVal = buffer[n];
+            
+            n++;
 
-            maxigin_writeIntSetting( "maxigin_resumePlaybackSpeed.ini",
-                                     mx_playbackSpeed );
-            maxigin_writeIntSetting( "maxigin_resumePlaybackDirection.ini",
-                                     mx_playbackDirection );
-            maxigin_writeIntSetting( "maxigin_resumePlaybackPaused.ini",
-                                     mx_playbackPaused );
-            }
-        else {
-            maxigin_writeIntSetting( "maxigin_resumePlayback.ini",
-                                     0 );
+            if( n >= NUM_BUFFERS ) {
+                n = 0;
+                }
+            
+            return returnVal;
             }
-        
-        mx_finalizeRecording();
 
-        mx_stopPlayingMusic();
-
-        if( mx_enableAutoQuit ) {
-            maxigin_writeIntSetting( "maxigin_autoQuitDone.ini",
-                                     1 );
-            }
+        /* reached end of data store AND we reached end of buffer?
+           While loop above should prevent this */
+            
+        mingin_log( "Error:  Reading string token from bulk data reached "
+                    "unexpected case\n" );
+        return 0;
+        }
+    else if( readNum == -1 ) {
         
-        mingin_quit();
-
-        return;
+        mingin_log( "Error:  Got read failure when trying to read string "
+                    "token from bulk data.\n" );
+        return 0;
         }
 
+    /* got here, safe to terminate buffer at first whitespace character
+       found */
+    buffer[n][i] = '\0';
 
-    if( mx_isActionFreshPressed( MENU ) ) {
+    returnVal = buffer[n];
+    
+    n++;
 
-        if( ! mx_menuShowing
-            ||
-            ( mx_menuShowing
-              &&
-              ! mx_blockMenuClose ) ) {
+    if( n >= NUM_BUFFERS ) {
+        n = 0;
+        }
 
-            char menuWasShowing = mx_menuShowing;
+    return returnVal; 
+    }
 
-            if( menuWasShowing ) {
-                /* play thte do sound BEFORE closing the menu,
-                   so it won't be included in recording */
-                if( mx_menuDoSound != -1 ) {
-            
-                    maxigin_playSoundEffect( mx_menuDoSound,
-                                             mx_menuDoLoudness );
-                    }
-                }
-            
-            mx_menuShowing = ! mx_menuShowing;
 
-            if( ! menuWasShowing ) {
+/*
+  Reads a \0-terminated string representation of an int from data store.
 
-                /* recording paused during menu, don't want all
-                   active sound effects to pile up their ending events
-                   in one frame */
-                
-                mx_pauseAllPlayingSoundEffects();
-                
-                /* play thte do sound AFTER we start opening the menu,
-                   so it won't be included in recording */
-                if( mx_menuDoSound != -1 ) {
-            
-                    maxigin_playSoundEffect( mx_menuDoSound,
-                                             mx_menuDoLoudness );
-                    }
-                }
-            else {
-                /* menu just closed, unpause in-process sound effects
-                   that were playing when menu was opened, allowing
-                   their ending events to get recorded properly */
-                
-                mx_unpauseAllPlayingSoundEffects();
-                }
-            
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_readIntFromPersistData( int   inStoreReadHandle,
+                                       int  *outInt ) {
+    
+    const char  *read  =  mx_readShortStringFromPersistData( inStoreReadHandle );
 
-            /* end playback when menu opened */
-            if( mx_menuShowing
-                &&
-                mx_playbackRunning ) {
-                mx_playbackEnd();
-                mx_initRecording();
-                mx_playbackInterruptedRecording = 0;
-                }
-        
-            
-            }
+    if( read == 0 ) {
+        return 0;
         }
     
-    
+    *outInt = maxigin_stringToInt( read );
 
-    maxigin_startGUI( &mx_internalGUI );
+    return 1;
+    }
+
+
+/*
+  Reads a whitespace-delimited string representation of an int from
+  a bulk resource.
+
+  Skips any whitespace before the int, and consumes the first whitespace
+  character after the int.
 
-    if( mx_isActionFreshPressed( FULLSCREEN_TOGGLE ) ) {
-        mingin_toggleFullscreen( ! mingin_isFullscreen() );
-        }
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_readIntTokenFromBulkData( int   inBulkReadHandle,
+                                         int  *outInt ) {
+    
+    const char  *read  =  mx_readShortTokenFromBulkData( inBulkReadHandle );
 
-    if( mx_isActionFreshPressed( CRT_TOGGLE ) ) {
-        mx_crtOverlayOn = ! mx_crtOverlayOn;
+    if( read == 0 ) {
+        return 0;
         }
+    
+    *outInt = maxigin_stringToInt( read );
 
-    if( mx_isActionFreshPressed( LANG_SWITCH ) ) {
-        mx_nextLang();
-        }
+    return 1;
+    }
 
-    if( mx_isActionFreshPressed( MAXIGIN_HIDE_GUI ) ) {
-        mx_hideGUI = ! mx_hideGUI;
-        }
 
 
-    if( mx_playbackRunning
-        &&
-        mx_isActionFreshPressed( MAXIGIN_ADD_LOOP_POINT ) ) {
+/*
+  Writes a \0-terminated string representation of an int to data store.
 
-        int  curDataPos  =
-               mingin_getPersistDataPosition( mx_playbackDataStoreHandle );
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writeStringToPeristentData( int          inStoreWriteHandle,
+                                           const char  *inString ) {
+    
+    return mingin_writePersistData( inStoreWriteHandle,
+                                    maxigin_stringLength( inString ) + 1,
+                                    (unsigned char*)inString );
+    }
 
-        if( curDataPos != -1 ) {
 
-            if( ! mx_playbackPaused ) {
-                
-                if( mx_playbackDirection == 1 ) {
-                    
-                    mx_loopPointHandles[ 1 ] = curDataPos;
-                    mx_loopPointSteps  [ 1 ] = mx_playbackCurrentStep;
+/*
+  Writes a \0-terminated string representation of an int to data store.
 
-                    if( mx_loopPointHandles[ 0 ] == -1 ) {
-                    
-                        mx_loopPointHandles[ 0 ] = 0;
-                        mx_loopPointSteps  [ 0 ] = 0;
-                        }
-                    mx_updateLoopPoints();
-                    }
-                else if( mx_playbackDirection == -1 ) {
-                    mx_loopPointHandles[ 0 ] = curDataPos;
-                    mx_loopPointSteps  [ 0 ] = mx_playbackCurrentStep;
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writeIntToPeristentData( int  inStoreWriteHandle,
+                                        int  inInt ) {
+    
+    return mx_writeStringToPeristentData( inStoreWriteHandle,
+                                          maxigin_intToString( inInt ) );
+    }
 
-                    if( mx_loopPointHandles[ 1 ] == -1 ) {
-                    
-                        mx_loopPointHandles[ 1 ] = mx_playbackDataLength;
-                        mx_loopPointSteps  [ 1 ] = mx_playbackTotalSteps;
-                        }
-                    mx_updateLoopPoints();
-                    }
-                }
-            else {
-                /* paused, player might move head with mouse
-                   and we let them set whichever loop point isn't set yet */
 
-                if( mx_loopPointHandles[ 0 ] == -1
-                    ||
-                    mx_loopPointHandles[ 0 ] == 0 ) {
-                    
-                    mx_loopPointHandles[ 0 ] = curDataPos;
-                    mx_loopPointSteps  [ 0 ] = mx_playbackCurrentStep;
 
-                    if( mx_loopPointHandles[ 1 ] == -1 ) {
-                        mx_loopPointHandles[ 1 ] = mx_playbackDataLength;
-                        mx_loopPointSteps  [ 1 ] = mx_playbackTotalSteps;
-                        }
-                    mx_updateLoopPoints();
-                    }
-                else if( mx_loopPointHandles[ 1 ] == -1
-                         ||
-                         mx_loopPointHandles[ 1 ] == mx_playbackDataLength ) {
-                    
-                    mx_loopPointHandles[ 1 ] = curDataPos;
-                    mx_loopPointSteps  [ 1] = mx_playbackCurrentStep;
-                    mx_updateLoopPoints();
-                    }
-                else {
-                    /* loop points set... are we before first one
-                       or after second one ?
-                     */
 
-                    if( mx_playbackCurrentStep < mx_loopPointSteps  [ 0 ] ) {
-                        mx_loopPointHandles[ 0 ] = curDataPos;
-                        mx_loopPointSteps  [ 0 ] = mx_playbackCurrentStep;
-                        mx_updateLoopPoints();
-                        }
-                    else if( mx_playbackCurrentStep >
-                             mx_loopPointSteps  [ 1 ] ) {
-                        mx_loopPointHandles[ 1 ] = curDataPos;
-                        mx_loopPointSteps  [ 1 ] = mx_playbackCurrentStep;
-                        }
-                    else if( mx_playbackCurrentStep == mx_loopPointSteps[ 0 ]
-                             ||
-                             mx_playbackCurrentStep == mx_loopPointSteps[ 1 ] ) {
-                        /* on an existing point, do nothing */
-                        }
-                    else {
-                        /* we're between loop points...
-                           adjust whichever is closest to us
-                        */
+static  unsigned char  mx_intPadding[ MAXIGIN_PADDED_INT_LENGTH ];
 
-                        int  diff0  =  mx_playbackCurrentStep -
-                                       mx_loopPointSteps[ 0 ];
-                        int  diff1  =  mx_loopPointSteps[ 1 ] -
-                                       mx_playbackCurrentStep;
 
-                        if( diff0 <= diff1 ) {
-                            mx_loopPointHandles[ 0 ] = curDataPos;
-                            mx_loopPointSteps  [ 0 ] = mx_playbackCurrentStep;
-                            }
-                        else {
-                            mx_loopPointHandles[ 1 ] = curDataPos;
-                            mx_loopPointSteps  [ 1 ] = mx_playbackCurrentStep;
-                            }
-                        mx_updateLoopPoints();
-                        }
-                    }
-                }
-            }
-        }
 
-    if( mx_playbackRunning
-        &&
-        mx_isActionFreshPressed( MAXIGIN_CLEAR_LOOP_POINTS ) ) {
 
-        int  p;
+static char mx_writePaddedIntToPerisistentData( int  inStoreWriteHandle,
+                                                int  inInt ) {
 
-        for( p = 0;
-             p < 2;
-             p ++ ) {
+    /* local buffers, since the recording writer might call this
+       from a worker thread */
+    char           stringBuffer[ 20 ];
+    unsigned char  padded[ MAXIGIN_PADDED_INT_LENGTH ];
+    const char    *intString                             =
+                       mx_intToStringInBuffer( inInt,
+                                               stringBuffer );
+    int            b                                     =  0;
 
-            mx_loopPointHandles[ p ] = -1;
-            mx_loopPointSteps  [ p ] = -1;
-            }
-        mx_updateLoopPoints();
+    while( b < MAXIGIN_PADDED_INT_LENGTH
+           &&
+           intString[b] != '\0' ) {
+        
+        padded[b] = (unsigned char)( intString[b] );
+        b++;
         }
     
-    
-    if( ! mx_menuShowing
-        &&
-        mx_isActionFreshPressed( PLAYBACK_START_STOP ) ) {
-        
-        mx_playbackInstantReverseRecording = 0;
-        
-        if( mx_playbackRunning ) {
-            mx_playbackEnd();
-            mx_initRecording();
-            mx_playbackInterruptedRecording = 0;
-            }
-        else {
-            if( mx_recordingRunning ) {
-                mx_finalizeRecording();
-                mx_playbackInterruptedRecording = 1;
-                }
-            mx_initPlayback();
-            }
+    /* pad with \0     */
+    while( b < MAXIGIN_PADDED_INT_LENGTH ) {
+        padded[b] = '\0';
+        b++;
         }
 
-    if( ! mx_menuShowing
-        &&
-        mx_playbackRunning ) {
-
-        int   oldPlaybackFrame;
-        int   newPlaybackFrame;
-        char  playbackSliderActive;
-        int   oldSpeed               =  mx_playbackSpeed;
-        int   oldDir                 =  mx_playbackDirection;
-        char  oldPaused              =  mx_playbackPaused;
-        
-        if( mx_isActionFreshPressed( PLAYBACK_PAUSE ) ) {
-            mx_playbackPaused = ! mx_playbackPaused;
-            }
-        if( mx_isActionFreshPressed( PLAYBACK_NORMAL ) ) {
-            mx_playbackPaused = 0;
-            mx_playbackSpeed = 1;
-            mx_playbackDirection = 1;
-            }
-        if( mx_isActionFreshPressed( PLAYBACK_REVERSE ) ) {
-            mx_playbackPaused = 0;
-            if( mx_playbackDirection == 1 ) {
-                mx_playbackDirection = -1;
-                }
-            else {
-                mx_playbackDirection = 1;
-                }
-            }
-        if( mx_isActionFreshPressed( PLAYBACK_JUMP_HALF_AHEAD ) ) {
-            mx_playbackJumpHalfAhead();
-            }
-        if( mx_isActionFreshPressed( PLAYBACK_JUMP_HALF_BACK ) ) {
-            mx_playbackJumpHalfBack();
-            }
-                        
-        if( mx_isActionFreshPressed( PLAYBACK_FASTER ) ) {
-            if( mx_playbackPaused ) {
-                /* faster button jumps ahead by one step when paused */
-                mx_playbackStep();
-                }
-            else {
-                /* not paused, faster adjusts speed */
-            
-                if( mx_playbackSpeed >= 1 ) {
-                    mx_playbackSpeed ++;
-                    }
-                else if( mx_playbackSpeed == -2 ) {
-                    /* coming out of half-speed mode */
-                    mx_playbackSpeed = 1;
-                    }
-                else if( mx_playbackSpeed <= -4 ) {
-                    /* in slow down mode, get 2x faster per step
-                       to get out of it */
-                    
-                    mx_playbackSpeed /= 2;
-                    }
-                }
-            }
-        if( mx_isActionFreshPressed( PLAYBACK_SLOWER ) ) {
-            if( mx_playbackSpeed > 1 ) {
-                mx_playbackSpeed--;
-                }
-            else if( mx_playbackSpeed == 1 ) {
-                mx_playbackSpeed = -2;
-                }
-            else if( mx_playbackSpeed < 0 ) {
-                /* twice as slow */
-                mx_playbackSpeed *= 2;
-                }
-            }
-
-        if( oldSpeed  != mx_playbackSpeed
-            ||
-            oldDir    != mx_playbackDirection
-            ||
-            oldPaused != mx_playbackPaused ) {
+    return mingin_writePersistData( inStoreWriteHandle,
+                                    MAXIGIN_PADDED_INT_LENGTH,
+                                    padded );
+    }
 
-            int  setSpeed  =  mx_playbackSpeed;
 
-            if( mx_playbackPaused ) {
-                setSpeed = 0;
-                }
-            
-            mx_setSoundSpeedAndDirection( setSpeed,
-                                          mx_playbackDirection );
-            }
 
+static char mx_readPaddedIntFromPeristentData( int   inStoreReadHandle,
+                                               int  *outInt ) {
+    
+    int  numRead  =  mingin_readPersistData( inStoreReadHandle,
+                                             MAXIGIN_PADDED_INT_LENGTH,
+                                             mx_intPadding );
 
-        oldPlaybackFrame = mx_playbackCurrentStep;
+    if( numRead != MAXIGIN_PADDED_INT_LENGTH ){
+        return 0;
+        }
 
-        newPlaybackFrame = oldPlaybackFrame;
+    *outInt = maxigin_stringToInt( (char *)mx_intPadding );
+    return 1;
+    }
 
-        playbackSliderActive =
-            maxigin_guiSlider( &mx_internalGUI,
-                               &newPlaybackFrame,
-                               0,
-                               mx_playbackTotalSteps - 1,
-                               -( MAXIGIN_GAME_NATIVE_W / 2 - 20 ),
-                               MAXIGIN_GAME_NATIVE_W / 2 - 20,
-                               MAXIGIN_GAME_NATIVE_H / 2 - 30,
-                               10,
-                               20,
-                               10,
-                               mx_loopPointSteps[ 0 ],
-                               mx_loopPointSteps[ 1 ] );
 
-        if( ! mx_playbackPaused
-            &&
-            playbackSliderActive ) {
-            
-            /* temporarily pause playback while slider moving */
-            
-            mx_playbackPaused = 1;
-            playbackPausedBySlider = 1;
-            mx_playbackSliderActive = 1;
 
-            /* pause sound while slider moving */
-            mx_setSoundSpeedAndDirection( 0,
-                                          mx_playbackDirection );
-            }
-        
+/*
+  Maps a signed int onto an unsigned value, interleaving negative and
+  positive values (0, -1, 1, -2, 2, ...), so that small negative values
+  make short varints.
+*/
+static unsigned long mx_zigZag( int  inInt ) {
+    if( inInt < 0 ) {
+        return ( (unsigned long)( -( inInt + 1 ) ) << 1 ) | 1;
+        }
+    return (unsigned long)inInt << 1;
+    }
 
-        if( mx_playbackSliderActive
-            &&
-            ! playbackSliderActive ) {
-            /* slider was active before, not active now */
 
-            /* unpause sound if necessary */
-            int  setSpeed  =  mx_playbackSpeed;
 
-            if( mx_playbackPaused ) {
-                setSpeed = 0;
-                }
-            
-            mx_setSoundSpeedAndDirection( setSpeed,
-                                          mx_playbackDirection );
+/* inverse of mx_zigZag */
+static int mx_unZigZag( unsigned long  inValue ) {
+    if( inValue & 1 ) {
+        return - (int)( inValue >> 1 ) - 1;
+        }
+    return (int)( inValue >> 1 );
+    }
 
-            mx_playbackSliderActive = 0;
-            }
-        
 
-        if( oldPlaybackFrame != newPlaybackFrame ) {
-            /* slider caused a change */
 
-            mx_playbackJumpToStep( newPlaybackFrame );
-            }
-        }
-    else if( ! mx_menuShowing ) {
-        /* playback not running
-           watch for "reverse playback button"
-           to insta-rewind the current live game from this point back */
+/*
+  Encodes an unsigned value as a LEB128 varint, 7 bits per byte,
+  least significant bits first, with the high bit set on every byte
+  except the last.
 
-        if( mx_isActionFreshPressed( PLAYBACK_REVERSE ) ) {
-            
-            
-            if( mx_recordingRunning ) {
-                
-                char  success  =  0;
-                
-                /* end the recording, copy the recording file into the
-                   playback file, and then start playback from there */
-                
-                mx_finalizeRecording();
-                mx_playbackInterruptedRecording = 1;
-                mx_playbackInstantReverseRecording = 1;
+  Parameters:
 
-                if( mingin_renamePersistData( mx_recordingDataStoreName,
-                                              mx_playbackDataStoreName ) ) {
-                    mingin_log( "Moved recording file into playback file "
-                                "for instant playback.\n" );
-                    success = 1;
-                    }
-                else {
-                    /* simple/quick rename failed, try copying data
-                       between files */
-                    int   recordingLength;
-                    int   recordingHandle;
-                    int   playbackHandle;
+      inValue      the value to encode
 
-                    mingin_log( "Moving recording file failed, trying "
-                                "data copy into playback file instead.\n" );
-                    
-                    recordingHandle =
-                        mingin_startReadPersistData( mx_recordingDataStoreName,
-                                                     &recordingLength );
+      outBytes     buffer where encoded bytes should be written,
+                   must have room for MAXIGIN_MAX_VARINT_LENGTH bytes
+  
+  Returns:
 
-                    if( recordingHandle != -1 ) {
+      number of bytes written
+*/
+static int mx_encodeVarint( unsigned long   inValue,
+                            unsigned char  *outBytes ) {
+    int  n  =  0;
+    
+    while( inValue >= 0x80 ) {
+        outBytes[n] = (unsigned char)( ( inValue & 0x7F ) | 0x80 );
+        inValue >>= 7;
+        n++;
+        }
+    outBytes[n] = (unsigned char)inValue;
+    n++;
 
-                        playbackHandle =
-                            mingin_startWritePersistData(
-                                mx_playbackDataStoreName );
+    return n;
+    }
 
-                        if( playbackHandle != -1 ) {
 
-                            success = mx_copyIntoDataStore( recordingHandle,
-                                                            playbackHandle,
-                                                            recordingLength );
-                        
-                            mingin_endWritePersistData( playbackHandle );
-                            }
-                        
-                        mingin_endReadPersistData( recordingHandle );
 
-                        if( success ) {
-                            mingin_log(
-                                "Copied recording file data into playback file "
-                                "for instant playback.\n" );
-                            
-                            mingin_deletePersistData(
-                                mx_recordingDataStoreName );
-                            }
-                        }
-                    }
-                
-                if( success ) {
-                    
-                    /* we block sound triggers here
-                       because we are initing playback from the first
-                       recorded frame and then
+/*
+  Decodes a LEB128 varint from a buffer.
 
-                       fast-stepping forward to the
-                       last step, and then instant-reversing from there
-                       we don't want recorded sounds to trigger when
-                       we do this init or fast-stepping */
-                    mx_playbackBlockForwardSounds = 1;
-                    
-                    mx_initPlayback();
+  Parameters:
 
-                    /* jump to last step */
-                    mx_playbackJumpToStep( mx_playbackTotalSteps - 1 );
+      inBytes      the buffer to decode from
 
-                    mx_playbackBlockForwardSounds = 0;
+      inNumBytes   length of the buffer
 
-                    
-                    mx_playbackDirection = -1;
-                    mx_playbackSpeed     = 1;
+      ioPos        pointer to position in buffer to decode from,
+                   advanced past the varint on success
 
-                    mx_setSoundSpeedAndDirection( mx_playbackSpeed,
-                                                  mx_playbackDirection );
-                    }
-                else {
-                    /* playback failed for some reason */
+      outValue     pointer to where decoded value should be returned
 
-                    mingin_log( "Instant-reverse playback mid-game failed\n" );
+  Returns:
 
-                    /* start recording again */
-                    
-                    mx_initRecording();
-                    }
-                }
+      1   on success
+
+      0   on failure (varint runs off end of buffer or is too long)
+*/
+static char mx_decodeVarint( const unsigned char  *inBytes,
+                             int                   inNumBytes,
+                             int                  *ioPos,
+                             unsigned long        *outValue ) {
+    unsigned long  value  =  0;
+    int            shift  =  0;
+    int            pos    =  *ioPos;
+    
+    while( pos < inNumBytes
+           &&
+           shift < 7 * MAXIGIN_MAX_VARINT_LENGTH ) {
+
+        unsigned char  b  =  inBytes[ pos ];
+        
+        value |= (unsigned long)( b & 0x7F ) << shift;
+        pos++;
+        
+        if( ! ( b & 0x80 ) ) {
+            *ioPos    = pos;
+            *outValue = value;
+            return 1;
             }
+        shift += 7;
         }
 
-    
+    return 0;
+    }
 
-    if( ! mx_spriteCacheLoaded ) {
-        /* have no last-modified times if sprites loaded from cache */
-        mx_checkSpritesNeedReload();
-        }
-    
-    mx_checkLangNeedsReload();
-    
-    mx_processDoneSoundEffects();
 
-    if( ! mx_menuShowing
-        &&
-        ! mx_playbackSpeedStep() ) {
 
-        if( mx_playbackInterruptedRecording ) {
-            /* playback has ended, resume recording */
-            mx_initRecording();
-            mx_playbackInterruptedRecording = 0;
-            mx_playbackInstantReverseRecording = 0;
+/*
+  Reads a LEB128 varint from a data store.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_readVarintFromPersistData( int             inStoreReadHandle,
+                                          unsigned long  *outValue ) {
+    
+    unsigned char  bytes[ MAXIGIN_MAX_VARINT_LENGTH ];
+    int            n      =  0;
+    int            pos    =  0;
+    
+    while( n < MAXIGIN_MAX_VARINT_LENGTH ) {
+        
+        int  numRead  =  mingin_readPersistData( inStoreReadHandle,
+                                                 1,
+                                                 &( bytes[n] ) );
+        if( numRead != 1 ) {
+            return 0;
             }
+        n++;
         
-        mx_areWeInMaxiginGameStepFunction = 1;
-    
-        maxiginGame_step();
+        if( ! ( bytes[ n - 1 ] & 0x80 ) ) {
+            return mx_decodeVarint( bytes,
+                                    n,
+                                    &pos,
+                                    outValue );
+            }
+        }
+
+    return 0;
+    }
+
+
+
+/*
+  Writes a LEB128 varint to a data store.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writeVarintToPersistData( int            inStoreWriteHandle,
+                                         unsigned long  inValue ) {
     
-        mx_areWeInMaxiginGameStepFunction = 0;
+    unsigned char  bytes[ MAXIGIN_MAX_VARINT_LENGTH ];
+    int            n      =  mx_encodeVarint( inValue,
+                                              bytes );
 
-        mx_stepRecording();
+    return mingin_writePersistData( inStoreWriteHandle,
+                                    n,
+                                    bytes );
+    }
 
-        mx_clearJustStartedSoundEffects();
-        }
 
-    /* if we jumped half-forward or half-back above
-       we set this to 1.
-       But those jumps waited for mx_playbackSpeedStep to actually
-       apply the snapshot after the jump.
-       So we need to leave mx_playbackJumping set until now, so
-       that our music jumps correctly in mx_playbackSpeedStep.
-    */
-    mx_playbackJumping = 0;
 
-    if( playbackPausedBySlider ) {
-        /* unpause temporary playback slider pause */
-        mx_playbackPaused = 0;
+#define  MAXIGIN_FIXED_INT_LENGTH  4
+
+
+/*
+  Encodes a non-negative int as 4 little-endian bytes in outBytes.
+*/
+static void mx_encodeFixedInt( int             inValue,
+                               unsigned char  *outBytes ) {
+    int  i;
+
+    for( i = 0;
+         i < MAXIGIN_FIXED_INT_LENGTH;
+         i ++ ) {
+        
+        outBytes[i] = (unsigned char)( ( (unsigned long)inValue >> ( 8 * i ) )
+                                       & 0xFF );
         }
+    }
+
+
+
+/*
+  Decodes a non-negative int from 4 little-endian bytes.
+*/
+static int mx_decodeFixedInt( const unsigned char  *inBytes ) {
+    
+    unsigned long  value  =  0;
+    int            i;
     
+    for( i = 0;
+         i < MAXIGIN_FIXED_INT_LENGTH;
+         i ++ ) {
+        
+        value |= (unsigned long)inBytes[i] << ( 8 * i );
+        }
 
+    return (int)value;
+    }
 
-    if( mx_menuShowing
-        ||
-        mx_menuFade > 0 ) {
 
-        int            menuPanel;
-        int            fadeStep;
-        int            ySlideInPos;
 
-        ySlideInPos =
-            - MAXIGIN_GAME_NATIVE_H * ( mx_menuFadeMax - mx_menuFade )
-            / mx_menuFadeMax;
-            
-        menuPanel = maxigin_guiStartPanel( &mx_internalGUI,
-                                           0,
-                                           ySlideInPos,
-                                           MAXIGIN_GAME_NATIVE_W - 20,
-                                           MAXIGIN_GAME_NATIVE_H - 40,
-                                           (unsigned char)( mx_menuFade / 10 ) );
+/*
+  Writes a non-negative int to a data store as 4 little-endian bytes.
 
-        mx_populateMenuPanel();
-        
-        maxigin_guiEndPanel( &mx_internalGUI,
-                             menuPanel );
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writeFixedIntToPersistData( int  inStoreWriteHandle,
+                                           int  inValue ) {
+    
+    unsigned char  bytes[ MAXIGIN_FIXED_INT_LENGTH ];
 
-        if( mx_menuShowing
-            &&
-            mx_menuFade < mx_menuFadeMax ) {
-            /* Purho easing function, go 20% of remaining distance */
-            fadeStep = ( mx_menuFadeMax - mx_menuFade ) / 5;
-            if( fadeStep < 1 ) {
-                fadeStep = 1;
-                }
-            
-            mx_menuFade += fadeStep;
-            }
-        else if( ! mx_menuShowing
-                 &&
-                 mx_menuFade > 0 ) {
+    mx_encodeFixedInt( inValue,
+                       bytes );
+    
+    return mingin_writePersistData( inStoreWriteHandle,
+                                    MAXIGIN_FIXED_INT_LENGTH,
+                                    bytes );
+    }
 
-            fadeStep = ( mx_menuFadeMax - mx_menuFade ) / 3;
-            if( fadeStep < 30 ) {
-                fadeStep = 30;
-                }
 
-            if( fadeStep > mx_menuFade ) {
-                mx_menuFade = 0;
-                }
-            else {
-                mx_menuFade -= fadeStep;
-                }
 
-            if( mx_menuFade == 0 ) {
-                mx_langPanelShowing     = 0;
-                mx_controlsPanelShowing = 0;
-                mx_menuReturnForceHot   = 0;
-                mx_internalGUI.forceHot = 0;
-                }
-            } 
-        }
-    
+/*
+  Reads a non-negative int from 4 little-endian bytes in a data store.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_readFixedIntFromPersistData( int   inStoreReadHandle,
+                                            int  *outValue ) {
     
-    maxigin_endGUI( &mx_internalGUI );
+    unsigned char  bytes[ MAXIGIN_FIXED_INT_LENGTH ];
+    int            numRead;
+
+    numRead = mingin_readPersistData( inStoreReadHandle,
+                                      MAXIGIN_FIXED_INT_LENGTH,
+                                      bytes );
+
+    if( numRead != MAXIGIN_FIXED_INT_LENGTH ) {
+        return 0;
+        }
+
+    *outValue = mx_decodeFixedInt( bytes );
     
+    return 1;
     }
 
 
 
-static  MinginButton  mx_quitMapping[] = { MGN_KEY_Q,
-                                           MGN_MAP_END };
+static  const char  *mx_spriteCacheName  =  "maxigin_spriteCache.bin";
 
-static  MinginButton  mx_menuMapping[] = { MGN_KEY_ESCAPE,
-                                           MGN_BUTTON_XBOX_GUIDE,
-                                           MGN_BUTTON_XBOX_START,
-                                           MGN_BUTTON_PS_PS,
-                                           MGN_BUTTON_PS_OPTIONS,
-                                           MGN_MAP_END };
 
-static  MinginButton  mx_menuBackMapping[] = { MGN_BUTTON_XBOX_B,
-                                               MGN_BUTTON_PS_CIRCLE,
-                                               MGN_BUTTON_XBOX_BACK,
-                                               MGN_MAP_END };
+static void mx_spriteCacheReadFailed( int  inReadHandle ) {
+    mingin_endReadPersistData( inReadHandle );
 
-static  MinginButton  mx_menuUpMapping[] = { MGN_BUTTON_DPAD_UP,
-                                             MGN_MAP_END };
+    mingin_deletePersistData( mx_spriteCacheName );
 
-static  MinginButton  mx_menuDownMapping[] = { MGN_BUTTON_DPAD_DOWN,
-                                               MGN_MAP_END };
+    mx_numSpriteBytesUsed = 0;
+    mx_numSprites         = 0;
+    mx_numStripSubSprites = 0;
+    mx_numSpriteStrips    = 0;
 
-static  MinginStick  mx_menuStickNavMapping[] = { MGN_STICK_LEFT_Y,
-                                                  MGN_STICK_RIGHT_Y,
-                                                  MGN_MAP_END };
+    mingin_log( "Failed to read from sprite cache: " );
+    mingin_log( mx_spriteCacheName );
+    mingin_log( "\n" );
+    }
 
-static  MinginButton  mx_menuPickMapping[] = { MGN_BUTTON_XBOX_A,
-                                               MGN_BUTTON_XBOX_X,
-                                               MGN_BUTTON_XBOX_Y,
-                                               MGN_BUTTON_L1,
-                                               MGN_BUTTON_R1,
-                                               MGN_BUTTON_L2,
-                                               MGN_BUTTON_R2,
-                                               MGN_BUTTON_PS_SQUARE,
-                                               MGN_BUTTON_PS_TRIANGLE,
-                                               MGN_BUTTON_PS_X,
-                                               MGN_MAP_END };
 
-static  MinginButton  mx_fullscreenMapping[] = { MGN_KEY_F,
-                                                 MGN_MAP_END };
 
-static  MinginButton  mx_crtMapping[] = { MGN_KEY_C,
-                                          MGN_MAP_END };
+static void mx_initSpriteCache( void ) {
 
-static  MinginButton  mx_langSwitchMapping[] = { MGN_KEY_L,
-                                                 MGN_MAP_END };
+    int  numBytes;
+    int  readHandle;
 
-static  MinginButton  mx_mouseButtonMapping[] = { MGN_BUTTON_MOUSE_LEFT,
-                                                  MGN_MAP_END };
+    if( maxigin_readFlagSetting( "maxigin_disableSpriteCache.ini",
+                                 0 ) ) {
+        /* if we're in development and hot-reloading a bunch of sprites
+           while working on them, we might set this flag.
+           That means the cache is likely stale, so delete it for now,
+           until the flag is turned off later and the cache can be regenerated */
+        
+        mingin_deletePersistData( mx_spriteCacheName );
+        
+        return;
+        }
 
-static  MinginButton  mx_sliderIncreaseMapping[] = { MGN_KEY_RIGHT,
-                                                     MGN_BUTTON_DPAD_RIGHT,
-                                                     MGN_MAP_END };
+    readHandle =  mingin_startReadPersistData( mx_spriteCacheName,
+                                               &numBytes );
 
-static  MinginButton  mx_sliderDecreaseMapping[] = { MGN_KEY_LEFT,
-                                                     MGN_BUTTON_DPAD_LEFT,
-                                                     MGN_MAP_END };
+    if( readHandle != -1 ) {
 
-static  MinginButton  mx_playbackMappings[8][2] =
-    { { MGN_KEY_BACKSLASH, MGN_MAP_END },   /* start-stop */
-      { MGN_KEY_EQUAL,     MGN_MAP_END },   /* faster */
-      { MGN_KEY_MINUS,     MGN_MAP_END },   /* slower */
-      { MGN_KEY_0,         MGN_MAP_END },   /* pause */
-      { MGN_KEY_9,         MGN_MAP_END },   /* normal speed */
-      { MGN_KEY_8,         MGN_MAP_END },   /* reverse playback */
-      { MGN_KEY_BRACKET_L, MGN_MAP_END },   /* jump back */
-      { MGN_KEY_BRACKET_R, MGN_MAP_END } }; /* jump ahead */
+        int  readInt;
+        
+        if( ! mx_readIntFromPersistData( readHandle,
+                                         & mx_numSpriteBytesUsed ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
+        
+        if( mx_numSpriteBytesUsed
+            !=
+            mingin_readPersistData(
+                readHandle,
+                mx_numSpriteBytesUsed,
+                mx_spriteBytes ) ) {
+                
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
+        if( ! mx_readIntFromPersistData( readHandle,
+                                         &readInt ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
-static  MinginButton  mx_hideGuiMapping[]  = { MGN_KEY_H,
-                                               MGN_MAP_END };
+        if( readInt != sizeof( MaxiginSprite ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
+        
+        if( ! mx_readIntFromPersistData( readHandle,
+                                         &mx_numSprites ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
 
-static  MinginButton  mx_addLoopPointMapping[]     = { MGN_KEY_P,
-                                                       MGN_MAP_END };
+        if( mx_numSprites * (int)sizeof( MaxiginSprite )
+            !=
+            mingin_readPersistData(
+                readHandle,
+                mx_numSprites * (int)sizeof( MaxiginSprite ),
+                (unsigned char *)mx_sprites ) ) {
+                
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
-static  MinginButton  mx_clearLoopPointsMapping[]  = { MGN_KEY_O,
-                                                       MGN_MAP_END };
 
+        if( ! mx_readIntFromPersistData( readHandle,
+                                         &readInt ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
-static  MinginStick  mx_sliderStickMapping[] = { MGN_STICK_LEFT_X,
-                                                 MGN_STICK_RIGHT_X,
-                                                 MGN_MAP_END };
+        if( readInt != (int)sizeof( int ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
+        if( ! mx_readIntFromPersistData( readHandle,
+                                         &mx_numStripSubSprites ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
-static void mx_clearTranslationKeys( void );
+        if( mx_numStripSubSprites * (int)sizeof( int )
+            !=
+            mingin_readPersistData(
+                readHandle,
+                mx_numStripSubSprites * (int)sizeof( int ),
+                (unsigned char *)mx_stripSubSprites ) ) {
+                
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
-static  void mx_initLanguages( void );
+        if( ! mx_readIntFromPersistData( readHandle,
+                                         &readInt ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
-static int          mx_lang_settings;
-static int          mx_lang_newGame;
-static int          mx_lang_quit;
-static int          mx_lang_resume;
-static int          mx_lang_musicVolume;
-static int          mx_lang_effectsVolume;
-static int          mx_lang_fullscreen;
-static int          mx_lang_languages;
-static int          mx_lang_controls;
-static int          mx_lang_back;
-static int          mx_lang_press;
-static int          mx_lang_defaults;
+        if( readInt != (int)sizeof( MaxiginSpriteStrip ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
+        if( ! mx_readIntFromPersistData( readHandle,
+                                         &mx_numSpriteStrips ) ) {
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
-/* smaller scale for sound effects, since the volume only applies
-   per play and doesn't do smooth fades */
-#define       MAXIGIN_MAX_SOUND_LOUDNESS           512
+        if( mx_numSpriteStrips * (int)sizeof( MaxiginSpriteStrip )
+            !=
+            mingin_readPersistData(
+                readHandle,
+                mx_numSpriteStrips * (int)sizeof( MaxiginSpriteStrip ),
+                (unsigned char *)mx_spriteStrips ) ) {
+                
+            mx_spriteCacheReadFailed( readHandle );
+            return;
+            }
 
-/* larger scale for music, since we smoothly fade to target volume */
-#define       MAXIGIN_MAX_MUSIC_LOUDNESS           8192
+        mingin_endReadPersistData( readHandle );
 
-static  int   mx_soundEffectsVolume             =  MAXIGIN_MAX_SOUND_LOUDNESS;
-static  int   mx_musicVolume                    =  MAXIGIN_MAX_MUSIC_LOUDNESS;
-static  int   mx_musicVolumeTarget              =  MAXIGIN_MAX_MUSIC_LOUDNESS;
 
+        mx_spriteCacheLoaded           = 1;
+        mx_nextCachedSpriteHandle      = 0;
+        mx_nextCachedSpriteStripHandle = 0;
 
-static  int          mx_buttonPhraseKeys[ MINGIN_NUM_BUTTON_MAPPINGS ];
+        mingin_log( "Loaded cached sprite data.\n" );
+        }
 
+    }
 
-static void mx_loadButtonMapping( const char  *inStoreName );
 
-static void mx_saveButtonMapping( const char  *inStoreName );
 
+static void mx_spriteCacheWriteFailed( int  inWriteHandle ) {
+    mingin_endWritePersistData( inWriteHandle );
 
+    mingin_deletePersistData( mx_spriteCacheName );
 
-static void mx_gameInit( void ) {
+    mingin_log( "Failed to write to sprite cache: " );
+    mingin_log( mx_spriteCacheName );
+    mingin_log( "\n" );
+    }
 
-    int  p;
-    int  i;
     
-    mx_enableAutoQuit = maxigin_readFlagSetting( "maxigin_enableAutoQuit.ini",
-                                                 0 );
-
+static void mx_finalizeSpriteCache( void ) {
 
-    mx_soundEffectsVolume =
-        maxigin_readIntSetting( "maxigin_soundEffectsVolume.ini",
-                                MAXIGIN_MAX_SOUND_LOUDNESS );
-    mx_musicVolume =
-        maxigin_readIntSetting( "maxigin_musicVolume.ini",
-                                MAXIGIN_MAX_MUSIC_LOUDNESS );
+    if( maxigin_readFlagSetting( "maxigin_disableSpriteCache.ini",
+                                 0 ) ) {
+        return;
+        }
 
-    mx_musicVolumeTarget = mx_musicVolume;
+    if( mx_spriteCacheBad ) {
+        mingin_log( "Deleting bad sprite cache.  Cache will be regenerated on "
+                    "next run.\n" );
+        mingin_deletePersistData( mx_spriteCacheName );
+        }
 
-    for( i = 0;
-         i < MINGIN_NUM_BUTTON_MAPPINGS;
-         i ++ ) {
+    if( ! mx_spriteCacheLoaded ) {
 
-        mx_buttonPhraseKeys[i] = -1;
-        
-        }
-    
-    
-    mingin_registerButtonMapping( QUIT,
-                                  mx_quitMapping );
-    
-    mingin_registerButtonMapping( MENU,
-                                  mx_menuMapping );
-    
-    mingin_registerButtonMapping( MENU_BACK,
-                                  mx_menuBackMapping );
+        /* generate a new sprite cache and save it */
 
-    mingin_registerButtonMapping( MENU_UP,
-                                  mx_menuUpMapping );
+        int   writeHandle  =  mingin_startWritePersistData( mx_spriteCacheName );
 
-    mingin_registerButtonMapping( MENU_DOWN,
-                                  mx_menuDownMapping );
+        mingin_log( "Regenerating new sprite cache from good sprite data.\n" );
+        
+        if( writeHandle != -1 ) {
 
-    mingin_registerStickAxis( MENU_STICK_NAV,
-                              mx_menuStickNavMapping );
+            if( ! mx_writeIntToPeristentData( writeHandle,
+                                              mx_numSpriteBytesUsed ) ) {
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
 
-    mingin_registerButtonMapping( MENU_PICK,
-                                  mx_menuPickMapping );
-    
-    mingin_registerButtonMapping( FULLSCREEN_TOGGLE,
-                                  mx_fullscreenMapping );
+            if( ! mingin_writePersistData( writeHandle,
+                                           mx_numSpriteBytesUsed,
+                                           mx_spriteBytes ) ) {
+                
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
 
-    mingin_registerButtonMapping( CRT_TOGGLE,
-                                  mx_crtMapping );
-    
-    mingin_registerButtonMapping( LANG_SWITCH,
-                                  mx_langSwitchMapping );
+            if( ! mx_writeIntToPeristentData( writeHandle,
+                                              (int)sizeof( MaxiginSprite ) ) ) {
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
+            
+            if( ! mx_writeIntToPeristentData( writeHandle,
+                                              mx_numSprites ) ) {
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
 
-    mingin_registerButtonMapping( MAXIGIN_MOUSE_BUTTON,
-                                  mx_mouseButtonMapping );
+            if( ! mingin_writePersistData(
+                    writeHandle,
+                    mx_numSprites * (int)sizeof( MaxiginSprite ),
+                    (unsigned char *)mx_sprites ) ) {
+                
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
 
-    mingin_registerButtonMapping( MAXIGIN_SLIDER_INCREASE,
-                                  mx_sliderIncreaseMapping );
-    
-    mingin_registerButtonMapping( MAXIGIN_SLIDER_DECREASE,
-                                  mx_sliderDecreaseMapping );
+            if( ! mx_writeIntToPeristentData( writeHandle,
+                                              (int)sizeof( int ) ) ) {
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
+            
+            if( ! mx_writeIntToPeristentData( writeHandle,
+                                              mx_numStripSubSprites ) ) {
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
+            
+            if( ! mingin_writePersistData(
+                    writeHandle,
+                    mx_numStripSubSprites * (int)sizeof( int ),
+                    (unsigned char *)mx_stripSubSprites ) ) {
+                
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
 
-    for( p =  PLAYBACK_START_STOP;
-         p <= PLAYBACK_JUMP_HALF_AHEAD;
-         p ++ ) {
-        
-        mingin_registerButtonMapping(
-            p,
-            mx_playbackMappings[ p - PLAYBACK_START_STOP ] );
-        }
+            if( ! mx_writeIntToPeristentData(
+                    writeHandle,
+                    (int)sizeof( MaxiginSpriteStrip ) ) ) {
+                
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
+            
+            if( ! mx_writeIntToPeristentData( writeHandle,
+                                              mx_numSpriteStrips ) ) {
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
 
-    mingin_registerButtonMapping( MAXIGIN_HIDE_GUI,
-                                  mx_hideGuiMapping );
+            if( ! mingin_writePersistData(
+                    writeHandle,
+                    mx_numSpriteStrips * (int)sizeof( MaxiginSpriteStrip ),
+                    (unsigned char *)mx_spriteStrips ) ) {
+                
+                mx_spriteCacheWriteFailed( writeHandle );
+                return;
+                }
 
-    mingin_registerButtonMapping( MAXIGIN_ADD_LOOP_POINT,
-                                  mx_addLoopPointMapping );
-    
-    mingin_registerButtonMapping( MAXIGIN_CLEAR_LOOP_POINTS,
-                                  mx_clearLoopPointsMapping );
+            if( ! mingin_endWritePersistData( writeHandle ) ) {
+                /* already ended, just clean up */
+                mingin_deletePersistData( mx_spriteCacheName );
 
-    /* all buttons start out unpressed */
-    for( p = QUIT;
-         p < LAST_MAXIGIN_USER_ACTION;
-         p ++ ) {
-        
-        mx_buttonsDown[ p ] = 0;
+                mingin_log( "Failed to finish writing sprite cache: " );
+                mingin_log( mx_spriteCacheName );
+                mingin_log( "\n" );
+                }
+            }
         }
+    }
 
 
-    mingin_registerStickAxis( MAXIGIN_STICK_SLIDER,
-                              mx_sliderStickMapping );
-
-    /* all translation keys start empty */
-    mx_clearTranslationKeys();
 
-    
-    
-    mx_areWeInMaxiginGameInitFunction = 1;
-    
-    maxigin_initGUI( &mx_internalGUI );
+/*
+  Saved games (and the start of recordings) are binary:
+
+      "MXSAVE2" header string, including \0
+      4-byte little-endian int total bytes of memory records
+      4-byte little-endian int number of memory records
+      fingerprint of memory record descriptions, as a \0-terminated
+      hex string
+      4-byte little-endian int size of each memory record
+      memory records, end-to-end
+      flexHash of memory records, MAXIGIN_SAVE_HASH_LENGTH bytes
+
+  Older saved games started with the total bytes as a \0-terminated
+  decimal string, and can still be restored.
+*/
+static  const char  *mx_saveGameMagicHeader         =  "MXSAVE2";
 
-    mx_initSpriteCache();
-    
-    maxiginGame_init();
+static  const char  *mx_saveGameNewDataStoreName    =  "maxigin_saveNew.bin";
 
-    /* we save the default dynamic buttons that the game has asked for */
-    mx_saveButtonMapping( "maxigin_defaultButtons.ini" );
+#define  MAXIGIN_SAVE_HASH_LENGTH  8
 
-    /* now we load any overwritten dynamic button
-       settings that were saved through
-       our menu in the past */
-    mx_loadButtonMapping( "maxigin_savedButtons.ini" );
-    
+/* room for header string, counts, fingerprint, and record sizes */
+#define  MAXIGIN_SAVE_HEADER_MAX_BYTES                                   \
+            ( 64 + MAXIGIN_FIXED_INT_LENGTH * MAXIGIN_MAX_MEM_RECORDS )
 
-    /* our own internal translation keys */
-    mx_lang_settings      = maxigin_initTranslationKey( "settings" );
-    mx_lang_newGame       = maxigin_initTranslationKey( "newGame"  );
-    mx_lang_quit          = maxigin_initTranslationKey( "quit" );
-    mx_lang_resume        = maxigin_initTranslationKey( "resume" );
-    mx_lang_musicVolume   = maxigin_initTranslationKey( "musicVolume" );
-    mx_lang_effectsVolume = maxigin_initTranslationKey( "effectsVolume" );
-    mx_lang_fullscreen    = maxigin_initTranslationKey( "fullscreen" );
-    mx_lang_languages     = maxigin_initTranslationKey( "languages" );
-    mx_lang_controls      = maxigin_initTranslationKey( "controls" );
-    mx_lang_back          = maxigin_initTranslationKey( "back" );
-    mx_lang_press         = maxigin_initTranslationKey( "press" );
-    mx_lang_defaults      = maxigin_initTranslationKey( "defaults" );
 
-    /* game set any translation keys during init, now we can load languages
-       based on those keys */
-    mx_initLanguages();
 
-    
-    mx_finalizeSpriteCache();
+/*
+  Writes everything before the memory records into a buffer.
 
+  Returns number of bytes written.
+*/
+static int mx_encodeSaveGameHeader( unsigned char  *outBuffer ) {
     
-    /* leave init flag set until here, b/c init languages loads sprites, etc */
-    mx_areWeInMaxiginGameInitFunction = 0;
+    char  *fingerprint;
+    int    numTotalBytes;
+    int    pos            =  0;
+    int    len;
+    int    i;
 
-    
-    mx_recordingCrashRecovery();
+    fingerprint = mx_getMemRecordsFingerprint( &numTotalBytes );
 
-    mx_initRecording();
+    len = maxigin_stringLength( mx_saveGameMagicHeader ) + 1;
+    
+    mx_copyBytes( &( outBuffer[ pos ] ),
+                  (const unsigned char*)mx_saveGameMagicHeader,
+                  len );
+    pos += len;
 
+    mx_encodeFixedInt( numTotalBytes,
+                       &( outBuffer[ pos ] ) );
+    pos += MAXIGIN_FIXED_INT_LENGTH;
 
-    /* supress warning
-       this function generally only called when debugging */
-    if( 0 ) {
-        mx_dumpSpriteRGBA( 0 );
+    mx_encodeFixedInt( mx_numMemRecords,
+                       &( outBuffer[ pos ] ) );
+    pos += MAXIGIN_FIXED_INT_LENGTH;
+    
+    len = maxigin_stringLength( fingerprint ) + 1;
+    
+    mx_copyBytes( &( outBuffer[ pos ] ),
+                  (const unsigned char*)fingerprint,
+                  len );
+    pos += len;
 
-        mx_dumpRGBPixels( 0,
-                          0,
-                          0 );
+    for( i = 0;
+         i < mx_numMemRecords;
+         i ++ ) {
+        
+        mx_encodeFixedInt( mx_memRecords[i].numBytes,
+                           &( outBuffer[ pos ] ) );
+        pos += MAXIGIN_FIXED_INT_LENGTH;
         }
+    
+    return pos;
     }
 
 
 
+/* returns 1 on success, 0 on failure */
+static char mx_saveGameToDataStore( int  inStoreWriteHandle ) {
+    
+    static  unsigned char  header[ MAXIGIN_SAVE_HEADER_MAX_BYTES ];
 
+    unsigned char          hash[ MAXIGIN_SAVE_HASH_LENGTH ];
+    MaxiginFlexHashState   s;
+    int                    headerLength;
+    char                   success;
+    int                    i;
 
+    headerLength = mx_encodeSaveGameHeader( header );
 
-char maxigin_registerButtonMapping( int                 inButtonHandle,
-                                    const MinginButton  inMapping[] ) {
+    success = mingin_writePersistData( inStoreWriteHandle,
+                                       headerLength,
+                                       header );
 
-    char  returnV;
+    if( ! success ) {
+        
+MAXIGIN_SAVED_GAME_WRITE_FAILURE:
+        
+        maxigin_logString( "Failed to write to saved game data: ",
+                           mx_saveGameDataStoreName );
+        return 0;
+        }
+
+    maxigin_flexHashInit( &s,
+                          MAXIGIN_SAVE_HASH_LENGTH,
+                          hash );
     
-    /* push it up so it doesn't interfere with our mappings */
-    inButtonHandle += LAST_MAXIGIN_USER_ACTION;
+    /* write memory regions straight from where they live */
+    for( i = 0;
+         i < mx_numMemRecords;
+         i ++ ) {
+        
+        success = mingin_writePersistData(
+            inStoreWriteHandle,
+            mx_memRecords[i].numBytes,
+            (unsigned char*)mx_memRecords[i].pointer );
+        
+        if( ! success ) {
+            goto MAXIGIN_SAVED_GAME_WRITE_FAILURE;
+            }
 
-    returnV = mingin_registerButtonMapping( inButtonHandle,
-                                            inMapping );
-    if( returnV ) {
-        mx_buttonPhraseKeys[ inButtonHandle ] = -1;
+        maxigin_flexHashAdd( &s,
+                             mx_memRecords[i].numBytes,
+                             (unsigned char*)mx_memRecords[i].pointer );
         }
 
-    return returnV;
-    }
+    maxigin_flexHashFinish( &s );
 
+    success = mingin_writePersistData( inStoreWriteHandle,
+                                       MAXIGIN_SAVE_HASH_LENGTH,
+                                       hash );
+    
+    if( ! success ) {
+        goto MAXIGIN_SAVED_GAME_WRITE_FAILURE;
+        }
+    
+    return 1;
+    }
 
 
-char maxigin_registerDynamicButtonMapping( int                 inButtonHandle,
-                                           const MinginButton  inMapping[],
-                                           int                 inPhraseKey ) {
 
-    char  returnV;
+static void mx_saveGame( void ) {
     
-    /* push it up so it doesn't interfere with our mappings */
-    inButtonHandle += LAST_MAXIGIN_USER_ACTION;
-
-    returnV = mingin_registerButtonMapping( inButtonHandle,
-                                            inMapping );
-    if( returnV ) {
-        mx_buttonPhraseKeys[ inButtonHandle ] = inPhraseKey;
+    int   outHandle;
+    char  success;
+    
+    if( mx_numMemRecords == 0 ) {
+        return;
         }
 
-    return returnV;
-    }
-
+    /* write into a new store, and then swap it into place, so a
+       crash or failure mid-save never leaves a broken saved game behind */
+    outHandle = mingin_startWritePersistData( mx_saveGameNewDataStoreName );
 
+    if( outHandle == -1 ) {
+        maxigin_logString( "Failed to open saved game for writing: ",
+                           mx_saveGameNewDataStoreName );
+        return;
+        }
 
-char maxigin_isButtonDown( int  inButtonHandle ) {
+    success = mx_saveGameToDataStore( outHandle );
     
-    /* push it up so it doesn't interfere with our mappings */
-    inButtonHandle += LAST_MAXIGIN_USER_ACTION;
+    /* a failed final flush means the new save is cut off */
+    if( ! mingin_endWritePersistData( outHandle ) ) {
+        maxigin_logString( "Failed to finish writing saved game: ",
+                           mx_saveGameNewDataStoreName );
+        success = 0;
+        }
 
-    return mingin_isButtonDown( inButtonHandle );
-    }
+    if( ! success ) {
+        mingin_deletePersistData( mx_saveGameNewDataStoreName );
+        return;
+        }
 
+    if( ! mingin_renamePersistData( mx_saveGameNewDataStoreName,
+                                    mx_saveGameDataStoreName ) ) {
 
+        /* writing over the old one in place could leave nothing good
+           behind, so keep it */
+        maxigin_logString( "Swapping new saved game into place failed, "
+                           "keeping old saved game: ",
+                           mx_saveGameDataStoreName );
 
-MinginButton maxigin_getPlatformPrimaryButton( int  inButtonHandle ) {
-    /* push it up so it doesn't interfere with our mappings */
-    inButtonHandle += LAST_MAXIGIN_USER_ACTION;
+        mingin_deletePersistData( mx_saveGameNewDataStoreName );
+        return;
+        }
 
-    return mingin_getPlatformPrimaryButton( inButtonHandle );
+    mingin_log( "Saved game.\n" );
     }
 
 
 
+/*
+  Reads the hash that follows saved memory.
 
-char maxigin_getPointerLocation( int  *outX,
-                                 int  *outY ) {
-    int   rawX;
-    int   rawY;
-    int   maxX;
-    int   maxY;
-    char  avail;
-    int   scaleFactor;
-    int   offsetX;
-    int   offsetY;
-        
-    avail = mingin_getPointerLocation( &rawX,
-                                       &rawY,
-                                       &maxX,
-                                       &maxY );
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_readSavedMemoryHash( int             inStoreReadHandle,
+                                    unsigned char  *outHash ) {
 
-    if( ! avail ) {
+    int  numRead  =  mingin_readPersistData( inStoreReadHandle,
+                                             MAXIGIN_SAVE_HASH_LENGTH,
+                                             outHash );
+
+    if( numRead != MAXIGIN_SAVE_HASH_LENGTH ) {
+        mingin_log( "Failed to read hash from save data.\n" );
         return 0;
         }
 
-    mx_computeScaling( maxX,
-                       maxY,
-                       & scaleFactor,
-                       & offsetX,
-                       & offsetY );
-
-    rawX -= offsetX;
-    rawX /= scaleFactor;
+    return 1;
+    }
 
-    rawY -= offsetY;
-    rawY /= scaleFactor;
 
-    *outX = rawX;
-    *outY = rawY;
 
+/* returns 1 if two MAXIGIN_SAVE_HASH_LENGTH hashes match */
+static char mx_hashesEqual( const unsigned char  *inHashA,
+                            const unsigned char  *inHashB ) {
+    int  i;
+    
+    for( i = 0;
+         i < MAXIGIN_SAVE_HASH_LENGTH;
+         i ++ ) {
+        
+        if( inHashA[i] != inHashB[i] ) {
+            return 0;
+            }
+        }
     return 1;
     }
 
 
 
-char maxigin_registerStickAxis( int                inStickAxisHandle,
-                                const MinginStick  inMapping[] ) {
+/*
+  Hashes saved memory at the current position in a data store without
+  restoring any of it, and checks it against the hash that follows.
+
+  Leaves the data store back at the start of the saved memory.
+  
+  Returns 1 if the hash matches, 0 if not or on failure.
+*/
+static char mx_checkSavedMemoryHash( int  inStoreReadHandle,
+                                     int  inNumTotalBytes ) {
     
-    inStickAxisHandle += LAST_MAXIGIN_STICK;
+    enum{  CHUNK_LEN  =  512  };
+    
+    static  unsigned char  chunk[ CHUNK_LEN ];
+    
+    unsigned char          hash[ MAXIGIN_SAVE_HASH_LENGTH ];
+    unsigned char          readHash[ MAXIGIN_SAVE_HASH_LENGTH ];
+    MaxiginFlexHashState   s;
+    int                    dataStartPos;
+    int                    numHashed     =  0;
+    int                    numRead;
 
-    return mingin_registerStickAxis( inStickAxisHandle,
-                                     inMapping );
-    }
+    dataStartPos = mingin_getPersistDataPosition( inStoreReadHandle );
+
+    if( dataStartPos == -1 ) {
+        return 0;
+        }
+    
+    maxigin_flexHashInit( &s,
+                          MAXIGIN_SAVE_HASH_LENGTH,
+                          hash );
+    
+    while( numHashed < inNumTotalBytes ) {
+        
+        int  numThisTime  =  inNumTotalBytes - numHashed;
 
+        if( numThisTime > CHUNK_LEN ) {
+            numThisTime = CHUNK_LEN;
+            }
 
+        numRead = mingin_readPersistData( inStoreReadHandle,
+                                          numThisTime,
+                                          chunk );
+        
+        if( numRead != numThisTime ) {
+            mingin_log( "Failed to read memory data from save data.\n" );
+            return 0;
+            }
+        
+        maxigin_flexHashAdd( &s,
+                             numRead,
+                             chunk );
+        numHashed += numRead;
+        }
 
-char maxigin_getStickPosition( int   inStickAxisHandle,
-                               int  *outPosition,
-                               int  *outLowerLimit,
-                               int  *outUpperLimit ) {
+    maxigin_flexHashFinish( &s );
 
-    inStickAxisHandle += LAST_MAXIGIN_STICK;
+    if( ! mx_readSavedMemoryHash( inStoreReadHandle,
+                                  readHash ) ) {
+        return 0;
+        }
+    
+    if( ! mx_hashesEqual( hash,
+                          readHash ) ) {
+        mingin_log( "Save data does not match its hash, ignoring.\n" );
+        return 0;
+        }
 
-    return mingin_getStickPosition( inStickAxisHandle,
-                                    outPosition,
-                                    outLowerLimit,
-                                    outUpperLimit );
+    return mingin_seekPersistData( inStoreReadHandle,
+                                   dataStartPos );
     }
 
 
 
+/*
+  Restores memory from binary saved game data, after the "MXSAVE2" header
+  string has been read.
 
+  Each memory record is read straight into place, and hashed as it lands.
+  Memory is copied aside first, and put back if the hash doesn't match.
+  If there's no room to copy memory aside, the hash is checked before
+  any memory is touched instead, which means reading saved memory twice.
 
-typedef struct MaxiginMemRec {
-        void        *pointer;
-        int          numBytes;
-        const char  *description;
-    } MaxiginMemRec;
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_restoreStaticMemoryFromBinaryData( int  inStoreReadHandle ) {
+    
+    static  unsigned char  sizes[ MAXIGIN_FIXED_INT_LENGTH
+                                  * MAXIGIN_MAX_MEM_RECORDS ];
+
+    unsigned char          hash[ MAXIGIN_SAVE_HASH_LENGTH ];
+    unsigned char          readHash[ MAXIGIN_SAVE_HASH_LENGTH ];
+    MaxiginFlexHashState   s;
+    char                  *fingerprint;
+    const char            *readFingerprint;
+    int                    numTotalBytes;
+    int                    readNumTotalBytes;
+    int                    readNumMemRecords;
+    int                    numRead;
+    char                   haveBackup;
+    int                    i;
 
+    fingerprint = mx_getMemRecordsFingerprint( &numTotalBytes );
 
-#define  MAXIGIN_MAX_MEM_RECORDS  1024
+    if( ! mx_readFixedIntFromPersistData( inStoreReadHandle,
+                                          &readNumTotalBytes )
+        ||
+        ! mx_readFixedIntFromPersistData( inStoreReadHandle,
+                                          &readNumMemRecords ) ) {
+        mingin_log( "Failed to read memory sizes from save data.\n" );
+        return 0;
+        }
+
+    if( readNumTotalBytes != numTotalBytes
+        ||
+        readNumMemRecords != mx_numMemRecords ) {
+        
+        mingin_log( "Save data does not match current memory records, "
+                    "ignoring.\n" );
+        
+        maxigin_logInt2( "Save data has numTotalBytes = ",
+                         readNumTotalBytes,
+                         ", mx_numMemRecords = ",
+                         readNumMemRecords,
+                         "" );
+        
+        maxigin_logInt2( "Current live numTotalBytes = ",
+                         numTotalBytes,
+                         ", mx_numMemRecords = ",
+                         mx_numMemRecords,
+                         "" );
+        return 0;
+        }
+
+    readFingerprint = mx_readShortStringFromPersistData( inStoreReadHandle );
+    
+    if( readFingerprint == 0 ) {
+        mingin_log( "Failed to read fingerprint from save data.\n" );
+        return 0;
+        }
+    
+    if( ! maxigin_stringsEqual( fingerprint,
+                                readFingerprint ) ) {
+        
+        mingin_log( "Save data does not match current memory fingerprint, "
+                    "ignoring.\n" );
+        
+        maxigin_logString( "Save data has fingerprint = ",
+                           readFingerprint );
+        
+        maxigin_logString( "Current live has fingerprint = ",
+                           fingerprint );
+        
+        return 0;
+        }
+
+    numRead = mingin_readPersistData( inStoreReadHandle,
+                                      MAXIGIN_FIXED_INT_LENGTH
+                                      * mx_numMemRecords,
+                                      sizes );
+
+    if( numRead != MAXIGIN_FIXED_INT_LENGTH * mx_numMemRecords ) {
+        mingin_log( "Failed to read record sizes from save data.\n" );
+        return 0;
+        }
+    
+    for( i = 0;
+         i < mx_numMemRecords;
+         i ++ ) {
+
+        int  readNumBytes  =
+                 mx_decodeFixedInt( &( sizes[ i * MAXIGIN_FIXED_INT_LENGTH ] ) );
+        
+        if( readNumBytes != mx_memRecords[i].numBytes ) {
+            maxigin_logInt2( "Save data has wrong numBytes for record # ",
+                             i,
+                             ": ",
+                             readNumBytes,
+                             "" );
+            
+            maxigin_logString( "Live description = ",
+                               mx_memRecords[i].description );
+            return 0;
+            }
+        }
+
+
+    haveBackup = mx_backupMemoryRecords();
+
+    if( ! haveBackup ) {
+        /* no room to keep a copy of memory, so the hash has to be
+           checked before we touch it */
+        if( ! mx_checkSavedMemoryHash( inStoreReadHandle,
+                                       numTotalBytes ) ) {
+            return 0;
+            }
+        }
+    
+    /* read each memory record straight into place, hashing as it lands */
+    maxigin_flexHashInit( &s,
+                          MAXIGIN_SAVE_HASH_LENGTH,
+                          hash );
+    
+    for( i = 0;
+         i < mx_numMemRecords;
+         i ++ ) {
+        
+        numRead = mingin_readPersistData(
+            inStoreReadHandle,
+            mx_memRecords[i].numBytes,
+            (unsigned char*)mx_memRecords[i].pointer );
+        
+        if( numRead != mx_memRecords[i].numBytes ) {
+            maxigin_logInt(
+                "Failed to read memory data from save data for record # = ", i );
 
-static  MaxiginMemRec  mx_memRecords[ MAXIGIN_MAX_MEM_RECORDS ];
+            if( haveBackup ) {
+                mx_restoreMemoryRecordsBackup();
+                }
+            return 0;
+            }
 
-static  int            mx_numMemRecords            =  0;
-static  int            mx_totalMemoryRecordsBytes  =  0;
+        maxigin_flexHashAdd( &s,
+                             numRead,
+                             (unsigned char*)mx_memRecords[i].pointer );
+        }
 
+    maxigin_flexHashFinish( &s );
 
-void maxigin_initRegisterStaticMemory( void        *inPointer,
-                                       int          inNumBytes,
-                                       const char  *inDescription ) {
-    
-    if( ! mx_areWeInMaxiginGameInitFunction ) {
-        mingin_log( "Game tried to call maxigin_initRegisterStaticMemory "
-                    "from outside of maxiginGame_init\n" );
-        return;
+    if( ! haveBackup ) {
+        /* already checked, just get past the hash */
+        return mx_readSavedMemoryHash( inStoreReadHandle,
+                                       readHash );
         }
     
-    if( mx_numMemRecords >= MAXIGIN_MAX_MEM_RECORDS ) {
-        maxigin_logInt( "Game tried to register more than max memory records: ",
-                        MAXIGIN_MAX_MEM_RECORDS );
-        return;
+    if( ! mx_readSavedMemoryHash( inStoreReadHandle,
+                                  readHash )
+        ||
+        ! mx_hashesEqual( hash,
+                          readHash ) ) {
+        
+        mingin_log( "Save data does not match its hash, ignoring.\n" );
+        
+        mx_restoreMemoryRecordsBackup();
+        return 0;
         }
-    mx_memRecords[ mx_numMemRecords ].pointer      =  inPointer;
-    mx_memRecords[ mx_numMemRecords ].numBytes     =  inNumBytes;
-    mx_memRecords[ mx_numMemRecords ].description  =  inDescription;
 
-    mx_numMemRecords ++;
-    mx_totalMemoryRecordsBytes += inNumBytes;
+    return 1;
     }
 
 
 
+/* returns 1 on success, 0 on failure */
+static char mx_restoreStaticMemoryFromDataStore( int inStoreReadHandle ) {
+    
+    char        *fingerprint;
+    int          numTotalBytes;
+    int          readNumTotalBytes;
+    int          readNumMemRecords;
+    char         success;
+    int          i;
+    const char  *readFingerprint;
+    const char  *firstString;
 
+    if( mx_numMemRecords == 0 ) {
+        return 0;
+        }
+    
+    fingerprint = mx_getMemRecordsFingerprint( &numTotalBytes );
 
+    maxigin_logInt( "Registered live static memory total bytes:  ",
+                    numTotalBytes );
+ 
+    firstString = mx_readShortStringFromPersistData( inStoreReadHandle );
 
+    if( firstString == 0 ) {
+        mingin_log( "Failed to read total num bytes from save data.\n" );
+        return 0;
+        }
 
-static  const char   *mx_saveGameDataStoreName  =  "maxigin_save.bin";
+    if( maxigin_stringsEqual( firstString,
+                              mx_saveGameMagicHeader ) ) {
+        return mx_restoreStaticMemoryFromBinaryData( inStoreReadHandle );
+        }
 
+    /* older text save data, starts with total num bytes */
+    readNumTotalBytes = maxigin_stringToInt( firstString );
 
+    if( readNumTotalBytes != numTotalBytes ) {
+        mingin_log( "Save data does not match current total memory bytes, "
+                    "ignoring.\n" );
+        
+        maxigin_logInt( "Save data has numTotalBytes = ",
+                        readNumTotalBytes );
+        
+        maxigin_logInt( "Current live numTotalBytes = ",
+                        numTotalBytes );
+        
+        return 0;
+        }
 
-static char *mx_getMemRecordsFingerprint( int  *outTotalMemBytes ) {
+    success = mx_readIntFromPersistData( inStoreReadHandle,
+                                         &readNumMemRecords );
+
+    if( ! success ) {
+        mingin_log( "Failed to read num memory records from save data.\n" );
+        return 0;
+        }
     
-    enum{  FINGERPRINT_LENGTH  =  10,
-           HEX_LENGTH          =  FINGERPRINT_LENGTH * 2 + 1  };
+    if( readNumMemRecords != mx_numMemRecords ) {
+        mingin_log( "Save data does not match current mx_numMemRecords, "
+                    "ignoring.\n" );
+        
+        maxigin_logInt( "Save data has mx_numMemRecords = ",
+                        readNumMemRecords );
+        
+        maxigin_logInt( "Current live mx_numMemRecords = ",
+                        mx_numMemRecords );
+        
+        return 0;
+        }
     
-    static  unsigned char  fingerprintBuffer[ FINGERPRINT_LENGTH ];
-    static  char           hexBuffer[ HEX_LENGTH ];
 
-    MaxiginFlexHashState  s;
-    int                   i;
-    int                   totalNumBytes  =  0;
 
+    readFingerprint = mx_readShortStringFromPersistData( inStoreReadHandle );
     
-    maxigin_flexHashInit( &s,
-                          FINGERPRINT_LENGTH,
-                          fingerprintBuffer );
+    if( readFingerprint == 0 ) {
+        mingin_log( "Failed to read fingerprint from save data.\n" );
+        return 0;
+        }
     
-    for( i = 0;
-         i < mx_numMemRecords;
-         i ++ ) {
+    
+    if( ! maxigin_stringsEqual( fingerprint,
+                                readFingerprint ) ) {
         
-        totalNumBytes += mx_memRecords[i].numBytes;
+        mingin_log( "Save data does not match current memory fingerprint, "
+                    "ignoring.\n" );
         
-        maxigin_flexHashAdd(
-            &s,
-            maxigin_stringLength( mx_memRecords[i].description ),
-            (unsigned char *)( mx_memRecords[i].description ) );
+        maxigin_logString( "Save data has fingerprint = ",
+                           readFingerprint );
+        
+        maxigin_logString( "Current live has fingerprint = ",
+                           fingerprint );
+        
+        return 0;
         }
-    *outTotalMemBytes = totalNumBytes;
-
-    maxigin_hexEncode( FINGERPRINT_LENGTH,
-                       fingerprintBuffer, 
-                       hexBuffer );
-    
-    return hexBuffer;
-    }
 
+    /* now read the memory records from the saved data */
 
+    /* first read the descriptions and sizes to make sure they all match */
+    for( i = 0;
+         i < mx_numMemRecords;
+         i ++ ) {
+        
+        const char *liveDes = mx_memRecords[i].description;
+        const char *readDes =
+            mx_readShortStringFromPersistData( inStoreReadHandle );
+        
+        int readNumBytes;
+        
+        if( readDes == 0 ) {
+            maxigin_logInt( "Failed to read saved description for record # = ",
+                            i );
+            return 0;
+            }
+        
+        if( ! maxigin_stringsEqual( liveDes,
+                                    readDes ) ) {
+            maxigin_logInt( "Save data has wrong description for record # = ",
+                            i );
+            
+            maxigin_logString( "Save data has description = ",
+                               readDes );
 
+            maxigin_logString( "Live description = ",
+                               liveDes );
+            
+            return 0;
+            }
+        
+        
+        success = mx_readIntFromPersistData( inStoreReadHandle,
+                                             &readNumBytes );
+        
+        if( ! success ) {
+            maxigin_logInt( "Failed to read saved numBytes for record # = ",
+                            i );
+            return 0;
+            }
 
-/*
-  Reads a \0-terminated string from data store.
+        if( readNumBytes != mx_memRecords[i].numBytes ) {
+            maxigin_logInt( "Save data has wrong numBytes for record # = ",
+                            i );
+            
+            maxigin_logInt( "Save data has numBytes = ",
+                            readNumBytes );
 
-  inMaxBytes is the length of the buffer, including the \0 byte for termination.
+            maxigin_logInt( "Live numBytes = ",
+                            mx_memRecords[i].numBytes );
 
-  Returns 1 on success, 0 on failure.
-*/
-static char mx_readStringFromPersistData( int    inStoreReadHandle,
-                                          int    inMaxBytes,
-                                          char  *inBuffer ) {
-    int  i        =  0;
+            return 0;
+            }
 
-    int  readNum  =  mingin_readPersistData(
-                         inStoreReadHandle,
-                         1,
-                         (unsigned char *)&( inBuffer[i] ) );
-    
-    while( readNum == 1
-           &&
-           i < inMaxBytes - 1
-           &&
-           inBuffer[i] != '\0' ) {
-        i++;
-        readNum = mingin_readPersistData( inStoreReadHandle,
-                                          1,
-                                          (unsigned char *)&( inBuffer[i] ) );
         }
 
-    if( readNum == 0
-        &&
-        i > 0 ) {
-        /* read some chars, but last read hit EOF, back up */
-        i --;
-        }
-    else if( readNum == 0
-             &&
-             i == 0 ) {
-        /* never read any chars */
-        return 0;
-        }
     
-    if( readNum == 1
-        &&
-        inBuffer[i] != '\0' ) {
-        /* didn't find termination in data store
-           because string was too long for buffer */
-        mingin_log( "Error:  Buffer overflow when trying to read string from "
-                    "persistent data store.\n" );
-        return 0;
-        }
-    else if( readNum == 0
-             &&
-             inBuffer[i] != '\0' ) {
-        /* reached end of data store without finding termination byte
-           special case:  a data store that only contains one string, with
-           no termination at the end (to make file editable in a text editor)
-           Terminate our read string and return it */
+    /* Now it's safe to reach the memory regions into memory
+       since everything above matches */
+    
+    for( i = 0;
+         i < mx_numMemRecords;
+         i ++ ) {
+        
+        /* read numBytes from memory location into storage */
+        int numRead = mingin_readPersistData(
+            inStoreReadHandle,
+            mx_memRecords[i].numBytes,
+            (unsigned char*)mx_memRecords[i].pointer );
+        
+        if( numRead !=  mx_memRecords[i].numBytes ) {
+            maxigin_logInt(
+                "Failed to read memory data from save data for record # = ", i );
 
-        if( i < inMaxBytes - 1 ) {
-            inBuffer[ i + 1 ] = '\0';
-            return 1;
+            return 0;
             }
-
-        /* reached end of data store AND we reached end of buffer?
-           While loop above should prevent this */
-            
-        mingin_log( "Error:  Reading string from persistent data store reached "
-                    "unexpected case\n" );
-        return 0;
-        }
-    else if( readNum == -1 ) {
-        mingin_log( "Error:  Got read failure when trying to read string "
-                    "from persistent data store.\n" );
-        return 0;
         }
 
     return 1;
@@ -13459,1223 +17566,1593 @@ static char mx_readStringFromPersistData( int    inStoreReadHandle,
 
 
 
-/*
-  Reads a \0-terminated short string (< 64 chars long) into a static buffer.
+static void mx_checkStartupPlaybackResume( void ) {
 
-  Returns 0 on failure.
-*/
-static const char *mx_readShortStringFromPersistData( int  inStoreReadHandle ) {
+    char  resume  =  maxigin_readFlagSetting( "maxigin_resumePlayback.ini",
+                                              0 );
+    int   pos;
+
+    if( ! resume ) {
+        return;
+        }
+
+    pos = maxigin_readIntSetting( "maxigin_resumePlaybackPos.ini",
+                                  -1 );
+
+    if( pos == -1 ) {
+        return;
+        }
 
-    enum{  BUFFER_LEN  =  64  };
     
-    static  char  buffer[ BUFFER_LEN ];
+    mx_playbackBlockForwardSounds = 1;
+                    
+    mx_initPlayback();
+
+    /* jump to saved step */
+    mx_playbackJumpToStep( pos );
+
+    mx_playbackBlockForwardSounds = 0;
+
     
-    char  success;
+    /* start paused in that spot
+       
+       This is very useful when hot-reloading to tweak the position
+       of something mid-move */
+
+    mx_playbackSpeed =
+        maxigin_readIntSetting( "maxigin_resumePlaybackSpeed.ini",
+                                1 );
     
     
-    success = mx_readStringFromPersistData( inStoreReadHandle,
-                                            BUFFER_LEN,
-                                            buffer );
-    if( success ) {
-        return buffer;
+    mx_playbackDirection =
+        (char)maxigin_readIntSetting( "maxigin_resumePlaybackDirection.ini",
+                                      1 );
+    
+        
+    mx_playbackPaused =
+        (char)maxigin_readIntSetting( "maxigin_resumePlaybackPaused.ini",
+                                      1 );
+    
+
+    /* sound speed to 0 when paused */
+    if( mx_playbackPaused ) {
+        mx_setSoundSpeedAndDirection( 0,
+                                      mx_playbackDirection );
         }
     else {
-        return 0;
-        } 
-    }
+        mx_setSoundSpeedAndDirection( mx_playbackSpeed,
+                                      mx_playbackDirection );
+        }
 
+    mx_loadLoopPoints();
+    
+    }
 
-/*
-  Reads a whitespace-terminated short string token (< 64 chars long) into a
-  static buffer.
 
-  Skips any whitespace before the token, and consumes the first whitespace
-  character after the token.
 
-  Valid whitespace includes ' ', '\n', '\r', and '\t'
 
-  Has 10 internal buffers that it uses, round-robin, for interleaved calls
-  
-  Returns \0-terminated string token with no trailing whitespace
-  Returns 0 on failure.
-*/
-static const char *mx_readShortTokenFromBulkData( int  inBulkReadHandle ) {
+void maxigin_initRestoreStaticMemoryFromLastRun( void ) {
+    char success;
 
-    enum{         NUM_BUFFERS  =  10,
-                  BUFFER_LEN   =  64  };
-    int           i            =   0;
-    int           readNum;
-    char         *returnVal;
-    char          c;
+    int storeSize;
+    int readHandle;
     
-    static  char  buffer[NUM_BUFFERS][ BUFFER_LEN ];
-    static  int   n                                   =  0;
+    if( ! mx_areWeInMaxiginGameInitFunction ) {
+        mingin_log( "Game tried to call "
+                    "maxigin_initRestoreStaticMemoryFromLastRun "
+                    "from outside of maxiginGame_init\n" );
+        return;
+        }
     
+    readHandle = mingin_startReadPersistData( mx_saveGameDataStoreName,
+                                              &storeSize );
 
-    /* skip white space */
-    readNum = mingin_readBulkData( inBulkReadHandle,
-                                   1,
-                                   (unsigned char *)&( c ) );
+    if( readHandle == -1 ) {
+        maxigin_logString( "Failed to open saved game for reading: ",
+                           mx_saveGameDataStoreName );
+        return;
+        }
 
-    while( readNum == 1
-           &&
-           ( c == '\0'
-             ||
-             c == ' '
-             ||
-             c == '\n'
-             ||
-             c == '\r'
-             ||
-             c == '\t' ) ) {
+    success = mx_restoreStaticMemoryFromDataStore( readHandle );
 
-        readNum = mingin_readBulkData( inBulkReadHandle,
-                                   1,
-                                   (unsigned char *)&( c ) );
-        }
+    mingin_endReadPersistData( readHandle );
 
-    if( readNum != 1 ) {
-        /* read to end without finding anything but spaces */
-        return 0;
+
+    if( !success ) {
+        return;
         }
+    mingin_log( "Restored live memory from saved game data.\n" );
 
-    /* put first non-whitespace in our buffer */
-    buffer[n][i] = c;
 
-    i++;
+    mx_checkStartupPlaybackResume();
+    }
 
-    
-    /* now continue filling buffer with non-whitespace tokens */
-    
-    readNum = mingin_readPersistData( inBulkReadHandle,
-                                          1,
-                                          (unsigned char *)&( buffer[n][i] ) );
-    
-    while( readNum == 1
-           &&
-           i < BUFFER_LEN - 1
-           &&
-           buffer[n][i] != '\0'
-           &&
-           buffer[n][i] != ' '
-           &&
-           buffer[n][i] != '\n'
-           &&
-           buffer[n][i] != '\r'
-           &&
-           buffer[n][i] != '\t' ) {
-        i++;
-        readNum = mingin_readPersistData( inBulkReadHandle,
-                                          1,
-                                          (unsigned char *)&( buffer[n][i] ) );
-        }
 
-    if( readNum == 0
-        &&
-        i > 0 ) {
-        /* read some chars, but last read hit end of data, back up */
-        i --;
-        }
-    else if( readNum == 0
-             &&
-             i == 0 ) {
-        /* never read any chars */
-        return 0;
-        }
-    
-    if( readNum == 1
-        &&
-        buffer[n][i] != '\0'
-        &&
-        buffer[n][i] != ' '
-        &&
-        buffer[n][i] != '\n'
-        &&
-        buffer[n][i] != '\r'
-        &&
-        buffer[n][i] != '\t' ) {
-        /* didn't find termination in data store
-           because string was too long for buffer */
-        mingin_log( "Error:  Buffer overflow when trying to read string "
-                    "token from bulk data store.\n" );
-        return 0;
-        }
-    else if( readNum == 0
-             &&
-             buffer[n][i] != '\0'
-             &&
-             buffer[n][i] != ' '
-             &&
-             buffer[n][i] != '\n'
-             &&
-             buffer[n][i] != '\r'
-             &&
-             buffer[n][i] != '\t' ) {
-        /* reached end of data store without finding whitespace
-           or termination byte
-           special case:  a data store that only contains one string, with
-           no whitespace at end
-           Terminate our read string and return it */
 
-        if( i < BUFFER_LEN - 1 ) {
-            buffer[n][ i + 1 ] = '\0';
 
-            returnVal = buffer[n];
-            
-            n++;
 
-            if( n >= NUM_BUFFERS ) {
-                n = 0;
-                }
-            
-            return returnVal;
-            }
 
-        /* reached end of data store AND we reached end of buffer?
-           While loop above should prevent this */
-            
-        mingin_log( "Error:  Reading string token from bulk data reached "
-                    "unexpected case\n" );
-        return 0;
-        }
-    else if( readNum == -1 ) {
-        
-        mingin_log( "Error:  Got read failure when trying to read string "
-                    "token from bulk data.\n" );
-        return 0;
-        }
 
-    /* got here, safe to terminate buffer at first whitespace character
-       found */
-    buffer[n][i] = '\0';
+#if( MAXIGIN_ENABLE_RECORDING == 0 )
+    /* recording is off, shrink our recording buffer down to nothing */
+    #undef   MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES
+    #define  MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES  1
+    #undef   MAXIGIN_RECORDING_RING_STEPS
+    #define  MAXIGIN_RECORDING_RING_STEPS  2
+    #undef   MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS
+    #define  MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS  1
+    #undef   MAXIGIN_MAX_PLAYBACK_KEYFRAMES
+    #define  MAXIGIN_MAX_PLAYBACK_KEYFRAMES  1
+#endif
+
+
+/* recording buffers are made of words, so we can compare them a word at
+   a time */
+#define  MAXIGIN_RECORDING_BUFFER_WORDS                                  \
+            ( ( MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES                \
+                + sizeof( unsigned long ) - 1 )                          \
+              / sizeof( unsigned long ) )
 
-    returnVal = buffer[n];
-    
-    n++;
+/* number of words we compare at once when skipping unchanged memory */
+#define  MAXIGIN_RECORDING_DIFF_CHUNK_WORDS  4
 
-    if( n >= NUM_BUFFERS ) {
-        n = 0;
-        }
 
-    return returnVal; 
-    }
+/* what the recording writer needs to write for a captured step */
+typedef enum MaxiginRecordingStepType {
+    MAXIGIN_RECORD_FULL_SNAPSHOT,
+    MAXIGIN_RECORD_DIFF,
+    MAXIGIN_RECORD_DIFF_AND_FULL_SNAPSHOT
+    } MaxiginRecordingStepType;
 
 
 /*
-  Reads a \0-terminated string representation of an int from data store.
-
-  Returns 1 on success, 0 on failure.
+  Everything about one step that goes into the recording, captured during
+  the game step and written out later by the recording writer.
 */
-static char mx_readIntFromPersistData( int   inStoreReadHandle,
-                                       int  *outInt ) {
-    
-    const char  *read  =  mx_readShortStringFromPersistData( inStoreReadHandle );
+typedef struct MaxiginRecordingStep {
+        
+        MaxiginRecordingStepType  type;
+        
+        int            stepNumber;
+        int            musicPos;
+        
+        int            numJustStarted;
+        int            justStartedHandles[
+                           MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
+        int            justStartedLoudness[
+                           MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
+        
+        int            numJustEnded;
+        int            justEndedHandles[
+                           MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
+        int            justEndedLoudness[
+                           MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
+        
+        int            numLive;
+        int            liveHandles[ MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
+        int            liveLoudness[ MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
+        int            liveDataPositions[
+                           MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
 
-    if( read == 0 ) {
-        return 0;
-        }
-    
-    *outInt = maxigin_stringToInt( read );
+        /* what the game step saw of player input */
+        MaxiginStepInput  input;
 
-    return 1;
-    }
+        /* all registered memory records, end-to-end
+           carved from mx_recordingArena */
+        unsigned long *memory;
+        
+    } MaxiginRecordingStep;
 
 
 /*
-  Reads a whitespace-delimited string representation of an int from
-  a bulk resource.
+  Ring of captured steps waiting for the recording writer.
 
-  Skips any whitespace before the int, and consumes the first whitespace
-  character after the int.
+  The slot before mx_recordingRingWritePos holds the last step written,
+  which the next diff is computed against, so at most
+  mx_recordingRingSteps - 1 steps can be waiting.
 
-  Returns 1 on success, 0 on failure.
+  Positions are shared with the writer thread, so they're only touched
+  inside mingin_lockWorker.
 */
-static char mx_readIntTokenFromBulkData( int   inBulkReadHandle,
-                                         int  *outInt ) {
-    
-    const char  *read  =  mx_readShortTokenFromBulkData( inBulkReadHandle );
+static  MaxiginRecordingStep  mx_recordingRing[
+                                  MAXIGIN_RECORDING_RING_STEPS ];
 
-    if( read == 0 ) {
-        return 0;
-        }
-    
-    *outInt = maxigin_stringToInt( read );
+/* how many slots have memory carved for them, at least 2 */
+static  int          mx_recordingRingSteps             =  0;
 
-    return 1;
-    }
+/* next slot that the game step captures into */
+static  int          mx_recordingRingCapturePos        =  0;
+/* next slot that the writer writes out */
+static  int          mx_recordingRingWritePos          =  0;
+
+static  char         mx_recordingWriterThreadRunning   =  0;
+/* set by writer when writing fails, so game step can close the recording */
+static  char         mx_recordingWriterFailed          =  0;
 
+static  int          mx_recordingDataStoreHandle       =  -1;
+static  int          mx_recordingIndexDataStoreHandle  =  -1;
+
+static  char         mx_diffRecordingEnabled           =  1;
+
+static  int          mx_numDiffsSinceLastFullSnapshot  =  0;
+static  int          mx_totalStepsRecorded             =  0;
+
+static  const char  *mx_recordingMagicFooter           =  "MX_RECORDING";
+static  const char  *mx_recordingCompactMagicFooter    =  "MX_RECORDING2";
+static  char         mx_newPlaybackStarting            =  0;
 
 
 /*
-  Writes a \0-terminated string representation of an int to data store.
+  A recording is a saved game header, followed by blocks, each either
+  a full memory snapshot (header "F") or a diff from the previous step
+  (header "D").
 
-  Returns 1 on success, 0 on failure.
+  Version 1 blocks store numbers as \0-terminated decimal strings, and each
+  changed byte in a diff as its own offset and xor byte.  These are still
+  read, so that old recordings can be played back.
+
+  Version 2 blocks (headers "F2" and "D2") are binary:
+
+      header string, including \0
+      
+      varint length of body
+      
+      body:
+          varint          step number
+          zig-zag varint  music position
+          
+          just-started sound effects:  varint count, then zig-zag varint
+                                       handle and loudness for each
+          just-ended sound effects:    same as just-started
+          live sound effects:          varint count, then zig-zag varint
+                                       handle, loudness, and data position
+                                       for each
+
+          full snapshot:  raw bytes of all memory records, end-to-end
+
+          diff:           runs of changed bytes, each a varint gap from
+                          the end of the previous run, a varint run length,
+                          and then the xor of each byte in the run with its
+                          previous value.
+                          A run with length 0 ends the diff.
+                          
+      4-byte little-endian int position of block start, so we can find
+      block starts when playing backward
+
+  Diffs are written as version 4 blocks (header "D4"), which are the same
+  as "D2" blocks except that the player input seen by the game step comes
+  right after the live sound effects:
+
+      game buttons down:  varint count, then varint handle of each
+      pointer:            varint 0 if not available, or 1 followed by
+                          zig-zag varint x and y
+      game sticks:        varint count of available sticks, then varint
+                          handle, and zig-zag varint position, lower limit,
+                          and upper limit for each
+
+  Full snapshots that compress to fewer bytes than the memory records are
+  written as version 3 blocks (header "F3"), which are the same as "F2"
+  blocks except that the memory records are compressed:
+
+      pairs of literals and matches, each a varint literal count, followed
+      by that many literal bytes, then a varint match length, followed by
+      a varint match distance back from the current end of the memory,
+      if the length is not 0.
+      A match with length 0 ends the snapshot.
+
+  Each compressed snapshot stands on its own, so playback can still jump
+  straight to any full snapshot.
+
+  Varints are LEB128, 7 bits per byte, least significant bits first.
+
+  While recording, an index of full snapshots is kept in a separate data
+  store, as pairs of padded decimal ints (step number, then position of
+  block start).  When the recording is finalized, or recovered after a crash,
+  this index is appended to the recording in compact form, followed by
+  the index length and total step count as padded ints, and then
+  the footer "MX_RECORDING2", including \0:
+
+      compact index entry:  4-byte little-endian int step number,
+                            4-byte little-endian int position of block start
+
+  Older recordings have the padded index appended as-is, with the footer
+  "MX_RECORDING", and can still be played back.
 */
-static char mx_writeStringToPeristentData( int          inStoreWriteHandle,
-                                           const char  *inString ) {
-    
-    return mingin_writePersistData( inStoreWriteHandle,
-                                    maxigin_stringLength( inString ) + 1,
-                                    (unsigned char*)inString );
-    }
+
+
+/* largest encoded step input, in a "D4" block */
+#define  MAXIGIN_STEP_INPUT_MAX_BYTES                                    \
+            ( MAXIGIN_MAX_VARINT_LENGTH *                                \
+              ( MAXIGIN_NUM_GAME_BUTTONS                                 \
+                +                                                        \
+                4 * MAXIGIN_NUM_GAME_STICKS                              \
+                + 5 ) )
 
 
 /*
-  Writes a \0-terminated string representation of an int to data store.
+  Largest block body we can have.
+  
+  Diff runs cost at most 3 bytes for every 2 bytes of memory (every other
+  byte changed), plus step number, music position, sound effects,
+  and step input.
+*/
+#define  MAXIGIN_RECORDING_BLOCK_MAX_BYTES                               \
+            ( 2 * MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES              \
+              +                                                          \
+              MAXIGIN_MAX_VARINT_LENGTH *                                \
+              ( 3 * 3 * MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS + 8 )      \
+              +                                                          \
+              MAXIGIN_STEP_INPUT_MAX_BYTES )
 
-  Returns 1 on success, 0 on failure.
+
+/* words needed for a block buffer when MAXIGIN_RECORDING_BLOCK_MAX_BYTES
+   are registered */
+#define  MAXIGIN_RECORDING_BLOCK_WORDS                                   \
+            ( ( MAXIGIN_RECORDING_BLOCK_MAX_BYTES                        \
+                + sizeof( unsigned long ) - 1 )                          \
+              / sizeof( unsigned long ) )
+
+
+/*
+  Arena that recording buffers are carved from, sized at compile time
+  for MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES of registered memory.
+
+  Laid out as the block buffer, followed by a memory buffer for each slot
+  in mx_recordingRing, all sized by mx_layoutRecordingArena for the memory
+  actually registered.
 */
-static char mx_writeIntToPeristentData( int  inStoreWriteHandle,
-                                        int  inInt ) {
-    
-    return mx_writeStringToPeristentData( inStoreWriteHandle,
-                                          maxigin_intToString( inInt ) );
-    }
+static unsigned long mx_recordingArena[
+    MAXIGIN_RECORDING_BLOCK_WORDS
+    +
+    MAXIGIN_RECORDING_RING_STEPS * MAXIGIN_RECORDING_BUFFER_WORDS ];
 
 
+/* where we encode a block before writing it,
+   and where we read a block before decoding it
+   carved from mx_recordingArena */
+static  unsigned char  *mx_recordingBlockBuffer       =  0;
+static  int             mx_recordingBlockBufferBytes  =  0;
 
 
-static  unsigned char  mx_intPadding[ MAXIGIN_PADDED_INT_LENGTH ];
+/* length of one full snapshot entry in an index */
+#define  MAXIGIN_PADDED_INDEX_ENTRY_LENGTH   ( 2 * MAXIGIN_PADDED_INT_LENGTH )
+#define  MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH  ( 2 * MAXIGIN_FIXED_INT_LENGTH )
 
 
+/* playback index entries loaded at the start of playback, so that jumps
+   don't need to read the index from the playback data store */
+static  int   mx_playbackIndexSteps    [ MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS ];
+static  int   mx_playbackIndexPositions[ MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS ];
+static  int   mx_playbackIndexNumLoaded     =  0;
+static  int   mx_playbackIndexEntryLength   =
+                  MAXIGIN_PADDED_INDEX_ENTRY_LENGTH;
 
 
-static char mx_writePaddedIntToPerisistentData( int  inStoreWriteHandle,
-                                                int  inInt ) {
-    
-    const char  *intString  =  maxigin_intToString( inInt );
-    char         success;
-    int          b          =  0;
-    int          len;
-    
-    success = mingin_writePersistData( inStoreWriteHandle,
-                                       maxigin_stringLength( intString ),
-                                       (unsigned char*)intString );
+/*
+  Memory state at a playback step, so we can jump back to it without
+  re-reading diffs.
+*/
+typedef struct MaxiginPlaybackKeyframe {
+        
+        /* -1 if slot empty */
+        int            stepNumber;
 
-    if( ! success ) {
+        /* where the block for the following step starts */
+        int            dataPos;
+
+        int            fullSnapshotLastPlayed;
+        
+        unsigned long  lastUsed;
+        
+        /* carved from mx_recordingArena */
+        unsigned long  *memory;
+        
+    } MaxiginPlaybackKeyframe;
+
+
+static  MaxiginPlaybackKeyframe  mx_playbackKeyframes[
+                                     MAXIGIN_MAX_PLAYBACK_KEYFRAMES ];
+static  int                      mx_playbackNumKeyframeSlots  =  0;
+static  unsigned long            mx_playbackKeyframeUseCount  =  0;
+
+
+
+/*
+  Gets the largest block body we can have, for the memory actually
+  registered, like MAXIGIN_RECORDING_BLOCK_MAX_BYTES.
+*/
+static int mx_getRecordingBlockMaxBytes( void ) {
+    return 2 * mx_totalMemoryRecordsBytes
+           +
+           MAXIGIN_MAX_VARINT_LENGTH *
+           ( 3 * 3 * MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS + 8 )
+           +
+           MAXIGIN_STEP_INPUT_MAX_BYTES;
+    }
+
+
+
+/*
+  Carves the block buffer and ring slot memory out of mx_recordingArena,
+  sized for mx_totalMemoryRecordsBytes, and sets mx_recordingRingSteps
+  to how many ring slots fit, up to MAXIGIN_RECORDING_RING_STEPS.
+
+  Returns 1 if at least the block buffer fits, 0 if not.
+*/
+static char mx_layoutRecordingArena( void ) {
+
+    int  wordBytes    =  (int)sizeof( unsigned long );
+    int  arenaWords   =  (int)( sizeof( mx_recordingArena ) /
+                                sizeof( unsigned long ) );
+    int  blockWords   =  ( mx_getRecordingBlockMaxBytes() + wordBytes - 1 ) /
+                         wordBytes;
+    int  memoryWords  =  ( mx_totalMemoryRecordsBytes + wordBytes - 1 ) /
+                         wordBytes;
+    int  i;
+
+    mx_recordingRingSteps = 0;
+    
+    if( blockWords > arenaWords ) {
         return 0;
         }
+
+    mx_recordingBlockBuffer       =  (unsigned char*)mx_recordingArena;
+    mx_recordingBlockBufferBytes  =  blockWords * wordBytes;
+
+    if( memoryWords > 0 ) {
+        mx_recordingRingSteps = ( arenaWords - blockWords ) / memoryWords;
+        }
     
-    /* pad with \0     */
-    len = maxigin_stringLength( intString );
-    
-    while( len < MAXIGIN_PADDED_INT_LENGTH ) {
-        mx_intPadding[b] = '\0';
-        len++;
-        b++;
+    if( mx_recordingRingSteps > MAXIGIN_RECORDING_RING_STEPS ) {
+        mx_recordingRingSteps = MAXIGIN_RECORDING_RING_STEPS;
         }
 
-    /* write padding out */
-    return mingin_writePersistData( inStoreWriteHandle,
-                                    b,
-                                    mx_intPadding );
+    for( i = 0;
+         i < mx_recordingRingSteps;
+         i ++ ) {
+        
+        mx_recordingRing[i].memory =
+            &( mx_recordingArena[ blockWords + i * memoryWords ] );
+        }
+
+    /* ring slots overlap playback keyframes, so any we have are lost */
+    for( i = 0;
+         i < mx_playbackNumKeyframeSlots;
+         i ++ ) {
+        
+        mx_playbackKeyframes[i].stepNumber = -1;
+        }
+
+    return 1;
     }
 
 
 
-static char mx_readPaddedIntFromPeristentData( int   inStoreReadHandle,
-                                               int  *outInt ) {
-    
-    int  numRead  =  mingin_readPersistData( inStoreReadHandle,
-                                             MAXIGIN_PADDED_INT_LENGTH,
-                                             mx_intPadding );
+/*
+  Lays out empty playback keyframes in the part of mx_recordingArena after
+  the block buffer, overlapping the recording ring, which isn't used
+  during playback.
 
-    if( numRead != MAXIGIN_PADDED_INT_LENGTH ){
-        return 0;
+  mx_layoutRecordingArena must have succeeded before calling.
+*/
+static void mx_layoutPlaybackKeyframes( void ) {
+
+    int  wordBytes    =  (int)sizeof( unsigned long );
+    int  arenaWords   =  (int)( sizeof( mx_recordingArena ) /
+                                sizeof( unsigned long ) );
+    int  blockWords   =  mx_recordingBlockBufferBytes / wordBytes;
+    int  memoryWords  =  ( mx_totalMemoryRecordsBytes + wordBytes - 1 ) /
+                         wordBytes;
+    int  i;
+
+    mx_playbackNumKeyframeSlots = 0;
+    mx_playbackKeyframeUseCount = 0;
+    
+    if( memoryWords > 0 ) {
+        mx_playbackNumKeyframeSlots = ( arenaWords - blockWords ) / memoryWords;
+        }
+    
+    if( mx_playbackNumKeyframeSlots > MAXIGIN_MAX_PLAYBACK_KEYFRAMES ) {
+        mx_playbackNumKeyframeSlots = MAXIGIN_MAX_PLAYBACK_KEYFRAMES;
         }
 
-    *outInt = maxigin_stringToInt( (char *)mx_intPadding );
-    return 1;
+    for( i = 0;
+         i < mx_playbackNumKeyframeSlots;
+         i ++ ) {
+        
+        mx_playbackKeyframes[i].stepNumber  =  -1;
+        mx_playbackKeyframes[i].lastUsed    =  0;
+        mx_playbackKeyframes[i].memory      =
+            &( mx_recordingArena[ blockWords + i * memoryWords ] );
+        }
     }
 
 
+#define  MAXIGIN_BLOCK_START_POS_LENGTH  MAXIGIN_FIXED_INT_LENGTH
 
-static  const char  *mx_spriteCacheName  =  "maxigin_spriteCache.bin";
+/* version of the last block we played back */
+static  int  mx_playbackBlockVersion  =  1;
 
+/* set by the playback verify tool, which re-simulates diffs that have
+   step input in them, so their memory changes are skipped */
+static  char  mx_playbackSimulatingSteps  =  0;
 
-static void mx_spriteCacheReadFailed( int  inReadHandle ) {
-    mingin_endReadPersistData( inReadHandle );
 
-    mingin_deletePersistData( mx_spriteCacheName );
+/*
+  Copies snapshot of memory into a recording buffer, like a recording
+  step's memory or a playback keyframe.
+*/
+static void mx_copyMemoryIntoBuffer( unsigned long  *outMemory ) {
+    
+    int             r;
+    int             b           =  0;
+    int             wordBytes   =  (int)sizeof( unsigned long );
+    unsigned char  *buffer      =  (unsigned char*)outMemory;
 
-    mx_numSpriteBytesUsed = 0;
-    mx_numSprites         = 0;
-    mx_numStripSubSprites = 0;
-    mx_numSpriteStrips    = 0;
+    /* bytes past the end of our records in the last word must match
+       in all steps, for word-at-a-time diffing */
+    outMemory[ ( mx_totalMemoryRecordsBytes + wordBytes - 1 ) /
+               wordBytes
+               - 1 ] = 0;
 
-    mingin_log( "Failed to read from sprite cache: " );
-    mingin_log( mx_spriteCacheName );
-    mingin_log( "\n" );
+    for( r = 0;
+         r < mx_numMemRecords;
+         r ++ ) {
+
+        int  recSize  =  mx_memRecords[r].numBytes;
+        
+        mx_copyBytes( &( buffer[b] ),
+                      (unsigned char*)( mx_memRecords[r].pointer ),
+                      recSize );
+        b += recSize;
+        }
     }
 
 
 
-static void mx_initSpriteCache( void ) {
+/*
+  Copies a recording buffer back into memory, the opposite of
+  mx_copyMemoryIntoBuffer.
+*/
+static void mx_copyBufferIntoMemory( const unsigned long  *inMemory ) {
+    
+    int                   r;
+    int                   b       =  0;
+    const unsigned char  *buffer  =  (const unsigned char*)inMemory;
 
-    int  numBytes;
-    int  readHandle;
+    for( r = 0;
+         r < mx_numMemRecords;
+         r ++ ) {
 
-    if( maxigin_readFlagSetting( "maxigin_disableSpriteCache.ini",
-                                 0 ) ) {
-        /* if we're in development and hot-reloading a bunch of sprites
-           while working on them, we might set this flag.
-           That means the cache is likely stale, so delete it for now,
-           until the flag is turned off later and the cache can be regenerated */
-        
-        mingin_deletePersistData( mx_spriteCacheName );
+        int  recSize  =  mx_memRecords[r].numBytes;
         
-        return;
+        mx_copyBytes( (unsigned char*)( mx_memRecords[r].pointer ),
+                      &( buffer[b] ),
+                      recSize );
+        b += recSize;
         }
+    }
 
-    readHandle =  mingin_startReadPersistData( mx_spriteCacheName,
-                                               &numBytes );
 
-    if( readHandle != -1 ) {
 
-        int  readInt;
-        
-        if( ! mx_readIntFromPersistData( readHandle,
-                                         & mx_numSpriteBytesUsed ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
-        
-        if( mx_numSpriteBytesUsed
-            !=
-            mingin_readPersistData(
-                readHandle,
-                mx_numSpriteBytesUsed,
-                mx_spriteBytes ) ) {
-                
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+static char mx_backupMemoryRecords( void ) {
 
-        if( ! mx_readIntFromPersistData( readHandle,
-                                         &readInt ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+    if( ! mx_layoutRecordingArena()
+        ||
+        mx_recordingRingSteps < 1 ) {
+        return 0;
+        }
 
-        if( readInt != sizeof( MaxiginSprite ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
-        
-        if( ! mx_readIntFromPersistData( readHandle,
-                                         &mx_numSprites ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+    mx_copyMemoryIntoBuffer( mx_recordingRing[0].memory );
+    
+    return 1;
+    }
+
+
+
+static void mx_restoreMemoryRecordsBackup( void ) {
+    mx_copyBufferIntoMemory( mx_recordingRing[0].memory );
+    }
+
+
+
+/* number of bits in hashes used to find matches when compressing */
+#define  MAXIGIN_COMPRESS_HASH_BITS  12
+
+/* shortest match worth encoding */
+#define  MAXIGIN_COMPRESS_MIN_MATCH  4
 
 
-        if( mx_numSprites * (int)sizeof( MaxiginSprite )
-            !=
-            mingin_readPersistData(
-                readHandle,
-                mx_numSprites * (int)sizeof( MaxiginSprite ),
-                (unsigned char *)mx_sprites ) ) {
-                
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+/* last position where each hash of MAXIGIN_COMPRESS_MIN_MATCH bytes was seen
+   only used by the recording writer */
+static  int  mx_compressHashTable[ 1 << MAXIGIN_COMPRESS_HASH_BITS ];
 
 
-        if( ! mx_readIntFromPersistData( readHandle,
-                                         &readInt ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
 
-        if( readInt != (int)sizeof( int ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+/*
+  Hashes the MAXIGIN_COMPRESS_MIN_MATCH bytes at inBytes.
+*/
+static int mx_compressHash( const unsigned char  *inBytes ) {
+    
+    unsigned long  v  =  (unsigned long)inBytes[0]
+                         | (unsigned long)inBytes[1] << 8
+                         | (unsigned long)inBytes[2] << 16
+                         | (unsigned long)inBytes[3] << 24;
 
-        if( ! mx_readIntFromPersistData( readHandle,
-                                         &mx_numStripSubSprites ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+    v = ( v * 2654435761UL ) & 0xFFFFFFFFUL;
 
-        if( mx_numStripSubSprites * (int)sizeof( int )
-            !=
-            mingin_readPersistData(
-                readHandle,
-                mx_numStripSubSprites * (int)sizeof( int ),
-                (unsigned char *)mx_stripSubSprites ) ) {
-                
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+    return (int)( v >> ( 32 - MAXIGIN_COMPRESS_HASH_BITS ) );
+    }
 
-        if( ! mx_readIntFromPersistData( readHandle,
-                                         &readInt ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
 
-        if( readInt != (int)sizeof( MaxiginSpriteStrip ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
 
-        if( ! mx_readIntFromPersistData( readHandle,
-                                         &mx_numSpriteStrips ) ) {
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+/*
+  Adds a literal count, literals, and a match to the end of compressed data.
 
-        if( mx_numSpriteStrips * (int)sizeof( MaxiginSpriteStrip )
-            !=
-            mingin_readPersistData(
-                readHandle,
-                mx_numSpriteStrips * (int)sizeof( MaxiginSpriteStrip ),
-                (unsigned char *)mx_spriteStrips ) ) {
-                
-            mx_spriteCacheReadFailed( readHandle );
-            return;
-            }
+  Returns new end of compressed data, or -1 if out of room.
+*/
+static int mx_compressEmit( const unsigned char  *inLiterals,
+                            int                   inNumLiterals,
+                            int                   inMatchLength,
+                            int                   inMatchDistance,
+                            unsigned char        *outBytes,
+                            int                   inPos,
+                            int                   inMaxBytes ) {
+    
+    int  pos  =  inPos;
 
-        mingin_endReadPersistData( readHandle );
+    if( pos + inNumLiterals + 3 * MAXIGIN_MAX_VARINT_LENGTH > inMaxBytes ) {
+        return -1;
+        }
 
+    pos += mx_encodeVarint( (unsigned long)inNumLiterals,
+                            &( outBytes[ pos ] ) );
 
-        mx_spriteCacheLoaded           = 1;
-        mx_nextCachedSpriteHandle      = 0;
-        mx_nextCachedSpriteStripHandle = 0;
+    mx_copyBytes( &( outBytes[ pos ] ),
+                  inLiterals,
+                  inNumLiterals );
+    pos += inNumLiterals;
 
-        mingin_log( "Loaded cached sprite data.\n" );
+    pos += mx_encodeVarint( (unsigned long)inMatchLength,
+                            &( outBytes[ pos ] ) );
+
+    if( inMatchLength > 0 ) {
+        pos += mx_encodeVarint( (unsigned long)inMatchDistance,
+                                &( outBytes[ pos ] ) );
         }
 
+    return pos;
     }
 
 
 
-static void mx_spriteCacheWriteFailed( int  inWriteHandle ) {
-    mingin_endWritePersistData( inWriteHandle );
-
-    mingin_deletePersistData( mx_spriteCacheName );
+/*
+  Compresses bytes as pairs of literals and matches with earlier bytes,
+  in the format used by "F3" recording blocks.
 
-    mingin_log( "Failed to write to sprite cache: " );
-    mingin_log( mx_spriteCacheName );
-    mingin_log( "\n" );
-    }
+  Matches can overlap the bytes they produce, so runs of the same
+  byte, like zeroed memory, compress down to a few bytes.
 
-    
-static void mx_finalizeSpriteCache( void ) {
+  Parameters:
 
-    if( maxigin_readFlagSetting( "maxigin_disableSpriteCache.ini",
-                                 0 ) ) {
-        return;
-        }
+      inBytes      the bytes to compress
 
-    if( mx_spriteCacheBad ) {
-        mingin_log( "Deleting bad sprite cache.  Cache will be regenerated on "
-                    "next run.\n" );
-        mingin_deletePersistData( mx_spriteCacheName );
-        }
+      inNumBytes   how many bytes to compress
 
-    if( ! mx_spriteCacheLoaded ) {
+      outBytes     buffer where compressed bytes should be written
 
-        /* generate a new sprite cache and save it */
+      inMaxBytes   size of outBytes
 
-        int   writeHandle  =  mingin_startWritePersistData( mx_spriteCacheName );
+  Returns:
 
-        mingin_log( "Regenerating new sprite cache from good sprite data.\n" );
-        
-        if( writeHandle != -1 ) {
+      length of compressed bytes
 
-            if( ! mx_writeIntToPeristentData( writeHandle,
-                                              mx_numSpriteBytesUsed ) ) {
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
+      -1   if compressed bytes don't fit in inMaxBytes
+*/
+static int mx_compressBytes( const unsigned char  *inBytes,
+                             int                   inNumBytes,
+                             unsigned char        *outBytes,
+                             int                   inMaxBytes ) {
+    
+    int  i;
+    int  literalStart  =  0;
+    int  pos           =  0;
 
-            if( ! mingin_writePersistData( writeHandle,
-                                           mx_numSpriteBytesUsed,
-                                           mx_spriteBytes ) ) {
-                
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
+    for( i = 0;
+         i < ( 1 << MAXIGIN_COMPRESS_HASH_BITS );
+         i ++ ) {
+        
+        mx_compressHashTable[i] = -1;
+        }
 
-            if( ! mx_writeIntToPeristentData( writeHandle,
-                                              (int)sizeof( MaxiginSprite ) ) ) {
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
-            
-            if( ! mx_writeIntToPeristentData( writeHandle,
-                                              mx_numSprites ) ) {
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
+    i = 0;
+    
+    while( i + MAXIGIN_COMPRESS_MIN_MATCH <= inNumBytes ) {
 
-            if( ! mingin_writePersistData(
-                    writeHandle,
-                    mx_numSprites * (int)sizeof( MaxiginSprite ),
-                    (unsigned char *)mx_sprites ) ) {
-                
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
+        int  h          =  mx_compressHash( &( inBytes[i] ) );
+        int  candidate  =  mx_compressHashTable[ h ];
+        int  length     =  0;
 
-            if( ! mx_writeIntToPeristentData( writeHandle,
-                                              (int)sizeof( int ) ) ) {
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
-            
-            if( ! mx_writeIntToPeristentData( writeHandle,
-                                              mx_numStripSubSprites ) ) {
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
-            
-            if( ! mingin_writePersistData(
-                    writeHandle,
-                    mx_numStripSubSprites * (int)sizeof( int ),
-                    (unsigned char *)mx_stripSubSprites ) ) {
-                
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
+        mx_compressHashTable[ h ] = i;
 
-            if( ! mx_writeIntToPeristentData(
-                    writeHandle,
-                    (int)sizeof( MaxiginSpriteStrip ) ) ) {
-                
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
-            
-            if( ! mx_writeIntToPeristentData( writeHandle,
-                                              mx_numSpriteStrips ) ) {
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
+        if( candidate != -1 ) {
+            while( i + length < inNumBytes
+                   &&
+                   inBytes[ candidate + length ] == inBytes[ i + length ] ) {
+                length ++;
                 }
+            }
 
-            if( ! mingin_writePersistData(
-                    writeHandle,
-                    mx_numSpriteStrips * (int)sizeof( MaxiginSpriteStrip ),
-                    (unsigned char *)mx_spriteStrips ) ) {
-                
-                mx_spriteCacheWriteFailed( writeHandle );
-                return;
-                }
+        if( length < MAXIGIN_COMPRESS_MIN_MATCH ) {
+            i ++;
+            continue;
+            }
 
-            mingin_endWritePersistData( writeHandle );
+        pos = mx_compressEmit( &( inBytes[ literalStart ] ),
+                               i - literalStart,
+                               length,
+                               i - candidate,
+                               outBytes,
+                               pos,
+                               inMaxBytes );
+        if( pos == -1 ) {
+            return -1;
             }
+        
+        i            += length;
+        literalStart  = i;
         }
+
+    /* rest are literals, followed by a 0-length match to end */
+    return mx_compressEmit( &( inBytes[ literalStart ] ),
+                            inNumBytes - literalStart,
+                            0,
+                            0,
+                            outBytes,
+                            pos,
+                            inMaxBytes );
     }
 
 
 
-/* returns 1 on success, 0 on failure */
-static char mx_saveGameToDataStore( int  inStoreWriteHandle ) {
-    
-    char  *fingerprint;
-    int    numTotalBytes;
-    char   success;
-    int    i;
+/*
+  Decompresses bytes compressed by mx_compressBytes.
 
-    fingerprint = mx_getMemRecordsFingerprint( &numTotalBytes );
+  Parameters:
 
+      inBytes      the compressed bytes
 
-    success = mx_writeIntToPeristentData( inStoreWriteHandle,
-                                          numTotalBytes );
+      inNumBytes   how many compressed bytes there are
 
-    if( ! success ) {
+      outBytes     buffer where decompressed bytes should be written
+
+      inOutBytes   how many decompressed bytes are expected
+
+  Returns 1 on success, 0 on failure (corrupt compressed bytes, or
+  wrong number of decompressed bytes).
+*/
+static char mx_decompressBytes( const unsigned char  *inBytes,
+                                int                   inNumBytes,
+                                unsigned char        *outBytes,
+                                int                   inOutBytes ) {
+    
+    int            pos     =  0;
+    int            out     =  0;
+    unsigned long  value;
+    unsigned long  distance;
+    int            n;
+    
+    while( 1 ) {
         
-MAXIGIN_SAVED_GAME_WRITE_FAILURE:
+        if( ! mx_decodeVarint( inBytes, inNumBytes, &pos, &value )
+            ||
+            value > (unsigned long)( inOutBytes - out )
+            ||
+            value > (unsigned long)( inNumBytes - pos ) ) {
+            /* bad literal count */
+            return 0;
+            }
         
-        maxigin_logString( "Failed to write to saved game data: ",
-                           mx_saveGameDataStoreName );
-        return 0;
-        }
+        n = (int)value;
 
+        mx_copyBytes( &( outBytes[ out ] ),
+                      &( inBytes[ pos ] ),
+                      n );
+        out += n;
+        pos += n;
 
-    success = mx_writeIntToPeristentData( inStoreWriteHandle,
-                                          mx_numMemRecords );
+        if( ! mx_decodeVarint( inBytes, inNumBytes, &pos, &value )
+            ||
+            value > (unsigned long)( inOutBytes - out ) ) {
+            /* bad match length */
+            return 0;
+            }
 
-    if( ! success ) {
-        goto MAXIGIN_SAVED_GAME_WRITE_FAILURE;
-        }
+        if( value == 0 ) {
+            /* end */
+            break;
+            }
 
-    
-    success = mx_writeStringToPeristentData( inStoreWriteHandle,
-                                             fingerprint );
-    
-    if( ! success ) {
-        goto MAXIGIN_SAVED_GAME_WRITE_FAILURE;
-        }
+        if( ! mx_decodeVarint( inBytes, inNumBytes, &pos, &distance )
+            ||
+            distance == 0
+            ||
+            distance > (unsigned long)out ) {
+            /* bad match distance */
+            return 0;
+            }
 
-    /* first write all the descriptions and sizes
-       on loading, we can bail out if these don't match, before
-       overwriting anything */
-    for( i = 0;
-         i < mx_numMemRecords;
-         i ++ ) {
-        
-        const char *des = mx_memRecords[i].description;
+        /* byte at a time, because match can overlap what it produces */
+        for( n = (int)value;
+             n > 0;
+             n -- ) {
+            
+            outBytes[ out ] = outBytes[ out - (int)distance ];
+            out ++;
+            }
+        }
     
-        success = mx_writeStringToPeristentData( inStoreWriteHandle,
-                                                 des );
+    return ( out == inOutBytes );
+    }
 
-        if( ! success ) {
-            goto MAXIGIN_SAVED_GAME_WRITE_FAILURE;
-            }
+
+
+/*
+  Finds the next byte at or after inByte that differs between two recording
+  buffers, skipping over unchanged memory a chunk of words at a time.
+
+  Only the first inNumBytes are compared, but the rest of the last word
+  must match in both buffers.
+  
+  Returns inNumBytes if no more bytes differ.
+*/
+static int mx_findNextChangedByte( const unsigned long  *inBufferA,
+                                   const unsigned long  *inBufferB,
+                                   int                   inNumBytes,
+                                   int                   inByte ) {
+
+    int                   wordBytes  =  (int)sizeof( unsigned long );
+    int                   numWords   =  ( inNumBytes + wordBytes - 1 ) /
+                                        wordBytes;
+    int                   w          =  inByte / wordBytes;
+    int                   b          =  inByte;
+    const unsigned char  *bytesA     =  (const unsigned char*)inBufferA;
+    const unsigned char  *bytesB     =  (const unsigned char*)inBufferB;
+
+    /* finish the word we start in a byte at a time */
+    while( b < inNumBytes
+           &&
+           b % wordBytes != 0 ) {
         
-        success = mx_writeIntToPeristentData( inStoreWriteHandle,
-                                              mx_memRecords[i].numBytes );
-        if( ! success ) {
-            goto MAXIGIN_SAVED_GAME_WRITE_FAILURE;
+        if( bytesA[b] != bytesB[b] ) {
+            return b;
             }
+        b++;
+        }
+    
+    if( b >= inNumBytes ) {
+        return inNumBytes;
         }
 
-    /* now write the actual memory regions */
-    for( i = 0;
-         i < mx_numMemRecords;
-         i ++ ) {
-        
-        /* write numBytes from memory location into storage */
-        success = mingin_writePersistData(
-            inStoreWriteHandle,
-            mx_memRecords[i].numBytes,
-            (unsigned char*)mx_memRecords[i].pointer );
+    w = b / wordBytes;
+    
+    /* skip whole chunks of unchanged words */
+    while( w + MAXIGIN_RECORDING_DIFF_CHUNK_WORDS <= numWords
+           &&
+           ( ( inBufferA[ w     ] ^ inBufferB[ w     ] ) |
+             ( inBufferA[ w + 1 ] ^ inBufferB[ w + 1 ] ) |
+             ( inBufferA[ w + 2 ] ^ inBufferB[ w + 2 ] ) |
+             ( inBufferA[ w + 3 ] ^ inBufferB[ w + 3 ] ) ) == 0 ) {
         
-        if( ! success ) {
-            goto MAXIGIN_SAVED_GAME_WRITE_FAILURE;
-            }
+        w += MAXIGIN_RECORDING_DIFF_CHUNK_WORDS;
         }
 
-    return 1;
-    }
+    /* then single unchanged words */
+    while( w < numWords
+           &&
+           inBufferA[w] == inBufferB[w] ) {
+        w++;
+        }
 
+    if( w >= numWords ) {
+        return inNumBytes;
+        }
 
+    /* find the changed byte in this word */
+    b = w * wordBytes;
 
-static void mx_saveGame( void ) {
-    
-    int  outHandle;
-    
-    if( mx_numMemRecords == 0 ) {
-        return;
+    while( bytesA[b] == bytesB[b] ) {
+        b++;
+        }
+
+    if( b >= inNumBytes ) {
+        return inNumBytes;
         }
     
-    outHandle = mingin_startWritePersistData( mx_saveGameDataStoreName );
+    return b;
+    }
 
-    if( outHandle == -1 ) {
-        maxigin_logString( "Failed to open saved game for writing: ",
-                           mx_saveGameDataStoreName );
-        return;
+
+
+/*
+  Waits for the recording writer to write all waiting steps, and then
+  ends the recording writer thread, if there is one.
+*/
+static void mx_endRecordingWriter( void ) {
+    
+    if( mx_recordingWriterThreadRunning ) {
+        mingin_endWorkerThread();
+        mx_recordingWriterThreadRunning = 0;
         }
+    }
+
+
 
-    mx_saveGameToDataStore( outHandle );
+static void mx_closeRecordingDataStores( void ) {
+
+    /* writer must be done with the stores before we close them */
+    mx_endRecordingWriter();
     
-    mingin_endWritePersistData( outHandle );
+    if( mx_recordingDataStoreHandle != -1 ) {
+        mingin_endWritePersistData( mx_recordingDataStoreHandle );
+        }
+    if( mx_recordingIndexDataStoreHandle != -1 ) {
+        mingin_endWritePersistData( mx_recordingIndexDataStoreHandle );
+        }
 
-    mingin_log( "Saved game.\n" );
+    mx_recordingDataStoreHandle = -1;
+    mx_recordingIndexDataStoreHandle = -1;
+
+    mx_recordingRunning = 0;
     }
 
 
 
-/* returns 1 on success, 0 on failure */
-static char mx_restoreStaticMemoryFromDataStore( int inStoreReadHandle ) {
+/*
+  Encodes just-started or just-ended sound effects at inPos in
+  mx_recordingBlockBuffer.
+
+  Returns position in mx_recordingBlockBuffer after encoded data.
+*/
+static int mx_encodeSoundEffectsTriggers( int         inPos,
+                                          int         inNumSoundEffects,
+                                          const int  *inHandles,
+                                          const int  *inLoudness ) {
+
+    int  pos  =  inPos;
+    int  s;
     
-    char        *fingerprint;
-    int          numTotalBytes;
-    int          readNumTotalBytes;
-    int          readNumMemRecords;
-    char         success;
-    int          i;
-    const char  *readFingerprint;
+    /* number of sound effects */
+    pos += mx_encodeVarint( (unsigned long)inNumSoundEffects,
+                            &( mx_recordingBlockBuffer[ pos ] ) );
 
-    if( mx_numMemRecords == 0 ) {
-        return 0;
+    /* handle and loudness of each just-started (or ended) sound effect */
+    for( s = 0;
+         s < inNumSoundEffects;
+         s ++ ) {
+        
+        pos += mx_encodeVarint( mx_zigZag( inHandles[ s ] ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
+        pos += mx_encodeVarint( mx_zigZag( inLoudness[ s ] ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
         }
-    
-    fingerprint = mx_getMemRecordsFingerprint( &numTotalBytes );
 
-    maxigin_logInt( "Registered live static memory total bytes:  ",
-                    numTotalBytes );
- 
-    success = mx_readIntFromPersistData( inStoreReadHandle,
-                                         &readNumTotalBytes );
+    return pos;
+    }
 
-    if( ! success ) {
-        mingin_log( "Failed to read total num bytes from save data.\n" );
-        return 0;
-        }
 
-    if( readNumTotalBytes != numTotalBytes ) {
-        mingin_log( "Save data does not match current total memory bytes, "
-                    "ignoring.\n" );
-        
-        maxigin_logInt( "Save data has numTotalBytes = ",
-                        readNumTotalBytes );
-        
-        maxigin_logInt( "Current live numTotalBytes = ",
-                        numTotalBytes );
-        
-        return 0;
-        }
 
-    success = mx_readIntFromPersistData( inStoreReadHandle,
-                                         &readNumMemRecords );
+/*
+  Encodes live sound effects at inPos in mx_recordingBlockBuffer.
 
-    if( ! success ) {
-        mingin_log( "Failed to read num memory records from save data.\n" );
-        return 0;
-        }
+  Returns position in mx_recordingBlockBuffer after encoded data.
+*/
+static int mx_encodeLiveSoundEffects( int                    inPos,
+                                      MaxiginRecordingStep  *inStep ) {
+
+    int  pos  =  inPos;
+    int  s;
+
+    pos += mx_encodeVarint( (unsigned long)inStep->numLive,
+                            &( mx_recordingBlockBuffer[ pos ] ) );
     
-    if( readNumMemRecords != mx_numMemRecords ) {
-        mingin_log( "Save data does not match current mx_numMemRecords, "
-                    "ignoring.\n" );
-        
-        maxigin_logInt( "Save data has mx_numMemRecords = ",
-                        readNumMemRecords );
-        
-        maxigin_logInt( "Current live mx_numMemRecords = ",
-                        mx_numMemRecords );
+    /* handle, loudness, and position of each */
+    for( s = 0;
+         s < inStep->numLive;
+         s ++ ) {
         
-        return 0;
+        pos += mx_encodeVarint( mx_zigZag( inStep->liveHandles[ s ] ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
+        pos += mx_encodeVarint( mx_zigZag( inStep->liveLoudness[ s ] ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
+        pos += mx_encodeVarint( mx_zigZag( inStep->liveDataPositions[ s ] ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
         }
-    
 
+    return pos;
+    }
 
-    readFingerprint = mx_readShortStringFromPersistData( inStoreReadHandle );
+
+
+/*
+  Encodes the part that starts the body of both block types, step number,
+  music position, and sound effects, at the start of mx_recordingBlockBuffer.
+
+  If inIncludeTriggers is 0, just-started and just-ended sound effects
+  are left out, because a diff block for the same step already has them.
+  
+  Returns position in mx_recordingBlockBuffer after encoded data.
+*/
+static int mx_encodeBlockBodyStart( MaxiginRecordingStep  *inStep,
+                                    char                   inIncludeTriggers ) {
+
+    int  pos  =  0;
     
-    if( readFingerprint == 0 ) {
-        mingin_log( "Failed to read fingerprint from save data.\n" );
-        return 0;
-        }
+    pos += mx_encodeVarint( (unsigned long)inStep->stepNumber,
+                            &( mx_recordingBlockBuffer[ pos ] ) );
     
+    pos += mx_encodeVarint( mx_zigZag( inStep->musicPos ),
+                            &( mx_recordingBlockBuffer[ pos ] ) );
+
+    if( inIncludeTriggers ) {
+        pos = mx_encodeSoundEffectsTriggers( pos,
+                                             inStep->numJustStarted,
+                                             inStep->justStartedHandles,
+                                             inStep->justStartedLoudness );
     
-    if( ! maxigin_stringsEqual( fingerprint,
-                                readFingerprint ) ) {
-        
-        mingin_log( "Save data does not match current memory fingerprint, "
-                    "ignoring.\n" );
-        
-        maxigin_logString( "Save data has fingerprint = ",
-                           readFingerprint );
-        
-        maxigin_logString( "Current live has fingerprint = ",
-                           fingerprint );
-        
-        return 0;
+        pos = mx_encodeSoundEffectsTriggers( pos,
+                                             inStep->numJustEnded,
+                                             inStep->justEndedHandles,
+                                             inStep->justEndedLoudness );
+        }
+    else {
+        pos = mx_encodeSoundEffectsTriggers( pos, 0, 0, 0 );
+        pos = mx_encodeSoundEffectsTriggers( pos, 0, 0, 0 );
         }
+    
+    pos = mx_encodeLiveSoundEffects( pos,
+                                     inStep );
 
-    /* now read the memory records from the saved data */
+    return pos;
+    }
+
+
+
+/*
+  Encodes the player input of a captured step at inPos in
+  mx_recordingBlockBuffer.
+
+  Returns position in mx_recordingBlockBuffer after encoded data.
+*/
+static int mx_encodeStepInput( int                    inPos,
+                               MaxiginRecordingStep  *inStep ) {
+
+    MaxiginStepInput  *input        =  &( inStep->input );
+    int                pos          =  inPos;
+    int                numDown      =  0;
+    int                numSticks    =  0;
+    int                i;
 
-    /* first read the descriptions and sizes to make sure they all match */
     for( i = 0;
-         i < mx_numMemRecords;
+         i < mx_numGameButtons;
          i ++ ) {
         
-        const char *liveDes = mx_memRecords[i].description;
-        const char *readDes =
-            mx_readShortStringFromPersistData( inStoreReadHandle );
-        
-        int readNumBytes;
-        
-        if( readDes == 0 ) {
-            maxigin_logInt( "Failed to read saved description for record # = ",
-                            i );
-            return 0;
-            }
-        
-        if( ! maxigin_stringsEqual( liveDes,
-                                    readDes ) ) {
-            maxigin_logInt( "Save data has wrong description for record # = ",
-                            i );
-            
-            maxigin_logString( "Save data has description = ",
-                               readDes );
-
-            maxigin_logString( "Live description = ",
-                               liveDes );
-            
-            return 0;
+        if( input->buttonsDown[ i ] ) {
+            numDown ++;
             }
+        }
+    
+    pos += mx_encodeVarint( (unsigned long)numDown,
+                            &( mx_recordingBlockBuffer[ pos ] ) );
+    
+    for( i = 0;
+         i < mx_numGameButtons;
+         i ++ ) {
         
-        
-        success = mx_readIntFromPersistData( inStoreReadHandle,
-                                             &readNumBytes );
-        
-        if( ! success ) {
-            maxigin_logInt( "Failed to read saved numBytes for record # = ",
-                            i );
-            return 0;
+        if( input->buttonsDown[ i ] ) {
+            pos += mx_encodeVarint( (unsigned long)i,
+                                    &( mx_recordingBlockBuffer[ pos ] ) );
             }
+        }
 
-        if( readNumBytes != mx_memRecords[i].numBytes ) {
-            maxigin_logInt( "Save data has wrong numBytes for record # = ",
-                            i );
-            
-            maxigin_logInt( "Save data has numBytes = ",
-                            readNumBytes );
+    
+    pos += mx_encodeVarint( (unsigned long)input->pointerAvailable,
+                            &( mx_recordingBlockBuffer[ pos ] ) );
 
-            maxigin_logInt( "Live numBytes = ",
-                            mx_memRecords[i].numBytes );
+    if( input->pointerAvailable ) {
+        pos += mx_encodeVarint( mx_zigZag( input->pointerX ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
+        pos += mx_encodeVarint( mx_zigZag( input->pointerY ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
+        }
 
-            return 0;
+    
+    for( i = 0;
+         i < mx_numGameSticks;
+         i ++ ) {
+        
+        if( input->stickAvailable[ i ] ) {
+            numSticks ++;
             }
-
         }
-
     
-    /* Now it's safe to reach the memory regions into memory
-       since everything above matches */
+    pos += mx_encodeVarint( (unsigned long)numSticks,
+                            &( mx_recordingBlockBuffer[ pos ] ) );
     
     for( i = 0;
-         i < mx_numMemRecords;
+         i < mx_numGameSticks;
          i ++ ) {
         
-        /* read numBytes from memory location into storage */
-        int numRead = mingin_readPersistData(
-            inStoreReadHandle,
-            mx_memRecords[i].numBytes,
-            (unsigned char*)mx_memRecords[i].pointer );
-        
-        if( numRead !=  mx_memRecords[i].numBytes ) {
-            maxigin_logInt(
-                "Failed to read memory data from save data for record # = ", i );
-
-            return 0;
+        if( input->stickAvailable[ i ] ) {
+            pos += mx_encodeVarint( (unsigned long)i,
+                                    &( mx_recordingBlockBuffer[ pos ] ) );
+            pos += mx_encodeVarint( mx_zigZag( input->stickPositions[ i ] ),
+                                    &( mx_recordingBlockBuffer[ pos ] ) );
+            pos += mx_encodeVarint( mx_zigZag( input->stickLowerLimits[ i ] ),
+                                    &( mx_recordingBlockBuffer[ pos ] ) );
+            pos += mx_encodeVarint( mx_zigZag( input->stickUpperLimits[ i ] ),
+                                    &( mx_recordingBlockBuffer[ pos ] ) );
             }
         }
 
-    return 1;
+    return pos;
     }
 
 
 
-static void mx_checkStartupPlaybackResume( void ) {
+/*
+  Writes the position of a block's start at the end of the block,
+  as a 4-byte little-endian int.
 
-    char  resume  =  maxigin_readFlagSetting( "maxigin_resumePlayback.ini",
-                                              0 );
-    int   pos;
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writeBlockStartPos( int  inStartPos ) {
+    
+    return mx_writeFixedIntToPersistData( mx_recordingDataStoreHandle,
+                                          inStartPos );
+    }
 
-    if( ! resume ) {
-        return;
+
+
+/*
+  Reads the position of a block's start from the end of a block.
+
+  Version 1 blocks end with a padded int, and later blocks with
+  a 4-byte little-endian int.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_readBlockStartPos( int   inStoreReadHandle,
+                                  int   inVersion,
+                                  int  *outStartPos ) {
+
+    if( inVersion == 1 ) {
+        return mx_readPaddedIntFromPeristentData( inStoreReadHandle,
+                                                  outStartPos );
         }
+    
+    return mx_readFixedIntFromPersistData( inStoreReadHandle,
+                                           outStartPos );
+    }
 
-    pos = maxigin_readIntSetting( "maxigin_resumePlaybackPos.ini",
-                                  -1 );
 
-    if( pos == -1 ) {
-        return;
-        }
 
-    
-    mx_playbackBlockForwardSounds = 1;
-                    
-    mx_initPlayback();
+/* returns length of start position at end of blocks of inVersion */
+static int mx_getBlockStartPosLength( int  inVersion ) {
+    if( inVersion == 1 ) {
+        return MAXIGIN_PADDED_INT_LENGTH;
+        }
+    return MAXIGIN_BLOCK_START_POS_LENGTH;
+    }
 
-    /* jump to saved step */
-    mx_playbackJumpToStep( pos );
 
-    mx_playbackBlockForwardSounds = 0;
 
-    
-    /* start paused in that spot
-       
-       This is very useful when hot-reloading to tweak the position
-       of something mid-move */
+/*
+  Writes the header and body length that start a block.
 
-    mx_playbackSpeed =
-        maxigin_readIntSetting( "maxigin_resumePlaybackSpeed.ini",
-                                1 );
-    
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writeBlockStart( const char  *inHeader,
+                                int          inBodyLength ) {
     
-    mx_playbackDirection =
-        (char)maxigin_readIntSetting( "maxigin_resumePlaybackDirection.ini",
-                                      1 );
+    char  success;
     
-        
-    mx_playbackPaused =
-        (char)maxigin_readIntSetting( "maxigin_resumePlaybackPaused.ini",
-                                      1 );
+    success = mx_writeStringToPeristentData( mx_recordingDataStoreHandle,
+                                             inHeader );
     
-
-    /* sound speed to 0 when paused */
-    if( mx_playbackPaused ) {
-        mx_setSoundSpeedAndDirection( 0,
-                                      mx_playbackDirection );
-        }
-    else {
-        mx_setSoundSpeedAndDirection( mx_playbackSpeed,
-                                      mx_playbackDirection );
+    if( ! success ) {
+        return 0;
         }
-
-    mx_loadLoopPoints();
     
+    return mx_writeVarintToPersistData( mx_recordingDataStoreHandle,
+                                        (unsigned long)inBodyLength );
     }
 
 
 
+/*
+  Writes a full memory snapshot of a captured step to
+  mx_recordingDataStoreHandle
 
-void maxigin_initRestoreStaticMemoryFromLastRun( void ) {
-    char success;
+  Called by the recording writer, which might be running in a worker thread,
+  so failures are only logged with mingin_log.
 
-    int storeSize;
-    int readHandle;
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_recordFullMemorySnapshot( MaxiginRecordingStep  *inStep ) {
     
-    if( ! mx_areWeInMaxiginGameInitFunction ) {
-        mingin_log( "Game tried to call "
-                    "maxigin_initRestoreStaticMemoryFromLastRun "
-                    "from outside of maxiginGame_init\n" );
-        return;
+    int   startPos  =
+              mingin_getPersistDataPosition( mx_recordingDataStoreHandle );
+    char  success;
+    int   bodyStartLength;
+    int   compressedLength;
+    int   maxCompressedLength;
+    
+    if( startPos == -1 ) {
+        mingin_log( "Failed to get current recording data store postion.\n" );
+        return 0;
         }
     
-    readHandle = mingin_startReadPersistData( mx_saveGameDataStoreName,
-                                              &storeSize );
-
-    if( readHandle == -1 ) {
-        maxigin_logString( "Failed to open saved game for reading: ",
-                           mx_saveGameDataStoreName );
-        return;
+        
+    /* write the step number and starting pos of this full snapshot into our
+       index data store
+       use a padded int so that we can jump by 12 + 12 bytes to go
+       "frame by frame" through the index.
+    */
+    
+    success =
+        mx_writePaddedIntToPerisistentData( mx_recordingIndexDataStoreHandle,
+                                            inStep->stepNumber );
+    if( ! success ) {
+        mingin_log( "Failed to write step number to recording index data\n" );
+        return 0;
         }
 
-    success = mx_restoreStaticMemoryFromDataStore( readHandle );
-
-    mingin_endReadPersistData( readHandle );
+    
+    success =
+        mx_writePaddedIntToPerisistentData( mx_recordingIndexDataStoreHandle,
+                                            startPos );
+    if( ! success ) {
+        mingin_log(
+            "Failed to write data position to recording index data\n" );
+        return 0;
+        }
+    
 
+    /* a diff for this same step already has the just-started and
+       just-ended sound effects */
+    bodyStartLength =
+        mx_encodeBlockBodyStart(
+            inStep,
+            inStep->type == MAXIGIN_RECORD_FULL_SNAPSHOT );
+    
+    /* compress memory after body start, only keeping it if it's
+       smaller than the raw memory */
+    maxCompressedLength = mx_recordingBlockBufferBytes - bodyStartLength;
 
-    if( !success ) {
-        return;
+    if( maxCompressedLength > mx_totalMemoryRecordsBytes - 1 ) {
+        maxCompressedLength = mx_totalMemoryRecordsBytes - 1;
         }
-    mingin_log( "Restored live memory from saved game data.\n" );
+    
+    compressedLength =
+        mx_compressBytes( (unsigned char*)( inStep->memory ),
+                          mx_totalMemoryRecordsBytes,
+                          &( mx_recordingBlockBuffer[ bodyStartLength ] ),
+                          maxCompressedLength );
 
+    if( compressedLength != -1 ) {
+        
+        success = mx_writeBlockStart( "F3",
+                                      bodyStartLength + compressedLength );
 
-    mx_checkStartupPlaybackResume();
-    }
+        if( success ) {
+            success = mingin_writePersistData( mx_recordingDataStoreHandle,
+                                               bodyStartLength
+                                               + compressedLength,
+                                               mx_recordingBlockBuffer );
+            }
+        
+        if( ! success ) {
+            mingin_log( "Failed to write compressed full memory snapshot "
+                        "to recording data\n" );
+            return 0;
+            }
+        }
+    else {
+        /* doesn't compress, write raw memory */
+        success = mx_writeBlockStart( "F2",
+                                      bodyStartLength +
+                                      mx_totalMemoryRecordsBytes );
 
+        if( success ) {
+            success = mingin_writePersistData( mx_recordingDataStoreHandle,
+                                               bodyStartLength,
+                                               mx_recordingBlockBuffer );
+            }
+    
+        if( ! success ) {
+            mingin_log(
+                "Failed to write full memory snapshot header in recording\n" );
+            return 0;
+            }
+        
+    
+        success =
+            mingin_writePersistData( mx_recordingDataStoreHandle,
+                                     mx_totalMemoryRecordsBytes,
+                                     (unsigned char*)( inStep->memory ) );
 
+        if( ! success ) {
+            mingin_log( "Failed to write data block to recording data\n" );
+            return 0;
+            }
+        }
+    
+    /* write the position of this block start.
+       this will help us during reverse playback */
+    success = mx_writeBlockStartPos( startPos );
 
+    if( ! success ) {
+        mingin_log( "Failed to write recording full snapshot start position "
+                    " at end of snapshot block.\n" );
+        return 0;
+        }
 
+    /* full snapshots are our crash recovery points
+       flush the recording data before the index, so that the index never
+       points at a snapshot that didn't make it out */
+    success = mingin_flushPersistData( mx_recordingDataStoreHandle );
 
+    if( success ) {
+        success = mingin_flushPersistData( mx_recordingIndexDataStoreHandle );
+        }
+    
+    if( ! success ) {
+        mingin_log( "Failed to flush recording data after full snapshot.\n" );
+        return 0;
+        }
 
+    return 1;
+    }
 
-#if( MAXIGIN_ENABLE_RECORDING == 0 )
-    /* recording is off, shrink our recording buffer down to nothing */
-    #undef   MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES
-    #define  MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES  1
-#endif
 
 
 /*
-  buffer for our last state represented in the recording data store
-  and our current state, used for computing the next diff.
-*/
-static unsigned char mx_recordingBuffers[2][
-    MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES ];
-
-static  int          mx_latestRecordingIndex           =  -1;
-static  int          mx_recordingDataStoreHandle       =  -1;
-static  int          mx_recordingIndexDataStoreHandle  =  -1;
-
-static  char         mx_diffRecordingEnabled           =  1;
+  Reads a block header and checks it against inTargetLetter.
 
-static  int          mx_numDiffsSinceLastFullSnapshot  =  0;
-static  int          mx_totalStepsRecorded             =  0;
-
-static  const char  *mx_recordingMagicFooter           =  "MX_RECORDING";
-static  char         mx_newPlaybackStarting            =  0;
-
-
-/*
-  Copies snapshot of memory into the next rotating slot of  mx_recordingBuffers
-  and updates mx_latestRecordingIndex to continue the rotation.
+  Version 1 headers are just the letter, and later versions have their
+  version digit after the letter.
+  
+  Returns block format version if header found matching inTargetLetter,
+  0 if not
 */
-static void mx_copyMemoryIntoRecordingBuffer( void ) {
+static int mx_checkHeader( int         inStoreReadHandle,
+                           const char  inTargetLetter ) {
     
-    int             r;
-    int             b           =  0;
-    int             nextBuffer  =  mx_latestRecordingIndex + 1;
-    unsigned char  *buffer;
+    const char  *header  =
+                     mx_readShortStringFromPersistData( inStoreReadHandle );
 
-    if( nextBuffer > 1 ) {
-        nextBuffer = 0;
+    if( header == 0 ||
+        header[0] != inTargetLetter ) {
+        
+        /* bad header */
+        return 0;
         }
 
-    buffer =  mx_recordingBuffers[ nextBuffer ];
-    
-    
-    if( ! mx_diffRecordingEnabled ) {
-        return;
+    if( header[1] == '\0' ) {
+        return 1;
         }
 
-    for( r = 0;
-         r < mx_numMemRecords;
-         r ++ ) {
+    if( header[1] >= '2' && header[1] <= '9'
+        &&
+        header[2] == '\0' ) {
 
-        int             rb          =  0;
-        int             recSize     =  mx_memRecords[r].numBytes;
-        unsigned char  *recPointer  =
-                            (unsigned char*)( mx_memRecords[r].pointer );
-        
-        while( rb < recSize ) {
-            buffer[b] = recPointer[ rb ];
-            b++;
-            rb++;
-            }
+        return header[1] - '0';
         }
-    
-    mx_latestRecordingIndex = nextBuffer; 
+
+    /* bad header */
+    return 0;
     }
 
 
 
-static void mx_closeRecordingDataStores( void ) {
+/*
+  Plays back a recorded sound effect trigger.
+  
+  inStartingdOrEnding  is  1 for playing back starting sound effects
+                           0 for playing back ending sound effects
+*/
+static void mx_playbackSoundEffectTrigger( int   inHandle,
+                                           int   inLoudness,
+                                           char  inStartingOrEnding ) {
+    
+    /* only play them if we're not paused */
+    if( ! mx_playbackPaused ) {
 
-    if( mx_recordingDataStoreHandle != -1 ) {
-        mingin_endWritePersistData( mx_recordingDataStoreHandle );
-        }
-    if( mx_recordingIndexDataStoreHandle != -1 ) {
-        mingin_endWritePersistData( mx_recordingIndexDataStoreHandle );
-        }
+        /* decide whether to play based on direction and
+           what kinds of sounds we're playing */
+        if( inStartingOrEnding
+            &&
+            mx_playbackDirection == 1
+            &&
+            ! mx_playbackBlockForwardSounds ) {
 
-    mx_recordingDataStoreHandle = -1;
-    mx_recordingIndexDataStoreHandle = -1;
+            /* starting sounds only if we're playing forward */
+            maxigin_playSoundEffect( inHandle,
+                                     inLoudness );
+            }
+        else if( ! inStartingOrEnding
+                 &&
+                 mx_playbackDirection == -1 ) {
 
-    mx_recordingRunning = 0;
+            /* ending sounds only if we're playing backward */
+            maxigin_playSoundEffect( inHandle,
+                                     inLoudness );
+            }
+        }
     }
 
 
 
-/* returns 1 on success, 0 on error */
-static char mx_recordSoundEffectsTriggers( int (*inCountFunction)( void ),
-                                           int (*inGetNextFunction)( int* ) ) {
+/*
+  inStartingdOrEnding  is  1 for playing back starting sound effects
+                           0 for playing back ending sound effects
+                        
+  returns  1 on success
+           0 on error
+*/
+static char mx_restoreSoundEffectsTriggers( int   inStoreReadHandle,
+                                            char  inStartingOrEnding ) {
 
-    int   numSoundEffects;
+    int   readInt;
+    int   readIntB;
     char  success;
     int   s;
-    int   loudness;
     
-    /* write number of sound effects */
-
-    numSoundEffects = inCountFunction();
-
-    success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                          numSoundEffects );
+    success = mx_readIntFromPersistData( inStoreReadHandle,
+                                         &readInt );
 
     if( ! success ) {
-        mingin_log( "Failed to write sound effects count "
-                    "in recording\n" );
-        
+        /* failed to read num sound effects */
         return 0;
         }
 
-    /* write handle of each just-started (or ended) sound effect, and clear it
-       from list */
-    s = inGetNextFunction( &loudness );
-    
-    while( s != -1 ) {
-        success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                              s );
+    if( readInt > 0 ) {
+        /* some sound effects starting */
 
-        if( ! success ) {
-            mingin_log( "Failed to write sound effect handle "
-                        "in recording\n" );
-            return 0;
-            }
+        int  num  =  readInt;
         
-        success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                              loudness );
+        for( s = 0;
+             s < num;
+             s ++ ) {
 
-        if( ! success ) {
-            mingin_log( "Failed to write sound effect loudness "
-                        "in recording\n" );
-            return 0;
+            success = mx_readIntFromPersistData( inStoreReadHandle,
+                                                 &readInt );
+            if( ! success ) {
+                /* failed to read next sound effect handle */
+                return 0;
+                }
+            
+            success = mx_readIntFromPersistData( inStoreReadHandle,
+                                                 &readIntB );
+            if( ! success ) {
+                /* failed to read next sound effect loudness */
+                return 0;
+                }
+            
+            mx_playbackSoundEffectTrigger( readInt,
+                                           readIntB,
+                                           inStartingOrEnding );
             }
-        
-        s = inGetNextFunction( &loudness );
         }
 
     return 1;
     }
 
 
+/* plays a sound effect
+   but jumps instantly to inDataPos in that sound effect if inDataPos != -1 */
+static void mx_playSoundEffectWithPos( int inSoundEffectHandle,
+                                       int inLoudness,
+                                       int inDataPos );
+
 
-/* returns 1 on success, 0 on error */
-static char mx_recordJustStartedSoundEffects( void ) {
 
-    return mx_recordSoundEffectsTriggers( mx_getNumJustStartedSoundEffects,
-                                          mx_getNextJustStartedSoundEffect );
-    }
+/* called before a recorded set of live sound effects is played back */
+static void mx_playbackClearLiveSoundEffects( void ) {
+    
+    if( mx_playbackPaused
+        ||
+        mx_playbackJumping ) {
+        
+        /* when restoring live effects, we auto-clear any playing effects
+           because they're probably stale, or left over from a previously-played
+           snapshot (if we're walking forward in time, trying to reach
+           a desired snapshot */
 
+        /* we are paused, so this is safe
+           to do without hearing cut-off glitching */
+        mx_endAllSoundEffectsNow();
+        }
+    }
 
 
-/* returns 1 on success, 0 on error */
-static char mx_recordJustEndedSoundEffects( void ) {
 
-    return mx_recordSoundEffectsTriggers( mx_getNumJustEndedSoundEffects,
-                                          mx_getNextJustEndedSoundEffect );
+/* plays back one recorded live sound effect */
+static void mx_playbackLiveSoundEffect( int  inHandle,
+                                        int  inLoudness,
+                                        int  inDataPos ) {
+    
+    /* only trigger them if we're paused */
+    if( mx_playbackPaused
+        ||
+        mx_playbackJumping ) {
+                
+        mx_playSoundEffectWithPos( inHandle,
+                                   inLoudness,
+                                   inDataPos );
+        }
     }
 
 
 
-/* returns 1 on success, 0 on error */
-static char mx_recordLiveSoundEffects( void ) {
+/*                      
+  returns  1 on success
+           0 on error
+*/
+static char mx_restoreLiveSoundEffects( int   inStoreReadHandle ) {
 
-    int   numSoundEffects;
+    int   readInt;
     char  success;
     int   s;
-
-    static  int  handles[ MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
-    static  int  loudness[ MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
-    static  int  dataPositions[ MAXIGIN_MAX_NUM_PLAYING_SOUND_EFFECTS ];
-    
     
-    /* write number of sound effects */
-
-    numSoundEffects = mx_getLiveSoundEffects( handles,
-                                              loudness,
-                                              dataPositions );
-
-    success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                          numSoundEffects );
+    success = mx_readIntFromPersistData( inStoreReadHandle,
+                                         &readInt );
 
     if( ! success ) {
-        mingin_log( "Failed to write live sound effects count "
-                    "in recording\n" );
-        
+        /* failed to read num sound effects */
         return 0;
         }
 
-    
-    /* write handle and position of each */
-    for( s = 0;
-         s < numSoundEffects;
-         s ++ ) {
-
-        success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                              handles[ s ] );
+    mx_playbackClearLiveSoundEffects();
 
-        if( ! success ) {
-            mingin_log( "Failed to write live sound effect handle "
-                        "in recording\n" );
-            return 0;
-            }
+    if( readInt > 0 ) {
+        /* some sound effects live */
 
-        success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                              loudness[ s ] );
+        int  num  =  readInt;
+        
+        for( s = 0;
+             s < num;
+             s ++ ) {
 
-        if( ! success ) {
-            mingin_log( "Failed to write live sound effect loudness "
-                        "in recording\n" );
-            return 0;
-            }
+            int  handle;
+            int  loudness;
+            int  dataPos;
+            
+            success = mx_readIntFromPersistData( inStoreReadHandle,
+                                                 &handle );
+            if( ! success ) {
+                /* failed to read next sound effect handle */
+                return 0;
+                }
 
-        success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                              dataPositions[ s ] );
+            success = mx_readIntFromPersistData( inStoreReadHandle,
+                                                 &loudness );
+            if( ! success ) {
+                /* failed to read next sound effect loudness */
+                return 0;
+                }
 
-        if( ! success ) {
-            mingin_log( "Failed to write live sound effect data position "
-                        "in recording\n" );
-            return 0;
+            success = mx_readIntFromPersistData( inStoreReadHandle,
+                                                 &dataPos );
+            if( ! success ) {
+                /* failed to read next sound effect dataPos */
+                return 0;
+                }
+            
+            mx_playbackLiveSoundEffect( handle,
+                                        loudness,
+                                        dataPos );
             }
         }
 
@@ -14683,356 +19160,398 @@ static char mx_recordLiveSoundEffects( void ) {
     }
 
 
-
 /*
-  Writes a full memory snapshot to mx_recordingDataStoreHandle
+  Decodes next varint from body in mx_recordingBlockBuffer.
 
-  Does NOT copy current memory state into rotating memory buffer
+  Returns 1 on success, 0 on failure.
 */
-static void mx_recordFullMemorySnapshot( void ) {
-    
-    int   r;
-    int   startPos  =
-              mingin_getPersistDataPosition( mx_recordingDataStoreHandle );
-    char  success;
-    int   musicPos;
+static char mx_decodeBlockVarint( int             inBodyLength,
+                                  int            *ioPos,
+                                  unsigned long  *outValue ) {
     
-    if( startPos == -1 ) {
-        mingin_log( "Failed to get current recording data store postion.\n" );
+    return mx_decodeVarint( mx_recordingBlockBuffer,
+                            inBodyLength,
+                            ioPos,
+                            outValue );
+    }
 
-        mx_closeRecordingDataStores();
-        return;
+
+
+/*
+  Decodes step input from body in mx_recordingBlockBuffer into
+  mx_replayStepInput.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_decodeStepInput( int   inBodyLength,
+                                int  *ioPos ) {
+
+    MaxiginStepInput  *input  =  &mx_replayStepInput;
+    unsigned long      value;
+    unsigned long      handle;
+    unsigned long      valueB;
+    unsigned long      valueC;
+    int                n;
+    int                i;
+
+    for( i = 0;
+         i < MAXIGIN_NUM_GAME_BUTTONS;
+         i ++ ) {
+        input->buttonsDown[ i ] = 0;
         }
     
-        
-    /* write the step number and starting pos of this full snapshot into our
-       index data store
-       use a padded int so that we can jump by 12 + 12 bytes to go
-       "frame by frame" through the index.
-    */
-    
-    success =
-        mx_writePaddedIntToPerisistentData( mx_recordingIndexDataStoreHandle,
-                                            mx_totalStepsRecorded );
-    if( ! success ) {
-        maxigin_logString(
-            "Failed to write step number to recording index data: ",
-            mx_recordingIndexDataStoreName );
-        
-        mx_closeRecordingDataStores();
-        return;
+    for( i = 0;
+         i < MAXIGIN_NUM_GAME_STICKS;
+         i ++ ) {
+        input->stickAvailable[ i ] = 0;
         }
-
     
-    success =
-        mx_writePaddedIntToPerisistentData( mx_recordingIndexDataStoreHandle,
-                                            startPos );
-    if( ! success ) {
-        maxigin_logString(
-            "Failed to write data position to recording index data: ",
-            mx_recordingIndexDataStoreName );
-        
-        mx_closeRecordingDataStores();
-        return;
+    if( ! mx_decodeBlockVarint( inBodyLength, ioPos, &value ) ) {
+        /* failed to read num buttons down */
+        return 0;
         }
-    
 
-    /* write our full snapshot header */
-    success = mx_writeStringToPeristentData( mx_recordingDataStoreHandle,
-                                             "F" );
+    n = (int)value;
 
-    if( ! success ) {
-        mingin_log(
-            "Failed to write full memory snapshot header in recording\n" );
+    for( i = 0;
+         i < n;
+         i ++ ) {
         
-        mx_closeRecordingDataStores();
-        return;
-        }
-
-
-    /* write step number */
-    success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                          mx_totalStepsRecorded );
-
-    if( ! success ) {
-        mingin_log( "Failed to write memory full snapshot step number "
-                    "in recording\n" );
+        if( ! mx_decodeBlockVarint( inBodyLength, ioPos, &handle )
+            ||
+            handle >= (unsigned long)MAXIGIN_NUM_GAME_BUTTONS ) {
+            /* failed to read next button */
+            return 0;
+            }
         
-        mx_closeRecordingDataStores();
-        return;
+        input->buttonsDown[ handle ] = 1;
         }
 
     
-    /* write music position */
-    musicPos = mx_getMusicFilePos();
+    if( ! mx_decodeBlockVarint( inBodyLength, ioPos, &value ) ) {
+        /* failed to read pointer availability */
+        return 0;
+        }
 
-    success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                          musicPos );
+    input->pointerAvailable = (char)( value != 0 );
 
-    if( ! success ) {
-        mingin_log( "Failed to write music position in recording\n" );
+    if( input->pointerAvailable ) {
         
-        mx_closeRecordingDataStores();
-        return;
+        if( ! mx_decodeBlockVarint( inBodyLength, ioPos, &value )
+            ||
+            ! mx_decodeBlockVarint( inBodyLength, ioPos, &valueB ) ) {
+            /* failed to read pointer location */
+            return 0;
+            }
+        
+        input->pointerX = mx_unZigZag( value );
+        input->pointerY = mx_unZigZag( valueB );
         }
 
     
-    success = mx_recordJustStartedSoundEffects();
-
-    if( ! success ) {
-        mingin_log( "Failed to write just-started sound effects "
-                    "in recording\n" );
-        
-        mx_closeRecordingDataStores();
-        return;
+    if( ! mx_decodeBlockVarint( inBodyLength, ioPos, &value ) ) {
+        /* failed to read num sticks */
+        return 0;
         }
 
+    n = (int)value;
 
-    success = mx_recordJustEndedSoundEffects();
-
-    if( ! success ) {
-        mingin_log( "Failed to write just-ended sound effects "
-                    "in recording\n" );
+    for( i = 0;
+         i < n;
+         i ++ ) {
         
-        mx_closeRecordingDataStores();
-        return;
+        if( ! mx_decodeBlockVarint( inBodyLength, ioPos, &handle )
+            ||
+            handle >= (unsigned long)MAXIGIN_NUM_GAME_STICKS
+            ||
+            ! mx_decodeBlockVarint( inBodyLength, ioPos, &value )
+            ||
+            ! mx_decodeBlockVarint( inBodyLength, ioPos, &valueB )
+            ||
+            ! mx_decodeBlockVarint( inBodyLength, ioPos, &valueC ) ) {
+            /* failed to read next stick */
+            return 0;
+            }
+        
+        input->stickAvailable[ handle ]    =  1;
+        input->stickPositions[ handle ]    =  mx_unZigZag( value );
+        input->stickLowerLimits[ handle ]  =  mx_unZigZag( valueB );
+        input->stickUpperLimits[ handle ]  =  mx_unZigZag( valueC );
         }
 
-    
-    success = mx_recordLiveSoundEffects();
+    return 1;
+    }
 
-    if( ! success ) {
-        mingin_log( "Failed to write live sound effects "
-                    "in recording\n" );
-        
-        mx_closeRecordingDataStores();
-        return;
-        }
-    
-    
-    for( r = 0;
-         r < mx_numMemRecords;
-         r ++ ) {
-        
-        int recSize = mx_memRecords[r].numBytes;
-        unsigned char *recPointer = (unsigned char*)( mx_memRecords[r].pointer );
 
-        success =
-            mingin_writePersistData( mx_recordingDataStoreHandle,
-                                     recSize,
-                                     recPointer );
 
-        if( ! success ) {
-            maxigin_logString( "Failed to write data block to recording data: ",
-                               mx_recordingDataStoreName );
-            
-            mx_closeRecordingDataStores();
-            return;
-            }
-        }
-    
-    /* write the position of this block start, as a padded int.
-       this will help us during reverse playback */
-    success = mx_writePaddedIntToPerisistentData( mx_recordingDataStoreHandle,
-                                                  startPos );
+/*
+  Restores a version 2, 3, or 4 block from the current position in a
+  data store, which should be just past the block's header.
 
-    if( ! success ) {
-        mingin_log( "Failed to write recording full snapshot start position "
-                    " at end of snapshot block.\n" );
-        mx_closeRecordingDataStores();
-        return;
-        }
-    }
+  inVersion       is  the block version from the header
 
+  inFullSnapshot  is  1 for a full memory snapshot block
+                      0 for a memory diff block
+  
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_restoreFromBinaryBlock( int   inStoreReadHandle,
+                                       int   inVersion,
+                                       char  inFullSnapshot ) {
+    
+    unsigned long  value;
+    unsigned long  valueB;
+    unsigned long  valueC;
+    int            bodyLength;
+    int            pos                =  0;
+    int            numRead;
+    int            i;
+    int            n;
+    int            s;
+    int            musicPos;
+    int            startPos;
+    int            r;
+    int            offset;
+    int            curRecord;
+    int            curRecordStart;
+    
+    if( ! mx_readVarintFromPersistData( inStoreReadHandle,
+                                        &value )
+        ||
+        value > (unsigned long)mx_recordingBlockBufferBytes ) {
+        /* failed to read body length */
+        return 0;
+        }
 
+    bodyLength = (int)value;
 
-/* Returns 1 if header found matching inTargetLetter, 0 if not */
-static char mx_checkHeader( int         inStoreReadHandle,
-                            const char  inTargetLetter ) {
-    
-    const char  *header  =
-                     mx_readShortStringFromPersistData( inStoreReadHandle );
+    numRead = mingin_readPersistData( inStoreReadHandle,
+                                      bodyLength,
+                                      mx_recordingBlockBuffer );
 
-    if( header == 0 ||
-        header[0] != inTargetLetter ||
-        header[1] != '\0' ) {
-        
-        /* bad header */
+    if( numRead != bodyLength ) {
+        /* failed to read body */
         return 0;
         }
-    
-    return 1;
-    }
 
+    
+    if( ! mx_decodeBlockVarint( bodyLength, &pos, &value ) ) {
+        /* failed to read step number */
+        return 0;
+        }
 
+    mx_playbackCurrentStep = (int)value;
 
-/*
-  inStartingdOrEnding  is  1 for playing back starting sound effects
-                           0 for playing back ending sound effects
-                        
-  returns  1 on success
-           0 on error
-*/
-static char mx_restoreSoundEffectsTriggers( int   inStoreReadHandle,
-                                            char  inStartingOrEnding ) {
+    
+    if( ! mx_decodeBlockVarint( bodyLength, &pos, &value ) ) {
+        /* failed to read music position */
+        return 0;
+        }
 
-    int   readInt;
-    int   readIntB;
-    char  success;
-    int   s;
+    musicPos = mx_unZigZag( value );
     
-    success = mx_readIntFromPersistData( inStoreReadHandle,
-                                         &readInt );
+    if( musicPos != -1 ) {
+        /* a meaningful music position
+           set it... */
+
+        /* but only if we're paused, otherwise there is a lot
+           of sample discontinuity and popping */
+        if( mx_playbackPaused
+            ||
+            mx_playbackJumping
+            ||
+            ( inFullSnapshot
+              &&
+              mx_newPlaybackStarting ) ) {
 
-    if( ! success ) {
-        /* failed to read num sound effects */
-        return 0;
+            /* jumps can land via a keyframe and diffs, not only
+               a full snapshot */
+            mx_setMusicFilePos( musicPos );
+            }
         }
 
-    if( readInt > 0 ) {
-        /* some sound effects starting */
+    
+    /* starting sound effects, then ending sound effects */
+    for( s = 1;
+         s >= 0;
+         s -- ) {
 
-        int  num  =  readInt;
+        if( ! mx_decodeBlockVarint( bodyLength, &pos, &value ) ) {
+            /* failed to read num sound effects */
+            return 0;
+            }
         
-        for( s = 0;
-             s < num;
-             s ++ ) {
+        n = (int)value;
 
-            success = mx_readIntFromPersistData( inStoreReadHandle,
-                                                 &readInt );
-            if( ! success ) {
-                /* failed to read next sound effect handle */
-                return 0;
-                }
+        for( i = 0;
+             i < n;
+             i ++ ) {
             
-            success = mx_readIntFromPersistData( inStoreReadHandle,
-                                                 &readIntB );
-            if( ! success ) {
-                /* failed to read next sound effect loudness */
+            if( ! mx_decodeBlockVarint( bodyLength, &pos, &value )
+                ||
+                ! mx_decodeBlockVarint( bodyLength, &pos, &valueB ) ) {
+                /* failed to read next sound effect */
                 return 0;
                 }
             
-            /* only play them if we're not paused */
-            if( ! mx_playbackPaused ) {
-
-                /* decide whether to play based on direction and
-                   what kinds of sounds we're playing */
-                if( inStartingOrEnding
-                    &&
-                    mx_playbackDirection == 1
-                    &&
-                    ! mx_playbackBlockForwardSounds ) {
-
-                    /* starting sounds only if we're playing forward */
-                    maxigin_playSoundEffect( readInt,
-                                             readIntB );
-                    }
-                else if( ! inStartingOrEnding
-                         &&
-                         mx_playbackDirection == -1 ) {
-
-                    /* ending sounds only if we're playing backward */
-                    maxigin_playSoundEffect( readInt,
-                                             readIntB );
-                    }
-                }
+            mx_playbackSoundEffectTrigger( mx_unZigZag( value ),
+                                           mx_unZigZag( valueB ),
+                                           (char)s );
             }
         }
 
-    return 1;
-    }
-
+    
+    if( ! mx_decodeBlockVarint( bodyLength, &pos, &value ) ) {
+        /* failed to read num live sound effects */
+        return 0;
+        }
 
-/* plays a sound effect
-   but jumps instantly to inDataPos in that sound effect if inDataPos != -1 */
-static void mx_playSoundEffectWithPos( int inSoundEffectHandle,
-                                       int inLoudness,
-                                       int inDataPos );
+    n = (int)value;
 
+    mx_playbackClearLiveSoundEffects();
+    
+    for( i = 0;
+         i < n;
+         i ++ ) {
+            
+        if( ! mx_decodeBlockVarint( bodyLength, &pos, &value )
+            ||
+            ! mx_decodeBlockVarint( bodyLength, &pos, &valueB )
+            ||
+            ! mx_decodeBlockVarint( bodyLength, &pos, &valueC ) ) {
+            /* failed to read next live sound effect */
+            return 0;
+            }
+        
+        mx_playbackLiveSoundEffect( mx_unZigZag( value ),
+                                    mx_unZigZag( valueB ),
+                                    mx_unZigZag( valueC ) );
+        }
 
 
-/*                      
-  returns  1 on success
-           0 on error
-*/
-static char mx_restoreLiveSoundEffects( int   inStoreReadHandle ) {
+    if( inVersion == 4 ) {
+        
+        if( ! mx_decodeStepInput( bodyLength, &pos ) ) {
+            return 0;
+            }
 
-    int   readInt;
-    char  success;
-    int   s;
-    
-    success = mx_readIntFromPersistData( inStoreReadHandle,
-                                         &readInt );
+        mx_replayStepInputLoaded = 1;
 
-    if( ! success ) {
-        /* failed to read num sound effects */
-        return 0;
+        if( mx_playbackSimulatingSteps ) {
+            /* caller steps the game with this input instead */
+            return mx_readBlockStartPos( inStoreReadHandle,
+                                         inVersion,
+                                         &startPos );
+            }
         }
+    
+    
+    if( inFullSnapshot ) {
 
-    if( mx_playbackPaused
-        ||
-        mx_playbackJumping ) {
+        if( inVersion == 3 ) {
+            /* compressed, decompress after end of body
+               compressed snapshots are smaller than our memory records,
+               so block buffer always has room for both */
+            if( bodyLength + mx_totalMemoryRecordsBytes >
+                mx_recordingBlockBufferBytes
+                ||
+                ! mx_decompressBytes( &( mx_recordingBlockBuffer[ pos ] ),
+                                      bodyLength - pos,
+                                      &( mx_recordingBlockBuffer[
+                                             bodyLength ] ),
+                                      mx_totalMemoryRecordsBytes ) ) {
+                /* snapshot doesn't match our memory records */
+                return 0;
+                }
+            
+            pos = bodyLength;
+            }
+        else if( bodyLength - pos != mx_totalMemoryRecordsBytes ) {
+            /* snapshot doesn't match our memory records */
+            return 0;
+            }
         
-        /* when restoring live effects, we auto-clear any playing effects
-           because they're probably stale, or left over from a previously-played
-           snapshot (if we're walking forward in time, trying to reach
-           a desired snapshot */
-
-        /* we are paused, so this is safe
-           to do without hearing cut-off glitching */
-        mx_endAllSoundEffectsNow();
+        for( r = 0;
+             r < mx_numMemRecords;
+             r ++ ) {
+        
+            int  recSize  =  mx_memRecords[r].numBytes;
+        
+            mx_copyBytes( (unsigned char*)( mx_memRecords[r].pointer ),
+                          &( mx_recordingBlockBuffer[ pos ] ),
+                          recSize );
+            pos += recSize;
+            }
         }
-
-    if( readInt > 0 ) {
-        /* some sound effects live */
-
-        int  num  =  readInt;
+    else {
+        /* runs of changed bytes in our full static memory space,
+           with static regions butted end-to-end */
+        offset          =  0;
+        curRecord       =  0;
+        curRecordStart  =  0;
         
-        for( s = 0;
-             s < num;
-             s ++ ) {
-
-            int  handle;
-            int  loudness;
-            int  dataPos;
+        while( 1 ) {
             
-            success = mx_readIntFromPersistData( inStoreReadHandle,
-                                                 &handle );
-            if( ! success ) {
-                /* failed to read next sound effect handle */
+            if( ! mx_decodeBlockVarint( bodyLength, &pos, &value )
+                ||
+                ! mx_decodeBlockVarint( bodyLength, &pos, &valueB ) ) {
+                /* failed to read run gap and length */
                 return 0;
                 }
 
-            success = mx_readIntFromPersistData( inStoreReadHandle,
-                                                 &loudness );
-            if( ! success ) {
-                /* failed to read next sound effect loudness */
-                return 0;
+            if( valueB == 0 ) {
+                /* end of diff */
+                break;
                 }
 
-            success = mx_readIntFromPersistData( inStoreReadHandle,
-                                                 &dataPos );
-            if( ! success ) {
-                /* failed to read next sound effect dataPos */
+            if( value > (unsigned long)mx_totalMemoryRecordsBytes
+                ||
+                valueB > (unsigned long)( bodyLength - pos ) ) {
+                /* run past end of memory or block */
                 return 0;
                 }
+
+            offset += (int)value;
+
+            n = (int)valueB;
             
-            /* only trigger them if we're paused */
-            if( mx_playbackPaused
-                ||
-                mx_playbackJumping ) {
-                
-                mx_playSoundEffectWithPos( handle,
-                                           loudness,
-                                           dataPos );
+            for( i = 0;
+                 i < n;
+                 i ++ ) {
+
+                while( offset >=
+                       curRecordStart + mx_memRecords[ curRecord ].numBytes ) {
+                    /* gone past the end of our current record
+                       start marching into next record */
+                    curRecordStart += mx_memRecords[ curRecord ].numBytes;
+                    
+                    curRecord ++;
+                    if( curRecord >= mx_numMemRecords ) {
+                        /* diff includes offsets that go beyond our last
+                           live memory record */
+                        return 0;
+                        }
+                    }
+
+                /* apply our xor */
+                ( (unsigned char*)( mx_memRecords[ curRecord ].pointer ) )
+                    [ offset - curRecordStart ] ^=
+                    mx_recordingBlockBuffer[ pos ];
+
+                offset ++;
+                pos ++;
                 }
             }
         }
-
-    return 1;
+    
+    /* now read start position footer, just to get past it */
+    return mx_readBlockStartPos( inStoreReadHandle,
+                                 2,
+                                 &startPos );
     }
 
 
+
 /*
   Restores a full memory snapshot from current position in a data store.
 
@@ -15044,11 +19563,24 @@ static char mx_restoreFromFullMemorySnapshot( int  inStoreReadHandle ) {
     int   startPos;
     char  success;
     int   readInt;
+    int   version;
     
-    if( ! mx_checkHeader( inStoreReadHandle, 'F' ) ) {
+    version = mx_checkHeader( inStoreReadHandle, 'F' );
+    
+    if( version == 0 ) {
         return 0;
         }
 
+    mx_playbackBlockVersion = version;
+
+    if( version == 2
+        ||
+        version == 3 ) {
+        return mx_restoreFromBinaryBlock( inStoreReadHandle,
+                                          version,
+                                          1 );
+        }
+
     success = mx_readIntFromPersistData( inStoreReadHandle,
                                          &readInt );
 
@@ -15145,186 +19677,119 @@ static char mx_restoreFromFullMemorySnapshot( int  inStoreReadHandle ) {
 
     
 /*
-  Writes a memory diff to mx_recordingDataStoreHandle
+  Writes a memory diff between two captured steps to
+  mx_recordingDataStoreHandle
+
+  Called by the recording writer, which might be running in a worker thread,
+  so failures are only logged with mingin_log.
 
-  Copies current memory state into rotating memory buffer
+  Returns 1 on success, 0 on failure.
 */
-static void mx_recordMemoryDiff( void ) {
+static char mx_recordMemoryDiff( MaxiginRecordingStep  *inPrevStep,
+                                 MaxiginRecordingStep  *inStep ) {
     
-    int   prevIndex    =  mx_latestRecordingIndex;
-    int   newIndex     =  0;
-    int   b;
-    int   lastWritten  =  0;
-    char  success;
-    int   startPos;
-    int   musicPos;
+    int             b;
+    int             lastWritten  =  0;
+    char            success;
+    int             startPos;
+    int             pos;
+    unsigned char  *prevBytes    =  (unsigned char*)( inPrevStep->memory );
+    unsigned char  *newBytes     =  (unsigned char*)( inStep->memory );
     
     if( ! mx_diffRecordingEnabled ) {
-        return;
+        return 1;
         }
 
     startPos = mingin_getPersistDataPosition( mx_recordingDataStoreHandle );
     
     if( startPos == -1 ) {
         mingin_log( "Failed to get current recording data store postion.\n" );
-
-        mx_closeRecordingDataStores();
-        return;
-        }
-    
-    mx_copyMemoryIntoRecordingBuffer();
-
-    newIndex = mx_latestRecordingIndex;
-
-    
-    if( newIndex == prevIndex ) {
-        mingin_log( "Failed to update mx_latestRecordingIndex when recording "
-                    "memory diff." );
-        
-        mx_closeRecordingDataStores();
-        return;
-        }
-    
-        
-
-    /* header for a diff */
-    success = mx_writeStringToPeristentData( mx_recordingDataStoreHandle,
-                                             "D" );
-
-    if( ! success ) {
-        mingin_log( "Failed to write memory diff header in recording\n" );
-        
-        mx_closeRecordingDataStores();
-        return;
-        }
-
-    /* write step number */
-    success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                          mx_totalStepsRecorded );
-
-    if( ! success ) {
-        mingin_log( "Failed to write memory diff step number in recording\n" );
-        
-        mx_closeRecordingDataStores();
-        return;
-        }
-
-    /* write music position */
-    musicPos = mx_getMusicFilePos();
-
-    success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                          musicPos );
-
-    if( ! success ) {
-        mingin_log( "Failed to write music position in recording\n" );
-        
-        mx_closeRecordingDataStores();
-        return;
+        return 0;
         }
-
-
-    success = mx_recordJustStartedSoundEffects();
-
-    if( ! success ) {
-        mingin_log( "Failed to write just-started sound effects "
-                    "in recording\n" );
         
-        mx_closeRecordingDataStores();
-        return;
-        }
 
+    pos = mx_encodeBlockBodyStart( inStep,
+                                   1 );
 
-    success = mx_recordJustEndedSoundEffects();
-
-    if( ! success ) {
-        mingin_log( "Failed to write just-ended sound effects "
-                    "in recording\n" );
-        
-        mx_closeRecordingDataStores();
-        return;
-        }
-    
-    
-    success = mx_recordLiveSoundEffects();
-
-    if( ! success ) {
-        mingin_log( "Failed to write live sound effects "
-                    "in recording\n" );
-        
-        mx_closeRecordingDataStores();
-        return;
-        }
+    pos = mx_encodeStepInput( pos,
+                              inStep );
     
+    /* only compare the bytes we have registered */
+    b = mx_findNextChangedByte( inPrevStep->memory,
+                                inStep->memory,
+                                mx_totalMemoryRecordsBytes,
+                                0 );
     
-    
-    for( b = 0;
-         b < MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES;
-         b ++ ) {
+    while( b < mx_totalMemoryRecordsBytes ) {
         
-        if( mx_recordingBuffers[prevIndex][b] !=
-            mx_recordingBuffers[newIndex][b] ) {
+        /* a byte has changed, start of a run of changed bytes */
+        int  runStart  =  b;
+        int  runEnd    =  b + 1;
 
-            /* a byte has changed */
-            
-            unsigned char  xorValue  =
-                mx_recordingBuffers[prevIndex][b]
-                ^
-                mx_recordingBuffers[newIndex][b];
+        while( runEnd < mx_totalMemoryRecordsBytes
+               &&
+               prevBytes[ runEnd ] != newBytes[ runEnd ] ) {
+            runEnd ++;
+            }
             
+        /* gap from end of previous run, and run length */
+        pos += mx_encodeVarint( (unsigned long)( runStart - lastWritten ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
+        pos += mx_encodeVarint( (unsigned long)( runEnd - runStart ),
+                                &( mx_recordingBlockBuffer[ pos ] ) );
+
+        /* xor of each byte with previous value */
+        for( b = runStart;
+             b < runEnd;
+             b ++ ) {
                 
-            /* write its position offset from the previous one recorded */
-            success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                                  b - lastWritten );
-
-            if( ! success ) {
-                mingin_log( "Failed to write diff position in recording\n" );
-        
-                mx_closeRecordingDataStores();
-                return;
-                }
+            mx_recordingBlockBuffer[ pos ] =
+                (unsigned char)( prevBytes[b] ^ newBytes[b] );
+            pos ++;
+            }
             
-            lastWritten = b;
+        lastWritten = runEnd;
 
-            /* write its xor with previous value */
-            success = mingin_writePersistData(
-                mx_recordingDataStoreHandle, 1,
-                &( xorValue ) );
-            
-            if( ! success ) {
-                mingin_log( "Failed to write diff byte in recording\n" );
-        
-                mx_closeRecordingDataStores();
-                return;
-                }
-            }
+        b = mx_findNextChangedByte( inPrevStep->memory,
+                                    inStep->memory,
+                                    mx_totalMemoryRecordsBytes,
+                                    runEnd );
         }
 
-    /* write -1 to end of diff, so that we know it's over
-       (each line in the diff starts with a valid non-negative position
-       in our memory snapshot */
+    /* zero-length run to end the diff */
+    pos += mx_encodeVarint( 0,
+                            &( mx_recordingBlockBuffer[ pos ] ) );
+    pos += mx_encodeVarint( 0,
+                            &( mx_recordingBlockBuffer[ pos ] ) );
     
-    success = mx_writeIntToPeristentData( mx_recordingDataStoreHandle,
-                                          -1 );
+
+    /* header for a diff */
+    success = mx_writeBlockStart( "D4",
+                                  pos );
+
+    if( success ) {
+        success = mingin_writePersistData( mx_recordingDataStoreHandle,
+                                           pos,
+                                           mx_recordingBlockBuffer );
+        }
     
     if( ! success ) {
-        mingin_log( "Failed to write diff footer in recording\n" );
-        
-        mx_closeRecordingDataStores();
-        return;
+        mingin_log( "Failed to write memory diff in recording\n" );
+        return 0;
         }
 
     
-    /* write the position of this block start, as a padded int.
+    /* write the position of this block start.
        this will help us during reverse playback */
-    success = mx_writePaddedIntToPerisistentData( mx_recordingDataStoreHandle,
-                                                  startPos );
+    success = mx_writeBlockStartPos( startPos );
 
     if( ! success ) {
         mingin_log( "Failed to write recording diff snapshot start position "
-                    " at end of snapshot block.\n" );
-        mx_closeRecordingDataStores();
-        return;
-        } 
+                    " at end of snapshot block.\n" );
+        return 0;
+        }
+
+    return 1;
     }
 
 
@@ -15344,17 +19809,30 @@ static char mx_restoreFromMemoryDiff( int inStoreReadHandle ) {
     unsigned char  *curRecordPointer;
     int             numRead;
     int             startPos;
+    int             version;
+    
     
+    version = mx_checkHeader( inStoreReadHandle, 'D' );
     
-    if( ! mx_checkHeader( inStoreReadHandle, 'D' ) ) {
+    if( version == 0 ) {
         return 0;
         }
 
+    mx_playbackBlockVersion = version;
+
     if( mx_numMemRecords == 0 ) {
         /* trying to restore diff into no live memory records */
         return 0;
         }
 
+    if( version == 2
+        ||
+        version == 4 ) {
+        return mx_restoreFromBinaryBlock( inStoreReadHandle,
+                                          version,
+                                          0 );
+        }
+
     curRecordPointer = (unsigned char*)( mx_memRecords[ curRecord ].pointer );
 
 
@@ -15496,10 +19974,216 @@ static char mx_restoreFromMemoryDiff( int inStoreReadHandle ) {
     
 
 
+/*
+  Writes one captured step out to the recording data stores.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_writeRecordingStep( MaxiginRecordingStep  *inPrevStep,
+                                   MaxiginRecordingStep  *inStep ) {
+
+    char  success  =  1;
+    
+    if( inStep->type != MAXIGIN_RECORD_FULL_SNAPSHOT ) {
+        success = mx_recordMemoryDiff( inPrevStep,
+                                       inStep );
+        }
+
+    /* always record a diff right before our snapshot so that
+       we can play the change recorded in our snapshot backwards */
+    if( success
+        &&
+        inStep->type != MAXIGIN_RECORD_DIFF ) {
+        
+        success = mx_recordFullMemorySnapshot( inStep );
+        }
+
+    /* hand this step off to the platform, so that a crash only loses
+       the steps that haven't been written yet */
+    if( success
+        &&
+        ! mingin_flushPersistData( mx_recordingDataStoreHandle ) ) {
+        
+        mingin_log( "Failed to flush recording data.\n" );
+        success = 0;
+        }
+
+    return success;
+    }
+
+
+
+/*
+  Writes out all captured steps that are waiting in mx_recordingRing.
+
+  This is the recording writer.  It's called from a worker thread if the
+  platform has one, or right from the game step if not.
+*/
+static void mx_writeWaitingRecordingSteps( void ) {
+
+    while( 1 ) {
+        
+        int   writePos;
+        int   prevPos;
+        char  nothingWaiting;
+
+        mingin_lockWorker();
+        
+        writePos        =  mx_recordingRingWritePos;
+        nothingWaiting  =  ( writePos == mx_recordingRingCapturePos
+                             ||
+                             mx_recordingWriterFailed );
+        
+        mingin_unlockWorker();
+
+        if( nothingWaiting ) {
+            return;
+            }
+
+        prevPos = writePos - 1;
+
+        if( prevPos < 0 ) {
+            prevPos = mx_recordingRingSteps - 1;
+            }
+        
+        if( ! mx_writeRecordingStep( &( mx_recordingRing[ prevPos ] ),
+                                     &( mx_recordingRing[ writePos ] ) ) ) {
+            mingin_lockWorker();
+            mx_recordingWriterFailed = 1;
+            mingin_unlockWorker();
+            return;
+            }
+
+        mingin_lockWorker();
+        
+        mx_recordingRingWritePos ++;
+
+        if( mx_recordingRingWritePos >= mx_recordingRingSteps ) {
+            mx_recordingRingWritePos = 0;
+            }
+        
+        mingin_unlockWorker();
+        }
+    }
+
+
+
+/* returns 1 if the recording writer has failed */
+static char mx_hasRecordingWriterFailed( void ) {
+
+    char  failed;
+    
+    mingin_lockWorker();
+    failed = mx_recordingWriterFailed;
+    mingin_unlockWorker();
+
+    return failed;
+    }
+
+
+
+/*
+  Captures memory and sound state for the current step into
+  mx_recordingRing, and hands it off to the recording writer.
+
+  Returns 1 on success, 0 if the recording writer has failed.
+*/
+static char mx_captureRecordingStep( MaxiginRecordingStepType  inType ) {
+    
+    MaxiginRecordingStep  *step;
+    int                    numWaiting;
+    int                    s;
+    int                    loudness;
+
+    mingin_lockWorker();
+    numWaiting = mx_recordingRingCapturePos - mx_recordingRingWritePos;
+    mingin_unlockWorker();
+
+    if( numWaiting < 0 ) {
+        numWaiting += mx_recordingRingSteps;
+        }
+    
+    if( numWaiting >= mx_recordingRingSteps - 1 ) {
+        /* ring is full, writer has fallen behind
+           wait for it to catch up */
+        mingin_waitForWorkerThread();
+
+        if( mx_hasRecordingWriterFailed() ) {
+            return 0;
+            }
+        }
+
+    /* only the game step changes the capture position,
+       so we don't need a lock to read it */
+    step = &( mx_recordingRing[ mx_recordingRingCapturePos ] );
+
+    step->type        =  inType;
+    step->stepNumber  =  mx_totalStepsRecorded;
+    step->musicPos    =  mx_getMusicFilePos();
+
+    
+    /* take just-started and just-ended sound effects, clearing them
+       from their lists */
+    step->numJustStarted = 0;
+    
+    s = mx_getNextJustStartedSoundEffect( &loudness );
+    
+    while( s != -1 ) {
+        step->justStartedHandles[ step->numJustStarted ]   =  s;
+        step->justStartedLoudness[ step->numJustStarted ]  =  loudness;
+        step->numJustStarted ++;
+        
+        s = mx_getNextJustStartedSoundEffect( &loudness );
+        }
+
+    step->numJustEnded = 0;
+    
+    s = mx_getNextJustEndedSoundEffect( &loudness );
+    
+    while( s != -1 ) {
+        step->justEndedHandles[ step->numJustEnded ]   =  s;
+        step->justEndedLoudness[ step->numJustEnded ]  =  loudness;
+        step->numJustEnded ++;
+        
+        s = mx_getNextJustEndedSoundEffect( &loudness );
+        }
+
+    step->numLive = mx_getLiveSoundEffects( step->liveHandles,
+                                            step->liveLoudness,
+                                            step->liveDataPositions );
+
+    /* platform input doesn't change during our step, so this is what
+       the game step just saw */
+    mx_captureStepInput( &( step->input ) );
+    
+    mx_copyMemoryIntoBuffer( step->memory );
+
+
+    mingin_lockWorker();
+
+    mx_recordingRingCapturePos ++;
+
+    if( mx_recordingRingCapturePos >= mx_recordingRingSteps ) {
+        mx_recordingRingCapturePos = 0;
+        }
+    
+    mingin_unlockWorker();
+
+    
+    if( mx_recordingWriterThreadRunning ) {
+        mingin_wakeWorkerThread();
+        }
+    else {
+        mx_writeWaitingRecordingSteps();
+        }
+
+    return 1;
+    }
+
+
+
 static void mx_initRecording( void ) {
     
-    int  b;
-    int  i;
     int  success;
     
     mx_recordingRunning    = 0;
@@ -15515,10 +20199,11 @@ static void mx_initRecording( void ) {
     if( mx_numMemRecords == 0 ) {
         return;
         }
-    if( MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES <
-        mx_totalMemoryRecordsBytes ) {
+    if( ! mx_layoutRecordingArena()
+        ||
+        mx_recordingRingSteps < 2 ) {
         
-        maxigin_logInt2( "Only have room for recording ",
+        maxigin_logInt2( "Only have room for recording about ",
                          MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES,
                          " bytes, but ",
                          mx_totalMemoryRecordsBytes,
@@ -15557,106 +20242,319 @@ static void mx_initRecording( void ) {
         return;
         }
     
-    /* zero out both buffers */
-    for( i = 0;
-         i < 2;
-         i ++ ) {
+    mx_recordingRingCapturePos  =  0;
+    mx_recordingRingWritePos    =  0;
+    mx_recordingWriterFailed    =  0;
+
+    /* diffing, encoding, and writing happen in the background if we can,
+       so the game step only has to capture memory */
+    mx_recordingWriterThreadRunning =
+        mingin_startWorkerThread( mx_writeWaitingRecordingSteps );
+
+    if( ! mx_captureRecordingStep( MAXIGIN_RECORD_FULL_SNAPSHOT )
+        ||
+        mx_hasRecordingWriterFailed() ) {
+
+        mingin_log( "Failed to write first full snapshot to recording.\n" );
         
-        for( b = 0;
-             b < MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES;
-             b ++ ) {
+        mx_closeRecordingDataStores();
+        return;
+        }
+
+    mx_numDiffsSinceLastFullSnapshot = 0;
+
+    mx_recordingRunning = 1;
+    }
+
+
+
+static void mx_stepRecording( void ) {
+
+    char  success;
+    
+    if( ! MAXIGIN_ENABLE_RECORDING
+        ||
+        ! mx_recordingRunning ) {
+        return;
+        }
+
+    
+    if( mx_hasRecordingWriterFailed() ) {
+        mingin_log( "Recording writer failed, ending recording.\n" );
+        
+        mx_closeRecordingDataStores();
+        return;
+        }
+    
+    if( mx_numDiffsSinceLastFullSnapshot < mx_diffsBetweenSnapshots ) {
+        success = mx_captureRecordingStep( MAXIGIN_RECORD_DIFF );
+        
+        mx_numDiffsSinceLastFullSnapshot ++;
+        }
+    else {
+        success =
+            mx_captureRecordingStep( MAXIGIN_RECORD_DIFF_AND_FULL_SNAPSHOT );
+        
+        mx_numDiffsSinceLastFullSnapshot = 0;
+        }
+    
+    mx_totalStepsRecorded ++;
+
+    if( ! success ) {
+        mingin_log( "Recording writer failed, ending recording.\n" );
+        
+        mx_closeRecordingDataStores();
+        }
+    }
+
+
+
+/*
+  Copies bytes from one open read data store into the end
+  of an open write data store.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_copyIntoDataStore( int inStoreReadHandle,
+                                  int inStoreWriteHandle,
+                                  int inNumBytesToCopy ) {
+    
+    enum{  BUFFER_LEN  =  512  };
+    
+    static  unsigned char  buffer[ BUFFER_LEN ];
+
+    int  numCopied  =  0;
             
-            mx_recordingBuffers[i][b] = 0;
+
+    while( numCopied < inNumBytesToCopy ) {
+        
+        int   numLeft      =  inNumBytesToCopy - numCopied;
+        int   numThisTime  =  numLeft;
+        int   numRead;
+        char  success;
+        
+        if( numThisTime > BUFFER_LEN ) {
+            numThisTime = BUFFER_LEN;
+            }
+        
+        numRead = mingin_readPersistData( inStoreReadHandle,
+                                          numThisTime,
+                                          buffer );
+
+        if( numRead == -1 || numRead < numThisTime ) {
+            /* error in read, or reached end of data before we got
+               inNumBytesToCopy */
+            return 0;
+            }
+        
+        success = mingin_writePersistData( inStoreWriteHandle,
+                                           numRead,
+                                           buffer );
+
+        if( ! success ) {
+            return 0;
             }
+        numCopied += numRead;
         }
     
-    mx_recordFullMemorySnapshot();
+    return 1;
+    }
 
-    mx_numDiffsSinceLastFullSnapshot = 0;
+
+
+/*
+  Checks whether the full snapshot block at inPos in an open recording
+  data store ends before inRecordingLength.
+
+  Returns 1 if the whole block is there, 0 if it was cut off or
+  can't be read.
+*/
+static char mx_isFullSnapshotComplete( int  inRecordingReadHandle,
+                                       int  inPos,
+                                       int  inRecordingLength ) {
+
+    unsigned long  bodyLength;
+    int            bodyStartPos;
+    int            version;
+    
+    if( ! mingin_seekPersistData( inRecordingReadHandle,
+                                  inPos ) ) {
+        return 0;
+        }
+
+    version = mx_checkHeader( inRecordingReadHandle, 'F' );
+    
+    if( version != 2
+        &&
+        version != 3 ) {
+        return 0;
+        }
+
+    if( ! mx_readVarintFromPersistData( inRecordingReadHandle,
+                                        &bodyLength ) ) {
+        return 0;
+        }
+
+    bodyStartPos = mingin_getPersistDataPosition( inRecordingReadHandle );
+
+    if( bodyStartPos == -1
+        ||
+        bodyLength > (unsigned long)mx_getRecordingBlockMaxBytes() ) {
+        return 0;
+        }
+
+    if( bodyStartPos + (int)bodyLength + MAXIGIN_BLOCK_START_POS_LENGTH
+        > inRecordingLength ) {
+        return 0;
+        }
     
-    mx_copyMemoryIntoRecordingBuffer();
+    return 1;
+    }
+
+
+
+/*
+  Reads a padded recording index from an open read data store, and appends
+  it in compact form to the end of an open write data store.
+
+  Entries that point past the end of the recording data are skipped,
+  along with any partial entry at the end of the padded index.
+
+  An index entry can reach storage before all of its snapshot does, so
+  after a crash, the last entry can point at a full snapshot that starts
+  inside the data but was cut off.  If inRecordingReadHandle is given,
+  that entry is checked against the data and dropped if incomplete.
+
+  Parameters:
 
-    mx_recordingRunning = 1;
-    }
+      inIndexReadHandle        handle of the read store holding the
+                               padded index
 
+      inIndexLength            length of the padded index, in bytes
 
+      inStoreWriteHandle       handle of the write store to append the
+                               compact index to
 
-static void mx_stepRecording( void ) {
-    if( ! MAXIGIN_ENABLE_RECORDING
-        ||
-        ! mx_recordingRunning ) {
-        return;
-        }
+      inRecordingReadHandle    handle of a read store holding the recording
+                               data, or -1 to skip checking the last entry
 
-    
-    if( mx_numDiffsSinceLastFullSnapshot < mx_diffsBetweenSnapshots ) {
-        mx_recordMemoryDiff();
-        mx_numDiffsSinceLastFullSnapshot ++;
-        mx_totalStepsRecorded ++;
-        }
-    else {
-        /* always record a diff right before our snapshot so that
-           we can play the change recorded in our snapshot backwards */
-        mx_recordMemoryDiff();
-        
-        mx_recordFullMemorySnapshot();
-        mx_totalStepsRecorded ++;
-        
-        mx_numDiffsSinceLastFullSnapshot = 0;
-        }
-    }
+      inRecordingLength        length of the recording data that the
+                               index points into
 
+      outLastFullSnapshotPos   pointer to where the data position of the
+                               last full snapshot in the compact index
+                               should be returned, or -1 if the compact index
+                               is empty
 
+  Returns:
 
-/*
-  Copies bytes from one open read data store into the end
-  of an open write data store.
+      length of the compact index, in bytes
 
-  Returns 1 on success, 0 on failure.
+      -1   on failure
 */
-static char mx_copyIntoDataStore( int inStoreReadHandle,
-                                  int inStoreWriteHandle,
-                                  int inNumBytesToCopy ) {
-    
-    enum{  BUFFER_LEN  =  512  };
+static int mx_appendCompactRecordingIndex( int   inIndexReadHandle,
+                                           int   inIndexLength,
+                                           int   inStoreWriteHandle,
+                                           int   inRecordingReadHandle,
+                                           int   inRecordingLength,
+                                           int  *outLastFullSnapshotPos ) {
+
+    enum{  BUFFER_ENTRIES  =  64  };
     
-    static  unsigned char  buffer[ BUFFER_LEN ];
+    static  unsigned char  buffer[ BUFFER_ENTRIES
+                                   * MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH ];
 
-    int  numCopied  =  0;
-            
+    int   numEntries     =  inIndexLength / MAXIGIN_PADDED_INDEX_ENTRY_LENGTH;
+    int   numBuffered    =  0;
+    int   compactLength  =  0;
+    int   i;
+    char  success;
 
-    while( numCopied < inNumBytesToCopy ) {
+    /* newest entry is held back until a later one shows that its
+       snapshot is complete, since snapshots are written in order */
+    int   pendingStepNumber  =  -1;
+    int   pendingDataPos     =  -1;
+
+    *outLastFullSnapshotPos = -1;
+    
+    for( i = 0;
+         i <= numEntries;
+         i ++ ) {
         
-        int   numLeft      =  inNumBytesToCopy - numCopied;
-        int   numThisTime  =  numLeft;
-        int   numRead;
-        char  success;
+        int             stepNumber  =  -1;
+        int             dataPos     =  -1;
+        unsigned char  *entry;
+
+        if( i < numEntries ) {
+            success = mx_readPaddedIntFromPeristentData( inIndexReadHandle,
+                                                         &stepNumber );
+            if( ! success ) {
+                return -1;
+                }
         
-        if( numThisTime > BUFFER_LEN ) {
-            numThisTime = BUFFER_LEN;
+            success = mx_readPaddedIntFromPeristentData( inIndexReadHandle,
+                                                         &dataPos );
+            if( ! success ) {
+                return -1;
+                }
+
+            if( dataPos < 0
+                ||
+                dataPos >= inRecordingLength ) {
+                /* snapshot never made it into recording data */
+                continue;
+                }
             }
+        else if( pendingDataPos != -1
+                 &&
+                 inRecordingReadHandle != -1
+                 &&
+                 ! mx_isFullSnapshotComplete( inRecordingReadHandle,
+                                              pendingDataPos,
+                                              inRecordingLength ) ) {
+            /* last snapshot starts in the data but was cut off by crash */
+            pendingDataPos = -1;
+            }
+
+        if( pendingDataPos != -1 ) {
+            
+            entry =
+                &( buffer[ numBuffered * MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH ] );
         
-        numRead = mingin_readPersistData( inStoreReadHandle,
-                                          numThisTime,
-                                          buffer );
+            mx_encodeFixedInt( pendingStepNumber,
+                               entry );
+            mx_encodeFixedInt( pendingDataPos,
+                               &( entry[ MAXIGIN_FIXED_INT_LENGTH ] ) );
 
-        if( numRead == -1 || numRead < numThisTime ) {
-            /* error in read, or reached end of data before we got
-               inNumBytesToCopy */
-            return 0;
-            }
+            *outLastFullSnapshotPos = pendingDataPos;
         
-        success = mingin_writePersistData( inStoreWriteHandle,
-                                           numRead,
-                                           buffer );
+            numBuffered ++;
+            }
 
-        if( ! success ) {
-            return 0;
+        pendingStepNumber = stepNumber;
+        pendingDataPos    = dataPos;
+
+        if( numBuffered == BUFFER_ENTRIES
+            ||
+            ( numBuffered > 0
+              &&
+              i == numEntries ) ) {
+            
+            success = mingin_writePersistData(
+                inStoreWriteHandle,
+                numBuffered * MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH,
+                buffer );
+
+            if( ! success ) {
+                return -1;
+                }
+            
+            compactLength += numBuffered * MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH;
+            numBuffered    = 0;
             }
-        numCopied += numRead;
         }
     
-    return 1;
+    return compactLength;
     }
 
 
@@ -15670,12 +20568,49 @@ static void mx_finalizeRecording( void ) {
     if( mx_recordingRunning ) {
         
         int   indexLength;
+        int   compactIndexLength;
+        int   recordingLength;
+        int   lastFullSnapshotPos;
         char  success;
         int   recordingIndexReadHandle;
+
+        /* get all waiting steps written before we add the index */
+        mx_endRecordingWriter();
+
+        if( mx_recordingWriterFailed ) {
+            mingin_log( "Recording writer failed, not finalizing "
+                        "recording data.\n" );
+            
+            mx_closeRecordingDataStores();
+            return;
+            }
         
-        mingin_endWritePersistData( mx_recordingIndexDataStoreHandle );
+        success =
+            mingin_endWritePersistData( mx_recordingIndexDataStoreHandle );
         mx_recordingIndexDataStoreHandle = -1;
 
+        if( ! success ) {
+            /* index tail might be missing, can't build a compact index */
+            mingin_log( "Failed to finish writing recording index data at "
+                        "end of recording.\n" );
+            
+            mingin_endWritePersistData( mx_recordingDataStoreHandle );
+            mx_recordingDataStoreHandle = -1;
+            return;
+            }
+
+        recordingLength =
+            mingin_getPersistDataPosition( mx_recordingDataStoreHandle );
+
+        if( recordingLength == -1 ) {
+            mingin_log( "Failed to get length of recording data at end "
+                        "of recording.\n" );
+            
+            mingin_endWritePersistData( mx_recordingDataStoreHandle );
+            mx_recordingDataStoreHandle = -1;
+            return;
+            }
+        
         recordingIndexReadHandle =
             mingin_startReadPersistData( mx_recordingIndexDataStoreName,
                                          &indexLength );
@@ -15689,14 +20624,19 @@ static void mx_finalizeRecording( void ) {
             return;
             }
         
-        success = mx_copyIntoDataStore( recordingIndexReadHandle,
-                                        mx_recordingDataStoreHandle,
-                                        indexLength );
+        compactIndexLength =
+            mx_appendCompactRecordingIndex( recordingIndexReadHandle,
+                                            indexLength,
+                                            mx_recordingDataStoreHandle,
+                                            /* all written, nothing cut off */
+                                            -1,
+                                            recordingLength,
+                                            &lastFullSnapshotPos );
 
         mingin_endReadPersistData( recordingIndexReadHandle );
             
-        if( ! success ) {
-            mingin_log( "Failed to copy recording index into end "
+        if( compactIndexLength == -1 ) {
+            mingin_log( "Failed to add compact recording index into end "
                         "of recording data.\n" );
             mingin_endWritePersistData( mx_recordingDataStoreHandle );
             mx_recordingDataStoreHandle = -1;
@@ -15712,7 +20652,7 @@ static void mx_finalizeRecording( void ) {
            padded so we know how far to jump back to read it during playback */
         success = mx_writePaddedIntToPerisistentData(
             mx_recordingDataStoreHandle,
-            indexLength );
+            compactIndexLength );
 
         if( ! success ) {
             mingin_log( "Failed write length of index into end "
@@ -15741,8 +20681,8 @@ static void mx_finalizeRecording( void ) {
         success =  mingin_writePersistData(
             mx_recordingDataStoreHandle,
             /* include the \0 termination */
-            maxigin_stringLength( mx_recordingMagicFooter ) + 1,
-            (unsigned char*)mx_recordingMagicFooter );
+            maxigin_stringLength( mx_recordingCompactMagicFooter ) + 1,
+            (unsigned char*)mx_recordingCompactMagicFooter );
 
         if( ! success ) {
             mingin_log( "Failed write magic footer into end "
@@ -15754,9 +20694,15 @@ static void mx_finalizeRecording( void ) {
             }
             
             
-        mingin_endWritePersistData( mx_recordingDataStoreHandle );
+        success = mingin_endWritePersistData( mx_recordingDataStoreHandle );
         mx_recordingDataStoreHandle = -1;
 
+        if( ! success ) {
+            maxigin_logString( "Failed to finish writing recording data: ",
+                               mx_recordingDataStoreName );
+            return;
+            }
+
         maxigin_logString( "Game recording finalized: ",
                            mx_recordingDataStoreName );
         }
@@ -15791,15 +20737,21 @@ static const char *mx_getRecordingRecoveryFileName( void ) {
 
 
 
-/* returns -1 on failure */
+/*
+  Walks through complete blocks, starting with the full snapshot at
+  inStartSeekPos, and finds the step number of the last one.
+  
+  returns -1 on failure
+*/
 static int mx_getMaxStepNumber( int  inRecordingReadHandle,
-                                int  inStartSeekPos ) {
+                                int  inStartSeekPos,
+                                int  inRecordingLength ) {
 
-    char  success;
-    int   readInt;
-    int   maxStepNumber  =  0;
-    int   curPos;
-    int   r;
+    char           success;
+    unsigned long  value;
+    int            maxStepNumber  =  -1;
+    int            curPos         =  inStartSeekPos;
+    int            version;
     
     success = mingin_seekPersistData( inRecordingReadHandle,
                                       inStartSeekPos );
@@ -15808,90 +20760,64 @@ static int mx_getMaxStepNumber( int  inRecordingReadHandle,
         return -1;
         }
 
-    if( ! mx_checkHeader( inRecordingReadHandle, 'F' ) ) {
-        return -1;
-        }
-
-    success = mx_readIntFromPersistData( inRecordingReadHandle,
-                                         &readInt );
-
-    if( ! success ) {
-        /* failed to read step number */
-        return -1;
-        }
-
-    maxStepNumber = readInt;
-
-
-    /* now skip over the data from this full block */
-    curPos = mingin_getPersistDataPosition( inRecordingReadHandle );
+    version = mx_checkHeader( inRecordingReadHandle, 'F' );
     
-    for( r = 0;
-         r < mx_numMemRecords;
-         r ++ ) {
-        
-        int  recSize  =  mx_memRecords[r].numBytes;
-
-        curPos += recSize;
-        }
-
-    success = mingin_seekPersistData( inRecordingReadHandle, curPos );
-
-    if( ! success ) {
-        /* failed to seek to end of full block position */
+    if( version != 2
+        &&
+        version != 3 ) {
         return -1;
         }
 
-    
-    /* walk through diff blocks until the last one
+    /* walk through blocks until the last complete one
        updating maxStepNumber as we go */
-
+    
     while( success ) {
         
-        if( ! mx_checkHeader( inRecordingReadHandle, 'D' ) ) {
+        int  bodyStartPos;
+        int  blockEndPos;
+        
+        if( ! mx_readVarintFromPersistData( inRecordingReadHandle,
+                                            &value ) ) {
+            /* failed to read body length */
             break;
             }
 
-        success = mx_readIntFromPersistData( inRecordingReadHandle,
-                                             &readInt );
+        bodyStartPos = mingin_getPersistDataPosition( inRecordingReadHandle );
 
-        if( ! success ) {
-            /* failed to read step number */
+        if( bodyStartPos == -1 ) {
             break;
             }
-
-        maxStepNumber = readInt;
         
+        blockEndPos = bodyStartPos + (int)value +
+                      MAXIGIN_BLOCK_START_POS_LENGTH;
 
-        /* now skip over the data from this diff */
-        success = mx_readIntFromPersistData( inRecordingReadHandle,
-                                             &readInt );
-        if( ! success ) {
-            /* must have at least 1 int, at least the -1 at the end,
-               even if diff is empty with no changes */
+        if( value > (unsigned long)mx_getRecordingBlockMaxBytes()
+            ||
+            blockEndPos > inRecordingLength ) {
+            /* block cut off by crash */
             break;
             }
         
-        while( readInt != -1 ) {
+        /* step number starts the body */
+        if( ! mx_readVarintFromPersistData( inRecordingReadHandle,
+                                            &value ) ) {
+            break;
+            }
 
-            /* skip the xor value */
-            unsigned char  xorValue;
-            int            numRead;
-        
-            numRead = mingin_readPersistData( inRecordingReadHandle,
-                                              1,
-                                              &xorValue );
+        maxStepNumber = (int)value;
+        curPos        = blockEndPos;
 
-            if( numRead != 1 ) {
-                success = 0;
-                break;
-                }
+        /* skip the rest of this block */
+        success = mingin_seekPersistData( inRecordingReadHandle,
+                                          curPos );
 
-            /* read index of next diff xor */
-            success = mx_readIntFromPersistData( inRecordingReadHandle,
-                                                 &readInt );
+        if( success ) {
+            version = mx_checkHeader( inRecordingReadHandle, 'D' );
 
-            if( ! success ) {
+            if( version != 2
+                &&
+                version != 4 ) {
+                /* no more diffs */
                 break;
                 }
             }
@@ -15929,6 +20855,7 @@ void mx_recordingCrashRecovery( void ) {
     int          recoveryWriteHandle;
     int          recordingLength;
     int          indexLength;
+    int          compactIndexLength;
     char         success;
     int          lastFullSnapshotPos;
     int          totalSteps;
@@ -15992,32 +20919,31 @@ void mx_recordingCrashRecovery( void ) {
         return;
         }
 
-    success = mx_copyIntoDataStore( indexReadHandle,
-                                    recoveryWriteHandle,
-                                    indexLength );
-            
-    if( ! success ) {
-        mingin_log( "Failed to copy recording index into recovery file.\n" );
+    /* rebuild index in compact form, skipping any full snapshots that
+       didn't make it into the recording data before the crash */
+    compactIndexLength =
+        mx_appendCompactRecordingIndex( indexReadHandle,
+                                        indexLength,
+                                        recoveryWriteHandle,
+                                        recordingReadHandle,
+                                        recordingLength,
+                                        &lastFullSnapshotPos );
+
+    mingin_endReadPersistData( indexReadHandle );
+    
+    if( compactIndexLength == -1 ) {
+        mingin_log( "Failed to rebuild recording index into recovery "
+                    "file.\n" );
 
         mingin_endReadPersistData( recordingReadHandle );
         
         mingin_endWritePersistData( recoveryWriteHandle );
-
-        mingin_endReadPersistData( indexReadHandle ); 
             
         return;
         }
 
-
-    /* read last full snapshot pos from end of index */
-    success = mx_seekAndReadInt( indexReadHandle,
-                                 indexLength - MAXIGIN_PADDED_INT_LENGTH,
-                                 &lastFullSnapshotPos );
-
-    mingin_endReadPersistData( indexReadHandle );
-    
-    if( ! success ) {
-        mingin_log( "Failed to seek/read last offset in recording index "
+    if( lastFullSnapshotPos == -1 ) {
+        mingin_log( "No full snapshots in recording index "
                     "during recovery\n" );
         mingin_endReadPersistData( recordingReadHandle );
         
@@ -16035,7 +20961,7 @@ void mx_recordingCrashRecovery( void ) {
        padded so we know how far to jump back to read it during playback */
     success = mx_writePaddedIntToPerisistentData(
         recoveryWriteHandle,
-        indexLength );
+        compactIndexLength );
 
     if( ! success ) {
         mingin_log( "Failed write length of index into end "
@@ -16050,12 +20976,13 @@ void mx_recordingCrashRecovery( void ) {
     
 
     totalSteps = mx_getMaxStepNumber( recordingReadHandle,
-                                      lastFullSnapshotPos );
+                                      lastFullSnapshotPos,
+                                      recordingLength );
     
     mingin_endReadPersistData( recordingReadHandle );
 
     if( totalSteps == -1 ) {
-        mingin_log( "Failed to determine total step count during"
+        mingin_log( "Failed to determine total step count during "
                     "recording recovery.\n" );
         mingin_endWritePersistData( recoveryWriteHandle );
             
@@ -16066,8 +20993,8 @@ void mx_recordingCrashRecovery( void ) {
         recoveryWriteHandle,
         totalSteps );
 
-    if( totalSteps == -1 ) {
-        mingin_log( "Failed to write total step count during"
+    if( ! success ) {
+        mingin_log( "Failed to write total step count during "
                     "recording recovery.\n" );
         mingin_endWritePersistData( recoveryWriteHandle );
             
@@ -16077,8 +21004,8 @@ void mx_recordingCrashRecovery( void ) {
     success =  mingin_writePersistData(
         recoveryWriteHandle,
         /* include the \0 termination */
-        maxigin_stringLength( mx_recordingMagicFooter ) + 1,
-        (unsigned char*)mx_recordingMagicFooter );
+        maxigin_stringLength( mx_recordingCompactMagicFooter ) + 1,
+        (unsigned char*)mx_recordingCompactMagicFooter );
 
     if( ! success ) {
         mingin_log( "Failed write magic footer into end "
@@ -16089,23 +21016,218 @@ void mx_recordingCrashRecovery( void ) {
         }
             
             
-    mingin_endWritePersistData( recoveryWriteHandle );
+    if( ! mingin_endWritePersistData( recoveryWriteHandle ) ) {
+        maxigin_logString( "Failed to finish writing recording "
+                           "recovery file: ",
+                           recoveryFileName );
+        return;
+        }
+
+    maxigin_logString( "Recording recovery saved into: ",
+                       recoveryFileName );
+    }
+
+
+
+
+
+
+
+
+
+
+
+    
+
+
+/*
+  Looks for a magic footer string at the very end of mx_playbackDataStoreHandle
+
+  Returns data position of footer, or -1 if not found.
+*/
+static int mx_findPlaybackMagicFooter( const char  *inFooter ) {
+
+    char  magicFooterBuffer[ 20 ];
+    int   numRead;
+    char  success;
+    int   magicFooterDataPos  =  mx_playbackDataLength
+                                 - maxigin_stringLength( inFooter )
+                                 - 1;
+    
+    if( magicFooterDataPos < 0 ) {
+        return -1;
+        }
+    
+    success = mingin_seekPersistData( mx_playbackDataStoreHandle,
+                                      magicFooterDataPos );
+    
+    if( ! success ) {
+        return -1;
+        }
+
+    numRead = mingin_readPersistData( mx_playbackDataStoreHandle,
+                                      sizeof( magicFooterBuffer ),
+                                      (unsigned char*)magicFooterBuffer );
+
+    if( numRead != maxigin_stringLength( inFooter ) + 1
+        ||
+        ! maxigin_stringsEqual( inFooter,
+                                magicFooterBuffer ) ) {
+        return -1;
+        }
+
+    return magicFooterDataPos;
+    }
+
+
+
+/*
+  Reads index entries from mx_playbackDataStoreHandle into
+  mx_playbackIndexSteps and mx_playbackIndexPositions, up to
+  MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS.
+
+  mx_playbackIndexStartPos, mx_playbackIndexEntryLength, and
+  mx_playbackNumFullSnapshots must be set before calling.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_loadPlaybackIndex( void ) {
+
+    static  unsigned char  compactEntries[
+                               MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS
+                               * MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH ];
+    
+    int   numToLoad  =  mx_playbackNumFullSnapshots;
+    int   i;
+    char  success;
+
+    mx_playbackIndexNumLoaded = 0;
+    
+    if( numToLoad > MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS ) {
+        maxigin_logInt2( "Playback index has ",
+                         mx_playbackNumFullSnapshots,
+                         " snapshots, but only have room to load ",
+                         MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS,
+                         ".  Rest will be read from playback data store." );
+        
+        numToLoad = MAXIGIN_MAX_PLAYBACK_INDEX_SNAPSHOTS;
+        }
+
+    success = mingin_seekPersistData( mx_playbackDataStoreHandle,
+                                      mx_playbackIndexStartPos );
+
+    if( ! success ) {
+        return 0;
+        }
+
+    if( mx_playbackIndexEntryLength == MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH ) {
+
+        /* fixed-length entries, read them all at once */
+        int  numBytes  =  numToLoad * MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH;
+        int  pos       =  0;
+        
+        if( mingin_readPersistData( mx_playbackDataStoreHandle,
+                                    numBytes,
+                                    compactEntries ) != numBytes ) {
+            return 0;
+            }
+
+        for( i = 0;
+             i < numToLoad;
+             i ++ ) {
+            
+            mx_playbackIndexSteps[i] =
+                mx_decodeFixedInt( &( compactEntries[ pos ] ) );
+            pos += MAXIGIN_FIXED_INT_LENGTH;
+            
+            mx_playbackIndexPositions[i] =
+                mx_decodeFixedInt( &( compactEntries[ pos ] ) );
+            pos += MAXIGIN_FIXED_INT_LENGTH;
+            }
+        }
+    else {
+        /* older padded index */
+        for( i = 0;
+             i < numToLoad;
+             i ++ ) {
 
-    maxigin_logString( "Recording recovery saved into: ",
-                       recoveryFileName );
-    }
+            success =
+                mx_readPaddedIntFromPeristentData(
+                    mx_playbackDataStoreHandle,
+                    &( mx_playbackIndexSteps[i] ) )
+                &&
+                mx_readPaddedIntFromPeristentData(
+                    mx_playbackDataStoreHandle,
+                    &( mx_playbackIndexPositions[i] ) );
 
+            if( ! success ) {
+                return 0;
+                }
+            }
+        }
 
+    mx_playbackIndexNumLoaded = numToLoad;
+    
+    return 1;
+    }
 
 
 
+/*
+  Gets the step number and data position of a full snapshot in the playback
+  index, from the loaded index if possible, or from
+  mx_playbackDataStoreHandle if not.
 
+  Note that reading from mx_playbackDataStoreHandle moves the current
+  playback position.
 
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_getPlaybackIndexEntry( int   inFullSnapshotIndex,
+                                      int  *outStepNumber,
+                                      int  *outDataPos ) {
+    
+    int   indexJumpPos;
+    char  success;
+    
+    if( inFullSnapshotIndex < 0
+        ||
+        inFullSnapshotIndex >= mx_playbackNumFullSnapshots ) {
+        return 0;
+        }
 
+    if( inFullSnapshotIndex < mx_playbackIndexNumLoaded ) {
+        *outStepNumber = mx_playbackIndexSteps    [ inFullSnapshotIndex ];
+        *outDataPos    = mx_playbackIndexPositions[ inFullSnapshotIndex ];
+        return 1;
+        }
 
+    indexJumpPos = mx_playbackIndexStartPos
+                   + mx_playbackIndexEntryLength * inFullSnapshotIndex;
+    
+    success = mingin_seekPersistData( mx_playbackDataStoreHandle,
+                                      indexJumpPos );
 
+    if( ! success ) {
+        return 0;
+        }
 
+    if( mx_playbackIndexEntryLength == MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH ) {
+        
+        return mx_readFixedIntFromPersistData( mx_playbackDataStoreHandle,
+                                               outStepNumber )
+               &&
+               mx_readFixedIntFromPersistData( mx_playbackDataStoreHandle,
+                                               outDataPos );
+        }
     
+    return mx_readPaddedIntFromPeristentData( mx_playbackDataStoreHandle,
+                                              outStepNumber )
+           &&
+           mx_readPaddedIntFromPeristentData( mx_playbackDataStoreHandle,
+                                              outDataPos );
+    }
+
 
 
 static char mx_initPlayback( void ) {
@@ -16115,8 +21237,6 @@ static char mx_initPlayback( void ) {
     int    totalStepsDataPos;
     int    indexLength;
     int    magicFooterDataPos;
-    char   magicFooterBuffer[ 20 ];
-    int    numRead;
     
     int    firstFullSnapshotDataPos;
     int    firstFullSnapshotStepNumber;
@@ -16132,10 +21252,9 @@ static char mx_initPlayback( void ) {
         return 0;
         }
 
-    if( MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES <
-        mx_totalMemoryRecordsBytes ) {
+    if( ! mx_layoutRecordingArena() ) {
         
-        maxigin_logInt2( "Only have room for playing back ",
+        maxigin_logInt2( "Only have room for playing back about ",
                          MAXIGIN_RECORDING_STATIC_MEMORY_MAX_BYTES,
                          " bytes, but ",
                          mx_totalMemoryRecordsBytes,
@@ -16171,39 +21290,21 @@ static char mx_initPlayback( void ) {
         return 0;
         }
 
-    /* jump to end and make sure magic footer is there */
-    magicFooterDataPos = mx_playbackDataLength
-                         - maxigin_stringLength( mx_recordingMagicFooter )
-                         - 1;
-    
-    if( magicFooterDataPos < 0 ) {
-        mingin_log( "Playback file too short to even contain magic footer.\n" );
-        
-        mingin_endReadPersistData( mx_playbackDataStoreHandle );
-        return 0;
-        }
+    /* jump to end and make sure magic footer is there
+       check for compact index footer first, then older padded index footer */
+    mx_playbackIndexEntryLength = MAXIGIN_COMPACT_INDEX_ENTRY_LENGTH;
     
-    success = mingin_seekPersistData( mx_playbackDataStoreHandle,
-                                      magicFooterDataPos );
+    magicFooterDataPos =
+        mx_findPlaybackMagicFooter( mx_recordingCompactMagicFooter );
+
+    if( magicFooterDataPos == -1 ) {
+        mx_playbackIndexEntryLength = MAXIGIN_PADDED_INDEX_ENTRY_LENGTH;
     
-    if( ! success ) {
-        maxigin_logInt( "Failed to seek to this position to read magic footer "
-                        "in playback data store: ",
-                        magicFooterDataPos );
-        
-        mingin_endReadPersistData( mx_playbackDataStoreHandle );
-        return 0;
+        magicFooterDataPos =
+            mx_findPlaybackMagicFooter( mx_recordingMagicFooter );
         }
-
-    numRead = mingin_readPersistData( mx_playbackDataStoreHandle,
-                                      sizeof( magicFooterBuffer ),
-                                      (unsigned char*)magicFooterBuffer );
-
-    if( numRead != maxigin_stringLength( mx_recordingMagicFooter ) + 1
-        ||
-        ! maxigin_stringsEqual( mx_recordingMagicFooter,
-                                magicFooterBuffer ) ) {
-
+    
+    if( magicFooterDataPos == -1 ) {
         maxigin_logString( "Failed to find magic footer string at end of "
                            "playback file: ", mx_recordingMagicFooter );
         
@@ -16261,44 +21362,45 @@ static char mx_initPlayback( void ) {
         return 0;
         }
 
-    mx_playbackIndexStartPos = indexLengthDataPos - indexLength;
+    mx_layoutPlaybackKeyframes();
 
-    success = mx_seekAndReadInt( mx_playbackDataStoreHandle,
-                                 mx_playbackIndexStartPos,
-                                 &firstFullSnapshotStepNumber );
+    mx_playbackIndexStartPos    = indexLengthDataPos - indexLength;
+    mx_playbackNumFullSnapshots = indexLength / mx_playbackIndexEntryLength;
+
+    success = mx_loadPlaybackIndex();
 
     if( ! success ) {
-        maxigin_logInt( "Failed to seek to this position and read first "
-                        "step number in playback data store: ",
+        maxigin_logInt( "Failed to load index from this position "
+                        "in playback data store: ",
                         mx_playbackIndexStartPos );
         
         mingin_endReadPersistData( mx_playbackDataStoreHandle );
         return 0;
         }
 
-    if( firstFullSnapshotStepNumber != 0 ) {
-        maxigin_logInt( "Unexpected first full snapshot step number in "
-                        "playback data store: ",
-                        firstFullSnapshotStepNumber );
+    success = mx_getPlaybackIndexEntry( 0,
+                                        &firstFullSnapshotStepNumber,
+                                        &firstFullSnapshotDataPos );
+
+    if( ! success ) {
+        maxigin_logInt( "Failed to read first index entry from this position "
+                        "in playback data store: ",
+                        mx_playbackIndexStartPos );
         
         mingin_endReadPersistData( mx_playbackDataStoreHandle );
         return 0;
         }
 
-    success = mx_seekAndReadInt( mx_playbackDataStoreHandle,
-                                 mx_playbackIndexStartPos
-                                     + MAXIGIN_PADDED_INT_LENGTH,
-                                 &firstFullSnapshotDataPos);
-
-    if( ! success ) {
-        mingin_log( "Failed to read first snapshot data position"
-                    "playback data store\n" );
+    if( firstFullSnapshotStepNumber != 0 ) {
+        maxigin_logInt( "Unexpected first full snapshot step number in "
+                        "playback data store: ",
+                        firstFullSnapshotStepNumber );
         
         mingin_endReadPersistData( mx_playbackDataStoreHandle );
         return 0;
         }
 
-    
+
     /* now jump to that first full snapshot */
 
     success = mingin_seekPersistData( mx_playbackDataStoreHandle,
@@ -16345,8 +21447,6 @@ static char mx_initPlayback( void ) {
 
     
     mx_playbackFullSnapshotLastPlayed = 0;
-    mx_playbackNumFullSnapshots =
-        indexLength / ( MAXIGIN_PADDED_INT_LENGTH * 2 );
     
     maxigin_logInt( "Playback started successfully with num snapshots: ",
                     mx_playbackNumFullSnapshots );
@@ -16370,6 +21470,126 @@ static void mx_playbackEnd( void ) {
 
 
 
+/*
+  Keeps a keyframe of the current memory state, if inStepNumber falls
+  on a keyframe interval and isn't already kept.
+
+  The current playback position must be the start of the block for the
+  step after inStepNumber.
+*/
+static void mx_playbackCacheKeyframe( int  inStepNumber ) {
+
+    int                       i;
+    int                       dataPos;
+    MaxiginPlaybackKeyframe  *k          =  0;
+
+    if( mx_playbackNumKeyframeSlots == 0
+        ||
+        inStepNumber % MAXIGIN_PLAYBACK_KEYFRAME_INTERVAL != 0 ) {
+        return;
+        }
+
+    mx_playbackKeyframeUseCount ++;
+    
+    for( i = 0;
+         i < mx_playbackNumKeyframeSlots;
+         i ++ ) {
+        
+        if( mx_playbackKeyframes[i].stepNumber == inStepNumber ) {
+            /* already have it */
+            mx_playbackKeyframes[i].lastUsed = mx_playbackKeyframeUseCount;
+            return;
+            }
+        
+        if( k == 0
+            ||
+            mx_playbackKeyframes[i].lastUsed < k->lastUsed ) {
+            /* empty slots have never been used, so they are picked first */
+            k = &( mx_playbackKeyframes[i] );
+            }
+        }
+
+    dataPos = mingin_getPersistDataPosition( mx_playbackDataStoreHandle );
+
+    if( dataPos == -1 ) {
+        return;
+        }
+
+    k->stepNumber              =  inStepNumber;
+    k->dataPos                 =  dataPos;
+    k->fullSnapshotLastPlayed  =  mx_playbackFullSnapshotLastPlayed;
+    k->lastUsed                =  mx_playbackKeyframeUseCount;
+
+    mx_copyMemoryIntoBuffer( k->memory );
+    }
+
+
+
+/*
+  Finds the latest keyframe with a step number in
+  [inMinStepNumber, inMaxStepNumber]
+
+  Returns slot number, or -1 if none found.
+*/
+static int mx_findPlaybackKeyframe( int  inMinStepNumber,
+                                    int  inMaxStepNumber ) {
+    
+    int  i;
+    int  best  =  -1;
+
+    for( i = 0;
+         i < mx_playbackNumKeyframeSlots;
+         i ++ ) {
+
+        int  step  =  mx_playbackKeyframes[i].stepNumber;
+        
+        if( step != -1
+            &&
+            step >= inMinStepNumber
+            &&
+            step <= inMaxStepNumber
+            &&
+            ( best == -1
+              ||
+              step > mx_playbackKeyframes[ best ].stepNumber ) ) {
+            
+            best = i;
+            }
+        }
+    
+    return best;
+    }
+
+
+
+/*
+  Restores memory from a keyframe, and moves playback to the start of
+  the block for the step after it.
+
+  Returns 1 on success, 0 on failure.
+*/
+static char mx_playbackRestoreKeyframe( int  inSlot ) {
+
+    MaxiginPlaybackKeyframe  *k  =  &( mx_playbackKeyframes[ inSlot ] );
+    char                      success;
+
+    success = mingin_seekPersistData( mx_playbackDataStoreHandle,
+                                      k->dataPos );
+
+    if( ! success ) {
+        return 0;
+        }
+
+    mx_copyBufferIntoMemory( k->memory );
+    
+    mx_playbackCurrentStep            =  k->stepNumber;
+    mx_playbackFullSnapshotLastPlayed =  k->fullSnapshotLastPlayed;
+
+    mx_playbackKeyframeUseCount ++;
+    k->lastUsed = mx_playbackKeyframeUseCount;
+    
+    return 1;
+    }
 
 
 
@@ -16388,7 +21608,13 @@ static char mx_playbackSpeedStep( void ) {
         return 1;
         }
     
-    if( mx_playbackSpeed >= 1 ) {
+    if( mx_playbackSpeed > 1
+        &&
+        mx_playbackDirection == -1 ) {
+        
+        success = mx_playbackMultiStepBackward( mx_playbackSpeed );
+        }
+    else if( mx_playbackSpeed >= 1 ) {
         int i;
         /* we can't skip steps because diffs are accumulative  */
         for( i = 0;
@@ -16535,7 +21761,8 @@ static char mx_playbackStepForward( void ) {
             return 0;
             }
         }
-    
+
+    mx_playbackCacheKeyframe( mx_playbackCurrentStep );
     
     return 1;
     }
@@ -16569,9 +21796,11 @@ static char mx_playbackStepBackward( void ) {
         return 1;
         }
 
-    /* read the start pos from the end of the block before this position */
+    /* read the start pos from the end of the block before this position
+       all blocks in a recording have the same version as the last one we
+       read */
 
-    curDataPos -= MAXIGIN_PADDED_INT_LENGTH;
+    curDataPos -= mx_getBlockStartPosLength( mx_playbackBlockVersion );
 
     success = mingin_seekPersistData( mx_playbackDataStoreHandle,
                                       curDataPos );
@@ -16583,8 +21812,9 @@ static char mx_playbackStepBackward( void ) {
         return 0;
         }
 
-    success = mx_readIntFromPersistData( mx_playbackDataStoreHandle,
-                                         &blockStartPos );
+    success = mx_readBlockStartPos( mx_playbackDataStoreHandle,
+                                    mx_playbackBlockVersion,
+                                    &blockStartPos );
 
     if( ! success ) {
         mingin_log( "Reverse playback failed to read start position "
@@ -16619,6 +21849,9 @@ static char mx_playbackStepBackward( void ) {
             mx_playbackEnd();
             return 0;
             }
+
+        /* we just un-did this step, so memory is at the step before */
+        mx_playbackCacheKeyframe( mx_playbackCurrentStep - 1 );
         }
     else {
         /* diff reading failed
@@ -16721,27 +21954,112 @@ static char mx_playbackStepBackward( void ) {
 
 
 
-static int mx_getSnapshotStepNumber( int inSnapshotNumber ) {
+static char mx_playbackMultiStepBackward( int  inNumSteps ) {
 
-    int   indexJumpPos  =  mx_playbackIndexStartPos +
-                           MAXIGIN_PADDED_INT_LENGTH * 2 * inSnapshotNumber;
-    char  success;
-    int   stepNumber;
+    int   targetStep;
+    int   slot;
+    int   i;
+    char  oldBlockForwardSounds;
     
-    success = mingin_seekPersistData( mx_playbackDataStoreHandle,
-                                      indexJumpPos );
+    /* take the first step the usual way, so we know where memory is:
+       after a backward step, it's one step behind mx_playbackCurrentStep */
+    if( ! mx_playbackStepBackward() ) {
+        return 0;
+        }
 
-    if( ! success ) {
-        maxigin_logInt( "Failed to seek into index at pos: ",
-                        indexJumpPos );
-        return -1;
+    inNumSteps --;
+    
+    targetStep = mx_playbackCurrentStep - 1 - inNumSteps;
+
+    /* restoring keyframe k and playing forward to targetStep + 1, then
+       one step back, reads targetStep + 2 - k blocks, so only worth it
+       when that's fewer than stepping back one block at a time
+
+       Stay clear of loop points and the start of the recording, which
+       stepping back handles by changing direction. */
+    slot = -1;
+    
+    if( mx_playbackDirection == -1
+        &&
+        targetStep > 0
+        &&
+        ( mx_loopPointHandles[0] == -1
+          ||
+          mx_loopPointSteps[0] + 1 < targetStep )
+        &&
+        ( mx_loopPointHandles[1] == -1
+          ||
+          mx_loopPointSteps[1] > mx_playbackCurrentStep + 1 ) ) {
+        
+        slot = mx_findPlaybackKeyframe( targetStep + 3 - inNumSteps,
+                                        targetStep + 1 );
+        }
+    
+    if( slot == -1 ) {
+        /* we can't skip steps because diffs are accumulative  */
+        char  success  =  1;
+        
+        for( i = 0;
+             i < inNumSteps;
+             i ++ ) {
+            
+            success = success && mx_playbackStep();
+            }
+        return success;
+        }
+
+    if( ! mx_playbackRestoreKeyframe( slot ) ) {
+        mingin_log( "Reverse playback failed to restore keyframe.\n" );
+        mx_playbackEnd();
+        return 0;
+        }
+
+    /* play forward silently, the sounds of the steps we pass over
+       belong to forward playback */
+    oldBlockForwardSounds = mx_playbackBlockForwardSounds;
+    
+    mx_playbackDirection          = 1;
+    mx_playbackBlockForwardSounds = 1;
+
+    while( mx_playbackRunning
+           &&
+           mx_playbackDirection == 1
+           &&
+           mx_playbackCurrentStep < targetStep + 1 ) {
+        
+        mx_playbackStepForward();
+        }
+
+    mx_playbackDirection          = -1;
+    mx_playbackBlockForwardSounds = oldBlockForwardSounds;
+
+    if( ! mx_playbackRunning ) {
+        maxigin_logInt( "Reverse playback failed to step forward from "
+                        "keyframe to step: ",
+                        targetStep + 1 );
+        return 0;
         }
 
-    success = mx_readIntFromPersistData( mx_playbackDataStoreHandle,
-                                         &stepNumber );
+    /* last step taken backward, so we end up exactly where stepping
+       back one block at a time would, with that step's ending sounds */
+    return mx_playbackStepBackward();
+    }
+
+
+
+static int mx_getSnapshotStepNumber( int inSnapshotNumber ) {
+
+    int   stepNumber;
+    int   dataPos;
+    char  success;
+    
+    success = mx_getPlaybackIndexEntry( inSnapshotNumber,
+                                        &stepNumber,
+                                        &dataPos );
     
     if( ! success ) {
-        mingin_log( "Failed to read step number from index\n" );
+        maxigin_logInt( "Failed to read step number from index for snapshot: ",
+                        inSnapshotNumber );
         return -1;
         }
     return stepNumber;
@@ -16751,10 +22069,20 @@ static int mx_getSnapshotStepNumber( int inSnapshotNumber ) {
 
 static void mx_playbackJumpToStep( int inStepNumber ) {
 
-    /* find closest snapshot before or at inStepNumber */
+    /* find closest snapshot before or at inStepNumber
+       snapshots are evenly spaced, so our guess is usually right,
+       and we only need to walk when it's not */
     int  snapshotGuess  =  inStepNumber / ( mx_diffsBetweenSnapshots + 1 );
     int  snapshotStepNumber;
+    int  keyframeSlot;
 
+    if( snapshotGuess > mx_playbackNumFullSnapshots - 1 ) {
+        snapshotGuess = mx_playbackNumFullSnapshots - 1;
+        }
+    if( snapshotGuess < 0 ) {
+        snapshotGuess = 0;
+        }
+    
     snapshotStepNumber = mx_getSnapshotStepNumber( snapshotGuess );
 
     while( snapshotStepNumber > inStepNumber ) {
@@ -16762,6 +22090,21 @@ static void mx_playbackJumpToStep( int inStepNumber ) {
         snapshotStepNumber = mx_getSnapshotStepNumber( snapshotGuess );
         }
 
+    while( snapshotStepNumber != -1
+           &&
+           snapshotGuess < mx_playbackNumFullSnapshots - 1 ) {
+        
+        int  nextStepNumber  =  mx_getSnapshotStepNumber( snapshotGuess + 1 );
+
+        if( nextStepNumber == -1
+            ||
+            nextStepNumber > inStepNumber ) {
+            break;
+            }
+        snapshotGuess ++;
+        snapshotStepNumber = nextStepNumber;
+        }
+
     if( snapshotStepNumber == -1 ) {
         maxigin_logInt( "Playback jump failed find full snapshot before step: ",
                         inStepNumber );
@@ -16769,12 +22112,30 @@ static void mx_playbackJumpToStep( int inStepNumber ) {
         return;
         }
 
-    mx_playbackJumpToFullSnapshot( snapshotGuess );
+    /* a keyframe between the snapshot and our step saves re-reading diffs
+       keyframe must be before our step, so that we play at least one
+       step forward from it, to restore sound effects */
+    keyframeSlot = mx_findPlaybackKeyframe( snapshotStepNumber,
+                                            inStepNumber - 1 );
 
-    if( ! mx_playbackRunning ) {
-        /* jumping to snapshot failed */
+    if( keyframeSlot != -1
+        &&
+        ! mx_playbackRestoreKeyframe( keyframeSlot ) ) {
+        
+        mingin_log( "Playback jump failed to restore keyframe.\n" );
+        mx_playbackEnd();
         return;
         }
+    
+    if( keyframeSlot == -1 ) {
+        
+        mx_playbackJumpToFullSnapshot( snapshotGuess );
+        
+        if( ! mx_playbackRunning ) {
+            /* jumping to snapshot failed */
+            return;
+            }
+        }
 
     while( mx_playbackRunning
            &&
@@ -16816,56 +22177,24 @@ static void mx_playbackJumpToStep( int inStepNumber ) {
                         "after jumping to full snapshot: ",
                         inStepNumber );
         }
-    }
-
-
-
-static void mx_playbackJumpToFullSnapshot( int inFullSnapshotIndex ) {
-
-    int   indexJumpPos  =  mx_playbackIndexStartPos +
-                           MAXIGIN_PADDED_INT_LENGTH * 2 * inFullSnapshotIndex;
-    int   readPos;
-    int   stepNumber;
-    char  success;
-    
-    success = mingin_seekPersistData( mx_playbackDataStoreHandle,
-                                      indexJumpPos );
-
-    if( ! success ) {
-        maxigin_logInt( "Playback jump failed to seek into index at pos: ",
-                        indexJumpPos );
-        mx_playbackEnd();
-        return;
-        }
+    }
 
-    success = mx_readIntFromPersistData( mx_playbackDataStoreHandle,
-                                         &stepNumber );
-    
-    if( ! success ) {
-        mingin_log( "Playback jump failed to read step number from index\n" );
-        mx_playbackEnd();
-        return;
-        }
 
-    /* now jump to read full snapshot file position */
-    indexJumpPos += MAXIGIN_PADDED_INT_LENGTH;
-    
-    success = mingin_seekPersistData( mx_playbackDataStoreHandle,
-                                      indexJumpPos );
 
-    if( ! success ) {
-        maxigin_logInt( "Playback jump failed to seek into index at pos: ",
-                        indexJumpPos );
-        mx_playbackEnd();
-        return;
-        }
-    
+static void mx_playbackJumpToFullSnapshot( int inFullSnapshotIndex ) {
+
+    int   readPos;
+    int   stepNumber;
+    char  success;
     
-    success = mx_readIntFromPersistData( mx_playbackDataStoreHandle,
-                                         &readPos );
+    success = mx_getPlaybackIndexEntry( inFullSnapshotIndex,
+                                        &stepNumber,
+                                        &readPos );
     
     if( ! success ) {
-        mingin_log( "Playback jump failed to read jump pos from index\n" );
+        maxigin_logInt( "Playback jump failed to read index entry for "
+                        "snapshot: ",
+                        inFullSnapshotIndex );
         mx_playbackEnd();
         return;
         }
@@ -16926,20 +22255,266 @@ static void mx_playbackJumpHalfBack( void ) {
         ( mx_playbackFullSnapshotLastPlayed ) / 2;
 
     if( destToJump < mx_playbackFullSnapshotLastPlayed ) {
+
+        int   destStep  =  mx_getSnapshotStepNumber( destToJump );
+        char  oldDirection;
+        
+        if( destStep == -1 ) {
+            mx_playbackEnd();
+            return;
+            }
         
         mx_startSoundPauseRamp();
         
         mx_startSoundShortFadeIn();
 
         mx_playbackJumping = 1;
+
+        /* land on the step after the snapshot, like jumping to the
+           snapshot and applying it does, but from a keyframe if we
+           have one
+           Steps played forward to get there are silent. */
+        oldDirection = mx_playbackDirection;
+        
+        mx_playbackDirection          = 1;
+        mx_playbackBlockForwardSounds = 1;
         
-        mx_playbackJumpToFullSnapshot( destToJump );
+        mx_playbackJumpToStep( destStep + 1 );
+
+        mx_playbackDirection          = oldDirection;
+        mx_playbackBlockForwardSounds = 0;
         }
     }
 
 
 
 
+/*
+  Runs maxiginGame_step headless with the step input that was just
+  played back.
+*/
+static void mx_verifyPlaybackGameStep( void ) {
+
+    mx_replayingStepInput = 1;
+    mx_areWeInMaxiginGameStepFunction = 1;
+
+    maxiginGame_step();
+
+    mx_areWeInMaxiginGameStepFunction = 0;
+    mx_replayingStepInput = 0;
+
+    /* nothing is listening, don't let them pile up */
+    mx_endAllSoundEffectsNow();
+    mx_clearJustStartedSoundEffects();
+    }
+
+
+
+/*
+  Headless tool mode, turned on by maxigin_verifyPlayback.ini
+
+  Replays the whole playback data store as fast as possible, without
+  drawing.  Starting from each full snapshot, the player input recorded
+  with each step is fed back through maxiginGame_step, and the memory that
+  re-simulation produces is compared with the next full snapshot.
+  Mismatches, and the memory record they're in, are logged, along with
+  how many steps per second were replayed.  Memory is then reset to the
+  snapshot, so each stretch between snapshots is checked on its own.
+
+  A mismatch means the game step isn't deterministic given its registered
+  memory and input, for example it depends on the clock or on memory that
+  isn't registered.
+
+  Recordings made before step input was recorded are checked by applying
+  their diffs instead, which only catches recording or playback losing
+  track of memory.
+*/
+static int mx_verifyPlayback( void ) {
+
+    long  startSec;
+    long  startMSec;
+    long  endSec;
+    long  endMSec;
+    long  elapsedMSec;
+    int   numSteps        =  0;
+    int   numSimulated    =  0;
+    int   numSnapshots    =  1;
+    int   numMismatches   =  0;
+    int   r;
+    int   recordStart;
+    char  success;
+
+    if( mx_playbackRunning ) {
+        /* resumed playback during init */
+        mx_playbackEnd();
+        }
+    
+    mingin_getRunningTime( &startSec,
+                           &startMSec );
+
+    /* headless, never play recorded sounds */
+    mx_playbackBlockForwardSounds = 1;
+    
+    success = mx_initPlayback();
+
+    if( ! success ) {
+        mx_playbackBlockForwardSounds = 0;
+        
+        maxigin_logString( "Playback verify failed to start playback from: ",
+                           mx_playbackDataStoreName );
+        return -1;
+        }
+
+    if( mx_recordingRingSteps < 2 ) {
+        mx_playbackBlockForwardSounds = 0;
+        
+        mingin_log( "Playback verify needs room for 2 copies of memory.\n" );
+        mx_playbackEnd();
+        return -1;
+        }
+
+    mx_playbackSimulatingSteps = 1;
+    
+    while( 1 ) {
+        
+        int  curDataPos  =
+            mingin_getPersistDataPosition( mx_playbackDataStoreHandle );
+        int  changedByte;
+        
+        if( curDataPos == -1 ) {
+            mingin_log( "Playback verify failed to get current position.\n" );
+            numMismatches = -1;
+            break;
+            }
+
+        mx_replayStepInputLoaded = 0;
+        
+        if( mx_restoreFromMemoryDiff( mx_playbackDataStoreHandle ) ) {
+            
+            if( mx_replayStepInputLoaded ) {
+                /* diff was skipped, simulate the step instead */
+                mx_verifyPlaybackGameStep();
+                numSimulated ++;
+                }
+            
+            numSteps ++;
+            continue;
+            }
+
+        if( mx_playbackFullSnapshotLastPlayed ==
+            mx_playbackNumFullSnapshots - 1 ) {
+            /* reached end */
+            break;
+            }
+
+        /* next block is a full snapshot
+           compare what we produced with what it holds */
+        mx_copyMemoryIntoBuffer( mx_recordingRing[0].memory );
+        
+        success = mingin_seekPersistData( mx_playbackDataStoreHandle,
+                                          curDataPos );
+
+        if( success ) {
+            success =
+                mx_restoreFromFullMemorySnapshot( mx_playbackDataStoreHandle );
+            }
+
+        if( ! success ) {
+            maxigin_logInt( "Playback verify failed to read diff or full "
+                            "snapshot after step: ",
+                            mx_playbackCurrentStep );
+            numMismatches = -1;
+            break;
+            }
+
+        mx_playbackFullSnapshotLastPlayed ++;
+        numSnapshots ++;
+
+        mx_copyMemoryIntoBuffer( mx_recordingRing[1].memory );
+
+        changedByte = mx_findNextChangedByte( mx_recordingRing[0].memory,
+                                              mx_recordingRing[1].memory,
+                                              mx_totalMemoryRecordsBytes,
+                                              0 );
+        
+        if( changedByte < mx_totalMemoryRecordsBytes ) {
+            numMismatches ++;
+            }
+
+        /* log first mismatched byte in each memory record, since one
+           record that always differs can hide others */
+        r            =  0;
+        recordStart  =  0;
+        
+        while( changedByte < mx_totalMemoryRecordsBytes ) {
+            
+            while( changedByte >= recordStart + mx_memRecords[r].numBytes ) {
+                recordStart += mx_memRecords[r].numBytes;
+                r ++;
+                }
+            
+            maxigin_logInt2( "Playback verify mismatch at step ",
+                             mx_playbackCurrentStep,
+                             " in byte ",
+                             changedByte - recordStart,
+                             " of memory record:" );
+            
+            maxigin_logString( "    ",
+                               mx_memRecords[r].description );
+
+            changedByte =
+                mx_findNextChangedByte( mx_recordingRing[0].memory,
+                                        mx_recordingRing[1].memory,
+                                        mx_totalMemoryRecordsBytes,
+                                        recordStart
+                                        + mx_memRecords[r].numBytes );
+            }
+        }
+
+    mx_playbackSimulatingSteps    = 0;
+    mx_playbackBlockForwardSounds = 0;
+    
+    mx_playbackEnd();
+    
+    if( numMismatches == -1 ) {
+        return -1;
+        }
+    
+    mingin_getRunningTime( &endSec,
+                           &endMSec );
+
+    elapsedMSec = ( endSec - startSec ) * 1000 + ( endMSec - startMSec );
+
+    if( elapsedMSec < 1 ) {
+        elapsedMSec = 1;
+        }
+
+    maxigin_logInt2( "Playback verify replayed steps: ",
+                     numSteps,
+                     " and full snapshots: ",
+                     numSnapshots,
+                     "" );
+
+    if( numSimulated < numSteps ) {
+        maxigin_logInt( "Playback verify had no step input, "
+                        "so only applied diffs, for steps: ",
+                        numSteps - numSimulated );
+        }
+    
+    maxigin_logInt2( "Playback verify found mismatched snapshots: ",
+                     numMismatches,
+                     " in milliseconds: ",
+                     (int)elapsedMSec,
+                     "" );
+    
+    maxigin_logInt( "Playback verify steps per second: ",
+                    (int)( (long)numSteps * 1000 / elapsedMSec ) );
+
+    return numMismatches;
+    }
+
+
+
 
 
 
@@ -17056,15 +22631,34 @@ const char *maxigin_intToString( int  inInt ) {
     static  char  buffers[ NUM_BUFFERS ][ BUFFER_LEN ];
     static  int   nextBuffer                             =  0;
 
+    const char   *returnVal;
+
+    returnVal = mx_intToStringInBuffer( inInt,
+                                        buffers[ nextBuffer ] );
+    
+    nextBuffer++;
+
+    if( nextBuffer >= NUM_BUFFERS ) {
+        nextBuffer = 0;
+        }
+    
+    return returnVal;
+    }
+
+
+
+static const char *mx_intToStringInBuffer( int    inInt,
+                                           char  *inBuffer ) {
+
+    enum{  BUFFER_LEN   =  20 };
+
     unsigned int  c            =  0;
                   /* start with billions */
     int           divisor      =  1000000000;
     const char   *formatError  =  "[int_format_error]";
                   /* skip 0 digits until our first non-zero digit */
     int           qLowerLimit  =  1;
-    char         *buffer;
-
-    buffer = buffers[ nextBuffer ];
+    char         *buffer       =  inBuffer;
     
     
     if( inInt == 0 ) {
@@ -17110,12 +22704,6 @@ const char *maxigin_intToString( int  inInt ) {
     
     /* terminate */
     buffer[c] = '\0';
-
-    nextBuffer++;
-
-    if( nextBuffer >= NUM_BUFFERS ) {
-        nextBuffer = 0;
-        }
     
     return buffer;  
     }
@@ -17773,6 +23361,10 @@ typedef struct MaxiginSoundEffect {
 
     /* first sample first byte position in mx_soundBytes */
     int  startByte;
+
+    /* handle of async read of sample bytes that hasn't been collected yet,
+       or -1 */
+    int  readRequest;
     
     } MaxiginSoundEffect;
 
@@ -17784,7 +23376,7 @@ static  int                 mx_numSoundBytes   =    0;
 static  int                 mx_numSoundEffect  =    0;
 
 
-int maxigin_initSoundEffect( const char  *inBulkResourceName ) {
+static int mx_loadSoundEffect( const char  *inBulkResourceName ) {
 
     char                 success;
     int                  newHandle;
@@ -17843,23 +23435,48 @@ int maxigin_initSoundEffect( const char  *inBulkResourceName ) {
     
     effect->numSampleFrames = wavFormat.numSampleFrames;
     effect->startByte = mx_numSoundBytes;
+    effect->readRequest = -1;
 
 
     /* now read all sample bytes into memory buffer */
 
-    numRead = mingin_readBulkData( wavFormat.bulkResourceHandle,
-                                   sampleBytes,
-                                   &( mx_soundBytes[ effect->startByte ] ) );
+    if( mx_areWeInMaxiginGameInitFunction ) {
+        /* read in the background while the game loads other things,
+           we collect these reads before init finishes */
+        
+        int  dataPos  =  mingin_getBulkDataPosition(
+                             wavFormat.bulkResourceHandle );
 
-    if( numRead != sampleBytes ) {
-        mingin_endReadBulkData( wavFormat.bulkResourceHandle );
+        if( dataPos != -1 ) {
+            effect->readRequest =
+                mingin_startAsyncBulkRead(
+                    inBulkResourceName,
+                    dataPos,
+                    sampleBytes,
+                    &( mx_soundBytes[ effect->startByte ] ),
+                    MGN_READ_BACKGROUND );
+            }
+        }
 
-        maxigin_logString( "Failed to read all sample bytes from WAV "
-                           "data when trying to read sound effect: ",
-                           inBulkResourceName );
-        return -1;
+    if( effect->readRequest == -1 ) {
+        
+        numRead = mingin_readBulkData(
+                      wavFormat.bulkResourceHandle,
+                      sampleBytes,
+                      &( mx_soundBytes[ effect->startByte ] ) );
+
+        if( numRead != sampleBytes ) {
+            mingin_endReadBulkData( wavFormat.bulkResourceHandle );
+
+            maxigin_logString( "Failed to read all sample bytes from WAV "
+                               "data when trying to read sound effect: ",
+                               inBulkResourceName );
+            return -1;
+            }
         }
 
+    mingin_endReadBulkData( wavFormat.bulkResourceHandle );
+
     mx_numSoundEffect ++;
     mx_numSoundBytes += sampleBytes;
 
@@ -17869,6 +23486,59 @@ int maxigin_initSoundEffect( const char  *inBulkResourceName ) {
 
 
 
+int maxigin_initSoundEffect( const char  *inBulkResourceName ) {
+
+    int  handle;
+
+    mx_startProfilePhase( "initSoundEffects" );
+    
+    handle = mx_loadSoundEffect( inBulkResourceName );
+
+    mx_endProfilePhase();
+
+    return handle;
+    }
+
+
+
+/*
+  Waits for any sound effect sample reads started in the background to
+  finish.
+
+  Sound effects whose reads failed are left silent.
+*/
+static void mx_finishSoundEffectReads( void ) {
+
+    int  i;
+
+    for( i = 0;
+         i < mx_numSoundEffect;
+         i ++ ) {
+
+        MaxiginSoundEffect  *effect  =  &( mx_soundEffects[ i ] );
+        int                  numRead;
+
+        if( effect->readRequest == -1 ) {
+            continue;
+            }
+
+        numRead = mingin_getAsyncBulkReadResult( effect->readRequest,
+                                                 1 );
+
+        effect->readRequest = -1;
+
+        if( numRead != effect->numSampleFrames * 4 ) {
+            maxigin_logInt( "Failed to read all sample bytes from WAV "
+                            "data for sound effect handle: ",
+                            i );
+
+            effect->numSampleFrames = 0;
+            }
+        }
+    }
+
+
+
 
 
 
@@ -17937,17 +23607,6 @@ static void mx_clearJustStartedSoundEffects( void ) {
 
 
 
-static int mx_getNumJustStartedSoundEffects( void ) {
-    return mx_numJustStartedSoundEffects;
-    }
-
-
-static int mx_getNumJustEndedSoundEffects( void ) {
-    return mx_numJustEndedSoundEffects;
-    }
-
-
-
 static int mx_getNextJustStartedSoundEffect( int  *outLoudness ) {
 
     int  returnVal;
@@ -20515,12 +26174,12 @@ static int mx_fontSpriteLookup( MaxiginFont   *inFont,
 
 
 
-int maxigin_initFont( int          inSpriteStripHandle,
-                      const char  *inMapBulkResourceName,
-                      int          inCharSpacing,
-                      int          inSpaceWidth,
-                      int          inFixedWidth,
-                      int          inLineSpacing ) {
+static int mx_loadFont( int          inSpriteStripHandle,
+                        const char  *inMapBulkResourceName,
+                        int          inCharSpacing,
+                        int          inSpaceWidth,
+                        int          inFixedWidth,
+                        int          inLineSpacing ) {
 
     int           bulkHandle;
     int           bulkSize;
@@ -20666,6 +26325,31 @@ int maxigin_initFont( int          inSpriteStripHandle,
 
 
 
+int maxigin_initFont( int          inSpriteStripHandle,
+                      const char  *inMapBulkResourceName,
+                      int          inCharSpacing,
+                      int          inSpaceWidth,
+                      int          inFixedWidth,
+                      int          inLineSpacing ) {
+
+    int  handle;
+
+    mx_startProfilePhase( "initFonts" );
+    
+    handle = mx_loadFont( inSpriteStripHandle,
+                          inMapBulkResourceName,
+                          inCharSpacing,
+                          inSpaceWidth,
+                          inFixedWidth,
+                          inLineSpacing );
+
+    mx_endProfilePhase();
+
+    return handle;
+    }
+
+
+
 /* must be a power of 2 */
 #define  MAXIGIN_NUM_KERNING_CACHE_ENTRIES  2048
 
@@ -22175,39 +27859,64 @@ int maxigin_getFontLineSpacing( int  inFont ) {
 
 
 
+static void mx_reloadLanguage( int  inLanguage ) {
+    
+    MaxiginLanguage  *lang  =  &( mx_languages[ inLanguage ] );
+    
+    int  k;
+
+    char  bulkName[ MAXIGIN_LANGUAGE_NAME_MAX_LENGTH + 1 ];
+
+    maxigin_stringCopy( lang->bulkResourceName,
+                        bulkName );
+    
+    for( k = 0;
+         k < mx_numTranslationKeys;
+         k ++ ) {
+
+        if( lang->stringStartBytes[ k ] != -1 ) {
+
+            mx_removeTranslationString( lang->stringStartBytes[ k ] );
+
+            lang->stringStartBytes[ k ] = -1;
+            }
+        }
+
+    /* re-init in same spot */
+    mx_initLanguage( lang->bulkResourceName,
+                     inLanguage );
+    }
+
+
+
 static void mx_checkLangNeedsReload( void ) {
     int  ln;
 
     for( ln = 0;
          ln < mx_numLanguages;
          ln ++ ) {
-
-        MaxiginLanguage  *lang  =  &( mx_languages[ ln ] );
         
-        if( mingin_getBulkDataChanged( lang->bulkResourceName ) ) {
+        if( mingin_getBulkDataChanged(
+                mx_languages[ ln ].bulkResourceName ) ) {
 
-            int  k;
-
-            char  bulkName[ MAXIGIN_LANGUAGE_NAME_MAX_LENGTH + 1 ];
+            mx_reloadLanguage( ln );
+            }
+        }
+    }
 
-            maxigin_stringCopy( lang->bulkResourceName,
-                                bulkName );
-            
-            for( k = 0;
-                 k < mx_numTranslationKeys;
-                 k ++ ) {
 
-                if( lang->stringStartBytes[ k ] != -1 ) {
 
-                    mx_removeTranslationString( lang->stringStartBytes[ k ] );
+static void mx_reloadLanguagesFromBulkData( const char  *inBulkName ) {
+    int  ln;
 
-                    lang->stringStartBytes[ k ] = -1;
-                    }
-                }
+    for( ln = 0;
+         ln < mx_numLanguages;
+         ln ++ ) {
+        
+        if( maxigin_stringsEqual( inBulkName,
+                                  mx_languages[ ln ].bulkResourceName ) ) {
 
-            /* re-init in same spot */
-            mx_initLanguage( lang->bulkResourceName,
-                             ln );
+            mx_reloadLanguage( ln );
             }
         }
     }
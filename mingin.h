@@ -104,6 +104,24 @@
 
 
 
+/*
+  Time each stage of presenting a frame to the screen, so that a profiler
+  can see it through mingin_getLastPresentTiming.
+
+  Off by default, which compiles the timing out entirely.
+
+  To turn on present timing, do this:
+
+      #define  MINGIN_ENABLE_PRESENT_TIMING  1
+
+  [jumpSettings]
+*/
+#ifndef  MINGIN_ENABLE_PRESENT_TIMING
+#define  MINGIN_ENABLE_PRESENT_TIMING  0
+#endif
+
+
+
 
 
 /*
@@ -513,6 +531,65 @@ void mingin_getRunningTime( long  *outSeconds,
 
 
 
+/*
+  How many microseconds has the program been running?
+
+  The value wraps around when it gets too big for an unsigned long, so only
+  differences between nearby values are meaningful.  Computing differences
+  as unsigned longs gives the right answer across a wrap.
+
+  Returns:
+
+      elapsed microseconds, or 0 on platforms that don't have clocks
+            
+  [jumpMinginProvides]                         
+*/
+unsigned long mingin_getRunningMicroseconds( void );
+
+
+
+/* stages of presenting a frame to the screen, after
+   minginGame_getScreenPixels returns */
+typedef enum MinginPresentStage {
+    /* handing screen pixels to the graphics system */
+    MGN_PRESENT_UPLOAD,
+    /* swapping buffers, which might wait for vsync */
+    MGN_PRESENT_SWAP,
+    MGN_NUM_PRESENT_STAGES
+    } MinginPresentStage;
+
+
+
+/*
+  Gets when a stage of presenting the most recent frame started and ended.
+
+  Only supported if MINGIN_ENABLE_PRESENT_TIMING is 1.  [jumpSettings]
+
+  Parameters:
+
+      inStage                 the stage to get timing for
+
+      outStartMicroseconds    pointer to where the start time should be
+                              returned, in mingin_getRunningMicroseconds time
+
+      outEndMicroseconds      pointer to where the end time should be
+                              returned, in mingin_getRunningMicroseconds time
+
+  Returns:
+
+      1   if timing was returned
+
+      0   if present timing is not supported, or if no frame has been
+          presented yet
+            
+  [jumpMinginProvides]                         
+*/
+char mingin_getLastPresentTiming( MinginPresentStage   inStage,
+                                  unsigned long       *outStartMicroseconds,
+                                  unsigned long       *outEndMicroseconds );
+
+
+
 /*
   Gets a seed value from an entropy source.
 
@@ -1281,6 +1358,32 @@ char mingin_writePersistData( int                   inStoreWriteHandle,
 
 
 
+/*
+  Flushes any data that the platform is holding in a buffer for an open
+  persistent data store, making sure that everything written so far has
+  been handed off to the underlying storage.
+
+  Platforms may buffer data passed to mingin_writePersistData, so that many
+  small writes are cheap.  Buffered data is always flushed by
+  mingin_endWritePersistData, so this only needs to be called at points
+  where data written so far must survive a crash before the store is ended.
+
+  Parameters:
+
+      inStoreWriteHandle   handle of the store to flush
+
+  Returns:
+
+      1   on success
+      
+      0   on failure
+  
+  [jumpMinginProvides]
+*/
+char mingin_flushPersistData( int  inStoreWriteHandle );
+
+
+
 /*
   Reads more data from an open persistent data store.
 
@@ -1352,14 +1455,25 @@ int mingin_getPersistDataPosition( int  inStoreReadHandle );
 
 /*
   Ends writing persistent data store.
+
+  Any data still buffered by the platform is written out first, so a
+  failure here means that the tail of the store may be missing, even if
+  every call to mingin_writePersistData succeeded.
+  The store is ended either way.
   
   Parameters:
 
       inStoreWriteHandle   handle of the write store to end writing
+
+  Returns:
+
+      1   on success
+      
+      0   on failure
   
   [jumpMinginProvides]
 */
-void mingin_endWritePersistData( int  inStoreWriteHandle );
+char mingin_endWritePersistData( int  inStoreWriteHandle );
 
 
 
@@ -1392,6 +1506,10 @@ void mingin_deletePersistData( const char  *inStoreName );
 /*
   Renames a persistent data store, if it exists.
 
+  If a store named inStoreNewName already exists, it is replaced, so
+  a new version of a store can be written under a temporary name and
+  then swapped into place.
+
   Parameters:
 
       inStoreName      the name of the store to rename as a \0-terminated string.
@@ -1545,6 +1663,158 @@ void mingin_endReadBulkData( int  inBulkDataHandle );
 
 
 
+/*
+  Maps a whole bulk data resource into memory for reading, on platforms
+  that support it.
+
+  The resource's bytes can then be parsed in place, without copying them
+  through mingin_readBulkData.
+
+  Counts as opening the resource for reading for mingin_getBulkDataChanged.
+  
+  Parameters:
+
+      inBulkName      the name of the bulk resource as a \0-terminated string.
+
+      outTotalBytes   pointer to where the number of bytes in the data
+                      resource should be returned
+  Returns:
+
+      pointer to the read-only bytes of the resource, valid until
+      mingin_endMapBulkData is called
+
+      0   on failure
+          or
+          if mapping is not supported on this platform, or not safe for
+          this resource, in which case mingin_startReadBulkData should be
+          used instead
+
+  Only resources that can't change while mapped are mapped.  A loose file
+  that is rewritten or truncated under a mapping (for example, while
+  being edited for hot-reloading) would crash the game when the missing
+  bytes are touched.
+  
+  [jumpMinginProvides]
+*/
+const unsigned char *mingin_startMapBulkData( const char  *inBulkName,
+                                              int         *outTotalBytes );
+
+
+
+/*
+  Ends a mapping made by mingin_startMapBulkData.
+  
+  Parameters:
+
+      inData          the pointer returned by mingin_startMapBulkData
+
+      inTotalBytes    the number of bytes returned by mingin_startMapBulkData
+  
+  [jumpMinginProvides]
+*/
+void mingin_endMapBulkData( const unsigned char  *inData,
+                            int                   inTotalBytes );
+
+
+
+/*
+  Priority classes for asynchronous bulk data reads.
+
+  Waiting urgent reads are always started before waiting background reads.
+
+  These values are used in call:
+     mingin_startAsyncBulkRead
+       (see below)
+
+  [jumpMinginProvides]
+*/
+typedef enum MinginReadPriority {
+    /* data the game needs soon, or will block on */
+    MGN_READ_URGENT      = 0,
+    /* data loaded ahead of time, like assets at startup */
+    MGN_READ_BACKGROUND,
+    MGN_NUM_READ_PRIORITIES
+    } MinginReadPriority;
+
+
+
+/*
+  Starts reading a range of bytes from a bulk data resource in the
+  background, on platforms that support it.
+
+  Reads are served by a small pool of I/O threads, in priority order, so
+  many reads can be waiting for the disk at once.
+
+  Streaming reads set up with mingin_setBulkDataReadBuffer are served by
+  their own thread, and don't wait behind these reads.
+
+  Counts as opening the resource for reading for mingin_getBulkDataChanged.
+  
+  Parameters:
+
+      inBulkName       the name of the bulk resource as a \0-terminated string.
+
+      inStartPos       the byte position in the resource to start reading at
+
+      inNumBytes       the number of bytes to read
+
+      inBuffer         the buffer to read into, which must stay untouched
+                       until the read finishes
+
+      inPriority       the priority class of the read
+
+  Returns:
+
+      read request handle   on success
+
+      -1                    on failure
+                            or
+                            if too many reads are already waiting
+                            or
+                            if asynchronous reads are not supported on
+                            this platform, in which case the caller should
+                            read the data itself
+  
+  [jumpMinginProvides]
+*/
+int mingin_startAsyncBulkRead( const char          *inBulkName,
+                               int                  inStartPos,
+                               int                  inNumBytes,
+                               unsigned char       *inBuffer,
+                               MinginReadPriority   inPriority );
+
+
+
+#define  MINGIN_ASYNC_READ_PENDING  -2
+
+/*
+  Gets the result of an asynchronous bulk data read.
+
+  Once a result other than MINGIN_ASYNC_READ_PENDING is returned, the read
+  request handle is no longer valid.
+  
+  Parameters:
+
+      inReadRequest   the handle returned by mingin_startAsyncBulkRead
+
+      inWait          1 to block until the read finishes
+                      0 to return right away
+  Returns:
+
+      number of bytes read        if the read finished
+
+      -1                          if the read failed
+
+      MINGIN_ASYNC_READ_PENDING   if inWait is 0 and the read hasn't
+                                  finished yet
+  
+  [jumpMinginProvides]
+*/
+int mingin_getAsyncBulkReadResult( int   inReadRequest,
+                                   char  inWait );
+
+
+
 /*
   Gets whether a bulk data resource has changed since the last time
   mingin_startReadBulkData was called for that resource.
@@ -1567,6 +1837,145 @@ char mingin_getBulkDataChanged( const char  *inBulkName );
 
 
 
+/*
+  Gets whether the platform can notify us of bulk data changes through
+  mingin_getNextChangedBulkData.
+
+  When supported, a game can check for changes once per step through
+  mingin_getNextChangedBulkData instead of calling mingin_getBulkDataChanged
+  for each of its bulk data resources.
+
+  Returns:
+
+      1   if change notifications are supported and can be relied on
+
+      0   if not, in which case mingin_getBulkDataChanged should be used
+  
+  [jumpMinginProvides]
+*/
+char mingin_getBulkDataChangeNotificationsSupported( void );
+
+
+
+/*
+  Gets the name of the next bulk data resource that has changed.
+
+  Only resources that have been opened with mingin_startReadBulkData are
+  reported, and each resource is reported once, no matter how many times
+  it changed since it was last reported.
+
+  Returns:
+
+      the name of the changed resource as a \0-terminated string, which is
+      valid until the next call to mingin_getNextChangedBulkData
+
+      0   if no more changed resources are waiting
+          or
+          if change notifications are not supported on this platform
+  
+  [jumpMinginProvides]
+*/
+const char *mingin_getNextChangedBulkData( void );
+
+
+
+/*
+  Starts a background worker thread on platforms that support threads.
+
+  Only one worker thread can be running at a time.
+
+  After each call to mingin_wakeWorkerThread, the worker thread will call
+  inWorkFunction.  Wake calls that happen while inWorkFunction is already
+  waiting to be called are merged into one call, so inWorkFunction should
+  process all of the work that is waiting for it each time it is called.
+
+  inWorkFunction runs concurrently with the minginGame_ functions.  Use
+  mingin_lockWorker and mingin_unlockWorker around data shared with it.
+
+  inWorkFunction can use persist data handles, as long as no other thread
+  uses those handles at the same time.  It can also call mingin_log,
+  mingin_lockWorker, and mingin_unlockWorker, but no other mingin_
+  functions.
+  
+  Parameters:
+
+      inWorkFunction   the function to call from the worker thread
+
+  Returns:
+
+      1   if the worker thread started
+
+      0   if a worker thread is already running, or threads are not supported
+          on this platform.  In this case, the caller should do its work
+          itself instead.
+  
+  [jumpMinginProvides]
+*/
+char mingin_startWorkerThread( void  (*inWorkFunction)( void ) );
+
+
+
+/*
+  Wakes the worker thread up, so it calls its work function again.
+
+  Does nothing if the worker thread isn't running.
+  
+  [jumpMinginProvides]
+*/
+void mingin_wakeWorkerThread( void );
+
+
+
+/*
+  Blocks until the worker thread has finished all of the work it has been
+  woken for.
+
+  Returns right away if the worker thread isn't running.
+
+  Do not call this from the worker thread's work function.
+  
+  [jumpMinginProvides]
+*/
+void mingin_waitForWorkerThread( void );
+
+
+
+/*
+  Locks data shared with the worker thread, blocking until
+  mingin_unlockWorker() is called if it's already locked.
+
+  Does nothing if the worker thread isn't running.
+  
+  [jumpMinginProvides]
+*/
+void mingin_lockWorker( void );
+
+
+
+/*
+  Unlocks data shared with the worker thread, if
+  mingin_lockWorker() was called previously.
+  
+  [jumpMinginProvides]
+*/
+void mingin_unlockWorker( void );
+
+
+
+/*
+  Waits for the worker thread to finish all of the work it has been woken for,
+  and then ends it.
+
+  Does nothing if the worker thread isn't running.
+
+  Do not call this from the worker thread's work function.
+  
+  [jumpMinginProvides]
+*/
+void mingin_endWorkerThread( void );
+
+
+
 /*
   This is the end of Mingin functions that a game can call.
 
@@ -2202,34 +2611,89 @@ static const char *mn_getWindowTitle( void ) {
 
 
 
+#if MINGIN_ENABLE_PRESENT_TIMING
 
+static  unsigned long  mn_presentStartTimes[ MGN_NUM_PRESENT_STAGES ];
+static  unsigned long  mn_presentEndTimes[ MGN_NUM_PRESENT_STAGES ];
+static  char           mn_presentTimed[ MGN_NUM_PRESENT_STAGES ];
 
-/*
-  This is the end of Mingin's internal code.
-
-  [jumpInternal]
-*/
-
-
-
+#endif
 
-/*
-  ==================================================
-  Mingin platform implementations      [jumpSystems]
-  ==================================================
 
-  The following #ifdefs selectively compile platform-specific implmentation
-  code.
 
-*/
+/* platforms call these around each stage of presenting a frame */
+static void mn_startPresentStage( MinginPresentStage  inStage ) {
+#if MINGIN_ENABLE_PRESENT_TIMING
+    mn_presentStartTimes[ inStage ] = mingin_getRunningMicroseconds();
+#else
+    (void)inStage;
+#endif
+    }
 
 
 
+static void mn_endPresentStage( MinginPresentStage  inStage ) {
+#if MINGIN_ENABLE_PRESENT_TIMING
+    mn_presentEndTimes[ inStage ] = mingin_getRunningMicroseconds();
+    mn_presentTimed[ inStage ]    = 1;
+#else
+    (void)inStage;
+#endif
+    }
 
-#ifdef __linux__
 
 
-/*
+char mingin_getLastPresentTiming( MinginPresentStage   inStage,
+                                  unsigned long       *outStartMicroseconds,
+                                  unsigned long       *outEndMicroseconds ) {
+#if MINGIN_ENABLE_PRESENT_TIMING
+    if( ! mn_presentTimed[ inStage ] ) {
+        return 0;
+        }
+    
+    *outStartMicroseconds = mn_presentStartTimes[ inStage ];
+    *outEndMicroseconds   = mn_presentEndTimes[ inStage ];
+    
+    return 1;
+#else
+    (void)inStage;
+    (void)outStartMicroseconds;
+    (void)outEndMicroseconds;
+    
+    return 0;
+#endif
+    }
+
+
+
+
+
+/*
+  This is the end of Mingin's internal code.
+
+  [jumpInternal]
+*/
+
+
+
+
+/*
+  ==================================================
+  Mingin platform implementations      [jumpSystems]
+  ==================================================
+
+  The following #ifdefs selectively compile platform-specific implmentation
+  code.
+
+*/
+
+
+
+
+#ifdef __linux__
+
+
+/*
   ================================================
   Linux implementation                 [jumpLinux]
   ================================================
@@ -2250,6 +2714,17 @@ static const char *mn_getWindowTitle( void ) {
 */
 #define  MINGIN_MAX_NUM_BULK_CHANGE_RECORDS   256
 
+/* writes to persistent data stores are buffered in user space, so that
+   lots of small writes don't each turn into a write() system call.
+   This is the number of stores that can be open for writing with buffering
+   at the same time.  Stores opened beyond this limit are written
+   unbuffered.
+*/
+#define  MINGIN_LINUX_MAX_PERSIST_WRITE_BUFFERS      4
+
+/* buffered bytes are flushed when the buffer fills up */
+#define  MINGIN_LINUX_PERSIST_WRITE_BUFFER_BYTES     16384
+
 
 /* make inline keyword disappear in asoundlib header so it can compile
    in a C89 environment */
@@ -2286,6 +2761,11 @@ static const char *mn_getWindowTitle( void ) {
 #include <X11/Xatom.h>
 #include <X11/extensions/Xrandr.h>
 
+/* for presenting through shared memory when GL is slow or missing */
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
 /* for binding gl context to X11 window for fast display of game image */
 #define GLX_GLXEXT_PROTOTYPES 1
 #include <GL/glx.h>
@@ -2308,7 +2788,16 @@ int  rename( const char  *oldpath,
 #include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <sys/ioctl.h>
-#include <linux/joystick.h>
+#include <linux/input.h>
+
+/* for bulk data change notifications */
+#include <sys/inotify.h>
+
+/* for mapping bulk data into memory */
+#include <sys/mman.h>
+
+/* for waking the input thread when X or gamepad events arrive */
+#include <sys/epoll.h>
 
 
 
@@ -2393,6 +2882,31 @@ int mingin_getMillisecondsLeftInStep( void ) {
 
 
 
+/* converts a gettimeofday time to mingin_getRunningMicroseconds time */
+static unsigned long mn_getRunningMicrosecondsAt( long  inSeconds,
+                                                  long  inMicroseconds ) {
+    
+    /* wraps around in unsigned arithmetic */
+    return (unsigned long)( inSeconds - mn_programStartTime.tv_sec )
+        * 1000000UL
+        + (unsigned long)( inMicroseconds - mn_programStartTime.tv_usec );
+    }
+
+
+
+unsigned long mingin_getRunningMicroseconds( void ) {
+
+    struct timeval  currentTime;
+
+    gettimeofday( & currentTime,
+                  NULL );
+
+    return mn_getRunningMicrosecondsAt( (long)currentTime.tv_sec,
+                                        (long)currentTime.tv_usec );
+    }
+
+
+
 void mingin_getRunningTime( long  *outSeconds,
                             long  *outMilliseconds ) {
 
@@ -2630,22 +3144,63 @@ static char  mn_gamepadTouched  =  0;
 
 
 /*
-  Looks through  /dev/input/js  devices for the first gamepad that matches
-  one of our mn_gamepadIDStrings.
+  We read gamepads through their  /dev/input/event  evdev device, but
+  number their buttons and sticks the way the  /dev/input/js  joydev driver
+  would, with the same value scaling, so our js maps above still apply.
+
+  Only read or written by whichever thread is reading input.
+*/
+
+/* js button or stick number for each evdev code, or -1 if not present */
+static  int   mn_evdevKeyToJSButton[ KEY_CNT ];
+static  int   mn_evdevAbsToJSStick[ ABS_CNT ];
+
+/* joydev's default correction for each evdev axis */
+static  long  mn_evdevAbsCorrection[ ABS_CNT ][ 4 ];
+
+/* last value we queued for each evdev code, so we only deliver changes */
+static  char  mn_evdevKeyValue[ KEY_CNT ];
+static  int   mn_evdevAbsValue[ ABS_CNT ];
+
+/* set when kernel dropped events, until next SYN_REPORT */
+static  char  mn_evdevDropped      =  0;
+
+/* only touched by whichever thread is pumping input:  the input thread
+   while it's live, otherwise the main thread */
+static  int   mn_gamepadFD         =  -1;
+
+/* inotify on /dev/input, for hotplug */
+static  int   mn_gamepadNotifyFD   =  -1;
+
+/*
+  Looks through  /dev/input/event  devices for the first gamepad that
+  matches one of our mn_gamepadIDStrings.
 
   Side Effects:
 
-      mn_activeGamepad   set to an index in MinginGamepad if found
-      
-      mn_activeGamepad   set to MGN_NO_GAMEPAD of not found
+      mn_gamepadFD   set to open device if found, or -1 if not found
+
+      Queues an MGN_INPUT_GAMEPAD_CHANGE event that sets mn_activeGamepad
+      to an index in MinginGamepad, or MGN_NO_GAMEPAD if not found
+*/
+static void mn_openActiveGamepad( void );
 
-  Returns:
 
-      file descriptor   for open gamepad if found
+/* opens first gamepad and starts watching for hotplug */
+static void mn_setupGamepadInput( void );
 
-      -1                if not found
+static void mn_endGamepadInput( void );
+
+/*
+  Reads and queues all available events from open gamepad.
+
+  Returns 1 if a read error closed the gamepad (and a re-open was tried,
+  which may hand back the same fd number), or 0 if not.
 */
-static int mn_openActiveGamepad( void );
+static char mn_readGamepadEvents( void );
+
+/* opens a gamepad if one has been plugged in */
+static void mn_readGamepadNotifications( void );
 
 
 
@@ -3258,12 +3813,17 @@ static void mn_reconfigureWindowSize( Display  *inXDisplay ) {
 
 typedef struct MinginXWindowSetup {
         
-        Display      *xDisplay;
-        Window        xWindow;
-        Window        xRoot;
-        int           xScreen;
-        XVisualInfo  *xVisual;
-        GLXContext    glxContext;
+        Display          *xDisplay;
+        Window            xWindow;
+        Window            xRoot;
+        int               xScreen;
+        XVisualInfo      *xVisual;
+        GLXContext        glxContext;
+
+        /* if set, we present with XShmPutImage and have no GLX context */
+        char              useShm;
+        XImage           *shmImage;
+        XShmSegmentInfo   shmInfo;
         
     } MinginXWindowSetup;
 
@@ -3274,6 +3834,225 @@ static  MinginXWindowSetup   mn_XSetup;
 
 
 
+/*
+  Set to 1 to always present frames through MIT-SHM, or 0 to always
+  use GLX.
+
+  If not set, we use MIT-SHM only when GLX is missing or is a software
+  renderer, where glDrawPixels makes extra full-frame copies.
+*/
+static  const char  *mn_xShmPresentSetting  =  "mingin_xShmPresent.ini";
+
+
+
+static char mn_stringContains( const char  *inString,
+                               const char  *inSubString ) {
+
+    while( *inString != '\0' ) {
+        
+        if( mn_stringStartsWith( inString, inSubString ) ) {
+            return 1;
+            }
+        inString ++;
+        }
+    
+    return 0;
+    }
+
+
+
+/* must be called with our GLX context current */
+static char mn_isGLSoftware( void ) {
+
+    const char  *renderer  =  (const char *)glGetString( GL_RENDERER );
+
+    if( renderer == NULL ) {
+        return 1;
+        }
+
+    return ( mn_stringContains( renderer, "llvmpipe" )
+             ||
+             mn_stringContains( renderer, "softpipe" )
+             ||
+             mn_stringContains( renderer, "swrast" )
+             ||
+             mn_stringContains( renderer, "Software Rasterizer" ) );
+    }
+
+
+
+static  char  mn_shmAttachFailed  =  0;
+
+
+static int mn_shmErrorHandler( Display      *inDisplay,
+                               XErrorEvent  *inEvent ) {
+    /* suppress warning, args not needed */
+    if( inDisplay == NULL
+        ||
+        inEvent == NULL ) {
+        
+        }
+    
+    mn_shmAttachFailed = 1;
+    
+    return 0;
+    }
+
+
+
+/*
+  Makes a window-sized shared memory XImage.
+
+  Returns 1 on success, 0 if MIT-SHM isn't available (like on a remote
+  display), or the default visual isn't 32-bit 0xRRGGBB.
+*/
+static char mn_openShmImage( MinginXWindowSetup  *inSetup ) {
+
+    MinginXWindowSetup  *s          =  inSetup;
+    XImage              *image;
+    int                  numBytes;
+    int                  i;
+    int                  one        =  1;
+    char                 hostLSB    =  ( *( (char *)&one ) == 1 );
+    int                (*oldHandler)( Display *, XErrorEvent * );
+
+    s->shmImage = NULL;
+    
+    if( ! XShmQueryExtension( s->xDisplay ) ) {
+        mingin_log( "MIT-SHM extension not available\n" );
+        return 0;
+        }
+
+    image = XShmCreateImage(
+        s->xDisplay,
+        DefaultVisual( s->xDisplay, s->xScreen ),
+        (unsigned int)DefaultDepth( s->xDisplay, s->xScreen ),
+        ZPixmap,
+        NULL,
+        &( s->shmInfo ),
+        (unsigned int)mn_realWindowW,
+        (unsigned int)mn_realWindowH );
+
+    if( image == NULL ) {
+        mingin_log( "Failed to create MIT-SHM image\n" );
+        return 0;
+        }
+
+    if( image->bits_per_pixel != 32
+        ||
+        image->red_mask   != 0xFF0000
+        ||
+        image->green_mask != 0x00FF00
+        ||
+        image->blue_mask  != 0x0000FF
+        ||
+        ( image->byte_order == LSBFirst ) != hostLSB ) {
+
+        mingin_log( "X visual pixel format not supported for MIT-SHM\n" );
+        XDestroyImage( image );
+        return 0;
+        }
+
+    numBytes = image->bytes_per_line * image->height;
+    
+    s->shmInfo.shmid = shmget( IPC_PRIVATE,
+                               (size_t)numBytes,
+                               IPC_CREAT | 0600 );
+    
+    if( s->shmInfo.shmid == -1 ) {
+        mingin_log( "Failed to get shared memory for MIT-SHM\n" );
+        XDestroyImage( image );
+        return 0;
+        }
+
+    s->shmInfo.shmaddr = (char *)shmat( s->shmInfo.shmid, 0, 0 );
+
+    if( s->shmInfo.shmaddr == (char *)-1 ) {
+        mingin_log( "Failed to attach shared memory for MIT-SHM\n" );
+        shmctl( s->shmInfo.shmid, IPC_RMID, 0 );
+        XDestroyImage( image );
+        return 0;
+        }
+
+    image->data           = s->shmInfo.shmaddr;
+    s->shmInfo.readOnly   = False;
+
+    /* X server can refuse, and default handler would exit */
+    mn_shmAttachFailed = 0;
+    
+    oldHandler = XSetErrorHandler( mn_shmErrorHandler );
+
+    XShmAttach( s->xDisplay,
+                &( s->shmInfo ) );
+
+    XSync( s->xDisplay,
+           False );
+
+    XSetErrorHandler( oldHandler );
+
+    /* once both of us detach, segment goes away */
+    shmctl( s->shmInfo.shmid, IPC_RMID, 0 );
+    
+    if( mn_shmAttachFailed ) {
+        mingin_log( "X server failed to attach MIT-SHM segment\n" );
+        shmdt( s->shmInfo.shmaddr );
+        XDestroyImage( image );
+        return 0;
+        }
+
+    /* borders around game image stay black */
+    for( i = 0;
+         i < numBytes;
+         i ++ ) {
+        image->data[i] = 0;
+        }
+    
+    s->shmImage = image;
+    
+    return 1;
+    }
+
+
+
+/* frees whichever of GLX context, visual, and shared image we made */
+static void mn_closeXPresenter( MinginXWindowSetup  *inSetup ) {
+
+    MinginXWindowSetup  *s  =  inSetup;
+
+    if( s->glxContext ) {
+        glXMakeCurrent( s->xDisplay,
+                        None,
+                        NULL );
+
+        glXDestroyContext( s->xDisplay,
+                           s->glxContext );
+        
+        s->glxContext = NULL;
+        }
+
+    if( s->xVisual ) {
+        XFree( s->xVisual );
+        s->xVisual = NULL;
+        }
+    
+    if( s->shmImage ) {
+        XShmDetach( s->xDisplay,
+                    &( s->shmInfo ) );
+        
+        XSync( s->xDisplay,
+               False );
+        
+        /* doesn't free shared data */
+        XDestroyImage( s->shmImage );
+        
+        shmdt( s->shmInfo.shmaddr );
+
+        s->shmImage = NULL;
+        }
+    }
+
+
+
 /* returns 1 on success, 0 on failure */
 static char mn_openXWindow( MinginXWindowSetup  *inSetup ) {
     
@@ -3295,6 +4074,9 @@ static char mn_openXWindow( MinginXWindowSetup  *inSetup ) {
     XTextProperty            winTitleProperty;
     const char              *winTitle           =  mn_getWindowTitle();
     Status                   returnCode;
+    char                     shmSetting         =
+        mn_getFlagSetting( mn_xShmPresentSetting,
+                           -1 );
     
     s->xDisplay = XOpenDisplay( NULL );
 
@@ -3305,15 +4087,23 @@ static char mn_openXWindow( MinginXWindowSetup  *inSetup ) {
     
     s->xScreen = DefaultScreen( s->xDisplay );
 
-    
-    s->xVisual = glXChooseVisual( s->xDisplay,
-                                  s->xScreen,
-                                  glxAttributes );
+    s->xVisual    = NULL;
+    s->glxContext = NULL;
+    s->shmImage   = NULL;
+    s->useShm     = 1;
 
-    if( ! s->xVisual ) {
-        mingin_log( "No Visual found for GLX\n" );
-        XCloseDisplay( s->xDisplay );
-        return 0;
+    if( shmSetting != 1 ) {
+        
+        s->xVisual = glXChooseVisual( s->xDisplay,
+                                      s->xScreen,
+                                      glxAttributes );
+
+        if( s->xVisual ) {
+            s->useShm = 0;
+            }
+        else {
+            mingin_log( "No Visual found for GLX, trying MIT-SHM\n" );
+            }
         }
 
     xBlackColor = BlackPixel( s->xDisplay,
@@ -3353,22 +4143,23 @@ static char mn_openXWindow( MinginXWindowSetup  *inSetup ) {
     XMapWindow( s->xDisplay,
                 s->xWindow );
 
-    s->glxContext = glXCreateContext( s->xDisplay,
-                                      s->xVisual,
-                                      NULL,
-                                      GL_TRUE );
-    
-    if( ! s->glxContext ) {
-        mingin_log( "Failed to create GLX context\n" );
-        XDestroyWindow( s->xDisplay,
-                        s->xWindow );
-        XFree( s->xVisual );
-        XCloseDisplay( s->xDisplay );
+    if( ! s->useShm ) {
         
-        return 0;
+        s->glxContext = glXCreateContext( s->xDisplay,
+                                          s->xVisual,
+                                          NULL,
+                                          GL_TRUE );
+    
+        if( s->glxContext ) {
+            glXSwapIntervalMESA( 1 );
+            }
+        else {
+            mingin_log( "Failed to create GLX context, trying MIT-SHM\n" );
+            
+            mn_closeXPresenter( s );
+            s->useShm = 1;
+            }
         }
-
-    glXSwapIntervalMESA( 1 );
     
 
     /* wait for MapNotify */
@@ -3395,12 +4186,10 @@ static char mn_openXWindow( MinginXWindowSetup  *inSetup ) {
 
         mingin_log( "Failed to get X Window geometry\n" );
 
-        glXDestroyContext( s->xDisplay,
-                           s->glxContext );
+        mn_closeXPresenter( s );
 
         XDestroyWindow( s->xDisplay,
                         s->xWindow );
-        XFree( s->xVisual );
         XCloseDisplay( s->xDisplay );
         
         return 0;
@@ -3413,12 +4202,10 @@ static char mn_openXWindow( MinginXWindowSetup  *inSetup ) {
     if( ! xrrRes ) {
         mingin_log( "Failed to get XRR ScreenResources\n" );
 
-        glXDestroyContext( s->xDisplay,
-                           s->glxContext );
+        mn_closeXPresenter( s );
 
         XDestroyWindow( s->xDisplay,
                         s->xWindow );
-        XFree( s->xVisual );
         XCloseDisplay( s->xDisplay );
         
         return 0;
@@ -3531,15 +4318,52 @@ static char mn_openXWindow( MinginXWindowSetup  *inSetup ) {
                        mn_xFullscreen );
 
     
-    glXMakeCurrent( s->xDisplay,
-                    s->xWindow,
-                    s->glxContext );
+    if( ! s->useShm ) {
+        
+        glXMakeCurrent( s->xDisplay,
+                        s->xWindow,
+                        s->glxContext );
 
-    glViewport( 0,
-                0,
-                (GLsizei)mn_realWindowW,
-                (GLsizei)mn_realWindowH );
+        glViewport( 0,
+                    0,
+                    (GLsizei)mn_realWindowW,
+                    (GLsizei)mn_realWindowH );
+
+        if( shmSetting == -1
+            &&
+            mn_isGLSoftware() ) {
+
+            mingin_log( "GL renderer is software, trying MIT-SHM\n" );
 
+            if( mn_openShmImage( s ) ) {
+                
+                /* keep shared image, drop GLX */
+                XImage  *image  =  s->shmImage;
+
+                s->shmImage = NULL;
+                
+                mn_closeXPresenter( s );
+
+                s->shmImage = image;
+                s->useShm   = 1;
+                }
+            }
+        }
+    else if( ! mn_openShmImage( s ) ) {
+        
+        mingin_log( "No way to present frames to X Window\n" );
+
+        XDestroyWindow( s->xDisplay,
+                        s->xWindow );
+        XCloseDisplay( s->xDisplay );
+
+        return 0;
+        }
+
+    if( s->useShm ) {
+        mingin_log( "Presenting frames with MIT-SHM\n" );
+        }
+    
     return 1;
     }
 
@@ -3549,15 +4373,7 @@ static void mn_closeXWindow( MinginXWindowSetup  *inSetup ) {
     
     MinginXWindowSetup  *s  =  inSetup;
 
-    XFree( s->xVisual );
-    
-    glXMakeCurrent( s->xDisplay,
-                    None,
-                    NULL );
-
-    glXDestroyContext( s->xDisplay,
-                       s->glxContext );
-
+    mn_closeXPresenter( s );
     
     XDestroyWindow( s->xDisplay,
                     s->xWindow );
@@ -3665,379 +4481,866 @@ static void mn_releaseAllButtons( void ) {
     }
 
 
+/*
+  Returns the MinginButton for an X key or mouse button event, or
+  MGN_BUTTON_NONE for other events.
 
-/* whether or not first call to minginGame_step has been called
-   we don't initilize sound thread until after that */
-static  char  mn_firstStepRun  =  0;
+  Sets outDown to 1 for presses and 0 for releases.
+*/
+static MinginButton mn_mapXEventToButton( XEvent  *inEvent,
+                                          char    *outDown ) {
+    
+    *outDown = 0;
+    
+    if( inEvent->type == KeyPress ) {
+        *outDown = 1;
+        return mn_mapXKeyToButton( XLookupKeysym( &( inEvent->xkey ),
+                                                  0 ) );
+        }
+    else if( inEvent->type == KeyRelease ) {
+        return mn_mapXKeyToButton( XLookupKeysym( &( inEvent->xkey ),
+                                                  0 ) );
+        }
+    else if( inEvent->type == ButtonPress ) {
+        *outDown = 1;
+        return mn_mapXButtonToButton( inEvent->xbutton.button );
+        }
+    else if( inEvent->type == ButtonRelease ) {
+        return mn_mapXButtonToButton( inEvent->xbutton.button );
+        }
 
+    return MGN_BUTTON_NONE;
+    }
 
-static void mn_openSound( void );
 
-static void *mn_audioThreadFunction( void *inArg );
 
-static void mn_stepSound( void );
+/*
+  Keyboard, mouse button, and gamepad events are read by an input thread
+  with its own X display connection, so they're picked up even while the
+  main thread is drawing or blocked in glXSwapBuffers.
 
-static void mn_closeSound( void );
+  The thread sleeps in epoll_wait until X, the gamepad, or /dev/input
+  has something for it.
 
-static void mn_endBulkReadThread( void );
+  Each event is stamped and queued, and the main loop applies the whole
+  queue right before calling minginGame_step.  Gamepad events are queued
+  with their /dev/input/js numbers and mapped when they are applied, so
+  mn_activeGamepad and the stick positions are only touched by the main
+  thread.
 
-/* returns  1  if we can count on vsync to maintian mn_screenRefreshRate
-   returns  0  otherwise */
-static char mn_detectVsync( void );
+  If the thread can't be started, the main loop reads these events itself,
+  once per step.
+*/
+
+#define  MINGIN_INPUT_QUEUE_SIZE        256
+
+/* how many presses we measure before logging input latency */
+#define  MINGIN_INPUT_LATENCY_REPORT    120
+
+
+typedef enum MinginInputEventType {
+    /* number is a MinginButton, value is 1 for down, 0 for up */
+    MGN_INPUT_BUTTON,
+    /* number is a js button, value is 1 for down, 0 for up */
+    MGN_INPUT_JS_BUTTON,
+    /* number is a js stick, value is its position */
+    MGN_INPUT_JS_STICK,
+    /* value is the newly active MinginGamepad */
+    MGN_INPUT_GAMEPAD_CHANGE
+    } MinginInputEventType;
 
 
+typedef struct MinginInputEvent {
         
-int main( void ) {
+        MinginInputEventType  type;
 
-    int   b;
-    char  currentlyFullscreen  =   0;
-    int   gamepadFD            =  -1;
-    char  vsyncOn              =   0;
-    long  frameNS              =   0;
+        int                   number;
+        
+        int                   value;
 
-    struct timespec  nextFrameTime;
+        /* in mingin_getRunningMicroseconds time */
+        unsigned long         microseconds;
+        
+    } MinginInputEvent;
 
+
+static  MinginInputEvent  mn_inputQueue[ MINGIN_INPUT_QUEUE_SIZE ];
+static  int               mn_inputQueueStart       =  0;
+static  int               mn_inputQueueCount       =  0;
+static  int               mn_inputQueueDropped     =  0;
+static  char              mn_inputQueueLive        =  0;
+static  char              mn_inputThreadLive       =  0;
+static  pthread_t         mn_inputThread;
+/* protects queue */
+static  pthread_mutex_t   mn_inputMutex;
+/* only touched by input thread while it's running */
+static  Display          *mn_inputDisplay          =  NULL;
+/* written to when input thread should end */
+static  int               mn_inputWakePipe[2]      =  { -1, -1 };
+
+
+static  const char  *mn_measureInputLatencySetting  =
+    "mingin_measureInputLatency.ini";
+
+static  char           mn_measureInputLatency      =  0;
+
+/* times of presses applied before the most recent step, waiting
+   for that step's frame to be swapped */
+static  unsigned long  mn_latencyPending[ MINGIN_INPUT_QUEUE_SIZE ];
+static  int            mn_numLatencyPending        =  0;
+
+static  int            mn_numLatencySamples        =  0;
+static  unsigned long  mn_latencyQueuedTotal       =  0;
+static  unsigned long  mn_latencyQueuedMax         =  0;
+static  unsigned long  mn_latencySwapTotal         =  0;
+static  unsigned long  mn_latencySwapMax           =  0;
+
+
+
+/* safe to call from either thread */
+static void mn_queueInputEvent( MinginInputEventType  inType,
+                                int                   inNumber,
+                                int                   inValue,
+                                unsigned long         inMicroseconds ) {
+
+    if( ! mn_inputQueueLive ) {
+        return;
+        }
     
-    gettimeofday( & mn_programStartTime,
-                  NULL );
-    
-    mingin_log( "Linux mingin platform starting up\n" );
-    
-    mn_steamDeck = mn_isRunningOnSteamDeck();
-    
-    currentlyFullscreen = mn_getFlagSetting( fullscreenSetting,
-                                             -1 );
+    pthread_mutex_lock( &mn_inputMutex );
 
-    if( currentlyFullscreen != -1 ) {
-        mn_xFullscreen = currentlyFullscreen;
+    if( mn_inputQueueCount < MINGIN_INPUT_QUEUE_SIZE ) {
+                
+        MinginInputEvent  *q  =
+            &( mn_inputQueue[ ( mn_inputQueueStart + mn_inputQueueCount )
+                              % MINGIN_INPUT_QUEUE_SIZE ] );
+        q->type         = inType;
+        q->number       = inNumber;
+        q->value        = inValue;
+        q->microseconds = inMicroseconds;
+                
+        mn_inputQueueCount ++;
         }
     else {
-        /* default to fullscreen on all linux platforms */
-        currentlyFullscreen = 1;
-        mn_xFullscreen      = currentlyFullscreen;
+        /* main thread hasn't stepped in a very long time */
+        mn_inputQueueDropped ++;
         }
+            
+    pthread_mutex_unlock( &mn_inputMutex );
+    }
+
+
+
+static void mn_setupInputQueue( void ) {
     
+    if( pthread_mutex_init( &mn_inputMutex, 0 ) != 0 ) {
+        /* this should never happen, pthread_mutex_init always returns 0 */
+        
+        mingin_log( "Failed to create input mutex\n" );
+        return;
+        }
+
+    mn_inputQueueStart = 0;
+    mn_inputQueueCount = 0;
     
-    minginInternal_init();
+    mn_inputQueueLive = 1;
+    }
 
-    for( b = 0;
-         b < MGN_NUM_BUTTONS;
-         b ++ ) {
+
+
+static void mn_endInputQueue( void ) {
+    
+    if( ! mn_inputQueueLive ) {
+        return;
+        }
+    
+    mn_inputQueueLive = 0;
+    
+    pthread_mutex_destroy( &mn_inputMutex );
+
+    if( mn_inputQueueDropped > 0 ) {
+        mingin_log( "Input queue was full, dropped " );
+        mingin_log( mn_intToString( mn_inputQueueDropped ) );
+        mingin_log( " events\n" );
         
-        mn_buttonDown[b] = 0;
-        mn_buttonWasDownSinceLastStep[b] = 0;
-        mn_buttonToXKeyMap[b] = 0;
+        mn_inputQueueDropped = 0;
         }
+    }
 
-    mn_setupX11KeyMap();
 
-    mn_setupLinuxGamepadMaps();
+
+static void *mn_inputThreadFunction( void *inArg ) {
+
+    int                 epollFD;
+    int                 epollGamepadFD  =  -1;
+    struct epoll_event  e;
     
+    /* suppress warning, arg not needed */
+    if( inArg == 0 ) {
 
-    if( ! mn_openXWindow( & mn_XSetup ) ) {
-        mingin_log( "Opening X Window failed\n" );
-        return 1;
         }
 
-    if( mn_screenRefreshRate < 1 ) {
-        mn_screenRefreshRate = 60;
+    epollFD = epoll_create( 4 );
+
+    if( epollFD == -1 ) {
+        mingin_log( "Failed to create epoll instance for input thread\n" );
+        return 0;
         }
     
-    
-    mn_XSetupLive = 1;
+    e.events  = EPOLLIN;
+    e.data.fd = ConnectionNumber( mn_inputDisplay );
+    epoll_ctl( epollFD, EPOLL_CTL_ADD, e.data.fd, &e );
 
-    vsyncOn = mn_detectVsync();
-    
-    clock_gettime( CLOCK_MONOTONIC, &nextFrameTime );
+    e.events  = EPOLLIN;
+    e.data.fd = mn_inputWakePipe[0];
+    epoll_ctl( epollFD, EPOLL_CTL_ADD, e.data.fd, &e );
 
-    frameNS = 1000000000L / mn_screenRefreshRate;
+    if( mn_gamepadNotifyFD != -1 ) {
+        e.events  = EPOLLIN;
+        e.data.fd = mn_gamepadNotifyFD;
+        epoll_ctl( epollFD, EPOLL_CTL_ADD, e.data.fd, &e );
+        }
     
-        
-    gamepadFD = mn_openActiveGamepad();
+    while( 1 ) {
 
-    
-    while( ! mn_shouldQuit ) {
+        struct epoll_event  ready[ 4 ];
+        int                 numReady;
+        int                 i;
         
-        /* pump all X11 events */
-        while( XPending( mn_XSetup.xDisplay ) > 0 ) {
+        if( mn_gamepadFD != epollGamepadFD ) {
+            /* closing the old one already took it out of our set */
+            if( mn_gamepadFD != -1 ) {
+                e.events  = EPOLLIN;
+                e.data.fd = mn_gamepadFD;
+                epoll_ctl( epollFD, EPOLL_CTL_ADD, e.data.fd, &e );
+                }
+            epollGamepadFD = mn_gamepadFD;
+            }
+
+        /* Xlib may have read events into its own queue while handling
+           a request, so drain that before we sleep */
+        while( XPending( mn_inputDisplay ) > 0 ) {
             
-            XEvent  e;
+            XEvent        xe;
+            MinginButton  button;
+            char          down;
             
-            XNextEvent( mn_XSetup.xDisplay,
-                        &e );
+            XNextEvent( mn_inputDisplay,
+                        &xe );
 
-            if( e.type == KeyPress ) {
-                KeySym        ks      =  XLookupKeysym( &( e.xkey ),
-                                                        0 );
-                MinginButton  button  =  mn_mapXKeyToButton( ks );
-                
-                if( button > MGN_BUTTON_NONE ) {
-                    mn_setButtonState( button, 1 );
-                    }
+            button = mn_mapXEventToButton( &xe, &down );
+
+            if( button > MGN_BUTTON_NONE ) {
+                mn_queueInputEvent( MGN_INPUT_BUTTON,
+                                    button,
+                                    down,
+                                    mingin_getRunningMicroseconds() );
                 }
-            else if( e.type == KeyRelease ) {
-                KeySym        ks      =  XLookupKeysym( &(e.xkey),
-                                                        0 );
-                MinginButton  button  =  mn_mapXKeyToButton( ks );
-                
-                if( button > MGN_BUTTON_NONE ) {
-                    mn_setButtonState( button, 0 );
-                    }
+            }
+        
+        numReady = epoll_wait( epollFD,
+                               ready,
+                               4,
+                               -1 );
+
+        for( i = 0;
+             i < numReady;
+             i ++ ) {
+
+            if( ready[i].data.fd == mn_inputWakePipe[0] ) {
+                close( epollFD );
+                return 0;
                 }
-            else if( e.type == ButtonPress ) {
-                MinginButton  button  =  mn_mapXButtonToButton(
-                                             e.xbutton.button );
-                
-                if( button > MGN_BUTTON_NONE ) {
-                    mn_setButtonState( button, 1 );
-                    }
+            else if( ready[i].data.fd == mn_gamepadNotifyFD ) {
+                mn_readGamepadNotifications();
                 }
-            else if( e.type == ButtonRelease ) {
-                MinginButton  button  =  mn_mapXButtonToButton(
-                                             e.xbutton.button );
-                
-                if( button > MGN_BUTTON_NONE ) {
-                    mn_setButtonState( button, 0 );
+            else if( ready[i].data.fd == epollGamepadFD ) {
+                if( mn_readGamepadEvents() ) {
+                    /* closing took it out of our set, and a re-opened
+                       device can get the same fd number, so force
+                       an add at the top of the loop */
+                    epollGamepadFD = -1;
                     }
                 }
+            /* X events are handled at top of loop */
             }
+        }
+    }
 
-        /* pump all events for open joystick */
-        if( gamepadFD != -1 ) {
-
-            char             readMore  =  1;
-            ssize_t          numRead;
-            struct js_event  e;
-            
-            while( readMore ) {
-                numRead = read( gamepadFD,
-                                & e,
-                                sizeof( struct js_event ) );
-                
-                if( numRead == sizeof( struct js_event ) ) {
-
-                    MinginButton  button;
-                    char          pressed;
-                    
-                    /* for stick axes that act like binary button
-                       presses, the axis will return 0 when either
-                       directional button is released, so we need
-                       to release both of them */
-                    MinginButton  buttonMinus;
-                    MinginButton  buttonPlus;
-                    
-                    switch( e.type ) {
-                        case JS_EVENT_BUTTON:
-                            mn_gamepadTouched = 1;
-                            
-                            button = mn_mapJSButtonToButton( e.number );
-
-                            if( button > MGN_BUTTON_NONE ) {
-                                if( e.value ) {
-                                    /* press */
-                                    mn_setButtonState( button, 1 );
-                                    }
-                                else {
-                                    /* release */
-                                    mn_setButtonState( button, 0 );
-                                    }
-                                }
-                            break;
-                        case JS_EVENT_AXIS:
-                            if( e.value == 0 ) {
-                                /* might be a release of a stick
-                                   that behaves like a binary button */
-                                buttonPlus = mn_mapJSStickToButton( e.number,
-                                                                    1 );
-                                buttonMinus = mn_mapJSStickToButton( e.number,
-                                                                     -1 );
-
-                                if( buttonPlus > MGN_BUTTON_NONE ) {
-                                    mn_gamepadTouched = 1;
-                                    /* release */
-                                    mn_setButtonState( buttonPlus, 0 );
-                                    }
-                                if( buttonMinus > MGN_BUTTON_NONE ) {
-                                    mn_gamepadTouched = 1;
-                                    /* release */
-                                    mn_setButtonState( buttonMinus, 0 );
-                                    }
-                                }
-                            else {
-                                button = mn_mapJSStickToButton( e.number,
-                                                                e.value );
-                                /* negate the value to see
-                                   opposite side that might need to be
-                                   released */
-                                buttonMinus = mn_mapJSStickToButton( e.number,
-                                                                     -e.value );
-
-                                if( button > MGN_BUTTON_NONE ) {
-                                    mn_gamepadTouched = 1;
-                                    /* press */
-                                    mn_setButtonState( button, 1 );
-                                    }
-                                if( buttonMinus > MGN_BUTTON_NONE ) {
-                                    mn_gamepadTouched = 1;
-                                    /* release opposite side */
-                                    mn_setButtonState( buttonMinus, 0 );
-                                    }
-                                }
 
-                            
-                            button = mn_mapJSStickThresholdToButton( e.number,
-                                                                     e.value,
-                                                                     & pressed );
-                            if( button > MGN_BUTTON_NONE ) {
-                                mn_gamepadTouched = 1;
-                                mn_setButtonState( button, pressed );
-                                }
 
-                            
-                            mn_registerJSStickPosition( e.number,
-                                                        e.value );
+/*
+  Starts input thread for the current X window.
+  
+  Only one X client can select button presses on a window, so the main
+  connection gives them up first.
+*/
+static void mn_startInputThread( void ) {
 
-                            break;
-                        }
-                    }
-                else if( numRead == -1 ) {
-                    readMore = 0;
-                    
-                    if( errno == EAGAIN
-                        ||
-                        errno == EINTR
-                        ||
-                        errno == EWOULDBLOCK ) {
+    if( mn_inputThreadLive
+        ||
+        ! mn_inputQueueLive ) {
+        return;
+        }
+    
+    if( pipe( mn_inputWakePipe ) != 0 ) {
+        mingin_log( "Failed to create input thread wake pipe\n" );
+        return;
+        }
+    
+    mn_inputDisplay = XOpenDisplay( NULL );
 
-                        
-               
-                        /* no event ready, we've read all available */
-                        }
-                    else {
-                        /* error on reading... maybe joystick unplugged */
-                        close( gamepadFD );
-                        
-                        /* try to re-open, maybe switch joysticks */
-                        gamepadFD = mn_openActiveGamepad();
-                        }
-                    }
-                }
-            }
+    if( mn_inputDisplay == NULL ) {
+        mingin_log( "Failed to open X display for input thread\n" );
         
-            
+        close( mn_inputWakePipe[0] );
+        close( mn_inputWakePipe[1] );
+        return;
+        }
 
-        mn_areWeInStepFunction = 1;
+    XSelectInput( mn_XSetup.xDisplay,
+                  mn_XSetup.xWindow,
+                  StructureNotifyMask );
 
-        minginGame_step( 0 );
+    XSync( mn_XSetup.xDisplay,
+           False );
 
-        mn_areWeInStepFunction = 0;
+    XSelectInput( mn_inputDisplay,
+                  mn_XSetup.xWindow,
+                  KeyPressMask        |
+                  KeyReleaseMask      |
+                  ButtonPressMask     |
+                  ButtonReleaseMask );
 
+    XSync( mn_inputDisplay,
+           False );
 
-        /* any "was pressed at all" flags have been consumed by step
-           clear them */
-        for( b = 0;
-             b < MGN_NUM_BUTTONS;
-             b ++ ) {
-            mn_buttonWasDownSinceLastStep[b] = 0;
-            }
+    
+    if( pthread_create( & mn_inputThread,
+                        0,
+                        & mn_inputThreadFunction,
+                        0 ) != 0 ) {
         
+        mingin_log( "Failed to start input thread, reading input "
+                    "on main thread instead\n" );
+
+        XCloseDisplay( mn_inputDisplay );
+        mn_inputDisplay = NULL;
+
+        close( mn_inputWakePipe[0] );
+        close( mn_inputWakePipe[1] );
         
-        if( mn_shouldQuit ) {
-            /* mingin_quit called in the most recent step,
-               so we can't call any minginGame_ functions again */
-            break;
-            }
+        /* take button events back on main connection */
+        XSelectInput( mn_XSetup.xDisplay,
+                      mn_XSetup.xWindow,
+                      StructureNotifyMask |
+                      KeyPressMask        |
+                      KeyReleaseMask      |
+                      ButtonPressMask     |
+                      ButtonReleaseMask );
+        return;
+        }
 
+    mn_inputThreadLive = 1;
+    }
 
-        if( ! mn_firstStepRun ) {
-            /* first step has been run now, can start sound thread */
-            mn_openSound();
 
-            mn_firstStepRun = 1;
-            }
-        
-        
-        minginGame_getScreenPixels( mn_windowW,
-                                    mn_windowH,
-                                    mn_gameScreenBuffer );
 
-        
+/* must be called before the X window is closed */
+static void mn_endInputThread( void ) {
+    
+    void  *threadReturnVal;
+    char   wakeByte         =  1;
+    
+    if( ! mn_inputThreadLive ) {
+        return;
+        }
 
-        if( (mn_realWindowW == mn_windowW
-            &&
-             mn_realWindowH == mn_windowH )) {
+    if( write( mn_inputWakePipe[1], &wakeByte, 1 ) != 1 ) {
+        mingin_log( "Failed to wake input thread\n" );
+        }
+    
+    if( pthread_join( mn_inputThread, &threadReturnVal ) != 0 ) {
+        mingin_log( "Failed to join input thread\n" );
+        }
 
-            glRasterPos2f( -1,
-                            1 );
-            
-            glPixelZoom(  1,
-                         -1 );
+    mn_inputThreadLive = 0;
+    
+    XCloseDisplay( mn_inputDisplay );
+    mn_inputDisplay = NULL;
+
+    close( mn_inputWakePipe[0] );
+    close( mn_inputWakePipe[1] );
+    }
+
+
+
+static void mn_applyJSButton( int  inJSButton,
+                              int  inValue ) {
+    
+    MinginButton  button  =  mn_mapJSButtonToButton( inJSButton );
+
+    mn_gamepadTouched = 1;
+    
+    if( button > MGN_BUTTON_NONE ) {
+        if( inValue ) {
+            /* press */
+            mn_setButtonState( button, 1 );
             }
         else {
-            /* we must be in fullscreen mode, and fullscreen size
-               is too big for our static buffer... scale up the
-               best we can */
-
-            /* use smallest scale factor to keep game image
-               entirely on screen */
-            int scaleFactorW;
-            int scaleFactorH;
-            int scaleFactor;
-            int offsetX;
-            int offsetY;
-            
-            scaleFactorW = mn_realWindowW / mn_windowW;
-            scaleFactorH = mn_realWindowH / mn_windowH;
+            /* release */
+            mn_setButtonState( button, 0 );
+            }
+        }
+    }
 
-            scaleFactor = scaleFactorW;
 
-            if( scaleFactorH < scaleFactor ) {
-                scaleFactor = scaleFactorH;
-                }
 
-            offsetX = ( mn_realWindowW - mn_windowW * scaleFactor );
-            offsetY = ( mn_realWindowH - mn_windowH * scaleFactor );
+static void mn_applyJSStick( int  inJSStick,
+                             int  inValue ) {
+    
+    MinginButton  button;
+    char          pressed;
+                    
+    /* for stick axes that act like binary button
+       presses, the axis will return 0 when either
+       directional button is released, so we need
+       to release both of them */
+    MinginButton  buttonMinus;
+    MinginButton  buttonPlus;
+    
+    if( inValue == 0 ) {
+        /* might be a release of a stick
+           that behaves like a binary button */
+        buttonPlus = mn_mapJSStickToButton( inJSStick,
+                                            1 );
+        buttonMinus = mn_mapJSStickToButton( inJSStick,
+                                             -1 );
 
-            glRasterPos2f( -1 + (GLfloat)offsetX / (GLfloat)mn_realWindowW,
-                            1 - (GLfloat)offsetY / (GLfloat)mn_realWindowH );
-            
-            glPixelZoom(   (GLfloat)scaleFactor,
-                         - (GLfloat)scaleFactor );
+        if( buttonPlus > MGN_BUTTON_NONE ) {
+            mn_gamepadTouched = 1;
+            /* release */
+            mn_setButtonState( buttonPlus, 0 );
+            }
+        if( buttonMinus > MGN_BUTTON_NONE ) {
+            mn_gamepadTouched = 1;
+            /* release */
+            mn_setButtonState( buttonMinus, 0 );
             }
+        }
+    else {
+        button = mn_mapJSStickToButton( inJSStick,
+                                        inValue );
+        /* negate the value to see
+           opposite side that might need to be
+           released */
+        buttonMinus = mn_mapJSStickToButton( inJSStick,
+                                             -inValue );
 
-        glClearColor( 0, 0, 0, 1 );
-        
-        glClear( GL_COLOR_BUFFER_BIT );
+        if( button > MGN_BUTTON_NONE ) {
+            mn_gamepadTouched = 1;
+            /* press */
+            mn_setButtonState( button, 1 );
+            }
+        if( buttonMinus > MGN_BUTTON_NONE ) {
+            mn_gamepadTouched = 1;
+            /* release opposite side */
+            mn_setButtonState( buttonMinus, 0 );
+            }
+        }
 
-        glPixelStorei( GL_UNPACK_ALIGNMENT,
-                       1 );
- 
-        glDrawPixels( (GLsizei)mn_windowW,
-                      (GLsizei)mn_windowH,
-                      GL_RGB,
-                      GL_UNSIGNED_BYTE,
-                      mn_gameScreenBuffer );
+                            
+    button = mn_mapJSStickThresholdToButton( inJSStick,
+                                             inValue,
+                                             & pressed );
+    if( button > MGN_BUTTON_NONE ) {
+        mn_gamepadTouched = 1;
+        mn_setButtonState( button, pressed );
+        }
+                            
+    mn_registerJSStickPosition( inJSStick,
+                                inValue );
+    }
 
-        glXSwapBuffers( mn_XSetup.xDisplay,
-                        mn_XSetup.xWindow ); 
 
-        if( ! vsyncOn ) {
 
-            nextFrameTime.tv_nsec += frameNS;
+/*
+  Reads and queues all available gamepad and keyboard input if the input
+  thread isn't doing that for us.
+*/
+static void mn_pumpInputWithoutThread( void ) {
+    
+    if( mn_inputThreadLive ) {
+        return;
+        }
 
-            /* watch out for nsec overflow */
-            while( nextFrameTime.tv_nsec > 1000000000L ) {
-                nextFrameTime.tv_nsec   -= 1000000000L;
-                nextFrameTime.tv_sec ++;
-                }
+    mn_readGamepadNotifications();
 
-            clock_nanosleep( CLOCK_MONOTONIC,
-                             TIMER_ABSTIME,
-                             &nextFrameTime,
-                             0 );
-            }
-        
-        
+    mn_readGamepadEvents();
+    }
+
+
+
+/* applies all queued input events, in order, right before a step */
+static void mn_applyQueuedInput( void ) {
+
+    unsigned long  now;
+    
+    if( ! mn_inputQueueLive ) {
+        return;
+        }
+
+    now = mingin_getRunningMicroseconds();
+    
+    pthread_mutex_lock( &mn_inputMutex );
+
+    while( mn_inputQueueCount > 0 ) {
+        
+        MinginInputEvent  *q  =  &( mn_inputQueue[ mn_inputQueueStart ] );
+        int                s;
+        
+        switch( q->type ) {
+            case MGN_INPUT_BUTTON:
+                mn_setButtonState( (MinginButton)q->number,
+                                   (char)q->value );
+                break;
+            case MGN_INPUT_JS_BUTTON:
+                mn_applyJSButton( q->number, q->value );
+                break;
+            case MGN_INPUT_JS_STICK:
+                mn_applyJSStick( q->number, q->value );
+                break;
+            case MGN_INPUT_GAMEPAD_CHANGE:
+                mn_activeGamepad = (MinginGamepad)q->value;
+
+                /* whenever we open or re-open a gamepad,
+                   zero out our stick positions */
+                for( s = 0;
+                     s < MGN_NUM_STICKS;
+                     s ++ ) {
+        
+                    mn_stickPosition[ s ] = 0;
+                    }
+                break;
+            }
+
+        if( mn_measureInputLatency
+            &&
+            q->value
+            &&
+            ( q->type == MGN_INPUT_BUTTON
+              ||
+              q->type == MGN_INPUT_JS_BUTTON )
+            &&
+            mn_numLatencyPending < MINGIN_INPUT_QUEUE_SIZE ) {
+
+            unsigned long  queued  =  now - q->microseconds;
+
+            mn_latencyPending[ mn_numLatencyPending ] = q->microseconds;
+            mn_numLatencyPending ++;
+
+            mn_latencyQueuedTotal += queued;
+
+            if( queued > mn_latencyQueuedMax ) {
+                mn_latencyQueuedMax = queued;
+                }
+            }
+        
+        mn_inputQueueStart =
+            ( mn_inputQueueStart + 1 ) % MINGIN_INPUT_QUEUE_SIZE;
+        mn_inputQueueCount --;
+        }
+    
+    pthread_mutex_unlock( &mn_inputMutex );
+    }
+
+
+
+static void mn_logInputLatency( void ) {
+    
+    if( mn_numLatencySamples == 0 ) {
+        return;
+        }
+    
+    mingin_log( "Input latency over " );
+    mingin_log( mn_intToString( mn_numLatencySamples ) );
+    mingin_log( " presses (microseconds):  until step avg " );
+    mingin_log( mn_intToString(
+                    (int)( mn_latencyQueuedTotal
+                           / (unsigned long)mn_numLatencySamples ) ) );
+    mingin_log( " max " );
+    mingin_log( mn_intToString( (int)mn_latencyQueuedMax ) );
+    mingin_log( ",  until swap avg " );
+    mingin_log( mn_intToString(
+                    (int)( mn_latencySwapTotal
+                           / (unsigned long)mn_numLatencySamples ) ) );
+    mingin_log( " max " );
+    mingin_log( mn_intToString( (int)mn_latencySwapMax ) );
+    mingin_log( "\n" );
+
+    mn_numLatencySamples  = 0;
+    mn_latencyQueuedTotal = 0;
+    mn_latencyQueuedMax   = 0;
+    mn_latencySwapTotal   = 0;
+    mn_latencySwapMax     = 0;
+    }
+
+
+
+/*
+  Called after the frame drawn by the most recent step has been
+  swapped, which is as close to photons as we can measure.
+*/
+static void mn_finishInputLatency( void ) {
+    
+    unsigned long  now;
+    int            i;
+    
+    if( mn_numLatencyPending == 0 ) {
+        return;
+        }
+
+    now = mingin_getRunningMicroseconds();
+
+    for( i = 0;
+         i < mn_numLatencyPending;
+         i ++ ) {
+
+        unsigned long  total  =  now - mn_latencyPending[i];
+
+        mn_latencySwapTotal += total;
+
+        if( total > mn_latencySwapMax ) {
+            mn_latencySwapMax = total;
+            }
+
+        mn_numLatencySamples ++;
+        }
+    
+    mn_numLatencyPending = 0;
+
+    if( mn_numLatencySamples >= MINGIN_INPUT_LATENCY_REPORT ) {
+        mn_logInputLatency();
+        }
+    }
+
+
+
+
+/* whether or not first call to minginGame_step has been called
+   we don't initilize sound thread until after that */
+static  char  mn_firstStepRun  =  0;
+
+
+static void mn_openSound( void );
+
+static void *mn_audioThreadFunction( void *inArg );
+
+static void mn_stepSound( void );
+
+static void mn_closeSound( void );
+
+static void mn_endBulkReadThread( void );
+
+static void mn_setupBulkDataNotifications( void );
+
+static void mn_readBulkDataNotifications( void );
+
+static void mn_endBulkDataNotifications( void );
+
+static void mn_endAsyncReadThreads( void );
+
+/* returns  1  if we can count on vsync to maintian mn_screenRefreshRate
+   returns  0  otherwise */
+static char mn_detectVsync( void );
+
+/* draws mn_gameScreenBuffer to window and swaps */
+static void mn_glPresentScreen( void );
+
+static void mn_shmPresentScreen( void );
+
+
+        
+int main( void ) {
+
+    int   b;
+    char  currentlyFullscreen  =   0;
+    char  vsyncOn              =   0;
+    long  frameNS              =   0;
+
+    struct timespec  nextFrameTime;
+
+    
+    gettimeofday( & mn_programStartTime,
+                  NULL );
+    
+    mingin_log( "Linux mingin platform starting up\n" );
+
+    /* input thread has its own display connection, but Xlib's
+       shared state still needs to be thread safe */
+    XInitThreads();
+    
+    mn_steamDeck = mn_isRunningOnSteamDeck();
+    
+    currentlyFullscreen = mn_getFlagSetting( fullscreenSetting,
+                                             -1 );
+
+    if( currentlyFullscreen != -1 ) {
+        mn_xFullscreen = currentlyFullscreen;
+        }
+    else {
+        /* default to fullscreen on all linux platforms */
+        currentlyFullscreen = 1;
+        mn_xFullscreen      = currentlyFullscreen;
+        }
+    
+    
+    minginInternal_init();
+
+    for( b = 0;
+         b < MGN_NUM_BUTTONS;
+         b ++ ) {
+        
+        mn_buttonDown[b] = 0;
+        mn_buttonWasDownSinceLastStep[b] = 0;
+        mn_buttonToXKeyMap[b] = 0;
+        }
+
+    mn_setupX11KeyMap();
+
+    mn_setupLinuxGamepadMaps();
+    
+
+    if( ! mn_openXWindow( & mn_XSetup ) ) {
+        mingin_log( "Opening X Window failed\n" );
+        return 1;
+        }
+
+    if( mn_screenRefreshRate < 1 ) {
+        mn_screenRefreshRate = 60;
+        }
+    
+    
+    mn_XSetupLive = 1;
+
+    mn_measureInputLatency = mn_getFlagSetting( mn_measureInputLatencySetting,
+                                                0 );
+
+    if( mn_measureInputLatency ) {
+        mingin_log( "Measuring input latency\n" );
+        }
+    
+    mn_setupInputQueue();
+
+    mn_setupGamepadInput();
+    
+    mn_startInputThread();
+    
+    vsyncOn = mn_detectVsync();
+    
+    clock_gettime( CLOCK_MONOTONIC, &nextFrameTime );
+
+    frameNS = 1000000000L / mn_screenRefreshRate;
+    
+    
+    mn_setupBulkDataNotifications();
+
+    
+    while( ! mn_shouldQuit ) {
+        
+        /* pump all X11 events
+           when input thread is running, these are only window events,
+           otherwise they include key and mouse button events */
+        while( XPending( mn_XSetup.xDisplay ) > 0 ) {
+            
+            XEvent        e;
+            MinginButton  button;
+            char          down;
+            
+            XNextEvent( mn_XSetup.xDisplay,
+                        &e );
+
+            button = mn_mapXEventToButton( &e, &down );
+            
+            if( button > MGN_BUTTON_NONE ) {
+                mn_setButtonState( button, down );
+                }
+            }
+
+        /* gamepad too, if input thread isn't reading it */
+        mn_pumpInputWithoutThread();
+
+        mn_readBulkDataNotifications();
+
+        /* as late as possible, to catch input that arrived while
+           we were waiting for the last swap */
+        mn_applyQueuedInput();
+        
+        mn_areWeInStepFunction = 1;
+
+        minginGame_step( 0 );
+
+        mn_areWeInStepFunction = 0;
+
+
+        /* any "was pressed at all" flags have been consumed by step
+           clear them */
+        for( b = 0;
+             b < MGN_NUM_BUTTONS;
+             b ++ ) {
+            mn_buttonWasDownSinceLastStep[b] = 0;
+            }
+        
+        
+        if( mn_shouldQuit ) {
+            /* mingin_quit called in the most recent step,
+               so we can't call any minginGame_ functions again */
+            break;
+            }
+
+
+        if( ! mn_firstStepRun ) {
+            /* first step has been run now, can start sound thread */
+            mn_openSound();
+
+            mn_firstStepRun = 1;
+            }
+        
+        
+        minginGame_getScreenPixels( mn_windowW,
+                                    mn_windowH,
+                                    mn_gameScreenBuffer );
+
+        
+
+        if( mn_XSetup.useShm ) {
+            mn_shmPresentScreen();
+            }
+        else {
+            mn_glPresentScreen();
+            }
+
+        if( mn_measureInputLatency ) {
+            mn_finishInputLatency();
+            }
+        
+        if( ! vsyncOn ) {
+
+            nextFrameTime.tv_nsec += frameNS;
+
+            /* watch out for nsec overflow */
+            while( nextFrameTime.tv_nsec > 1000000000L ) {
+                nextFrameTime.tv_nsec   -= 1000000000L;
+                nextFrameTime.tv_sec ++;
+                }
+
+            clock_nanosleep( CLOCK_MONOTONIC,
+                             TIMER_ABSTIME,
+                             &nextFrameTime,
+                             0 );
+            }
+        
+        
 
         
         if( currentlyFullscreen != mn_xFullscreen ) {
@@ -4064,6 +5367,8 @@ int main( void ) {
                 mingin_log( mn_intToString( mn_realWindowH ) );
                 mingin_log( "\n" );
 
+                mn_endInputThread();
+                
                 mn_closeXWindow( & mn_XSetup );
 
                 if( ! mn_openXWindow( & mn_XSetup ) ) {
@@ -4071,6 +5376,8 @@ int main( void ) {
                                 "fullscreen mode\n" );
                     return 1;
                     }
+
+                mn_startInputThread();
                 }
             else {
                 /* same window size after fullscreen toggle,
@@ -4097,20 +5404,237 @@ int main( void ) {
     mn_closeSound();
 
     mn_endBulkReadThread();
-    
-    mn_closeXWindow( & mn_XSetup );
 
-    if( gamepadFD != -1 ) {
-        close( gamepadFD );
-        gamepadFD = -1;
-        }
-    
-    return 1;
-    }
+    mn_endBulkDataNotifications();
+
+    mn_endAsyncReadThreads();
+
+    /* in case game left it running */
+    mingin_endWorkerThread();
+
+    mn_endInputThread();
+
+    mn_logInputLatency();
+    
+    mn_closeXWindow( & mn_XSetup );
+
+    mn_endGamepadInput();
+
+    mn_endInputQueue();
+    
+    return 1;
+    }
+
+
+
+static void mn_glPresentScreen( void ) {
+
+    if( (mn_realWindowW == mn_windowW
+        &&
+         mn_realWindowH == mn_windowH )) {
+
+        glRasterPos2f( -1,
+                        1 );
+        
+        glPixelZoom(  1,
+                     -1 );
+        }
+    else {
+        /* we must be in fullscreen mode, and fullscreen size
+           is too big for our static buffer... scale up the
+           best we can */
+
+        /* use smallest scale factor to keep game image
+           entirely on screen */
+        int scaleFactorW;
+        int scaleFactorH;
+        int scaleFactor;
+        int offsetX;
+        int offsetY;
+        
+        scaleFactorW = mn_realWindowW / mn_windowW;
+        scaleFactorH = mn_realWindowH / mn_windowH;
+
+        scaleFactor = scaleFactorW;
+
+        if( scaleFactorH < scaleFactor ) {
+            scaleFactor = scaleFactorH;
+            }
+
+        offsetX = ( mn_realWindowW - mn_windowW * scaleFactor );
+        offsetY = ( mn_realWindowH - mn_windowH * scaleFactor );
+
+        glRasterPos2f( -1 + (GLfloat)offsetX / (GLfloat)mn_realWindowW,
+                        1 - (GLfloat)offsetY / (GLfloat)mn_realWindowH );
+        
+        glPixelZoom(   (GLfloat)scaleFactor,
+                     - (GLfloat)scaleFactor );
+        }
+
+    glClearColor( 0, 0, 0, 1 );
+    
+    glClear( GL_COLOR_BUFFER_BIT );
+
+    glPixelStorei( GL_UNPACK_ALIGNMENT,
+                   1 );
+
+    mn_startPresentStage( MGN_PRESENT_UPLOAD );
+    
+    glDrawPixels( (GLsizei)mn_windowW,
+                  (GLsizei)mn_windowH,
+                  GL_RGB,
+                  GL_UNSIGNED_BYTE,
+                  mn_gameScreenBuffer );
+    
+    mn_endPresentStage( MGN_PRESENT_UPLOAD );
+
+    mn_startPresentStage( MGN_PRESENT_SWAP );
+    
+    glXSwapBuffers( mn_XSetup.xDisplay,
+                    mn_XSetup.xWindow ); 
+    
+    mn_endPresentStage( MGN_PRESENT_SWAP );
+    }
+
+
+
+static void mn_shmPresentScreen( void ) {
+
+    XImage        *image    =  mn_XSetup.shmImage;
+    int            scale    =  1;
+    int            offsetX  =  0;
+    int            offsetY  =  0;
+    int            numCols;
+    int            x;
+    int            y;
+    int            k;
+    
+    if( mn_realWindowW != mn_windowW
+        ||
+        mn_realWindowH != mn_windowH ) {
+
+        /* same integer scaling and centering as our GL path */
+        int scaleFactorW  =  mn_realWindowW / mn_windowW;
+        int scaleFactorH  =  mn_realWindowH / mn_windowH;
+
+        scale = scaleFactorW;
+
+        if( scaleFactorH < scale ) {
+            scale = scaleFactorH;
+            }
+        if( scale < 1 ) {
+            scale = 1;
+            }
+
+        offsetX = ( mn_realWindowW - mn_windowW * scale ) / 2;
+        offsetY = ( mn_realWindowH - mn_windowH * scale ) / 2;
+
+        if( offsetX < 0 ) {
+            offsetX = 0;
+            }
+        if( offsetY < 0 ) {
+            offsetY = 0;
+            }
+        }
+
+    numCols = ( image->width - offsetX ) / scale;
+
+    if( numCols > mn_windowW ) {
+        numCols = mn_windowW;
+        }
+    
+    mn_startPresentStage( MGN_PRESENT_UPLOAD );
+
+    /* convert RGB straight into the shared image as we scale it up,
+       so that's the only copy we make */
+    for( y = 0;
+         y < mn_windowH;
+         y ++ ) {
+
+        const unsigned char  *source   =
+            &( mn_gameScreenBuffer[ y * mn_windowW * 3 ] );
+        int                   destY    =  offsetY + y * scale;
+        unsigned int         *firstRow;
+        unsigned int         *dest;
+
+        if( destY + scale > image->height ) {
+            break;
+            }
+
+        firstRow = (unsigned int *)( image->data
+                                     + destY * image->bytes_per_line )
+            + offsetX;
+
+        dest = firstRow;
+        
+        for( x = 0;
+             x < numCols;
+             x ++ ) {
+            
+            unsigned int  p  =
+                (unsigned int)source[0] << 16
+                |
+                (unsigned int)source[1] << 8
+                |
+                (unsigned int)source[2];
+
+            for( k = 0;
+                 k < scale;
+                 k ++ ) {
+                *dest = p;
+                dest ++;
+                }
+            source += 3;
+            }
+
+        for( k = 1;
+             k < scale;
+             k ++ ) {
+            
+            unsigned int  *row  =
+                (unsigned int *)( image->data
+                                  + ( destY + k ) * image->bytes_per_line )
+                + offsetX;
+
+            for( x = 0;
+                 x < numCols * scale;
+                 x ++ ) {
+                row[x] = firstRow[x];
+                }
+            }
+        }
+
+    XShmPutImage( mn_XSetup.xDisplay,
+                  mn_XSetup.xWindow,
+                  DefaultGC( mn_XSetup.xDisplay, mn_XSetup.xScreen ),
+                  image,
+                  0, 0,
+                  0, 0,
+                  (unsigned int)image->width,
+                  (unsigned int)image->height,
+                  False );
+    
+    mn_endPresentStage( MGN_PRESENT_UPLOAD );
+
+    mn_startPresentStage( MGN_PRESENT_SWAP );
+
+    /* wait until X has read the image, so we can't write over it
+       while it's still being displayed */
+    XSync( mn_XSetup.xDisplay,
+           False );
+    
+    mn_endPresentStage( MGN_PRESENT_SWAP );
+    }
 
 
 
 static void mn_testSwapScreen( void ) {
+
+    if( mn_XSetup.useShm ) {
+        mn_shmPresentScreen();
+        return;
+        }
+    
     glRasterPos2f( -1, 1 );
     
     glPixelZoom( 1, -1 );
@@ -4523,1451 +6047,3486 @@ static int mn_getGamepadIndex( const char  *inIDString ) {
 /*
   Returns static string.
 
-  Only indexes 0..9 supported.
+  Only indexes 0..99 supported.
 */
-static const char *mn_getJSPath( int  inIndex ) {
+static const char *mn_getEventPath( int  inIndex ) {
 
-    static  char  pathString[15]  = "/dev/input/js0";
+    static  char  pathString[20]  = "/dev/input/event0";
 
-    int  digitPos  =  13;
+    int  digitPos  =  16;
 
-    
-    pathString[ digitPos ] = (char)( '0' + inIndex );
+    if( inIndex < 10 ) {
+        pathString[ digitPos ]     = (char)( '0' + inIndex );
+        pathString[ digitPos + 1 ] = '\0';
+        }
+    else {
+        pathString[ digitPos ]     = (char)( '0' + inIndex / 10 );
+        pathString[ digitPos + 1 ] = (char)( '0' + inIndex % 10 );
+        pathString[ digitPos + 2 ] = '\0';
+        }
     
     return pathString;
     }
 
 
 
-static int mn_openActiveGamepad( void ) {
-
-    int   fd;
-    char  name[ 128 ];
-    int   i             =  0;
-    int   result;
+#define  MINGIN_MAX_EVENT_DEVICES   64
 
-    
-    /* init name buffer to avoid valgrind errors */
-    for( i = 0;
-         i < 128;
-         i ++ ) {
-        name[ i ] = '\0';
-        }
-    
-    /* whenever we open or re-open a gamepad, zero out our stick positions */
-    for( i = 0;
-         i < MGN_NUM_STICKS;
-         i ++ ) {
-        
-        mn_stickPosition[ i ] = 0;
-        }
+#define  MINGIN_BITS_PER_LONG       ( 8 * (int)sizeof( unsigned long ) )
 
-    for( i =  0;
-         i <= 9;
-         i ++ ) {
-        
-        fd = open( mn_getJSPath( i ),
-                   O_RDONLY | O_NONBLOCK );
 
-        if( fd != -1 ) {
-            /* opened a joystick device */
+static  unsigned long  mn_evdevKeyBits[ KEY_CNT / MINGIN_BITS_PER_LONG + 1 ];
+static  unsigned long  mn_evdevAbsBits[ ABS_CNT / MINGIN_BITS_PER_LONG + 1 ];
 
-            /* does it match one of our strings? */
 
-            result = ioctl( fd,
-                            JSIOCGNAME( sizeof( name ) ),
-                            name );
 
-            if( result >= 0 ) {
-                
-                int gamepadIndex  =
-                    mn_getGamepadIndex( name );
+static char mn_testEvdevBit( const unsigned long  *inBits,
+                             int                   inBit ) {
+    
+    return (char)( ( inBits[ inBit / MINGIN_BITS_PER_LONG ]
+                     >> ( inBit % MINGIN_BITS_PER_LONG ) ) & 1 );
+    }
 
-                if( gamepadIndex != -1 ) {
 
-                    mingin_log( "Active gamepad opened: " );
-                    mingin_log( name );
-                    mingin_log( "\n" );
-                    
-                    mn_activeGamepad = gamepadIndex;
 
-                    return fd;
-                    }
-                }
+/* fills mn_evdevKeyBits, or clears it if ioctl fails */
+static void mn_readEvdevKeyBits( int           inFD,
+                                 unsigned int  inRequest ) {
+    int  i;
+    
+    for( i = 0;
+         i < KEY_CNT / MINGIN_BITS_PER_LONG + 1;
+         i ++ ) {
+        mn_evdevKeyBits[i] = 0;
+        }
 
-            /* not a match */
-            close( fd );
+    if( ioctl( inFD,
+               inRequest,
+               mn_evdevKeyBits ) < 0 ) {
+        
+        for( i = 0;
+             i < KEY_CNT / MINGIN_BITS_PER_LONG + 1;
+             i ++ ) {
+            mn_evdevKeyBits[i] = 0;
             }
         }
+    }
 
-    /* got through all of /dev/input/js0 through /dev/input/js9
-       without finding one */
 
-    mn_activeGamepad = MGN_NO_GAMEPAD;
 
-    return -1;
-    }
+/* same default correction joydev uses, scales to -32767..32767 */
+static int mn_correctEvdevAbs( int  inCode,
+                               int  inValue ) {
+    
+    long  *c  =  mn_evdevAbsCorrection[ inCode ];
+    long   v  =  inValue;
 
+    if( v > c[0] ) {
+        if( v < c[1] ) {
+            v = 0;
+            }
+        else {
+            v = ( c[3] * ( v - c[1] ) ) >> 14;
+            }
+        }
+    else {
+        v = ( c[2] * ( v - c[0] ) ) >> 14;
+        }
 
+    if( v < -32767 ) {
+        v = -32767;
+        }
+    else if( v > 32767 ) {
+        v = 32767;
+        }
     
+    return (int)v;
+    }
 
 
 
-static char *mn_linuxGetFilePath( const char  *inFolderName,
-                                  const char  *inFileName ) {
-    
-    enum{  MAX_PATH_LEN  =  255,
-           NUM_BUFFERS   =    2   };
-
-    static  int   curBuffer  = 0;
-    
-    static  char  buffer[ NUM_BUFFERS ][ MAX_PATH_LEN + 1 ];
+/*
+  Numbers buttons and sticks on an opened evdev device the way joydev
+  does, and records their current state.
+*/
+static void mn_mapEvdevDevice( int  inFD ) {
 
-    
-    int  i  =  0;
-    int  j  =  0;
+    int  code;
+    int  numButtons  =  0;
+    int  numSticks   =  0;
 
+    mn_readEvdevKeyBits( inFD,
+                         EVIOCGBIT( EV_KEY, sizeof( mn_evdevKeyBits ) ) );
     
-    curBuffer ++;
+    for( code = 0;
+         code < KEY_CNT;
+         code ++ ) {
+        mn_evdevKeyToJSButton[ code ] = -1;
+        mn_evdevKeyValue[ code ]      = 0;
+        }
 
-    if( curBuffer >= NUM_BUFFERS ) {
-        curBuffer = 0;
+    /* joydev numbers joystick and gamepad buttons first,
+       then the misc buttons below them */
+    for( code = BTN_JOYSTICK;
+         code < KEY_CNT;
+         code ++ ) {
+        if( mn_testEvdevBit( mn_evdevKeyBits, code ) ) {
+            mn_evdevKeyToJSButton[ code ] = numButtons;
+            numButtons ++;
+            }
         }
-    
-    while( i < MAX_PATH_LEN
-           &&
-           inFolderName[i] != '\0' ) {
-        
-        buffer[curBuffer][i] = inFolderName[i];
-        i++;
+    for( code = BTN_MISC;
+         code < BTN_JOYSTICK;
+         code ++ ) {
+        if( mn_testEvdevBit( mn_evdevKeyBits, code ) ) {
+            mn_evdevKeyToJSButton[ code ] = numButtons;
+            numButtons ++;
+            }
         }
+
     
-    /* now separator */
-    if( i < MAX_PATH_LEN ) {
-        buffer[curBuffer][i] = '/';
-        i++;
+    for( code = 0;
+         code < ABS_CNT / MINGIN_BITS_PER_LONG + 1;
+         code ++ ) {
+        mn_evdevAbsBits[ code ] = 0;
         }
     
-    while( i < MAX_PATH_LEN
-           &&
-           inFileName[j] != '\0' ) {
+    if( ioctl( inFD,
+               EVIOCGBIT( EV_ABS, sizeof( mn_evdevAbsBits ) ),
+               mn_evdevAbsBits ) < 0 ) {
         
-        buffer[curBuffer][i] = inFileName[j];
-        i++;
-        j++;
+        mingin_log( "Failed to read gamepad stick list\n" );
         }
+    
+    for( code = 0;
+         code < ABS_CNT;
+         code ++ ) {
 
-    /* now terminate */
-    if( i < MAX_PATH_LEN ) {
-        buffer[curBuffer][i] = '\0';
+        struct input_absinfo  info;
+        long                 *c     =  mn_evdevAbsCorrection[ code ];
+        long                  t;
+        
+        mn_evdevAbsToJSStick[ code ] = -1;
+        mn_evdevAbsValue[ code ]     = 0;
+
+        c[0] = 0;
+        c[1] = 0;
+        c[2] = 0;
+        c[3] = 0;
+        
+        if( ! mn_testEvdevBit( mn_evdevAbsBits, code )
+            ||
+            ioctl( inFD, EVIOCGABS( (unsigned int)code ), &info ) < 0 ) {
+            continue;
+            }
+        
+        mn_evdevAbsToJSStick[ code ] = numSticks;
+        numSticks ++;
+
+        t = ( (long)info.maximum + (long)info.minimum ) / 2;
+        
+        c[0] = t - info.flat;
+        c[1] = t + info.flat;
+
+        t = ( (long)info.maximum - (long)info.minimum ) / 2 - 2 * info.flat;
+
+        if( t != 0 ) {
+            c[2] = ( 1L << 29 ) / t;
+            c[3] = ( 1L << 29 ) / t;
+            }
+
+        mn_evdevAbsValue[ code ] = mn_correctEvdevAbs( code,
+                                                       info.value );
         }
+
     
-    return buffer[curBuffer];
+    mn_readEvdevKeyBits( inFD,
+                         EVIOCGKEY( sizeof( mn_evdevKeyBits ) ) );
+    
+    for( code = 0;
+         code < KEY_CNT;
+         code ++ ) {
+        mn_evdevKeyValue[ code ] = mn_testEvdevBit( mn_evdevKeyBits, code );
+        }
+
+    mn_evdevDropped = 0;
     }
 
 
 
-static int mn_linuxFileOpenRead( const char  *inFolderName,
-                                 const char  *inFileName,
-                                 int         *outTotalBytes ) {
-    struct stat   statStruct;
-    int           fd;
-    char         *path         =  mn_linuxGetFilePath( inFolderName,
-                                                       inFileName );
+static void mn_evdevKeyChanged( int            inCode,
+                                char           inValue,
+                                unsigned long  inMicroseconds ) {
 
-    *outTotalBytes = 0;
-    
-    if( stat( path, &statStruct ) == 0 ) {
-        
-        *outTotalBytes = (int)( statStruct.st_size );
-        }
-    else {
-        /* stat failed, file does not exist */
-        return -1;
+    int  jsButton  =  mn_evdevKeyToJSButton[ inCode ];
+
+    if( jsButton == -1
+        ||
+        mn_evdevKeyValue[ inCode ] == inValue ) {
+        /* not a button, or auto-repeat */
+        return;
         }
     
-    fd = open( path,
-               O_RDONLY );
+    mn_evdevKeyValue[ inCode ] = inValue;
 
-    return fd;
+    mn_queueInputEvent( MGN_INPUT_JS_BUTTON,
+                        jsButton,
+                        inValue,
+                        inMicroseconds );
     }
 
 
 
-static int mn_linuxFileOpenWrite( const char  *inFolderName,
-                                  const char  *inFileName ) {
-    struct stat  statStruct;
-    char         folderExists  =  0;
+static void mn_evdevAbsChanged( int            inCode,
+                                int            inValue,
+                                unsigned long  inMicroseconds ) {
 
-    /* make sure folder exists */
-    
-    /* Check if the path exists and retrieve its stat */
-    if( stat( inFolderName, &statStruct ) == 0 ) {
-        /* use macro to check if it's a dir */
-        folderExists = S_ISDIR( statStruct.st_mode );
-        }
-    if( ! folderExists ) {
-        if( mkdir( inFolderName, 0755 ) == 0 ) {
-            folderExists = 1;
-            }
-        }
-    if( folderExists ) {
-        
-        char  *path  =  mn_linuxGetFilePath( inFolderName,
-                                             inFileName );
-        int    fd    =  open( path,
-                              O_CREAT | O_WRONLY | O_TRUNC, S_IRWXU );
+    int  jsStick  =  mn_evdevAbsToJSStick[ inCode ];
+    int  value;
 
-        return fd;
+    if( jsStick == -1 ) {
+        return;
         }
-    else {
-        return -1;
+
+    value = mn_correctEvdevAbs( inCode,
+                                inValue );
+    
+    if( mn_evdevAbsValue[ inCode ] == value ) {
+        /* movement within flat zone, or below our resolution */
+        return;
         }
+    
+    mn_evdevAbsValue[ inCode ] = value;
+
+    mn_queueInputEvent( MGN_INPUT_JS_STICK,
+                        jsStick,
+                        value,
+                        inMicroseconds );
     }
 
 
 
-static char mn_linuxFileWrite( int                   inFD,
-                               int                   inNumBytesToWrite,
-                               const unsigned char  *inByteBuffer ) {
+/* after kernel dropped events, queue whatever changed while we
+   weren't looking */
+static void mn_resyncGamepad( void ) {
     
-    int  numWritten  =  0;
+    unsigned long  t  =  mingin_getRunningMicroseconds();
+    int            code;
+
+    mn_readEvdevKeyBits( mn_gamepadFD,
+                         EVIOCGKEY( sizeof( mn_evdevKeyBits ) ) );
     
-    while( numWritten < inNumBytesToWrite ) {
-        size_t   numLeftToWrite      =  (size_t)( inNumBytesToWrite -
-                                                  numWritten );
-        ssize_t  numWrittenThisTime  =  write( inFD,
-                                               &( inByteBuffer[ numWritten ] ),
-                                               numLeftToWrite );
-        if( numWrittenThisTime == -1 ) {
-            return 0;
-            }
-        
-        numWritten += (int)numWrittenThisTime;
+    for( code = 0;
+         code < KEY_CNT;
+         code ++ ) {
+        mn_evdevKeyChanged( code,
+                            mn_testEvdevBit( mn_evdevKeyBits, code ),
+                            t );
         }
 
-    return 1;
-    }
-
-
-
-static int mn_linuxFileRead( int             inFD,
-                             int             inNumBytesToRead,
-                             unsigned char  *inByteBuffer ) {
-    int  numRead  =  0;
-    
-    while( numRead < inNumBytesToRead ) {
-        size_t   numLeftToRead    =  (size_t)( inNumBytesToRead - numRead );
+    for( code = 0;
+         code < ABS_CNT;
+         code ++ ) {
         
-        ssize_t  numReadThisTime  =  read( inFD,
-                                           &( inByteBuffer[numRead] ),
-                                           numLeftToRead );
+        struct input_absinfo  info;
 
-        if( numReadThisTime == 0 ) {
-            /* truly reached end of file */
-            return numRead;
-            }
-        else if( numReadThisTime == -1 ) {
-            /* error on read */
-            return -1;
+        if( mn_evdevAbsToJSStick[ code ] != -1
+            &&
+            ioctl( mn_gamepadFD, EVIOCGABS( (unsigned int)code ), &info ) >= 0 ) {
+            
+            mn_evdevAbsChanged( code,
+                                info.value,
+                                t );
             }
-        numRead += (int)numReadThisTime;
         }
-
-    return numRead;
     }
 
 
 
-static char mn_linuxFileSeek( int  inFD,
-                              int  inAbsoluteBytePosition ) {
+static void mn_openActiveGamepad( void ) {
+
+    int   fd;
+    char  name[ 128 ];
+    int   i;
+    int   d;
+    int   result;
 
-    off_t  offset  =  lseek( inFD,
-                             inAbsoluteBytePosition,
-                             SEEK_SET );
     
-    if( offset == (off_t)( -1 ) ) {
-        return 0;
-        }
-    return 1;
-    }
+    for( d = 0;
+         d < MINGIN_MAX_EVENT_DEVICES;
+         d ++ ) {
 
+        fd = open( mn_getEventPath( d ),
+                   O_RDONLY | O_NONBLOCK );
 
+        if( fd == -1 ) {
+            continue;
+            }
+        
+        /* opened an input device */
+        
+        /* init name buffer to avoid valgrind errors */
+        for( i = 0;
+             i < 128;
+             i ++ ) {
+            name[ i ] = '\0';
+            }
 
-static int mn_linuxFileGetPos( int  inFD ) {
-    
-    off_t  offset  =  lseek( inFD,
-                             0,
-                             SEEK_CUR );
-    
-    if( offset == (off_t)( -1 ) ) {
-        return -1;
-        }
-    return (int)offset;
-    }
+        /* does it match one of our strings? */
 
+        result = ioctl( fd,
+                        EVIOCGNAME( sizeof( name ) - 1 ),
+                        name );
 
+        if( result >= 0 ) {
+                
+            int gamepadIndex  =  mn_getGamepadIndex( name );
+
+            /* some gamepads also have motion sensor and touchpad
+               devices with names that start the same way, but only the
+               gamepad itself has gamepad buttons */
+            mn_readEvdevKeyBits( fd,
+                                 EVIOCGBIT( EV_KEY,
+                                            sizeof( mn_evdevKeyBits ) ) );
+            
+            if( gamepadIndex != -1
+                &&
+                ( mn_testEvdevBit( mn_evdevKeyBits, BTN_GAMEPAD )
+                  ||
+                  mn_testEvdevBit( mn_evdevKeyBits, BTN_JOYSTICK ) ) ) {
 
-int mingin_startWritePersistData( const char  *inStoreName ) {
-    return mn_linuxFileOpenWrite( mn_settingsDirName,
-                                  inStoreName );
-    }
+                mingin_log( "Active gamepad opened: " );
+                mingin_log( name );
+                mingin_log( "\n" );
 
+                mn_mapEvdevDevice( fd );
+                
+                mn_gamepadFD = fd;
 
+                mn_queueInputEvent( MGN_INPUT_GAMEPAD_CHANGE,
+                                    0,
+                                    gamepadIndex,
+                                    mingin_getRunningMicroseconds() );
+                return;
+                }
+            }
 
-int mingin_startReadPersistData( const char  *inStoreName,
-                                 int         *outTotalBytes ) {
-    return mn_linuxFileOpenRead( mn_settingsDirName,
-                                 inStoreName,
-                                 outTotalBytes );
-    }
+        /* not a match */
+        close( fd );
+        }
 
+    /* got through all of /dev/input/event devices without finding one */
 
+    mn_gamepadFD = -1;
 
-char mingin_writePersistData( int                   inStoreWriteHandle,
-                              int                   inNumBytesToWrite,
-                              const unsigned char  *inByteBuffer ) {
-    
-    return mn_linuxFileWrite( inStoreWriteHandle,
-                              inNumBytesToWrite,
-                              inByteBuffer );
+    mn_queueInputEvent( MGN_INPUT_GAMEPAD_CHANGE,
+                        0,
+                        MGN_NO_GAMEPAD,
+                        mingin_getRunningMicroseconds() );
     }
 
 
 
-int mingin_readPersistData( int             inStoreReadHandle,
-                            int             inNumBytesToRead,
-                            unsigned char  *inByteBuffer ) {
+static char mn_readGamepadEvents( void ) {
 
-    return mn_linuxFileRead( inStoreReadHandle,
-                             inNumBytesToRead,
-                             inByteBuffer );
-    }
+    struct input_event  events[ 64 ];
 
+    if( mn_gamepadFD == -1 ) {
+        return 0;
+        }
+    
+    while( 1 ) {
+        
+        ssize_t  numRead  =  read( mn_gamepadFD,
+                                   events,
+                                   sizeof( events ) );
+        int      numEvents;
+        int      i;
+        
+        if( numRead == -1 ) {
+            
+            if( errno == EAGAIN
+                ||
+                errno == EINTR
+                ||
+                errno == EWOULDBLOCK ) {
+                /* no event ready, we've read all available */
+                return 0;
+                }
 
+            /* error on reading... maybe gamepad unplugged */
+            close( mn_gamepadFD );
+            mn_gamepadFD = -1;
+                        
+            /* try to re-open, maybe switch gamepads */
+            mn_openActiveGamepad();
+            return 1;
+            }
 
-char mingin_seekPersistData( int  inStoreReadHandle,
-                             int  inAbsoluteBytePosition ) {
-    return mn_linuxFileSeek( inStoreReadHandle,
-                             inAbsoluteBytePosition );
-    }
+        numEvents = (int)( numRead / (ssize_t)sizeof( struct input_event ) );
 
+        if( numEvents == 0 ) {
+            return 0;
+            }
+        
+        for( i = 0;
+             i < numEvents;
+             i ++ ) {
 
+            struct input_event  *e  =  &( events[i] );
 
-int mingin_getPersistDataPosition( int  inStoreReadHandle ) {
-    return mn_linuxFileGetPos( inStoreReadHandle );
+            /* kernel stamps events with the same clock
+               as mingin_getRunningMicroseconds */
+            unsigned long  t  =
+                mn_getRunningMicrosecondsAt( (long)e->input_event_sec,
+                                             (long)e->input_event_usec );
+            
+            if( e->type == EV_SYN ) {
+                if( e->code == SYN_DROPPED ) {
+                    mn_evdevDropped = 1;
+                    }
+                else if( e->code == SYN_REPORT
+                         &&
+                         mn_evdevDropped ) {
+                    mn_evdevDropped = 0;
+                    mn_resyncGamepad();
+                    }
+                }
+            else if( mn_evdevDropped ) {
+                /* ignore partial state until next SYN_REPORT */
+                }
+            else if( e->type == EV_KEY
+                     &&
+                     e->code < KEY_CNT ) {
+                
+                mn_evdevKeyChanged( e->code,
+                                    (char)( e->value != 0 ),
+                                    t );
+                }
+            else if( e->type == EV_ABS
+                     &&
+                     e->code < ABS_CNT ) {
+                
+                mn_evdevAbsChanged( e->code,
+                                    e->value,
+                                    t );
+                }
+            }
+        }
     }
 
 
 
-void mingin_endWritePersistData( int  inStoreWriteHandle ) {
-    close( inStoreWriteHandle );
-    }
+static void mn_setupGamepadInput( void ) {
 
+    mn_gamepadNotifyFD = inotify_init1( IN_NONBLOCK );
 
+    if( mn_gamepadNotifyFD == -1 ) {
+        mingin_log( "Failed to start inotify, "
+                    "gamepads plugged in later won't be found.\n" );
+        }
+    /* udev creates device and then changes its permissions,
+       so we might not be able to open it until the second event */
+    else if( inotify_add_watch( mn_gamepadNotifyFD,
+                                "/dev/input",
+                                IN_CREATE | IN_ATTRIB ) == -1 ) {
+        
+        mingin_log( "Failed to watch /dev/input with inotify, "
+                    "gamepads plugged in later won't be found.\n" );
+        
+        close( mn_gamepadNotifyFD );
+        mn_gamepadNotifyFD = -1;
+        }
 
-void mingin_endReadPersistData( int  inStoreReadHandle ) {
-    close( inStoreReadHandle );
+    mn_openActiveGamepad();
     }
 
 
 
-void mingin_deletePersistData( const char  *inStoreName ) {
+static void mn_endGamepadInput( void ) {
     
-    char  *path  =  mn_linuxGetFilePath( mn_settingsDirName,
-                                         inStoreName );
+    if( mn_gamepadNotifyFD != -1 ) {
+        close( mn_gamepadNotifyFD );
+        mn_gamepadNotifyFD = -1;
+        }
     
-    unlink( path );
+    if( mn_gamepadFD != -1 ) {
+        close( mn_gamepadFD );
+        mn_gamepadFD = -1;
+        }
     }
 
 
 
-char mingin_renamePersistData( const char  *inStoreName,
-                               const char  *inStoreNewName ) {
-
-    char  *pathOld  =  mn_linuxGetFilePath( mn_settingsDirName, inStoreName );
-    char  *pathNew  =  mn_linuxGetFilePath( mn_settingsDirName, inStoreNewName );
+static void mn_readGamepadNotifications( void ) {
 
-    int    result   =  rename( pathOld, pathNew );
+    /* long for alignment of inotify_event structs */
+    static  long  buffer[ 256 ];
 
-    if( result == 0 ) {
-        return 1;
-        }
-    else {
-        return 0;
+    char  anyDevice  =  0;
+    
+    if( mn_gamepadNotifyFD == -1 ) {
+        return;
         }
-    }
-
-
-
-/* including \0 termination */
-#define  MINGIN_BULK_NAME_MAX_LENGTH  128
 
-typedef struct MinginBulkChangeRecord {
-        
-        char    bulkName[ MINGIN_BULK_NAME_MAX_LENGTH ];
-        
-        time_t  modTime;
+    while( 1 ) {
         
-    } MinginBulkChangeRecord;
-
+        int  pos      =  0;
+        int  numRead  =  (int)read( mn_gamepadNotifyFD,
+                                    buffer,
+                                    sizeof( buffer ) );
 
+        if( numRead <= 0 ) {
+            /* EAGAIN, no more events waiting */
+            break;
+            }
+        
+        while( pos + (int)sizeof( struct inotify_event ) <= numRead ) {
 
-static  MinginBulkChangeRecord  mn_bulkChangeRecords
-                                    [ MINGIN_MAX_NUM_BULK_CHANGE_RECORDS ];
+            const struct inotify_event  *e  =
+                (const struct inotify_event *)
+                    ( (const char *)buffer + pos );
 
-static  int                     mn_numBulkChangeRecords      =  0;
-static  time_t                  mn_latestBulkChangeModTime   =  0;
-static  char                    mn_bulkChangeOverflowLogged  =  0;
+            if( e->mask & IN_Q_OVERFLOW ) {
+                anyDevice = 1;
+                }
+            else if( e->len > 0
+                     &&
+                     mn_stringStartsWith( e->name, "event" ) ) {
+                anyDevice = 1;
+                }
 
+            pos += (int)( sizeof( struct inotify_event ) + e->len );
+            }
+        }
 
-/* note that in many circumstances, mn_latestBulkChangeModTime is sufficient
-   to track when any bulk data file changes, since a file will become
-   newer than the latest file when it is updated.
+    if( anyDevice
+        &&
+        mn_gamepadFD == -1 ) {
+        
+        mn_openActiveGamepad();
+        }
+    }
 
-   If we're only updating one file at a time, and the game client is
-   checking modified status fast enough to not miss any of these changes,
-   mn_latestBulkChangeModTime will not miss anything.
 
-   However, in cases where multiple files are being updated before
-   the game client checks for file modifications, some files might be missed.
+    
 
-   This is why keeping one record per file is ideal, if we can.  However,
-   we don't want to waste static memory space with a huge buffer of these
-   to cover all cases.
-*/
 
 
+static char *mn_linuxGetFilePath( const char  *inFolderName,
+                                  const char  *inFileName ) {
+    
+    enum{  MAX_PATH_LEN  =  255,
+           NUM_BUFFERS   =    2   };
 
-static void mn_logModTime( const char  *inBulkName ) {
+    static  int   curBuffer  = 0;
+    
+    static  char  buffer[ NUM_BUFFERS ][ MAX_PATH_LEN + 1 ];
 
-    int          i;
-    int          foundI     =  -1;
-    struct stat  fileStat;
-    const char  *path       =  mn_linuxGetFilePath( mn_bulkDataDirName,
-                                                    inBulkName );
+    
+    int  i  =  0;
+    int  j  =  0;
 
-    if( stat( path,
-              & fileStat ) != 0 ) {
+    
+    curBuffer ++;
 
-        mingin_log( "Failed to get mod time for bulk data file: " );
-        mingin_log( inBulkName );
-        mingin_log( "\n" );
-        
-        return;
+    if( curBuffer >= NUM_BUFFERS ) {
+        curBuffer = 0;
         }
-
-    
-    /* update our global latest mod time */
     
-    if( fileStat.st_mtime > mn_latestBulkChangeModTime ) {
-        mn_latestBulkChangeModTime = fileStat.st_mtime;
+    while( i < MAX_PATH_LEN
+           &&
+           inFolderName[i] != '\0' ) {
+        
+        buffer[curBuffer][i] = inFolderName[i];
+        i++;
         }
     
+    /* now separator */
+    if( i < MAX_PATH_LEN ) {
+        buffer[curBuffer][i] = '/';
+        i++;
+        }
     
-    for( i = 0;
-         i < mn_numBulkChangeRecords;
-         i ++ ) {
-
-        if( mn_stringsEqual(
-                inBulkName,
-                mn_bulkChangeRecords[ i ].bulkName ) ) {
+    while( i < MAX_PATH_LEN
+           &&
+           inFileName[j] != '\0' ) {
+        
+        buffer[curBuffer][i] = inFileName[j];
+        i++;
+        j++;
+        }
 
-            foundI = i;
-            break;
-            }
+    /* now terminate */
+    if( i < MAX_PATH_LEN ) {
+        buffer[curBuffer][i] = '\0';
         }
+    
+    return buffer[curBuffer];
+    }
 
-    if( foundI == -1 ) {
-        /* no existing record, try to make a new one */
+
+
+static int mn_linuxFileOpenRead( const char  *inFolderName,
+                                 const char  *inFileName,
+                                 int         *outTotalBytes ) {
+    struct stat   statStruct;
+    int           fd;
+    char         *path         =  mn_linuxGetFilePath( inFolderName,
+                                                       inFileName );
+
+    *outTotalBytes = 0;
+    
+    if( stat( path, &statStruct ) == 0 ) {
         
-        if( mn_numBulkChangeRecords == MINGIN_MAX_NUM_BULK_CHANGE_RECORDS ) {
-            /* no room for new record */
+        *outTotalBytes = (int)( statStruct.st_size );
+        }
+    else {
+        /* stat failed, file does not exist */
+        return -1;
+        }
+    
+    fd = open( path,
+               O_RDONLY );
 
-            if( ! mn_bulkChangeOverflowLogged ) {
-                /* only log once, to avoid flooding log with tons
-                   of messages if a game opens lots of bulk data files */
-                mingin_log( "Mingin:  Ran out of room in static "
-                            "bulkChangeRecord array, "
-                            "rapid-fire changes to bulk data files may result "
-                            "in some changes being missed.\n" );
-                
-                mn_bulkChangeOverflowLogged = 1;
-                }
-            
-            return;
-            }
+    return fd;
+    }
 
-        foundI = mn_numBulkChangeRecords;
 
-        mn_bulkChangeRecords[ foundI ].modTime = 0;
 
-        /* copy name into record */
-        i = 0;
-        while( i < MINGIN_BULK_NAME_MAX_LENGTH - 1
-               &&
-               inBulkName[i] != '\0' ) {
-            
-            mn_bulkChangeRecords[ foundI ].bulkName[i] = inBulkName[i];
-            i ++;
-            }
+static int mn_linuxFileOpenWrite( const char  *inFolderName,
+                                  const char  *inFileName ) {
+    struct stat  statStruct;
+    char         folderExists  =  0;
 
-        /* terminate */
-        mn_bulkChangeRecords[ foundI ].bulkName[i] = '\0';
-        
-        mn_numBulkChangeRecords ++;
+    /* make sure folder exists */
+    
+    /* Check if the path exists and retrieve its stat */
+    if( stat( inFolderName, &statStruct ) == 0 ) {
+        /* use macro to check if it's a dir */
+        folderExists = S_ISDIR( statStruct.st_mode );
+        }
+    if( ! folderExists ) {
+        if( mkdir( inFolderName, 0755 ) == 0 ) {
+            folderExists = 1;
+            }
         }
+    if( folderExists ) {
+        
+        char  *path  =  mn_linuxGetFilePath( inFolderName,
+                                             inFileName );
+        int    fd    =  open( path,
+                              O_CREAT | O_WRONLY | O_TRUNC, S_IRWXU );
 
-    if( foundI != -1 ) {
-        /* update found (or new) record with mod time */
-        mn_bulkChangeRecords[ foundI ].modTime = fileStat.st_mtime;
+        return fd;
+        }
+    else {
+        return -1;
         }
     }
 
 
 
-int mingin_startReadBulkData( const char  *inBulkName,
-                              int         *outTotalBytes ) {
+static char mn_linuxFileWrite( int                   inFD,
+                               int                   inNumBytesToWrite,
+                               const unsigned char  *inByteBuffer ) {
     
-    mn_logModTime( inBulkName );
+    int  numWritten  =  0;
     
-    return mn_linuxFileOpenRead( mn_bulkDataDirName,
-                                 inBulkName,
-                                 outTotalBytes );
+    while( numWritten < inNumBytesToWrite ) {
+        size_t   numLeftToWrite      =  (size_t)( inNumBytesToWrite -
+                                                  numWritten );
+        ssize_t  numWrittenThisTime  =  write( inFD,
+                                               &( inByteBuffer[ numWritten ] ),
+                                               numLeftToWrite );
+        if( numWrittenThisTime == -1 ) {
+            return 0;
+            }
+        
+        numWritten += (int)numWrittenThisTime;
+        }
+
+    return 1;
     }
 
 
 
-typedef struct MinginBulkReadBuffer {
-        
-        int             bulkDataHandle;
+/*
+  Bulk data can also come from a single pack file, made from the data
+  directory by util/makeAssetPack.c, so that a shipped game can load
+  everything with one open.
 
-        int             bufferSize;
+  Pack format, with all ints as 4-byte little-endian:
 
-        unsigned char  *buffer;
+      "MNPACK1" magic string, including \0
+      number of entries
+      number of table of contents bytes that follow
 
-        /* spot in the ring buffer where the next byte produced by the
-           producer will go */
-        int             producerPos;
+      table of contents:
+          one 16-byte entry per file, sorted by name:
+              name offset, from start of table of contents
+              data offset, from start of pack
+              data length
+              0, reserved
+          \0-terminated names
 
-        /* spot in the ring buffer where the next byte read by the consumer
-           will come from */
-        int             consumerPos;
+      file data, with each file starting on a 4096-byte boundary, so
+      that it can be memory-mapped in place
 
-        /* where the producer will read the next byte from in the bulk
-           data resource the next time it tries to read bytes */
-        int             nextProducerResourcePos;
+  Loose files in the data directory override files in the pack, so
+  they can still be edited and hot-reloaded.
+*/
+static  const char  *mn_bulkDataPackName  =  "data.pack";
 
-        /* when the consumer consumes the byte at consumerPos,
-           where did this byte come from in the bulk data resource? */
-        int             nextConsumerResourcePos;
+#define  MINGIN_PACK_HEADER_BYTES        16
+#define  MINGIN_PACK_ENTRY_BYTES         16
+#define  MINGIN_PACK_MAX_TOC_BYTES       131072
+#define  MINGIN_MAX_OPEN_PACK_ENTRIES    64
 
-        char            endOfFileReached;
-        
-    } MinginBulkReadBuffer;
+/* handles for files opened from the pack are far above any fd that
+   open will give us */
+#define  MN_PACK_HANDLE_BASE             0x40000000
 
 
+typedef struct MinginOpenPackEntry {
+        
+        char  used;
 
-#define  MINGIN_MAX_BULK_READ_BUFFERS  16
+        /* from start of pack */
+        int   dataOffset;
 
-static  MinginBulkReadBuffer  mn_bulkReadBuffers[ MINGIN_MAX_BULK_READ_BUFFERS ];
+        int   length;
 
-static  int                   mn_numBulkReadBuffers    =  0;
-static  char                  mn_bulkReadThreadLive    =  0;
-static  char                  mn_bulkReadMutexesLive   =  0;
-/* this mutex protects the bulk buffer data structure */
-static  pthread_mutex_t       mn_bulkBufferMutex;
-/* this mutext protects file operations on the underlying files */
-static  pthread_mutex_t       mn_bulkFileOpsMutex;
-static  pthread_cond_t        mn_bulkCanWriteCondition;
-static  pthread_t             mn_bulkReadThread;
+        /* read position, relative to dataOffset */
+        int   pos;
+        
+    } MinginOpenPackEntry;
 
 
+static  char                 mn_packChecked             =  0;
+static  int                  mn_packFD                  =  -1;
+static  int                  mn_packNumEntries          =  0;
+static  int                  mn_packTOCBytes            =  0;
+static  char                 mn_looseBulkDataDirExists  =  1;
+static  unsigned char        mn_packTOC[ MINGIN_PACK_MAX_TOC_BYTES ];
+static  MinginOpenPackEntry  mn_openPackEntries[ MINGIN_MAX_OPEN_PACK_ENTRIES ];
+/* protects open entries and the pack file position, since bulk read and
+   async read threads read from the pack too */
+static  pthread_mutex_t      mn_packMutex;
 
-static void mn_lockBulkBuffers( void ) {
-    
-    int  result;
 
-    if( ! mn_bulkReadMutexesLive ) {
-        return;
-        }
-    
-    result = pthread_mutex_lock( &mn_bulkBufferMutex );
 
-    if( result != 0 ) {
-        mingin_log( "Failed to lock bulk read mutex\n" );
-        }
+static int mn_decodePackInt( const unsigned char  *inBytes ) {
+    return (int)( (unsigned int)inBytes[0]
+                  | ( (unsigned int)inBytes[1] <<  8 )
+                  | ( (unsigned int)inBytes[2] << 16 )
+                  | ( (unsigned int)inBytes[3] << 24 ) );
     }
 
 
 
-static void mn_unlockBulkBuffers( void ) {
+/* compares like strcmp, which the pack tool sorts names with */
+static int mn_compareStrings( const char  *inStringA,
+                              const char  *inStringB ) {
     
-    int  result;
-
-    if( ! mn_bulkReadMutexesLive ) {
-        return;
+    int  i  =  0;
+    
+    while( inStringA[i] == inStringB[i]
+           &&
+           inStringA[i] != '\0' ) {
+        i++;
         }
 
-    result = pthread_mutex_unlock( &mn_bulkBufferMutex );
-
-    if( result != 0 ) {
-        mingin_log( "Failed to unlock bulk read mutex\n" );
-        }
+    return (int)(unsigned char)inStringA[i] - (int)(unsigned char)inStringB[i];
     }
 
 
 
-static void mn_lockBulkFileOps( void ) {
+/* opens pack and reads its table of contents the first time we're called */
+static void mn_loadBulkDataPack( void ) {
+
+    struct stat    statStruct;
+    unsigned char  header[ MINGIN_PACK_HEADER_BYTES ];
+    const char    *magic  =  "MNPACK1";
+    int            i;
     
-    int  result;
+    if( mn_packChecked ) {
+        return;
+        }
 
-    if( ! mn_bulkReadMutexesLive ) {
+    mn_packChecked = 1;
+
+    mn_looseBulkDataDirExists =
+        ( stat( mn_bulkDataDirName, &statStruct ) == 0
+          &&
+          S_ISDIR( statStruct.st_mode ) );
+    
+    mn_packFD = open( mn_bulkDataPackName,
+                      O_RDONLY );
+
+    if( mn_packFD == -1 ) {
+        /* no pack, only loose files */
+        mn_looseBulkDataDirExists = 1;
         return;
         }
 
-    result = pthread_mutex_lock( &mn_bulkFileOpsMutex );
+    if( read( mn_packFD,
+              header,
+              MINGIN_PACK_HEADER_BYTES ) != MINGIN_PACK_HEADER_BYTES ) {
+        
+        mingin_log( "Failed to read bulk data pack header\n" );
+        goto PACK_FAILURE;
+        }
 
-    if( result != 0 ) {
-        mingin_log( "Failed to lock bulk file operations mutex\n" );
+    for( i = 0;
+         i < 8;
+         i ++ ) {
+        
+        if( header[i] != (unsigned char)magic[i] ) {
+            mingin_log( "Bulk data pack has bad magic header\n" );
+            goto PACK_FAILURE;
+            }
         }
-    }
 
+    mn_packNumEntries = mn_decodePackInt( &( header[8] ) );
+    mn_packTOCBytes   = mn_decodePackInt( &( header[12] ) );
 
+    if( mn_packNumEntries < 0
+        ||
+        mn_packTOCBytes < mn_packNumEntries * MINGIN_PACK_ENTRY_BYTES
+        ||
+        mn_packTOCBytes > MINGIN_PACK_MAX_TOC_BYTES ) {
+        
+        mingin_log( "Bulk data pack table of contents doesn't fit\n" );
+        goto PACK_FAILURE;
+        }
 
-static void mn_unlockBulkFileOps( void ) {
-    
-    int  result;
+    if( read( mn_packFD,
+              mn_packTOC,
+              (size_t)mn_packTOCBytes ) != mn_packTOCBytes ) {
+        
+        mingin_log( "Failed to read bulk data pack table of contents\n" );
+        goto PACK_FAILURE;
+        }
 
-    if( ! mn_bulkReadMutexesLive ) {
-        return;
+    if( mn_packTOCBytes > 0
+        &&
+        mn_packTOC[ mn_packTOCBytes - 1 ] != '\0' ) {
+        mingin_log( "Bulk data pack has unterminated names\n" );
+        goto PACK_FAILURE;
         }
 
-    result = pthread_mutex_unlock( &mn_bulkFileOpsMutex );
+    if( pthread_mutex_init( &mn_packMutex, 0 ) != 0 ) {
+        mingin_log( "Failed to create bulk data pack mutex\n" );
+        goto PACK_FAILURE;
+        }
 
-    if( result != 0 ) {
-        mingin_log( "Failed to unlock bulk file operations mutex\n" );
+    for( i = 0;
+         i < MINGIN_MAX_OPEN_PACK_ENTRIES;
+         i ++ ) {
+        mn_openPackEntries[ i ].used = 0;
         }
+    
+    mingin_log( "Opened bulk data pack: " );
+    mingin_log( mn_bulkDataPackName );
+    mingin_log( "\n" );
+    
+    return;
+    
+    
+PACK_FAILURE:
+    close( mn_packFD );
+    mn_packFD                 = -1;
+    mn_packNumEntries         = 0;
+    mn_looseBulkDataDirExists = 1;
     }
 
 
 
-/* returns 0 if no buffer exists for this handle */
-static MinginBulkReadBuffer *mn_getBulkReadBuffer( int  inBulkDataHandle ) {
+/* returns index of pack entry, or -1 if not found */
+static int mn_findPackEntry( const char  *inBulkName ) {
 
-    int  i;
+    int  low;
+    int  high;
+
+    if( mn_packFD == -1 ) {
+        return -1;
+        }
     
-    for( i = 0;
-         i < mn_numBulkReadBuffers;
-         i ++ ) {
+    low  = 0;
+    high = mn_packNumEntries - 1;
 
-        if( mn_bulkReadBuffers[ i ].bulkDataHandle == inBulkDataHandle ) {
+    while( low <= high ) {
+        
+        int  mid         =  ( low + high ) / 2;
+        int  nameOffset  =  mn_decodePackInt(
+                                &( mn_packTOC[ mid
+                                               * MINGIN_PACK_ENTRY_BYTES ] ) );
+        int  c;
 
-            return &( mn_bulkReadBuffers[ i ] );
+        if( nameOffset < 0
+            ||
+            nameOffset >= mn_packTOCBytes ) {
+            return -1;
+            }
+
+        c = mn_compareStrings( inBulkName,
+                               (const char *)&( mn_packTOC[ nameOffset ] ) );
+
+        if( c == 0 ) {
+            return mid;
+            }
+        else if( c < 0 ) {
+            high = mid - 1;
+            }
+        else {
+            low = mid + 1;
             }
         }
-    
-    return 0;
+
+    return -1;
     }
 
 
+
 /*
-  must call mn_lockBulkBuffers() before calling
+  Opens a bulk data file, from the data directory if it's there,
+  or from the pack otherwise.
 
-  This call will unlock before returning.
+  Returns a file descriptor, or a pack handle, or -1 on failure.
+*/
+static int mn_openBulkFile( const char  *inBulkName,
+                            int         *outTotalBytes ) {
 
-  returns
-     1  if something read
-     0  if the buffer was full OR there was nothing left to read in file */
-static char mn_processBulkReadBuffer( MinginBulkReadBuffer *inBuffer ) {
+    int                   e;
+    int                   i;
+    const unsigned char  *entry;
+
+    mn_loadBulkDataPack();
+
+    if( mn_looseBulkDataDirExists ) {
+        
+        int  fd  =  mn_linuxFileOpenRead( mn_bulkDataDirName,
+                                          inBulkName,
+                                          outTotalBytes );
+        if( fd != -1 ) {
+            return fd;
+            }
+        }
+
+    e = mn_findPackEntry( inBulkName );
+
+    if( e == -1 ) {
+        return -1;
+        }
+
+    entry = &( mn_packTOC[ e * MINGIN_PACK_ENTRY_BYTES ] );
+
+    pthread_mutex_lock( &mn_packMutex );
     
-    enum{  BUFFER_SIZE             =  512 };
-    int    ourDesiredResourcePos;
-    int    maxNumReadBytes;
-    int    truePos;
-    int    numRead;
-    int    i;
-    int    p;
-    int    bulkDataHandle;
+    for( i = 0;
+         i < MINGIN_MAX_OPEN_PACK_ENTRIES;
+         i ++ ) {
+
+        MinginOpenPackEntry  *o  =  &( mn_openPackEntries[ i ] );
+        
+        if( ! o->used ) {
+            o->used       = 1;
+            o->dataOffset = mn_decodePackInt( &( entry[4] ) );
+            o->length     = mn_decodePackInt( &( entry[8] ) );
+            o->pos        = 0;
+
+            *outTotalBytes = o->length;
+            
+            pthread_mutex_unlock( &mn_packMutex );
+
+            return MN_PACK_HANDLE_BASE + i;
+            }
+        }
     
-    static  unsigned char  buffer[ BUFFER_SIZE ];
+    pthread_mutex_unlock( &mn_packMutex );
 
+    mingin_log( "Too many files open from bulk data pack\n" );
     
-    if( inBuffer->producerPos    ==  inBuffer->consumerPos - 1
-        ||
-        ( inBuffer->consumerPos  ==  0
-          &&
-          inBuffer->producerPos  ==  inBuffer->bufferSize - 1 ) ) {
+    return -1;
+    }
 
-        /* consumer is behind, producer is nipping at consumer's
-           heels, no room to read more */
-        mn_unlockBulkBuffers();
+
+
+static void mn_closeBulkFile( int  inHandle ) {
+
+    if( inHandle >= MN_PACK_HANDLE_BASE ) {
+        
+        pthread_mutex_lock( &mn_packMutex );
+        
+        mn_openPackEntries[ inHandle - MN_PACK_HANDLE_BASE ].used = 0;
+        
+        pthread_mutex_unlock( &mn_packMutex );
+        }
+    else {
+        close( inHandle );
+        }
+    }
+
+
+
+static int mn_packFileRead( int             inHandle,
+                            int             inNumBytesToRead,
+                            unsigned char  *inByteBuffer ) {
+
+    MinginOpenPackEntry  *o  =  &( mn_openPackEntries[ inHandle
+                                                       - MN_PACK_HANDLE_BASE ] );
+    int                   numRead  =  0;
+    int                   numLeft;
+
+    pthread_mutex_lock( &mn_packMutex );
+
+    numLeft = o->length - o->pos;
+
+    if( inNumBytesToRead > numLeft ) {
+        inNumBytesToRead = numLeft;
+        }
+
+    if( inNumBytesToRead > 0
+        &&
+        lseek( mn_packFD,
+               o->dataOffset + o->pos,
+               SEEK_SET ) == (off_t)( -1 ) ) {
+        
+        pthread_mutex_unlock( &mn_packMutex );
+        return -1;
+        }
+    
+    while( numRead < inNumBytesToRead ) {
+        
+        ssize_t  numReadThisTime  =
+                     read( mn_packFD,
+                           &( inByteBuffer[ numRead ] ),
+                           (size_t)( inNumBytesToRead - numRead ) );
+
+        if( numReadThisTime <= 0 ) {
+            /* pack shorter than its table of contents says */
+            pthread_mutex_unlock( &mn_packMutex );
+            return -1;
+            }
+        numRead += (int)numReadThisTime;
+        }
+
+    o->pos += numRead;
+
+    pthread_mutex_unlock( &mn_packMutex );
+
+    return numRead;
+    }
+
+
+
+static int mn_linuxFileRead( int             inFD,
+                             int             inNumBytesToRead,
+                             unsigned char  *inByteBuffer ) {
+    int  numRead  =  0;
+
+    if( inFD >= MN_PACK_HANDLE_BASE ) {
+        return mn_packFileRead( inFD,
+                                inNumBytesToRead,
+                                inByteBuffer );
+        }
+    
+    while( numRead < inNumBytesToRead ) {
+        size_t   numLeftToRead    =  (size_t)( inNumBytesToRead - numRead );
+        
+        ssize_t  numReadThisTime  =  read( inFD,
+                                           &( inByteBuffer[numRead] ),
+                                           numLeftToRead );
+
+        if( numReadThisTime == 0 ) {
+            /* truly reached end of file */
+            return numRead;
+            }
+        else if( numReadThisTime == -1 ) {
+            /* error on read */
+            return -1;
+            }
+        numRead += (int)numReadThisTime;
+        }
+
+    return numRead;
+    }
+
+
+
+static char mn_linuxFileSeek( int  inFD,
+                              int  inAbsoluteBytePosition ) {
+
+    off_t  offset;
+
+    if( inFD >= MN_PACK_HANDLE_BASE ) {
         
+        if( inAbsoluteBytePosition < 0 ) {
+            return 0;
+            }
+        
+        pthread_mutex_lock( &mn_packMutex );
+        
+        mn_openPackEntries[ inFD - MN_PACK_HANDLE_BASE ].pos =
+            inAbsoluteBytePosition;
+        
+        pthread_mutex_unlock( &mn_packMutex );
+        
+        return 1;
+        }
+    
+    offset = lseek( inFD,
+                    inAbsoluteBytePosition,
+                    SEEK_SET );
+    
+    if( offset == (off_t)( -1 ) ) {
         return 0;
         }
+    return 1;
+    }
 
-    ourDesiredResourcePos = inBuffer->nextProducerResourcePos;
 
-    if( inBuffer->producerPos < inBuffer->consumerPos ) {
-        maxNumReadBytes = inBuffer->consumerPos - inBuffer->producerPos - 1;
+
+static int mn_linuxFileGetPos( int  inFD ) {
+    
+    off_t  offset;
+
+    if( inFD >= MN_PACK_HANDLE_BASE ) {
+        
+        int  pos;
+        
+        pthread_mutex_lock( &mn_packMutex );
+        
+        pos = mn_openPackEntries[ inFD - MN_PACK_HANDLE_BASE ].pos;
+        
+        pthread_mutex_unlock( &mn_packMutex );
+        
+        return pos;
         }
-    else if( inBuffer->producerPos >= inBuffer->consumerPos ) {
-        /* include wrap-around in room left */
-        maxNumReadBytes = inBuffer->bufferSize - inBuffer->producerPos
-                          + inBuffer->consumerPos
-                          - 1;
+    
+    offset = lseek( inFD,
+                    0,
+                    SEEK_CUR );
+    
+    if( offset == (off_t)( -1 ) ) {
+        return -1;
         }
+    return (int)offset;
+    }
 
 
-    if( maxNumReadBytes > BUFFER_SIZE ) {
-        maxNumReadBytes = BUFFER_SIZE;
+
+typedef struct MinginPersistWriteBuffer {
+        char           live;
+        int            fd;
+        int            numBytes;
+        unsigned char  bytes[ MINGIN_LINUX_PERSIST_WRITE_BUFFER_BYTES ];
+    } MinginPersistWriteBuffer;
+
+
+static  MinginPersistWriteBuffer
+            mn_persistWriteBuffers[ MINGIN_LINUX_MAX_PERSIST_WRITE_BUFFERS ];
+
+/* protects which buffers are live, since a worker thread can be writing
+   to one store while the game opens or closes another
+   Each buffer's bytes are only touched by the thread using its store. */
+static  pthread_mutex_t  mn_persistWriteBuffersMutex  =
+                             PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/* returns 0 if inFD has no write buffer */
+static MinginPersistWriteBuffer *mn_getPersistWriteBuffer( int  inFD ) {
+    
+    int                        i;
+    MinginPersistWriteBuffer  *found  =  0;
+
+    pthread_mutex_lock( &mn_persistWriteBuffersMutex );
+    
+    for( i = 0;
+         i < MINGIN_LINUX_MAX_PERSIST_WRITE_BUFFERS;
+         i ++ ) {
+
+        if( mn_persistWriteBuffers[i].live
+            &&
+            mn_persistWriteBuffers[i].fd == inFD ) {
+            
+            found = &( mn_persistWriteBuffers[i] );
+            break;
+            }
         }
 
- 
-    bulkDataHandle = inBuffer->bulkDataHandle;
+    pthread_mutex_unlock( &mn_persistWriteBuffersMutex );
     
-    mn_unlockBulkBuffers();
+    return found;
+    }
 
 
-    mn_lockBulkFileOps();
+
+/* returns 1 on success, 0 on failure */
+static char mn_flushPersistWriteBuffer( MinginPersistWriteBuffer  *inBuffer ) {
+
+    char  success;
     
-    truePos = mn_linuxFileGetPos( bulkDataHandle );
+    if( inBuffer->numBytes == 0 ) {
+        return 1;
+        }
 
-    if( truePos == -1 ) {
-        mingin_log( "Failed to get position from buffered bulk resource.\n" );
-        mn_unlockBulkFileOps();
-        return 0;
+    success = mn_linuxFileWrite( inBuffer->fd,
+                                 inBuffer->numBytes,
+                                 inBuffer->bytes );
+
+    /* even on failure, we don't know how much made it out,
+       so drop what's buffered, like an unbuffered write would */
+    inBuffer->numBytes = 0;
+
+    return success;
+    }
+
+
+
+int mingin_startWritePersistData( const char  *inStoreName ) {
+    
+    int  fd  =  mn_linuxFileOpenWrite( mn_settingsDirName,
+                                       inStoreName );
+    int  i;
+
+    if( fd == -1 ) {
+        return -1;
         }
 
-    if( truePos != ourDesiredResourcePos ) {
-        /* need to seek */
+    pthread_mutex_lock( &mn_persistWriteBuffersMutex );
+    
+    for( i = 0;
+         i < MINGIN_LINUX_MAX_PERSIST_WRITE_BUFFERS;
+         i ++ ) {
 
-        if( ! mn_linuxFileSeek( bulkDataHandle,
-                                ourDesiredResourcePos ) ) {
+        MinginPersistWriteBuffer  *b  =  &( mn_persistWriteBuffers[i] );
+        
+        if( ! b->live ) {
+            b->live      =  1;
+            b->fd        =  fd;
+            b->numBytes  =  0;
+            break;
+            }
+        }
+
+    pthread_mutex_unlock( &mn_persistWriteBuffersMutex );
+    
+    return fd;
+    }
+
+
+
+int mingin_startReadPersistData( const char  *inStoreName,
+                                 int         *outTotalBytes ) {
+    return mn_linuxFileOpenRead( mn_settingsDirName,
+                                 inStoreName,
+                                 outTotalBytes );
+    }
+
+
+
+char mingin_writePersistData( int                   inStoreWriteHandle,
+                              int                   inNumBytesToWrite,
+                              const unsigned char  *inByteBuffer ) {
+
+    MinginPersistWriteBuffer  *b  =
+        mn_getPersistWriteBuffer( inStoreWriteHandle );
+    int                        i;
+    
+    if( b == 0 ) {
+        return mn_linuxFileWrite( inStoreWriteHandle,
+                                  inNumBytesToWrite,
+                                  inByteBuffer );
+        }
+
+    if( b->numBytes + inNumBytesToWrite >
+        MINGIN_LINUX_PERSIST_WRITE_BUFFER_BYTES ) {
+        
+        if( ! mn_flushPersistWriteBuffer( b ) ) {
+            return 0;
+            }
+        }
+
+    if( inNumBytesToWrite >= MINGIN_LINUX_PERSIST_WRITE_BUFFER_BYTES ) {
+        /* too big to be worth buffering */
+        return mn_linuxFileWrite( inStoreWriteHandle,
+                                  inNumBytesToWrite,
+                                  inByteBuffer );
+        }
+
+    for( i = 0;
+         i < inNumBytesToWrite;
+         i ++ ) {
+        
+        b->bytes[ b->numBytes ] = inByteBuffer[i];
+        b->numBytes ++;
+        }
+    
+    return 1;
+    }
+
+
+
+char mingin_flushPersistData( int  inStoreWriteHandle ) {
+
+    MinginPersistWriteBuffer  *b  =
+        mn_getPersistWriteBuffer( inStoreWriteHandle );
+
+    if( b == 0 ) {
+        /* unbuffered, nothing to flush */
+        return 1;
+        }
+    
+    return mn_flushPersistWriteBuffer( b );
+    }
+
+
+
+int mingin_readPersistData( int             inStoreReadHandle,
+                            int             inNumBytesToRead,
+                            unsigned char  *inByteBuffer ) {
+
+    return mn_linuxFileRead( inStoreReadHandle,
+                             inNumBytesToRead,
+                             inByteBuffer );
+    }
+
+
+
+char mingin_seekPersistData( int  inStoreReadHandle,
+                             int  inAbsoluteBytePosition ) {
+
+    /* in case we're seeking in a store that is being written */
+    if( ! mingin_flushPersistData( inStoreReadHandle ) ) {
+        return 0;
+        }
+    
+    return mn_linuxFileSeek( inStoreReadHandle,
+                             inAbsoluteBytePosition );
+    }
+
+
+
+int mingin_getPersistDataPosition( int  inStoreReadHandle ) {
+
+    int                        pos  =  mn_linuxFileGetPos( inStoreReadHandle );
+    MinginPersistWriteBuffer  *b    =
+        mn_getPersistWriteBuffer( inStoreReadHandle );
+
+    if( pos != -1
+        &&
+        b != 0 ) {
+        /* count what's buffered, but not written yet */
+        pos += b->numBytes;
+        }
+
+    return pos;
+    }
+
+
+
+char mingin_endWritePersistData( int  inStoreWriteHandle ) {
+    
+    MinginPersistWriteBuffer  *b        =
+        mn_getPersistWriteBuffer( inStoreWriteHandle );
+    char                       success  =  1;
+
+    if( b != 0 ) {
+        success = mn_flushPersistWriteBuffer( b );
+        
+        pthread_mutex_lock( &mn_persistWriteBuffersMutex );
+        b->live = 0;
+        pthread_mutex_unlock( &mn_persistWriteBuffersMutex );
+        }
+    
+    /* close can report a deferred write error too */
+    if( close( inStoreWriteHandle ) != 0 ) {
+        success = 0;
+        }
+
+    return success;
+    }
+
+
+
+void mingin_endReadPersistData( int  inStoreReadHandle ) {
+    close( inStoreReadHandle );
+    }
+
+
+
+void mingin_deletePersistData( const char  *inStoreName ) {
+    
+    char  *path  =  mn_linuxGetFilePath( mn_settingsDirName,
+                                         inStoreName );
+    
+    unlink( path );
+    }
+
+
+
+char mingin_renamePersistData( const char  *inStoreName,
+                               const char  *inStoreNewName ) {
+
+    char  *pathOld  =  mn_linuxGetFilePath( mn_settingsDirName, inStoreName );
+    char  *pathNew  =  mn_linuxGetFilePath( mn_settingsDirName, inStoreNewName );
+
+    int    result   =  rename( pathOld, pathNew );
+
+    if( result == 0 ) {
+        return 1;
+        }
+    else {
+        return 0;
+        }
+    }
+
+
+
+/* including \0 termination */
+#define  MINGIN_BULK_NAME_MAX_LENGTH  128
+
+typedef struct MinginBulkChangeRecord {
+        
+        char    bulkName[ MINGIN_BULK_NAME_MAX_LENGTH ];
+        
+        time_t  modTime;
+
+        /* set by inotify when file changes, cleared when opened for reading */
+        char    changed;
+
+        /* set by inotify when file changes, cleared when returned by
+           mingin_getNextChangedBulkData */
+        char    notifyPending;
+        
+    } MinginBulkChangeRecord;
+
+
+
+static  MinginBulkChangeRecord  mn_bulkChangeRecords
+                                    [ MINGIN_MAX_NUM_BULK_CHANGE_RECORDS ];
+
+static  int                     mn_numBulkChangeRecords      =  0;
+static  time_t                  mn_latestBulkChangeModTime   =  0;
+static  char                    mn_bulkChangeOverflowLogged  =  0;
+
+
+/* note that in many circumstances, mn_latestBulkChangeModTime is sufficient
+   to track when any bulk data file changes, since a file will become
+   newer than the latest file when it is updated.
+
+   If we're only updating one file at a time, and the game client is
+   checking modified status fast enough to not miss any of these changes,
+   mn_latestBulkChangeModTime will not miss anything.
+
+   However, in cases where multiple files are being updated before
+   the game client checks for file modifications, some files might be missed.
+
+   This is why keeping one record per file is ideal, if we can.  However,
+   we don't want to waste static memory space with a huge buffer of these
+   to cover all cases.
+*/
+
+
+
+static void mn_logModTime( const char  *inBulkName ) {
+
+    int          i;
+    int          foundI     =  -1;
+    struct stat  fileStat;
+    const char  *path       =  mn_linuxGetFilePath( mn_bulkDataDirName,
+                                                    inBulkName );
+
+    mn_loadBulkDataPack();
+
+    if( ! mn_looseBulkDataDirExists ) {
+        /* everything comes from pack, which never changes */
+        return;
+        }
+    
+    if( stat( path,
+              & fileStat ) != 0 ) {
+
+        if( mn_findPackEntry( inBulkName ) != -1 ) {
+            /* no loose file overriding pack */
+            return;
+            }
+        
+        mingin_log( "Failed to get mod time for bulk data file: " );
+        mingin_log( inBulkName );
+        mingin_log( "\n" );
+        
+        return;
+        }
+
+    
+    /* update our global latest mod time */
+    
+    if( fileStat.st_mtime > mn_latestBulkChangeModTime ) {
+        mn_latestBulkChangeModTime = fileStat.st_mtime;
+        }
+    
+    
+    for( i = 0;
+         i < mn_numBulkChangeRecords;
+         i ++ ) {
+
+        if( mn_stringsEqual(
+                inBulkName,
+                mn_bulkChangeRecords[ i ].bulkName ) ) {
+
+            foundI = i;
+            break;
+            }
+        }
+
+    if( foundI == -1 ) {
+        /* no existing record, try to make a new one */
+        
+        if( mn_numBulkChangeRecords == MINGIN_MAX_NUM_BULK_CHANGE_RECORDS ) {
+            /* no room for new record */
+
+            if( ! mn_bulkChangeOverflowLogged ) {
+                /* only log once, to avoid flooding log with tons
+                   of messages if a game opens lots of bulk data files */
+                mingin_log( "Mingin:  Ran out of room in static "
+                            "bulkChangeRecord array, "
+                            "rapid-fire changes to bulk data files may result "
+                            "in some changes being missed.\n" );
+                
+                mn_bulkChangeOverflowLogged = 1;
+                }
+            
+            return;
+            }
+
+        foundI = mn_numBulkChangeRecords;
+
+        mn_bulkChangeRecords[ foundI ].modTime       = 0;
+        mn_bulkChangeRecords[ foundI ].notifyPending = 0;
+
+        /* copy name into record */
+        i = 0;
+        while( i < MINGIN_BULK_NAME_MAX_LENGTH - 1
+               &&
+               inBulkName[i] != '\0' ) {
+            
+            mn_bulkChangeRecords[ foundI ].bulkName[i] = inBulkName[i];
+            i ++;
+            }
+
+        /* terminate */
+        mn_bulkChangeRecords[ foundI ].bulkName[i] = '\0';
+        
+        mn_numBulkChangeRecords ++;
+        }
+
+    if( foundI != -1 ) {
+        /* update found (or new) record with mod time */
+        mn_bulkChangeRecords[ foundI ].modTime = fileStat.st_mtime;
+        mn_bulkChangeRecords[ foundI ].changed = 0;
+        }
+    }
+
+
+
+/* inotify instance watching our bulk data directory, or -1 */
+static  int  mn_bulkNotifyFD          =  -1;
+
+/* number of records with notifyPending set */
+static  int  mn_numBulkNotifyPending  =   0;
+
+
+
+static void mn_setupBulkDataNotifications( void ) {
+
+    mn_bulkNotifyFD = inotify_init1( IN_NONBLOCK );
+
+    if( mn_bulkNotifyFD == -1 ) {
+        mingin_log( "Failed to start inotify, "
+                    "falling back to polling bulk data mod times.\n" );
+        return;
+        }
+
+    /* editors either write in place or write a new file and move it
+       into place, and touching a file changes its attributes */
+    if( inotify_add_watch( mn_bulkNotifyFD,
+                           mn_bulkDataDirName,
+                           IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB ) == -1 ) {
+        
+        mingin_log( "Failed to watch bulk data directory with inotify, "
+                    "falling back to polling bulk data mod times.\n" );
+        
+        close( mn_bulkNotifyFD );
+        mn_bulkNotifyFD = -1;
+        }
+    }
+
+
+
+static void mn_endBulkDataNotifications( void ) {
+    if( mn_bulkNotifyFD != -1 ) {
+        close( mn_bulkNotifyFD );
+        mn_bulkNotifyFD = -1;
+        }
+    }
+
+
+
+/* pass 0 to mark all records as changed */
+static void mn_markBulkDataChanged( const char  *inBulkName ) {
+
+    int  i;
+
+    for( i = 0;
+         i < mn_numBulkChangeRecords;
+         i ++ ) {
+
+        MinginBulkChangeRecord  *r  =  &( mn_bulkChangeRecords[ i ] );
+        
+        if( inBulkName == 0
+            ||
+            mn_stringsEqual( inBulkName,
+                             r->bulkName ) ) {
+
+            r->changed = 1;
+
+            if( ! r->notifyPending ) {
+                r->notifyPending = 1;
+                mn_numBulkNotifyPending ++;
+                }
+            }
+        }
+    }
+
+
+
+/* reads all waiting inotify events without blocking
+   called once per step, so when nothing changes, this costs us one read */
+static void mn_readBulkDataNotifications( void ) {
+
+    /* long for alignment of inotify_event structs */
+    static  long  buffer[ 1024 ];
+    
+    if( mn_bulkNotifyFD == -1 ) {
+        return;
+        }
+
+    while( 1 ) {
+        
+        int  pos      =  0;
+        int  numRead  =  (int)read( mn_bulkNotifyFD,
+                                    buffer,
+                                    sizeof( buffer ) );
+
+        if( numRead <= 0 ) {
+            /* EAGAIN, no more events waiting */
+            return;
+            }
+        
+        while( pos + (int)sizeof( struct inotify_event ) <= numRead ) {
+
+            const struct inotify_event  *e  =
+                (const struct inotify_event *)
+                    ( (const char *)buffer + pos );
+
+            if( e->mask & IN_Q_OVERFLOW ) {
+                /* lost track of which files changed */
+                mn_markBulkDataChanged( 0 );
+                }
+            else if( e->len > 0 ) {
+                mn_markBulkDataChanged( e->name );
+                }
+
+            pos += (int)( sizeof( struct inotify_event ) + e->len );
+            }
+        }
+    }
+
+
+
+char mingin_getBulkDataChangeNotificationsSupported( void ) {
+    /* if we've run out of records, we won't hear about some files */
+    return ( mn_bulkNotifyFD != -1
+             &&
+             ! mn_bulkChangeOverflowLogged );
+    }
+
+
+
+const char *mingin_getNextChangedBulkData( void ) {
+
+    int  i;
+    
+    if( mn_numBulkNotifyPending == 0 ) {
+        return 0;
+        }
+
+    for( i = 0;
+         i < mn_numBulkChangeRecords;
+         i ++ ) {
+
+        MinginBulkChangeRecord  *r  =  &( mn_bulkChangeRecords[ i ] );
+        
+        if( r->notifyPending ) {
+            r->notifyPending = 0;
+            mn_numBulkNotifyPending --;
+            
+            return r->bulkName;
+            }
+        }
+
+    mn_numBulkNotifyPending = 0;
+    
+    return 0;
+    }
+
+
+
+int mingin_startReadBulkData( const char  *inBulkName,
+                              int         *outTotalBytes ) {
+    
+    mn_logModTime( inBulkName );
+    
+    return mn_openBulkFile( inBulkName,
+                            outTotalBytes );
+    }
+
+
+
+const unsigned char *mingin_startMapBulkData( const char  *inBulkName,
+                                              int         *outTotalBytes ) {
+
+    int    fd;
+    int    mapFD;
+    int    offset;
+    int    pageOffset;
+    void  *data;
+    
+    mn_logModTime( inBulkName );
+
+    fd = mn_openBulkFile( inBulkName,
+                          outTotalBytes );
+
+    if( fd == -1 ) {
+        return 0;
+        }
+
+    if( *outTotalBytes <= 0
+        ||
+        fd < MN_PACK_HANDLE_BASE ) {
+        /* can't map empty file
+           and loose files can be edited and truncated while mapped,
+           which would SIGBUS when we touch the missing pages,
+           so only the pack, which we never write, is mapped */
+        mn_closeBulkFile( fd );
+        return 0;
+        }
+
+    /* map straight out of pack */
+    mapFD  = mn_packFD;
+    offset = mn_openPackEntries[ fd - MN_PACK_HANDLE_BASE ].dataOffset;
+
+    /* mappings must start on a page boundary
+       pack tool aligns data, but pages can be bigger than its alignment */
+    pageOffset = offset % (int)sysconf( _SC_PAGESIZE );
+    
+    data = mmap( NULL,
+                 (size_t)( *outTotalBytes + pageOffset ),
+                 PROT_READ,
+                 MAP_PRIVATE,
+                 mapFD,
+                 offset - pageOffset );
+
+    /* mapping stays valid after file is closed */
+    mn_closeBulkFile( fd );
+
+    if( data == MAP_FAILED ) {
+        return 0;
+        }
+
+    return (const unsigned char *)data + pageOffset;
+    }
+
+
+
+void mingin_endMapBulkData( const unsigned char  *inData,
+                            int                   inTotalBytes ) {
+
+    /* mapping itself starts at page boundary before inData */
+    unsigned long  pageSize    =  (unsigned long)sysconf( _SC_PAGESIZE );
+    unsigned long  pageOffset  =  (unsigned long)inData % pageSize;
+    
+    munmap( (void *)( inData - pageOffset ),
+            (size_t)inTotalBytes + pageOffset );
+    }
+
+
+
+typedef struct MinginBulkReadBuffer {
+        
+        int             bulkDataHandle;
+
+        int             bufferSize;
+
+        unsigned char  *buffer;
+
+        /* spot in the ring buffer where the next byte produced by the
+           producer will go */
+        int             producerPos;
+
+        /* spot in the ring buffer where the next byte read by the consumer
+           will come from */
+        int             consumerPos;
+
+        /* where the producer will read the next byte from in the bulk
+           data resource the next time it tries to read bytes */
+        int             nextProducerResourcePos;
+
+        /* when the consumer consumes the byte at consumerPos,
+           where did this byte come from in the bulk data resource? */
+        int             nextConsumerResourcePos;
+
+        char            endOfFileReached;
+        
+    } MinginBulkReadBuffer;
+
+
+
+#define  MINGIN_MAX_BULK_READ_BUFFERS  16
+
+static  MinginBulkReadBuffer  mn_bulkReadBuffers[ MINGIN_MAX_BULK_READ_BUFFERS ];
+
+static  int                   mn_numBulkReadBuffers    =  0;
+static  char                  mn_bulkReadThreadLive    =  0;
+static  char                  mn_bulkReadMutexesLive   =  0;
+/* this mutex protects the bulk buffer data structure */
+static  pthread_mutex_t       mn_bulkBufferMutex;
+/* this mutext protects file operations on the underlying files */
+static  pthread_mutex_t       mn_bulkFileOpsMutex;
+static  pthread_cond_t        mn_bulkCanWriteCondition;
+static  pthread_t             mn_bulkReadThread;
+
+
+
+static void mn_lockBulkBuffers( void ) {
+    
+    int  result;
+
+    if( ! mn_bulkReadMutexesLive ) {
+        return;
+        }
+    
+    result = pthread_mutex_lock( &mn_bulkBufferMutex );
+
+    if( result != 0 ) {
+        mingin_log( "Failed to lock bulk read mutex\n" );
+        }
+    }
+
+
+
+static void mn_unlockBulkBuffers( void ) {
+    
+    int  result;
+
+    if( ! mn_bulkReadMutexesLive ) {
+        return;
+        }
+
+    result = pthread_mutex_unlock( &mn_bulkBufferMutex );
+
+    if( result != 0 ) {
+        mingin_log( "Failed to unlock bulk read mutex\n" );
+        }
+    }
+
+
+
+static void mn_lockBulkFileOps( void ) {
+    
+    int  result;
+
+    if( ! mn_bulkReadMutexesLive ) {
+        return;
+        }
+
+    result = pthread_mutex_lock( &mn_bulkFileOpsMutex );
+
+    if( result != 0 ) {
+        mingin_log( "Failed to lock bulk file operations mutex\n" );
+        }
+    }
+
+
+
+static void mn_unlockBulkFileOps( void ) {
+    
+    int  result;
+
+    if( ! mn_bulkReadMutexesLive ) {
+        return;
+        }
+
+    result = pthread_mutex_unlock( &mn_bulkFileOpsMutex );
+
+    if( result != 0 ) {
+        mingin_log( "Failed to unlock bulk file operations mutex\n" );
+        }
+    }
+
+
+
+/* returns 0 if no buffer exists for this handle */
+static MinginBulkReadBuffer *mn_getBulkReadBuffer( int  inBulkDataHandle ) {
+
+    int  i;
+    
+    for( i = 0;
+         i < mn_numBulkReadBuffers;
+         i ++ ) {
+
+        if( mn_bulkReadBuffers[ i ].bulkDataHandle == inBulkDataHandle ) {
+
+            return &( mn_bulkReadBuffers[ i ] );
+            }
+        }
+    
+    return 0;
+    }
+
+
+
+/*
+  Copies bytes in blocks of 8, which compilers can turn into wide moves.
+*/
+static void mn_copyBytes( unsigned char        *outDest,
+                          const unsigned char  *inSource,
+                          int                   inNumBytes ) {
+    
+    int  i  =  0;
+    
+    while( i < inNumBytes - 7 ) {
+        outDest[ i     ] = inSource[ i     ];
+        outDest[ i + 1 ] = inSource[ i + 1 ];
+        outDest[ i + 2 ] = inSource[ i + 2 ];
+        outDest[ i + 3 ] = inSource[ i + 3 ];
+        outDest[ i + 4 ] = inSource[ i + 4 ];
+        outDest[ i + 5 ] = inSource[ i + 5 ];
+        outDest[ i + 6 ] = inSource[ i + 6 ];
+        outDest[ i + 7 ] = inSource[ i + 7 ];
+        i += 8;
+        }
+    
+    while( i < inNumBytes ) {
+        outDest[i] = inSource[i];
+        i++;
+        }
+    }
+
+
+
+/*
+  Copies bytes into a bulk read ring buffer at its producer position,
+  in at most two spans, one before the end of the ring and one after
+  wrapping around.
+
+  Caller must make sure there's room for inNumBytes.
+
+  Returns the producer position after the copied bytes.
+*/
+static int mn_copyIntoBulkReadRing( MinginBulkReadBuffer  *inBuffer,
+                                    const unsigned char   *inBytes,
+                                    int                    inNumBytes ) {
+
+    int  p          =  inBuffer->producerPos;
+    int  firstSpan  =  inBuffer->bufferSize - p;
+
+    if( firstSpan > inNumBytes ) {
+        firstSpan = inNumBytes;
+        }
+
+    mn_copyBytes( &( inBuffer->buffer[ p ] ),
+                  inBytes,
+                  firstSpan );
+
+    mn_copyBytes( inBuffer->buffer,
+                  &( inBytes[ firstSpan ] ),
+                  inNumBytes - firstSpan );
+
+    p += inNumBytes;
+
+    if( p >= inBuffer->bufferSize ) {
+        /* wrap around */
+        p -= inBuffer->bufferSize;
+        }
+    
+    return p;
+    }
+
+
+
+/*
+  Copies up to inNumBytes out of a bulk read ring buffer at its consumer
+  position, in at most two spans.
+
+  Returns the number of bytes copied, which is less than inNumBytes if
+  the ring doesn't have that many waiting.
+*/
+static int mn_copyOutOfBulkReadRing( MinginBulkReadBuffer  *inBuffer,
+                                     unsigned char         *outBytes,
+                                     int                    inNumBytes ) {
+
+    int  p           =  inBuffer->producerPos;
+    int  c           =  inBuffer->consumerPos;
+    int  numWaiting;
+    int  firstSpan;
+
+    if( p >= c ) {
+        numWaiting = p - c;
+        }
+    else {
+        /* producer has wrapped around */
+        numWaiting = inBuffer->bufferSize - c + p;
+        }
+
+    if( inNumBytes > numWaiting ) {
+        inNumBytes = numWaiting;
+        }
+    
+    firstSpan = inBuffer->bufferSize - c;
+
+    if( firstSpan > inNumBytes ) {
+        firstSpan = inNumBytes;
+        }
+
+    mn_copyBytes( outBytes,
+                  &( inBuffer->buffer[ c ] ),
+                  firstSpan );
+
+    mn_copyBytes( &( outBytes[ firstSpan ] ),
+                  inBuffer->buffer,
+                  inNumBytes - firstSpan );
+
+    c += inNumBytes;
+
+    if( c >= inBuffer->bufferSize ) {
+        /* wrap around */
+        c -= inBuffer->bufferSize;
+        }
+
+    inBuffer->consumerPos = c;
+    
+    return inNumBytes;
+    }
+
+
+/*
+  must call mn_lockBulkBuffers() before calling
+
+  This call will unlock before returning.
+
+  returns
+     1  if something read
+     0  if the buffer was full OR there was nothing left to read in file */
+static char mn_processBulkReadBuffer( MinginBulkReadBuffer *inBuffer ) {
+    
+    enum{  BUFFER_SIZE             =  512 };
+    int    ourDesiredResourcePos;
+    int    maxNumReadBytes;
+    int    truePos;
+    int    numRead;
+    int    bulkDataHandle;
+    
+    static  unsigned char  buffer[ BUFFER_SIZE ];
+
+    
+    if( inBuffer->producerPos    ==  inBuffer->consumerPos - 1
+        ||
+        ( inBuffer->consumerPos  ==  0
+          &&
+          inBuffer->producerPos  ==  inBuffer->bufferSize - 1 ) ) {
+
+        /* consumer is behind, producer is nipping at consumer's
+           heels, no room to read more */
+        mn_unlockBulkBuffers();
+        
+        return 0;
+        }
+
+    ourDesiredResourcePos = inBuffer->nextProducerResourcePos;
+
+    if( inBuffer->producerPos < inBuffer->consumerPos ) {
+        maxNumReadBytes = inBuffer->consumerPos - inBuffer->producerPos - 1;
+        }
+    else if( inBuffer->producerPos >= inBuffer->consumerPos ) {
+        /* include wrap-around in room left */
+        maxNumReadBytes = inBuffer->bufferSize - inBuffer->producerPos
+                          + inBuffer->consumerPos
+                          - 1;
+        }
+
+
+    if( maxNumReadBytes > BUFFER_SIZE ) {
+        maxNumReadBytes = BUFFER_SIZE;
+        }
+
+ 
+    bulkDataHandle = inBuffer->bulkDataHandle;
+    
+    mn_unlockBulkBuffers();
+
+
+    mn_lockBulkFileOps();
+    
+    truePos = mn_linuxFileGetPos( bulkDataHandle );
+
+    if( truePos == -1 ) {
+        mingin_log( "Failed to get position from buffered bulk resource.\n" );
+        mn_unlockBulkFileOps();
+        return 0;
+        }
+
+    if( truePos != ourDesiredResourcePos ) {
+        /* need to seek */
+
+        if( ! mn_linuxFileSeek( bulkDataHandle,
+                                ourDesiredResourcePos ) ) {
+
+            mingin_log( "Failed to seek in buffered bulk resource.\n" );
+            mn_unlockBulkFileOps();
+            return 0;
+            }
+        }
+
+    numRead = mn_linuxFileRead( bulkDataHandle,
+                                maxNumReadBytes,
+                                buffer );
+
+    if( numRead == -1 ) {
+        mingin_log( "Failed to read from buffered bulk resource.\n" );
+        mn_unlockBulkFileOps();
+        return 0;
+        }
+
+    
+    mn_unlockBulkFileOps();
+    
+
+    /* now copy into shared buffer */
+
+    mn_lockBulkBuffers();
+
+    /* re-get our buffer, since we had buffer structure unlocked for a bit */
+
+    inBuffer = mn_getBulkReadBuffer( bulkDataHandle );
+
+    if( inBuffer == 0 ) {
+        /* our buffer has been destroyed while we were unlocked */
+        mn_unlockBulkBuffers();
+        return 0;
+        }
+    
+    
+    if( inBuffer->nextProducerResourcePos != ourDesiredResourcePos ) {
+        /* file has been seeked out from under us while
+           we were reading...
+           do NOT put this into the buffer
+           just return, and deal with this next iteration */
+
+        mn_unlockBulkBuffers();
+        return 1;
+        }
+
+    if( numRead < maxNumReadBytes ) {
+        inBuffer->endOfFileReached = 1;
+        }
+
+    /* producer will never catch up to consumer pos,
+       because we limited our read size above to deal with this */
+    inBuffer->producerPos = mn_copyIntoBulkReadRing( inBuffer,
+                                                     buffer,
+                                                     numRead );
+
+    inBuffer->nextProducerResourcePos = ourDesiredResourcePos + numRead;
+
+    mn_unlockBulkBuffers();
+
+    if( numRead > 0 ) {
+        return 1;
+        }
+    else {
+        return 0;
+        }
+    }
+    
+
+
+static void *mn_bulkReadThreadFunction( void *inArg ) {
+
+    int    i;
+
+    /* suppress warning, arg not needed */
+    if( inArg == 0 ) {
+
+        }
+    
+    mn_lockBulkBuffers();
+
+    while( 1 ) {
+
+        char  anyProgress = 0;
+
+        /* we always have the lock when we head into next iteration of
+           this while loop */
+        
+        if( ! mn_bulkReadThreadLive ) {
+            
+            mn_unlockBulkBuffers();
+            
+            return 0;
+            }
+
+        for( i = 0;
+             i < mn_numBulkReadBuffers;
+             i ++ ) {
+
+            /* we must hold lock when calling */
+            anyProgress =
+                anyProgress
+                ||
+                mn_processBulkReadBuffer( &( mn_bulkReadBuffers[ i ] ) );
+            /* it unlocks when it returns */
+
+            /* re-lock before we check mn_numBulkReadBuffers limit again */
+            mn_lockBulkBuffers();
+            }
+
+        /* when we come out of the loop, we have the lock */
+        
+        if( ! anyProgress ) {
+            /* all buffers are full, waiting for consumer to read more */
+
+            /* sleep until some consumer signals us */
+
+            if( ! mn_bulkReadThreadLive ) {
+                /* but not if our thread has ended */
+                mn_unlockBulkBuffers();
+            
+                return 0;
+                }
+            
+            /* this sleeps until signal happens and then auto
+               re-aquires the mutex */
+            pthread_cond_wait( &mn_bulkCanWriteCondition,
+                               &mn_bulkBufferMutex );
+
+            /* when we wait up from wait, we have the mutex locked again
+               keep it locked as we head into next iteration of while loop */
+            }
+        }
+    }
+
+
+static void mn_setupBulkReadThread( void ) {
+
+    int  result;
+
+    
+    if( mn_bulkReadThreadLive ) {
+        return;
+        }
+
+    mn_bulkReadMutexesLive = 0;
+
+    if( pthread_mutex_init( &mn_bulkBufferMutex, 0 ) != 0 ) {
+        /* this should never happen, pthread_mutex_init always returns 0 */
+
+        mingin_log( "Failed to create bulk read mutex \n" );
+        return;
+        }
+
+    if( pthread_mutex_init( &mn_bulkFileOpsMutex, 0 ) != 0 ) {
+        /* this should never happen, pthread_mutex_init always returns 0 */
+
+        mingin_log( "Failed to create bulk file operations mutex \n" );
+
+        pthread_mutex_destroy( &mn_bulkBufferMutex );
+        
+        return;
+        }
+
+    if( pthread_cond_init( &mn_bulkCanWriteCondition, 0 ) != 0 ) {
+        mingin_log( "Failed to create bulk can write condition\n" );
+
+        pthread_mutex_destroy( &mn_bulkFileOpsMutex );
+        pthread_mutex_destroy( &mn_bulkBufferMutex );
+        
+        return;
+        }
+
+    mn_bulkReadMutexesLive = 1;
+    
+    mn_bulkReadThreadLive = 1;
+
+
+    result = pthread_create( & mn_bulkReadThread,
+                             0,
+                             & mn_bulkReadThreadFunction,
+                             0 );
+
+    
+    if( result != 0 ) {
+        mingin_log( "Failed to start bulk read thread.\n" );
+        mn_bulkReadThreadLive = 0;
+        mn_bulkReadMutexesLive = 0;
+
+        pthread_cond_destroy( &mn_bulkCanWriteCondition );
+        pthread_mutex_destroy( &mn_bulkFileOpsMutex );
+        pthread_mutex_destroy( &mn_bulkBufferMutex );
+        
+        return;
+        }
+
+    mingin_log( "Bulk data read thread started.\n" );
+    }
+
+
+
+static void mn_endBulkReadThread( void ) {
+    
+    void  *threadReturnVal;
+    int    result;
+    
+    if( ! mn_bulkReadThreadLive ) {
+        return;
+        }
+        
+    mn_lockBulkBuffers();
+    mn_bulkReadThreadLive = 0;
+
+    /* wake producer thread up if it's waiting */
+    pthread_cond_signal( &mn_bulkCanWriteCondition );
+    
+    mn_unlockBulkBuffers();
+
+    
+    result = pthread_join( mn_bulkReadThread, &threadReturnVal );
+
+    if( result != 0 ) {
+        mingin_log( "Failed to join bulk read thread at exit\n" );
+        }
+
+    mn_bulkReadMutexesLive = 0;
+    
+    result = pthread_cond_destroy( &mn_bulkCanWriteCondition );
+
+    if( result != 0 ) {
+        mingin_log( "Failed to destroy bulk can write condition at exit\n" );
+        }
+
+    
+    result = pthread_mutex_destroy( &mn_bulkFileOpsMutex );
+
+    if( result != 0 ) {
+        mingin_log( "Failed to destroy bulk file operations mutex at exit\n" );
+        }
+    
+
+    result = pthread_mutex_destroy( &mn_bulkBufferMutex );
+
+    if( result != 0 ) {
+        mingin_log( "Failed to destroy bulk read mutex at exit\n" );
+        }
+        
+    mingin_log( "Ended bulk read thread.\n" );
+    }
+
+
+
+void mingin_setBulkDataReadBuffer( int             inBulkDataHandle,
+                                   int             inBufferSize,
+                                   unsigned char  *inBuffer ) {
+
+    MinginBulkReadBuffer  *b;
+    int                    numRead;
+
+    mn_setupBulkReadThread();
+
+    mn_lockBulkBuffers();
+
+    if( ! mn_bulkReadThreadLive ) {
+        /* buffer thread system not up and running */
+        mn_unlockBulkBuffers();
+        return;
+        }
+
+    if( mn_numBulkReadBuffers >= MINGIN_MAX_BULK_READ_BUFFERS ) {
+        /* full */
+        mn_unlockBulkBuffers();
+        return;
+        }
+    
+    if( mn_getBulkReadBuffer( inBulkDataHandle ) != 0 ) {
+        /* exists already */
+        mn_unlockBulkBuffers();
+        return;
+        }
+
+    b = &( mn_bulkReadBuffers[ mn_numBulkReadBuffers ] );
+
+    b->bulkDataHandle = inBulkDataHandle;
+
+    b->bufferSize = inBufferSize;
+
+    b->buffer = inBuffer;
+
+    b->producerPos = 0;
+    b->consumerPos = 0;
+
+    b->nextConsumerResourcePos = mn_linuxFileGetPos( inBulkDataHandle );
+
+    if( b->nextConsumerResourcePos == -1 ) {
+        /* failed to get pos */
+        mn_unlockBulkBuffers();
+        return;
+        }
+    
+    /* pre-fill buffer */
+    numRead = mn_linuxFileRead( inBulkDataHandle,
+                                inBufferSize - 1,
+                                inBuffer );
+
+    if( numRead == -1 ) {
+        mn_unlockBulkBuffers();
+        return;
+        }
+
+    b->producerPos += numRead;
+    
+    b->nextProducerResourcePos = mn_linuxFileGetPos( inBulkDataHandle );
+    
+    if( b->nextProducerResourcePos == -1 ) {
+        /* failed to get pos */
+        mn_unlockBulkBuffers();
+        return;
+        }
+    
+    b->endOfFileReached = 0;
+
+    if( numRead != inBufferSize - 1 ) {
+        
+        /* got to end of file on first read */
+        b->endOfFileReached = 1;
+        }
+    
+    mn_numBulkReadBuffers ++;
+
+    mn_unlockBulkBuffers();
+    }
+
+
+
+static void mn_removeBulkDataReadBuffer( int  inBulkDataHandle ) {
+
+    int  i;
+
+    mn_lockBulkBuffers();
+    
+    for( i = 0;
+         i < mn_numBulkReadBuffers;
+         i ++ ) {
+
+        if( mn_bulkReadBuffers[ i ].bulkDataHandle == inBulkDataHandle ) {
+
+            /* found */
+
+            /* swap last into this spot and shrink */
+            
+            if( i != mn_numBulkReadBuffers - 1 ) {
+                
+                mn_bulkReadBuffers[ i ] =
+                    mn_bulkReadBuffers[ mn_numBulkReadBuffers - 1 ];
+                }
+
+            mn_unlockBulkBuffers();
+            
+            mn_numBulkReadBuffers --;
+            return;
+            }
+        }
+
+    /* not found */
+    mn_unlockBulkBuffers();
+    }
+
+
+
+/* must call mn_lockBulkBuffers before calling
+   unlocks before returning */
+static int mn_bufferedBulkRead( int             inBulkDataHandle,
+                                int             inNumBytesToRead,
+                                unsigned char  *inByteBuffer ) {
+    
+    MinginBulkReadBuffer  *buffer;
+    int                    b;
+    
+    buffer = mn_getBulkReadBuffer( inBulkDataHandle );
+
+    if( buffer == 0 ) {
+        mn_unlockBulkBuffers();
+        return -1;
+        }
+
+    b = mn_copyOutOfBulkReadRing( buffer,
+                                  inByteBuffer,
+                                  inNumBytesToRead );
+    buffer->nextConsumerResourcePos += b;
+    
+    if( b < inNumBytesToRead
+        &&
+        ! buffer->endOfFileReached ) {
+        
+        /* we read everything in ring buffer, and we still need more
+           in this case, read from the actual underlying file
+           keep lock while we do this, so that i/o thread doesn't
+           try to read while we're in here */
+
+        int  numExtra  = inNumBytesToRead - b;
+
+        int  numRead;
+        int  truePos;
+        
+        mn_lockBulkFileOps();
+
+        truePos = mn_linuxFileGetPos( inBulkDataHandle );
+
+        if( truePos == -1 ) {
+            mn_unlockBulkFileOps();
+            mn_unlockBulkBuffers();
+            return -1;
+            }
+        if( truePos != buffer->nextConsumerResourcePos ) {
+            /* io thread did some file reading that's not in the buffer
+               yet, and changed the file position
+
+               seek to where we actually want to be */
+            
+            if( ! mn_linuxFileSeek( inBulkDataHandle,
+                                    buffer->nextConsumerResourcePos ) ) {
+                mn_unlockBulkFileOps();
+                mn_unlockBulkBuffers();
+                return -1;
+                }
+            }
+        
+        numRead = mn_linuxFileRead( inBulkDataHandle,
+                                    numExtra,
+                                    &( inByteBuffer[ b ] ) );
+        mn_unlockBulkFileOps();
+        
+        if( numRead == -1 ) {
+            mn_unlockBulkBuffers();
+
+            return -1;
+            }
+        b += numRead;
+
+        /* keep track of where our consumer is at in the file now */
+        buffer->nextConsumerResourcePos += numRead;
+
+        /* tell io thread that it needs to read from a different
+           spot in the file next time */
+        buffer->nextProducerResourcePos = buffer->nextConsumerResourcePos;
+        }
+
+    if( b > 0
+        &&
+        ! buffer->endOfFileReached ){
+        /* tell producer that there's room to write more in the buffer
+           we must hold the lock while doing this */
+
+        /* note that we do NOT do this if producer has reached the
+           end of the file, since that will wake them up to do
+           nothing */
+        
+        pthread_cond_signal( & mn_bulkCanWriteCondition );
+        }
+
+    mn_unlockBulkBuffers();
+
+    return b;
+    }
+
+
+/* must call mn_lockBulkBuffers before calling
+   unlocks before returning */
+static char mn_bufferedBulkSeek( int  inBulkDataHandle,
+                                 int  inAbsoluteBytePosition ) {
+
+    MinginBulkReadBuffer  *buffer;
+
+    buffer = mn_getBulkReadBuffer( inBulkDataHandle );
+
+    if( buffer == 0 ) {
+        mn_unlockBulkBuffers();
+        return 0;
+        }
+
+    if( buffer->nextConsumerResourcePos == inAbsoluteBytePosition ) {
+        /* already there */
+        mn_unlockBulkBuffers();
+        return 1;
+        }
+    /* an actual seek
+       in this case, reset all the positions in the buffer,
+       starting over with an empty buffer */
+
+    buffer->producerPos = 0;
+    buffer->consumerPos = 0;
+
+    /* producer will seek here before its next read */
+    buffer->nextProducerResourcePos = inAbsoluteBytePosition;
+    buffer->nextConsumerResourcePos = inAbsoluteBytePosition;
+    buffer->endOfFileReached = 0;
+
+    /* tell producer that there's room to write more in the buffer
+       since all positions reset
+       we must hold the lock while doing this */
+    pthread_cond_signal( & mn_bulkCanWriteCondition );
+
+    mn_unlockBulkBuffers();
+        
+    return 1;
+    }
+
+
+
+/* must call mn_lockBulkBuffers before calling
+   unlocks before returning */
+static int mn_bufferedBulkTell( int  inBulkDataHandle ) {
+
+    int                    pos;
+    MinginBulkReadBuffer  *buffer;
+    
+    buffer = mn_getBulkReadBuffer( inBulkDataHandle );
+
+    if( buffer == 0 ) {
+        mn_unlockBulkBuffers();
+        return -1;
+        }
+
+    pos = buffer->nextConsumerResourcePos;
+
+    mn_unlockBulkBuffers();
+
+    return pos;
+    }
+
+
+
+int mingin_readBulkData( int             inBulkDataHandle,
+                         int             inNumBytesToRead,
+                         unsigned char  *inByteBuffer ) {
+    
+    /* call first without locking
+       if there are some buffered bulk resources,
+       we don't want to slow down ALL reads for non-buffered
+       resources with locking on every read */
+    
+    if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+
+        /* we know it existed, but it might not exist still
+           lock and try again */
+
+        mn_lockBulkBuffers();
+
+        if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+
+            /* this will unlock before returning */
+            return mn_bufferedBulkRead( inBulkDataHandle,
+                                        inNumBytesToRead,
+                                        inByteBuffer );
+            }
+        else {
+            mn_unlockBulkBuffers();
+            }
+        }
+
+    /* if we fell through without returning, we didn't read a
+       buffered resource */
+    
+    return mn_linuxFileRead( inBulkDataHandle,
+                             inNumBytesToRead,
+                             inByteBuffer );
+    }
+
+
+
+char mingin_seekBulkData( int  inBulkDataHandle,
+                          int  inAbsoluteBytePosition ) {
+
+    /* see comments inside
+           mingin_readBulkData
+       for explanation of why we do things in this order */
+    
+    if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+        
+        mn_lockBulkBuffers();
+
+        if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+            
+            return mn_bufferedBulkSeek( inBulkDataHandle,
+                                        inAbsoluteBytePosition );
+            }
+        else {
+            mn_unlockBulkBuffers();
+            }
+        }
+
+    return mn_linuxFileSeek( inBulkDataHandle,
+                             inAbsoluteBytePosition );
+    }
+
+
+
+int mingin_getBulkDataPosition( int  inBulkDataHandle ) {
+
+    /* see comments inside
+           mingin_readBulkData
+       for explanation of why we do things in this order */
+
+    if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+        
+        mn_lockBulkBuffers();
+
+        if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+            
+            return mn_bufferedBulkTell( inBulkDataHandle );
+            }
+        else {
+            mn_unlockBulkBuffers();
+            }
+        }
+    
+    return mn_linuxFileGetPos( inBulkDataHandle );
+    }
+
+
+
+void mingin_endReadBulkData( int  inBulkDataHandle ) {
+
+    if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
 
-            mingin_log( "Failed to seek in buffered bulk resource.\n" );
-            mn_unlockBulkFileOps();
-            return 0;
-            }
+        /* this is safe to do without locks around
+           checking for existence, since the remove
+           code locks and will just not find the buffer if it's
+           already been removed */
+        
+        mn_removeBulkDataReadBuffer( inBulkDataHandle );
         }
+    
+    mn_closeBulkFile( inBulkDataHandle );
+    }
 
-    numRead = mn_linuxFileRead( bulkDataHandle,
-                                maxNumReadBytes,
-                                buffer );
 
-    if( numRead == -1 ) {
-        mingin_log( "Failed to read from buffered bulk resource.\n" );
-        mn_unlockBulkFileOps();
-        return 0;
-        }
 
-    
-    mn_unlockBulkFileOps();
-    
+char mingin_getBulkDataChanged( const char  *inBulkName ) {
 
-    /* now copy into shared buffer */
+    int          i;
+    struct stat  fileStat;
+    const char  *path;
 
-    mn_lockBulkBuffers();
+    if( mn_bulkNotifyFD != -1 ) {
+        /* inotify tells us about changes, no need to stat */
+        for( i = 0;
+             i < mn_numBulkChangeRecords;
+             i ++ ) {
 
-    /* re-get our buffer, since we had buffer structure unlocked for a bit */
+            if( mn_stringsEqual(
+                    inBulkName,
+                    mn_bulkChangeRecords[ i ].bulkName ) ) {
 
-    inBuffer = mn_getBulkReadBuffer( bulkDataHandle );
+                return mn_bulkChangeRecords[ i ].changed;
+                }
+            }
+        /* no record, fall back to checking mod time */
+        }
 
-    if( inBuffer == 0 ) {
-        /* our buffer has been destroyed while we were unlocked */
-        mn_unlockBulkBuffers();
+    mn_loadBulkDataPack();
+    
+    if( ! mn_looseBulkDataDirExists ) {
+        /* everything comes from pack, which never changes */
         return 0;
         }
     
+    path = mn_linuxGetFilePath( mn_bulkDataDirName,
+                                inBulkName );
     
-    if( inBuffer->nextProducerResourcePos != ourDesiredResourcePos ) {
-        /* file has been seeked out from under us while
-           we were reading...
-           do NOT put this into the buffer
-           just return, and deal with this next iteration */
+    if( stat( path,
+              & fileStat ) != 0 ) {
 
-        mn_unlockBulkBuffers();
-        return 1;
-        }
+        if( mn_findPackEntry( inBulkName ) != -1 ) {
+            /* no loose file overriding pack */
+            return 0;
+            }
 
-    if( numRead < maxNumReadBytes ) {
-        inBuffer->endOfFileReached = 1;
+        mingin_log( "Failed to get mod time for bulk data file: " );
+        mingin_log( inBulkName );
+        mingin_log( "\n" );
+        
+        return 0;
         }
 
-    /* p will never catch up to consumer pos,
-       because we limited our read size above to deal with this */
-    p = inBuffer->producerPos;
+    if( fileStat.st_mtime > mn_latestBulkChangeModTime ) {
+        /* file is newer than our most recent global mod time
+           it definitely changed */
+
+        /* don't update our mod time until game client calls
+               mingin_startReadBulkData
+           since we're tracking whether data has changed since it was last
+           opened for reading
+        */
+        return 1;
+        }
     
+    
+
     for( i = 0;
-         i < numRead;
+         i < mn_numBulkChangeRecords;
          i ++ ) {
 
-        inBuffer->buffer[ p ] = buffer[ i ];
-
-        p ++;
+        if( mn_stringsEqual(
+                inBulkName,
+                mn_bulkChangeRecords[ i ].bulkName ) ) {
 
-        /* wrap around */
-        if( p >= inBuffer->bufferSize ) {
-            p = 0;
+            /* found a match */
+            if( fileStat.st_mtime > mn_bulkChangeRecords[ i ].modTime ) {
+                /* newer than our record */
+                return 1;
+                }
             }
         }
 
-    inBuffer->producerPos = p;
+    /* not newer than our record, or no record found.
+       if no record found, that means either file hasn't been openend
+       for reading before, or we have a mn_bulkChangeRecords overflow
+       and can't track this file.
+       In that case, we count the file as changed only if it's mod
+       time is greater than our mn_latestBulkChangeModTime global mod tim.
+    */
+    return 0;
+    }
 
-    inBuffer->nextProducerResourcePos = ourDesiredResourcePos + numRead;
 
-    mn_unlockBulkBuffers();
 
-    if( numRead > 0 ) {
-        return 1;
-        }
-    else {
-        return 0;
-        }
-    }
-    
+/* only touched by the thread that starts and ends the worker,
+   stays set until the worker has been joined */
+static  char              mn_workerThreadLive      =  0;
+/* set when the mutexes and conditions below exist, cleared only after
+   they are destroyed, so the worker can lock and unlock right up until
+   it is joined */
+static  char              mn_workerSyncMade        =  0;
+/* set when the worker has been woken, cleared when it starts the work */
+static  char              mn_workerWorkWaiting     =  0;
+static  char              mn_workerBusy            =  0;
+/* set when the worker should return once it runs out of work */
+static  char              mn_workerEnding          =  0;
+static  void            (*mn_workerFunction)( void );
+/* this mutex protects the three flags above */
+static  pthread_mutex_t   mn_workerStateMutex;
+/* this mutex is the one that mingin_lockWorker locks */
+static  pthread_mutex_t   mn_workerSharedDataMutex;
+static  pthread_cond_t    mn_workerWakeCondition;
+static  pthread_cond_t    mn_workerIdleCondition;
+static  pthread_t         mn_workerThread;
 
 
-static void *mn_bulkReadThreadFunction( void *inArg ) {
 
-    int    i;
+static void *mn_workerThreadFunction( void *inArg ) {
 
     /* suppress warning, arg not needed */
     if( inArg == 0 ) {
 
         }
     
-    mn_lockBulkBuffers();
+    pthread_mutex_lock( &mn_workerStateMutex );
 
     while( 1 ) {
 
-        char  anyProgress = 0;
-
         /* we always have the lock when we head into next iteration of
            this while loop */
         
-        if( ! mn_bulkReadThreadLive ) {
-            
-            mn_unlockBulkBuffers();
+        while( ! mn_workerWorkWaiting
+               &&
+               ! mn_workerEnding ) {
             
-            return 0;
+            pthread_cond_wait( &mn_workerWakeCondition,
+                               &mn_workerStateMutex );
             }
 
-        for( i = 0;
-             i < mn_numBulkReadBuffers;
-             i ++ ) {
-
-            /* we must hold lock when calling */
-            anyProgress =
-                anyProgress
-                ||
-                mn_processBulkReadBuffer( &( mn_bulkReadBuffers[ i ] ) );
-            /* it unlocks when it returns */
-
-            /* re-lock before we check mn_numBulkReadBuffers limit again */
-            mn_lockBulkBuffers();
+        if( ! mn_workerWorkWaiting ) {
+            /* ended, and no more work to do */
+            pthread_mutex_unlock( &mn_workerStateMutex );
+            
+            return 0;
             }
 
-        /* when we come out of the loop, we have the lock */
+        mn_workerWorkWaiting = 0;
+        mn_workerBusy = 1;
         
-        if( ! anyProgress ) {
-            /* all buffers are full, waiting for consumer to read more */
+        pthread_mutex_unlock( &mn_workerStateMutex );
 
-            /* sleep until some consumer signals us */
+        mn_workerFunction();
 
-            if( ! mn_bulkReadThreadLive ) {
-                /* but not if our thread has ended */
-                mn_unlockBulkBuffers();
-            
-                return 0;
-                }
-            
-            /* this sleeps until signal happens and then auto
-               re-aquires the mutex */
-            pthread_cond_wait( &mn_bulkCanWriteCondition,
-                               &mn_bulkBufferMutex );
+        pthread_mutex_lock( &mn_workerStateMutex );
 
-            /* when we wait up from wait, we have the mutex locked again
-               keep it locked as we head into next iteration of while loop */
+        mn_workerBusy = 0;
+
+        if( ! mn_workerWorkWaiting ) {
+            pthread_cond_broadcast( &mn_workerIdleCondition );
             }
         }
     }
 
 
-static void mn_setupBulkReadThread( void ) {
-
-    int  result;
 
+char mingin_startWorkerThread( void  (*inWorkFunction)( void ) ) {
     
-    if( mn_bulkReadThreadLive ) {
-        return;
+    if( mn_workerThreadLive ) {
+        return 0;
         }
 
-    mn_bulkReadMutexesLive = 0;
-
-    if( pthread_mutex_init( &mn_bulkBufferMutex, 0 ) != 0 ) {
-        /* this should never happen, pthread_mutex_init always returns 0 */
-
-        mingin_log( "Failed to create bulk read mutex \n" );
-        return;
+    if( pthread_mutex_init( &mn_workerStateMutex, 0 ) != 0 ) {
+        mingin_log( "Failed to create worker state mutex\n" );
+        return 0;
         }
 
-    if( pthread_mutex_init( &mn_bulkFileOpsMutex, 0 ) != 0 ) {
-        /* this should never happen, pthread_mutex_init always returns 0 */
-
-        mingin_log( "Failed to create bulk file operations mutex \n" );
+    if( pthread_mutex_init( &mn_workerSharedDataMutex, 0 ) != 0 ) {
+        mingin_log( "Failed to create worker shared data mutex\n" );
 
-        pthread_mutex_destroy( &mn_bulkBufferMutex );
-        
-        return;
+        pthread_mutex_destroy( &mn_workerStateMutex );
+        return 0;
         }
 
-    if( pthread_cond_init( &mn_bulkCanWriteCondition, 0 ) != 0 ) {
-        mingin_log( "Failed to create bulk can write condition\n" );
+    if( pthread_cond_init( &mn_workerWakeCondition, 0 ) != 0 ) {
+        mingin_log( "Failed to create worker wake condition\n" );
 
-        pthread_mutex_destroy( &mn_bulkFileOpsMutex );
-        pthread_mutex_destroy( &mn_bulkBufferMutex );
-        
-        return;
+        pthread_mutex_destroy( &mn_workerSharedDataMutex );
+        pthread_mutex_destroy( &mn_workerStateMutex );
+        return 0;
         }
 
-    mn_bulkReadMutexesLive = 1;
-    
-    mn_bulkReadThreadLive = 1;
-
+    if( pthread_cond_init( &mn_workerIdleCondition, 0 ) != 0 ) {
+        mingin_log( "Failed to create worker idle condition\n" );
 
-    result = pthread_create( & mn_bulkReadThread,
-                             0,
-                             & mn_bulkReadThreadFunction,
-                             0 );
+        pthread_cond_destroy( &mn_workerWakeCondition );
+        pthread_mutex_destroy( &mn_workerSharedDataMutex );
+        pthread_mutex_destroy( &mn_workerStateMutex );
+        return 0;
+        }
 
-    
-    if( result != 0 ) {
-        mingin_log( "Failed to start bulk read thread.\n" );
-        mn_bulkReadThreadLive = 0;
-        mn_bulkReadMutexesLive = 0;
+    mn_workerFunction     =  inWorkFunction;
+    mn_workerWorkWaiting  =  0;
+    mn_workerBusy         =  0;
+    mn_workerEnding       =  0;
+    mn_workerSyncMade     =  1;
+    mn_workerThreadLive   =  1;
 
-        pthread_cond_destroy( &mn_bulkCanWriteCondition );
-        pthread_mutex_destroy( &mn_bulkFileOpsMutex );
-        pthread_mutex_destroy( &mn_bulkBufferMutex );
+    if( pthread_create( & mn_workerThread,
+                        0,
+                        & mn_workerThreadFunction,
+                        0 ) != 0 ) {
         
-        return;
+        mingin_log( "Failed to start worker thread.\n" );
+        mn_workerThreadLive = 0;
+        mn_workerSyncMade   = 0;
+
+        pthread_cond_destroy( &mn_workerIdleCondition );
+        pthread_cond_destroy( &mn_workerWakeCondition );
+        pthread_mutex_destroy( &mn_workerSharedDataMutex );
+        pthread_mutex_destroy( &mn_workerStateMutex );
+        return 0;
         }
 
-    mingin_log( "Bulk data read thread started.\n" );
+    return 1;
     }
 
 
 
-static void mn_endBulkReadThread( void ) {
-    
-    void  *threadReturnVal;
-    int    result;
+void mingin_wakeWorkerThread( void ) {
     
-    if( ! mn_bulkReadThreadLive ) {
+    if( ! mn_workerThreadLive ) {
         return;
         }
-        
-    mn_lockBulkBuffers();
-    mn_bulkReadThreadLive = 0;
-
-    /* wake producer thread up if it's waiting */
-    pthread_cond_signal( &mn_bulkCanWriteCondition );
-    
-    mn_unlockBulkBuffers();
-
-    
-    result = pthread_join( mn_bulkReadThread, &threadReturnVal );
-
-    if( result != 0 ) {
-        mingin_log( "Failed to join bulk read thread at exit\n" );
-        }
-
-    mn_bulkReadMutexesLive = 0;
-    
-    result = pthread_cond_destroy( &mn_bulkCanWriteCondition );
-
-    if( result != 0 ) {
-        mingin_log( "Failed to destroy bulk can write condition at exit\n" );
-        }
-
-    
-    result = pthread_mutex_destroy( &mn_bulkFileOpsMutex );
 
-    if( result != 0 ) {
-        mingin_log( "Failed to destroy bulk file operations mutex at exit\n" );
-        }
-    
+    pthread_mutex_lock( &mn_workerStateMutex );
 
-    result = pthread_mutex_destroy( &mn_bulkBufferMutex );
+    mn_workerWorkWaiting = 1;
+    pthread_cond_signal( &mn_workerWakeCondition );
 
-    if( result != 0 ) {
-        mingin_log( "Failed to destroy bulk read mutex at exit\n" );
-        }
-        
-    mingin_log( "Ended bulk read thread.\n" );
+    pthread_mutex_unlock( &mn_workerStateMutex );
     }
 
 
 
-void mingin_setBulkDataReadBuffer( int             inBulkDataHandle,
-                                   int             inBufferSize,
-                                   unsigned char  *inBuffer ) {
-
-    MinginBulkReadBuffer  *b;
-    int                    numRead;
-
-    mn_setupBulkReadThread();
-
-    mn_lockBulkBuffers();
-
-    if( ! mn_bulkReadThreadLive ) {
-        /* buffer thread system not up and running */
-        mn_unlockBulkBuffers();
-        return;
-        }
-
-    if( mn_numBulkReadBuffers >= MINGIN_MAX_BULK_READ_BUFFERS ) {
-        /* full */
-        mn_unlockBulkBuffers();
-        return;
-        }
+void mingin_waitForWorkerThread( void ) {
     
-    if( mn_getBulkReadBuffer( inBulkDataHandle ) != 0 ) {
-        /* exists already */
-        mn_unlockBulkBuffers();
+    if( ! mn_workerThreadLive ) {
         return;
         }
 
-    b = &( mn_bulkReadBuffers[ mn_numBulkReadBuffers ] );
-
-    b->bulkDataHandle = inBulkDataHandle;
+    pthread_mutex_lock( &mn_workerStateMutex );
 
-    b->bufferSize = inBufferSize;
+    while( mn_workerWorkWaiting
+           ||
+           mn_workerBusy ) {
+        
+        pthread_cond_wait( &mn_workerIdleCondition,
+                           &mn_workerStateMutex );
+        }
 
-    b->buffer = inBuffer;
+    pthread_mutex_unlock( &mn_workerStateMutex );
+    }
 
-    b->producerPos = 0;
-    b->consumerPos = 0;
 
-    b->nextConsumerResourcePos = mn_linuxFileGetPos( inBulkDataHandle );
 
-    if( b->nextConsumerResourcePos == -1 ) {
-        /* failed to get pos */
-        mn_unlockBulkBuffers();
+void mingin_lockWorker( void ) {
+    
+    if( ! mn_workerSyncMade ) {
         return;
         }
-    
-    /* pre-fill buffer */
-    numRead = mn_linuxFileRead( inBulkDataHandle,
-                                inBufferSize - 1,
-                                inBuffer );
 
-    if( numRead == -1 ) {
-        mn_unlockBulkBuffers();
+    if( pthread_mutex_lock( &mn_workerSharedDataMutex ) != 0 ) {
+        mingin_log( "Failed to lock worker mutex\n" );
+        }
+    }
+
+
+
+void mingin_unlockWorker( void ) {
+    
+    if( ! mn_workerSyncMade ) {
         return;
         }
 
-    b->producerPos += numRead;
+    if( pthread_mutex_unlock( &mn_workerSharedDataMutex ) != 0 ) {
+        mingin_log( "Failed to unlock worker mutex\n" );
+        }
+    }
+
+
+
+void mingin_endWorkerThread( void ) {
     
-    b->nextProducerResourcePos = mn_linuxFileGetPos( inBulkDataHandle );
+    void  *threadReturnVal;
     
-    if( b->nextProducerResourcePos == -1 ) {
-        /* failed to get pos */
-        mn_unlockBulkBuffers();
+    if( ! mn_workerThreadLive ) {
         return;
         }
+
+    pthread_mutex_lock( &mn_workerStateMutex );
+
+    mn_workerEnding = 1;
     
-    b->endOfFileReached = 0;
+    /* wake it up, so it can finish any waiting work and return */
+    pthread_cond_signal( &mn_workerWakeCondition );
+    
+    pthread_mutex_unlock( &mn_workerStateMutex );
 
-    if( numRead != inBufferSize - 1 ) {
-        
-        /* got to end of file on first read */
-        b->endOfFileReached = 1;
+    /* worker may still be locking and unlocking until it returns */
+    if( pthread_join( mn_workerThread, &threadReturnVal ) != 0 ) {
+        mingin_log( "Failed to join worker thread\n" );
         }
-    
-    mn_numBulkReadBuffers ++;
 
-    mn_unlockBulkBuffers();
+    mn_workerThreadLive = 0;
+    mn_workerSyncMade   = 0;
+
+    pthread_cond_destroy( &mn_workerIdleCondition );
+    pthread_cond_destroy( &mn_workerWakeCondition );
+    pthread_mutex_destroy( &mn_workerSharedDataMutex );
+    pthread_mutex_destroy( &mn_workerStateMutex );
     }
 
 
 
-static void mn_removeBulkDataReadBuffer( int  inBulkDataHandle ) {
+#define  MINGIN_NUM_ASYNC_READ_THREADS    2
+#define  MINGIN_MAX_ASYNC_READ_REQUESTS  64
+
+typedef enum MinginAsyncReadState {
+    MN_ASYNC_READ_FREE = 0,
+    MN_ASYNC_READ_WAITING,
+    MN_ASYNC_READ_RUNNING,
+    MN_ASYNC_READ_DONE
+    } MinginAsyncReadState;
+
+
+typedef struct MinginAsyncReadRequest {
+        
+        MinginAsyncReadState   state;
+
+        MinginReadPriority     priority;
+
+        /* requests in the same priority class are served in the order
+           they were made */
+        unsigned long          sequenceNumber;
+
+        /* opened by the caller's thread, so I/O threads don't need
+           to build file paths */
+        int                    fd;
+
+        int                    startPos;
+
+        int                    numBytes;
+
+        unsigned char         *buffer;
+
+        /* bytes read, or -1 on failure */
+        int                    result;
+        
+    } MinginAsyncReadRequest;
+
+
+static  MinginAsyncReadRequest  mn_asyncReadRequests
+                                    [ MINGIN_MAX_ASYNC_READ_REQUESTS ];
+
+static  unsigned long     mn_nextAsyncReadSequenceNumber  =  0;
+static  char              mn_asyncReadThreadsLive         =  0;
+static  int               mn_numAsyncReadThreads          =  0;
+/* this mutex protects all request records */
+static  pthread_mutex_t   mn_asyncReadMutex;
+static  pthread_cond_t    mn_asyncReadWaitingCondition;
+static  pthread_cond_t    mn_asyncReadDoneCondition;
+static  pthread_t         mn_asyncReadThreads[ MINGIN_NUM_ASYNC_READ_THREADS ];
+
+
+
+/* must hold mn_asyncReadMutex
+   returns index of next waiting request to serve, or -1 if none */
+static int mn_getNextAsyncReadRequest( void ) {
 
     int  i;
+    int  best  =  -1;
 
-    mn_lockBulkBuffers();
-    
     for( i = 0;
-         i < mn_numBulkReadBuffers;
+         i < MINGIN_MAX_ASYNC_READ_REQUESTS;
          i ++ ) {
 
-        if( mn_bulkReadBuffers[ i ].bulkDataHandle == inBulkDataHandle ) {
-
-            /* found */
+        MinginAsyncReadRequest  *r  =  &( mn_asyncReadRequests[ i ] );
+        
+        if( r->state != MN_ASYNC_READ_WAITING ) {
+            continue;
+            }
 
-            /* swap last into this spot and shrink */
-            
-            if( i != mn_numBulkReadBuffers - 1 ) {
-                
-                mn_bulkReadBuffers[ i ] =
-                    mn_bulkReadBuffers[ mn_numBulkReadBuffers - 1 ];
-                }
+        if( best == -1
+            ||
+            r->priority < mn_asyncReadRequests[ best ].priority
+            ||
+            ( r->priority == mn_asyncReadRequests[ best ].priority
+              &&
+              r->sequenceNumber
+              < mn_asyncReadRequests[ best ].sequenceNumber ) ) {
 
-            mn_unlockBulkBuffers();
-            
-            mn_numBulkReadBuffers --;
-            return;
+            best = i;
             }
         }
 
-    /* not found */
-    mn_unlockBulkBuffers();
+    return best;
     }
 
 
 
-/* must call mn_lockBulkBuffers before calling
-   unlocks before returning */
-static int mn_bufferedBulkRead( int             inBulkDataHandle,
-                                int             inNumBytesToRead,
-                                unsigned char  *inByteBuffer ) {
-    
-    MinginBulkReadBuffer  *buffer;
-    int                    c;
-    int                    p;
-    int                    b;
-    
-    buffer = mn_getBulkReadBuffer( inBulkDataHandle );
+static void *mn_asyncReadThreadFunction( void *inArg ) {
 
-    if( buffer == 0 ) {
-        mn_unlockBulkBuffers();
-        return -1;
+    /* suppress warning, arg not needed */
+    if( inArg == 0 ) {
+        
         }
 
-    p = buffer->producerPos;
-    c = buffer->consumerPos;
-    b = 0;
-    
-    while( c != p
-           &&
-           b < inNumBytesToRead ) {
-
-        inByteBuffer[ b++ ] = buffer->buffer[ c++ ];
+    pthread_mutex_lock( &mn_asyncReadMutex );
 
-        if( c >= buffer->bufferSize ) {
-            /* wrap around */
-            c = 0;
-            }
-        }
+    while( 1 ) {
 
-    buffer->consumerPos = c;
-    buffer->nextConsumerResourcePos += b;
-    
-    if( b < inNumBytesToRead
-        &&
-        ! buffer->endOfFileReached ) {
-        
-        /* we read everything in ring buffer, and we still need more
-           in this case, read from the actual underlying file
-           keep lock while we do this, so that i/o thread doesn't
-           try to read while we're in here */
+        MinginAsyncReadRequest  *r;
+        int                      i;
+        int                      numRead;
 
-        int  numExtra  = inNumBytesToRead - b;
+        /* we always have the lock when we head into next iteration of
+           this while loop */
 
-        int  numRead;
-        int  truePos;
+        i = mn_getNextAsyncReadRequest();
         
-        mn_lockBulkFileOps();
-
-        truePos = mn_linuxFileGetPos( inBulkDataHandle );
+        while( i == -1
+               &&
+               mn_asyncReadThreadsLive ) {
+            
+            pthread_cond_wait( &mn_asyncReadWaitingCondition,
+                               &mn_asyncReadMutex );
 
-        if( truePos == -1 ) {
-            mn_unlockBulkFileOps();
-            mn_unlockBulkBuffers();
-            return -1;
+            i = mn_getNextAsyncReadRequest();
             }
-        if( truePos != buffer->nextConsumerResourcePos ) {
-            /* io thread did some file reading that's not in the buffer
-               yet, and changed the file position
 
-               seek to where we actually want to be */
+        if( i == -1 ) {
+            /* ended, and no more reads waiting */
+            pthread_mutex_unlock( &mn_asyncReadMutex );
             
-            if( ! mn_linuxFileSeek( inBulkDataHandle,
-                                    buffer->nextConsumerResourcePos ) ) {
-                mn_unlockBulkFileOps();
-                mn_unlockBulkBuffers();
-                return -1;
-                }
-            }
-        
-        numRead = mn_linuxFileRead( inBulkDataHandle,
-                                    numExtra,
-                                    &( inByteBuffer[ b ] ) );
-        mn_unlockBulkFileOps();
-        
-        if( numRead == -1 ) {
-            mn_unlockBulkBuffers();
-
-            return -1;
+            return 0;
             }
-        b += numRead;
 
-        /* keep track of where our consumer is at in the file now */
-        buffer->nextConsumerResourcePos += numRead;
+        r = &( mn_asyncReadRequests[ i ] );
+        
+        r->state = MN_ASYNC_READ_RUNNING;
 
-        /* tell io thread that it needs to read from a different
-           spot in the file next time */
-        buffer->nextProducerResourcePos = buffer->nextConsumerResourcePos;
-        }
+        pthread_mutex_unlock( &mn_asyncReadMutex );
 
-    if( b > 0
-        &&
-        ! buffer->endOfFileReached ){
-        /* tell producer that there's room to write more in the buffer
-           we must hold the lock while doing this */
+        
+        /* nobody else touches a running request's fd or buffer */
+        numRead = -1;
+        
+        if( mn_linuxFileSeek( r->fd,
+                              r->startPos ) ) {
+            
+            /* reads until numBytes or end of file */
+            numRead = mn_linuxFileRead( r->fd,
+                                        r->numBytes,
+                                        r->buffer );
+            }
+        
+        pthread_mutex_lock( &mn_asyncReadMutex );
 
-        /* note that we do NOT do this if producer has reached the
-           end of the file, since that will wake them up to do
-           nothing */
+        r->result = numRead;
+        r->state  = MN_ASYNC_READ_DONE;
         
-        pthread_cond_signal( & mn_bulkCanWriteCondition );
+        pthread_cond_broadcast( &mn_asyncReadDoneCondition );
         }
-
-    mn_unlockBulkBuffers();
-
-    return b;
     }
 
 
-/* must call mn_lockBulkBuffers before calling
-   unlocks before returning */
-static char mn_bufferedBulkSeek( int  inBulkDataHandle,
-                                 int  inAbsoluteBytePosition ) {
-
-    MinginBulkReadBuffer  *buffer;
 
-    buffer = mn_getBulkReadBuffer( inBulkDataHandle );
+static void mn_setupAsyncReadThreads( void ) {
 
-    if( buffer == 0 ) {
-        mn_unlockBulkBuffers();
-        return 0;
+    int  i;
+    
+    if( mn_asyncReadThreadsLive ) {
+        return;
         }
 
-    if( buffer->nextConsumerResourcePos == inAbsoluteBytePosition ) {
-        /* already there */
-        mn_unlockBulkBuffers();
-        return 1;
+    if( pthread_mutex_init( &mn_asyncReadMutex, 0 ) != 0 ) {
+        mingin_log( "Failed to create async read mutex\n" );
+        return;
         }
-    /* an actual seek
-       in this case, reset all the positions in the buffer,
-       starting over with an empty buffer */
-
-    buffer->producerPos = 0;
-    buffer->consumerPos = 0;
-
-    /* producer will seek here before its next read */
-    buffer->nextProducerResourcePos = inAbsoluteBytePosition;
-    buffer->nextConsumerResourcePos = inAbsoluteBytePosition;
-    buffer->endOfFileReached = 0;
 
-    /* tell producer that there's room to write more in the buffer
-       since all positions reset
-       we must hold the lock while doing this */
-    pthread_cond_signal( & mn_bulkCanWriteCondition );
+    if( pthread_cond_init( &mn_asyncReadWaitingCondition, 0 ) != 0 ) {
+        mingin_log( "Failed to create async read waiting condition\n" );
 
-    mn_unlockBulkBuffers();
-        
-    return 1;
-    }
+        pthread_mutex_destroy( &mn_asyncReadMutex );
+        return;
+        }
 
+    if( pthread_cond_init( &mn_asyncReadDoneCondition, 0 ) != 0 ) {
+        mingin_log( "Failed to create async read done condition\n" );
 
+        pthread_cond_destroy( &mn_asyncReadWaitingCondition );
+        pthread_mutex_destroy( &mn_asyncReadMutex );
+        return;
+        }
 
-/* must call mn_lockBulkBuffers before calling
-   unlocks before returning */
-static int mn_bufferedBulkTell( int  inBulkDataHandle ) {
+    for( i = 0;
+         i < MINGIN_MAX_ASYNC_READ_REQUESTS;
+         i ++ ) {
+        mn_asyncReadRequests[ i ].state = MN_ASYNC_READ_FREE;
+        }
 
-    int                    pos;
-    MinginBulkReadBuffer  *buffer;
-    
-    buffer = mn_getBulkReadBuffer( inBulkDataHandle );
+    mn_asyncReadThreadsLive = 1;
+    mn_numAsyncReadThreads  = 0;
 
-    if( buffer == 0 ) {
-        mn_unlockBulkBuffers();
-        return -1;
+    for( i = 0;
+         i < MINGIN_NUM_ASYNC_READ_THREADS;
+         i ++ ) {
+        
+        if( pthread_create( &( mn_asyncReadThreads[ i ] ),
+                            0,
+                            & mn_asyncReadThreadFunction,
+                            0 ) != 0 ) {
+            mingin_log( "Failed to start async read thread.\n" );
+            break;
+            }
+        
+        mn_numAsyncReadThreads ++;
         }
 
-    pos = buffer->nextConsumerResourcePos;
-
-    mn_unlockBulkBuffers();
+    if( mn_numAsyncReadThreads == 0 ) {
+        mn_asyncReadThreadsLive = 0;
+        
+        pthread_cond_destroy( &mn_asyncReadDoneCondition );
+        pthread_cond_destroy( &mn_asyncReadWaitingCondition );
+        pthread_mutex_destroy( &mn_asyncReadMutex );
+        return;
+        }
 
-    return pos;
+    mingin_log( "Async read threads started.\n" );
     }
 
 
 
-int mingin_readBulkData( int             inBulkDataHandle,
-                         int             inNumBytesToRead,
-                         unsigned char  *inByteBuffer ) {
-    
-    /* call first without locking
-       if there are some buffered bulk resources,
-       we don't want to slow down ALL reads for non-buffered
-       resources with locking on every read */
+static void mn_endAsyncReadThreads( void ) {
+
+    void  *threadReturnVal;
+    int    i;
     
-    if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+    if( ! mn_asyncReadThreadsLive ) {
+        return;
+        }
 
-        /* we know it existed, but it might not exist still
-           lock and try again */
+    pthread_mutex_lock( &mn_asyncReadMutex );
 
-        mn_lockBulkBuffers();
+    mn_asyncReadThreadsLive = 0;
 
-        if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+    /* wake them up, so they can finish any waiting reads and return */
+    pthread_cond_broadcast( &mn_asyncReadWaitingCondition );
+    
+    pthread_mutex_unlock( &mn_asyncReadMutex );
 
-            /* this will unlock before returning */
-            return mn_bufferedBulkRead( inBulkDataHandle,
-                                        inNumBytesToRead,
-                                        inByteBuffer );
+    for( i = 0;
+         i < mn_numAsyncReadThreads;
+         i ++ ) {
+        
+        if( pthread_join( mn_asyncReadThreads[ i ],
+                          &threadReturnVal ) != 0 ) {
+            mingin_log( "Failed to join async read thread\n" );
             }
-        else {
-            mn_unlockBulkBuffers();
+        }
+
+    mn_numAsyncReadThreads = 0;
+
+    /* close files of any reads that the game never collected */
+    for( i = 0;
+         i < MINGIN_MAX_ASYNC_READ_REQUESTS;
+         i ++ ) {
+
+        if( mn_asyncReadRequests[ i ].state != MN_ASYNC_READ_FREE ) {
+            mn_closeBulkFile( mn_asyncReadRequests[ i ].fd );
+            mn_asyncReadRequests[ i ].state = MN_ASYNC_READ_FREE;
             }
         }
 
-    /* if we fell through without returning, we didn't read a
-       buffered resource */
-    
-    return mn_linuxFileRead( inBulkDataHandle,
-                             inNumBytesToRead,
-                             inByteBuffer );
+    pthread_cond_destroy( &mn_asyncReadDoneCondition );
+    pthread_cond_destroy( &mn_asyncReadWaitingCondition );
+    pthread_mutex_destroy( &mn_asyncReadMutex );
     }
 
 
 
-char mingin_seekBulkData( int  inBulkDataHandle,
-                          int  inAbsoluteBytePosition ) {
-
-    /* see comments inside
-           mingin_readBulkData
-       for explanation of why we do things in this order */
-    
-    if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
-        
-        mn_lockBulkBuffers();
+int mingin_startAsyncBulkRead( const char          *inBulkName,
+                               int                  inStartPos,
+                               int                  inNumBytes,
+                               unsigned char       *inBuffer,
+                               MinginReadPriority   inPriority ) {
 
-        if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
-            
-            return mn_bufferedBulkSeek( inBulkDataHandle,
-                                        inAbsoluteBytePosition );
-            }
-        else {
-            mn_unlockBulkBuffers();
-            }
-        }
+    int  i;
+    int  fd;
+    int  totalBytes;
 
-    return mn_linuxFileSeek( inBulkDataHandle,
-                             inAbsoluteBytePosition );
-    }
+    mn_setupAsyncReadThreads();
 
+    if( ! mn_asyncReadThreadsLive ) {
+        return -1;
+        }
 
+    mn_logModTime( inBulkName );
 
-int mingin_getBulkDataPosition( int  inBulkDataHandle ) {
+    fd = mn_openBulkFile( inBulkName,
+                          &totalBytes );
 
-    /* see comments inside
-           mingin_readBulkData
-       for explanation of why we do things in this order */
+    if( fd == -1 ) {
+        return -1;
+        }
+    
+    pthread_mutex_lock( &mn_asyncReadMutex );
+    
+    for( i = 0;
+         i < MINGIN_MAX_ASYNC_READ_REQUESTS;
+         i ++ ) {
 
-    if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+        MinginAsyncReadRequest  *r  =  &( mn_asyncReadRequests[ i ] );
         
-        mn_lockBulkBuffers();
+        if( r->state == MN_ASYNC_READ_FREE ) {
 
-        if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+            r->state          = MN_ASYNC_READ_WAITING;
+            r->priority       = inPriority;
+            r->sequenceNumber = mn_nextAsyncReadSequenceNumber;
+            r->fd             = fd;
+            r->startPos       = inStartPos;
+            r->numBytes       = inNumBytes;
+            r->buffer         = inBuffer;
+            r->result         = -1;
+
+            mn_nextAsyncReadSequenceNumber ++;
             
-            return mn_bufferedBulkTell( inBulkDataHandle );
-            }
-        else {
-            mn_unlockBulkBuffers();
+            pthread_cond_signal( &mn_asyncReadWaitingCondition );
+            
+            pthread_mutex_unlock( &mn_asyncReadMutex );
+            
+            return i;
             }
         }
+
+    /* all request records in use */
+    pthread_mutex_unlock( &mn_asyncReadMutex );
+
+    mn_closeBulkFile( fd );
     
-    return mn_linuxFileGetPos( inBulkDataHandle );
+    return -1;
     }
 
 
 
-void mingin_endReadBulkData( int  inBulkDataHandle ) {
-
-    if( mn_getBulkReadBuffer( inBulkDataHandle ) ) {
+int mingin_getAsyncBulkReadResult( int   inReadRequest,
+                                   char  inWait ) {
 
-        /* this is safe to do without locks around
-           checking for existence, since the remove
-           code locks and will just not find the buffer if it's
-           already been removed */
-        
-        mn_removeBulkDataReadBuffer( inBulkDataHandle );
-        }
+    MinginAsyncReadRequest  *r;
+    int                      result;
     
-    close( inBulkDataHandle );
-    }
-
+    if( ! mn_asyncReadThreadsLive
+        ||
+        inReadRequest < 0
+        ||
+        inReadRequest >= MINGIN_MAX_ASYNC_READ_REQUESTS ) {
+        return -1;
+        }
 
+    r = &( mn_asyncReadRequests[ inReadRequest ] );
 
-char mingin_getBulkDataChanged( const char  *inBulkName ) {
+    pthread_mutex_lock( &mn_asyncReadMutex );
 
-    int          i;
-    struct stat  fileStat;
-    const char  *path       =  mn_linuxGetFilePath( mn_bulkDataDirName,
-                                                    inBulkName );
+    if( r->state == MN_ASYNC_READ_FREE ) {
+        pthread_mutex_unlock( &mn_asyncReadMutex );
+        return -1;
+        }
     
-    if( stat( path,
-              & fileStat ) != 0 ) {
+    while( r->state != MN_ASYNC_READ_DONE ) {
 
-        mingin_log( "Failed to get mod time for bulk data file: " );
-        mingin_log( inBulkName );
-        mingin_log( "\n" );
+        if( ! inWait ) {
+            pthread_mutex_unlock( &mn_asyncReadMutex );
+            return MINGIN_ASYNC_READ_PENDING;
+            }
         
-        return 0;
+        pthread_cond_wait( &mn_asyncReadDoneCondition,
+                           &mn_asyncReadMutex );
         }
 
-    if( fileStat.st_mtime > mn_latestBulkChangeModTime ) {
-        /* file is newer than our most recent global mod time
-           it definitely changed */
+    result = r->result;
 
-        /* don't update our mod time until game client calls
-               mingin_startReadBulkData
-           since we're tracking whether data has changed since it was last
-           opened for reading
-        */
-        return 1;
-        }
+    mn_closeBulkFile( r->fd );
     
+    r->state = MN_ASYNC_READ_FREE;
     
+    pthread_mutex_unlock( &mn_asyncReadMutex );
 
-    for( i = 0;
-         i < mn_numBulkChangeRecords;
-         i ++ ) {
-
-        if( mn_stringsEqual(
-                inBulkName,
-                mn_bulkChangeRecords[ i ].bulkName ) ) {
-
-            /* found a match */
-            if( fileStat.st_mtime > mn_bulkChangeRecords[ i ].modTime ) {
-                /* newer than our record */
-                return 1;
-                }
-            }
-        }
-
-    /* not newer than our record, or no record found.
-       if no record found, that means either file hasn't been openend
-       for reading before, or we have a mn_bulkChangeRecords overflow
-       and can't track this file.
-       In that case, we count the file as changed only if it's mod
-       time is greater than our mn_latestBulkChangeModTime global mod tim.
-    */
-    return 0;
+    return result;
     }
 
 
@@ -8108,6 +11667,8 @@ int APIENTRY WinMain( HINSTANCE  hInstance,
                                         mn_windowH,
                                         mn_gameScreenBuffer );
 
+            mn_startPresentStage( MGN_PRESENT_UPLOAD );
+            
             /* now copy them into RGBA texture data */
             numPixels   =  mn_windowW * mn_windowH;
             gameImageI  = 0;
@@ -8153,9 +11714,14 @@ int APIENTRY WinMain( HINSTANCE  hInstance,
 
                 ID3D11Texture2D_Release( backBufferTexture );
                 }
+
+            mn_endPresentStage( MGN_PRESENT_UPLOAD );
             
+            mn_startPresentStage( MGN_PRESENT_SWAP );
                     
             mn_swapScreen();
+
+            mn_endPresentStage( MGN_PRESENT_SWAP );
             
             if( ! mn_vsyncOn ) {
                 /* sleep to contol frame time */
@@ -8201,6 +11767,9 @@ int APIENTRY WinMain( HINSTANCE  hInstance,
 
     mn_endBulkReadThread();
 
+    /* in case game left it running */
+    mingin_endWorkerThread();
+
     mn_windowSetup = 0;
     
     mn_destroyWindow( hInstance );
@@ -8248,6 +11817,33 @@ int mingin_getMillisecondsLeftInStep( void ) {
 
 
 
+unsigned long mingin_getRunningMicroseconds( void ) {
+
+    LARGE_INTEGER  currCount;
+    LARGE_INTEGER  countDiff;
+    LARGE_INTEGER  sec;
+    LARGE_INTEGER  remainder;
+    
+    QueryPerformanceCounter( &currCount );
+
+    countDiff.QuadPart =
+        currCount.QuadPart - mn_programStartCount.QuadPart;
+
+    /* split off whole seconds first, so that scaling up the remainder to
+       microseconds can't overflow */
+    sec.QuadPart       =
+        countDiff.QuadPart / mn_performanceCounterFreq.QuadPart;
+    remainder.QuadPart =
+        countDiff.QuadPart % mn_performanceCounterFreq.QuadPart;
+
+    /* wraps around in unsigned arithmetic */
+    return (unsigned long)sec.QuadPart * 1000000UL
+        + (unsigned long)( ( remainder.QuadPart * 1000000 )
+                           / mn_performanceCounterFreq.QuadPart );
+    }
+
+
+
 void mingin_getRunningTime( long  *outSeconds,
                             long  *outMilliseconds ) {
 
@@ -8937,6 +12533,18 @@ char mingin_writePersistData( int                   inStoreWriteHandle,
 
 
 
+char mingin_flushPersistData( int  inStoreWriteHandle ) {
+    
+    /* writes on Windows are not buffered by us, nothing to flush */
+    if( ! mn_fileHandles[ inStoreWriteHandle ].live ) {
+        return 0;
+        }
+    
+    return 1;
+    }
+
+
+
 int mingin_readPersistData( int             inStoreReadHandle,
                             int             inNumBytesToRead,
                             unsigned char  *inByteBuffer ) {
@@ -8962,21 +12570,28 @@ int mingin_getPersistDataPosition( int  inStoreReadHandle ) {
    }
 
 
-static void mn_windowsCloseFile( int  inFD ) {
+/* returns 1 on success, 0 on failure */
+static char mn_windowsCloseFile( int  inFD ) {
     
     MinginFileHandle  *fileHandle  =  &( mn_fileHandles[ inFD ] );
+    BOOL               result;
 
     if( ! fileHandle->live ) {
-        return;
+        return 0;
         }
-    CloseHandle( fileHandle->h );
+    result = CloseHandle( fileHandle->h );
     fileHandle->live = 0;
+
+    if( ! result ) {
+        return 0;
+        }
+    return 1;
     }
 
 
 
-void mingin_endWritePersistData( int  inStoreWriteHandle ) {
-    mn_windowsCloseFile( inStoreWriteHandle );
+char mingin_endWritePersistData( int  inStoreWriteHandle ) {
+    return mn_windowsCloseFile( inStoreWriteHandle );
     }
 
 
@@ -9005,8 +12620,10 @@ char mingin_renamePersistData( const char  *inStoreName,
     char  *pathNew  =  mn_windowsGetFilePath( mn_settingsDirName,
                                               inStoreNewName );
 
-    int    result   =  MoveFileA( pathOld,
-                                  pathNew );
+    /* replace existing, like rename does on other platforms */
+    int    result   =  MoveFileExA( pathOld,
+                                    pathNew,
+                                    MOVEFILE_REPLACE_EXISTING );
 
     if( result == 0 ) {
         return 0;
@@ -9295,13 +12912,138 @@ static MinginBulkReadBuffer *mn_getBulkReadBuffer( int  inBulkDataHandle ) {
          i < mn_numBulkReadBuffers;
          i ++ ) {
 
-        if( mn_bulkReadBuffers[ i ].bulkDataHandle == inBulkDataHandle ) {
+        if( mn_bulkReadBuffers[ i ].bulkDataHandle == inBulkDataHandle ) {
+
+            return &( mn_bulkReadBuffers[ i ] );
+            }
+        }
+    
+    return 0;
+    }
+
+
+
+/*
+  Copies bytes in blocks of 8, which compilers can turn into wide moves.
+*/
+static void mn_copyBytes( unsigned char        *outDest,
+                          const unsigned char  *inSource,
+                          int                   inNumBytes ) {
+    
+    int  i  =  0;
+    
+    while( i < inNumBytes - 7 ) {
+        outDest[ i     ] = inSource[ i     ];
+        outDest[ i + 1 ] = inSource[ i + 1 ];
+        outDest[ i + 2 ] = inSource[ i + 2 ];
+        outDest[ i + 3 ] = inSource[ i + 3 ];
+        outDest[ i + 4 ] = inSource[ i + 4 ];
+        outDest[ i + 5 ] = inSource[ i + 5 ];
+        outDest[ i + 6 ] = inSource[ i + 6 ];
+        outDest[ i + 7 ] = inSource[ i + 7 ];
+        i += 8;
+        }
+    
+    while( i < inNumBytes ) {
+        outDest[i] = inSource[i];
+        i++;
+        }
+    }
+
+
+
+/*
+  Copies bytes into a bulk read ring buffer at its producer position,
+  in at most two spans, one before the end of the ring and one after
+  wrapping around.
+
+  Caller must make sure there's room for inNumBytes.
+
+  Returns the producer position after the copied bytes.
+*/
+static int mn_copyIntoBulkReadRing( MinginBulkReadBuffer  *inBuffer,
+                                    const unsigned char   *inBytes,
+                                    int                    inNumBytes ) {
+
+    int  p          =  inBuffer->producerPos;
+    int  firstSpan  =  inBuffer->bufferSize - p;
+
+    if( firstSpan > inNumBytes ) {
+        firstSpan = inNumBytes;
+        }
+
+    mn_copyBytes( &( inBuffer->buffer[ p ] ),
+                  inBytes,
+                  firstSpan );
+
+    mn_copyBytes( inBuffer->buffer,
+                  &( inBytes[ firstSpan ] ),
+                  inNumBytes - firstSpan );
+
+    p += inNumBytes;
+
+    if( p >= inBuffer->bufferSize ) {
+        /* wrap around */
+        p -= inBuffer->bufferSize;
+        }
+    
+    return p;
+    }
+
+
+
+/*
+  Copies up to inNumBytes out of a bulk read ring buffer at its consumer
+  position, in at most two spans.
+
+  Returns the number of bytes copied, which is less than inNumBytes if
+  the ring doesn't have that many waiting.
+*/
+static int mn_copyOutOfBulkReadRing( MinginBulkReadBuffer  *inBuffer,
+                                     unsigned char         *outBytes,
+                                     int                    inNumBytes ) {
+
+    int  p           =  inBuffer->producerPos;
+    int  c           =  inBuffer->consumerPos;
+    int  numWaiting;
+    int  firstSpan;
+
+    if( p >= c ) {
+        numWaiting = p - c;
+        }
+    else {
+        /* producer has wrapped around */
+        numWaiting = inBuffer->bufferSize - c + p;
+        }
+
+    if( inNumBytes > numWaiting ) {
+        inNumBytes = numWaiting;
+        }
+    
+    firstSpan = inBuffer->bufferSize - c;
+
+    if( firstSpan > inNumBytes ) {
+        firstSpan = inNumBytes;
+        }
+
+    mn_copyBytes( outBytes,
+                  &( inBuffer->buffer[ c ] ),
+                  firstSpan );
+
+    mn_copyBytes( &( outBytes[ firstSpan ] ),
+                  inBuffer->buffer,
+                  inNumBytes - firstSpan );
+
+    c += inNumBytes;
 
-            return &( mn_bulkReadBuffers[ i ] );
-            }
+    if( c >= inBuffer->bufferSize ) {
+        /* wrap around */
+        c -= inBuffer->bufferSize;
         }
+
+    inBuffer->consumerPos = c;
     
-    return 0;
+    return inNumBytes;
     }
 
 
@@ -9321,8 +13063,6 @@ static char mn_processBulkReadBuffer( MinginBulkReadBuffer *inBuffer ) {
     int    maxNumReadBytes;
     int    truePos;
     int    numRead;
-    int    i;
-    int    p;
     int    bulkDataHandle;
     
     static  unsigned char  buffer[ BUFFER_SIZE ];
@@ -9429,25 +13169,11 @@ static char mn_processBulkReadBuffer( MinginBulkReadBuffer *inBuffer ) {
         inBuffer->endOfFileReached = 1;
         }
 
-    /* p will never catch up to consumer pos,
+    /* producer will never catch up to consumer pos,
        because we limited our read size above to deal with this */
-    p = inBuffer->producerPos;
-    
-    for( i = 0;
-         i < numRead;
-         i ++ ) {
-
-        inBuffer->buffer[ p ] = buffer[ i ];
-
-        p ++;
-
-        /* wrap around */
-        if( p >= inBuffer->bufferSize ) {
-            p = 0;
-            }
-        }
-
-    inBuffer->producerPos = p;
+    inBuffer->producerPos = mn_copyIntoBulkReadRing( inBuffer,
+                                                     buffer,
+                                                     numRead );
 
     inBuffer->nextProducerResourcePos = ourDesiredResourcePos + numRead;
 
@@ -9729,8 +13455,6 @@ static int mn_bufferedBulkRead( int             inBulkDataHandle,
                                 unsigned char  *inByteBuffer ) {
     
     MinginBulkReadBuffer  *buffer;
-    int                    c;
-    int                    p;
     int                    b;
     
     buffer = mn_getBulkReadBuffer( inBulkDataHandle );
@@ -9740,23 +13464,9 @@ static int mn_bufferedBulkRead( int             inBulkDataHandle,
         return -1;
         }
 
-    p = buffer->producerPos;
-    c = buffer->consumerPos;
-    b = 0;
-    
-    while( c != p
-           &&
-           b < inNumBytesToRead ) {
-
-        inByteBuffer[ b++ ] = buffer->buffer[ c++ ];
-
-        if( c >= buffer->bufferSize ) {
-            /* wrap around */
-            c = 0;
-            }
-        }
-
-    buffer->consumerPos = c;
+    b = mn_copyOutOfBulkReadRing( buffer,
+                                  inByteBuffer,
+                                  inNumBytesToRead );
     buffer->nextConsumerResourcePos += b;
     
     if( b < inNumBytesToRead
@@ -10007,6 +13717,61 @@ void mingin_endReadBulkData( int  inBulkDataHandle ) {
 
 
 
+const unsigned char *mingin_startMapBulkData( const char  *inBulkName,
+                                              int         *outTotalBytes ) {
+    /* not supported yet, game should use mingin_startReadBulkData */
+    if( inBulkName[0] != '\0' ) {
+        }
+    *outTotalBytes = 0;
+    return 0;
+    }
+
+
+
+void mingin_endMapBulkData( const unsigned char  *inData,
+                            int                   inTotalBytes ) {
+    /* suppress warning */
+    if( inData != 0
+        ||
+        inTotalBytes > 0 ) {
+        }
+    }
+
+
+
+int mingin_startAsyncBulkRead( const char          *inBulkName,
+                               int                  inStartPos,
+                               int                  inNumBytes,
+                               unsigned char       *inBuffer,
+                               MinginReadPriority   inPriority ) {
+    /* suppress warning */
+    if( inBulkName[0] != '\0'
+        ||
+        inStartPos > 0
+        ||
+        inNumBytes > 0
+        ||
+        inBuffer != 0
+        ||
+        inPriority > 0 ) {
+        }
+    return -1;
+    }
+
+
+
+int mingin_getAsyncBulkReadResult( int   inReadRequest,
+                                   char  inWait ) {
+    /* suppress warning */
+    if( inReadRequest > 0
+        ||
+        inWait ) {
+        }
+    return -1;
+    }
+
+
+
 char mingin_getBulkDataChanged( const char  *inBulkName ) {
 
     int              i;
@@ -10065,6 +13830,224 @@ char mingin_getBulkDataChanged( const char  *inBulkName ) {
 
 
 
+char mingin_getBulkDataChangeNotificationsSupported( void ) {
+    /* not supported yet, game should poll with mingin_getBulkDataChanged */
+    return 0;
+    }
+
+
+
+const char *mingin_getNextChangedBulkData( void ) {
+    return 0;
+    }
+
+
+
+/* only touched by the thread that starts and ends the worker,
+   stays set until the worker has been joined */
+static  char                mn_workerThreadLive      =  0;
+/* set when the critical sections below exist, cleared only after
+   they are deleted, so the worker can lock and unlock right up until
+   it is joined */
+static  char                mn_workerSyncMade        =  0;
+/* set when the worker has been woken, cleared when it starts the work */
+static  char                mn_workerWorkWaiting     =  0;
+static  char                mn_workerBusy            =  0;
+/* set when the worker should return once it runs out of work */
+static  char                mn_workerEnding          =  0;
+static  void              (*mn_workerFunction)( void );
+/* this critical section protects the three flags above */
+static  CRITICAL_SECTION    mn_workerStateCriticalSection;
+/* this critical section is the one that mingin_lockWorker enters */
+static  CRITICAL_SECTION    mn_workerSharedDataCriticalSection;
+static  CONDITION_VARIABLE  mn_workerWakeCondition;
+static  CONDITION_VARIABLE  mn_workerIdleCondition;
+static  HANDLE              mn_workerThread;
+
+
+
+static DWORD WINAPI mn_workerThreadFunction( LPVOID inArg ) {
+
+    /* suppress warning, arg not needed */
+    if( inArg == 0 ) {
+
+        }
+    
+    EnterCriticalSection( &mn_workerStateCriticalSection );
+
+    while( 1 ) {
+
+        /* we always have the critical section when we head into next
+           iteration of this while loop */
+        
+        while( ! mn_workerWorkWaiting
+               &&
+               ! mn_workerEnding ) {
+            
+            SleepConditionVariableCS( &mn_workerWakeCondition,
+                                      &mn_workerStateCriticalSection,
+                                      INFINITE );
+            }
+
+        if( ! mn_workerWorkWaiting ) {
+            /* ended, and no more work to do */
+            LeaveCriticalSection( &mn_workerStateCriticalSection );
+            
+            return 0;
+            }
+
+        mn_workerWorkWaiting = 0;
+        mn_workerBusy = 1;
+        
+        LeaveCriticalSection( &mn_workerStateCriticalSection );
+
+        mn_workerFunction();
+
+        EnterCriticalSection( &mn_workerStateCriticalSection );
+
+        mn_workerBusy = 0;
+
+        if( ! mn_workerWorkWaiting ) {
+            WakeAllConditionVariable( &mn_workerIdleCondition );
+            }
+        }
+    }
+
+
+
+char mingin_startWorkerThread( void  (*inWorkFunction)( void ) ) {
+    
+    if( mn_workerThreadLive ) {
+        return 0;
+        }
+
+    InitializeCriticalSection( &mn_workerStateCriticalSection );
+    InitializeCriticalSection( &mn_workerSharedDataCriticalSection );
+    InitializeConditionVariable( &mn_workerWakeCondition );
+    InitializeConditionVariable( &mn_workerIdleCondition );
+
+    mn_workerFunction     =  inWorkFunction;
+    mn_workerWorkWaiting  =  0;
+    mn_workerBusy         =  0;
+    mn_workerEnding       =  0;
+    mn_workerSyncMade     =  1;
+    mn_workerThreadLive   =  1;
+
+    mn_workerThread = CreateThread( NULL,
+                                    0,
+                                    mn_workerThreadFunction,
+                                    NULL,
+                                    0,
+                                    NULL );
+
+    if( mn_workerThread == NULL ) {
+        mingin_log( "Failed to start worker thread.\n" );
+        mn_workerThreadLive = 0;
+        mn_workerSyncMade   = 0;
+
+        DeleteCriticalSection( &mn_workerSharedDataCriticalSection );
+        DeleteCriticalSection( &mn_workerStateCriticalSection );
+        return 0;
+        }
+
+    return 1;
+    }
+
+
+
+void mingin_wakeWorkerThread( void ) {
+    
+    if( ! mn_workerThreadLive ) {
+        return;
+        }
+
+    EnterCriticalSection( &mn_workerStateCriticalSection );
+
+    mn_workerWorkWaiting = 1;
+    WakeConditionVariable( &mn_workerWakeCondition );
+
+    LeaveCriticalSection( &mn_workerStateCriticalSection );
+    }
+
+
+
+void mingin_waitForWorkerThread( void ) {
+    
+    if( ! mn_workerThreadLive ) {
+        return;
+        }
+
+    EnterCriticalSection( &mn_workerStateCriticalSection );
+
+    while( mn_workerWorkWaiting
+           ||
+           mn_workerBusy ) {
+        
+        SleepConditionVariableCS( &mn_workerIdleCondition,
+                                  &mn_workerStateCriticalSection,
+                                  INFINITE );
+        }
+
+    LeaveCriticalSection( &mn_workerStateCriticalSection );
+    }
+
+
+
+void mingin_lockWorker( void ) {
+    
+    if( ! mn_workerSyncMade ) {
+        return;
+        }
+
+    EnterCriticalSection( &mn_workerSharedDataCriticalSection );
+    }
+
+
+
+void mingin_unlockWorker( void ) {
+    
+    if( ! mn_workerSyncMade ) {
+        return;
+        }
+
+    LeaveCriticalSection( &mn_workerSharedDataCriticalSection );
+    }
+
+
+
+void mingin_endWorkerThread( void ) {
+    
+    if( ! mn_workerThreadLive ) {
+        return;
+        }
+
+    EnterCriticalSection( &mn_workerStateCriticalSection );
+
+    mn_workerEnding = 1;
+
+    /* wake it up, so it can finish any waiting work and return */
+    WakeConditionVariable( &mn_workerWakeCondition );
+    
+    LeaveCriticalSection( &mn_workerStateCriticalSection );
+
+    /* worker may still be locking and unlocking until it returns */
+    if( WaitForSingleObject( mn_workerThread,
+                             INFINITE )       != WAIT_OBJECT_0 ) {
+        
+        mingin_log( "Failed to join worker thread\n" );
+        }
+
+    CloseHandle( mn_workerThread );
+
+    mn_workerThreadLive = 0;
+    mn_workerSyncMade   = 0;
+
+    DeleteCriticalSection( &mn_workerSharedDataCriticalSection );
+    DeleteCriticalSection( &mn_workerStateCriticalSection );
+    }
+
+
+
 
 /* end of _WIN32 case */
 #else
@@ -10120,6 +14103,8 @@ int main( void ) {
     (void)mn_getFlagSetting;
     (void)mn_saveFlagSetting;
     (void)mn_stringStartsWith;
+    (void)mn_startPresentStage;
+    (void)mn_endPresentStage;
     (void)mn_stringsEqual;
     (void)mn_stringLength;
     (void)mn_intToString;
@@ -10152,6 +14137,12 @@ void mingin_getRunningTime( long  *outSeconds,
 
 
 
+unsigned long mingin_getRunningMicroseconds( void ) {
+    return 0;
+    }
+
+
+
 unsigned long mingin_getEntropySeed( void ) {
     return 0x9E3779B9UL;
     }
@@ -10302,6 +14293,15 @@ char mingin_writePersistData( int                   inStoreWriteHandle,
 
 
 
+char mingin_flushPersistData( int  inStoreWriteHandle ) {
+    /* suppress warning */
+    if( inStoreWriteHandle > 0 ) {
+        }
+    return 0;
+    }
+
+
+
 int mingin_readPersistData( int             inStoreReadHandle,
                             int             inNumBytesToRead,
                             unsigned char  *inByteBuffer ) {
@@ -10338,10 +14338,11 @@ int mingin_getPersistDataPosition( int  inStoreReadHandle ) {
 
 
 
-void mingin_endWritePersistData( int  inStoreWriteHandle ) {
+char mingin_endWritePersistData( int  inStoreWriteHandle ) {
     /* suppress warning */
     if( inStoreWriteHandle > 0 ) {
         }
+    return 0;
     }
 
 
@@ -10424,6 +14425,61 @@ void mingin_endReadBulkData( int  inBulkDataHandle ) {
 
 
 
+const unsigned char *mingin_startMapBulkData( const char  *inBulkName,
+                                              int         *outTotalBytes ) {
+    /* suppress warning */
+    if( inBulkName[0] != '\0' ) {
+        }
+    *outTotalBytes = 0;
+    return 0;
+    }
+
+
+
+void mingin_endMapBulkData( const unsigned char  *inData,
+                            int                   inTotalBytes ) {
+    /* suppress warning */
+    if( inData != 0
+        ||
+        inTotalBytes > 0 ) {
+        }
+    }
+
+
+
+int mingin_startAsyncBulkRead( const char          *inBulkName,
+                               int                  inStartPos,
+                               int                  inNumBytes,
+                               unsigned char       *inBuffer,
+                               MinginReadPriority   inPriority ) {
+    /* suppress warning */
+    if( inBulkName[0] != '\0'
+        ||
+        inStartPos > 0
+        ||
+        inNumBytes > 0
+        ||
+        inBuffer != 0
+        ||
+        inPriority > 0 ) {
+        }
+    return -1;
+    }
+
+
+
+int mingin_getAsyncBulkReadResult( int   inReadRequest,
+                                   char  inWait ) {
+    /* suppress warning */
+    if( inReadRequest > 0
+        ||
+        inWait ) {
+        }
+    return -1;
+    }
+
+
+
 char mingin_getBulkDataChanged( const char  *inBulkName ) {
     /* suppress warning */
     if( inBulkName[0] != '\0' ) {
@@ -10433,6 +14489,52 @@ char mingin_getBulkDataChanged( const char  *inBulkName ) {
 
 
 
+char mingin_getBulkDataChangeNotificationsSupported( void ) {
+    return 0;
+    }
+
+
+
+const char *mingin_getNextChangedBulkData( void ) {
+    return 0;
+    }
+
+
+
+char mingin_startWorkerThread( void  (*inWorkFunction)( void ) ) {
+    /* suppress warning */
+    if( inWorkFunction == 0 ) {
+        }
+    return 0;
+    }
+
+
+
+void mingin_wakeWorkerThread( void ) {
+    }
+
+
+
+void mingin_waitForWorkerThread( void ) {
+    }
+
+
+
+void mingin_lockWorker( void ) {
+    }
+
+
+
+void mingin_unlockWorker( void ) {
+    }
+
+
+
+void mingin_endWorkerThread( void ) {
+    }
+
+
+
 void mingin_deletePersistData( const char  *inStoreName ) {
     /* suppress warning */
     if( inStoreName[0] != '\0' ) {
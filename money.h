@@ -46,6 +46,10 @@ void moneyStep( void );
 char moneyIsSettled( void );
 
 
+/* finishes any money adding animation instantly, without sound */
+void moneySettle( void );
+
+
 void moneyForce( int  inVal );
 
 
@@ -306,6 +310,16 @@ char moneyIsSettled( void ) {
 
 
 
+void moneySettle( void ) {
+    moneyVal   += moneyToAdd;
+    moneyToAdd  = 0;
+
+    moneyAddProgress     = 0;
+    moneyProgressMidPeak = 0;
+    }
+
+
+
 #endif
 
 
@@ -32,54 +32,64 @@ enum{
     multiplier,
     addition,
     rocketUp,
-    rocketDown
+    rocketDown,
+    NUM_ANIM_PHASE_TYPES
     };
 
 #define  MAX_ANIM_PHASES       BN
 
 #define  NUM_ANIM_PARAMS       5
 
+/* a phase is stored as its type byte followed by only the params that
+   phase type uses, at most 7 bytes (see animPhaseParamBytes) */
+#define  MAX_ANIM_PHASE_BYTES  ( MAX_ANIM_PHASES * 7 )
+
 #define  MAX_PARTICLE_SYSTEMS  4
 
 
 typedef struct AnimProgress {
 
-        int        numPhases;
-        int        phaseNumber;
-        int        phaseProgress;
+        unsigned char   numPhases;
+        unsigned char   phaseNumber;
+
+        /* offset of current phase in phaseData */
+        unsigned short  phaseOffset;
 
-        /* type of phase from our enum above */
-        AnimPhase  phases[ MAX_ANIM_PHASES ];
+        /* bytes of phaseData in use */
+        unsigned short  phaseBytes;
+        
+        int             phaseProgress;
 
-        /* each phase may have multiple parameters that the phase
-           interprets in unique ways */
-        short      params[ MAX_ANIM_PHASES ][ NUM_ANIM_PARAMS ];
+        /* variable-length list of phases, each a type from our enum above
+           followed by parameters that the phase interprets in unique ways.
+           Use addAnimPhase, getAnimPhase and getAnimPhaseParam to access */
+        unsigned char   phaseData[ MAX_ANIM_PHASE_BYTES ];
 
         /* for accumulating multiplier factors that build up
-           as modifiers propagate */
-        char           anyMultFactors;
-        long           multFactors      [ BH ][ BW ];
-        unsigned char  multFactorFades  [ BH ][ BW ];
-        char           multFactorFadeDir[ BH ][ BW ];
+           as modifiers propagate, saturating at 65535 */
+        char            anyMultFactors;
+        unsigned short  multFactors      [ BH ][ BW ];
+        unsigned char   multFactorFades  [ BH ][ BW ];
+        char            multFactorFadeDir[ BH ][ BW ];
 
         /* used for shimmering in multFactors */
-        MaxiginRand    multRandA;
-        MaxiginRand    multRandB;
+        MaxiginRand     multRandA;
+        MaxiginRand     multRandB;
 
         /* used for other randomized effects */
-        MaxiginRand    randA;
-        MaxiginRand    randB;
+        MaxiginRand     randA;
+        MaxiginRand     randB;
 
-        int            sparkleProgress;
-        int            randProgress;
+        int             sparkleProgress;
+        int             randProgress;
 
         /* in [0..1024] */
-        int            pinchAmount;
-        int            pinchAmountTarget;
+        int             pinchAmount;
+        int             pinchAmountTarget;
 
-        unsigned char  partFade      [ MAX_PARTICLE_SYSTEMS ];
-        unsigned char  partFadeTarget[ MAX_PARTICLE_SYSTEMS ];
-        ParticleState  partState     [ MAX_PARTICLE_SYSTEMS ];
+        unsigned char   partFade      [ MAX_PARTICLE_SYSTEMS ];
+        unsigned char   partFadeTarget[ MAX_PARTICLE_SYSTEMS ];
+        ParticleState   partState     [ MAX_PARTICLE_SYSTEMS ];
         
     } AnimProgress;
         
@@ -117,6 +127,25 @@ void drawMoveAnimation( int            inBoardCenterX,
 
 
 
+/*
+  Skips to the end of the move animation in one call, with the same
+  results as stepping it until done:  capture money and multiplier and
+  addition factors are applied, without sounds or particles.
+  Effects that already happened while stepping aren't applied again.
+
+  Money and check displays are settled too, so the next call to
+  stepMoveAnimation returns 1.
+
+  Can be called at any point after initMoveAnimation.
+*/
+void resolveMoveAnimation( BoardState    *inState,
+                           Move          *inMove,
+                           Captured      *inCaptured,
+                           BoardState    *inNewState,
+                           AnimProgress  *inMoveProgress );
+
+
+
 void playBeepUpSound  ( void );
 void playBeepDownSound( void );
 
@@ -365,6 +394,175 @@ static void noPieceDraw( int            inBoardCenterX,
 
 
 
+/* bytes used by each param of each phase type, 0 for unused params.
+   1-byte params are signed in [-128..127], 2-byte params are shorts.
+
+   laser and explode:        startC, endC  (range in capture list)
+   multiplier and addition:  sourceR, sourceC, targetR, targetC, value
+   rocketUp:                 row, col
+   rocketDown:               row, col, index of previous captured piece */
+static const unsigned char
+animPhaseParamBytes[ NUM_ANIM_PHASE_TYPES ][ NUM_ANIM_PARAMS ] = {
+    { 0, 0, 0, 0, 0 },
+    { 1, 1, 0, 0, 0 },
+    { 1, 1, 0, 0, 0 },
+    { 1, 1, 1, 1, 2 },
+    { 1, 1, 1, 1, 2 },
+    { 1, 1, 0, 0, 0 },
+    { 1, 1, 1, 0, 0 } };
+
+
+
+static void clearAnimPhases( AnimProgress  *outMoveProgress ) {
+    
+    outMoveProgress->numPhases     = 0;
+    outMoveProgress->phaseNumber   = 0;
+    outMoveProgress->phaseOffset   = 0;
+    outMoveProgress->phaseBytes    = 0;
+    outMoveProgress->phaseProgress = 0;
+    }
+
+
+
+/* appends a phase, ignoring params that inPhase doesn't use.
+   Phases past MAX_ANIM_PHASES are dropped. */
+static void addAnimPhase( AnimProgress  *ioMoveProgress,
+                          AnimPhase      inPhase,
+                          int            inParamA,
+                          int            inParamB,
+                          int            inParamC,
+                          int            inParamD,
+                          int            inParamE ) {
+
+    int             params[ NUM_ANIM_PARAMS ];
+    unsigned char  *data  =  ioMoveProgress->phaseData;
+    int             b     =  ioMoveProgress->phaseBytes;
+    int             i;
+
+    if( ioMoveProgress->numPhases >= MAX_ANIM_PHASES
+        ||
+        b + 1 + NUM_ANIM_PARAMS + 1 > MAX_ANIM_PHASE_BYTES ) {
+        
+        mingin_log( "Too many animation phases, dropping one\n" );
+        return;
+        }
+    
+    params[0] = inParamA;
+    params[1] = inParamB;
+    params[2] = inParamC;
+    params[3] = inParamD;
+    params[4] = inParamE;
+
+    data[ b++ ] = inPhase;
+    
+    for( i = 0;
+         i < NUM_ANIM_PARAMS;
+         i ++ ) {
+
+        int  numBytes  =  animPhaseParamBytes[ inPhase ][ i ];
+        
+        if( numBytes > 0 ) {
+            data[ b++ ] = (unsigned char)( params[i] & 0xFF );
+            }
+        if( numBytes > 1 ) {
+            data[ b++ ] = (unsigned char)( ( params[i] >> 8 ) & 0xFF );
+            }
+        }
+
+    ioMoveProgress->phaseBytes = (unsigned short)b;
+    ioMoveProgress->numPhases ++;
+    }
+
+
+
+/* bytes taken by a phase of type inPhase in phaseData, including its
+   type byte */
+static int getAnimPhaseLength( AnimPhase  inPhase ) {
+
+    int  b  =  1;
+    int  i;
+
+    for( i = 0;
+         i < NUM_ANIM_PARAMS;
+         i ++ ) {
+        b += animPhaseParamBytes[ inPhase ][ i ];
+        }
+
+    return b;
+    }
+
+
+
+/* type of current phase, only valid if phaseNumber < numPhases */
+static AnimPhase getAnimPhase( AnimProgress  *inMoveProgress ) {
+    return inMoveProgress->phaseData[ inMoveProgress->phaseOffset ];
+    }
+
+
+
+/* param of the phase that starts at inOffset in phaseData */
+static int getAnimPhaseParamAt( AnimProgress  *inMoveProgress,
+                                int            inOffset,
+                                int            inParam ) {
+
+    unsigned char  *data    =  &( inMoveProgress->phaseData[ inOffset ] );
+    AnimPhase       p       =  data[0];
+    int             b       =  1;
+    int             v;
+    int             i;
+
+    for( i = 0;
+         i < inParam;
+         i ++ ) {
+        b += animPhaseParamBytes[ p ][ i ];
+        }
+
+    switch( animPhaseParamBytes[ p ][ inParam ] ) {
+        case 1:
+            v = data[ b ];
+            
+            if( v > 127 ) {
+                v -= 256;
+                }
+            return v;
+        case 2:
+            v = data[ b ] | ( data[ b + 1 ] << 8 );
+
+            if( v > 32767 ) {
+                v -= 65536;
+                }
+            return v;
+        default:
+            return 0;
+        }
+    }
+
+
+
+/* param of current phase */
+static int getAnimPhaseParam( AnimProgress  *inMoveProgress,
+                              int            inParam ) {
+    return getAnimPhaseParamAt( inMoveProgress,
+                                inMoveProgress->phaseOffset,
+                                inParam );
+    }
+
+
+
+static void nextAnimPhase( AnimProgress  *ioMoveProgress ) {
+
+    ioMoveProgress->phaseOffset =
+        (unsigned short)( ioMoveProgress->phaseOffset
+                          +
+                          getAnimPhaseLength(
+                              getAnimPhase( ioMoveProgress ) ) );
+    
+    ioMoveProgress->phaseNumber ++;
+    ioMoveProgress->phaseProgress = 0;
+    }
+
+
+
 static void initMultFactors( AnimProgress  *outMoveProgress ) {
 
     int  y;
@@ -423,11 +621,9 @@ static void defaultPieceInit( BoardState    *inState,
     (void)inCaptured;
     (void)inNewState;
     
-    outMoveProgress->numPhases     = 1;
-    outMoveProgress->phaseNumber   = 0;
-    outMoveProgress->phaseProgress = 0;
-
-    outMoveProgress->phases[0] = move;
+    clearAnimPhases( outMoveProgress );
+    
+    addAnimPhase( outMoveProgress, move, 0, 0, 0, 0, 0 );
 
     initMultFactors( outMoveProgress );
     }
@@ -613,6 +809,34 @@ static char defaultPieceStep( BoardState    *inState,
 
 
 
+/* applies whatever defaultPieceStep hasn't applied yet, and leaves
+   inMoveProgress waiting for displays to settle */
+static void defaultPieceResolve( Move          *inMove,
+                                 Captured      *inCaptured,
+                                 AnimProgress  *inMoveProgress ) {
+    
+    int  pixDist  =  boardGetPixelDistance( inMove->startPos[0],
+                                            inMove->startPos[1],
+                                            inMove->endPos[0],
+                                            inMove->endPos[1] );
+
+    if( inMoveProgress->phaseProgress >= 0
+        &&
+        inMoveProgress->phaseProgress < pixDist
+        &&
+        inCaptured->num > 0 ) {
+        
+        /* piece hasn't landed yet, so captures haven't been paid out */
+        processCaptureMoney( inCaptured,
+                             0,
+                             inCaptured->num - 1 );
+        }
+    
+    inMoveProgress->phaseProgress = -1;
+    }
+
+
+
 static void defaultPieceDraw( int            inBoardCenterX,
                               int            inBoardCenterY,
                               BoardState    *inState,
@@ -889,25 +1113,23 @@ static void spaceEffectsInit( BoardState    *inState,
          i >= 0;
          i -- ) {
 
-        int  p  =  outMoveProgress->numPhases;
-        
         if( types[i] == add ) {
-            outMoveProgress->phases[ p ]      = addition;
-            outMoveProgress->params[ p ][ 0 ] = (short)( sourceRows[i] );
-            outMoveProgress->params[ p ][ 1 ] = (short)( sourceCols[i] );
-            outMoveProgress->params[ p ][ 2 ] = (short)( targetRows[i] );
-            outMoveProgress->params[ p ][ 3 ] = (short)( targetCols[i] );
-            outMoveProgress->params[ p ][ 4 ] = (short)( values[i] );
-            outMoveProgress->numPhases ++;
+            addAnimPhase( outMoveProgress,
+                          addition,
+                          sourceRows[i],
+                          sourceCols[i],
+                          targetRows[i],
+                          targetCols[i],
+                          values[i] );
             }
         else if( types[i] == multiply ) {
-            outMoveProgress->phases[ p ]      = multiplier;
-            outMoveProgress->params[ p ][ 0 ] = (short)( sourceRows[i] );
-            outMoveProgress->params[ p ][ 1 ] = (short)( sourceCols[i] );
-            outMoveProgress->params[ p ][ 2 ] = (short)( targetRows[i] );
-            outMoveProgress->params[ p ][ 3 ] = (short)( targetCols[i] );
-            outMoveProgress->params[ p ][ 4 ] = (short)( values[i] );
-            outMoveProgress->numPhases ++;
+            addAnimPhase( outMoveProgress,
+                          multiplier,
+                          sourceRows[i],
+                          sourceCols[i],
+                          targetRows[i],
+                          targetCols[i],
+                          values[i] );
             } 
         }
     }
@@ -925,7 +1147,6 @@ static void laserPieceInit( BoardState    *inState,
     
     int  numLasers  =  0;
     int  i;
-    int  p;
 
     (void)inState;
     (void)inNewState;
@@ -940,36 +1161,23 @@ static void laserPieceInit( BoardState    *inState,
                                       &hit );
         }
     
-    outMoveProgress->numPhases     = 1;
-    outMoveProgress->phaseNumber   = 0;
-    outMoveProgress->phaseProgress = 0;
-
-    outMoveProgress->phases[0] = move;
+    clearAnimPhases( outMoveProgress );
+    
+    addAnimPhase( outMoveProgress, move, 0, 0, 0, 0, 0 );
 
     spaceEffectsInit( inState,
                       inMove,
                       outMoveProgress );
-
-    p = outMoveProgress->numPhases;
-    
-    outMoveProgress->numPhases += numLasers * 2;
     
     for( i = 0;
          i < numLasers;
          i ++ ) {
 
-        short  startC  =  (short)( hit.startC[i] );
-        short  endC    =  (short)( hit.endC  [i] );
+        int  startC  =  hit.startC[i];
+        int  endC    =  hit.endC  [i];
         
-        outMoveProgress->phases[p]    = laser;
-        outMoveProgress->params[p][0] = startC;
-        outMoveProgress->params[p][1] = endC;
-        p++;
-
-        outMoveProgress->phases[p]    = explode;
-        outMoveProgress->params[p][0] = startC;
-        outMoveProgress->params[p][1] = endC;
-        p++;
+        addAnimPhase( outMoveProgress, laser,   startC, endC, 0, 0, 0 );
+        addAnimPhase( outMoveProgress, explode, startC, endC, 0, 0, 0 );
         }   
     }
 
@@ -983,7 +1191,6 @@ static void rocketPieceInit( BoardState    *inState,
     
     static  Move  dummyMove;
     
-    int  p;
     int  i;
     
 
@@ -992,9 +1199,7 @@ static void rocketPieceInit( BoardState    *inState,
 
     initMultFactors( outMoveProgress );
 
-    outMoveProgress->numPhases     = 0;
-    outMoveProgress->phaseNumber   = 0;
-    outMoveProgress->phaseProgress = 0;
+    clearAnimPhases( outMoveProgress );
 
 
 
@@ -1009,14 +1214,12 @@ static void rocketPieceInit( BoardState    *inState,
                       &dummyMove,
                       outMoveProgress );
 
-    p = outMoveProgress->numPhases;
-
-    outMoveProgress->phases[p] = rocketUp;
     /* params are where it takes off from */
-    outMoveProgress->params[p][0] = (short)( inMove->startPos[0] );
-    outMoveProgress->params[p][1] = (short)( inMove->startPos[1] );
-
-    p++;
+    addAnimPhase( outMoveProgress,
+                  rocketUp,
+                  inMove->startPos[0],
+                  inMove->startPos[1],
+                  0, 0, 0 );
 
 
     /* fixme:
@@ -1033,21 +1236,15 @@ static void rocketPieceInit( BoardState    *inState,
         /* each captured piece has rocket come down, and then it explodes
            one by one */
 
-        outMoveProgress->phases[p]    = rocketDown;
-        outMoveProgress->params[p][0] = (short)( inCaptured->pieces[i].row );
-        outMoveProgress->params[p][1] = (short)( inCaptured->pieces[i].col );
-        outMoveProgress->params[p][2] = (short)( i - 1 );
-            
-        p++;
+        addAnimPhase( outMoveProgress,
+                      rocketDown,
+                      inCaptured->pieces[i].row,
+                      inCaptured->pieces[i].col,
+                      i - 1,
+                      0, 0 );
         
-        outMoveProgress->phases[p]    = explode;
-        outMoveProgress->params[p][0] = (short)i;
-        outMoveProgress->params[p][1] = (short)i;
-
-        p++;
+        addAnimPhase( outMoveProgress, explode, i, i, 0, 0, 0 );
         };
-    
-    outMoveProgress->numPhases = p;
     }
 
 
@@ -1187,18 +1384,16 @@ static void stepPinch( AnimProgress  *inMoveProgress,
 
 
 /* returns n, s, e, w captured pieces for this phase of anim progress */
+/* inStartC and inEndC are the range in the capture list hit by one
+   laser phase */
 static void getLaserCaptured( int            inDestR,
                               int            inDestC,
                               Captured      *inCaptured,
-                              AnimProgress  *inMoveProgress,
+                              int            inStartC,
+                              int            inEndC,
                               BoardPiece     outLaserCaptured[4],
                               int           *outSouthCapR ) {
 
-    /* fixme */
-
-    int  pn      =  inMoveProgress->phaseNumber;
-    int  startC  =  inMoveProgress->params[ pn ][ 0 ];
-    int  endC    =  inMoveProgress->params[ pn ][ 1 ];
     int  i;
 
     *outSouthCapR = 0;
@@ -1210,8 +1405,8 @@ static void getLaserCaptured( int            inDestR,
         outLaserCaptured[i].p = noPiece;
         }
 
-    for( i = startC;
-         i <= endC;
+    for( i = inStartC;
+         i <= inEndC;
          i ++ ) {
 
         int  r  =  inCaptured->pieces[i].row;
@@ -1246,19 +1441,291 @@ static void getLaserCaptured( int            inDestR,
 
 
 
+/* 
+   A multi-phase move compiled into one keyframe per phase, so that
+   multiPhaseStep and multiPhaseDraw index precomputed mid states instead
+   of rebuilding them every step and frame.
+
+   This is derived from the move, so it isn't registered memory.  Instead,
+   it remembers the move it was built for and is rebuilt if stepping or
+   drawing is called for a different move (after a playback jump,
+   for example).
+*/
+typedef struct AnimKeyframe {
+        /* board as drawn during this phase */
+        BoardState  midState;
+
+        /* laser phases:  n, s, e, w hits, with noPiece marking empty spots */
+        BoardPiece  laserCaptured[4];
+        int         southCapR;
+
+        /* explode phases:  1 if the captures don't lower the score */
+        char        goodExplode;
+        
+    } AnimKeyframe;
+
+
+typedef struct AnimTimeline {
+        char           valid;
+        
+        BoardState     state;
+        Move           move;
+        Captured       captured;
+        
+        /* the move with only its direct capture, see getCaptureMidState */
+        BoardState     captureMidState;
+        Captured       captureMidCaptured;
+        
+        int            numKeyframes;
+        AnimKeyframe   keyframes[ MAX_ANIM_PHASES ];
+        
+    } AnimTimeline;
+
+
+static  AnimTimeline  animTimeline;
+
+
+
+static char sameBoardState( BoardState  *inA,
+                            BoardState  *inB ) {
+    int  y;
+    int  x;
+
+    if( inA->nextToMove    != inB->nextToMove
+        ||
+        inA->moveCount     != inB->moveCount
+        ||
+        inA->kingExists[0] != inB->kingExists[0]
+        ||
+        inA->kingExists[1] != inB->kingExists[1] ) {
+        return 0;
+        }
+    
+    for( y = 0;
+         y < BH;
+         y ++ ) {
+        for( x = 0;
+             x < BW;
+             x ++ ) {
+            
+            if( inA->grid[y][x] != inB->grid[y][x] ) {
+                return 0;
+                }
+            }
+        }
+    return 1;
+    }
+
+
+
+static char sameCaptured( Captured  *inA,
+                          Captured  *inB ) {
+    int  i;
+    
+    if( inA->num != inB->num ) {
+        return 0;
+        }
+    
+    for( i = 0;
+         i < inA->num;
+         i ++ ) {
+
+        if( inA->pieces[i].p   != inB->pieces[i].p
+            ||
+            inA->pieces[i].row != inB->pieces[i].row
+            ||
+            inA->pieces[i].col != inB->pieces[i].col ) {
+            return 0;
+            }
+        }
+    return 1;
+    }
+
+
+
+static void compileAnimTimeline( BoardState    *inState,
+                                 Move          *inMove,
+                                 Captured      *inCaptured,
+                                 AnimProgress  *inMoveProgress ) {
+
+    static  BoardState  scoreState;
+    static  Captured    scoreCaptured;
+    
+    AnimTimeline  *t       =  &animTimeline;
+    int            offset  =  0;
+    int            i;
+
+    t->valid    = 1;
+    t->state    = *inState;
+    t->move     = *inMove;
+    t->captured = *inCaptured;
+    
+    getCaptureMidState( inState,
+                        inMove,
+                        inCaptured,
+                        &( t->captureMidState ),
+                        &( t->captureMidCaptured ) );
+
+    t->numKeyframes = inMoveProgress->numPhases;
+
+    for( i = 0;
+         i < t->numKeyframes;
+         i ++ ) {
+
+        AnimKeyframe  *k  =  &( t->keyframes[i] );
+        AnimPhase      p  =  inMoveProgress->phaseData[ offset ];
+        int            a  =  getAnimPhaseParamAt( inMoveProgress,
+                                                  offset,
+                                                  0 );
+        int            b  =  getAnimPhaseParamAt( inMoveProgress,
+                                                  offset,
+                                                  1 );
+        
+        k->midState    = t->captureMidState;
+        k->southCapR   = 0;
+        k->goodExplode = 0;
+
+        if( p == laser ) {
+            /* pieces hit by this laser are still there */
+            getCaptureCutoffMidState( inState,
+                                      inMove,
+                                      inCaptured,
+                                      &( k->midState ),
+                                      &scoreCaptured,
+                                      a - 1 );
+            
+            getLaserCaptured( inMove->endPos[0],
+                              inMove->endPos[1],
+                              inCaptured,
+                              a,
+                              b,
+                              k->laserCaptured,
+                              &( k->southCapR ) );
+            }
+        else if( p == explode ) {
+            int  oldScore;
+            
+            getCaptureCutoffMidState( inState,
+                                      inMove,
+                                      inCaptured,
+                                      &scoreState,
+                                      &scoreCaptured,
+                                      a - 1 );
+
+            oldScore = getScore( &scoreState );
+            
+            /* exploding pieces are gone */
+            getCaptureCutoffMidState( inState,
+                                      inMove,
+                                      inCaptured,
+                                      &( k->midState ),
+                                      &scoreCaptured,
+                                      b );
+
+            k->goodExplode = ( oldScore <= getScore( &( k->midState ) ) );
+            }
+        else if( p == rocketDown ) {
+            /* pieces up through the last one the rocket hit are gone */
+            getCaptureCutoffMidState( inState,
+                                      inMove,
+                                      inCaptured,
+                                      &( k->midState ),
+                                      &scoreCaptured,
+                                      getAnimPhaseParamAt( inMoveProgress,
+                                                           offset,
+                                                           2 ) );
+            }
+        
+        offset += getAnimPhaseLength( p );
+        }
+    }
+
+
+
+/* rebuilds timeline if it was compiled for a different move */
+static AnimTimeline *getAnimTimeline( BoardState    *inState,
+                                      Move          *inMove,
+                                      Captured      *inCaptured,
+                                      AnimProgress  *inMoveProgress ) {
+
+    AnimTimeline  *t  =  &animTimeline;
+    
+    if( ! t->valid
+        ||
+        t->numKeyframes     != inMoveProgress->numPhases
+        ||
+        t->move.startPos[0] != inMove->startPos[0]
+        ||
+        t->move.startPos[1] != inMove->startPos[1]
+        ||
+        t->move.endPos[0]   != inMove->endPos[0]
+        ||
+        t->move.endPos[1]   != inMove->endPos[1]
+        ||
+        ! sameCaptured( &( t->captured ), inCaptured )
+        ||
+        ! sameBoardState( &( t->state ), inState ) ) {
+
+        compileAnimTimeline( inState,
+                             inMove,
+                             inCaptured,
+                             inMoveProgress );
+        }
+
+    return t;
+    }
+
+
+
+/* applies current multiplier or addition phase to multFactors */
+static void applyModifierPhase( AnimProgress  *inMoveProgress ) {
+    
+    int   sourceR  =  getAnimPhaseParam( inMoveProgress, 0 );
+    int   sourceC  =  getAnimPhaseParam( inMoveProgress, 1 );
+    int   targetR  =  getAnimPhaseParam( inMoveProgress, 2 );
+    int   targetC  =  getAnimPhaseParam( inMoveProgress, 3 );
+    int   value    =  getAnimPhaseParam( inMoveProgress, 4 );
+    long  factor   =  inMoveProgress->multFactors[ targetR ][ targetC ];
+
+    if( getAnimPhase( inMoveProgress ) == multiplier ) {
+        factor *= value;
+        }
+    else {
+        factor += value;
+        }
+
+    if( factor > 65535 ) {
+        factor = 65535;
+        }
+    else if( factor < 0 ) {
+        factor = 0;
+        }
+            
+    inMoveProgress->multFactors[ targetR ][ targetC ] =
+        (unsigned short)factor;
+
+    /* start (or continue) fade-in of mult-factor display on target */
+    inMoveProgress->multFactorFadeDir[ targetR ][ targetC ] = 1;
+
+    /* fade out source */
+    inMoveProgress->multFactorFadeDir[ sourceR ][ sourceC ] = 0;
+    inMoveProgress->anyMultFactors = 1;
+    }
+
+
+
 static char multiPhaseStep( BoardState    *inState,
                             Move          *inMove,
                             Captured      *inCaptured,
                             BoardState    *inNewState,
                             AnimProgress  *inMoveProgress ) {
 
-    static  BoardState  midState;
-    static  Captured    midCaptured;
-    
-    int        pn      =  inMoveProgress->phaseNumber;
-    AnimPhase  p;
-    int        r       =  mingin_getStepsPerSecond();
-    int        partI;
+    int            pn      =  inMoveProgress->phaseNumber;
+    AnimPhase      p;
+    int            r       =  mingin_getStepsPerSecond();
+    int            partI;
+    AnimTimeline  *t;
+    AnimKeyframe  *k;
     
     (void)inNewState;
 
@@ -1286,17 +1753,18 @@ static char multiPhaseStep( BoardState    *inState,
         
         }
 
-    p =  inMoveProgress->phases[ pn ];
+    p =  getAnimPhase( inMoveProgress );
 
+    t = getAnimTimeline( inState,
+                         inMove,
+                         inCaptured,
+                         inMoveProgress );
+    
+    k = &( t->keyframes[ pn ] );
+    
     if( p == move ) {
         char  baseMoveDone;
 
-        getCaptureMidState( inState,
-                            inMove,
-                            inCaptured,
-                            &midState,
-                            &midCaptured );
-
         /* use base move for main piece move and for any direct-piece capture
            explosion */
 
@@ -1306,32 +1774,21 @@ static char multiPhaseStep( BoardState    *inState,
         
         baseMoveDone = defaultPieceStep( inState,
                                          inMove,
-                                         &midCaptured,
-                                         &midState,
+                                         &( t->captureMidCaptured ),
+                                         &( t->captureMidState ),
                                          inMoveProgress );
         blockCheckDetection = 0;
 
         
         if( baseMoveDone ) {
-            inMoveProgress->phaseNumber ++;
-            inMoveProgress->phaseProgress = 0;
+            nextAnimPhase( inMoveProgress );
             }
         }
     else if( p == laser ) {
         if( inMoveProgress->phaseProgress == 0 ) {
 
-            static  BoardPiece  laserCaptured[4];
-
-            int     southCapR;
-            int     capI;
-            
-            getLaserCaptured( inMove->endPos[0],
-                              inMove->endPos[1],
-                              inCaptured,
-                              inMoveProgress,
-                              laserCaptured,
-                              &southCapR );
-             
+            BoardPiece  *laserCaptured  =  k->laserCaptured;
+            int          capI;
 
             /* kick off drawing any particles at the hit sites */
             for( capI = 0;
@@ -1404,38 +1861,17 @@ static char multiPhaseStep( BoardState    *inState,
                 inMoveProgress->partFadeTarget[ partI ] = 0;
                 }
             
-            inMoveProgress->phaseNumber ++;
-            inMoveProgress->phaseProgress = 0;
+            nextAnimPhase( inMoveProgress );
             }
         }
     else if( p == explode ) {
         int  explodeProgress  =  inMoveProgress->phaseProgress;
 
         if( explodeProgress == 0 ) {
-            int  startC     =  inMoveProgress->params[ pn ][ 0 ];
-            int  endC       =  inMoveProgress->params[ pn ][ 1 ];
-            int  oldScore;
-            int  newScore;
-            
-            getCaptureCutoffMidState( inState,
-                                      inMove,
-                                      inCaptured,
-                                      &midState,
-                                      &midCaptured,
-                                      startC -  1 );
-
-            oldScore = getScore( &midState );
-
-            getCaptureCutoffMidState( inState,
-                                      inMove,
-                                      inCaptured,
-                                      &midState,
-                                      &midCaptured,
-                                      endC );
-            
-            newScore = getScore( &midState );
+            int  startC     =  getAnimPhaseParam( inMoveProgress, 0 );
+            int  endC       =  getAnimPhaseParam( inMoveProgress, 1 );
 
-            if( oldScore <= newScore ) {
+            if( k->goodExplode ) {
                 maxigin_playSoundEffect( shooshGood,
                                          512 );
                 }
@@ -1455,8 +1891,7 @@ static char multiPhaseStep( BoardState    *inState,
         if( explodeProgress == -1 ) {
             /* done exploding */
 
-            inMoveProgress->phaseNumber ++;
-            inMoveProgress->phaseProgress = 0;
+            nextAnimPhase( inMoveProgress );
             }
         else {
             inMoveProgress->phaseProgress = explodeProgress;
@@ -1467,11 +1902,6 @@ static char multiPhaseStep( BoardState    *inState,
              p == addition ) {
 
         if( inMoveProgress->phaseProgress == 0 ) {
-            int  sourceR  =  inMoveProgress->params[ pn ][ 0 ];
-            int  sourceC  =  inMoveProgress->params[ pn ][ 1 ];
-            int  targetR  =  inMoveProgress->params[ pn ][ 2 ];
-            int  targetC  =  inMoveProgress->params[ pn ][ 3 ];
-            int  value    =  inMoveProgress->params[ pn ][ 4 ];
             
             if( p == multiplier ) {
                 maxigin_playSoundEffect( multSound,
@@ -1482,28 +1912,13 @@ static char multiPhaseStep( BoardState    *inState,
                                          512 );
                 }
 
-            /* start (or continue) fade-in of mult-factor display on target */
-
-            if( p == multiplier ) {
-                inMoveProgress->multFactors[ targetR ][ targetC ]
-                    *= value;
-                }
-            else {
-                inMoveProgress->multFactors[ targetR ][ targetC ]
-                    += value;
-                }
-            inMoveProgress->multFactorFadeDir[ targetR ][ targetC ] = 1;
-
-            /* fade out source */
-            inMoveProgress->multFactorFadeDir[ sourceR ][ sourceC ] = 0;
-            inMoveProgress->anyMultFactors = 1;
+            applyModifierPhase( inMoveProgress );
             }
 
         inMoveProgress->phaseProgress += ( 15 * 60 ) / r;
 
         if( inMoveProgress->phaseProgress >= modifierPhaseLen ) {
-            inMoveProgress->phaseNumber ++;
-            inMoveProgress->phaseProgress = 0;
+            nextAnimPhase( inMoveProgress );
             }
         }
     else if( p == rocketUp ) {
@@ -1514,8 +1929,7 @@ static char multiPhaseStep( BoardState    *inState,
         inMoveProgress->phaseProgress += ( 10 * 60 ) / r;
 
         if( inMoveProgress->phaseProgress >= rocketUpPhaseLen ) {
-            inMoveProgress->phaseNumber ++;
-            inMoveProgress->phaseProgress = 0;
+            nextAnimPhase( inMoveProgress );
             }
         }
     else if( p == rocketDown ) {
@@ -1535,8 +1949,7 @@ static char multiPhaseStep( BoardState    *inState,
             }
 
         if( inMoveProgress->phaseProgress >= rocketDownPhaseLen ) {
-            inMoveProgress->phaseNumber ++;
-            inMoveProgress->phaseProgress = 0;
+            nextAnimPhase( inMoveProgress );
             }
         }
 
@@ -2033,21 +2446,17 @@ static void drawMultSparkles( int            inBoardCenterX,
                               Move          *inMove,
                               Captured      *inCaptured,
                               AnimProgress  *inMoveProgress ) {
-    
-    static  BoardState  midState;
-    static  Captured    midCaptured;
 
     if( inMoveProgress->anyMultFactors ) {
         
-        int          mY;
-        int          mX;
-        MaxiginRand  oldRand = inMoveProgress->multRandA;
-        
-        getCaptureMidState( inState,
-                            inMove,
-                            inCaptured,
-                            &midState,
-                            &midCaptured );
+        int           mY;
+        int           mX;
+        MaxiginRand   oldRand   =  inMoveProgress->multRandA;
+        BoardState   *midState  =
+            &( getAnimTimeline( inState,
+                                inMove,
+                                inCaptured,
+                                inMoveProgress )->captureMidState );
         
         for( mY = 0;
              mY < BH;
@@ -2079,7 +2488,7 @@ static void drawMultSparkles( int            inBoardCenterX,
                                       &bX,
                                       &bY );
                 
-                drawPieceSparkles( midState.grid[ mY ][ mX ],
+                drawPieceSparkles( midState->grid[ mY ][ mX ],
                                    bX,
                                    bY,
                                    &( inMoveProgress->multRandA ),
@@ -2094,7 +2503,7 @@ static void drawMultSparkles( int            inBoardCenterX,
                     glowFade = glowMax;
                     }
                 
-                drawPieceGlowOnly( midState.grid[ mY ][ mX ],
+                drawPieceGlowOnly( midState->grid[ mY ][ mX ],
                                    bX,
                                    bY,
                                    (unsigned char)glowFade );
@@ -2127,13 +2536,12 @@ static void multiPhaseDraw( int            inBoardCenterX,
                             BoardState    *inNewState,
                             AnimProgress  *inMoveProgress ) {
 
-    static  BoardState  midState;
-    static  Captured    midCaptured;
-    
-    int        pn                =  inMoveProgress->phaseNumber;
-    AnimPhase  p;
-    char       multFactorsDrawn  =  0;
-    int        partI;
+    AnimPhase      p;
+    char           multFactorsDrawn  =  0;
+    int            partI;
+    AnimTimeline  *t;
+    AnimKeyframe  *k;
+    BoardState    *midState;
     
     (void)inNewState;
 
@@ -2162,28 +2570,30 @@ static void multiPhaseDraw( int            inBoardCenterX,
         }
     
 
-    p = inMoveProgress->phases[ inMoveProgress->phaseNumber ];
+    p = getAnimPhase( inMoveProgress );
 
+    t = getAnimTimeline( inState,
+                         inMove,
+                         inCaptured,
+                         inMoveProgress );
     
-    if( p == move ) {
-        getCaptureMidState( inState,
-                            inMove,
-                            inCaptured,
-                            &midState,
-                            &midCaptured );
+    k = &( t->keyframes[ inMoveProgress->phaseNumber ] );
 
+    midState = &( k->midState );
+    
+    if( p == move ) {
         defaultPieceDraw( inBoardCenterX,
                           inBoardCenterY,
                           inState,
                           inMove,
-                          &midCaptured,
-                          &midState,
+                          &( t->captureMidCaptured ),
+                          &( t->captureMidState ),
                           inMoveProgress );
         }
     else if( p == laser ) {
 
         /* n, s, e, w order, with noPiece marking empty spots */
-        static  BoardPiece  laserCaptured[4];
+        BoardPiece    *laserCaptured  =  k->laserCaptured;
 
         int            laserProgress  =  inMoveProgress->phaseProgress;
         DrawBoardMask  mask;
@@ -2193,33 +2603,14 @@ static void multiPhaseDraw( int            inBoardCenterX,
         int            destX;
         int            destY;
         ChessPiece     mainP;
-        int            southCapR      =  0;
+        int            southCapR      =  k->southCapR;
         int            southCapX      =  0;
         int            southCapY      =  0;
-        int            startC;
             
             
         mainP = inNewState->grid[ destR ][ destC ];
 
 
-        getLaserCaptured( destR,
-                          destC,
-                          inCaptured,
-                          inMoveProgress,
-                          laserCaptured,
-                          &southCapR );
-
-        startC = inMoveProgress->params[ pn ][ 0 ];
-
-        getCaptureCutoffMidState( inState,
-                                  inMove,
-                                  inCaptured,
-                                  &midState,
-                                  &midCaptured,
-                                  startC - 1 );
-
-        
-
         boardDraw( inBoardCenterX,
                    inBoardCenterY );
 
@@ -2229,7 +2620,7 @@ static void multiPhaseDraw( int            inBoardCenterX,
             getRowsAboveMask( &mask,
                               inMove->endPos[0] - 1 );
             
-            drawBoardState( &midState,
+            drawBoardState( midState,
                             0,
                             0,
                             0,
@@ -2281,7 +2672,7 @@ static void multiPhaseDraw( int            inBoardCenterX,
                        destR,
                        destC );
 
-        drawBoardState( &midState,
+        drawBoardState( midState,
                         0,
                         0,
                         0,
@@ -2345,7 +2736,7 @@ static void multiPhaseDraw( int            inBoardCenterX,
                 }
             
             
-            drawBoardState( &midState,
+            drawBoardState( midState,
                             0,
                             0,
                             0,
@@ -2412,7 +2803,7 @@ static void multiPhaseDraw( int            inBoardCenterX,
                                southCapR,
                                destC );
 
-                drawBoardState( &midState,
+                drawBoardState( midState,
                                 0,
                                 0,
                                 0,
@@ -2453,7 +2844,7 @@ static void multiPhaseDraw( int            inBoardCenterX,
                     getRowsBelowMask( &mask,
                                       southCapR + 1 );
                     
-                    drawBoardState( &midState,
+                    drawBoardState( midState,
                                     0,
                                     0,
                                     0,
@@ -2479,21 +2870,15 @@ static void multiPhaseDraw( int            inBoardCenterX,
         int  endC;
         int  c;
 
-        startC = inMoveProgress->params[ pn ][ 0 ];
-        endC   = inMoveProgress->params[ pn ][ 1 ];
+        startC = getAnimPhaseParam( inMoveProgress, 0 );
+        endC   = getAnimPhaseParam( inMoveProgress, 1 );
 
-        getCaptureCutoffMidState( inState,
-                                  inMove,
-                                  inCaptured,
-                                  &midState,
-                                  &midCaptured,
-                                  endC );
 
         boardDraw( inBoardCenterX,
                    inBoardCenterY );
     
         /* draw mid state with captures up to this point removed */
-        drawBoardState( &midState,
+        drawBoardState( midState,
                         0,
                         0,
                         0,
@@ -2530,10 +2915,10 @@ static void multiPhaseDraw( int            inBoardCenterX,
              ||
              p == addition ) {
 
-        int            sourceR        =  inMoveProgress->params[ pn ][ 0 ];
-        int            sourceC        =  inMoveProgress->params[ pn ][ 1 ];
-        int            targetR        =  inMoveProgress->params[ pn ][ 2 ];
-        int            targetC        =  inMoveProgress->params[ pn ][ 3 ];
+        int            sourceR        =  getAnimPhaseParam( inMoveProgress, 0 );
+        int            sourceC        =  getAnimPhaseParam( inMoveProgress, 1 );
+        int            targetR        =  getAnimPhaseParam( inMoveProgress, 2 );
+        int            targetC        =  getAnimPhaseParam( inMoveProgress, 3 );
         int            sourceX;
         int            sourceY;
         int            targetX;
@@ -2617,13 +3002,8 @@ static void multiPhaseDraw( int            inBoardCenterX,
         boardDraw( inBoardCenterX,
                    inBoardCenterY );
 
-        getCaptureMidState( inState,
-                            inMove,
-                            inCaptured,
-                            &midState,
-                            &midCaptured );
     
-        drawBoardState( &midState,
+        drawBoardState( midState,
                         0,
                         0,
                         0,
@@ -2656,7 +3036,7 @@ static void multiPhaseDraw( int            inBoardCenterX,
         displayText =
             maxigin_stringConcat(
                 symbol,
-                maxigin_intToString( inMoveProgress->params[ pn ][ 4 ] ) );
+                maxigin_intToString( getAnimPhaseParam( inMoveProgress, 4 ) ) );
 
         numberDrawText( displayText,
                         drawX,
@@ -2915,20 +3295,14 @@ static void multiPhaseDraw( int            inBoardCenterX,
                        inMove->startPos[0],
                        inMove->startPos[1] );
 
-        getCaptureCutoffMidState( inState,
-                                  inMove,
-                                  inCaptured,
-                                  &midState,
-                                  &midCaptured,
-                                  inMoveProgress->params[ pn ][ 2 ] );
 
         /* draw row of rocket landing and further north */
 
         getRowRangeMask( &mask,
                          0,
-                         inMoveProgress->params[ pn ][ 0 ] );
+                         getAnimPhaseParam( inMoveProgress, 0 ) );
         
-        drawBoardState( &midState,
+        drawBoardState( midState,
                         0,
                         0,
                         0,
@@ -2945,8 +3319,8 @@ static void multiPhaseDraw( int            inBoardCenterX,
 
         boardGetSquareCenter( inBoardCenterX,
                               inBoardCenterY,
-                              inMoveProgress->params[pn][0],
-                              inMoveProgress->params[pn][1],
+                              getAnimPhaseParam( inMoveProgress, 0 ),
+                              getAnimPhaseParam( inMoveProgress, 1 ),
                               &landPosX,
                               &landPosY );
 
@@ -2981,10 +3355,10 @@ static void multiPhaseDraw( int            inBoardCenterX,
 
         /* now draw everything to south of where rocket landed */
         getRowRangeMask( &mask,
-                         inMoveProgress->params[ pn ][ 0 ] + 1,
+                         getAnimPhaseParam( inMoveProgress, 0 ) + 1,
                          BH - 1 );
         
-        drawBoardState( &midState,
+        drawBoardState( midState,
                         0,
                         0,
                         0,
@@ -3121,6 +3495,13 @@ void initMoveAnimation( BoardState    *inState,
                         inCaptured,
                         inNewState,
                         outMoveProgress );
+
+    if( stepFunctions[ t ] == multiPhaseStep ) {
+        compileAnimTimeline( inState,
+                             inMove,
+                             inCaptured,
+                             outMoveProgress );
+        }
     }
 
 
@@ -3169,6 +3550,100 @@ void drawMoveAnimation( int            inBoardCenterX,
 
 
 
+void resolveMoveAnimation( BoardState    *inState,
+                           Move          *inMove,
+                           Captured      *inCaptured,
+                           BoardState    *inNewState,
+                           AnimProgress  *inMoveProgress ) {
+
+    ChessPiece  p  =  inState->grid[ inMove->startPos[0] ]
+                                   [ inMove->startPos[1] ];
+    ChessPiece  t  =  p & CHESS_TYPE_MASK;
+    int         y;
+    int         x;
+    int         partI;
+
+    (void)inNewState;
+    
+    if( stepFunctions[ t ] == defaultPieceStep ) {
+        defaultPieceResolve( inMove,
+                             inCaptured,
+                             inMoveProgress );
+        }
+    else if( stepFunctions[ t ] == multiPhaseStep ) {
+
+        AnimTimeline  *tl  =  getAnimTimeline( inState,
+                                               inMove,
+                                               inCaptured,
+                                               inMoveProgress );
+
+        while( inMoveProgress->phaseNumber < inMoveProgress->numPhases ) {
+
+            AnimPhase  phase    =  getAnimPhase( inMoveProgress );
+
+            /* phases apply their effects on their first step */
+            char       started  =  ( inMoveProgress->phaseProgress != 0 );
+
+            if( phase == move ) {
+                defaultPieceResolve( inMove,
+                                     &( tl->captureMidCaptured ),
+                                     inMoveProgress );
+                }
+            else if( ! started
+                     &&
+                     phase == explode ) {
+                
+                processCaptureMoney( inCaptured,
+                                     getAnimPhaseParam( inMoveProgress, 0 ),
+                                     getAnimPhaseParam( inMoveProgress, 1 ) );
+                }
+            else if( ! started
+                     &&
+                     ( phase == multiplier
+                       ||
+                       phase == addition ) ) {
+                
+                applyModifierPhase( inMoveProgress );
+                }
+
+            nextAnimPhase( inMoveProgress );
+            }
+        }
+    
+
+    /* everything that would fade out by the end is gone */
+    
+    inMoveProgress->anyMultFactors = 0;
+
+    for( y = 0;
+         y < BH;
+         y ++ ) {
+        for( x = 0;
+             x < BW;
+             x ++ ) {
+            
+            inMoveProgress->multFactorFades  [ y ][ x ] = 0;
+            inMoveProgress->multFactorFadeDir[ y ][ x ] = 0;
+            }
+        }
+    
+    for( partI = 0;
+         partI < MAX_PARTICLE_SYSTEMS;
+         partI ++ ) {
+        
+        inMoveProgress->partFade      [ partI ] = 0;
+        inMoveProgress->partFadeTarget[ partI ] = 0;
+        }
+    
+    inMoveProgress->pinchAmount       = 0;
+    inMoveProgress->pinchAmountTarget = 0;
+
+    moneySettle();
+    checkDisplaySkip();
+    }
+
+
+
 #endif
 
 
@@ -374,6 +374,10 @@ void pieceSpritesInit( void ) {
                                              &h );
 
                 pieceOffsetY[ i ] = -( h / 2 - pieceBottomHeight );
+
+                /* piece art only uses a handful of colors,
+                   store it as palette indices */
+                maxigin_initPaletteSprite( pieceSpriteHandles[i][ci] );
                 }
             }
         }
@@ -457,6 +461,9 @@ void pieceSpritesInit( void ) {
                     pieceSpriteExtraHandles[ i ][ ci ],
                     4,
                     2 );
+
+                maxigin_initPaletteSprite(
+                    pieceSpriteExtraHandles[ i ][ ci ] );
                 }
             }
         }
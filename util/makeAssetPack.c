@@ -0,0 +1,324 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+
+
+/*
+  Packs every file in a data directory into one pack file that mingin
+  can read bulk data from.
+
+  See mn_loadBulkDataPack in mingin.h for the format.
+*/
+
+
+static void usage( const char  *inEXEName ) {
+
+    printf( "Usage:\n\n" );
+
+    printf( "  %s   dataDir  packOut.pack\n\n",
+            inEXEName );
+
+    exit( 1 );
+    }
+
+
+
+enum{ MAX_FILES       =  4096,
+      MAX_NAME_BYTES  =  256,
+      HEADER_BYTES    =  16,
+      ENTRY_BYTES     =  16,
+      /* mingin won't load a bigger table of contents */
+      MAX_TOC_BYTES   =  131072,
+      DATA_ALIGNMENT  =  4096 };
+
+
+static  char  fileNames[ MAX_FILES ][ MAX_NAME_BYTES ];
+static  long  fileLengths[ MAX_FILES ];
+static  int   numFiles  =  0;
+
+
+
+static int compareNames( const void  *inA,
+                         const void  *inB ) {
+
+    return strcmp( (const char *)inA,
+                   (const char *)inB );
+    }
+
+
+
+static void writeInt( FILE  *inFile,
+                      long   inValue ) {
+
+    unsigned long  v  =  (unsigned long)inValue;
+
+    fputc( (int)( v         & 0xFF ), inFile );
+    fputc( (int)( ( v >>  8 ) & 0xFF ), inFile );
+    fputc( (int)( ( v >> 16 ) & 0xFF ), inFile );
+    fputc( (int)( ( v >> 24 ) & 0xFF ), inFile );
+    }
+
+
+
+static void writePadding( FILE  *inFile,
+                          long   inPos ) {
+
+    while( inPos % DATA_ALIGNMENT != 0 ) {
+        fputc( 0, inFile );
+        inPos ++;
+        }
+    }
+
+
+
+static long alignUp( long  inPos ) {
+
+    return ( ( inPos + DATA_ALIGNMENT - 1 ) / DATA_ALIGNMENT )
+        * DATA_ALIGNMENT;
+    }
+
+
+
+/* returns path in a static buffer, or NULL if it doesn't fit */
+static const char *getPath( const char  *inDirName,
+                            const char  *inFileName ) {
+
+    static  char  buffer[ MAX_NAME_BYTES * 2 + 2 ];
+
+    if( strlen( inDirName ) + strlen( inFileName ) + 2 > sizeof( buffer ) ) {
+        return NULL;
+        }
+
+    sprintf( buffer, "%s/%s", inDirName, inFileName );
+
+    return buffer;
+    }
+
+
+
+int main( int          inNumArgs,
+          const char  **inArgs ) {
+
+    const char     *dirName;
+    const char     *packFileName;
+    DIR            *dir;
+    struct dirent  *entry;
+    FILE           *packFile;
+    long            namesBytes  =  0;
+    long            tocBytes;
+    long            pos;
+    int             i;
+
+    if( inNumArgs != 3 ) {
+        usage( inArgs[0] );
+        }
+
+    dirName      = inArgs[1];
+    packFileName = inArgs[2];
+
+    dir = opendir( dirName );
+
+    if( dir == NULL ) {
+        printf( "\nFailed to open data dir \"%s\"\n\n",
+                dirName );
+
+        usage( inArgs[0] );
+        }
+
+
+    while( ( entry = readdir( dir ) ) != NULL ) {
+
+        const char  *path;
+        FILE        *f;
+
+        if( entry->d_name[0] == '.' ) {
+            /* skip . and .. and hidden files */
+            continue;
+            }
+
+        if( numFiles >= MAX_FILES ) {
+            printf( "Error:  more than %d files in data dir\n",
+                    MAX_FILES );
+            closedir( dir );
+            return 1;
+            }
+
+        if( strlen( entry->d_name ) >= MAX_NAME_BYTES ) {
+            printf( "Error:  file name too long:  %s\n",
+                    entry->d_name );
+            closedir( dir );
+            return 1;
+            }
+
+        path = getPath( dirName, entry->d_name );
+
+        f = ( path == NULL ) ? NULL : fopen( path, "rb" );
+
+        if( f == NULL ) {
+            printf( "Error:  failed to open \"%s\"\n",
+                    entry->d_name );
+            closedir( dir );
+            return 1;
+            }
+
+        if( fseek( f, 0, SEEK_END ) != 0 ) {
+            /* directories fail here, skip them */
+            fclose( f );
+            continue;
+            }
+
+        if( ftell( f ) < 0 ) {
+            /* also a directory */
+            fclose( f );
+            continue;
+            }
+
+        fclose( f );
+
+        strcpy( fileNames[ numFiles ], entry->d_name );
+
+        namesBytes += (long)strlen( entry->d_name ) + 1;
+
+        numFiles ++;
+        }
+
+    closedir( dir );
+
+
+    /* mingin does a binary search by name */
+    qsort( fileNames,
+           (size_t)numFiles,
+           MAX_NAME_BYTES,
+           compareNames );
+
+
+    tocBytes = numFiles * ENTRY_BYTES + namesBytes;
+
+    if( tocBytes > MAX_TOC_BYTES ) {
+        printf( "Error:  table of contents is %ld bytes, "
+                "beyond the %d limit\n",
+                tocBytes,
+                MAX_TOC_BYTES );
+        return 1;
+        }
+
+
+    packFile = fopen( packFileName,
+                      "wb" );
+
+    if( packFile == NULL ) {
+        printf( "\nFailed to open/create output pack file \"%s\"\n\n",
+                packFileName );
+
+        usage( inArgs[0] );
+        }
+
+
+    /* header */
+    fwrite( "MNPACK1", 1, 8, packFile );
+    writeInt( packFile, numFiles );
+    writeInt( packFile, tocBytes );
+
+
+    /* entries */
+    {
+        long  nameOffset  =  numFiles * ENTRY_BYTES;
+        long  dataOffset  =  alignUp( HEADER_BYTES + tocBytes );
+
+        for( i = 0;
+             i < numFiles;
+             i ++ ) {
+
+            FILE  *f  =  fopen( getPath( dirName, fileNames[i] ),
+                                "rb" );
+
+            if( f == NULL
+                ||
+                fseek( f, 0, SEEK_END ) != 0 ) {
+
+                printf( "Error:  failed to open \"%s\"\n",
+                        fileNames[i] );
+                fclose( packFile );
+                return 1;
+                }
+
+            fileLengths[i] = ftell( f );
+            fclose( f );
+
+            writeInt( packFile, nameOffset );
+            writeInt( packFile, dataOffset );
+            writeInt( packFile, fileLengths[i] );
+            writeInt( packFile, 0 );
+
+            nameOffset += (long)strlen( fileNames[i] ) + 1;
+            dataOffset = alignUp( dataOffset + fileLengths[i] );
+            }
+        }
+
+    /* names */
+    for( i = 0;
+         i < numFiles;
+         i ++ ) {
+
+        fwrite( fileNames[i],
+                1,
+                strlen( fileNames[i] ) + 1,
+                packFile );
+        }
+
+    pos = HEADER_BYTES + tocBytes;
+
+
+    /* data */
+    for( i = 0;
+         i < numFiles;
+         i ++ ) {
+
+        FILE  *f;
+        int    c;
+        long   numCopied  =  0;
+
+        writePadding( packFile, pos );
+        pos = alignUp( pos );
+
+        f = fopen( getPath( dirName, fileNames[i] ),
+                   "rb" );
+
+        if( f == NULL ) {
+            printf( "Error:  failed to open \"%s\"\n",
+                    fileNames[i] );
+            fclose( packFile );
+            return 1;
+            }
+
+        while( ( c = fgetc( f ) ) != EOF ) {
+            fputc( c, packFile );
+            numCopied ++;
+            }
+
+        fclose( f );
+
+        if( numCopied != fileLengths[i] ) {
+            printf( "Error:  \"%s\" changed while packing\n",
+                    fileNames[i] );
+            fclose( packFile );
+            return 1;
+            }
+
+        pos += numCopied;
+        }
+
+    if( fclose( packFile ) != 0 ) {
+        printf( "Error:  failed to finish writing \"%s\"\n",
+                packFileName );
+        return 1;
+        }
+
+    printf( "Packed %d files into %s (%ld bytes)\n",
+            numFiles,
+            packFileName,
+            pos );
+
+    return 0;
+    }
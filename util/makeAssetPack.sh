@@ -0,0 +1,4 @@
+gcc -g -o makeAssetPack makeAssetPack.c
+
+
+./makeAssetPack ../data ../data.pack